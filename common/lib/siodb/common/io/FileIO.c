@@ -28,7 +28,7 @@ int closeFileIgnoreSignal(int fd)
 size_t readExact(int fd, void* buffer, size_t size, int ignoreSignal)
 {
     size_t bytesRead = 0;
-    while (bytesRead < size) {
+    while (size > 0) {
         const ssize_t n = read(fd, buffer, size);
         if (n < 0) {
             if (errno == EINTR && ignoreSignal) continue;
@@ -48,7 +48,7 @@ size_t readExact(int fd, void* buffer, size_t size, int ignoreSignal)
 size_t preadExact(int fd, void* buffer, size_t size, off_t offset, int ignoreSignal)
 {
     size_t bytesRead = 0;
-    while (bytesRead < size) {
+    while (size > 0) {
         const ssize_t n = pread(fd, buffer, size, offset);
         if (n < 0) {
             if (errno == EINTR && ignoreSignal) continue;
@@ -69,7 +69,7 @@ size_t preadExact(int fd, void* buffer, size_t size, off_t offset, int ignoreSig
 size_t writeExact(int fd, const void* buffer, size_t size, int ignoreSignal)
 {
     size_t bytesWritten = 0;
-    while (bytesWritten < size) {
+    while (size > 0) {
         const ssize_t n = write(fd, buffer, size);
         if (n < 0) {
             if (errno == EINTR && ignoreSignal) continue;
@@ -85,7 +85,7 @@ size_t writeExact(int fd, const void* buffer, size_t size, int ignoreSignal)
 size_t pwriteExact(int fd, const void* buffer, size_t size, off_t offset, int ignoreSignal)
 {
     size_t bytesWritten = 0;
-    while (bytesWritten < size) {
+    while (size > 0) {
         const ssize_t n = pwrite(fd, buffer, size, offset);
         if (n < 0) {
             if (errno == EINTR && ignoreSignal) continue;
@@ -17,6 +17,7 @@
 
 // STL headers
 #include <array>
+#include <limits>
 #include <unordered_set>
 
 // Boost headers
@@ -404,14 +405,158 @@ void InstanceOptions::load(const std::string& instanceName)
             && tmpOptions.m_ioManagerOptions.m_ipv4port == 0)
         throw InvalidConfigurationOptionError("Both IPv4 and IPv6 are disabled for IO Manager");
 
-    // Parse block cache capacity
-    {
-        tmpOptions.m_ioManagerOptions.m_blockCacheCapacity =
-                config.get<unsigned>(constructOptionPath(kIOManagerOptionBlockCacheCapacity),
-                        kDefaultIOManagerBlockCacheCapacity);
-        if (tmpOptions.m_ioManagerOptions.m_blockCacheCapacity < kMinIOManagerBlockCacheCapacity) {
-            throw InvalidConfigurationOptionError("IO Manager block cache capacity is too small");
+    // Parse block cache size
+    try {
+        auto option = boost::trim_copy(
+                config.get<std::string>(constructOptionPath(kIOManagerOptionBlockCacheSize),
+                        std::to_string(kDefaultIOManagerBlockCacheSize / kBytesInMB)));
+        std::size_t multiplier = 0;
+        if (option.size() > 1) {
+            switch (option.back()) {
+                case 'k':
+                case 'K': {
+                    multiplier = kBytesInKB;
+                    break;
+                }
+                case 'm':
+                case 'M': {
+                    multiplier = kBytesInMB;
+                    break;
+                }
+                case 'g':
+                case 'G': {
+                    multiplier = kBytesInGB;
+                    break;
+                }
+                default: break;
+            }
+            if (multiplier > 0) option.erase(option.length() - 1, 1);
+        }
+        if (multiplier == 0) multiplier = kBytesInMB;
+        const auto value = std::stoull(option);
+        if (value > std::numeric_limits<std::size_t>::max() / multiplier)
+            throw std::out_of_range("value is too big");
+        tmpOptions.m_ioManagerOptions.m_blockCacheSize = value * multiplier;
+    } catch (std::exception& ex) {
+        std::ostringstream err;
+        err << "Invalid value of IO Manager block cache size: " << ex.what();
+        throw InvalidConfigurationOptionError(err.str());
+    }
+    if (tmpOptions.m_ioManagerOptions.m_blockCacheSize < kMinIOManagerBlockCacheSize)
+        throw InvalidConfigurationOptionError("IO Manager block cache size is too small");
+
+    // Parse segment file size
+    try {
+        auto option = boost::trim_copy(
+                config.get<std::string>(constructOptionPath(kIOManagerOptionSegmentFileSize),
+                        std::to_string(kDefaultIOManagerSegmentFileSize / kBytesInMB)));
+        std::size_t multiplier = 0;
+        if (option.size() > 1) {
+            switch (option.back()) {
+                case 'k':
+                case 'K': {
+                    multiplier = kBytesInKB;
+                    break;
+                }
+                case 'm':
+                case 'M': {
+                    multiplier = kBytesInMB;
+                    break;
+                }
+                case 'g':
+                case 'G': {
+                    multiplier = kBytesInGB;
+                    break;
+                }
+                default: break;
+            }
+            if (multiplier > 0) option.erase(option.length() - 1, 1);
         }
+        if (multiplier == 0) multiplier = kBytesInMB;
+        const auto value = std::stoull(option);
+        if (value > std::numeric_limits<std::size_t>::max() / multiplier)
+            throw std::out_of_range("value is too big");
+        tmpOptions.m_ioManagerOptions.m_segmentFileSize = value * multiplier;
+    } catch (std::exception& ex) {
+        std::ostringstream err;
+        err << "Invalid value of IO Manager segment file size: " << ex.what();
+        throw InvalidConfigurationOptionError(err.str());
+    }
+    if (tmpOptions.m_ioManagerOptions.m_segmentFileSize > 0
+            && tmpOptions.m_ioManagerOptions.m_segmentFileSize < kMinIOManagerSegmentFileSize)
+        throw InvalidConfigurationOptionError("IO Manager segment file size is too small");
+
+    // Parse write-ahead log option
+    {
+        BoolTranslator translator;
+        tmpOptions.m_ioManagerOptions.m_enableWriteAheadLog =
+                config.get<bool>(constructOptionPath(kIOManagerOptionEnableWriteAheadLog),
+                        kDefaultIOManagerEnableWriteAheadLog, translator);
+    }
+
+    // Parse direct I/O option
+    {
+        BoolTranslator translator;
+        tmpOptions.m_ioManagerOptions.m_enableDirectIo =
+                config.get<bool>(constructOptionPath(kIOManagerOptionEnableDirectIo),
+                        kDefaultIOManagerEnableDirectIo, translator);
+    }
+
+    // Parse block scrubber rate
+    {
+        const std::size_t rate =
+                config.get<unsigned>(constructOptionPath(kIOManagerOptionBlockScrubRate),
+                        kDefaultIOManagerBlockScrubRate / kBytesInMB);
+        tmpOptions.m_ioManagerOptions.m_blockScrubRate = rate * kBytesInMB;
+    }
+
+    // Parse block scrubber interval
+    {
+        tmpOptions.m_ioManagerOptions.m_blockScrubInterval =
+                config.get<unsigned>(constructOptionPath(kIOManagerOptionBlockScrubInterval),
+                        static_cast<unsigned>(kDefaultIOManagerBlockScrubInterval));
+        if (tmpOptions.m_ioManagerOptions.m_blockScrubInterval < kMinIOManagerBlockScrubInterval)
+            throw InvalidConfigurationOptionError("IO Manager block scrub interval is too small");
+    }
+
+    // Parse index build memory
+    {
+        const std::size_t memory =
+                config.get<unsigned>(constructOptionPath(kIOManagerOptionIndexBuildMemory),
+                        kDefaultIOManagerIndexBuildMemory / kBytesInMB);
+        tmpOptions.m_ioManagerOptions.m_indexBuildMemory = memory * kBytesInMB;
+        if (tmpOptions.m_ioManagerOptions.m_indexBuildMemory < kMinIOManagerIndexBuildMemory)
+            throw InvalidConfigurationOptionError("IO Manager index build memory is too small");
+    }
+
+    // Parse join memory
+    {
+        const std::size_t memory =
+                config.get<unsigned>(constructOptionPath(kIOManagerOptionJoinMemory),
+                        kDefaultIOManagerJoinMemory / kBytesInMB);
+        tmpOptions.m_ioManagerOptions.m_joinMemory = memory * kBytesInMB;
+        if (tmpOptions.m_ioManagerOptions.m_joinMemory < kMinIOManagerJoinMemory)
+            throw InvalidConfigurationOptionError("IO Manager join memory is too small");
+    }
+
+    // Parse sort memory
+    {
+        const std::size_t memory =
+                config.get<unsigned>(constructOptionPath(kIOManagerOptionSortMemory),
+                        kDefaultIOManagerSortMemory / kBytesInMB);
+        tmpOptions.m_ioManagerOptions.m_sortMemory = memory * kBytesInMB;
+        if (tmpOptions.m_ioManagerOptions.m_sortMemory < kMinIOManagerSortMemory)
+            throw InvalidConfigurationOptionError("IO Manager sort memory is too small");
+    }
+
+    // Parse aggregation memory
+    {
+        const std::size_t memory =
+                config.get<unsigned>(constructOptionPath(kIOManagerOptionAggregationMemory),
+                        kDefaultIOManagerAggregationMemory / kBytesInMB);
+        tmpOptions.m_ioManagerOptions.m_aggregationMemory = memory * kBytesInMB;
+        if (tmpOptions.m_ioManagerOptions.m_aggregationMemory < kMinIOManagerAggregationMemory)
+            throw InvalidConfigurationOptionError("IO Manager aggregation memory is too small");
     }
 
     // Parse user cache capacity
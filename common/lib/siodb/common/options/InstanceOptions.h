@@ -41,7 +41,16 @@ constexpr const char* kIOManagerOptionWriterThreadNumber = "iomgr.writer_thread_
 constexpr const char* kIOManagerOptionUserCacheCapacity = "iomgr.user_cache_capacity";
 constexpr const char* kIOManagerOptionDatabaseCacheCapacity = "iomgr.database_cache_capacity";
 constexpr const char* kIOManagerOptionTableCacheCapacity = "iomgr.table_cache_capacity";
-constexpr const char* kIOManagerOptionBlockCacheCapacity = "iomgr.block_cache_capacity";
+constexpr const char* kIOManagerOptionBlockCacheSize = "iomgr.block_cache_size";
+constexpr const char* kIOManagerOptionSegmentFileSize = "iomgr.segment_file_size";
+constexpr const char* kIOManagerOptionEnableWriteAheadLog = "iomgr.enable_write_ahead_log";
+constexpr const char* kIOManagerOptionEnableDirectIo = "iomgr.enable_direct_io";
+constexpr const char* kIOManagerOptionBlockScrubRate = "iomgr.block_scrub_rate";
+constexpr const char* kIOManagerOptionBlockScrubInterval = "iomgr.block_scrub_interval";
+constexpr const char* kIOManagerOptionIndexBuildMemory = "iomgr.index_build_memory";
+constexpr const char* kIOManagerOptionJoinMemory = "iomgr.join_memory";
+constexpr const char* kIOManagerOptionSortMemory = "iomgr.sort_memory";
+constexpr const char* kIOManagerOptionAggregationMemory = "iomgr.aggregation_memory";
 
 // Encryption options
 constexpr const char* kEncryptionOptionDefaultCipherId = "encryption.default_cipher_id";
@@ -100,13 +109,45 @@ constexpr std::size_t kMinIOManagerDatabaseCacheCapacity = 2;
 constexpr std::size_t kDefaultIOManagerDatabaseCacheCapacity = 100;
 
 // IOManager table cache capacity
-constexpr std::size_t kMaxNumberOfSystemTables = 4;
+constexpr std::size_t kMaxNumberOfSystemTables = 5;
 constexpr std::size_t kMinIOManagerTableCacheCapacity = kMaxNumberOfSystemTables + 1;
 constexpr std::size_t kDefaultIOManagerTableCacheCapacity = 100;
 
-// IOManager block cache capacity
-constexpr std::size_t kMinIOManagerBlockCacheCapacity = 50;
-constexpr std::size_t kDefaultIOManagerBlockCacheCapacity = 103;
+// IOManager block cache size
+constexpr std::size_t kMinIOManagerBlockCacheSize = 16 * 1024 * 1024;  // 16M
+constexpr std::size_t kDefaultIOManagerBlockCacheSize = 1024 * 1024 * 1024;  // 1G
+
+// IOManager segment file size, zero means that each column data block has own file
+constexpr std::size_t kMinIOManagerSegmentFileSize = 16 * 1024 * 1024;  // 16M
+constexpr std::size_t kDefaultIOManagerSegmentFileSize = 0;
+
+// IOManager write-ahead log, when disabled, data files are written synchronously
+constexpr bool kDefaultIOManagerEnableWriteAheadLog = true;
+
+// IOManager direct I/O, when enabled, data and index files bypass the page cache
+constexpr bool kDefaultIOManagerEnableDirectIo = false;
+
+// IOManager block scrubber, verifies closed column data blocks in the background.
+// Rate is in bytes per second, zero disables scrubber. Interval is in seconds.
+constexpr std::size_t kDefaultIOManagerBlockScrubRate = 16 * 1024 * 1024;  // 16M
+constexpr std::size_t kDefaultIOManagerBlockScrubInterval = 24 * 60 * 60;  // 1 day
+constexpr std::size_t kMinIOManagerBlockScrubInterval = 60;
+
+// IOManager index build memory, keys which don't fit into it are sorted on disk
+constexpr std::size_t kMinIOManagerIndexBuildMemory = 4 * 1024 * 1024;  // 4M
+constexpr std::size_t kDefaultIOManagerIndexBuildMemory = 256 * 1024 * 1024;  // 256M
+
+// IOManager hash join memory, joined rows which don't fit into it are partitioned on disk
+constexpr std::size_t kMinIOManagerJoinMemory = 4 * 1024 * 1024;  // 4M
+constexpr std::size_t kDefaultIOManagerJoinMemory = 256 * 1024 * 1024;  // 256M
+
+// IOManager ORDER BY sort memory, rows which don't fit into it are sorted on disk
+constexpr std::size_t kMinIOManagerSortMemory = 4 * 1024 * 1024;  // 4M
+constexpr std::size_t kDefaultIOManagerSortMemory = 256 * 1024 * 1024;  // 256M
+
+// IOManager GROUP BY aggregation memory, groups which don't fit into it are merged on disk
+constexpr std::size_t kMinIOManagerAggregationMemory = 4 * 1024 * 1024;  // 4M
+constexpr std::size_t kDefaultIOManagerAggregationMemory = 256 * 1024 * 1024;  // 256M
 
 /** Default cipher */
 constexpr const char* kDefaultCipherId = "aes128";
@@ -164,7 +205,7 @@ struct IOManagerOptions {
     /** Worker thread number */
     std::size_t m_workerThreadNumber = kDefaultIOManagerWorkerThreadNumber;
 
-    /** Writer thread number */
+    /** Writer thread number, writer threads write back evicted column data blocks */
     std::size_t m_writerThreadNumber = kDefaultIOManagerWriterThreadNumber;
 
     /** IPv4 TCP port number */
@@ -182,8 +223,38 @@ struct IOManagerOptions {
     /** Table cache capacity */
     std::size_t m_tableCacheCapacity = kDefaultIOManagerTableCacheCapacity;
 
-    /** Block cache capacity */
-    std::size_t m_blockCacheCapacity = kDefaultIOManagerBlockCacheCapacity;
+    /** Block cache size in bytes */
+    std::size_t m_blockCacheSize = kDefaultIOManagerBlockCacheSize;
+
+    /**
+     * Size of the segment files which store column data blocks of new columns.
+     * Zero means that each column data block of new columns is stored in own file.
+     */
+    std::size_t m_segmentFileSize = kDefaultIOManagerSegmentFileSize;
+
+    /** Indication that data file writes are recorded in the write-ahead log */
+    bool m_enableWriteAheadLog = kDefaultIOManagerEnableWriteAheadLog;
+
+    /** Indication that column data block and index files are opened with O_DIRECT */
+    bool m_enableDirectIo = kDefaultIOManagerEnableDirectIo;
+
+    /** Block scrubber read rate in bytes per second, zero means that scrubber is disabled */
+    std::size_t m_blockScrubRate = kDefaultIOManagerBlockScrubRate;
+
+    /** Interval between block scrubber passes in seconds */
+    std::size_t m_blockScrubInterval = kDefaultIOManagerBlockScrubInterval;
+
+    /** Memory used for sorting index keys when index is built, in bytes */
+    std::size_t m_indexBuildMemory = kDefaultIOManagerIndexBuildMemory;
+
+    /** Memory used for hash tables of the joined tables, in bytes */
+    std::size_t m_joinMemory = kDefaultIOManagerJoinMemory;
+
+    /** Memory used for sorting SELECT results by ORDER BY, in bytes */
+    std::size_t m_sortMemory = kDefaultIOManagerSortMemory;
+
+    /** Memory used for the groups of the aggregated SELECT results, in bytes */
+    std::size_t m_aggregationMemory = kDefaultIOManagerAggregationMemory;
 };
 
 /** Extenal cipher options */
@@ -72,6 +72,30 @@ std::uint64_t BlockRegistry::getPrevBlockId(std::uint64_t blockId) const
     return prevBlockId;
 }
 
+ColumnDataBlockState BlockRegistry::getBlockState(std::uint64_t blockId) const
+{
+    BREG_DBG_LOG_DEBUG("BlockRegistry::getBlockState(): " << m_column.getDisplayName()
+                                                          << ": blockId=" << blockId);
+
+    // Obtain block record location
+    const auto blockRecordOffset = checkBlockRecordPresent(blockId);
+
+    // Read block state
+    std::uint8_t buffer[sizeof(std::uint32_t)];
+    const auto readOffset = blockRecordOffset + BlockListRecord::kBlockStateSerializedFieldOffset;
+    if (::preadExact(m_blockListFile.getFd(), buffer, sizeof(buffer), readOffset, kIgnoreSignals)
+            != sizeof(buffer)) {
+        const int errorCode = errno;
+        throwDatabaseError(IOManagerMessageId::kErrorCannotReadBlockListDataFile, __func__,
+                m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(),
+                m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(), readOffset,
+                sizeof(buffer), errorCode, std::strerror(errorCode));
+    }
+    std::uint32_t state = 0;
+    ::pbeDecodeUInt32(buffer, &state);
+    return static_cast<ColumnDataBlockState>(state);
+}
+
 std::vector<std::uint64_t> BlockRegistry::getNextBlockIds(std::uint64_t blockId) const
 {
     std::vector<std::uint64_t> nextBlocks;
@@ -134,6 +158,9 @@ void BlockRegistry::recordBlock(
         blockRecord.serialize(buffer);
     }
 
+    // Block list is written synchronously, so logged block data must become durable first
+    m_column.commitWriteAheadLog();
+
     // Write record
     if (::pwriteExact(
                 m_blockListFile.getFd(), buffer, sizeof(buffer), blockRecordOffset, kIgnoreSignals)
@@ -156,6 +183,9 @@ void BlockRegistry::updateBlockState(std::uint64_t blockId, ColumnDataBlockState
 
     const auto blockRecordOffset = checkBlockRecordPresent(blockId);
 
+    // New state must not get ahead of logged block data
+    m_column.commitWriteAheadLog();
+
     // Write new block state
     std::uint8_t buffer[sizeof(std::uint32_t)];
     ::pbeEncodeUInt32(static_cast<std::uint32_t>(state), buffer);
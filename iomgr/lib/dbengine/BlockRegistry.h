@@ -23,6 +23,10 @@ class Column;
 
 /** Registry of block files in a column */
 class BlockRegistry {
+public:
+    /** Block registry subdirectory */
+    static constexpr const char* kBlockRegistryDir = "breg";
+
 public:
     /**
      * Initializes object of class BlockRegistry.
@@ -54,6 +58,13 @@ public:
      */
     std::vector<std::uint64_t> getNextBlockIds(std::uint64_t blockId) const;
 
+    /**
+     * Returns recorded state of a given block.
+     * @param blockId Block ID.
+     * @return Block state.
+     */
+    ColumnDataBlockState getBlockState(std::uint64_t blockId) const;
+
     /**
      * Records new block and next block if applicable.
      * @param blockId Block ID.
@@ -232,9 +243,6 @@ private:
     /** Last block ID */
     std::uint64_t m_lastBlockId;
 
-    /** Block registry subdirectory */
-    static constexpr const char* kBlockRegistryDir = "breg";
-
     /** Block list data file cache capacity */
     static constexpr std::size_t kBlockListDataFileCacheSize = 64;
 
@@ -0,0 +1,75 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "BufferedDataSet.h"
+
+namespace siodb::iomgr::dbengine {
+
+BufferedDataSet::BufferedDataSet(const DataSetPtr& source)
+    : DataSet(source->getAlias())
+    , m_source(source)
+    , m_row(nullptr)
+{
+    m_columnInfos.reserve(source->getColumnCount());
+    for (std::size_t i = 0, n = source->getColumnCount(); i != n; ++i) {
+        m_columnInfos.emplace_back(source->getColumnPosition(i), source->getColumnName(i),
+                source->getColumnAlias(i));
+    }
+}
+
+const std::string& BufferedDataSet::getName() const noexcept
+{
+    return m_source->getName();
+}
+
+void BufferedDataSet::resetCursor()
+{
+}
+
+bool BufferedDataSet::moveToNextRow()
+{
+    throw std::runtime_error("Buffered data set cursor can't be moved");
+}
+
+std::size_t BufferedDataSet::getBatchRowCount() const noexcept
+{
+    return 0;
+}
+
+const Variant* BufferedDataSet::getBatchColumnValues([[maybe_unused]] std::size_t index)
+{
+    throw std::runtime_error("Buffered data set has no batches");
+}
+
+const std::vector<Variant>& BufferedDataSet::getCurrentRow()
+{
+    // Normally should never happen
+    if (!m_hasCurrentRow) throw std::runtime_error("No more rows");
+    return *m_row;
+}
+
+const Variant& BufferedDataSet::getColumnValue(std::size_t index)
+{
+    // Normally should never happen
+    if (!m_hasCurrentRow) throw std::runtime_error("No more rows");
+    return m_row->at(index);
+}
+
+ColumnDataType BufferedDataSet::getColumnDataType(std::size_t index) const
+{
+    return m_source->getColumnDataType(index);
+}
+
+std::optional<std::uint32_t> BufferedDataSet::getDataSourceColumnPosition(
+        const std::string& name) const
+{
+    return m_source->getDataSourceColumnPosition(name);
+}
+
+std::uint32_t BufferedDataSet::getDataSourceId() const noexcept
+{
+    return m_source->getDataSourceId();
+}
+
+}  // namespace siodb::iomgr::dbengine
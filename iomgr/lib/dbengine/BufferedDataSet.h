@@ -0,0 +1,114 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "DataSet.h"
+
+// Common project headers
+#include <siodb/common/utils/HelperMacros.h>
+
+namespace siodb::iomgr::dbengine {
+
+/**
+ * Data set which exposes rows of another data set, buffered in memory by its owner.
+ * Owner chooses the current row, so cursor of this data set can't be moved.
+ */
+class BufferedDataSet final : public DataSet {
+public:
+    /**
+     * Initializes object of class BufferedDataSet.
+     * @param source Source data set. Column information is copied from it.
+     */
+    explicit BufferedDataSet(const DataSetPtr& source);
+
+    DECLARE_NONCOPYABLE(BufferedDataSet);
+
+    /**
+     * Returns data set name.
+     * @return Data set name.
+     */
+    const std::string& getName() const noexcept override;
+
+    /**
+     * Sets current row.
+     * @param row Row values, which must be valid until the next call, or nullptr
+     *            if there is no current row.
+     */
+    void setCurrentRow(const std::vector<Variant>* row) noexcept
+    {
+        m_row = row;
+        m_hasCurrentRow = row != nullptr;
+    }
+
+    /** Does nothing, current row is set by the owner. */
+    void resetCursor() override;
+
+    /**
+     * Cursor can't be moved, current row is set by the owner.
+     * @throw std::runtime_error always.
+     */
+    bool moveToNextRow() override;
+
+    /**
+     * Returns zero, rows are not read in batches.
+     * @return Number of rows in the batch.
+     */
+    std::size_t getBatchRowCount() const noexcept override;
+
+    /**
+     * Batch values are not available.
+     * @param index Column index.
+     * @throw std::runtime_error always.
+     */
+    const Variant* getBatchColumnValues(std::size_t index) override;
+
+    /**
+     * Returns current row.
+     * @return Current row.
+     * @throw std::runtime_error if row data is not available.
+     */
+    const std::vector<Variant>& getCurrentRow() override;
+
+    /**
+     * Returns column value from the current row.
+     * @param index Index of column in dataset.
+     * @return Column value.
+     * @throw std::runtime_error if row data is not available.
+     * @throw std::out_of_range if index is out of range.
+     */
+    const Variant& getColumnValue(std::size_t index) override;
+
+    /**
+     * Returns column data type.
+     * @param index Column index.
+     * @return Column data type.
+     * @throw std::out_of_range if index is out of range.
+     */
+    ColumnDataType getColumnDataType(std::size_t index) const override;
+
+    /**
+     * Returns column position in the data source. Queries data source directly.
+     * @param name Column name.
+     * @return Column position in the data source.
+     */
+    std::optional<std::uint32_t> getDataSourceColumnPosition(
+            const std::string& name) const override;
+
+    /**
+     * Returns data source ID.
+     * @return Underlying data source ID.
+     */
+    std::uint32_t getDataSourceId() const noexcept override;
+
+private:
+    /** Source data set */
+    const DataSetPtr m_source;
+
+    /** Current row */
+    const std::vector<Variant>* m_row;
+};
+
+}  // namespace siodb::iomgr::dbengine
@@ -26,6 +26,10 @@
 #include <siodb/common/utils/FsUtils.h>
 #include <siodb/common/utils/PlainBinaryEncoding.h>
 
+// STL headers
+#include <algorithm>
+#include <iterator>
+
 // Boost headers
 #include <boost/format.hpp>
 
@@ -71,14 +75,18 @@ Column::Column(Table& table, const ColumnSpecification& spec, std::uint64_t firs
     , m_dataType(validateColumnDataType(spec.m_dataType))
     , m_id(getDatabase().generateNextColumnId(m_table.isSystemTable()))
     , m_dataBlockDataAreaSize(spec.m_dataBlockDataAreaSize)
+    , m_dataWriterThreadId(std::thread::id())
     , m_dataDir(ensureDataDir(true))
     , m_masterColumnData(maybeCreateMasterColumnData(true, firstUserTrid))
     , m_columnDefinitionCache(kColumnDefinitionCacheCapacity)
     , m_currentColumnDefinition(createColumnDefinitionUnlocked())
     , m_notNull(false)
     , m_blockRegistry(*this, true)
+    , m_segmentStore(maybeCreateSegmentStore(true))
     , m_lastBlockId(m_blockRegistry.getLastBlockId())
-    , m_blockCache(getDatabase().getInstance().getBlockCacheCapacity())
+    , m_blockPool(getDatabase().getInstance().getBlockPool())
+    , m_blockFinalizer(getDatabase().getInstance().getBlockFinalizer())
+    , m_blockFinalizationScheduled(false)
 {
     if (isMasterColumn()) {
         if (!spec.m_constraints.empty()) {
@@ -121,6 +129,7 @@ Column::Column(Table& table, const ColumnRecord& columnRecord, std::uint64_t fir
     , m_dataType(validateColumnDataType(columnRecord.m_dataType))
     , m_id(columnRecord.m_id)
     , m_dataBlockDataAreaSize(columnRecord.m_dataBlockDataAreaSize)
+    , m_dataWriterThreadId(std::thread::id())
     , m_dataDir(ensureDataDir())
     , m_masterColumnData(maybeCreateMasterColumnData(false, firstUserTrid))
     , m_columnDefinitionCache(kColumnDefinitionCacheCapacity)
@@ -128,10 +137,25 @@ Column::Column(Table& table, const ColumnRecord& columnRecord, std::uint64_t fir
               getDatabase().getLatestColumnDefinitionIdForColumn(m_table.getId(), m_id)))
     , m_notNull(m_currentColumnDefinition->isNotNull())
     , m_blockRegistry(*this)
+    , m_segmentStore(maybeCreateSegmentStore(false))
     , m_lastBlockId(m_blockRegistry.getLastBlockId())
-    , m_blockCache(table.getDatabase().getInstance().getBlockCacheCapacity())
+    , m_blockPool(table.getDatabase().getInstance().getBlockPool())
+    , m_blockFinalizer(getDatabase().getInstance().getBlockFinalizer())
+    , m_blockFinalizationScheduled(false)
 {
-    checkDataConsistency();
+    try {
+        checkDataConsistency();
+    } catch (...) {
+        // Destructor won't be called, so blocks must be released here
+        m_blockPool.evictColumnBlocks(*this);
+        throw;
+    }
+}
+
+Column::~Column()
+{
+    waitForPendingBlockFinalization();
+    m_blockPool.evictColumnBlocks(*this);
 }
 
 std::string Column::getDisplayName() const
@@ -171,24 +195,96 @@ ColumnDefinitionPtr Column::getPrevColumnDefinition() const
 ColumnDataBlockPtr Column::createBlock(std::uint64_t prevBlockId, ColumnDataBlockState state)
 {
     std::lock_guard lock(m_mutex);
-    auto block = std::make_shared<ColumnDataBlock>(*this, prevBlockId, state);
-    m_blockCache.emplace(block->getId(), block);
-    m_blockRegistry.recordBlockAndNextBlock(block->getId(), prevBlockId);
-    return block;
+    DataWriteLock dataLock(*this);
+    return createBlockUnlocked(prevBlockId, state);
 }
 
 std::uint64_t Column::getPrevBlockId(std::uint64_t blockId) const
 {
-    std::lock_guard lock(m_mutex);
     return m_blockRegistry.getPrevBlockId(blockId);
 }
 
+std::vector<std::uint64_t> Column::getNextBlockIds(std::uint64_t blockId) const
+{
+    const auto lock = lockDataForReading();
+    return m_blockRegistry.getNextBlockIds(blockId);
+}
+
+void Column::readAheadBlock(std::uint64_t blockId) const
+{
+    if (m_blockPool.contains(*this, blockId)) return;
+    if (m_segmentStore) {
+        m_segmentStore->readAhead(blockId);
+        return;
+    }
+    const auto dataFilePath = ColumnDataBlock::makeDataFilePath(*this, blockId);
+    FileDescriptorGuard fd(::open(dataFilePath.c_str(), O_RDONLY | O_CLOEXEC));
+    if (fd.isValidFd()) ::posix_fadvise(fd.getFd(), 0, 0, POSIX_FADV_WILLNEED);
+}
+
+io::WriteAheadLog* Column::getWriteAheadLog() const noexcept
+{
+    return getDatabase().getInstance().getWriteAheadLog();
+}
+
+void Column::commitWriteAheadLog() const
+{
+    getDatabase().getInstance().commitWriteAheadLog();
+}
+
 void Column::updateBlockState(std::uint64_t blockId, ColumnDataBlockState state) const
 {
     std::lock_guard lock(m_mutex);
     m_blockRegistry.updateBlockState(blockId, state);
 }
 
+std::vector<ColumnDataBlockZoneMap> Column::getBlockZoneMaps()
+{
+    const auto lock = lockDataForReading();
+    const auto lastBlockId = m_lastBlockId.load();
+    std::vector<ColumnDataBlockZoneMap> zoneMaps;
+    zoneMaps.reserve(lastBlockId);
+    for (std::uint64_t blockId = 1; blockId <= lastBlockId; ++blockId) {
+        {
+            std::lock_guard cacheLock(m_closedBlockZoneMapsMutex);
+            const auto it = m_closedBlockZoneMaps.find(blockId);
+            if (it != m_closedBlockZoneMaps.end()) {
+                zoneMaps.push_back(it->second);
+                continue;
+            }
+        }
+        try {
+            const auto block = loadBlock(blockId);
+            zoneMaps.push_back(block->getZoneMap());
+            if (block->isFinalized()) {
+                std::lock_guard cacheLock(m_closedBlockZoneMapsMutex);
+                m_closedBlockZoneMaps.emplace(blockId, block->getZoneMap());
+            }
+        } catch (std::exception& ex) {
+            // Block must be always scanned, if its contents is unknown
+            LOG_DEBUG << "Column " << getDisplayName() << ": can't load block #" << blockId
+                      << " to obtain value summary: " << ex.what();
+            auto& zoneMap = zoneMaps.emplace_back();
+            zoneMap.m_complete = false;
+        }
+    }
+    return zoneMaps;
+}
+
+std::size_t Column::verifyBlock(std::uint64_t blockId)
+{
+    const auto lock = lockDataForReading();
+    // Data of other blocks is still changing, and their digest is not computed yet
+    if (m_blockRegistry.getBlockState(blockId) != ColumnDataBlockState::kClosed) return 0;
+    const auto block = getExistingBlock(blockId);
+    if (!block->isFinalized()) return 0;
+    const auto prevBlockId = block->getPrevBlockId();
+    const auto prevBlockDigest = prevBlockId != 0
+                                         ? getExistingBlock(prevBlockId)->getDigest()
+                                         : ColumnDataBlockHeader::kInitialPrevBlockDigest;
+    return block->verifyData(prevBlockDigest);
+}
+
 void Column::readRecord(
         const ColumnDataAddress& addr, Variant& value, bool lobStreamsMustHoldSource)
 {
@@ -200,8 +296,6 @@ void Column::readRecord(
         return;
     }
 
-    std::lock_guard lock(m_mutex);
-    auto block = getExistingBlock(addr.getBlockId());
     std::uint32_t requiredLength = m_minRequiredBlockFreeSpaces[m_dataType];
     if (addr.getOffset() + requiredLength >= m_dataBlockDataAreaSize) {
         throwDatabaseError(IOManagerMessageId::kErrorInvalidDataBlockPosition, getDatabaseName(),
@@ -209,6 +303,25 @@ void Column::readRecord(
                 m_id, addr.getOffset());
     }
 
+    // LOB streams lock column on each access by themselves
+    if (m_dataType == COLUMN_DATA_TYPE_TEXT) {
+        loadText(addr, value, lobStreamsMustHoldSource);
+        return;
+    }
+    if (m_dataType == COLUMN_DATA_TYPE_BINARY) {
+        loadBinary(addr, value, lobStreamsMustHoldSource);
+        return;
+    }
+
+    const auto lock = lockDataForReading();
+    auto block = getExistingBlock(addr.getBlockId());
+
+    // Values in closed blocks are decoded directly from the mapped data file
+    if (const auto data = block->getMappedData(addr.getOffset(), requiredLength)) {
+        decodeRecord(data, value);
+        return;
+    }
+
     switch (m_dataType) {
         case COLUMN_DATA_TYPE_BOOL: {
             std::uint8_t v = 0;
@@ -292,14 +405,6 @@ void Column::readRecord(
             value = v;
             break;
         }
-        case COLUMN_DATA_TYPE_TEXT: {
-            loadText(addr, value, lobStreamsMustHoldSource);
-            break;
-        }
-        case COLUMN_DATA_TYPE_BINARY: {
-            loadBinary(addr, value, lobStreamsMustHoldSource);
-            break;
-        }
         case COLUMN_DATA_TYPE_TIMESTAMP: {
             std::uint8_t buffer[RawDateTime::kMaxSerializedSize];
             block->readData(buffer, RawDateTime::kDatePartSerializedSize, addr.getOffset());
@@ -318,10 +423,183 @@ void Column::readRecord(
     }  // switch
 }
 
+void Column::decodeRecord(const std::uint8_t* data, Variant& value) const
+{
+    switch (m_dataType) {
+        case COLUMN_DATA_TYPE_BOOL: {
+            value = (*data != 0);
+            break;
+        }
+        case COLUMN_DATA_TYPE_INT8: {
+            value = static_cast<std::int8_t>(*data);
+            break;
+        }
+        case COLUMN_DATA_TYPE_UINT8: {
+            value = *data;
+            break;
+        }
+        case COLUMN_DATA_TYPE_INT16: {
+            std::int16_t v = 0;
+            ::pbeDecodeInt16(data, &v);
+            value = v;
+            break;
+        }
+        case COLUMN_DATA_TYPE_UINT16: {
+            std::uint16_t v = 0;
+            ::pbeDecodeUInt16(data, &v);
+            value = v;
+            break;
+        }
+        case COLUMN_DATA_TYPE_INT32: {
+            std::int32_t v = 0;
+            ::pbeDecodeInt32(data, &v);
+            value = v;
+            break;
+        }
+        case COLUMN_DATA_TYPE_UINT32: {
+            std::uint32_t v = 0;
+            ::pbeDecodeUInt32(data, &v);
+            value = v;
+            break;
+        }
+        case COLUMN_DATA_TYPE_INT64: {
+            std::int64_t v = 0;
+            ::pbeDecodeInt64(data, &v);
+            value = v;
+            break;
+        }
+        case COLUMN_DATA_TYPE_UINT64: {
+            std::uint64_t v = 0;
+            ::pbeDecodeUInt64(data, &v);
+            value = v;
+            break;
+        }
+        case COLUMN_DATA_TYPE_FLOAT: {
+            float v = 0;
+            ::pbeDecodeFloat(data, &v);
+            value = v;
+            break;
+        }
+        case COLUMN_DATA_TYPE_DOUBLE: {
+            double v = 0;
+            ::pbeDecodeDouble(data, &v);
+            value = v;
+            break;
+        }
+        case COLUMN_DATA_TYPE_TIMESTAMP: {
+            RawDateTime v;
+            v.deserializeDatePart(data);
+            if (v.m_datePart.m_hasTimePart) v.deserialize(data, RawDateTime::kMaxSerializedSize);
+            value = v;
+            break;
+        }
+        default: throw std::logic_error("invalid data type");
+    }  // switch
+}
+
+void Column::readRecords(const std::vector<ColumnDataAddress>& addresses,
+        std::vector<Variant>& values, bool lobStreamsMustHoldSource)
+{
+    values.resize(addresses.size());
+
+    // LOBs may span multiple blocks, so they are read one by one
+    if (m_dataType == COLUMN_DATA_TYPE_TEXT || m_dataType == COLUMN_DATA_TYPE_BINARY) {
+        for (std::size_t i = 0; i < addresses.size(); ++i)
+            readRecord(addresses[i], values[i], lobStreamsMustHoldSource);
+        return;
+    }
+
+    // Order non-NULL values by location
+    const std::uint32_t valueLength = m_minRequiredBlockFreeSpaces[m_dataType];
+    std::vector<std::size_t> order;
+    order.reserve(addresses.size());
+    for (std::size_t i = 0; i < addresses.size(); ++i) {
+        const auto& addr = addresses[i];
+        if (addr.isNullValueAddress()) {
+            values[i].clear();
+            continue;
+        }
+        if (addr.getOffset() + valueLength >= m_dataBlockDataAreaSize) {
+            throwDatabaseError(IOManagerMessageId::kErrorInvalidDataBlockPosition,
+                    getDatabaseName(), m_table.getName(), m_name, addr.getBlockId(),
+                    getDatabaseUuid(), m_table.getId(), m_id, addr.getOffset());
+        }
+        order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [&addresses](std::size_t left, std::size_t right) {
+        const auto& l = addresses[left];
+        const auto& r = addresses[right];
+        return l.getBlockId() < r.getBlockId()
+               || (l.getBlockId() == r.getBlockId() && l.getOffset() < r.getOffset());
+    });
+
+    const auto lock = lockDataForReading();
+
+    // Obtain all involved blocks and load their data with single I/O batch
+    std::vector<ColumnDataBlockPtr> blocks;
+    for (auto it = order.begin(); it != order.end(); ++it) {
+        const auto blockId = addresses[*it].getBlockId();
+        if (blocks.empty() || blocks.back()->getId() != blockId)
+            blocks.push_back(getExistingBlock(blockId));
+    }
+    if (blocks.size() > 1) ColumnDataBlock::loadData(blocks);
+
+    std::vector<std::uint8_t> buffer;
+    auto blockIt = blocks.begin();
+    for (auto it = order.begin(); it != order.end(); ++blockIt) {
+        const auto& block = *blockIt;
+        const auto blockId = block->getId();
+        const auto blockEnd = std::find_if(it, order.end(), [&addresses, blockId](std::size_t i) {
+            return addresses[i].getBlockId() != blockId;
+        });
+
+        // Mapped block: decode in place
+        if (block->isDataMapped()) {
+            for (; it != blockEnd; ++it) {
+                const auto offset = addresses[*it].getOffset();
+                decodeRecord(block->getMappedData(offset, valueLength), values[*it]);
+            }
+            continue;
+        }
+
+        // Otherwise read neighbouring values with single read
+        while (it != blockEnd) {
+            const auto start = addresses[*it].getOffset();
+            auto end = start + valueLength;
+            auto rangeEnd = std::next(it);
+            while (rangeEnd != blockEnd) {
+                const auto nextEnd = addresses[*rangeEnd].getOffset() + valueLength;
+                if (nextEnd - start > kMaxBatchReadSize) break;
+                end = std::max(end, nextEnd);
+                ++rangeEnd;
+            }
+            buffer.resize(end - start);
+            block->readData(buffer.data(), buffer.size(), start);
+            for (; it != rangeEnd; ++it)
+                decodeRecord(buffer.data() + (addresses[*it].getOffset() - start), values[*it]);
+        }
+    }
+}
+
 void Column::readMasterColumnRecord(const ColumnDataAddress& addr, MasterColumnRecord& record)
 {
-    // Read MCR size
+    const auto lock = lockDataForReading();
     auto block = getExistingBlock(addr.getBlockId());
+
+    // Decode MCR directly from the mapped data file, if possible
+    if (addr.getOffset() + 2 <= m_dataBlockDataAreaSize) {
+        if (const auto data = block->getMappedData(addr.getOffset(), 2)) {
+            std::uint16_t recordSize = 0;
+            const int n = ::decodeVarUInt16(data, 2, &recordSize);
+            if (n > 0 && recordSize <= MasterColumnRecord::kMaxSerializedSize) {
+                record.deserialize(
+                        block->getMappedData(addr.getOffset() + n, recordSize), recordSize);
+                return;
+            }
+        }
+    }
+
+    // Read MCR size
     std::uint8_t recordSizeBuffer[2];
     auto offset = addr.getOffset();
     block->readData(recordSizeBuffer, 1, offset++);
@@ -342,17 +620,23 @@ void Column::readMasterColumnRecord(const ColumnDataAddress& addr, MasterColumnR
     record.deserialize(buffer.get(), recordSize);
 }
 
-std::pair<ColumnDataAddress, ColumnDataAddress> Column::putRecord(Variant&& value)
+std::pair<ColumnDataAddress, ColumnDataAddress> Column::putRecord(
+        Variant&& value, std::uint64_t trid)
 {
     std::lock_guard lock(m_mutex);
+    DataWriteLock dataLock(*this);
 
     // Handle NULL value
     if (value.isNull()) {
         if (m_notNull) {
             throwDatabaseError(IOManagerMessageId::kErrorCannotInsertNullValue, getDatabaseName(),
                     m_table.getName(), m_name);
-        } else
-            return std::make_pair(kNullValueAddress, kNullValueAddress);
+        }
+        // NULL values take no space, so they are accounted in the block
+        // which receives values of this column
+        const auto blockId = findAvailableBlockId(m_minRequiredBlockFreeSpaces[m_dataType]);
+        if (blockId != 0) loadBlock(blockId)->addZoneMapNull();
+        return std::make_pair(kNullValueAddress, kNullValueAddress);
     }
 
     Variant v;
@@ -602,6 +886,9 @@ std::pair<ColumnDataAddress, ColumnDataAddress> Column::putRecord(Variant&& valu
         }
     }  // switch
 
+    // Update block value summary
+    if (const auto key = getZoneMapKey(m_dataType, v)) block->addZoneMapValue(*key, trid);
+
     // Update block free space
     block->incNextDataPos(actualLength);
     itBlock->second = block->getFreeDataSpace();
@@ -633,6 +920,7 @@ std::pair<ColumnDataAddress, ColumnDataAddress> Column::putMasterColumnRecord(
     std::unique_ptr<std::uint8_t[]> buffer(new std::uint8_t[recordSizeWithSizeTag]);
 
     std::lock_guard lock(m_mutex);
+    DataWriteLock dataLock(*this);
 
     // Get available block
     auto block = selectAvailableBlock(recordSizeWithSizeTag);
@@ -706,6 +994,7 @@ void Column::rollbackToAddress(
         const ColumnDataAddress& addr, const std::uint64_t firstAvailableBlockId)
 {
     std::lock_guard lock(m_mutex);
+    DataWriteLock dataLock(*this);
 
     // Check first available data block
     if (m_availableDataBlocks.count(firstAvailableBlockId) == 0) {
@@ -747,10 +1036,12 @@ void Column::rollbackToAddress(
                     getDatabaseUuid(), m_table.getId(), m_id);
         }
 
-        // Adjust block metadata
-        block->setNextDataPos(0);
+        // Adjust block metadata. Block must be reopened before data is truncated,
+        // so that encoded data is restored completely.
         block->resetFillTimestamp();
+        block->setNextDataPos(0);
         block->saveHeader();
+        forgetClosedBlockZoneMap(currentBlockId);
 
         // Update block free space info
         updateAvailableBlock(*block);
@@ -765,11 +1056,13 @@ void Column::rollbackToAddress(
     }
 
     // Adjust block metadata
-    block->setNextDataPos(addr.getOffset());
-    if (block->getId() != firstAvailableBlockId) {
+    const bool reopenBlock = block->getId() != firstAvailableBlockId;
+    if (reopenBlock) {
         block->resetFillTimestamp();
-        block->saveHeader();
+        forgetClosedBlockZoneMap(block->getId());
     }
+    block->setNextDataPos(addr.getOffset());
+    if (reopenBlock) block->saveHeader();
 
     updateAvailableBlock(*block);
 }
@@ -777,7 +1070,7 @@ void Column::rollbackToAddress(
 std::uint32_t Column::loadLobChunkHeader(
         std::uint64_t blockId, std::uint32_t offset, LobChunkHeader& header)
 {
-    std::lock_guard lock(m_mutex);
+    const auto lock = lockDataForReading();
     auto block = getExistingBlock(blockId);
     return loadLobChunkHeaderUnlocked(*block, offset, header);
 }
@@ -785,7 +1078,7 @@ std::uint32_t Column::loadLobChunkHeader(
 void Column::readData(
         std::uint64_t blockId, std::uint32_t offset, void* buffer, std::size_t bufferSize)
 {
-    std::lock_guard lock(m_mutex);
+    const auto lock = lockDataForReading();
     auto block = getExistingBlock(blockId);
     block->readData(buffer, bufferSize, offset);
 }
@@ -1002,10 +1295,16 @@ void Column::checkDataConsistency()
             // We can check only closed blocks
             if (currentBlock->getState() != ColumnDataBlockState::kClosed) break;
 
+            // Block is loaded anyway, so keep its value summary for block skipping
+            {
+                std::lock_guard cacheLock(m_closedBlockZoneMapsMutex);
+                m_closedBlockZoneMaps[currentBlock->getId()] = currentBlock->getZoneMap();
+            }
+
             // Check block digest based on data in block
             ColumnDataBlockHeader::Digest currentBlockDigest;
             currentBlock->computeDigest(blockInfo.m_prevBlockDigest, currentBlockDigest);
-            if (currentBlock->getDigest() == currentBlockDigest) {
+            if (currentBlock->getDigest() != currentBlockDigest) {
                 LOG_DEBUG << "block digest mismatch";
                 throwDatabaseError(IOManagerMessageId::kErrorColumnDataBlockConsistencyMismatch,
                         getDatabaseName(), m_table.getName(), getName(), blockInfo.m_currentBlockId,
@@ -1052,30 +1351,53 @@ ColumnDefinitionPtr Column::createColumnDefinitionUnlocked(
     return columnDefinition;
 }
 
+std::shared_lock<std::shared_mutex> Column::lockDataForReading() const
+{
+    if (m_dataWriterThreadId.load() == std::this_thread::get_id()) return {};
+    return std::shared_lock(m_dataMutex);
+}
+
+ColumnDataBlockPtr Column::createBlockUnlocked(
+        std::uint64_t prevBlockId, ColumnDataBlockState state)
+{
+    auto block = std::make_shared<ColumnDataBlock>(*this, prevBlockId, state);
+    m_blockPool.emplace(block);
+    m_blockRegistry.recordBlockAndNextBlock(block->getId(), prevBlockId);
+    return block;
+}
+
 ColumnDataBlockPtr Column::loadBlock(std::uint64_t blockId)
 {
-    std::lock_guard lock(m_mutex);
-    auto block = m_blockCache.get(blockId).value_or(nullptr);
-    if (!block) {
-        block = std::make_shared<ColumnDataBlock>(*this, blockId);
-        m_blockCache.emplace(block->getId(), block);
+    auto block = m_blockPool.get(*this, blockId);
+    if (block) return block;
+    // Concurrent readers may load the same block simultaneously,
+    // only one instance gets into the pool and is used by all of them.
+    return m_blockPool.emplace(std::make_shared<ColumnDataBlock>(*this, blockId));
+}
+
+std::uint64_t Column::findAvailableBlockId(std::size_t requiredLength) const noexcept
+{
+    for (const auto& block : m_availableDataBlocks) {
+        if (block.second >= requiredLength) return block.first;
     }
-    return block;
+    return 0;
 }
 
 ColumnDataBlockPtr Column::selectAvailableBlock(std::size_t requiredLength)
 {
     // If there are no available blocks, just create new one
     if (m_availableDataBlocks.empty()) {
-        auto block = createBlock(0, ColumnDataBlockState::kCurrent);
+        auto block = createBlockUnlocked(0, ColumnDataBlockState::kCurrent);
         m_availableDataBlocks.emplace(block->getId(), block->getFreeDataSpace());
         return block;
     }
 
     // Try to find some block that has enough room
+    const auto availableBlockId = findAvailableBlockId(requiredLength);
+    if (availableBlockId != 0) return loadBlock(availableBlockId);
+
     std::pair<std::uint64_t, std::uint32_t> minFreeSpaceBlock = *m_availableDataBlocks.begin();
     for (const auto& block : m_availableDataBlocks) {
-        if (block.second >= requiredLength) return loadBlock(block.first);
         if (minFreeSpaceBlock.second < block.second) minFreeSpaceBlock = block;
     }
 
@@ -1132,28 +1454,103 @@ ColumnDataBlockPtr Column::createOrGetNextBlock(
     if (!nextBlock) {
         // There are either no existing next blocks or no one of them has matched
         // So create new block
-        nextBlock = createBlock(block.getId());
+        nextBlock = createBlockUnlocked(block.getId(), ColumnDataBlockState::kCreating);
     }
 
-    // Obtain previous block header
-    ColumnDataBlockHeader::Digest prevBlockDigest;
+    closeBlock(block);
+    m_availableDataBlocks.erase(block.getId());
+    updateAvailableBlock(*nextBlock);
+    return nextBlock;
+}
+
+void Column::closeBlock(ColumnDataBlock& block)
+{
+    PendingBlockFinalization pending;
+    // Block pool is shared by all columns, so previous block may have been evicted
     const auto prevBlockId = block.getPrevBlockId();
-    if (prevBlockId == 0)
-        prevBlockDigest = ColumnDataBlockHeader::kInitialPrevBlockDigest;
-    else {
-        auto prevBlock = m_blockCache.get(prevBlockId).value_or(nullptr);
-        if (!prevBlock) {
-            throwDatabaseError(IOManagerMessageId::kErrorColumnDataBlockNotAvailable,
-                    getDatabaseName(), m_table.getName(), m_name, prevBlockId, getDatabaseUuid(),
-                    m_table.getId(), m_id);
+    if (prevBlockId != 0) pending.m_prevBlock = getExistingBlock(prevBlockId);
+
+    pending.m_closeSequence = block.close();
+    {
+        std::lock_guard cacheLock(m_closedBlockZoneMapsMutex);
+        m_closedBlockZoneMaps[block.getId()] = block.getZoneMap();
+    }
+
+    // Pin block until it is finalized. Block is finalized only after column data
+    // is unlocked, because caller may still write to it, e.g. LOB chunk header.
+    pending.m_block = getExistingBlock(block.getId());
+    std::lock_guard lock(m_pendingBlockFinalizationsMutex);
+    m_pendingBlockFinalizations.push_back(std::move(pending));
+}
+
+void Column::finalizePendingBlocks()
+{
+    std::unique_lock lock(m_pendingBlockFinalizationsMutex);
+    while (!m_pendingBlockFinalizations.empty()) {
+        const auto pending = m_pendingBlockFinalizations.front();
+        lock.unlock();
+        try {
+            // Previous block has been closed earlier, so it is already finalized
+            const auto prevBlockDigest = pending.m_prevBlock
+                                                 ? pending.m_prevBlock->getDigest()
+                                                 : ColumnDataBlockHeader::kInitialPrevBlockDigest;
+            // Digest and encoded data are computed without blocking concurrent inserts
+            const auto finalization = pending.m_block->prepareFinalization(
+                    prevBlockDigest, pending.m_closeSequence);
+            if (finalization) {
+                std::lock_guard persistentLock(m_mutex);
+                DataWriteLock dataLock(*this);
+                if (!pending.m_block->finalize(*finalization)) {
+                    LOG_DEBUG << "Column " << getDisplayName() << ": block #"
+                              << pending.m_block->getId()
+                              << " was reopened before finalization";
+                }
+            }
+        } catch (std::exception& ex) {
+            LOG_ERROR << "Column " << getDisplayName() << ": can't finalize block #"
+                      << pending.m_block->getId() << ": " << ex.what();
         }
-        prevBlockDigest = prevBlock->getDigest();
+        lock.lock();
+        m_pendingBlockFinalizations.pop_front();
     }
+    m_blockFinalizationScheduled = false;
+    m_pendingBlockFinalizationsCond.notify_all();
+}
 
-    block.finalize(prevBlockDigest);
-    m_availableDataBlocks.erase(block.getId());
-    updateAvailableBlock(*nextBlock);
-    return nextBlock;
+void Column::schedulePendingBlockFinalization() noexcept
+{
+    std::unique_lock lock(m_pendingBlockFinalizationsMutex);
+    if (m_blockFinalizationScheduled || m_pendingBlockFinalizations.empty()) return;
+    m_blockFinalizationScheduled = true;
+    lock.unlock();
+    try {
+        if (m_blockFinalizer)
+            m_blockFinalizer->submit(*this);
+        else
+            finalizePendingBlocks();
+    } catch (std::exception& ex) {
+        // Blocks will be submitted again when column data is unlocked next time
+        LOG_ERROR << "Column " << getDisplayName() << ": can't schedule block finalization: "
+                  << ex.what();
+        lock.lock();
+        m_blockFinalizationScheduled = false;
+        m_pendingBlockFinalizationsCond.notify_all();
+    }
+}
+
+void Column::waitForPendingBlockFinalization()
+{
+    schedulePendingBlockFinalization();
+    std::unique_lock lock(m_pendingBlockFinalizationsMutex);
+    m_pendingBlockFinalizationsCond.wait(lock, [this] {
+        return !m_blockFinalizationScheduled && m_pendingBlockFinalizations.empty();
+    });
+}
+
+void Column::forgetClosedBlockZoneMap(std::uint64_t blockId)
+{
+    std::lock_guard cacheLock(m_closedBlockZoneMapsMutex);
+    m_closedBlockZoneMaps.erase(blockId);
 }
 
 ColumnDataBlockPtr Column::getExistingBlock(std::uint64_t blockId)
@@ -1173,6 +1570,9 @@ std::uint64_t Column::findFirstBlock() const
     constexpr auto kColumnDataBlockFileStaticLength =
             kColumnDataBlockFilePrefixLength + kColumnDataBlockFileExtensionLength;
 
+    // Blocks stored in the segment files are known from the offset table
+    if (m_segmentStore) return m_segmentStore->getFirstBlockId();
+
     // Find first available block
     auto firstBlockId = std::numeric_limits<std::uint64_t>::max();
     for (const auto& entry : fs::directory_iterator(m_dataDir)) {
@@ -1355,9 +1755,8 @@ std::pair<ColumnDataAddress, ColumnDataAddress> Column::storeBuffer(
 
 void Column::loadText(const ColumnDataAddress& addr, Variant& value, bool lobStreamsMustHoldSource)
 {
-    auto block = getExistingBlock(addr.getBlockId());
     LobChunkHeader chunkHeader;
-    loadLobChunkHeaderUnlocked(*block, addr.getOffset(), chunkHeader);
+    loadLobChunkHeader(addr.getBlockId(), addr.getOffset(), chunkHeader);
     if (chunkHeader.m_remainingLobLength == 0) {
         // Empty string
         value = std::string();
@@ -1379,9 +1778,8 @@ void Column::loadText(const ColumnDataAddress& addr, Variant& value, bool lobStr
 void Column::loadBinary(
         const ColumnDataAddress& addr, Variant& value, bool lobStreamsMustHoldSource)
 {
-    auto block = getExistingBlock(addr.getBlockId());
     LobChunkHeader chunkHeader;
-    loadLobChunkHeaderUnlocked(*block, addr.getOffset(), chunkHeader);
+    loadLobChunkHeader(addr.getBlockId(), addr.getOffset(), chunkHeader);
     if (chunkHeader.m_remainingLobLength == 0) {
         // Empty binary
         value = BinaryValue();
@@ -1573,6 +1971,18 @@ std::unique_ptr<Column::MasterColumnData> Column::maybeCreateMasterColumnData(
     return std::make_unique<MasterColumnData>(*this, create, firstUserTrid);
 }
 
+std::unique_ptr<ColumnSegmentStore> Column::maybeCreateSegmentStore(bool create) const
+{
+    if (create) {
+        const auto segmentFileSize = getDatabase().getInstance().getSegmentFileSize();
+        if (segmentFileSize == 0) return nullptr;
+        return std::make_unique<ColumnSegmentStore>(*this, segmentFileSize);
+    }
+    // Existing columns keep storage mode with which they were created
+    if (!ColumnSegmentStore::exists(*this)) return nullptr;
+    return std::make_unique<ColumnSegmentStore>(*this);
+}
+
 /////////////////// struct Column::MasterColumnData ///////////////////////////////////////////////
 
 Column::MasterColumnData::MasterColumnData(
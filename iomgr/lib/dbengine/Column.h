@@ -6,7 +6,10 @@
 
 // Project headers
 #include "BlockRegistry.h"
-#include "ColumnDataBlockCache.h"
+#include "ColumnDataBlockFinalizer.h"
+#include "ColumnDataBlockPool.h"
+#include "ColumnDataBlockZoneMap.h"
+#include "ColumnSegmentStore.h"
 #include "ColumnDefinitionCache.h"
 #include "ColumnPtr.h"
 #include "IndexPtr.h"
@@ -18,7 +21,11 @@
 
 // STL headers
 #include <array>
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <shared_mutex>
+#include <thread>
 #include <unordered_map>
 
 namespace siodb::iomgr::dbengine {
@@ -49,6 +56,9 @@ public:
      */
     Column(Table& table, const ColumnRecord& columnRecord, std::uint64_t firstUserTrid);
 
+    /** De-initializes object of class Column */
+    ~Column();
+
     DECLARE_NONCOPYABLE(Column);
 
     /**
@@ -238,6 +248,27 @@ public:
         return m_blockRegistry.getLastBlockId();
     }
 
+    /**
+     * Returns segment store of the column.
+     * @return Segment store or nullptr if each data block of the column is stored in own file.
+     */
+    ColumnSegmentStore* getSegmentStore() const noexcept
+    {
+        return m_segmentStore.get();
+    }
+
+    /**
+     * Returns write-ahead log which records writes of the column files.
+     * @return Write-ahead log or nullptr if column files are written synchronously.
+     */
+    io::WriteAheadLog* getWriteAheadLog() const noexcept;
+
+    /**
+     * Makes writes of the column files done so far durable.
+     * @throw DatabaseError if write-ahead log can't be written.
+     */
+    void commitWriteAheadLog() const;
+
     /**
      * Returns indication that column doesn't allow NULL values.
      * @return true is column doesn't allow NULL values, false otherwise.
@@ -269,13 +300,30 @@ public:
 
     /**
      * Returns ID of the previous block in the chain for the given block
-     * based on the information in the block registry.
+     * based on the information in the block registry. Doesn't lock column,
+     * must be called with column data locked either for reading or for writing.
      * @param blockId A block identifier.
      * @return Previous block ID in the chain.
      * @throw DatabaseError if given block doesn't exist in the block registry.
      */
     std::uint64_t getPrevBlockId(std::uint64_t blockId) const;
 
+    /**
+     * Returns IDs of the next blocks in the chain for the given block
+     * based on the information in the block registry.
+     * @param blockId A block identifier.
+     * @return List of next block IDs, the most recent one is the last.
+     * @throw DatabaseError if given block doesn't exist in the block registry.
+     */
+    std::vector<std::uint64_t> getNextBlockIds(std::uint64_t blockId) const;
+
+    /**
+     * Advises OS to read data file of the given block into the page cache in background,
+     * unless block is already in the block pool. Errors are ignored.
+     * @param blockId A block identifier.
+     */
+    void readAheadBlock(std::uint64_t blockId) const;
+
     /**
      * Update state of the the given block in the block registry.
      * @param blockId A block identifier.
@@ -284,6 +332,32 @@ public:
      */
     void updateBlockState(std::uint64_t blockId, ColumnDataBlockState state) const;
 
+    /**
+     * Returns summaries of values stored in all blocks of this column.
+     * Summaries of closed blocks are cached, they are collected when blocks
+     * are checked on column opening and when blocks are closed, so only blocks
+     * which are still written are loaded. Blocks which can't be loaded
+     * are reported with incomplete summary.
+     * @return Value summaries of blocks, indexed by block ID minus one.
+     */
+    std::vector<ColumnDataBlockZoneMap> getBlockZoneMaps();
+
+    /**
+     * Verifies stored data of the given block, if it is closed and finalized:
+     * data checksum and digest chain.
+     * @param blockId Block ID.
+     * @return Number of bytes read from disk, zero if block is not verified.
+     * @throw DatabaseError if block data is corrupted or can't be read.
+     */
+    std::size_t verifyBlock(std::uint64_t blockId);
+
+    /**
+     * Finalizes closed blocks of this column in the order of closing,
+     * until there are no more blocks waiting for finalization.
+     * Called by the block finalizer.
+     */
+    void finalizePendingBlocks();
+
     /**
      * Read data from the data file.
      * @param addr Data address.
@@ -294,6 +368,17 @@ public:
     void readRecord(
             const ColumnDataAddress& addr, Variant& value, bool lobStreamsMustHoldSource = true);
 
+    /**
+     * Reads multiple records from the data file. Records are read in the order of their
+     * location, neighbouring records from the same block are read at once.
+     * @param addresses Data addresses.
+     * @param[out] values Resulting values, in the same order as addresses.
+     * @param lobStreamsMustHoldSource Flag indicates that data source must be hold by any
+     *                                 underlying LOB stream objects.
+     */
+    void readRecords(const std::vector<ColumnDataAddress>& addresses, std::vector<Variant>& values,
+            bool lobStreamsMustHoldSource = true);
+
     /**
      * Read master column record from the data file.
      * @param addr Data address.
@@ -304,9 +389,10 @@ public:
     /**
      * Adds new data to a column.
      * @param value A value to put. May be altered by this function.
+     * @param trid Table row ID to which value belongs.
      * @return Pair containing data address and next data address
      */
-    std::pair<ColumnDataAddress, ColumnDataAddress> putRecord(Variant&& value);
+    std::pair<ColumnDataAddress, ColumnDataAddress> putRecord(Variant&& value, std::uint64_t trid);
 
     /**
      * Adds new data to a master column.
@@ -468,6 +554,46 @@ private:
         TridCounters* const m_tridCounters;
     };
 
+    /**
+     * Exclusive lock of the column data, which remembers owner thread so that
+     * this thread can still read column data, for example via LOB stream
+     * of the same column.
+     */
+    class DataWriteLock {
+    public:
+        /**
+         * Initializes object of class DataWriteLock.
+         * @param column Column which data is to be locked.
+         */
+        explicit DataWriteLock(Column& column)
+            : m_column(column)
+            , m_lock(column.m_dataMutex)
+        {
+            m_column.m_dataWriterThreadId.store(std::this_thread::get_id());
+        }
+
+        /**
+         * De-initializes object of class DataWriteLock. Schedules finalization
+         * of the blocks closed while data was locked, because they are
+         * not modified anymore.
+         */
+        ~DataWriteLock()
+        {
+            m_column.m_dataWriterThreadId.store(std::thread::id());
+            m_lock.unlock();
+            m_column.schedulePendingBlockFinalization();
+        }
+
+        DECLARE_NONCOPYABLE(DataWriteLock);
+
+    private:
+        /** Locked column */
+        Column& m_column;
+
+        /** Underlying lock */
+        std::unique_lock<std::shared_mutex> m_lock;
+    };
+
 private:
     /**
      * Returns indication that column name is master column name.
@@ -538,12 +664,35 @@ private:
     }
 
     /**
-     * Obtains existing column data block.
+     * Locks column data for reading. Lock is not actually taken if current thread
+     * already holds column data locked for writing.
+     * @return Lock object.
+     */
+    std::shared_lock<std::shared_mutex> lockDataForReading() const;
+
+    /**
+     * Creates new column data block. Column data must be locked for writing.
+     * @param prevBlockId Previous Block ID.
+     * @param state Initial block state.
+     * @return Column data block object.
+     */
+    ColumnDataBlockPtr createBlockUnlocked(std::uint64_t prevBlockId, ColumnDataBlockState state);
+
+    /**
+     * Obtains existing column data block. Column data must be locked
+     * either for reading or for writing.
      * @param blockId Block ID.
      * @return Column data block object.
      */
     ColumnDataBlockPtr loadBlock(std::uint64_t blockId);
 
+    /**
+     * Finds available block that can store at least given amount of bytes.
+     * @param requiredLength Required data length.
+     * @return Block ID or zero if there is no such block.
+     */
+    std::uint64_t findAvailableBlockId(std::size_t requiredLength) const noexcept;
+
     /**
      * Selects available block or creates new one that can store at least given amount of bytes.
      * @param requiredLength Required data length.
@@ -566,6 +715,32 @@ private:
      */
     ColumnDataBlockPtr createOrGetNextBlock(ColumnDataBlock& block, std::size_t requiredFreeSpace);
 
+    /**
+     * Closes filled block. Block is finalized after column data is unlocked,
+     * by the block finalizer or by the current thread if there is no block finalizer.
+     * Column data must be locked for writing.
+     * @param block A block.
+     */
+    void closeBlock(ColumnDataBlock& block);
+
+    /**
+     * Submits column to the block finalizer if it has blocks waiting for finalization.
+     * Finalizes them in the current thread if there is no block finalizer.
+     */
+    void schedulePendingBlockFinalization() noexcept;
+
+    /**
+     * Waits until all closed blocks of this column are finalized.
+     * Column data must not be locked by the current thread.
+     */
+    void waitForPendingBlockFinalization();
+
+    /**
+     * Removes cached value summary of the block which is reopened for writing.
+     * @param blockId Block ID.
+     */
+    void forgetClosedBlockZoneMap(std::uint64_t blockId);
+
     /**
      * Gets existing block into memory and returns cached object.
      * @param blockId Block ID.
@@ -627,6 +802,13 @@ private:
     std::pair<ColumnDataAddress, ColumnDataAddress> storeBuffer(
             const void* src, std::uint32_t length, ColumnDataBlockPtr block);
 
+    /**
+     * Decodes value of the fixed size data type from memory.
+     * @param data Pointer to the encoded value.
+     * @param[out] value Decoded value.
+     */
+    void decodeRecord(const std::uint8_t* data, Variant& value) const;
+
     /**
      * Loads TEXT data.
      * @param addr Data address.
@@ -702,6 +884,14 @@ private:
     std::unique_ptr<MasterColumnData> maybeCreateMasterColumnData(
             bool create, std::uint64_t firstUserTrid);
 
+    /**
+     * Creates segment store if column stores data blocks in the segment files.
+     * New columns use segment files if segment file size is configured.
+     * @param create Indicates that segment store must be created.
+     * @return Segment store or nullptr if column stores each data block in own file.
+     */
+    std::unique_ptr<ColumnSegmentStore> maybeCreateSegmentStore(bool create) const;
+
 private:
     /** Table to which this column belongs */
     Table& m_table;
@@ -724,6 +914,15 @@ private:
     /** Persistent info access synchronizarion object */
     mutable std::recursive_mutex m_mutex;
 
+    /**
+     * Data access synchronization object. Readers share it, while adding data
+     * and creating blocks require exclusive access. Must be locked after m_mutex.
+     */
+    mutable std::shared_mutex m_dataMutex;
+
+    /** Thread which holds column data locked for writing */
+    mutable std::atomic<std::thread::id> m_dataWriterThreadId;
+
     /** Column data directory */
     const std::string m_dataDir;
 
@@ -755,11 +954,53 @@ private:
     /** Block registry */
     BlockRegistry m_blockRegistry;
 
+    /** Segment store, exists only if data blocks are stored in the segment files */
+    const std::unique_ptr<ColumnSegmentStore> m_segmentStore;
+
     /** Last block ID */
     std::atomic<std::uint64_t> m_lastBlockId;
 
-    /** Cached blocks */
-    ColumnDataBlockCache m_blockCache;
+    /** Instance-wide block pool, which caches blocks of this column */
+    ColumnDataBlockPool& m_blockPool;
+
+    /** Value summaries of closed blocks, key is block ID */
+    std::unordered_map<std::uint64_t, ColumnDataBlockZoneMap> m_closedBlockZoneMaps;
+
+    /** Closed block value summaries access synchronization object */
+    std::mutex m_closedBlockZoneMapsMutex;
+
+    /** Closed block waiting for finalization */
+    struct PendingBlockFinalization {
+        /** Closed block */
+        ColumnDataBlockPtr m_block;
+
+        /** Previous block, nullptr if closed block is the first one in the chain */
+        ColumnDataBlockPtr m_prevBlock;
+
+        /** Close sequence number of the closed block */
+        std::uint64_t m_closeSequence;
+    };
+
+    /**
+     * Instance-wide block finalizer, nullptr if blocks are finalized
+     * by the inserting thread.
+     */
+    ColumnDataBlockFinalizer* const m_blockFinalizer;
+
+    /**
+     * Closed blocks waiting for finalization, in the order of closing.
+     * Block stays in the queue until its finalization completes.
+     */
+    std::deque<PendingBlockFinalization> m_pendingBlockFinalizations;
+
+    /** Indicates that column is submitted to the block finalizer */
+    bool m_blockFinalizationScheduled;
+
+    /** Pending block finalizations access synchronization object */
+    std::mutex m_pendingBlockFinalizationsMutex;
+
+    /** Signals that column has finalized all pending blocks */
+    std::condition_variable m_pendingBlockFinalizationsCond;
 
     /** Minimum required block free spaces for various column data type */
     static const std::array<std::uint32_t, ColumnDataType_MAX> m_minRequiredBlockFreeSpaces;
@@ -785,6 +1026,9 @@ private:
     /** TRID counter migration file extension */
     static constexpr const char* kTridCounterMigrationFileExt = ".mig";
 
+    /** Maximum size of the data range read at once by readRecords() */
+    static constexpr std::size_t kMaxBatchReadSize = 0x10000;
+
     /** Master column main index key size */
     static constexpr std::size_t kMasterColumnNameMainIndexKeySize = 8;
 
@@ -5,6 +5,9 @@
 #include "ColumnDataBlock.h"
 
 // Project headers
+#include "Database.h"
+#include "Instance.h"
+#include "io/FileIoBatch.h"
 #include <siodb-generated/iomgr/lib/messages/IOManagerMessageId.h>
 #include "ThrowDatabaseError.h"
 
@@ -24,15 +27,20 @@
 #include <cstring>
 
 // STL headers
+#include <algorithm>
 #include <sstream>
 
 // System headers
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 // OpenSSL
 #include <openssl/sha.h>
 
+// xxHash library
+#include "xxhash.h"
+
 namespace siodb::iomgr::dbengine {
 
 const BinaryValue ColumnDataBlock::m_dataFileHeaderProto(kDataFileHeaderSize, 0);
@@ -43,9 +51,13 @@ ColumnDataBlock::ColumnDataBlock(
     , m_header(column.getDatabaseUuid(), column.getTableId(), column.getId(),
               m_column.generateNextBlockId(), column.getDataBlockDataAreaSize())
     , m_prevBlockId(prevBlockId)
+    , m_extent(allocateExtent())
     , m_dataFilePath(makeDataFilePath())
     , m_file(createDataFile())
+    , m_dataLoaded(true)
+    , m_mappedData(nullptr)
     , m_state(state)
+    , m_closeSequence(0)
     , m_headerModified(false)
     , m_dataModified(false)
 {
@@ -57,21 +69,29 @@ ColumnDataBlock::ColumnDataBlock(Column& column, std::uint64_t id)
     , m_header(column.getDatabaseUuid(), column.getTableId(), column.getId(), id,
               column.getDataBlockDataAreaSize())
     , m_prevBlockId(column.getPrevBlockId(id))
+    , m_extent(getExtent())
     , m_dataFilePath(makeDataFilePath())
     , m_file(openDataFile())
+    , m_dataLoaded(false)
+    , m_mappedData(nullptr)
     , m_state(ColumnDataBlockState::kCreating)
+    , m_closeSequence(0)
     , m_headerModified(false)
     , m_dataModified(false)
 {
     loadHeader();
+    // Non-zero fill timestamp indicates that block is finalized
+    if (m_header.m_fillTimestamp != 0) mapDataFile();
 }
 
 ColumnDataBlock::~ColumnDataBlock()
 {
     //DBG_LOG_DEBUG("Deactivating ColumnDataBlock " << m_column.getDisplayName());
-    const bool headerModified = m_headerModified;
-    if (m_headerModified) saveHeader();
-    if (m_dataModified || headerModified) m_file->flush();
+    try {
+        writeBack();
+    } catch (std::exception& ex) {
+        LOG_ERROR << "Can't write back ColumnDataBlock " << getDisplayName() << ": " << ex.what();
+    }
 }
 
 std::string ColumnDataBlock::getDisplayName() const
@@ -90,16 +110,92 @@ std::string ColumnDataBlock::getDisplayCode() const
     return oss.str();
 }
 
+void ColumnDataBlock::loadData(const std::vector<ColumnDataBlockPtr>& blocks)
+{
+    struct LoadingBlock {
+        ColumnDataBlock* m_block;
+        std::size_t m_index;
+        std::vector<std::uint8_t> m_encodedData;
+    };
+
+    // Blocks are locked in the order of block IDs, so this can't deadlock
+    std::vector<std::unique_lock<std::mutex>> locks;
+    std::vector<LoadingBlock> loadingBlocks;
+    io::FileIoBatch batch;
+    for (const auto& block : blocks) {
+        if (block->isDataMapped() || block->m_dataLoaded.load(std::memory_order_acquire))
+            continue;
+        std::unique_lock lock(block->m_dataLoadMutex);
+        if (block->m_dataLoaded.load(std::memory_order_relaxed)) continue;
+        const std::size_t dataLength = block->m_header.m_nextDataOffset;
+        block->reserveCachedData(dataLength);
+        block->m_data.resize(dataLength);
+        LoadingBlock loadingBlock {block.get(), batch.size(), {}};
+        auto buffer = block->m_data.data();
+        auto length = dataLength;
+        if (block->isDataEncoded()) {
+            // Encoded data is read into temporary buffer and decoded after reading
+            loadingBlock.m_encodedData.resize(block->m_header.m_encodedDataSize);
+            buffer = loadingBlock.m_encodedData.data();
+            length = loadingBlock.m_encodedData.size();
+        }
+        if (length > 0)
+            batch.addRead(*block->m_file, buffer, length,
+                    block->m_extent.m_offset + block->m_header.m_dataAreaOffset);
+        loadingBlocks.push_back(std::move(loadingBlock));
+        locks.push_back(std::move(lock));
+    }
+
+    batch.execute();
+
+    for (const auto& [block, index, encodedData] : loadingBlocks) {
+        const auto length = block->isDataEncoded() ? encodedData.size() : block->m_data.size();
+        if (length > 0 && batch.getResult(index) != length) {
+            block->m_data.clear();
+            continue;
+        }
+        // Corrupted block is reported when it is loaded individually
+        if (block->m_header.hasDataChecksum()
+                && computeDataChecksum(block->isDataEncoded() ? encodedData.data()
+                                                              : block->m_data.data(),
+                           length) != block->m_header.m_dataChecksum) {
+            block->m_data.clear();
+            continue;
+        }
+        if (block->isDataEncoded() && !block->decodeData(encodedData, block->m_data)) {
+            block->m_data.clear();
+            continue;
+        }
+        block->m_dataLoaded.store(true, std::memory_order_release);
+    }
+}
+
+std::string ColumnDataBlock::makeDataFilePath(const Column& column, std::uint64_t blockId)
+{
+    return utils::constructPath(column.getDataDir(), kBlockFilePrefix, blockId, kDataFileExtension);
+}
+
+const std::uint8_t* ColumnDataBlock::getMappedData(std::uint32_t pos, std::size_t length) const
+{
+    checkDataRange(pos, length);
+    const auto mappedData = m_mappedData.load(std::memory_order_acquire);
+    return mappedData ? mappedData + pos : nullptr;
+}
+
 void ColumnDataBlock::readData(void* data, std::size_t length, std::uint32_t pos) const
 {
-    if (pos + length > m_column.getDataBlockDataAreaSize()) {
-        std::ostringstream err;
-        throw std::runtime_error(utils::StringBuilder()
-                                 << getDisplayName() << ": Invalid offset or length: " << pos
-                                 << ", " << length);
+    if (const auto mappedData = getMappedData(pos, length)) {
+        std::memcpy(data, mappedData, length);
+        return;
+    }
+    ensureDataLoaded();
+    if (pos + length <= m_data.size()) {
+        std::memcpy(data, m_data.data() + pos, length);
+        return;
     }
     const auto readOffset = pos + m_header.m_dataAreaOffset;
-    if (m_file->read(static_cast<std::uint8_t*>(data), length, readOffset) != length) {
+    if (m_file->read(static_cast<std::uint8_t*>(data), length, m_extent.m_offset + readOffset)
+            != length) {
         throwDatabaseError(IOManagerMessageId::kErrorCannotReadColumnDataBlockFile,
                 m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(), getId(),
                 m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(), readOffset,
@@ -109,36 +205,173 @@ void ColumnDataBlock::readData(void* data, std::size_t length, std::uint32_t pos
 
 void ColumnDataBlock::writeData(const void* data, std::size_t length, std::uint32_t pos)
 {
-    if (pos + length > m_column.getDataBlockDataAreaSize()) {
-        std::ostringstream err;
-        throw std::runtime_error(utils::StringBuilder()
-                                 << getDisplayName() << ": Invalid offset or length: " << pos
-                                 << ", " << length);
-    }
+    checkDataRange(pos, length);
     const auto writeOffset = pos + m_header.m_dataAreaOffset;
-    if (m_file->write(static_cast<const std::uint8_t*>(data), length, writeOffset) != length) {
+    if (m_file->write(
+                static_cast<const std::uint8_t*>(data), length, m_extent.m_offset + writeOffset)
+            != length) {
         throwDatabaseError(IOManagerMessageId::kErrorCannotWriteColumnDataBlockFile,
                 m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(), getId(),
                 m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(), writeOffset,
                 length, m_file->getLastError(), std::strerror(m_file->getLastError()));
     }
+    updateCachedData(data, length, pos);
     m_dataModified = true;
 }
 
-void ColumnDataBlock::finalize(const ColumnDataBlockHeader::Digest& prevBlockDigest)
+std::uint64_t ColumnDataBlock::close()
 {
     m_state = ColumnDataBlockState::kClosing;
     m_column.updateBlockState(getId(), m_state);
-    m_header.m_fillTimestamp = std::time(nullptr);
-    computeDigest(prevBlockDigest, m_header.m_digest);
+    std::lock_guard lock(m_finalizationMutex);
+    return ++m_closeSequence;
+}
+
+std::optional<ColumnDataBlock::PreparedFinalization> ColumnDataBlock::prepareFinalization(
+        const ColumnDataBlockHeader::Digest& prevBlockDigest, std::uint64_t closeSequence) const
+{
+    std::lock_guard lock(m_finalizationMutex);
+    if (closeSequence != m_closeSequence) return std::nullopt;
+
+    PreparedFinalization finalization;
+    finalization.m_closeSequence = closeSequence;
+    finalization.m_fillTimestamp = std::time(nullptr);
+    std::vector<std::uint8_t> buffer;
+    const auto data = getPlainData(buffer);
+    computeDigest(prevBlockDigest, finalization.m_fillTimestamp, data, finalization.m_digest);
+    finalization.m_plainDataChecksum = computeDataChecksum(data, m_header.m_nextDataOffset);
+    try {
+        finalization.m_encoding = encodeData(finalization.m_encodedData);
+    } catch (std::exception& ex) {
+        // Not critical, data stays in the plain form
+        LOG_WARNING << "Can't encode data of the column data block " << getDisplayName() << ": "
+                    << ex.what();
+        finalization.m_encoding = ColumnDataEncoding::kPlain;
+    }
+    finalization.m_encodedDataChecksum = computeDataChecksum(
+            finalization.m_encodedData.data(), finalization.m_encodedData.size());
+    return finalization;
+}
+
+bool ColumnDataBlock::finalize(const PreparedFinalization& finalization)
+{
+    if (finalization.m_closeSequence != m_closeSequence) return false;
+    // Header is always saved in the current format, so it can keep data checksum
+    m_header.m_version = ColumnDataBlockHeader::kCurrentVersion;
+    m_header.m_fillTimestamp = finalization.m_fillTimestamp;
+    m_header.m_digest = finalization.m_digest;
+    m_header.m_dataChecksum = finalization.m_plainDataChecksum;
     m_headerModified = true;
     saveHeader();
     m_state = ColumnDataBlockState::kClosed;
     m_column.updateBlockState(getId(), m_state);
+    if (finalization.m_encoding != ColumnDataEncoding::kPlain) {
+        try {
+            storeEncodedData(finalization.m_encoding, finalization.m_encodedData,
+                    finalization.m_encodedDataChecksum);
+        } catch (std::exception& ex) {
+            // Not critical, data stays in the plain form
+            LOG_WARNING << "Can't encode data of the column data block " << getDisplayName()
+                        << ": " << ex.what();
+        }
+    }
+    mapDataFile();
+    return true;
+}
+
+void ColumnDataBlock::resetFillTimestamp()
+{
+    {
+        // Finalization data prepared for the closing block becomes obsolete
+        std::lock_guard lock(m_finalizationMutex);
+        ++m_closeSequence;
+    }
+    if (isDataEncoded()) {
+        // Block is going to be written again, so data must be restored in the plain form
+        ensureDataLoaded();
+        const auto encoding = m_header.m_encoding;
+        const auto encodedDataSize = m_header.m_encodedDataSize;
+        m_header.m_encoding = ColumnDataEncoding::kPlain;
+        m_header.m_encodedDataSize = 0;
+        m_header.m_fillTimestamp = 0;
+        try {
+            replaceDataFile(m_data.data(), m_data.size(), getDataFileSize());
+        } catch (...) {
+            m_header.m_encoding = encoding;
+            m_header.m_encodedDataSize = encodedDataSize;
+            throw;
+        }
+    }
+    m_header.m_fillTimestamp = 0;
+    m_header.m_dataChecksum = 0;
+}
+
+void ColumnDataBlock::computeDigest(const ColumnDataBlockHeader::Digest& prevBlockDigest,
+        std::time_t fillTimestamp, ColumnDataBlockHeader::Digest& blockDigest) const
+{
+    std::vector<std::uint8_t> buffer;
+    computeDigest(prevBlockDigest, fillTimestamp, getPlainData(buffer), blockDigest);
+}
+
+std::size_t ColumnDataBlock::verifyData(const ColumnDataBlockHeader::Digest& prevBlockDigest) const
+{
+    // Data is read from file, because cached copy may hide corruption of the stored data
+    std::vector<std::uint8_t> storedData(
+            isDataEncoded() ? m_header.m_encodedDataSize : m_header.m_nextDataOffset);
+    if (!storedData.empty()
+            && m_file->read(storedData.data(), storedData.size(),
+                       m_extent.m_offset + m_header.m_dataAreaOffset)
+                       != storedData.size()) {
+        throwDatabaseError(IOManagerMessageId::kErrorCannotReadColumnDataBlockFile,
+                m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(), getId(),
+                m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(),
+                m_header.m_dataAreaOffset, storedData.size(), m_file->getLastError(),
+                std::strerror(m_file->getLastError()));
+    }
+
+    if (m_header.hasDataChecksum()
+            && computeDataChecksum(storedData.data(), storedData.size())
+                       != m_header.m_dataChecksum) {
+        throwDatabaseError(IOManagerMessageId::kErrorColumnDataBlockConsistencyMismatch,
+                m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(), getId(),
+                m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(),
+                "data checksum mismatch");
+    }
+
+    auto plainData = &storedData;
+    std::vector<std::uint8_t> decodedData;
+    if (isDataEncoded()) {
+        decodedData.resize(m_header.m_nextDataOffset);
+        if (!decodeData(storedData, decodedData)) {
+            throwDatabaseError(IOManagerMessageId::kErrorCannotDecodeColumnDataBlock,
+                    m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(),
+                    getId(), m_column.getDatabaseUuid(), m_column.getTableId(),
+                    m_column.getId(), static_cast<int>(m_header.m_encoding));
+        }
+        plainData = &decodedData;
+    }
+
+    ColumnDataBlockHeader::Digest digest;
+    computeDigest(prevBlockDigest, m_header.m_fillTimestamp, plainData->data(), digest);
+    if (digest != m_header.m_digest) {
+        throwDatabaseError(IOManagerMessageId::kErrorColumnDataBlockConsistencyMismatch,
+                m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(), getId(),
+                m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(),
+                "block digest mismatch");
+    }
+    return storedData.size();
+}
+
+// ---- internals ----
+
+std::uint64_t ColumnDataBlock::computeDataChecksum(const void* data, std::size_t length) noexcept
+{
+    return ::XXH64(data, length, kDataChecksumSeed);
 }
 
 void ColumnDataBlock::computeDigest(const ColumnDataBlockHeader::Digest& prevBlockDigest,
-        ColumnDataBlockHeader::Digest& blockDigest) const
+        std::time_t fillTimestamp, const std::uint8_t* data,
+        ColumnDataBlockHeader::Digest& blockDigest) const noexcept
 {
     // Serialize significant data from header
     std::uint8_t headerData[ColumnDataBlockHeader::kSerializedSize];
@@ -149,7 +382,7 @@ void ColumnDataBlock::computeDigest(const ColumnDataBlockHeader::Digest& prevBlo
     p = pbeEncodeUInt32(m_header.m_fullColumnDataBlockId.m_tableId, p);
     p = pbeEncodeUInt32(m_header.m_fullColumnDataBlockId.m_columnId, p);
     p = pbeEncodeUInt64(m_header.m_fullColumnDataBlockId.m_blockId, p);
-    p = pbeEncodeInt64(m_header.m_fillTimestamp, p);
+    p = pbeEncodeInt64(fillTimestamp, p);
     p = pbeEncodeUInt32(dataLength, p);
 
     // Compute digest
@@ -157,42 +390,81 @@ void ColumnDataBlock::computeDigest(const ColumnDataBlockHeader::Digest& prevBlo
     SHA256_Init(&ctx);
     SHA256_Update(&ctx, prevBlockDigest.data(), prevBlockDigest.size());
     SHA256_Update(&ctx, headerData, p - headerData);
-    if (dataLength > 0) {
-        std::vector<std::uint8_t> buffer(dataLength);
-        if (m_file->read(buffer.data(), dataLength, m_header.m_dataAreaOffset) != dataLength) {
-            throwDatabaseError(IOManagerMessageId::kErrorCannotReadColumnDataBlockFile,
-                    m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(),
-                    getId(), m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(),
-                    m_header.m_dataAreaOffset, dataLength, m_file->getLastError(),
-                    std::strerror(m_file->getLastError()));
-        }
-        SHA256_Update(&ctx, buffer.data(), dataLength);
-    }
+    if (dataLength > 0) SHA256_Update(&ctx, data, dataLength);
     SHA256_Final(blockDigest.data(), &ctx);
 }
 
-// ---- internals ----
+const std::uint8_t* ColumnDataBlock::getPlainData(std::vector<std::uint8_t>& buffer) const
+{
+    const std::size_t dataLength = m_header.m_nextDataOffset;
+    if (dataLength == 0) return nullptr;
+    if (const auto mappedData = m_mappedData.load(std::memory_order_acquire)) return mappedData;
+    ensureDataLoaded();
+    if (m_data.size() >= dataLength) return m_data.data();
+    buffer.resize(dataLength);
+    if (m_file->read(buffer.data(), dataLength, m_extent.m_offset + m_header.m_dataAreaOffset)
+            != dataLength) {
+        throwDatabaseError(IOManagerMessageId::kErrorCannotReadColumnDataBlockFile,
+                m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(), getId(),
+                m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(),
+                m_header.m_dataAreaOffset, dataLength, m_file->getLastError(),
+                std::strerror(m_file->getLastError()));
+    }
+    return buffer.data();
+}
+
+ColumnDataExtent ColumnDataBlock::allocateExtent() const
+{
+    const auto segmentStore = m_column.getSegmentStore();
+    return segmentStore ? segmentStore->allocateExtent(getDataFileSize()) : ColumnDataExtent();
+}
 
-io::FilePtr ColumnDataBlock::createDataFile() const
+ColumnDataExtent ColumnDataBlock::getExtent() const
+{
+    const auto segmentStore = m_column.getSegmentStore();
+    return segmentStore ? segmentStore->getExtent(getId()) : ColumnDataExtent();
+}
+
+io::FileSharedPtr ColumnDataBlock::createDataFile() const
 {
     LOG_DEBUG << "Creating ColumnDataBlock " << m_column.getDatabaseName() << '.'
               << m_column.getTableName() << '.' << m_column.getName() << '.' << getId();
 
+    if (const auto segmentStore = m_column.getSegmentStore()) {
+        try {
+            auto file = segmentStore->getSegmentFile(m_extent.m_segmentId);
+            if (const auto failedStep = writeDataFile(*file, m_extent.m_offset, nullptr, 0)) {
+                throwDatabaseError(IOManagerMessageId::kErrorCannotCreateNewColumnDataBlockFile,
+                        m_dataFilePath, m_column.getDatabaseName(), m_column.getTableName(),
+                        m_column.getName(), getId(), m_column.getDatabaseUuid(),
+                        m_column.getTableId(), m_column.getId(), failedStep,
+                        file->getLastError(), std::strerror(file->getLastError()));
+            }
+            segmentStore->recordExtent(getId(), m_extent);
+            return file;
+        } catch (...) {
+            segmentStore->releaseExtent(m_extent);
+            throw;
+        }
+    }
+
     std::string tmpFilePath;
 
     // Create data file as temporary file
-    constexpr int kBaseExtraOpenFlags = O_DSYNC;
+    const auto wal = m_column.getWriteAheadLog();
+    const int baseExtraOpenFlags =
+            (wal ? 0 : O_DSYNC) | m_column.getDatabase().getInstance().getDirectIoOpenFlags();
     io::FilePtr file;
     try {
         try {
             file = m_column.getDatabase().createFile(m_column.getDataDir(),
-                    kBaseExtraOpenFlags | O_TMPFILE, kDataFileCreationMode, getDataFileSize());
+                    baseExtraOpenFlags | O_TMPFILE, kDataFileCreationMode, getDataFileSize());
         } catch (std::system_error& ex) {
             if (ex.code().value() != ENOTSUP) throw;
             // O_TMPFILE not supported, fallback to named temporary file
             tmpFilePath = m_dataFilePath + kTempFileExtension;
             file = m_column.getDatabase().createFile(
-                    tmpFilePath, kBaseExtraOpenFlags, kDataFileCreationMode, getDataFileSize());
+                    tmpFilePath, baseExtraOpenFlags, kDataFileCreationMode, getDataFileSize());
         }
     } catch (std::system_error& ex) {
         throwDatabaseError(IOManagerMessageId::kErrorCannotCreateNewColumnDataBlockFile,
@@ -202,26 +474,15 @@ io::FilePtr ColumnDataBlock::createDataFile() const
                 std::strerror(ex.code().value()));
     }
 
-    // Prepare and write header
-    const auto remainingHeaderSize =
-            m_dataFileHeaderProto.size() - ColumnDataBlockHeader::kSerializedSize;
-    std::uint8_t buffer[ColumnDataBlockHeader::kSerializedSize];
-    m_header.serialize(buffer);
-    if (file->write(buffer, sizeof(buffer), 0) != sizeof(buffer)) {
-        throwDatabaseError(IOManagerMessageId::kErrorCannotCreateNewColumnDataBlockFile,
-                m_dataFilePath, m_column.getDatabaseName(), m_column.getTableName(),
-                m_column.getName(), getId(), m_column.getDatabaseUuid(), m_column.getTableId(),
-                m_column.getId(), "Can't write header part 1", file->getLastError(),
-                std::strerror(file->getLastError()));
-    }
+    // Header is logged under the final path, so it is replayed only if file gets linked
+    if (wal) file->enableWriteAheadLog(wal, m_dataFilePath);
 
-    // Write rest of header
-    if (file->write(m_dataFileHeaderProto.data(), remainingHeaderSize, sizeof(buffer))
-            != remainingHeaderSize) {
+    // Write header
+    if (const auto failedStep = writeDataFile(*file, 0, nullptr, 0)) {
         throwDatabaseError(IOManagerMessageId::kErrorCannotCreateNewColumnDataBlockFile,
                 m_dataFilePath, m_column.getDatabaseName(), m_column.getTableName(),
                 m_column.getName(), getId(), m_column.getDatabaseUuid(), m_column.getTableId(),
-                m_column.getId(), "Can't write header part 2", file->getLastError(),
+                m_column.getId(), failedStep, file->getLastError(),
                 std::strerror(file->getLastError()));
     }
 
@@ -252,30 +513,54 @@ io::FilePtr ColumnDataBlock::createDataFile() const
     return file;
 }
 
-io::FilePtr ColumnDataBlock::openDataFile() const
+io::FileSharedPtr ColumnDataBlock::openDataFile() const
 {
+    if (const auto segmentStore = m_column.getSegmentStore())
+        return segmentStore->getSegmentFile(m_extent.m_segmentId);
+
+    const auto wal = m_column.getWriteAheadLog();
+    const int extraOpenFlags =
+            (wal ? 0 : O_DSYNC) | m_column.getDatabase().getInstance().getDirectIoOpenFlags();
     io::FilePtr file;
     try {
-        file = m_column.getDatabase().openFile(m_dataFilePath, O_DSYNC);
+        file = m_column.getDatabase().openFile(m_dataFilePath, extraOpenFlags);
     } catch (std::system_error& ex) {
         throwDatabaseError(IOManagerMessageId::kErrorCannotOpenColumnDataBlockFile, m_dataFilePath,
                 m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(), getId(),
                 m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId());
     }
+    if (wal) file->enableWriteAheadLog(wal, m_dataFilePath);
     return file;
 }
 
+const char* ColumnDataBlock::writeDataFile(io::File& file, off_t offset, const std::uint8_t* data,
+        std::size_t length) const noexcept
+{
+    std::uint8_t buffer[ColumnDataBlockHeader::kSerializedSize];
+    m_header.serialize(buffer);
+    const auto remainingHeaderSize = m_header.m_dataAreaOffset - sizeof(buffer);
+    if (file.write(buffer, sizeof(buffer), offset) != sizeof(buffer))
+        return "Can't write header part 1";
+    if (file.write(m_dataFileHeaderProto.data(), remainingHeaderSize, offset + sizeof(buffer))
+            != remainingHeaderSize)
+        return "Can't write header part 2";
+    if (length > 0 && file.write(data, length, offset + m_header.m_dataAreaOffset) != length)
+        return "Can't write data";
+    return nullptr;
+}
+
 std::string ColumnDataBlock::makeDataFilePath() const
 {
-    return utils::constructPath(
-            m_column.getDataDir(), kBlockFilePrefix, getId(), kDataFileExtension);
+    const auto segmentStore = m_column.getSegmentStore();
+    return segmentStore ? segmentStore->makeSegmentFilePath(m_extent.m_segmentId)
+                        : makeDataFilePath(m_column, getId());
 }
 
 void ColumnDataBlock::loadHeader()
 {
     // Read header
     std::uint8_t buffer[ColumnDataBlockHeader::kSerializedSize];
-    auto readBytes = m_file->read(buffer, sizeof(buffer), 0);
+    auto readBytes = m_file->read(buffer, sizeof(buffer), m_extent.m_offset);
     if (readBytes == 0) {
         throwDatabaseError(IOManagerMessageId::kErrorCannotReadColumnDataBlockFile,
                 m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(), getId(),
@@ -288,10 +573,10 @@ void ColumnDataBlock::loadHeader()
     }
 
     ColumnDataBlockHeader header;
-    header.deserialize(buffer);
+    const bool headerDecoded = header.deserialize(buffer) != nullptr;
 
     // Validate header
-    if (header.m_version > ColumnDataBlockHeader::kCurrentVersion
+    if (!headerDecoded || header.m_version > ColumnDataBlockHeader::kCurrentVersion
             || header.m_fullColumnDataBlockId != m_header.m_fullColumnDataBlockId) {
         throwDatabaseError(IOManagerMessageId::kErrorInvalidDataFileHeader,
                 m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(), getId(),
@@ -306,7 +591,7 @@ void ColumnDataBlock::saveHeader() const
 {
     uint8_t header[ColumnDataBlockHeader::kSerializedSize];
     m_header.serialize(header);
-    if (m_file->write(header, sizeof(header), 0) != sizeof(header)) {
+    if (m_file->write(header, sizeof(header), m_extent.m_offset) != sizeof(header)) {
         throwDatabaseError(IOManagerMessageId::kErrorCannotWriteColumnDataBlockFile,
                 m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(), getId(),
                 m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(), 0,
@@ -315,4 +600,328 @@ void ColumnDataBlock::saveHeader() const
     m_headerModified = false;
 }
 
+void ColumnDataBlock::writeBack()
+{
+    const bool modified = isModified();
+    if (m_headerModified) saveHeader();
+    // Logged writes are made durable by the write-ahead log
+    if (modified && !m_file->isWriteAheadLogged() && !m_file->flush()) {
+        throwDatabaseError(IOManagerMessageId::kErrorCannotWriteColumnDataBlockFile,
+                m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(), getId(),
+                m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(),
+                m_extent.m_offset, getDataFileSize(), m_file->getLastError(),
+                std::strerror(m_file->getLastError()));
+    }
+    m_dataModified = false;
+}
+
+unsigned ColumnDataBlock::getEncodableValueSize(bool& isSigned) const noexcept
+{
+    // Master column stores variable length master column records
+    if (m_column.isMasterColumn()) return 0;
+    isSigned = false;
+    switch (m_column.getDataType()) {
+        case COLUMN_DATA_TYPE_BOOL:
+        case COLUMN_DATA_TYPE_UINT8: return 1;
+        case COLUMN_DATA_TYPE_UINT16: return 2;
+        case COLUMN_DATA_TYPE_UINT32: return 4;
+        case COLUMN_DATA_TYPE_UINT64: return 8;
+        default: break;
+    }
+    isSigned = true;
+    switch (m_column.getDataType()) {
+        case COLUMN_DATA_TYPE_INT8: return 1;
+        case COLUMN_DATA_TYPE_INT16: return 2;
+        case COLUMN_DATA_TYPE_INT32: return 4;
+        case COLUMN_DATA_TYPE_INT64: return 8;
+        default: return 0;
+    }
+}
+
+CompressionType ColumnDataBlock::getCompressionType() const noexcept
+{
+    if (m_column.isMasterColumn()) return CompressionType::kNone;
+    switch (m_column.getDataType()) {
+        case COLUMN_DATA_TYPE_TEXT:
+        case COLUMN_DATA_TYPE_BINARY: return m_column.getTable().getCompressionType();
+        default: return CompressionType::kNone;
+    }
+}
+
+ColumnDataEncoding ColumnDataBlock::encodeData(std::vector<std::uint8_t>& encodedData) const
+{
+    bool isSigned = false;
+    const auto valueSize = getEncodableValueSize(isSigned);
+    const auto compressionType = getCompressionType();
+    const std::size_t dataLength = m_header.m_nextDataOffset;
+    if (dataLength == 0) return ColumnDataEncoding::kPlain;
+    if (valueSize == 0 ? compressionType == CompressionType::kNone : dataLength % valueSize != 0)
+        return ColumnDataEncoding::kPlain;
+
+    ensureDataLoaded();
+    if (m_data.size() < dataLength) return ColumnDataEncoding::kPlain;
+
+    // Integer data is encoded with lightweight encodings, variable length data is compressed
+    ColumnDataEncoding encoding;
+    if (valueSize > 0) {
+        encoding = encodeIntegerColumnData(
+                m_data.data(), dataLength / valueSize, valueSize, isSigned, encodedData);
+    } else
+        encoding = compressColumnData(compressionType, m_data.data(), dataLength, encodedData);
+    if (encoding == ColumnDataEncoding::kPlain
+            || encodedData.size() > dataLength / 100 * kMaxEncodedDataSizePercent) {
+        encodedData.clear();
+        return ColumnDataEncoding::kPlain;
+    }
+    return encoding;
+}
+
+void ColumnDataBlock::storeEncodedData(ColumnDataEncoding encoding,
+        const std::vector<std::uint8_t>& encodedData, std::uint64_t encodedDataChecksum)
+{
+    const auto plainDataChecksum = m_header.m_dataChecksum;
+    m_header.m_encoding = encoding;
+    m_header.m_encodedDataSize = encodedData.size();
+    m_header.m_dataChecksum = encodedDataChecksum;
+    try {
+        replaceDataFile(encodedData.data(), encodedData.size(),
+                m_header.m_dataAreaOffset + encodedData.size());
+    } catch (...) {
+        m_header.m_encoding = ColumnDataEncoding::kPlain;
+        m_header.m_encodedDataSize = 0;
+        m_header.m_dataChecksum = plainDataChecksum;
+        throw;
+    }
+
+    LOG_DEBUG << "Column data block " << getDisplayName() << ": data encoded with encoding #"
+              << static_cast<int>(encoding) << ", " << m_header.m_nextDataOffset << " -> "
+              << encodedData.size() << " bytes";
+}
+
+bool ColumnDataBlock::decodeData(
+        const std::vector<std::uint8_t>& encodedData, std::vector<std::uint8_t>& data) const
+{
+    if (isCompressedColumnDataEncoding(m_header.m_encoding)) {
+        return decompressColumnData(m_header.m_encoding, encodedData.data(), encodedData.size(),
+                data.data(), data.size());
+    }
+
+    bool isSigned = false;
+    const auto valueSize = getEncodableValueSize(isSigned);
+    return valueSize > 0 && data.size() % valueSize == 0
+           && decodeIntegerColumnData(m_header.m_encoding, encodedData.data(),
+                   encodedData.size(), data.size() / valueSize, valueSize, isSigned,
+                   data.data());
+}
+
+void ColumnDataBlock::replaceDataFile(
+        const std::uint8_t* data, std::size_t length, std::size_t fileSize)
+{
+    if (const auto segmentStore = m_column.getSegmentStore()) {
+        // Block is moved to the new extent, old extent is released when new one is recorded
+        const auto extent = segmentStore->allocateExtent(fileSize);
+        io::FileSharedPtr file;
+        try {
+            file = segmentStore->getSegmentFile(extent.m_segmentId);
+            if (const auto failedStep = writeDataFile(*file, extent.m_offset, data, length)) {
+                throwDatabaseError(IOManagerMessageId::kErrorCannotCreateNewColumnDataBlockFile,
+                        m_dataFilePath, m_column.getDatabaseName(), m_column.getTableName(),
+                        m_column.getName(), getId(), m_column.getDatabaseUuid(),
+                        m_column.getTableId(), m_column.getId(), failedStep,
+                        file->getLastError(), std::strerror(file->getLastError()));
+            }
+            segmentStore->recordExtent(getId(), extent);
+        } catch (...) {
+            segmentStore->releaseExtent(extent);
+            throw;
+        }
+        m_mappedData.store(nullptr, std::memory_order_release);
+        m_mappedFile.reset();
+        m_extent = extent;
+        m_dataFilePath = segmentStore->makeSegmentFilePath(extent.m_segmentId);
+        m_file = std::move(file);
+        m_headerModified = false;
+        return;
+    }
+
+    const auto tmpFilePath = m_dataFilePath + kTempFileExtension;
+    const auto wal = m_column.getWriteAheadLog();
+    const int extraOpenFlags =
+            (wal ? 0 : O_DSYNC) | m_column.getDatabase().getInstance().getDirectIoOpenFlags();
+    io::FilePtr file;
+    try {
+        file = m_column.getDatabase().createFile(
+                tmpFilePath, extraOpenFlags | O_TRUNC, kDataFileCreationMode, fileSize);
+    } catch (std::system_error& ex) {
+        throwDatabaseError(IOManagerMessageId::kErrorCannotCreateNewColumnDataBlockFile,
+                m_dataFilePath, m_column.getDatabaseName(), m_column.getTableName(),
+                m_column.getName(), getId(), m_column.getDatabaseUuid(), m_column.getTableId(),
+                m_column.getId(), "Can't create replacement file", ex.code().value(),
+                std::strerror(ex.code().value()));
+    }
+
+    try {
+        // Write header, rest of header and data
+        if (const auto failedStep = writeDataFile(*file, 0, data, length)) {
+            throwDatabaseError(IOManagerMessageId::kErrorCannotCreateNewColumnDataBlockFile,
+                    m_dataFilePath, m_column.getDatabaseName(), m_column.getTableName(),
+                    m_column.getName(), getId(), m_column.getDatabaseUuid(),
+                    m_column.getTableId(), m_column.getId(), failedStep, file->getLastError(),
+                    std::strerror(file->getLastError()));
+        }
+
+        if (wal) {
+            // Replacement file must be durable before it is renamed. Old file must be durable
+            // before its log records are discarded, because rename may be lost in a crash.
+            if (!file->flush()) {
+                throwDatabaseError(IOManagerMessageId::kErrorCannotCreateNewColumnDataBlockFile,
+                        m_dataFilePath, m_column.getDatabaseName(), m_column.getTableName(),
+                        m_column.getName(), getId(), m_column.getDatabaseUuid(),
+                        m_column.getTableId(), m_column.getId(), "Can't flush replacement file",
+                        file->getLastError(), std::strerror(file->getLastError()));
+            }
+            if (!m_file->flush()) {
+                throwDatabaseError(IOManagerMessageId::kErrorCannotCreateNewColumnDataBlockFile,
+                        m_dataFilePath, m_column.getDatabaseName(), m_column.getTableName(),
+                        m_column.getName(), getId(), m_column.getDatabaseUuid(),
+                        m_column.getTableId(), m_column.getId(), "Can't flush old file",
+                        m_file->getLastError(), std::strerror(m_file->getLastError()));
+            }
+            wal->logDiscard(m_dataFilePath);
+            m_column.commitWriteAheadLog();
+        }
+
+        // Rename replacement file to the regular one, this atomically replaces old file
+        if (::rename(tmpFilePath.c_str(), m_dataFilePath.c_str()) < 0) {
+            const int errorCode = errno;
+            throwDatabaseError(IOManagerMessageId::kErrorCannotCreateNewColumnDataBlockFile,
+                    m_dataFilePath, m_column.getDatabaseName(), m_column.getTableName(),
+                    m_column.getName(), getId(), m_column.getDatabaseUuid(),
+                    m_column.getTableId(), m_column.getId(),
+                    "Can't rename replacement file to the regular one", errorCode,
+                    std::strerror(errorCode));
+        }
+    } catch (...) {
+        ::unlink(tmpFilePath.c_str());
+        throw;
+    }
+
+    if (wal) file->enableWriteAheadLog(wal, m_dataFilePath);
+    m_mappedData.store(nullptr, std::memory_order_release);
+    m_mappedFile.reset();
+    m_file = std::move(file);
+    m_headerModified = false;
+}
+
+void ColumnDataBlock::mapDataFile()
+{
+    // Encoded data can't be accessed directly
+    if (m_mappedFile || isDataEncoded() || !m_file->isMappable()) return;
+
+    // Data file must be long enough, otherwise access to the mapping could cause SIGBUS
+    const auto fileSize = m_file->getFileSize();
+    if (fileSize < 0
+            || static_cast<std::uint64_t>(fileSize) < m_extent.m_offset + getDataFileSize())
+        return;
+
+    // Mapping offset must be aligned to the page size
+    if (m_extent.m_offset % ::sysconf(_SC_PAGESIZE) != 0) return;
+
+    try {
+        m_mappedFile = std::make_unique<siodb::io::MemoryMappedFile>(
+                m_file->getFd(), false, PROT_READ, 0, m_extent.m_offset, getDataFileSize());
+    } catch (std::system_error& ex) {
+        // Not critical, data will be read from file
+        LOG_WARNING << "Can't map data file of the column data block " << getDisplayName()
+                    << ": " << ex.what();
+        return;
+    }
+
+    m_mappedData.store(static_cast<const std::uint8_t*>(m_mappedFile->getMappingAddress())
+                               + m_header.m_dataAreaOffset,
+            std::memory_order_release);
+
+    // In-memory copy of data is not needed anymore
+    if (m_data.capacity() > 0) {
+        std::vector<std::uint8_t>().swap(m_data);
+        m_dataLoaded = false;
+        m_column.getDatabase().getInstance().getBlockPool().updateMemoryUsage(*this);
+    }
+}
+
+void ColumnDataBlock::checkDataRange(std::uint32_t pos, std::size_t length) const
+{
+    if (pos + length > m_column.getDataBlockDataAreaSize()) {
+        throw std::runtime_error(utils::StringBuilder()
+                                 << getDisplayName() << ": Invalid offset or length: " << pos
+                                 << ", " << length);
+    }
+}
+
+void ColumnDataBlock::ensureDataLoaded() const
+{
+    if (m_dataLoaded.load(std::memory_order_acquire)) return;
+    std::lock_guard lock(m_dataLoadMutex);
+    if (m_dataLoaded.load(std::memory_order_relaxed)) return;
+    const std::size_t dataLength = m_header.m_nextDataOffset;
+    reserveCachedData(dataLength);
+    m_data.resize(dataLength);
+    std::vector<std::uint8_t> encodedData;
+    auto buffer = m_data.data();
+    auto length = dataLength;
+    if (isDataEncoded()) {
+        encodedData.resize(m_header.m_encodedDataSize);
+        buffer = encodedData.data();
+        length = encodedData.size();
+    }
+    if (length > 0
+            && m_file->read(buffer, length, m_extent.m_offset + m_header.m_dataAreaOffset)
+                       != length) {
+        m_data.clear();
+        throwDatabaseError(IOManagerMessageId::kErrorCannotReadColumnDataBlockFile,
+                m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(), getId(),
+                m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(),
+                m_header.m_dataAreaOffset, length, m_file->getLastError(),
+                std::strerror(m_file->getLastError()));
+    }
+    if (m_header.hasDataChecksum()
+            && computeDataChecksum(buffer, length) != m_header.m_dataChecksum) {
+        m_data.clear();
+        throwDatabaseError(IOManagerMessageId::kErrorColumnDataBlockConsistencyMismatch,
+                m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(), getId(),
+                m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(),
+                "data checksum mismatch");
+    }
+    if (isDataEncoded() && !decodeData(encodedData, m_data)) {
+        m_data.clear();
+        throwDatabaseError(IOManagerMessageId::kErrorCannotDecodeColumnDataBlock,
+                m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(), getId(),
+                m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(),
+                static_cast<int>(m_header.m_encoding));
+    }
+    m_dataLoaded.store(true, std::memory_order_release);
+}
+
+void ColumnDataBlock::updateCachedData(const void* data, std::size_t length, std::uint32_t pos)
+{
+    // Data after the gap can't be cached, it will be read from file.
+    // Mapped data reflects file changes by itself.
+    if (!m_dataLoaded || pos > m_data.size() || m_mappedFile) return;
+    const auto end = pos + length;
+    if (end > m_data.size()) {
+        reserveCachedData(end);
+        m_data.resize(end);
+    }
+    std::memcpy(m_data.data() + pos, data, length);
+}
+
+void ColumnDataBlock::reserveCachedData(std::size_t size) const
+{
+    if (size <= m_data.capacity()) return;
+    // Grow geometrically, but never beyond the data area size
+    const std::size_t dataAreaSize = m_column.getDataBlockDataAreaSize();
+    m_data.reserve(std::max(size, std::min(m_data.capacity() * 2, dataAreaSize)));
+    m_column.getDatabase().getInstance().getBlockPool().updateMemoryUsage(*this);
+}
+
 }  // namespace siodb::iomgr::dbengine
@@ -8,12 +8,21 @@
 #include "Column.h"
 #include "ColumnDataBlockHeader.h"
 #include "ColumnDataBlockPtr.h"
+#include "ColumnSegmentStore.h"
 
 // Common project headers
 #include <siodb/common/config/SiodbDefs.h>
+#include <siodb/common/io/MemoryMappedFile.h>
 #include <siodb/common/utils/FileDescriptorGuard.h>
 #include <siodb/common/utils/HelperMacros.h>
 
+// STL headers
+#include <atomic>
+#include <ctime>
+#include <mutex>
+#include <optional>
+#include <vector>
+
 namespace siodb::iomgr::dbengine {
 
 /** Column data block */
@@ -22,6 +31,30 @@ public:
     /** Block file prefix */
     static constexpr const char* kBlockFilePrefix = "b";
 
+    /** Finalization data of the closing block, computed before block is finalized */
+    struct PreparedFinalization {
+        /** Close sequence number of the block at the moment of preparation */
+        std::uint64_t m_closeSequence;
+
+        /** Fill timestamp */
+        std::time_t m_fillTimestamp;
+
+        /** Block digest */
+        ColumnDataBlockHeader::Digest m_digest;
+
+        /** Data encoding, plain if data should stay as is */
+        ColumnDataEncoding m_encoding;
+
+        /** Encoded data */
+        std::vector<std::uint8_t> m_encodedData;
+
+        /** Checksum of the plain data */
+        std::uint64_t m_plainDataChecksum;
+
+        /** Checksum of the encoded data */
+        std::uint64_t m_encodedDataChecksum;
+    };
+
 public:
     /**
      * Initializes object of class ColumnDataBlock for a new block.
@@ -43,6 +76,22 @@ public:
 
     DECLARE_NONCOPYABLE(ColumnDataBlock);
 
+    /**
+     * Loads written data of multiple blocks into memory using single I/O batch.
+     * Blocks which are mapped or already loaded are skipped. Blocks which fail
+     * to load are left unloaded, so that error is reported on their first access.
+     * @param blocks Blocks of the same column, ordered by block ID.
+     */
+    static void loadData(const std::vector<ColumnDataBlockPtr>& blocks);
+
+    /**
+     * Constructs data file path of the given block.
+     * @param column Column to which block belongs.
+     * @param blockId Block ID.
+     * @return Data file path.
+     */
+    static std::string makeDataFilePath(const Column& column, std::uint64_t blockId);
+
     /**
      * Returns column object.
      * @return Column object.
@@ -98,7 +147,7 @@ public:
     }
 
     /**
-     * Returns data file path.
+     * Returns data file path. This is segment file path if block is stored in the segment file.
      * @return data file path.
      */
     const auto& getDataFilePath() const noexcept
@@ -154,6 +203,10 @@ public:
         m_header.m_nextDataOffset = nextDataPos;
     }
 
+    /**
+     * Returns data file size.
+     * @return Data file size.
+     */
     std::uint32_t getDataFileSize() const noexcept
     {
         return m_column.getDataBlockDataAreaSize() + ColumnDataBlockHeader::kDefaultDataAreaOffset;
@@ -170,15 +223,76 @@ public:
         return m_header.m_nextDataOffset;
     }
 
-    /** Resets fill timestemp to zero */
-    void resetFillTimestamp() noexcept
+    /**
+     * Returns amount of memory used by this block, including cached data.
+     * @return Memory usage in bytes.
+     */
+    std::size_t getMemoryUsage() const noexcept
+    {
+        return sizeof(*this) + m_data.capacity();
+    }
+
+    /**
+     * Returns indication that block is finalized.
+     * @return true if block is finalized, false otherwise.
+     */
+    bool isFinalized() const noexcept
+    {
+        return m_header.m_fillTimestamp != 0;
+    }
+
+    /**
+     * Returns summary of values stored in the block.
+     * @return Value summary.
+     */
+    const ColumnDataBlockZoneMap& getZoneMap() const noexcept
+    {
+        return m_header.m_zoneMap;
+    }
+
+    /**
+     * Accounts non-NULL value written into the block in the value summary.
+     * @param key Value key.
+     * @param trid Table row ID of the value.
+     */
+    void addZoneMapValue(std::uint64_t key, std::uint64_t trid) noexcept
+    {
+        m_header.m_zoneMap.addValue(key, trid);
+        m_headerModified = true;
+    }
+
+    /** Accounts NULL value in the value summary. */
+    void addZoneMapNull() noexcept
+    {
+        m_header.m_zoneMap.addNull();
+        m_headerModified = true;
+    }
+
+    /**
+     * Resets fill timestemp to zero, so that block can be written again.
+     * Encoded data is restored in the plain form up to the next data position.
+     */
+    void resetFillTimestamp();
+
+    /**
+     * Returns indication that block data is stored encoded.
+     * @return true if block data is encoded, false otherwise.
+     */
+    bool isDataEncoded() const noexcept
     {
-        m_header.m_fillTimestamp = 0;
+        return m_header.m_encoding != ColumnDataEncoding::kPlain;
     }
 
     /** Saves header */
     void saveHeader() const;
 
+    /**
+     * Saves modified header and flushes modified data to disk.
+     * Called before block is released, so that destructor has nothing to write.
+     * @throw DatabaseError if header can't be written or file can't be flushed.
+     */
+    void writeBack();
+
     /**
      * Reads data from the data file at a given position.
      * @param[out] data A data.
@@ -187,6 +301,25 @@ public:
      */
     void readData(void* data, std::size_t length, std::uint32_t pos) const;
 
+    /**
+     * Returns indication that block data file is mapped into memory.
+     * @return true if block data file is mapped into memory, false otherwise.
+     */
+    bool isDataMapped() const noexcept
+    {
+        return m_mappedData.load(std::memory_order_acquire) != nullptr;
+    }
+
+    /**
+     * Returns pointer to the data at a given position, if block data file is mapped into memory.
+     * Only closed blocks are mapped. Their data never changes, so it can be read
+     * without holding column lock for as long as block object is held.
+     * @param pos Data position.
+     * @param length Data length.
+     * @return Pointer to the data or nullptr if block data file is not mapped.
+     */
+    const std::uint8_t* getMappedData(std::uint32_t pos, std::size_t length) const;
+
     /**
      * Writes data to the data file at a given position.
      * @param data A data.
@@ -225,10 +358,31 @@ public:
     }
 
     /**
-     * Finalizes block - put fill timestamp and adds data digest.
+     * Marks filled block as closing. Block must be finalized afterwards.
+     * @return Close sequence number, which identifies this closing of the block.
+     */
+    std::uint64_t close();
+
+    /**
+     * Computes fill timestamp, digest and encoded data of the closing block.
+     * Doesn't require column data lock, because data of the closing block
+     * is not modified until block is reopened, and reopening waits until
+     * preparation completes.
      * @param prevBlockDigest Digest of a previous block.
+     * @param closeSequence Close sequence number returned by close().
+     * @return Finalization data or nothing if block has been reopened since closing.
+     */
+    std::optional<PreparedFinalization> prepareFinalization(
+            const ColumnDataBlockHeader::Digest& prevBlockDigest,
+            std::uint64_t closeSequence) const;
+
+    /**
+     * Finalizes block - puts fill timestamp and data digest, replaces data file
+     * with encoded data if that was prepared. Column data must be locked for writing.
+     * @param finalization Finalization data.
+     * @return true if block is finalized, false if it has been reopened since preparation.
      */
-    void finalize(const ColumnDataBlockHeader::Digest& prevBlockDigest);
+    bool finalize(const PreparedFinalization& finalization);
 
     /**
      * Computes block digest. Assumes block has data.
@@ -236,25 +390,95 @@ public:
      * @param[out] blockDigest Computed current block digest.
      */
     void computeDigest(const ColumnDataBlockHeader::Digest& prevBlockDigest,
-            ColumnDataBlockHeader::Digest& blockDigest) const;
+            ColumnDataBlockHeader::Digest& blockDigest) const
+    {
+        computeDigest(prevBlockDigest, m_header.m_fillTimestamp, blockDigest);
+    }
+
+    /**
+     * Verifies data stored in the file of the closed block: checks data checksum,
+     * if header has one, and block digest. Cached data is not used.
+     * @param prevBlockDigest Digest of a previous block.
+     * @return Number of bytes read from the file.
+     * @throw DatabaseError if data is corrupted or can't be read.
+     */
+    std::size_t verifyData(const ColumnDataBlockHeader::Digest& prevBlockDigest) const;
 
 private:
+    /**
+     * Computes data checksum.
+     * @param data Data buffer.
+     * @param length Data length.
+     * @return Checksum value.
+     */
+    static std::uint64_t computeDataChecksum(const void* data, std::size_t length) noexcept;
+
+    /**
+     * Computes block digest for the given fill timestamp.
+     * @param prevBlockDigest Digest of a previous block.
+     * @param fillTimestamp Fill timestamp.
+     * @param[out] blockDigest Computed current block digest.
+     */
+    void computeDigest(const ColumnDataBlockHeader::Digest& prevBlockDigest,
+            std::time_t fillTimestamp, ColumnDataBlockHeader::Digest& blockDigest) const;
+
+    /**
+     * Computes block digest for the given fill timestamp and plain data.
+     * @param prevBlockDigest Digest of a previous block.
+     * @param fillTimestamp Fill timestamp.
+     * @param data Plain data of the written data length.
+     * @param[out] blockDigest Computed current block digest.
+     */
+    void computeDigest(const ColumnDataBlockHeader::Digest& prevBlockDigest,
+            std::time_t fillTimestamp, const std::uint8_t* data,
+            ColumnDataBlockHeader::Digest& blockDigest) const noexcept;
+
+    /**
+     * Returns plain data of the written data length from the mapped data,
+     * in-memory copy or, as a last resort, reads it from file into the given buffer.
+     * @param buffer Buffer for data read from file.
+     * @return Pointer to the data or nullptr if block has no data.
+     */
+    const std::uint8_t* getPlainData(std::vector<std::uint8_t>& buffer) const;
+
+    /**
+     * Allocates extent for a new block, if column stores blocks in the segment files.
+     * @return Block extent or invalid extent if block has own data file.
+     */
+    ColumnDataExtent allocateExtent() const;
+
+    /**
+     * Returns extent of an existing block, if column stores blocks in the segment files.
+     * @return Block extent or invalid extent if block has own data file.
+     */
+    ColumnDataExtent getExtent() const;
+
     /**
      * Creates new data file for the specified column block.
-     * Fails if the file already exists.
-     * @param columnDataBlock Column block info.
+     * Fails if the file already exists. If column stores blocks in the segment files,
+     * writes header into the allocated extent and records extent instead.
      * @return File object.
      * @throw DatabaseError if operation fails for any reason
      */
-    io::FilePtr createDataFile() const;
+    io::FileSharedPtr createDataFile() const;
 
     /**
      * Opens data file for the specified column block. Fails if the file doesn't exist.
-     * @param columnDataBlock Column block info.
      * @return File object.
      * @throw DatabaseError if operation fails for any reason
      */
-    io::FilePtr openDataFile() const;
+    io::FileSharedPtr openDataFile() const;
+
+    /**
+     * Writes current header followed by the given data into the data file.
+     * @param file Data file.
+     * @param offset Offset of the block in the data file.
+     * @param data Data area contents.
+     * @param length Data length.
+     * @return nullptr on success, otherwise description of the failed step.
+     */
+    const char* writeDataFile(io::File& file, off_t offset, const std::uint8_t* data,
+            std::size_t length) const noexcept;
 
     /**
      * Constructs data file path.
@@ -265,6 +489,90 @@ private:
     /** Loads header */
     void loadHeader();
 
+    /**
+     * Returns size of a single value if data of this block can be encoded.
+     * @param[out] isSigned Indicates that values are signed.
+     * @return Value size or 0 if data of this block can't be encoded.
+     */
+    unsigned getEncodableValueSize(bool& isSigned) const noexcept;
+
+    /**
+     * Returns compression type applicable to data of this block.
+     * Only blocks of variable length data columns are compressed.
+     * @return Compression type.
+     */
+    CompressionType getCompressionType() const noexcept;
+
+    /**
+     * Encodes or compresses data of the closing block, if that makes data
+     * considerably smaller.
+     * @param[out] encodedData Encoded data.
+     * @return Data encoding, plain if data should stay as is.
+     */
+    ColumnDataEncoding encodeData(std::vector<std::uint8_t>& encodedData) const;
+
+    /**
+     * Replaces data file with the new one containing encoded data.
+     * @param encoding Data encoding.
+     * @param encodedData Encoded data.
+     * @param encodedDataChecksum Checksum of the encoded data.
+     */
+    void storeEncodedData(ColumnDataEncoding encoding,
+            const std::vector<std::uint8_t>& encodedData, std::uint64_t encodedDataChecksum);
+
+    /**
+     * Decodes encoded data into the given buffer,
+     * which must be already sized to the written data length.
+     * @param encodedData Encoded data.
+     * @param[out] data Decoded data.
+     * @return true on success, false if encoded data is corrupted.
+     */
+    bool decodeData(const std::vector<std::uint8_t>& encodedData,
+            std::vector<std::uint8_t>& data) const;
+
+    /**
+     * Atomically replaces data file with the new one which contains
+     * current header followed by the given data. If column stores blocks
+     * in the segment files, block is moved to the new extent instead.
+     * @param data Data area contents.
+     * @param length Data length.
+     * @param fileSize Size of the new data file.
+     * @throw DatabaseError if operation fails for any reason
+     */
+    void replaceDataFile(const std::uint8_t* data, std::size_t length, std::size_t fileSize);
+
+    /** Maps data file into memory if block is closed and data file allows that. */
+    void mapDataFile();
+
+    /**
+     * Checks that data range fits into the data area.
+     * @param pos Data position.
+     * @param length Data length.
+     * @throw std::runtime_error if data range is invalid.
+     */
+    void checkDataRange(std::uint32_t pos, std::size_t length) const;
+
+    /**
+     * Loads written part of the data area into the memory, if not yet loaded.
+     * Safe to call concurrently by multiple readers.
+     */
+    void ensureDataLoaded() const;
+
+    /**
+     * Copies written data into the in-memory copy of the data area.
+     * @param data A data.
+     * @param length Data length.
+     * @param pos Data position.
+     */
+    void updateCachedData(const void* data, std::size_t length, std::uint32_t pos);
+
+    /**
+     * Reserves memory for the in-memory copy of the data area and reports
+     * changed memory usage to the block pool.
+     * @param size Required size.
+     */
+    void reserveCachedData(std::size_t size) const;
+
 private:
     /** Column to which this data block belongs */
     Column& m_column;
@@ -275,15 +583,45 @@ private:
     /** Cached previous block ID */
     const std::uint64_t m_prevBlockId;
 
+    /** Block extent in the segment file, invalid if block has own data file */
+    ColumnDataExtent m_extent;
+
     /** Column block data file path */
-    const std::string m_dataFilePath;
+    std::string m_dataFilePath;
+
+    /** Block file, may be shared with other blocks if it is segment file */
+    io::FileSharedPtr m_file;
+
+    /**
+     * In-memory copy of the beginning of the data area.
+     * Always has the same contents as the corresponding part of the data file.
+     */
+    mutable std::vector<std::uint8_t> m_data;
 
-    /** Block file */
-    io::FilePtr m_file;
+    /** Indicates that written data is loaded into m_data */
+    mutable std::atomic<bool> m_dataLoaded;
+
+    /** Serializes loading of data into m_data by concurrent readers */
+    mutable std::mutex m_dataLoadMutex;
+
+    /** Memory mapping of the data file, exists only for closed blocks */
+    std::unique_ptr<siodb::io::MemoryMappedFile> m_mappedFile;
+
+    /** Beginning of the data area in the mapped data file, nullptr if not mapped */
+    std::atomic<const std::uint8_t*> m_mappedData;
 
     /** Column block state */
     ColumnDataBlockState m_state;
 
+    /**
+     * Number of times block has been closed or reopened. Allows to detect that
+     * prepared finalization data became obsolete.
+     */
+    std::uint64_t m_closeSequence;
+
+    /** Serializes preparation of the finalization and reopening of the block */
+    mutable std::mutex m_finalizationMutex;
+
     /** Indicates that header of the block is been modified */
     mutable bool m_headerModified;
 
@@ -292,6 +630,12 @@ private:
 
     /** Data file header prototype */
     static const BinaryValue m_dataFileHeaderProto;
+
+    /** Maximum size of the encoded data in percents of the plain data size */
+    static constexpr std::size_t kMaxEncodedDataSizePercent = 75;
+
+    /** Seed of the data checksum */
+    static constexpr std::uint64_t kDataChecksumSeed = 0x5F0D5B1C3A9E4D27ULL;
 };
 
 }  // namespace siodb::iomgr::dbengine
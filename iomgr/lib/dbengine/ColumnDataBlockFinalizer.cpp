@@ -0,0 +1,69 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "ColumnDataBlockFinalizer.h"
+
+// Project headers
+#include "Column.h"
+
+namespace siodb::iomgr::dbengine {
+
+ColumnDataBlockFinalizer::ColumnDataBlockFinalizer(std::size_t threadCount)
+    : m_exitRequested(false)
+{
+    m_threads.reserve(threadCount);
+    try {
+        for (std::size_t i = 0; i < threadCount; ++i)
+            m_threads.emplace_back(&ColumnDataBlockFinalizer::threadMain, this);
+    } catch (...) {
+        {
+            std::lock_guard lock(m_mutex);
+            m_exitRequested = true;
+        }
+        m_queueCond.notify_all();
+        for (auto& thread : m_threads)
+            thread.join();
+        throw;
+    }
+}
+
+ColumnDataBlockFinalizer::~ColumnDataBlockFinalizer()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_exitRequested = true;
+    }
+    m_queueCond.notify_all();
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+void ColumnDataBlockFinalizer::submit(Column& column)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_queue.push_back(&column);
+    }
+    m_queueCond.notify_one();
+}
+
+// ----- internals -----
+
+void ColumnDataBlockFinalizer::threadMain()
+{
+    std::unique_lock lock(m_mutex);
+    while (true) {
+        m_queueCond.wait(lock, [this] { return m_exitRequested || !m_queue.empty(); });
+        // Queued columns are processed even when exit is requested
+        if (m_queue.empty()) break;
+        const auto column = m_queue.front();
+        m_queue.pop_front();
+        lock.unlock();
+        // Column can't be destroyed until it finishes this call
+        column->finalizePendingBlocks();
+        lock.lock();
+    }
+}
+
+}  // namespace siodb::iomgr::dbengine
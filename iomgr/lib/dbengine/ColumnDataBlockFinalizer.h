@@ -0,0 +1,72 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Common project headers
+#include <siodb/common/utils/HelperMacros.h>
+
+// STL headers
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace siodb::iomgr::dbengine {
+
+class Column;
+
+/**
+ * Pool of threads which finalize filled column data blocks, so that inserting
+ * thread doesn't wait for digest computation and data encoding. Column keeps
+ * its own queue of closed blocks and is submitted to the finalizer when that queue
+ * becomes non-empty. Queue of each column is processed by a single thread at a time,
+ * so blocks are finalized in the order of closing and digest chain is preserved.
+ */
+class ColumnDataBlockFinalizer {
+public:
+    /**
+     * Initializes object of class ColumnDataBlockFinalizer. Starts finalizer threads.
+     * @param threadCount Number of finalizer threads.
+     */
+    explicit ColumnDataBlockFinalizer(std::size_t threadCount);
+
+    /**
+     * De-initializes object. Stops threads. All columns must have been already
+     * finalized their pending blocks.
+     */
+    ~ColumnDataBlockFinalizer();
+
+    DECLARE_NONCOPYABLE(ColumnDataBlockFinalizer);
+
+    /**
+     * Queues column which has closed blocks waiting for finalization.
+     * Column must not be queued again until it finishes finalization of its blocks.
+     * @param column Column object.
+     */
+    void submit(Column& column);
+
+private:
+    /** Finalizer thread main function */
+    void threadMain();
+
+private:
+    /** Synchronizes access to the queue */
+    std::mutex m_mutex;
+
+    /** Signals that queue has new columns or that threads must exit */
+    std::condition_variable m_queueCond;
+
+    /** Columns waiting for finalization of their blocks */
+    std::deque<Column*> m_queue;
+
+    /** Indication that threads must exit when queue is empty */
+    bool m_exitRequested;
+
+    /** Finalizer threads */
+    std::vector<std::thread> m_threads;
+};
+
+}  // namespace siodb::iomgr::dbengine
@@ -25,6 +25,15 @@ std::uint8_t* ColumnDataBlockHeader::serialize(std::uint8_t* buffer) const noexc
     buffer = ::pbeEncodeUInt32(m_commitedDataOffset, buffer);
     buffer = ::pbeEncodeUInt64(m_fillTimestamp, buffer);
     buffer = ::pbeEncodeBinary(m_digest.data(), m_digest.size(), buffer);
+    *buffer++ = static_cast<std::uint8_t>(m_encoding);
+    buffer = ::pbeEncodeUInt32(m_encodedDataSize, buffer);
+    *buffer++ = m_zoneMap.m_complete ? 1 : 0;
+    buffer = ::pbeEncodeUInt64(m_zoneMap.m_minValue, buffer);
+    buffer = ::pbeEncodeUInt64(m_zoneMap.m_maxValue, buffer);
+    buffer = ::pbeEncodeUInt32(m_zoneMap.m_nullCount, buffer);
+    buffer = ::pbeEncodeUInt64(m_zoneMap.m_minTrid, buffer);
+    buffer = ::pbeEncodeUInt64(m_zoneMap.m_maxTrid, buffer);
+    buffer = ::pbeEncodeUInt64(m_dataChecksum, buffer);
     return buffer;
 }
 
@@ -47,6 +56,38 @@ const std::uint8_t* ColumnDataBlockHeader::deserialize(const std::uint8_t* buffe
     buffer = ::pbeDecodeUInt32(buffer, &m_commitedDataOffset);
     buffer = ::pbeDecodeUInt64(buffer, &m_fillTimestamp);
     buffer = ::pbeDecodeBinary(buffer, m_digest.data(), m_digest.size());
+    if (m_version < 2) {
+        // Data encoding is not supported by earlier versions
+        m_encoding = ColumnDataEncoding::kPlain;
+        m_encodedDataSize = 0;
+        m_zoneMap = ColumnDataBlockZoneMap();
+        m_zoneMap.m_complete = false;
+        m_dataChecksum = 0;
+        return buffer;
+    }
+    const auto encoding = *buffer++;
+    if (encoding >= static_cast<std::uint8_t>(ColumnDataEncoding::kMax)) return nullptr;
+    m_encoding = static_cast<ColumnDataEncoding>(encoding);
+    buffer = ::pbeDecodeUInt32(buffer, &m_encodedDataSize);
+    if (m_version < 3) {
+        // Value summary is not maintained by earlier versions
+        m_zoneMap = ColumnDataBlockZoneMap();
+        m_zoneMap.m_complete = false;
+        m_dataChecksum = 0;
+        return buffer;
+    }
+    m_zoneMap.m_complete = *buffer++ != 0;
+    buffer = ::pbeDecodeUInt64(buffer, &m_zoneMap.m_minValue);
+    buffer = ::pbeDecodeUInt64(buffer, &m_zoneMap.m_maxValue);
+    buffer = ::pbeDecodeUInt32(buffer, &m_zoneMap.m_nullCount);
+    buffer = ::pbeDecodeUInt64(buffer, &m_zoneMap.m_minTrid);
+    buffer = ::pbeDecodeUInt64(buffer, &m_zoneMap.m_maxTrid);
+    if (m_version < kDataChecksumVersion) {
+        // Data checksum is not maintained by earlier versions
+        m_dataChecksum = 0;
+        return buffer;
+    }
+    buffer = ::pbeDecodeUInt64(buffer, &m_dataChecksum);
     return buffer;
 }
 
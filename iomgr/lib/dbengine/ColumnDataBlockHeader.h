@@ -6,6 +6,8 @@
 
 // Project headers
 #include "ColumnDataBlockState.h"
+#include "ColumnDataBlockZoneMap.h"
+#include "ColumnDataEncoding.h"
 
 // Common project headers
 #include <siodb/common/config/SiodbDefs.h>
@@ -77,6 +79,9 @@ struct ColumnDataBlockHeader {
         , m_commitedDataOffset(0)
         , m_fillTimestamp(0)
         , m_digest {0}
+        , m_encoding(ColumnDataEncoding::kPlain)
+        , m_encodedDataSize(0)
+        , m_dataChecksum(0)
     {
     }
 
@@ -98,6 +103,9 @@ struct ColumnDataBlockHeader {
         , m_commitedDataOffset(0)
         , m_fillTimestamp(0)
         , m_digest {0}
+        , m_encoding(ColumnDataEncoding::kPlain)
+        , m_encodedDataSize(0)
+        , m_dataChecksum(0)
     {
     }
 
@@ -115,6 +123,15 @@ struct ColumnDataBlockHeader {
      */
     const std::uint8_t* deserialize(const std::uint8_t* buffer) noexcept;
 
+    /**
+     * Returns indication that header contains valid data checksum.
+     * @return true if data checksum is valid, false otherwise.
+     */
+    bool hasDataChecksum() const noexcept
+    {
+        return m_version >= kDataChecksumVersion && m_fillTimestamp != 0;
+    }
+
     /** Column block info version */
     std::uint32_t m_version;
 
@@ -148,14 +165,34 @@ struct ColumnDataBlockHeader {
     /** Block digest (when it became full) */
     Digest m_digest;
 
+    /** Encoding of the data area, non-plain encoding is used only for full blocks */
+    ColumnDataEncoding m_encoding;
+
+    /** Size of the encoded data at the data area start, 0 if data is not encoded */
+    std::uint32_t m_encodedDataSize;
+
+    /** Summary of values stored in the block */
+    ColumnDataBlockZoneMap m_zoneMap;
+
+    /**
+     * Checksum of the data area as it is stored in the file, i.e. of the encoded data
+     * if data is encoded. Valid only for the full blocks.
+     */
+    std::uint64_t m_dataChecksum;
+
     /** Current column block info version */
-    static constexpr const std::uint32_t kCurrentVersion = 1;
+    static constexpr const std::uint32_t kCurrentVersion = 4;
+
+    /** First column block info version which has data checksum */
+    static constexpr const std::uint32_t kDataChecksumVersion = 4;
 
     /** Serialized size */
     static constexpr const std::size_t kSerializedSize =
             sizeof(m_version) + FullColumnDataBlockId::kSerializedSize + sizeof(m_prevBlockId)
             + sizeof(m_dataAreaOffset) + sizeof(m_dataAreaSize) + sizeof(m_nextDataOffset)
-            + sizeof(m_commitedDataOffset) + sizeof(m_fillTimestamp) + sizeof(m_digest);
+            + sizeof(m_commitedDataOffset) + sizeof(m_fillTimestamp) + sizeof(m_digest)
+            + sizeof(m_encoding) + sizeof(m_encodedDataSize)
+            + ColumnDataBlockZoneMap::kSerializedSize + sizeof(m_dataChecksum);
 
     /** Standard data area offset for the current data file format version */
     static constexpr std::size_t kDefaultDataAreaOffset = kDataFileHeaderSize;
@@ -0,0 +1,297 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "ColumnDataBlockPool.h"
+
+// Project headers
+#include "ColumnDataBlock.h"
+
+// STL headers
+#include <algorithm>
+#include <iterator>
+
+namespace siodb::iomgr::dbengine {
+
+ColumnDataBlockPool::ColumnDataBlockPool(std::size_t capacity, std::size_t writebackThreadCount)
+    : m_capacity(capacity)
+    , m_probationCapacity(capacity / 100 * kProbationSharePercent)
+    , m_probationMemoryUsage(0)
+    , m_protectedMemoryUsage(0)
+    , m_writeback(writebackThreadCount > 0
+                          ? std::make_unique<ColumnDataBlockWriteback>(writebackThreadCount,
+                                  capacity / 100 * kWritebackSharePercent,
+                                  [this](const Column* column, std::uint64_t blockId) {
+                                      onBlockReleased(column, blockId);
+                                  })
+                          : nullptr)
+{
+}
+
+ColumnDataBlockPool::~ColumnDataBlockPool()
+{
+    // All columns must have been already removed their blocks, so this is just for safety.
+    m_index.clear();
+    m_probation.clear();
+    m_protected.clear();
+}
+
+std::size_t ColumnDataBlockPool::getMemoryUsage() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_probationMemoryUsage + m_protectedMemoryUsage;
+}
+
+std::size_t ColumnDataBlockPool::size() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_index.size();
+}
+
+ColumnDataBlockPtr ColumnDataBlockPool::get(const Column& column, std::uint64_t blockId)
+{
+    const Key key {&column, blockId};
+    std::unique_lock lock(m_mutex);
+    m_releasedCond.wait(lock, [this, &key] { return m_releasingKeys.count(key) == 0; });
+    const auto it = m_index.find(key);
+    if (it == m_index.end()) return nullptr;
+    auto& entry = *it->second;
+    if (entry.m_protected)
+        m_protected.splice(m_protected.begin(), m_protected, it->second);
+    else
+        entry.m_referenced = true;
+    return entry.m_block;
+}
+
+bool ColumnDataBlockPool::contains(const Column& column, std::uint64_t blockId) const
+{
+    std::lock_guard lock(m_mutex);
+    return m_index.count(Key {&column, blockId}) > 0;
+}
+
+ColumnDataBlockPtr ColumnDataBlockPool::emplace(const ColumnDataBlockPtr& block)
+{
+    std::vector<ColumnDataBlockPtr> evictedBlocks;
+    {
+        std::lock_guard lock(m_mutex);
+        const auto key = makeKey(*block);
+        const auto it = m_index.find(key);
+        if (it != m_index.end()) return it->second->m_block;
+
+        // Block which has been evicted from probation recently is worth keeping longer
+        const bool isProtected = removeGhostUnlocked(key);
+        const auto size = block->getMemoryUsage();
+        auto& list = isProtected ? m_protected : m_probation;
+        list.push_front(Entry {block, size, false, isProtected});
+        (isProtected ? m_protectedMemoryUsage : m_probationMemoryUsage) += size;
+        m_index.emplace(key, list.begin());
+        evictUnlocked(evictedBlocks);
+    }
+    releaseEvictedBlocks(evictedBlocks);
+    return block;
+}
+
+void ColumnDataBlockPool::updateMemoryUsage(const ColumnDataBlock& block)
+{
+    std::vector<ColumnDataBlockPtr> evictedBlocks;
+    {
+        std::lock_guard lock(m_mutex);
+        const auto it = m_index.find(makeKey(block));
+        if (it == m_index.end()) return;
+        auto& entry = *it->second;
+        const auto newSize = block.getMemoryUsage();
+        auto& memoryUsage = entry.m_protected ? m_protectedMemoryUsage : m_probationMemoryUsage;
+        memoryUsage = memoryUsage - entry.m_size + newSize;
+        entry.m_size = newSize;
+        evictUnlocked(evictedBlocks);
+    }
+    releaseEvictedBlocks(evictedBlocks);
+}
+
+std::size_t ColumnDataBlockPool::getWritebackMemoryUsage() const
+{
+    return m_writeback ? m_writeback->getQueuedMemoryUsage() : 0;
+}
+
+void ColumnDataBlockPool::evictColumnBlocks(const Column& column)
+{
+    std::vector<ColumnDataBlockPtr> evictedBlocks;
+    {
+        std::lock_guard lock(m_mutex);
+        for (auto it = m_index.begin(); it != m_index.end();) {
+            if (it->first.m_column == &column) {
+                const auto location = it->second;
+                m_releasingKeys.insert(it->first);
+                it = m_index.erase(it);
+                auto& entry = *location;
+                evictedBlocks.push_back(std::move(entry.m_block));
+                if (entry.m_protected) {
+                    m_protectedMemoryUsage -= entry.m_size;
+                    m_protected.erase(location);
+                } else {
+                    m_probationMemoryUsage -= entry.m_size;
+                    m_probation.erase(location);
+                }
+            } else
+                ++it;
+        }
+        for (auto it = m_ghosts.begin(); it != m_ghosts.end();) {
+            if (it->m_column == &column) {
+                m_ghostIndex.erase(*it);
+                it = m_ghosts.erase(it);
+            } else
+                ++it;
+        }
+    }
+    // Column is going away, so its blocks are released right here
+    releaseEvictedBlocks(evictedBlocks, false);
+
+    // Wait for blocks which have been passed to the writeback threads earlier
+    std::unique_lock lock(m_mutex);
+    m_releasedCond.wait(lock, [this, &column] {
+        return std::none_of(m_releasingKeys.cbegin(), m_releasingKeys.cend(),
+                [&column](const Key& key) { return key.m_column == &column; });
+    });
+}
+
+// ----- internals -----
+
+void ColumnDataBlockPool::releaseEvictedBlocks(
+        std::vector<ColumnDataBlockPtr>& evictedBlocks, bool allowWriteback)
+{
+    if (evictedBlocks.empty()) return;
+    std::vector<Key> keys;
+    keys.reserve(evictedBlocks.size());
+    for (auto& block : evictedBlocks) {
+        // Writeback thread removes key of the block after it is released
+        if (allowWriteback && m_writeback && block->isModified() && block.use_count() == 1) {
+            m_writeback->submit(std::move(block));
+            continue;
+        }
+        keys.push_back(makeKey(*block));
+    }
+    // Blocks are destroyed outside of the lock, because they may need to save their headers.
+    evictedBlocks.clear();
+    if (keys.empty()) return;
+    {
+        std::lock_guard lock(m_mutex);
+        for (const auto& key : keys)
+            m_releasingKeys.erase(m_releasingKeys.find(key));
+    }
+    m_releasedCond.notify_all();
+}
+
+void ColumnDataBlockPool::onBlockReleased(const Column* column, std::uint64_t blockId)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_releasingKeys.erase(m_releasingKeys.find(Key {column, blockId}));
+    }
+    m_releasedCond.notify_all();
+}
+
+ColumnDataBlockPool::Key ColumnDataBlockPool::makeKey(const ColumnDataBlock& block) noexcept
+{
+    return Key {&block.getColumn(), block.getId()};
+}
+
+void ColumnDataBlockPool::evictUnlocked(std::vector<ColumnDataBlockPtr>& evictedBlocks)
+{
+    while (m_probationMemoryUsage + m_protectedMemoryUsage > m_capacity) {
+        // Prefer evicting from the probation queue while it exceeds its share
+        // or there is nothing to evict from the protected queue.
+        if (m_probationMemoryUsage > m_probationCapacity || m_protected.empty()) {
+            if (evictFromProbationUnlocked(evictedBlocks)) continue;
+            if (evictFromProtectedUnlocked(evictedBlocks)) continue;
+        } else {
+            if (evictFromProtectedUnlocked(evictedBlocks)) continue;
+            if (evictFromProbationUnlocked(evictedBlocks)) continue;
+        }
+        // All blocks are pinned, nothing can be done now.
+        break;
+    }
+}
+
+bool ColumnDataBlockPool::evictFromProbationUnlocked(
+        std::vector<ColumnDataBlockPtr>& evictedBlocks)
+{
+    for (auto n = m_probation.size(); n > 0; --n) {
+        const auto it = std::prev(m_probation.end());
+        auto& entry = *it;
+        if (entry.m_block.use_count() > 1) {
+            // Pinned, give it another round
+            m_probation.splice(m_probation.begin(), m_probation, it);
+            continue;
+        }
+        if (entry.m_referenced) {
+            // Referenced again while in probation, promote to the protected queue
+            entry.m_referenced = false;
+            entry.m_protected = true;
+            m_probationMemoryUsage -= entry.m_size;
+            m_protectedMemoryUsage += entry.m_size;
+            m_protected.splice(m_protected.begin(), m_probation, it);
+            return true;
+        }
+        addGhostUnlocked(makeKey(*entry.m_block));
+        removeEntryUnlocked(it, evictedBlocks);
+        return true;
+    }
+    return false;
+}
+
+bool ColumnDataBlockPool::evictFromProtectedUnlocked(
+        std::vector<ColumnDataBlockPtr>& evictedBlocks)
+{
+    for (auto n = m_protected.size(); n > 0; --n) {
+        const auto it = std::prev(m_protected.end());
+        if (it->m_block.use_count() > 1) {
+            // Pinned, give it another round
+            m_protected.splice(m_protected.begin(), m_protected, it);
+            continue;
+        }
+        removeEntryUnlocked(it, evictedBlocks);
+        return true;
+    }
+    return false;
+}
+
+void ColumnDataBlockPool::removeEntryUnlocked(
+        EntryLocation it, std::vector<ColumnDataBlockPtr>& evictedBlocks)
+{
+    auto& entry = *it;
+    const auto key = makeKey(*entry.m_block);
+    m_index.erase(key);
+    m_releasingKeys.insert(key);
+    if (entry.m_protected) {
+        m_protectedMemoryUsage -= entry.m_size;
+        evictedBlocks.push_back(std::move(entry.m_block));
+        m_protected.erase(it);
+    } else {
+        m_probationMemoryUsage -= entry.m_size;
+        evictedBlocks.push_back(std::move(entry.m_block));
+        m_probation.erase(it);
+    }
+}
+
+void ColumnDataBlockPool::addGhostUnlocked(const Key& key)
+{
+    removeGhostUnlocked(key);
+    m_ghosts.push_front(key);
+    m_ghostIndex.emplace(key, m_ghosts.begin());
+    const auto maxGhostCount = std::max(m_index.size(), kMinGhostCount);
+    while (m_ghosts.size() > maxGhostCount) {
+        m_ghostIndex.erase(m_ghosts.back());
+        m_ghosts.pop_back();
+    }
+}
+
+bool ColumnDataBlockPool::removeGhostUnlocked(const Key& key)
+{
+    const auto it = m_ghostIndex.find(key);
+    if (it == m_ghostIndex.end()) return false;
+    m_ghosts.erase(it->second);
+    m_ghostIndex.erase(it);
+    return true;
+}
+
+}  // namespace siodb::iomgr::dbengine
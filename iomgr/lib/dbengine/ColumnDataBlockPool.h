@@ -0,0 +1,295 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "ColumnDataBlockPtr.h"
+#include "ColumnDataBlockWriteback.h"
+
+// Common project headers
+#include <siodb/common/utils/HelperMacros.h>
+
+// STL headers
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace siodb::iomgr::dbengine {
+
+class Column;
+
+/**
+ * Instance-wide pool of column data blocks with their contents, limited by memory size.
+ * Uses 2Q-style replacement: new blocks enter probation queue and are promoted to
+ * the protected queue only when referenced again, so that large one-time scans
+ * can evict only other probation blocks. Block is pinned while anybody except
+ * pool holds a ColumnDataBlockPtr to it, pinned blocks are never evicted.
+ * Pool is thread-safe. Lookup of the block which is being released after eviction
+ * waits until release completes, so that block is never reloaded with stale header.
+ * Modified blocks are written back and released by the writeback threads.
+ */
+class ColumnDataBlockPool {
+public:
+    /**
+     * Initializes object of class ColumnDataBlockPool.
+     * @param capacity Pool capacity in bytes.
+     * @param writebackThreadCount Number of threads which write back evicted
+     *                             modified blocks. Zero means that blocks are
+     *                             written back by the evicting thread.
+     */
+    ColumnDataBlockPool(std::size_t capacity, std::size_t writebackThreadCount);
+
+    /** De-initializes object of class ColumnDataBlockPool */
+    ~ColumnDataBlockPool();
+
+    DECLARE_NONCOPYABLE(ColumnDataBlockPool);
+
+    /**
+     * Returns pool capacity.
+     * @return Pool capacity in bytes.
+     */
+    std::size_t getCapacity() const noexcept
+    {
+        return m_capacity;
+    }
+
+    /**
+     * Returns amount of memory currently used by the cached blocks.
+     * @return Memory usage in bytes.
+     */
+    std::size_t getMemoryUsage() const;
+
+    /**
+     * Returns number of cached blocks.
+     * @return Number of cached blocks.
+     */
+    std::size_t size() const;
+
+    /**
+     * Looks up block in the pool. Waits if block has been evicted and is still being released.
+     * @param column Column to which block belongs.
+     * @param blockId Block ID.
+     * @return Block object or nullptr if block is not cached.
+     */
+    ColumnDataBlockPtr get(const Column& column, std::uint64_t blockId);
+
+    /**
+     * Checks presence of the block in the pool without affecting its replacement priority.
+     * @param column Column to which block belongs.
+     * @param blockId Block ID.
+     * @return true if block is in the pool, false otherwise.
+     */
+    bool contains(const Column& column, std::uint64_t blockId) const;
+
+    /**
+     * Adds block to the pool. Evicts other blocks if memory limit is exceeded.
+     * If the same block has been already added concurrently, pool keeps existing one.
+     * @param block Block object.
+     * @return Block object which is in the pool.
+     */
+    ColumnDataBlockPtr emplace(const ColumnDataBlockPtr& block);
+
+    /**
+     * Updates memory amount charged for the block, which has changed size of its buffers.
+     * Evicts other blocks if memory limit is exceeded.
+     * @param block Block object.
+     */
+    void updateMemoryUsage(const ColumnDataBlock& block);
+
+    /**
+     * Returns amount of memory held by the evicted blocks waiting for writeback.
+     * @return Memory usage in bytes.
+     */
+    std::size_t getWritebackMemoryUsage() const;
+
+    /**
+     * Removes all blocks of the given column from the pool. Must be called when column
+     * object is destroyed. Waits until writeback of the column blocks completes.
+     * @param column Column object.
+     */
+    void evictColumnBlocks(const Column& column);
+
+private:
+    /** Block key */
+    struct Key {
+        /** Column object */
+        const Column* m_column;
+
+        /** Block ID */
+        std::uint64_t m_blockId;
+
+        /**
+         * Equality comparison operator.
+         * @param other Other key.
+         * @return true if keys are equal, false otherwise.
+         */
+        bool operator==(const Key& other) const noexcept
+        {
+            return m_column == other.m_column && m_blockId == other.m_blockId;
+        }
+    };
+
+    /** Block key hasher */
+    struct KeyHash {
+        /**
+         * Computes hash value of the key.
+         * @param key A key.
+         * @return Hash value.
+         */
+        std::size_t operator()(const Key& key) const noexcept
+        {
+            const auto h = std::hash<const Column*>()(key.m_column);
+            return h ^ (std::hash<std::uint64_t>()(key.m_blockId) + 0x9e3779b9 + (h << 6)
+                               + (h >> 2));
+        }
+    };
+
+    /** Pool entry */
+    struct Entry {
+        /** Block */
+        ColumnDataBlockPtr m_block;
+
+        /** Memory charged for this block */
+        std::size_t m_size;
+
+        /** Indication that block was referenced while in probation */
+        bool m_referenced;
+
+        /** Indication that block is in the protected queue */
+        bool m_protected;
+    };
+
+    /** Entry list type */
+    using EntryList = std::list<Entry>;
+
+    /** Entry location */
+    using EntryLocation = EntryList::iterator;
+
+    /** Ghost key list type */
+    using GhostList = std::list<Key>;
+
+private:
+    /**
+     * Makes key for the block.
+     * @param block Block object.
+     * @return Block key.
+     */
+    static Key makeKey(const ColumnDataBlock& block) noexcept;
+
+    /**
+     * Releases evicted blocks and wakes up threads waiting for them. Modified blocks
+     * are passed to the writeback threads if allowed. Pool must be unlocked.
+     * @param evictedBlocks Evicted blocks.
+     * @param allowWriteback Indicates that modified blocks may be written back asynchronously.
+     */
+    void releaseEvictedBlocks(
+            std::vector<ColumnDataBlockPtr>& evictedBlocks, bool allowWriteback = true);
+
+    /**
+     * Forgets block which has been released and wakes up threads waiting for it.
+     * Pool must be unlocked.
+     * @param column Column to which block belongs.
+     * @param blockId Block ID.
+     */
+    void onBlockReleased(const Column* column, std::uint64_t blockId);
+
+    /**
+     * Evicts unpinned blocks until memory usage fits into capacity.
+     * @param[out] evictedBlocks Evicted blocks, to be released with pool unlocked.
+     */
+    void evictUnlocked(std::vector<ColumnDataBlockPtr>& evictedBlocks);
+
+    /**
+     * Evicts single block from the probation queue.
+     * @param[out] evictedBlocks Evicted blocks, to be released with pool unlocked.
+     * @return true if block was evicted, false otherwise.
+     */
+    bool evictFromProbationUnlocked(std::vector<ColumnDataBlockPtr>& evictedBlocks);
+
+    /**
+     * Evicts single block from the protected queue.
+     * @param[out] evictedBlocks Evicted blocks, to be released with pool unlocked.
+     * @return true if block was evicted, false otherwise.
+     */
+    bool evictFromProtectedUnlocked(std::vector<ColumnDataBlockPtr>& evictedBlocks);
+
+    /**
+     * Removes entry from the pool.
+     * @param it Entry location.
+     * @param[out] evictedBlocks Evicted blocks, to be released with pool unlocked.
+     */
+    void removeEntryUnlocked(EntryLocation it, std::vector<ColumnDataBlockPtr>& evictedBlocks);
+
+    /**
+     * Remembers key of the block evicted from probation queue.
+     * @param key Block key.
+     */
+    void addGhostUnlocked(const Key& key);
+
+    /**
+     * Removes ghost key if it exists.
+     * @param key Block key.
+     * @return true if ghost key existed, false otherwise.
+     */
+    bool removeGhostUnlocked(const Key& key);
+
+private:
+    /** Capacity in bytes */
+    const std::size_t m_capacity;
+
+    /** Probation queue memory limit */
+    const std::size_t m_probationCapacity;
+
+    /** Synchronization object */
+    mutable std::mutex m_mutex;
+
+    /** Probation queue, most recent block first */
+    EntryList m_probation;
+
+    /** Protected queue, most recent block first */
+    EntryList m_protected;
+
+    /** Block lookup index */
+    std::unordered_map<Key, EntryLocation, KeyHash> m_index;
+
+    /** Keys of the blocks recently evicted from the probation queue, most recent first */
+    GhostList m_ghosts;
+
+    /** Ghost key lookup index */
+    std::unordered_map<Key, GhostList::iterator, KeyHash> m_ghostIndex;
+
+    /** Keys of the evicted blocks which are still being released */
+    std::unordered_multiset<Key, KeyHash> m_releasingKeys;
+
+    /** Signals that some evicted blocks have been released */
+    std::condition_variable m_releasedCond;
+
+    /** Memory used by blocks in the probation queue */
+    std::size_t m_probationMemoryUsage;
+
+    /** Memory used by blocks in the protected queue */
+    std::size_t m_protectedMemoryUsage;
+
+    /** Probation queue share of the capacity, in percents */
+    static constexpr std::size_t kProbationSharePercent = 25;
+
+    /**
+     * Writeback threads. Must be declared last, so that queued blocks are written back
+     * while rest of the pool still exists.
+     */
+    std::unique_ptr<ColumnDataBlockWriteback> m_writeback;
+
+    /** Minimum number of remembered ghost keys */
+    static constexpr std::size_t kMinGhostCount = 256;
+
+    /** Share of the capacity which may be held by blocks waiting for writeback, in percents */
+    static constexpr std::size_t kWritebackSharePercent = 10;
+};
+
+}  // namespace siodb::iomgr::dbengine
@@ -0,0 +1,99 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "ColumnDataBlockReadahead.h"
+
+// Project headers
+#include "Column.h"
+
+// Common project headers
+#include <siodb/common/log/Log.h>
+
+// STL headers
+#include <algorithm>
+#include <iterator>
+
+namespace siodb::iomgr::dbengine {
+
+ColumnDataBlockReadahead::ColumnDataBlockReadahead(Column& column) noexcept
+    : m_column(column)
+    , m_currentBlockId(0)
+    , m_blockScanTime(0)
+    , m_windowSize(kInitialWindowBlocks)
+{
+}
+
+void ColumnDataBlockReadahead::reset() noexcept
+{
+    m_currentBlockId = 0;
+    m_blockScanTime = std::chrono::microseconds(0);
+    m_aheadBlockIds.clear();
+    m_windowSize = kInitialWindowBlocks;
+}
+
+void ColumnDataBlockReadahead::onBlockAccess(std::uint64_t blockId)
+{
+    if (blockId == m_currentBlockId) return;
+
+    // Update average block scan time
+    const auto now = std::chrono::steady_clock::now();
+    if (m_currentBlockId != 0) {
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                now - m_currentBlockAccessTime);
+        m_blockScanTime =
+                m_blockScanTime.count() == 0 ? elapsed : (m_blockScanTime * 3 + elapsed) / 4;
+    }
+    m_currentBlockId = blockId;
+    m_currentBlockAccessTime = now;
+
+    // Adjust window
+    const auto it = std::find(m_aheadBlockIds.begin(), m_aheadBlockIds.end(), blockId);
+    if (it == m_aheadBlockIds.end()) {
+        // Scan has just started or jumped somewhere else
+        m_aheadBlockIds.clear();
+        m_windowSize = kInitialWindowBlocks;
+    } else {
+        m_aheadBlockIds.erase(m_aheadBlockIds.begin(), std::next(it));
+        m_windowSize = std::min(m_windowSize * 2, getMaxWindowSize());
+    }
+
+    try {
+        fillWindow(blockId);
+    } catch (std::exception& ex) {
+        // Readahead is just a hint, scan itself must not fail because of it
+        LOG_DEBUG << "Column " << m_column.getDisplayName()
+                  << ": readahead failed: " << ex.what();
+        m_aheadBlockIds.clear();
+    }
+}
+
+// ---- internals ----
+
+std::size_t ColumnDataBlockReadahead::getMaxWindowSize() const noexcept
+{
+    const std::size_t blockSize = m_column.getDataBlockDataAreaSize();
+    auto maxWindowSize =
+            std::min(kMaxWindowBlocks, std::max(kMaxWindowBytes / blockSize, std::size_t(1)));
+    // No need to read ahead further than scan can reach in the target lead time
+    if (m_blockScanTime.count() > 0) {
+        const std::size_t rateLimit = kTargetLeadTime / m_blockScanTime + 1;
+        maxWindowSize = std::min(maxWindowSize, rateLimit);
+    }
+    return maxWindowSize;
+}
+
+void ColumnDataBlockReadahead::fillWindow(std::uint64_t blockId)
+{
+    auto lastBlockId = m_aheadBlockIds.empty() ? blockId : m_aheadBlockIds.back();
+    while (m_aheadBlockIds.size() < m_windowSize) {
+        const auto nextBlockIds = m_column.getNextBlockIds(lastBlockId);
+        if (nextBlockIds.empty()) break;
+        // Chain may branch after rollback, the latest branch is the one that is being filled
+        lastBlockId = nextBlockIds.back();
+        m_column.readAheadBlock(lastBlockId);
+        m_aheadBlockIds.push_back(lastBlockId);
+    }
+}
+
+}  // namespace siodb::iomgr::dbengine
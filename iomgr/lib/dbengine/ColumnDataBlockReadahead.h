@@ -0,0 +1,94 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// STL headers
+#include <chrono>
+#include <cstdint>
+#include <deque>
+
+namespace siodb::iomgr::dbengine {
+
+class Column;
+
+/**
+ * Sequential scan readahead of the column data blocks. Follows block chain
+ * using block registry and advises OS to read data files of the next blocks
+ * in advance, so that they are already in the page cache when scan reaches them.
+ * Readahead window grows while scan stays sequential, is limited by the scan rate
+ * and shrinks back when scan jumps to an unexpected block.
+ */
+class ColumnDataBlockReadahead {
+public:
+    /**
+     * Initializes object of class ColumnDataBlockReadahead.
+     * @param column Column which blocks are read ahead.
+     */
+    explicit ColumnDataBlockReadahead(Column& column) noexcept;
+
+    /**
+     * Returns current readahead window size.
+     * @return Window size in blocks.
+     */
+    std::size_t getWindowSize() const noexcept
+    {
+        return m_windowSize;
+    }
+
+    /** Forgets scan history, must be called when scan is restarted. */
+    void reset() noexcept;
+
+    /**
+     * Notifies that scan has reached the given block. Issues readahead of the next blocks.
+     * @param blockId Block ID.
+     */
+    void onBlockAccess(std::uint64_t blockId);
+
+private:
+    /**
+     * Computes maximum window size for the current scan rate.
+     * @return Maximum window size in blocks.
+     */
+    std::size_t getMaxWindowSize() const noexcept;
+
+    /**
+     * Advises readahead of the next blocks in the chain until window is filled.
+     * @param blockId Block ID which scan has reached.
+     */
+    void fillWindow(std::uint64_t blockId);
+
+private:
+    /** Column object */
+    Column& m_column;
+
+    /** Block at which scan is now, 0 if scan isn't started */
+    std::uint64_t m_currentBlockId;
+
+    /** Time when scan has reached current block */
+    std::chrono::steady_clock::time_point m_currentBlockAccessTime;
+
+    /** Average time of scanning single block, 0 if unknown */
+    std::chrono::microseconds m_blockScanTime;
+
+    /** Blocks for which readahead is issued, in the expected scan order */
+    std::deque<std::uint64_t> m_aheadBlockIds;
+
+    /** Current readahead window size in blocks */
+    std::size_t m_windowSize;
+
+    /** Upper limit of window size in bytes */
+    static constexpr std::size_t kMaxWindowBytes = 64 * 1024 * 1024;
+
+    /** Upper limit of window size in blocks */
+    static constexpr std::size_t kMaxWindowBlocks = 64;
+
+    /** Initial window size in blocks */
+    static constexpr std::size_t kInitialWindowBlocks = 2;
+
+    /** How long ahead of the scan data should be read */
+    static constexpr std::chrono::microseconds kTargetLeadTime {500000};
+};
+
+}  // namespace siodb::iomgr::dbengine
@@ -0,0 +1,137 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "ColumnDataBlockScrubber.h"
+
+// Project headers
+#include <siodb-generated/iomgr/lib/messages/IOManagerMessageId.h>
+#include "Column.h"
+#include "Database.h"
+#include "DatabaseError.h"
+#include "Instance.h"
+#include "Table.h"
+
+// Common project headers
+#include <siodb/common/log/Log.h>
+
+namespace siodb::iomgr::dbengine {
+
+ColumnDataBlockScrubber::ColumnDataBlockScrubber(
+        Instance& instance, std::size_t rate, std::size_t interval)
+    : m_instance(instance)
+    , m_rate(rate)
+    , m_interval(interval)
+    , m_passBytesRead(0)
+    , m_passBlockCount(0)
+    , m_passErrorCount(0)
+    , m_exitRequested(false)
+    , m_thread(&ColumnDataBlockScrubber::threadMain, this)
+{
+}
+
+ColumnDataBlockScrubber::~ColumnDataBlockScrubber()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_exitRequested = true;
+    }
+    m_exitCond.notify_all();
+    m_thread.join();
+}
+
+// ----- internals -----
+
+void ColumnDataBlockScrubber::threadMain()
+{
+    auto nextPassTime = std::chrono::steady_clock::now() + kInitialDelay;
+    while (waitUntil(nextPassTime)) {
+        m_passStartTime = std::chrono::steady_clock::now();
+        m_passBytesRead = 0;
+        m_passBlockCount = 0;
+        m_passErrorCount = 0;
+        try {
+            scrubAllDatabases();
+        } catch (std::exception& ex) {
+            LOG_ERROR << "Block scrubber: pass failed: " << ex.what();
+        }
+        const auto duration = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::steady_clock::now() - m_passStartTime);
+        LOG_INFO << "Block scrubber: verified " << m_passBlockCount << " blocks, "
+                 << m_passBytesRead << " bytes in " << duration.count() << " seconds, found "
+                 << m_passErrorCount << " corrupted blocks";
+        nextPassTime = m_passStartTime + m_interval;
+    }
+}
+
+void ColumnDataBlockScrubber::scrubAllDatabases()
+{
+    for (const auto& dbRecord : m_instance.getDatabaseRecordsOrderedByName()) {
+        // Database may have been dropped since list was obtained
+        const auto database = m_instance.getDatabase(dbRecord.m_name);
+        if (!database) continue;
+        for (const auto tableId : database->getTableIds()) {
+            TablePtr table;
+            try {
+                table = database->getTableChecked(tableId);
+            } catch (std::exception& ex) {
+                LOG_DEBUG << "Block scrubber: skipping table #" << tableId << " of the database "
+                          << database->getName() << ": " << ex.what();
+                continue;
+            }
+            for (const auto& column : table->getColumnsOrderedByPosition()) {
+                if (!scrubColumn(*column)) return;
+            }
+        }
+    }
+}
+
+bool ColumnDataBlockScrubber::scrubColumn(Column& column)
+{
+    const auto lastBlockId = column.getLastBlockId();
+    for (std::uint64_t blockId = 1; blockId <= lastBlockId; ++blockId) {
+        try {
+            const auto bytesRead = column.verifyBlock(blockId);
+            if (bytesRead == 0) continue;
+            m_passBytesRead += bytesRead;
+            ++m_passBlockCount;
+        } catch (DatabaseError& ex) {
+            if (ex.getErrorCode()
+                    != static_cast<int>(
+                            IOManagerMessageId::kErrorColumnDataBlockConsistencyMismatch)) {
+                // Block may have been removed or be unreadable for a transient reason
+                LOG_WARNING << "Block scrubber: can't verify block " << column.getDisplayName()
+                            << '.' << blockId << ": " << ex.what();
+                continue;
+            }
+            ++m_passErrorCount;
+            LOG_ERROR << "Block scrubber: " << ex.what();
+            try {
+                m_instance.recordBlockCheckError(column, blockId, ex.what());
+            } catch (std::exception& ex2) {
+                LOG_ERROR << "Block scrubber: can't record check error of the block "
+                          << column.getDisplayName() << '.' << blockId << ": " << ex2.what();
+            }
+        } catch (std::exception& ex) {
+            LOG_WARNING << "Block scrubber: can't verify block " << column.getDisplayName() << '.'
+                        << blockId << ": " << ex.what();
+        }
+
+        // Sleep until read rate drops to the limit
+        const std::chrono::duration<double> expectedDuration(
+                static_cast<double>(m_passBytesRead) / m_rate);
+        const auto expectedEndTime =
+                m_passStartTime
+                + std::chrono::duration_cast<std::chrono::steady_clock::duration>(expectedDuration);
+        if (!waitUntil(expectedEndTime)) return false;
+    }
+    return true;
+}
+
+bool ColumnDataBlockScrubber::waitUntil(std::chrono::steady_clock::time_point timePoint)
+{
+    std::unique_lock lock(m_mutex);
+    return !m_exitCond.wait_until(lock, timePoint, [this] { return m_exitRequested; });
+}
+
+}  // namespace siodb::iomgr::dbengine
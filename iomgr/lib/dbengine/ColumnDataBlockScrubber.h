@@ -0,0 +1,101 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Common project headers
+#include <siodb/common/utils/HelperMacros.h>
+
+// STL headers
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace siodb::iomgr::dbengine {
+
+class Column;
+class Instance;
+
+/**
+ * Background thread which periodically verifies stored data of the closed column data
+ * blocks in all databases: data checksum and digest chain. Reads are rate-limited,
+ * so that scrubbing doesn't compete with user requests for disk bandwidth.
+ * Corrupted blocks are recorded into the system table SYS_BLOCK_CHECKS.
+ */
+class ColumnDataBlockScrubber {
+public:
+    /**
+     * Initializes object of class ColumnDataBlockScrubber. Starts scrubber thread.
+     * @param instance Instance object.
+     * @param rate Max. read rate in bytes per second.
+     * @param interval Interval between passes in seconds.
+     */
+    ColumnDataBlockScrubber(Instance& instance, std::size_t rate, std::size_t interval);
+
+    /** De-initializes object. Stops scrubber thread. */
+    ~ColumnDataBlockScrubber();
+
+    DECLARE_NONCOPYABLE(ColumnDataBlockScrubber);
+
+private:
+    /** Scrubber thread main function */
+    void threadMain();
+
+    /** Verifies all closed blocks of all databases once */
+    void scrubAllDatabases();
+
+    /**
+     * Verifies all closed blocks of a column.
+     * @param column Column object.
+     * @return false if exit was requested, true otherwise.
+     */
+    bool scrubColumn(Column& column);
+
+    /**
+     * Waits until given time point or until exit is requested.
+     * @param timePoint Time point.
+     * @return false if exit was requested, true otherwise.
+     */
+    bool waitUntil(std::chrono::steady_clock::time_point timePoint);
+
+private:
+    /** Instance object */
+    Instance& m_instance;
+
+    /** Max. read rate in bytes per second */
+    const std::size_t m_rate;
+
+    /** Interval between passes */
+    const std::chrono::seconds m_interval;
+
+    /** Start time of the current pass */
+    std::chrono::steady_clock::time_point m_passStartTime;
+
+    /** Number of bytes read during the current pass */
+    std::size_t m_passBytesRead;
+
+    /** Number of blocks verified during the current pass */
+    std::size_t m_passBlockCount;
+
+    /** Number of corrupted blocks found during the current pass */
+    std::size_t m_passErrorCount;
+
+    /** Synchronizes access to the exit flag */
+    std::mutex m_mutex;
+
+    /** Signals that thread must exit */
+    std::condition_variable m_exitCond;
+
+    /** Indication that thread must exit */
+    bool m_exitRequested;
+
+    /** Scrubber thread */
+    std::thread m_thread;
+
+    /** Delay of the first pass after startup */
+    static constexpr std::chrono::seconds kInitialDelay {60};
+};
+
+}  // namespace siodb::iomgr::dbengine
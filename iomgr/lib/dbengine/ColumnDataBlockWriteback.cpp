@@ -0,0 +1,100 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "ColumnDataBlockWriteback.h"
+
+// Project headers
+#include "ColumnDataBlock.h"
+
+// Common project headers
+#include <siodb/common/log/Log.h>
+
+namespace siodb::iomgr::dbengine {
+
+ColumnDataBlockWriteback::ColumnDataBlockWriteback(
+        std::size_t threadCount, std::size_t memoryLimit, ReleaseHandler releaseHandler)
+    : m_memoryLimit(memoryLimit)
+    , m_releaseHandler(std::move(releaseHandler))
+    , m_queuedMemoryUsage(0)
+    , m_exitRequested(false)
+{
+    m_threads.reserve(threadCount);
+    try {
+        for (std::size_t i = 0; i < threadCount; ++i)
+            m_threads.emplace_back(&ColumnDataBlockWriteback::threadMain, this);
+    } catch (...) {
+        {
+            std::lock_guard lock(m_mutex);
+            m_exitRequested = true;
+        }
+        m_queueCond.notify_all();
+        for (auto& thread : m_threads)
+            thread.join();
+        throw;
+    }
+}
+
+ColumnDataBlockWriteback::~ColumnDataBlockWriteback()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_exitRequested = true;
+    }
+    m_queueCond.notify_all();
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+std::size_t ColumnDataBlockWriteback::getQueuedMemoryUsage() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_queuedMemoryUsage;
+}
+
+void ColumnDataBlockWriteback::submit(ColumnDataBlockPtr&& block)
+{
+    const auto size = block->getMemoryUsage();
+    std::unique_lock lock(m_mutex);
+    // Back-pressure: don't let evicted blocks pile up faster than they are written
+    m_spaceCond.wait(lock, [this] {
+        return m_queuedMemoryUsage == 0 || m_queuedMemoryUsage < m_memoryLimit;
+    });
+    m_queue.emplace_back(std::move(block), size);
+    m_queuedMemoryUsage += size;
+    lock.unlock();
+    m_queueCond.notify_one();
+}
+
+// ----- internals -----
+
+void ColumnDataBlockWriteback::threadMain()
+{
+    std::unique_lock lock(m_mutex);
+    while (true) {
+        m_queueCond.wait(lock, [this] { return m_exitRequested || !m_queue.empty(); });
+        // Queued blocks are written back even when exit is requested
+        if (m_queue.empty()) break;
+        auto block = std::move(m_queue.front().first);
+        const auto size = m_queue.front().second;
+        m_queue.pop_front();
+        lock.unlock();
+
+        const auto column = &block->getColumn();
+        const auto blockId = block->getId();
+        try {
+            block->writeBack();
+        } catch (std::exception& ex) {
+            LOG_ERROR << "Column data block writeback: " << block->getDisplayName() << ": "
+                      << ex.what();
+        }
+        block.reset();
+        m_releaseHandler(column, blockId);
+
+        lock.lock();
+        m_queuedMemoryUsage -= size;
+        m_spaceCond.notify_all();
+    }
+}
+
+}  // namespace siodb::iomgr::dbengine
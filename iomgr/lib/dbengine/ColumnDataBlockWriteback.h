@@ -0,0 +1,97 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "ColumnDataBlockPtr.h"
+
+// Common project headers
+#include <siodb/common/utils/HelperMacros.h>
+
+// STL headers
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace siodb::iomgr::dbengine {
+
+class Column;
+
+/**
+ * Pool of threads which write back modified column data blocks evicted from
+ * the block pool and release them, so that thread which caused eviction doesn't
+ * wait for disk I/O. Amount of memory held by the queued blocks is limited:
+ * when limit is reached, submitting thread waits until some blocks are written back.
+ */
+class ColumnDataBlockWriteback {
+public:
+    /** Handler which is called after block is written back and destroyed */
+    using ReleaseHandler = std::function<void(const Column* column, std::uint64_t blockId)>;
+
+public:
+    /**
+     * Initializes object of class ColumnDataBlockWriteback. Starts writeback threads.
+     * @param threadCount Number of writeback threads.
+     * @param memoryLimit Maximum memory held by the queued blocks.
+     * @param releaseHandler Handler which is called after block is released.
+     */
+    ColumnDataBlockWriteback(
+            std::size_t threadCount, std::size_t memoryLimit, ReleaseHandler releaseHandler);
+
+    /** De-initializes object. Writes back all queued blocks and stops threads. */
+    ~ColumnDataBlockWriteback();
+
+    DECLARE_NONCOPYABLE(ColumnDataBlockWriteback);
+
+    /**
+     * Returns memory held by the queued blocks.
+     * @return Memory usage in bytes.
+     */
+    std::size_t getQueuedMemoryUsage() const;
+
+    /**
+     * Queues block for writeback. Caller must hold the only reference to the block.
+     * Waits while memory held by the queued blocks exceeds limit.
+     * @param block Modified block.
+     */
+    void submit(ColumnDataBlockPtr&& block);
+
+private:
+    /** Writeback thread main function */
+    void threadMain();
+
+private:
+    /** Maximum memory held by the queued blocks */
+    const std::size_t m_memoryLimit;
+
+    /** Block release handler */
+    const ReleaseHandler m_releaseHandler;
+
+    /** Synchronizes access to the queue */
+    mutable std::mutex m_mutex;
+
+    /** Signals that queue has new blocks or that threads must exit */
+    std::condition_variable m_queueCond;
+
+    /** Signals that queued blocks have been written back */
+    std::condition_variable m_spaceCond;
+
+    /** Blocks waiting for writeback and memory charged for them */
+    std::deque<std::pair<ColumnDataBlockPtr, std::size_t>> m_queue;
+
+    /** Memory held by the queued blocks and blocks which are being written back */
+    std::size_t m_queuedMemoryUsage;
+
+    /** Indication that threads must exit when queue is empty */
+    bool m_exitRequested;
+
+    /** Writeback threads */
+    std::vector<std::thread> m_threads;
+};
+
+}  // namespace siodb::iomgr::dbengine
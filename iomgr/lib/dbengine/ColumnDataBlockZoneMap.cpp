@@ -0,0 +1,171 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "ColumnDataBlockZoneMap.h"
+
+// Project headers
+#include "Variant.h"
+
+// CRT headers
+#include <cmath>
+#include <cstring>
+
+namespace siodb::iomgr::dbengine {
+
+namespace {
+
+constexpr std::uint64_t kSignBit = 0x8000000000000000ULL;
+
+/** Largest integer magnitude exactly representable by float */
+constexpr std::int64_t kMaxExactFloatInteger = 1LL << 24;
+
+std::uint64_t getSignedIntegerKey(std::int64_t value) noexcept
+{
+    return static_cast<std::uint64_t>(value) ^ kSignBit;
+}
+
+std::optional<std::uint64_t> getFloatingPointKey(double value) noexcept
+{
+    if (std::isnan(value)) return std::nullopt;
+    // -0.0 and +0.0 are equal, so they must have the same key
+    if (value == 0.0) value = 0.0;
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & kSignBit) ? ~bits : (bits | kSignBit);
+}
+
+std::uint64_t getDateTimeKey(const RawDateTime& value) noexcept
+{
+    // Nanoseconds are dropped, so different values may have the same key,
+    // but order of the keys is still consistent with order of the values.
+    const auto& date = value.m_datePart;
+    const auto& time = value.m_timePart;
+    std::uint64_t key = static_cast<std::uint64_t>(date.m_year - RawDate::kMinYear);
+    key = key * 12 + date.m_month;
+    key = key * 31 + date.m_dayOfMonth;
+    key = key * 24 + time.m_hours;
+    key = key * 60 + time.m_minutes;
+    key = key * 60 + time.m_seconds;
+    return key;
+}
+
+bool isSignedIntegerValue(const Variant& value) noexcept
+{
+    switch (value.getValueType()) {
+        case VariantType::kInt8:
+        case VariantType::kInt16:
+        case VariantType::kInt32:
+        case VariantType::kInt64: return true;
+        default: return false;
+    }
+}
+
+bool isUnsignedIntegerValue(const Variant& value) noexcept
+{
+    switch (value.getValueType()) {
+        case VariantType::kUInt8:
+        case VariantType::kUInt16:
+        case VariantType::kUInt32:
+        case VariantType::kUInt64: return true;
+        default: return false;
+    }
+}
+
+}  // anonymous namespace
+
+bool isZoneMapSupported(ColumnDataType dataType) noexcept
+{
+    switch (dataType) {
+        case COLUMN_DATA_TYPE_INT8:
+        case COLUMN_DATA_TYPE_UINT8:
+        case COLUMN_DATA_TYPE_INT16:
+        case COLUMN_DATA_TYPE_UINT16:
+        case COLUMN_DATA_TYPE_INT32:
+        case COLUMN_DATA_TYPE_UINT32:
+        case COLUMN_DATA_TYPE_INT64:
+        case COLUMN_DATA_TYPE_UINT64:
+        case COLUMN_DATA_TYPE_FLOAT:
+        case COLUMN_DATA_TYPE_DOUBLE:
+        case COLUMN_DATA_TYPE_TIMESTAMP: return true;
+        default: return false;
+    }
+}
+
+std::optional<std::uint64_t> getZoneMapKey(ColumnDataType dataType, const Variant& value)
+{
+    switch (dataType) {
+        case COLUMN_DATA_TYPE_INT8:
+        case COLUMN_DATA_TYPE_INT16:
+        case COLUMN_DATA_TYPE_INT32:
+        case COLUMN_DATA_TYPE_INT64: return getSignedIntegerKey(value.asInt64());
+        case COLUMN_DATA_TYPE_UINT8:
+        case COLUMN_DATA_TYPE_UINT16:
+        case COLUMN_DATA_TYPE_UINT32:
+        case COLUMN_DATA_TYPE_UINT64: return value.asUInt64();
+        case COLUMN_DATA_TYPE_FLOAT:
+        case COLUMN_DATA_TYPE_DOUBLE: return getFloatingPointKey(value.asDouble());
+        case COLUMN_DATA_TYPE_TIMESTAMP: return getDateTimeKey(value.getDateTime());
+        default: return std::nullopt;
+    }
+}
+
+std::optional<std::uint64_t> getZoneMapKeyForConstant(
+        ColumnDataType dataType, const Variant& value)
+{
+    switch (dataType) {
+        case COLUMN_DATA_TYPE_INT8:
+        case COLUMN_DATA_TYPE_INT16:
+        case COLUMN_DATA_TYPE_INT32:
+        case COLUMN_DATA_TYPE_INT64: {
+            if (isSignedIntegerValue(value)) return getSignedIntegerKey(value.asInt64());
+            // Positive literals are unsigned. Large unsigned values are compared
+            // with signed ones after the narrowing cast, so they are not used.
+            if (isUnsignedIntegerValue(value)
+                    && value.asUInt64() <= std::numeric_limits<std::int32_t>::max())
+                return getSignedIntegerKey(value.asInt64());
+            return std::nullopt;
+        }
+
+        case COLUMN_DATA_TYPE_UINT8:
+        case COLUMN_DATA_TYPE_UINT16:
+        case COLUMN_DATA_TYPE_UINT32:
+        case COLUMN_DATA_TYPE_UINT64: {
+            if (isUnsignedIntegerValue(value)) return value.asUInt64();
+            // Negative values may be compared as unsigned after the conversion
+            if (isSignedIntegerValue(value) && !value.isNegative()) return value.asUInt64();
+            return std::nullopt;
+        }
+
+        case COLUMN_DATA_TYPE_FLOAT:
+        case COLUMN_DATA_TYPE_DOUBLE: {
+            if (value.isFloatingPoint()) return getFloatingPointKey(value.asDouble());
+            if (isSignedIntegerValue(value)) {
+                const auto v = value.asInt64();
+                if (v >= -kMaxExactFloatInteger && v <= kMaxExactFloatInteger)
+                    return getFloatingPointKey(static_cast<double>(v));
+            } else if (isUnsignedIntegerValue(value)) {
+                const auto v = value.asUInt64();
+                if (v <= static_cast<std::uint64_t>(kMaxExactFloatInteger))
+                    return getFloatingPointKey(static_cast<double>(v));
+            }
+            return std::nullopt;
+        }
+
+        case COLUMN_DATA_TYPE_TIMESTAMP: {
+            if (value.isDateTime()) return getDateTimeKey(value.getDateTime());
+            if (value.isString()) {
+                try {
+                    return getDateTimeKey(value.asDateTime());
+                } catch (std::exception&) {
+                    return std::nullopt;
+                }
+            }
+            return std::nullopt;
+        }
+
+        default: return std::nullopt;
+    }
+}
+
+}  // namespace siodb::iomgr::dbengine
@@ -0,0 +1,131 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Common project headers
+#include <siodb/common/proto/ColumnDataType.pb.h>
+
+// CRT headers
+#include <cstdint>
+
+// STL headers
+#include <limits>
+#include <optional>
+
+namespace siodb::iomgr::dbengine {
+
+class Variant;
+
+/**
+ * Summary of values stored in the column data block. Values are represented
+ * by order preserving unsigned integer keys, so that summaries of all supported
+ * data types are handled in the same way.
+ * POD type.
+ */
+struct ColumnDataBlockZoneMap {
+    /** Initializes ColumnDataBlockZoneMap */
+    ColumnDataBlockZoneMap() noexcept
+        : m_complete(true)
+        , m_minValue(std::numeric_limits<std::uint64_t>::max())
+        , m_maxValue(0)
+        , m_nullCount(0)
+        , m_minTrid(std::numeric_limits<std::uint64_t>::max())
+        , m_maxTrid(0)
+    {
+    }
+
+    /**
+     * Returns indication that block contains at least one non-NULL value.
+     * @return true if block contains values, false otherwise.
+     */
+    bool hasValues() const noexcept
+    {
+        return m_minValue <= m_maxValue;
+    }
+
+    /**
+     * Accounts non-NULL value written into the block.
+     * @param key Value key.
+     * @param trid Table row ID of the value.
+     */
+    void addValue(std::uint64_t key, std::uint64_t trid) noexcept
+    {
+        if (key < m_minValue) m_minValue = key;
+        if (key > m_maxValue) m_maxValue = key;
+        if (trid < m_minTrid) m_minTrid = trid;
+        if (trid > m_maxTrid) m_maxTrid = trid;
+    }
+
+    /** Accounts NULL value. Counter saturates at the maximum value. */
+    void addNull() noexcept
+    {
+        if (m_nullCount != std::numeric_limits<std::uint32_t>::max()) ++m_nullCount;
+    }
+
+    /**
+     * Returns indication that block may contain values in the given range.
+     * @param minKey Minimum key, inclusive.
+     * @param maxKey Maximum key, inclusive.
+     * @return true if block may contain matching values, false if it surely doesn't.
+     */
+    bool mayContain(std::uint64_t minKey, std::uint64_t maxKey) const noexcept
+    {
+        return !m_complete || (m_minValue <= maxKey && minKey <= m_maxValue);
+    }
+
+    /**
+     * Indicates that summary covers all values of the block.
+     * Blocks written before summaries were introduced have incomplete summary.
+     */
+    bool m_complete;
+
+    /** Minimum value key */
+    std::uint64_t m_minValue;
+
+    /** Maximum value key */
+    std::uint64_t m_maxValue;
+
+    /** Number of NULL values */
+    std::uint32_t m_nullCount;
+
+    /** Minimum table row ID of non-NULL values */
+    std::uint64_t m_minTrid;
+
+    /** Maximum table row ID of non-NULL values */
+    std::uint64_t m_maxTrid;
+
+    /** Serialized size */
+    static constexpr const std::size_t kSerializedSize = sizeof(m_complete) + sizeof(m_minValue)
+                                                         + sizeof(m_maxValue) + sizeof(m_nullCount)
+                                                         + sizeof(m_minTrid) + sizeof(m_maxTrid);
+};
+
+/**
+ * Returns indication that zone map summaries are maintained for the given data type.
+ * @param dataType Column data type.
+ * @return true if zone maps are maintained, false otherwise.
+ */
+bool isZoneMapSupported(ColumnDataType dataType) noexcept;
+
+/**
+ * Computes order preserving key of the value stored in the column.
+ * @param dataType Column data type.
+ * @param value Value of the column data type.
+ * @return Value key or nothing if value is not comparable (NaN) or data type is not supported.
+ */
+std::optional<std::uint64_t> getZoneMapKey(ColumnDataType dataType, const Variant& value);
+
+/**
+ * Computes order preserving key of the constant which is compared with column value.
+ * Key is computed only if comparisons of column values with the constant
+ * are consistent with the order of their keys.
+ * @param dataType Column data type.
+ * @param value Constant value.
+ * @return Value key or nothing if the constant can't be used to check zone maps.
+ */
+std::optional<std::uint64_t> getZoneMapKeyForConstant(
+        ColumnDataType dataType, const Variant& value);
+
+}  // namespace siodb::iomgr::dbengine
@@ -0,0 +1,566 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "ColumnDataEncoding.h"
+
+// Common project headers
+#include <siodb/common/utils/PlainBinaryEncoding.h>
+
+// CRT headers
+#include <cstring>
+
+// STL headers
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+// System headers
+#include <endian.h>
+
+// zlib
+#include <zlib.h>
+
+namespace siodb::iomgr::dbengine {
+
+namespace {
+
+/** Maximum width of a bit-packed value. Allows unpacking any value with single 64-bit load. */
+constexpr unsigned kMaxPackedBitWidth = 56;
+
+/** Padding after bit-packed data, so that unpacking never reads beyond encoded data */
+constexpr std::size_t kPackedDataPadding = sizeof(std::uint64_t);
+
+/** Maximum number of distinct values in the dictionary */
+constexpr std::size_t kMaxDictionarySize = 65536;
+
+/** zlib compression level. Blocks are compressed on the write path, so speed matters most. */
+constexpr int kZlibCompressionLevel = Z_BEST_SPEED;
+
+/** Sign bit of 64-bit value */
+constexpr std::uint64_t kSignBit = std::uint64_t(1) << 63;
+
+/** Size of the frame header: base value and bit width */
+constexpr std::size_t kFrameHeaderSize = sizeof(std::uint64_t) + sizeof(std::uint8_t);
+
+/** Sequential reader of the encoded data with bounds checking */
+class EncodedDataReader {
+public:
+    /**
+     * Initializes object of class EncodedDataReader.
+     * @param data Encoded data.
+     * @param size Encoded data size.
+     */
+    EncodedDataReader(const std::uint8_t* data, std::size_t size) noexcept
+        : m_pos(data)
+        , m_end(data + size)
+    {
+    }
+
+    /**
+     * Returns indication that all data has been read.
+     * @return true if all data has been read, false otherwise.
+     */
+    bool isAtEnd() const noexcept
+    {
+        return m_pos == m_end;
+    }
+
+    /**
+     * Reads 32-bit value.
+     * @param[out] value Value.
+     * @return true on success, false if there is not enough data.
+     */
+    bool readUInt32(std::uint32_t& value) noexcept
+    {
+        if (getRemaining() < sizeof(value)) return false;
+        m_pos = ::pbeDecodeUInt32(m_pos, &value);
+        return true;
+    }
+
+    /**
+     * Reads frame header.
+     * @param[out] base Base value.
+     * @param[out] bitWidth Bit width of the packed values.
+     * @return true on success, false if there is not enough data or header is invalid.
+     */
+    bool readFrameHeader(std::uint64_t& base, unsigned& bitWidth) noexcept
+    {
+        if (getRemaining() < kFrameHeaderSize) return false;
+        m_pos = ::pbeDecodeUInt64(m_pos, &base);
+        bitWidth = *m_pos++;
+        return bitWidth <= kMaxPackedBitWidth;
+    }
+
+    /**
+     * Skips bit-packed data.
+     * @param size Size of bit-packed data including padding.
+     * @return Beginning of bit-packed data or nullptr if there is not enough data.
+     */
+    const std::uint8_t* skip(std::size_t size) noexcept
+    {
+        if (getRemaining() < size) return nullptr;
+        const auto result = m_pos;
+        m_pos += size;
+        return result;
+    }
+
+private:
+    /**
+     * Returns remaining data size.
+     * @return Remaining data size.
+     */
+    std::size_t getRemaining() const noexcept
+    {
+        return m_end - m_pos;
+    }
+
+private:
+    /** Current read position */
+    const std::uint8_t* m_pos;
+
+    /** End of data */
+    const std::uint8_t* const m_end;
+};
+
+/**
+ * Converts value between little endian and host byte order.
+ * @param value Value.
+ * @return Converted value.
+ */
+inline std::uint8_t convertLittleEndian(std::uint8_t value) noexcept
+{
+    return value;
+}
+
+/**
+ * Converts value between little endian and host byte order.
+ * @param value Value.
+ * @return Converted value.
+ */
+inline std::uint16_t convertLittleEndian(std::uint16_t value) noexcept
+{
+    return le16toh(value);
+}
+
+/**
+ * Converts value between little endian and host byte order.
+ * @param value Value.
+ * @return Converted value.
+ */
+inline std::uint32_t convertLittleEndian(std::uint32_t value) noexcept
+{
+    return le32toh(value);
+}
+
+/**
+ * Converts value between little endian and host byte order.
+ * @param value Value.
+ * @return Converted value.
+ */
+inline std::uint64_t convertLittleEndian(std::uint64_t value) noexcept
+{
+    return le64toh(value);
+}
+
+/**
+ * Loads values into 64-bit unsigned integers. Signed values are mapped
+ * into unsigned range so that their order is preserved.
+ * @param data Values in the plain binary encoding.
+ * @param count Number of values.
+ * @param isSigned Indicates that values are signed.
+ * @param[out] values Loaded values.
+ */
+template<class UnsignedType>
+void loadValues(const std::uint8_t* data, std::size_t count, bool isSigned,
+        std::uint64_t* values) noexcept
+{
+    using SignedType = std::make_signed_t<UnsignedType>;
+    for (std::size_t i = 0; i < count; ++i) {
+        UnsignedType value;
+        std::memcpy(&value, data + i * sizeof(value), sizeof(value));
+        value = convertLittleEndian(value);
+        values[i] = isSigned ? static_cast<std::uint64_t>(
+                                       static_cast<std::int64_t>(static_cast<SignedType>(value)))
+                                       ^ kSignBit
+                             : value;
+    }
+}
+
+/**
+ * Stores values loaded by loadValues() back in the plain binary encoding.
+ * @param values Values.
+ * @param count Number of values.
+ * @param isSigned Indicates that values are signed.
+ * @param[out] data Output buffer.
+ */
+template<class UnsignedType>
+void storeValues(const std::uint64_t* values, std::size_t count, bool isSigned,
+        std::uint8_t* data) noexcept
+{
+    const auto signBit = isSigned ? kSignBit : 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto value = convertLittleEndian(static_cast<UnsignedType>(values[i] ^ signBit));
+        std::memcpy(data + i * sizeof(value), &value, sizeof(value));
+    }
+}
+
+/**
+ * Computes number of bits required to represent value.
+ * @param value Value.
+ * @return Number of significant bits.
+ */
+inline unsigned getBitWidth(std::uint64_t value) noexcept
+{
+    return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+
+/**
+ * Computes size of bit-packed data.
+ * @param count Number of values.
+ * @param bitWidth Bit width of a single value.
+ * @return Size of bit-packed data including padding.
+ */
+inline std::size_t getPackedSize(std::size_t count, unsigned bitWidth) noexcept
+{
+    return (count * bitWidth + 7) / 8 + kPackedDataPadding;
+}
+
+/**
+ * Appends frame of values: minimum value followed by bit-packed differences from it.
+ * @param values Values.
+ * @param count Number of values.
+ * @param[out] out Output buffer.
+ * @return true on success, false if value range is too wide for bit-packing.
+ */
+bool appendFrame(const std::uint64_t* values, std::size_t count, std::vector<std::uint8_t>& out)
+{
+    const auto [minIt, maxIt] = std::minmax_element(values, values + count);
+    const auto base = count > 0 ? *minIt : 0;
+    const auto bitWidth = count > 0 ? getBitWidth(*maxIt - base) : 0;
+    if (bitWidth > kMaxPackedBitWidth) return false;
+
+    const auto headerPos = out.size();
+    out.resize(headerPos + kFrameHeaderSize + getPackedSize(count, bitWidth), 0);
+    auto p = ::pbeEncodeUInt64(base, out.data() + headerPos);
+    *p++ = static_cast<std::uint8_t>(bitWidth);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto bitPos = i * bitWidth;
+        std::uint64_t word;
+        std::memcpy(&word, p + (bitPos >> 3), sizeof(word));
+        word = convertLittleEndian(convertLittleEndian(word) | ((values[i] - base) << (bitPos & 7)));
+        std::memcpy(p + (bitPos >> 3), &word, sizeof(word));
+    }
+    return true;
+}
+
+/**
+ * Reads frame of values written by appendFrame().
+ * Unpacking loop has no dependencies between iterations, so compiler can vectorize it.
+ * @param reader Encoded data reader.
+ * @param count Number of values.
+ * @param[out] values Output values.
+ * @return true on success, false if encoded data is corrupted.
+ */
+bool readFrame(EncodedDataReader& reader, std::size_t count, std::uint64_t* values) noexcept
+{
+    std::uint64_t base = 0;
+    unsigned bitWidth = 0;
+    if (!reader.readFrameHeader(base, bitWidth)) return false;
+    const auto p = reader.skip(getPackedSize(count, bitWidth));
+    if (!p) return false;
+    const auto mask = (std::uint64_t(1) << bitWidth) - 1;
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto bitPos = i * bitWidth;
+        std::uint64_t word;
+        std::memcpy(&word, p + (bitPos >> 3), sizeof(word));
+        values[i] = ((convertLittleEndian(word) >> (bitPos & 7)) & mask) + base;
+    }
+    return true;
+}
+
+/**
+ * Encodes values using frame of reference encoding.
+ * @param values Values.
+ * @param[out] out Output buffer.
+ * @return true on success, false if values can't be encoded.
+ */
+bool encodeFrameOfReference(const std::vector<std::uint64_t>& values, std::vector<std::uint8_t>& out)
+{
+    return appendFrame(values.data(), values.size(), out);
+}
+
+/**
+ * Decodes values encoded with frame of reference encoding.
+ * @param reader Encoded data reader.
+ * @param[out] values Output values.
+ * @return true on success, false if encoded data is corrupted.
+ */
+bool decodeFrameOfReference(EncodedDataReader& reader, std::vector<std::uint64_t>& values) noexcept
+{
+    return readFrame(reader, values.size(), values.data());
+}
+
+/**
+ * Encodes values using delta encoding. Differences are mapped into unsigned range
+ * preserving their order, so that both ascending and descending sequences pack well.
+ * @param values Values.
+ * @param[out] out Output buffer.
+ * @return true on success, false if values can't be encoded.
+ */
+bool encodeDelta(const std::vector<std::uint64_t>& values, std::vector<std::uint8_t>& out)
+{
+    std::vector<std::uint64_t> deltas(values.size());
+    deltas[0] = values[0];
+    for (std::size_t i = 1; i < values.size(); ++i)
+        deltas[i] = (values[i] - values[i - 1]) ^ kSignBit;
+    out.resize(sizeof(std::uint64_t));
+    ::pbeEncodeUInt64(deltas[0], out.data());
+    return appendFrame(deltas.data() + 1, deltas.size() - 1, out);
+}
+
+/**
+ * Decodes values encoded with delta encoding.
+ * @param reader Encoded data reader.
+ * @param[out] values Output values.
+ * @return true on success, false if encoded data is corrupted.
+ */
+bool decodeDelta(EncodedDataReader& reader, std::vector<std::uint64_t>& values) noexcept
+{
+    const auto p = reader.skip(sizeof(std::uint64_t));
+    if (!p) return false;
+    ::pbeDecodeUInt64(p, &values[0]);
+    if (!readFrame(reader, values.size() - 1, values.data() + 1)) return false;
+    for (std::size_t i = 1; i < values.size(); ++i)
+        values[i] = values[i - 1] + (values[i] ^ kSignBit);
+    return true;
+}
+
+/**
+ * Encodes values using run-length encoding.
+ * @param values Values.
+ * @param[out] out Output buffer.
+ * @return true on success, false if values can't be encoded.
+ */
+bool encodeRunLength(const std::vector<std::uint64_t>& values, std::vector<std::uint8_t>& out)
+{
+    std::vector<std::uint64_t> runValues, runLengths;
+    for (std::size_t i = 0; i < values.size();) {
+        std::size_t j = i + 1;
+        while (j < values.size() && values[j] == values[i])
+            ++j;
+        runValues.push_back(values[i]);
+        runLengths.push_back(j - i);
+        i = j;
+    }
+    out.resize(sizeof(std::uint32_t));
+    ::pbeEncodeUInt32(static_cast<std::uint32_t>(runValues.size()), out.data());
+    return appendFrame(runValues.data(), runValues.size(), out)
+           && appendFrame(runLengths.data(), runLengths.size(), out);
+}
+
+/**
+ * Decodes values encoded with run-length encoding.
+ * @param reader Encoded data reader.
+ * @param[out] values Output values.
+ * @return true on success, false if encoded data is corrupted.
+ */
+bool decodeRunLength(EncodedDataReader& reader, std::vector<std::uint64_t>& values)
+{
+    std::uint32_t runCount = 0;
+    if (!reader.readUInt32(runCount) || runCount == 0 || runCount > values.size()) return false;
+    std::vector<std::uint64_t> runValues(runCount), runLengths(runCount);
+    if (!readFrame(reader, runCount, runValues.data())
+            || !readFrame(reader, runCount, runLengths.data()))
+        return false;
+    std::size_t pos = 0;
+    for (std::uint32_t i = 0; i < runCount; ++i) {
+        if (runLengths[i] > values.size() - pos) return false;
+        std::fill_n(values.begin() + pos, runLengths[i], runValues[i]);
+        pos += runLengths[i];
+    }
+    return pos == values.size();
+}
+
+/**
+ * Encodes values using dictionary encoding.
+ * @param values Values.
+ * @param[out] out Output buffer.
+ * @return true on success, false if values can't be encoded.
+ */
+bool encodeDictionary(const std::vector<std::uint64_t>& values, std::vector<std::uint8_t>& out)
+{
+    auto dictionary = values;
+    std::sort(dictionary.begin(), dictionary.end());
+    dictionary.erase(std::unique(dictionary.begin(), dictionary.end()), dictionary.end());
+    if (dictionary.size() > kMaxDictionarySize) return false;
+
+    std::vector<std::uint64_t> indices(values.size());
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        indices[i] = std::lower_bound(dictionary.begin(), dictionary.end(), values[i])
+                     - dictionary.begin();
+    }
+
+    out.resize(sizeof(std::uint32_t));
+    ::pbeEncodeUInt32(static_cast<std::uint32_t>(dictionary.size()), out.data());
+    return appendFrame(dictionary.data(), dictionary.size(), out)
+           && appendFrame(indices.data(), indices.size(), out);
+}
+
+/**
+ * Decodes values encoded with dictionary encoding.
+ * @param reader Encoded data reader.
+ * @param[out] values Output values.
+ * @return true on success, false if encoded data is corrupted.
+ */
+bool decodeDictionary(EncodedDataReader& reader, std::vector<std::uint64_t>& values)
+{
+    std::uint32_t dictionarySize = 0;
+    if (!reader.readUInt32(dictionarySize) || dictionarySize == 0
+            || dictionarySize > kMaxDictionarySize)
+        return false;
+    std::vector<std::uint64_t> dictionary(dictionarySize);
+    if (!readFrame(reader, dictionarySize, dictionary.data())
+            || !readFrame(reader, values.size(), values.data()))
+        return false;
+    for (auto& value : values) {
+        if (value >= dictionarySize) return false;
+        value = dictionary[value];
+    }
+    return true;
+}
+
+/**
+ * Loads values of the given size into 64-bit unsigned integers.
+ * @param data Values in the plain binary encoding.
+ * @param count Number of values.
+ * @param valueSize Size of a single value.
+ * @param isSigned Indicates that values are signed.
+ * @param[out] values Loaded values.
+ * @return true on success, false if value size is not supported.
+ */
+bool loadValues(const std::uint8_t* data, std::size_t count, unsigned valueSize, bool isSigned,
+        std::uint64_t* values) noexcept
+{
+    switch (valueSize) {
+        case 1: loadValues<std::uint8_t>(data, count, isSigned, values); return true;
+        case 2: loadValues<std::uint16_t>(data, count, isSigned, values); return true;
+        case 4: loadValues<std::uint32_t>(data, count, isSigned, values); return true;
+        case 8: loadValues<std::uint64_t>(data, count, isSigned, values); return true;
+        default: return false;
+    }
+}
+
+/**
+ * Stores values of the given size in the plain binary encoding.
+ * @param values Values.
+ * @param count Number of values.
+ * @param valueSize Size of a single value.
+ * @param isSigned Indicates that values are signed.
+ * @param[out] data Output buffer.
+ * @return true on success, false if value size is not supported.
+ */
+bool storeValues(const std::uint64_t* values, std::size_t count, unsigned valueSize,
+        bool isSigned, std::uint8_t* data) noexcept
+{
+    switch (valueSize) {
+        case 1: storeValues<std::uint8_t>(values, count, isSigned, data); return true;
+        case 2: storeValues<std::uint16_t>(values, count, isSigned, data); return true;
+        case 4: storeValues<std::uint32_t>(values, count, isSigned, data); return true;
+        case 8: storeValues<std::uint64_t>(values, count, isSigned, data); return true;
+        default: return false;
+    }
+}
+
+}  // anonymous namespace
+
+ColumnDataEncoding encodeIntegerColumnData(const std::uint8_t* data, std::size_t count,
+        unsigned valueSize, bool isSigned, std::vector<std::uint8_t>& encodedData)
+{
+    encodedData.clear();
+    if (count == 0) return ColumnDataEncoding::kPlain;
+
+    std::vector<std::uint64_t> values(count);
+    if (!loadValues(data, count, valueSize, isSigned, values.data()))
+        return ColumnDataEncoding::kPlain;
+
+    using Encoder = bool (*)(const std::vector<std::uint64_t>&, std::vector<std::uint8_t>&);
+    static constexpr std::pair<ColumnDataEncoding, Encoder> kEncoders[] = {
+            {ColumnDataEncoding::kRunLength, &encodeRunLength},
+            {ColumnDataEncoding::kFrameOfReference, &encodeFrameOfReference},
+            {ColumnDataEncoding::kDelta, &encodeDelta},
+            {ColumnDataEncoding::kDictionary, &encodeDictionary},
+    };
+
+    auto bestEncoding = ColumnDataEncoding::kPlain;
+    std::size_t bestSize = count * valueSize;
+    std::vector<std::uint8_t> buffer;
+    for (const auto& [encoding, encoder] : kEncoders) {
+        buffer.clear();
+        if (!encoder(values, buffer) || buffer.size() >= bestSize) continue;
+        bestEncoding = encoding;
+        bestSize = buffer.size();
+        encodedData.swap(buffer);
+    }
+
+    if (bestEncoding == ColumnDataEncoding::kPlain) encodedData.clear();
+    return bestEncoding;
+}
+
+bool decodeIntegerColumnData(ColumnDataEncoding encoding, const std::uint8_t* encodedData,
+        std::size_t encodedDataSize, std::size_t count, unsigned valueSize, bool isSigned,
+        std::uint8_t* data)
+{
+    if (encoding == ColumnDataEncoding::kPlain) {
+        if (encodedDataSize != count * valueSize) return false;
+        std::memcpy(data, encodedData, encodedDataSize);
+        return true;
+    }
+
+    if (count == 0) return false;
+
+    std::vector<std::uint64_t> values(count);
+    EncodedDataReader reader(encodedData, encodedDataSize);
+    bool decoded = false;
+    switch (encoding) {
+        case ColumnDataEncoding::kDelta: decoded = decodeDelta(reader, values); break;
+        case ColumnDataEncoding::kFrameOfReference: {
+            decoded = decodeFrameOfReference(reader, values);
+            break;
+        }
+        case ColumnDataEncoding::kRunLength: decoded = decodeRunLength(reader, values); break;
+        case ColumnDataEncoding::kDictionary: decoded = decodeDictionary(reader, values); break;
+        default: break;
+    }
+    return decoded && reader.isAtEnd()
+           && storeValues(values.data(), count, valueSize, isSigned, data);
+}
+
+ColumnDataEncoding compressColumnData(CompressionType compressionType, const std::uint8_t* data,
+        std::size_t size, std::vector<std::uint8_t>& compressedData)
+{
+    compressedData.clear();
+    if (compressionType != CompressionType::kZlib || size == 0) return ColumnDataEncoding::kPlain;
+
+    compressedData.resize(::compressBound(size));
+    auto compressedSize = static_cast<uLongf>(compressedData.size());
+    if (::compress2(compressedData.data(), &compressedSize, data, size, kZlibCompressionLevel)
+                    != Z_OK
+            || compressedSize >= size) {
+        compressedData.clear();
+        return ColumnDataEncoding::kPlain;
+    }
+    compressedData.resize(compressedSize);
+    return ColumnDataEncoding::kZlib;
+}
+
+bool decompressColumnData(ColumnDataEncoding encoding, const std::uint8_t* compressedData,
+        std::size_t compressedDataSize, std::uint8_t* data, std::size_t size)
+{
+    if (encoding != ColumnDataEncoding::kZlib) return false;
+    auto decompressedSize = static_cast<uLongf>(size);
+    return ::uncompress(data, &decompressedSize, compressedData, compressedDataSize) == Z_OK
+           && decompressedSize == size;
+}
+
+}  // namespace siodb::iomgr::dbengine
@@ -0,0 +1,104 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "CompressionType.h"
+
+// CRT headers
+#include <cstdint>
+
+// STL headers
+#include <vector>
+
+namespace siodb::iomgr::dbengine {
+
+/** Encoding of the data area of a closed column data block */
+enum class ColumnDataEncoding : std::uint8_t {
+    /** Values are stored as is */
+    kPlain = 0,
+
+    /** First value followed by bit-packed differences between adjacent values */
+    kDelta = 1,
+
+    /** Minimum value followed by bit-packed differences from it */
+    kFrameOfReference = 2,
+
+    /** Bit-packed run values followed by bit-packed run lengths */
+    kRunLength = 3,
+
+    /** Sorted bit-packed distinct values followed by bit-packed value indices */
+    kDictionary = 4,
+
+    /** Data compressed with zlib */
+    kZlib = 5,
+
+    /** Number of encodings, must be last */
+    kMax
+};
+
+/**
+ * Encodes fixed width integer values using the most compact of the lightweight encodings.
+ * @param data Values in the plain binary encoding.
+ * @param count Number of values.
+ * @param valueSize Size of a single value: 1, 2, 4 or 8 bytes.
+ * @param isSigned Indicates that values are signed.
+ * @param[out] encodedData Encoded data.
+ * @return Selected encoding, ColumnDataEncoding::kPlain if none of encodings
+ *         produces data smaller than the original data.
+ */
+ColumnDataEncoding encodeIntegerColumnData(const std::uint8_t* data, std::size_t count,
+        unsigned valueSize, bool isSigned, std::vector<std::uint8_t>& encodedData);
+
+/**
+ * Decodes fixed width integer values back into the plain binary encoding.
+ * @param encoding Encoding of the data.
+ * @param encodedData Encoded data.
+ * @param encodedDataSize Encoded data size.
+ * @param count Number of values.
+ * @param valueSize Size of a single value: 1, 2, 4 or 8 bytes.
+ * @param isSigned Indicates that values are signed.
+ * @param[out] data Output buffer of count * valueSize bytes.
+ * @return true if data decoded successfully, false if encoded data is corrupted.
+ */
+bool decodeIntegerColumnData(ColumnDataEncoding encoding, const std::uint8_t* encodedData,
+        std::size_t encodedDataSize, std::size_t count, unsigned valueSize, bool isSigned,
+        std::uint8_t* data);
+
+/**
+ * Returns indication that encoding is a general purpose compression.
+ * @param encoding Encoding.
+ * @return true if encoding is a compression, false otherwise.
+ */
+inline bool isCompressedColumnDataEncoding(ColumnDataEncoding encoding) noexcept
+{
+    return encoding == ColumnDataEncoding::kZlib;
+}
+
+/**
+ * Compresses data using general purpose compression.
+ * @param compressionType Compression type.
+ * @param data Data.
+ * @param size Data size.
+ * @param[out] compressedData Compressed data.
+ * @return Encoding of the compressed data, ColumnDataEncoding::kPlain
+ *         if data can't be compressed to the smaller size.
+ */
+ColumnDataEncoding compressColumnData(CompressionType compressionType, const std::uint8_t* data,
+        std::size_t size, std::vector<std::uint8_t>& compressedData);
+
+/**
+ * Decompresses data compressed by compressColumnData().
+ * @param encoding Encoding of the compressed data.
+ * @param compressedData Compressed data.
+ * @param compressedDataSize Compressed data size.
+ * @param[out] data Output buffer.
+ * @param size Exact size of the original data.
+ * @return true if data decompressed successfully, false if compressed data is corrupted.
+ */
+bool decompressColumnData(ColumnDataEncoding encoding, const std::uint8_t* compressedData,
+        std::size_t compressedDataSize, std::uint8_t* data, std::size_t size);
+
+}  // namespace siodb::iomgr::dbengine
@@ -0,0 +1,423 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "ColumnSegmentStore.h"
+
+// Project headers
+#include <siodb-generated/iomgr/lib/messages/IOManagerMessageId.h>
+#include "BlockRegistry.h"
+#include "Column.h"
+#include "ColumnDataBlockHeader.h"
+#include "Database.h"
+#include "Instance.h"
+#include "ThrowDatabaseError.h"
+
+// Common project headers
+#include <siodb/common/config/SiodbDefs.h>
+#include <siodb/common/io/FileIO.h>
+#include <siodb/common/log/Log.h>
+#include <siodb/common/stl_wrap/filesystem_wrapper.h>
+#include <siodb/common/utils/Align.h>
+#include <siodb/common/utils/FsUtils.h>
+#include <siodb/common/utils/PlainBinaryEncoding.h>
+#include <siodb/common/utils/StringBuilder.h>
+
+// CRT headers
+#include <cstring>
+
+// STL headers
+#include <algorithm>
+#include <stdexcept>
+
+// System headers
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace siodb::iomgr::dbengine {
+
+ColumnSegmentStore::ColumnSegmentStore(const Column& column, std::uint64_t segmentFileSize)
+    : m_column(column)
+    , m_segmentFileSize(std::max(utils::alignUp(segmentFileSize, kExtentAlignment),
+              utils::alignUp(static_cast<std::uint64_t>(column.getDataBlockDataAreaSize())
+                                     + ColumnDataBlockHeader::kDefaultDataAreaOffset,
+                      kExtentAlignment)))
+{
+    createOffsetTableFile();
+}
+
+ColumnSegmentStore::ColumnSegmentStore(const Column& column)
+    : m_column(column)
+    , m_segmentFileSize(0)
+{
+    openOffsetTableFile();
+    rebuildFreeSpace();
+}
+
+bool ColumnSegmentStore::exists(const Column& column)
+{
+    return fs::exists(utils::constructPath(
+            utils::constructPath(column.getDataDir(), BlockRegistry::kBlockRegistryDir),
+            kOffsetTableFileName, column.getId(), kDataFileExtension));
+}
+
+std::string ColumnSegmentStore::makeSegmentFilePath(std::uint32_t segmentId) const
+{
+    return utils::constructPath(
+            m_column.getDataDir(), kSegmentFilePrefix, segmentId, kDataFileExtension);
+}
+
+std::uint64_t ColumnSegmentStore::getFirstBlockId() const
+{
+    std::lock_guard lock(m_mutex);
+    for (std::uint64_t blockId = 1; blockId < m_extents.size(); ++blockId) {
+        if (m_extents[blockId].isValid()) return blockId;
+    }
+    return 0;
+}
+
+ColumnDataExtent ColumnSegmentStore::getExtent(std::uint64_t blockId) const
+{
+    std::lock_guard lock(m_mutex);
+    if (blockId >= m_extents.size() || !m_extents[blockId].isValid()) {
+        throwDatabaseError(IOManagerMessageId::kErrorColumnDataBlockDoesNotExist,
+                m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(), blockId,
+                m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId());
+    }
+    return m_extents[blockId];
+}
+
+ColumnDataExtent ColumnSegmentStore::allocateExtent(std::uint64_t size)
+{
+    size = utils::alignUp(size, kExtentAlignment);
+    if (size == 0 || size > m_segmentFileSize) {
+        throw std::invalid_argument(utils::StringBuilder()
+                                    << "Column " << m_column.getDisplayName()
+                                    << ": Invalid extent size " << size);
+    }
+
+    std::lock_guard lock(m_mutex);
+
+    // First fit, so that the beginning of the segment files is filled densely
+    for (std::size_t i = 0; i < m_segments.size(); ++i) {
+        auto& freeRanges = m_segments[i].m_freeRanges;
+        for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+            if (it->second < size) continue;
+            const ColumnDataExtent extent(static_cast<std::uint32_t>(i + 1), it->first, size);
+            const auto remainingSize = it->second - size;
+            freeRanges.erase(it);
+            if (remainingSize > 0) freeRanges.emplace(extent.m_offset + size, remainingSize);
+            return extent;
+        }
+    }
+
+    const auto segmentId = createSegmentUnlocked();
+    auto& freeRanges = m_segments[segmentId - 1].m_freeRanges;
+    freeRanges.clear();
+    if (m_segmentFileSize > size) freeRanges.emplace(size, m_segmentFileSize - size);
+    return ColumnDataExtent(segmentId, 0, size);
+}
+
+void ColumnSegmentStore::releaseExtent(const ColumnDataExtent& extent)
+{
+    std::lock_guard lock(m_mutex);
+    releaseExtentUnlocked(extent);
+}
+
+void ColumnSegmentStore::recordExtent(std::uint64_t blockId, const ColumnDataExtent& extent)
+{
+    std::uint8_t buffer[kRecordSize];
+    std::memset(buffer, 0, sizeof(buffer));
+    auto p = buffer;
+    *p++ = 1;  // "present" flag
+    p = ::pbeEncodeUInt32(extent.m_segmentId, p);
+    p = ::pbeEncodeUInt64(extent.m_offset, p);
+    ::pbeEncodeUInt64(extent.m_size, p);
+
+    // Offset table is written synchronously, so logged extent data must become durable first
+    m_column.commitWriteAheadLog();
+
+    std::lock_guard lock(m_mutex);
+    const off_t recordOffset = blockId * kRecordSize;
+    if (::pwriteExact(m_offsetTableFile.getFd(), buffer, sizeof(buffer), recordOffset,
+                kIgnoreSignals)
+            != sizeof(buffer)) {
+        const int errorCode = errno;
+        throwDatabaseError(IOManagerMessageId::kErrorCannotWriteSegmentOffsetTableFile,
+                m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(),
+                m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(),
+                recordOffset, sizeof(buffer), errorCode, std::strerror(errorCode));
+    }
+
+    if (blockId >= m_extents.size()) m_extents.resize(blockId + 1);
+    // Previous extent is not used anymore
+    if (m_extents[blockId].isValid()) releaseExtentUnlocked(m_extents[blockId]);
+    m_extents[blockId] = extent;
+}
+
+io::FileSharedPtr ColumnSegmentStore::getSegmentFile(std::uint32_t segmentId) const
+{
+    std::lock_guard lock(m_mutex);
+    return getSegmentFileUnlocked(segmentId);
+}
+
+void ColumnSegmentStore::readAhead(std::uint64_t blockId) const noexcept
+{
+    try {
+        std::lock_guard lock(m_mutex);
+        if (blockId >= m_extents.size() || !m_extents[blockId].isValid()) return;
+        const auto& extent = m_extents[blockId];
+        const auto file = getSegmentFileUnlocked(extent.m_segmentId);
+        ::posix_fadvise(file->getFd(), extent.m_offset, extent.m_size, POSIX_FADV_WILLNEED);
+    } catch (std::exception& ex) {
+        // Not critical, block will be read when needed
+        LOG_DEBUG << "Column " << m_column.getDisplayName() << ": Can't read ahead block "
+                  << blockId << ": " << ex.what();
+    }
+}
+
+// ---- internals ----
+
+std::string ColumnSegmentStore::makeOffsetTableFilePath() const
+{
+    return utils::constructPath(
+            utils::constructPath(m_column.getDataDir(), BlockRegistry::kBlockRegistryDir),
+            kOffsetTableFileName, m_column.getId(), kDataFileExtension);
+}
+
+void ColumnSegmentStore::createOffsetTableFile()
+{
+    const auto offsetTableFilePath = makeOffsetTableFilePath();
+    FileDescriptorGuard offsetTableFile(::open(offsetTableFilePath.c_str(),
+            O_CREAT | O_TRUNC | O_CLOEXEC | O_DSYNC | O_RDWR, kDataFileCreationMode));
+    if (!offsetTableFile.isValidFd()) {
+        const int errorCode = errno;
+        throwDatabaseError(IOManagerMessageId::kErrorCannotCreateSegmentOffsetTableFile,
+                offsetTableFilePath, m_column.getDatabaseName(), m_column.getTableName(),
+                m_column.getName(), m_column.getDatabaseUuid(), m_column.getTableId(),
+                m_column.getId(), errorCode, std::strerror(errorCode));
+    }
+    m_offsetTableFile.swap(offsetTableFile);
+    m_extents.resize(1);
+    writeHeader();
+}
+
+void ColumnSegmentStore::openOffsetTableFile()
+{
+    const auto offsetTableFilePath = makeOffsetTableFilePath();
+    FileDescriptorGuard offsetTableFile(
+            ::open(offsetTableFilePath.c_str(), O_CLOEXEC | O_DSYNC | O_RDWR));
+    if (!offsetTableFile.isValidFd()) {
+        const int errorCode = errno;
+        throwDatabaseError(IOManagerMessageId::kErrorCannotOpenSegmentOffsetTableFile,
+                offsetTableFilePath, m_column.getDatabaseName(), m_column.getTableName(),
+                m_column.getName(), m_column.getDatabaseUuid(), m_column.getTableId(),
+                m_column.getId(), errorCode, std::strerror(errorCode));
+    }
+
+    const auto fileSize = ::lseek(offsetTableFile.getFd(), 0, SEEK_END);
+    if (fileSize < 0) {
+        const int errorCode = errno;
+        throwDatabaseError(IOManagerMessageId::kErrorCannotReadSegmentOffsetTableFile,
+                m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(),
+                m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(), 0, 0,
+                errorCode, std::strerror(errorCode));
+    }
+    if (fileSize == 0 || fileSize % kRecordSize != 0) {
+        throwDatabaseError(IOManagerMessageId::kErrorInvalidSegmentOffsetTableFile,
+                m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(),
+                m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(),
+                "invalid file size");
+    }
+
+    std::vector<std::uint8_t> buffer(fileSize);
+    if (::preadExact(offsetTableFile.getFd(), buffer.data(), buffer.size(), 0, kIgnoreSignals)
+            != buffer.size()) {
+        const int errorCode = errno;
+        throwDatabaseError(IOManagerMessageId::kErrorCannotReadSegmentOffsetTableFile,
+                m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(),
+                m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(), 0,
+                buffer.size(), errorCode, std::strerror(errorCode));
+    }
+
+    // Header occupies record of the non-existent block 0
+    std::uint32_t version = 0;
+    std::uint32_t segmentCount = 0;
+    auto p = ::pbeDecodeUInt32(buffer.data(), &version);
+    p = ::pbeDecodeUInt32(p, &segmentCount);
+    ::pbeDecodeUInt64(p, &m_segmentFileSize);
+    if (version > kOffsetTableVersion || m_segmentFileSize == 0
+            || m_segmentFileSize % kExtentAlignment != 0) {
+        throwDatabaseError(IOManagerMessageId::kErrorInvalidSegmentOffsetTableFile,
+                m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(),
+                m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(),
+                "invalid header");
+    }
+    m_segments.resize(segmentCount);
+    m_segmentFiles.resize(segmentCount);
+
+    const std::size_t recordCount = fileSize / kRecordSize;
+    m_extents.resize(recordCount);
+    for (std::size_t blockId = 1; blockId < recordCount; ++blockId) {
+        p = buffer.data() + blockId * kRecordSize;
+        if (*p++ == 0) continue;
+        auto& extent = m_extents[blockId];
+        p = ::pbeDecodeUInt32(p, &extent.m_segmentId);
+        p = ::pbeDecodeUInt64(p, &extent.m_offset);
+        ::pbeDecodeUInt64(p, &extent.m_size);
+        if (extent.m_segmentId == 0 || extent.m_segmentId > segmentCount || extent.m_size == 0
+                || extent.m_offset % kExtentAlignment != 0
+                || extent.m_offset + extent.m_size > m_segmentFileSize) {
+            throwDatabaseError(IOManagerMessageId::kErrorInvalidSegmentOffsetTableFile,
+                    m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(),
+                    m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(),
+                    "invalid extent of the block " + std::to_string(blockId));
+        }
+    }
+
+    m_offsetTableFile.swap(offsetTableFile);
+}
+
+void ColumnSegmentStore::writeHeader() const
+{
+    std::uint8_t buffer[kRecordSize];
+    std::memset(buffer, 0, sizeof(buffer));
+    auto p = ::pbeEncodeUInt32(kOffsetTableVersion, buffer);
+    p = ::pbeEncodeUInt32(static_cast<std::uint32_t>(m_segments.size()), p);
+    ::pbeEncodeUInt64(m_segmentFileSize, p);
+    if (::pwriteExact(m_offsetTableFile.getFd(), buffer, sizeof(buffer), 0, kIgnoreSignals)
+            != sizeof(buffer)) {
+        const int errorCode = errno;
+        throwDatabaseError(IOManagerMessageId::kErrorCannotWriteSegmentOffsetTableFile,
+                m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(),
+                m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(), 0,
+                sizeof(buffer), errorCode, std::strerror(errorCode));
+    }
+}
+
+void ColumnSegmentStore::rebuildFreeSpace()
+{
+    std::vector<std::vector<std::pair<std::uint64_t, std::uint64_t>>> usedRanges(
+            m_segments.size());
+    for (const auto& extent : m_extents) {
+        if (extent.isValid())
+            usedRanges[extent.m_segmentId - 1].emplace_back(extent.m_offset, extent.m_size);
+    }
+
+    for (std::size_t i = 0; i < m_segments.size(); ++i) {
+        auto& ranges = usedRanges[i];
+        std::sort(ranges.begin(), ranges.end());
+        auto& freeRanges = m_segments[i].m_freeRanges;
+        std::uint64_t offset = 0;
+        for (const auto& [usedOffset, usedSize] : ranges) {
+            if (usedOffset < offset) {
+                throwDatabaseError(IOManagerMessageId::kErrorInvalidSegmentOffsetTableFile,
+                        m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(),
+                        m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(),
+                        "overlapping extents in the segment " + std::to_string(i + 1));
+            }
+            if (usedOffset > offset) freeRanges.emplace(offset, usedOffset - offset);
+            offset = usedOffset + usedSize;
+        }
+        if (offset < m_segmentFileSize) freeRanges.emplace(offset, m_segmentFileSize - offset);
+    }
+}
+
+std::uint32_t ColumnSegmentStore::createSegmentUnlocked()
+{
+    const auto segmentId = static_cast<std::uint32_t>(m_segments.size() + 1);
+    const auto segmentFilePath = makeSegmentFilePath(segmentId);
+
+    LOG_DEBUG << "Column " << m_column.getDisplayName() << ": Creating segment " << segmentId
+              << ", " << (m_segmentFileSize / 1024) << " KiB";
+
+    // File may exist after crash, if segment wasn't recorded in the header
+    const auto wal = m_column.getWriteAheadLog();
+    const int extraOpenFlags =
+            (wal ? 0 : O_DSYNC) | m_column.getDatabase().getInstance().getDirectIoOpenFlags();
+    io::FilePtr file;
+    try {
+        file = m_column.getDatabase().createFile(segmentFilePath, extraOpenFlags | O_TRUNC,
+                kDataFileCreationMode, m_segmentFileSize);
+        // Allocated space must be durable before segment is recorded
+        if (wal && !file->flush()) {
+            const int errorCode = file->getLastError();
+            throw std::system_error(errorCode, std::generic_category());
+        }
+    } catch (std::system_error& ex) {
+        throwDatabaseError(IOManagerMessageId::kErrorCannotCreateSegmentFile, segmentFilePath,
+                m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(),
+                m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(),
+                ex.code().value(), std::strerror(ex.code().value()));
+    }
+
+    if (wal) file->enableWriteAheadLog(wal, segmentFilePath);
+    m_segments.emplace_back();
+    m_segmentFiles.push_back(std::move(file));
+    try {
+        writeHeader();
+    } catch (...) {
+        m_segments.pop_back();
+        m_segmentFiles.pop_back();
+        ::unlink(segmentFilePath.c_str());
+        throw;
+    }
+    return segmentId;
+}
+
+void ColumnSegmentStore::releaseExtentUnlocked(const ColumnDataExtent& extent)
+{
+    if (!extent.isValid() || extent.m_segmentId > m_segments.size()) return;
+    auto& freeRanges = m_segments[extent.m_segmentId - 1].m_freeRanges;
+    auto offset = extent.m_offset;
+    auto size = extent.m_size;
+
+    // Merge with the following range
+    auto it = freeRanges.lower_bound(offset);
+    if (it != freeRanges.end() && it->first == offset + size) {
+        size += it->second;
+        it = freeRanges.erase(it);
+    }
+
+    // Merge with the preceding range
+    if (it != freeRanges.begin()) {
+        const auto prev = std::prev(it);
+        if (prev->first + prev->second == offset) {
+            offset = prev->first;
+            size += prev->second;
+            freeRanges.erase(prev);
+        }
+    }
+
+    freeRanges.emplace(offset, size);
+}
+
+io::FileSharedPtr ColumnSegmentStore::getSegmentFileUnlocked(std::uint32_t segmentId) const
+{
+    if (segmentId == 0 || segmentId > m_segmentFiles.size()) {
+        throwDatabaseError(IOManagerMessageId::kErrorCannotOpenSegmentFile,
+                makeSegmentFilePath(segmentId), m_column.getDatabaseName(),
+                m_column.getTableName(), m_column.getName(), m_column.getDatabaseUuid(),
+                m_column.getTableId(), m_column.getId(), ENOENT, std::strerror(ENOENT));
+    }
+
+    auto& file = m_segmentFiles[segmentId - 1];
+    if (!file) {
+        const auto segmentFilePath = makeSegmentFilePath(segmentId);
+        const auto wal = m_column.getWriteAheadLog();
+        const int extraOpenFlags =
+                (wal ? 0 : O_DSYNC) | m_column.getDatabase().getInstance().getDirectIoOpenFlags();
+        try {
+            file = m_column.getDatabase().openFile(segmentFilePath, extraOpenFlags);
+            if (wal) file->enableWriteAheadLog(wal, segmentFilePath);
+        } catch (std::system_error& ex) {
+            throwDatabaseError(IOManagerMessageId::kErrorCannotOpenSegmentFile, segmentFilePath,
+                    m_column.getDatabaseName(), m_column.getTableName(), m_column.getName(),
+                    m_column.getDatabaseUuid(), m_column.getTableId(), m_column.getId(),
+                    ex.code().value(), std::strerror(ex.code().value()));
+        }
+    }
+    return file;
+}
+
+}  // namespace siodb::iomgr::dbengine
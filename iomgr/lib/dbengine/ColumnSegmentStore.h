@@ -0,0 +1,256 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "io/File.h"
+
+// Common project headers
+#include <siodb/common/utils/FileDescriptorGuard.h>
+#include <siodb/common/utils/HelperMacros.h>
+
+// STL headers
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace siodb::iomgr::dbengine {
+
+class Column;
+
+/** Location of the column data block in the segment file. POD type. */
+struct ColumnDataExtent {
+    /** Initializes ColumnDataExtent, which doesn't point to any location. */
+    ColumnDataExtent() noexcept
+        : m_segmentId(0)
+        , m_offset(0)
+        , m_size(0)
+    {
+    }
+
+    /**
+     * Initializes ColumnDataExtent.
+     * @param segmentId Segment ID.
+     * @param offset Offset in the segment file.
+     * @param size Extent size.
+     */
+    ColumnDataExtent(std::uint32_t segmentId, std::uint64_t offset, std::uint64_t size) noexcept
+        : m_segmentId(segmentId)
+        , m_offset(offset)
+        , m_size(size)
+    {
+    }
+
+    /**
+     * Returns indication that extent points to some location.
+     * @return true if extent points to some location, false otherwise.
+     */
+    bool isValid() const noexcept
+    {
+        return m_size != 0;
+    }
+
+    /** Segment ID, starting from 1 */
+    std::uint32_t m_segmentId;
+
+    /** Offset in the segment file */
+    std::uint64_t m_offset;
+
+    /** Extent size */
+    std::uint64_t m_size;
+};
+
+/**
+ * Storage of the column data blocks in the large preallocated segment files.
+ * Each block occupies an extent of a segment file. Extents of the blocks are recorded
+ * in the offset table file, which is located in the block registry directory.
+ * Records of the offset table are indexed by block ID, same as block registry records.
+ * Free space of the segment files is not recorded, it is rebuilt from the offset table
+ * when column is opened.
+ */
+class ColumnSegmentStore {
+public:
+    /** Segment file prefix */
+    static constexpr const char* kSegmentFilePrefix = "s";
+
+public:
+    /**
+     * Initializes object of class ColumnSegmentStore for a new column.
+     * @param column Column object.
+     * @param segmentFileSize Desired segment file size.
+     */
+    ColumnSegmentStore(const Column& column, std::uint64_t segmentFileSize);
+
+    /**
+     * Initializes object of class ColumnSegmentStore for an existing column.
+     * @param column Column object.
+     */
+    explicit ColumnSegmentStore(const Column& column);
+
+    DECLARE_NONCOPYABLE(ColumnSegmentStore);
+
+    /**
+     * Returns indication that column stores data blocks in the segment files.
+     * @param column Column object.
+     * @return true if column has segment offset table, false otherwise.
+     */
+    static bool exists(const Column& column);
+
+    /**
+     * Returns size of the segment files.
+     * @return Segment file size.
+     */
+    std::uint64_t getSegmentFileSize() const noexcept
+    {
+        return m_segmentFileSize;
+    }
+
+    /**
+     * Constructs segment file path.
+     * @param segmentId Segment ID.
+     * @return Segment file path.
+     */
+    std::string makeSegmentFilePath(std::uint32_t segmentId) const;
+
+    /**
+     * Returns lowest ID of the block which has an extent.
+     * @return Block ID or zero if there are no blocks.
+     */
+    std::uint64_t getFirstBlockId() const;
+
+    /**
+     * Returns extent of the block.
+     * @param blockId Block ID.
+     * @return Block extent.
+     * @throw DatabaseError if block has no extent.
+     */
+    ColumnDataExtent getExtent(std::uint64_t blockId) const;
+
+    /**
+     * Allocates new extent. Extent stays allocated until it is recorded
+     * or released. Creates new segment file if there is no enough free space.
+     * @param size Required size.
+     * @return New extent.
+     * @throw DatabaseError if new segment file can't be created.
+     */
+    ColumnDataExtent allocateExtent(std::uint64_t size);
+
+    /**
+     * Releases extent which was allocated, but not recorded.
+     * @param extent An extent.
+     */
+    void releaseExtent(const ColumnDataExtent& extent);
+
+    /**
+     * Records new extent of the block. Previous extent of the block, if any, is released.
+     * New extent must already contain block data, so that block is never pointed
+     * to the incomplete data.
+     * @param blockId Block ID.
+     * @param extent New block extent.
+     * @throw DatabaseError if offset table can't be written.
+     */
+    void recordExtent(std::uint64_t blockId, const ColumnDataExtent& extent);
+
+    /**
+     * Returns segment file. Segment file is opened on the first access
+     * and stays open while this object exists.
+     * @param segmentId Segment ID.
+     * @return Segment file.
+     * @throw DatabaseError if segment file can't be opened.
+     */
+    io::FileSharedPtr getSegmentFile(std::uint32_t segmentId) const;
+
+    /**
+     * Advises operating system to load block extent into the page cache.
+     * Errors are ignored.
+     * @param blockId Block ID.
+     */
+    void readAhead(std::uint64_t blockId) const noexcept;
+
+private:
+    /** Segment free space */
+    struct Segment {
+        /** Free ranges: offset -> size */
+        std::map<std::uint64_t, std::uint64_t> m_freeRanges;
+    };
+
+private:
+    /**
+     * Constructs offset table file path.
+     * @return Offset table file path.
+     */
+    std::string makeOffsetTableFilePath() const;
+
+    /** Creates offset table file. */
+    void createOffsetTableFile();
+
+    /** Opens offset table file and loads extents. */
+    void openOffsetTableFile();
+
+    /** Writes offset table header. */
+    void writeHeader() const;
+
+    /** Rebuilds free space of the segments from the block extents. */
+    void rebuildFreeSpace();
+
+    /**
+     * Creates new segment file.
+     * @return New segment ID.
+     */
+    std::uint32_t createSegmentUnlocked();
+
+    /**
+     * Returns free range to the segment, merges it with adjacent free ranges.
+     * @param extent An extent.
+     */
+    void releaseExtentUnlocked(const ColumnDataExtent& extent);
+
+    /**
+     * Returns segment file. Segment file is opened if it is not open yet.
+     * @param segmentId Segment ID.
+     * @return Segment file.
+     */
+    io::FileSharedPtr getSegmentFileUnlocked(std::uint32_t segmentId) const;
+
+private:
+    /** Column object */
+    const Column& m_column;
+
+    /** Offset table file */
+    FileDescriptorGuard m_offsetTableFile;
+
+    /** Segment file size */
+    std::uint64_t m_segmentFileSize;
+
+    /** Block extents, indexed by block ID */
+    std::vector<ColumnDataExtent> m_extents;
+
+    /** Segments, indexed by segment ID minus one */
+    std::vector<Segment> m_segments;
+
+    /** Open segment files, indexed by segment ID minus one */
+    mutable std::vector<io::FileSharedPtr> m_segmentFiles;
+
+    /** Synchronizes access to the extents and segments */
+    mutable std::mutex m_mutex;
+
+    /** Offset table file name prefix */
+    static constexpr const char* kOffsetTableFileName = "segtab";
+
+    /** Offset table format version */
+    static constexpr std::uint32_t kOffsetTableVersion = 1;
+
+    /**
+     * Offset table record size. Records don't cross disk sector boundaries,
+     * so that each record is updated atomically.
+     */
+    static constexpr std::size_t kRecordSize = 32;
+
+    /** Extent alignment, allows memory mapping of the extents */
+    static constexpr std::uint64_t kExtentAlignment = 4096;
+};
+
+}  // namespace siodb::iomgr::dbengine
@@ -0,0 +1,39 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "CompressionType.h"
+
+// STL headers
+#include <array>
+
+// Boost headers
+#include <boost/algorithm/string/predicate.hpp>
+
+namespace siodb::iomgr::dbengine {
+
+namespace {
+
+const std::array<const char*, static_cast<std::size_t>(CompressionType::kMax)>
+        g_compressionTypeNames {
+                "NONE",
+                "ZLIB",
+        };
+
+}  // namespace
+
+const char* getCompressionTypeName(CompressionType type)
+{
+    return g_compressionTypeNames.at(static_cast<std::size_t>(type));
+}
+
+std::optional<CompressionType> getCompressionType(const std::string& name)
+{
+    for (std::size_t i = 0; i < g_compressionTypeNames.size(); ++i) {
+        if (boost::iequals(name, g_compressionTypeNames[i]))
+            return static_cast<CompressionType>(i);
+    }
+    return std::nullopt;
+}
+
+}  // namespace siodb::iomgr::dbengine
@@ -0,0 +1,40 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// STL headers
+#include <optional>
+#include <string>
+
+namespace siodb::iomgr::dbengine {
+
+/** Compression of the closed TEXT and BINARY column data blocks */
+enum class CompressionType {
+    /** Data is not compressed */
+    kNone,
+
+    /** Data is compressed with zlib */
+    kZlib,
+
+    /** Supplementary value, that defines max compression type ID. */
+    kMax,
+};
+
+/**
+ * Returns compression type name.
+ * @param type Compression type.
+ * @return Compression type name.
+ * @throw std::out_of_range if type is invalid or kMax.
+ */
+const char* getCompressionTypeName(CompressionType type);
+
+/**
+ * Finds compression type by name. Name is case insensitive.
+ * @param name Compression type name.
+ * @return Compression type or empty value if there is no such compression type.
+ */
+std::optional<CompressionType> getCompressionType(const std::string& name);
+
+}  // namespace siodb::iomgr::dbengine
@@ -94,10 +94,28 @@ public:
      */
     virtual bool moveToNextRow() = 0;
 
+    /**
+     * Returns number of rows in the current batch. Batch starts at the current row.
+     * Values of the batch rows are read together, moving to the next row within
+     * the batch doesn't access underlying source.
+     * @return Number of rows in the batch.
+     */
+    virtual std::size_t getBatchRowCount() const noexcept = 0;
+
+    /**
+     * Returns column values of the rows of the current batch. Reads values
+     * if they were not read before.
+     * @param index Column index.
+     * @return Address of the value of the current row, followed by the values
+     *         of the remaining rows of the batch.
+     * @throw std::runtime_error if row data is not available.
+     */
+    virtual const Variant* getBatchColumnValues(std::size_t index) = 0;
+
     /**
      * Returns current row. Reads current row data if it was not read before.
      * @return Current row.
-     * @throw std::runtime_error if row data is not avaliable.
+     * @throw std::runtime_error if row data is not available.
      */
     virtual const std::vector<Variant>& getCurrentRow() = 0;
 
@@ -7,14 +7,17 @@
 // Project headers
 #include "ColumnSetPtr.h"
 #include "ColumnSpecification.h"
+#include "CompressionType.h"
 #include "ConstraintDefinitionCache.h"
 #include "ConstraintPtr.h"
 #include "DatabaseMetadata.h"
 #include "DatabasePtr.h"
 #include "FirstUserObjectId.h"
+#include "IndexColumnSpecification.h"
 #include "Instance.h"
 #include "MasterColumnRecordPtr.h"
 #include "OrderingType.h"
+#include "SecondaryIndexPtr.h"
 #include "TableCache.h"
 #include "TransactionParameters.h"
 #include "User.h"
@@ -71,6 +74,7 @@ public:
     static constexpr const char* kSysTables_Name_Column = "NAME";
     static constexpr const char* kSysTables_FirstUserTrid_Column = "FIRST_USER_TRID";
     static constexpr const char* kSysTables_CurrentColumnSetId_Column = "CURRENT_COLUMN_SET_ID";
+    static constexpr const char* kSysTables_Compression_Column = "COMPRESSION";
 
     /** Table SYS_DUMMY */
     static constexpr const char* kSysDummyTable = "SYS_DUMMY";
@@ -152,6 +156,15 @@ public:
     static constexpr const char* kSysUserPermissions_Permissions_Column = "PERMISSIONS";
     static constexpr const char* kSysUserPermissions_GrantOptions_Column = "GRANT_OPTIONS";
 
+    /** Table SYS_BLOCK_CHECKS */
+    static constexpr const char* kSysBlockChecksTable = "SYS_BLOCK_CHECKS";
+    static constexpr const char* kSysBlockChecks_DatabaseId_Column = "DATABASE_ID";
+    static constexpr const char* kSysBlockChecks_TableId_Column = "TABLE_ID";
+    static constexpr const char* kSysBlockChecks_ColumnId_Column = "COLUMN_ID";
+    static constexpr const char* kSysBlockChecks_BlockId_Column = "BLOCK_ID";
+    static constexpr const char* kSysBlockChecks_CheckTimestamp_Column = "CHECK_TIMESTAMP";
+    static constexpr const char* kSysBlockChecks_Error_Column = "ERROR";
+
     /** System database name */
     static constexpr const char* kSystemDatabaseName = "SYS";
 
@@ -317,6 +330,12 @@ public:
         return m_tableRegistry.size();
     }
 
+    /**
+     * Returns IDs of all tables in the database.
+     * @return List of table IDs.
+     */
+    std::vector<std::uint32_t> getTableIds() const;
+
     /**
      * Returns indication that user table can be created in this database.
      * @return true if user table can be created in this database, false otherwise.
@@ -337,6 +356,17 @@ public:
         return isTableExistsUnlocked(tableName);
     }
 
+    /**
+     * Returns indication that index with provided name exists.
+     * @param indexName Index name.
+     * @return true if index with provided name exists, false otherwise.
+     */
+    bool isIndexExists(const std::string& indexName) const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_indexRegistry.byName().count(indexName) > 0;
+    }
+
     /**
      * Returns cached table name.
      * @param tableId Table ID.
@@ -353,12 +383,14 @@ public:
      * @param name Table name.
      * @param type Table type.
      * @param firstUserTrid First user range TRID.
+     * @param compressionType Compression type of the variable length data.
      * @return New table object.
      */
-    TablePtr createTable(const std::string& name, TableType type, std::uint64_t firstUserTrid)
+    TablePtr createTable(const std::string& name, TableType type, std::uint64_t firstUserTrid,
+            CompressionType compressionType = CompressionType::kNone)
     {
         std::lock_guard lock(m_mutex);
-        return createTableUnlocked(name, type, firstUserTrid);
+        return createTableUnlocked(name, type, firstUserTrid, compressionType);
     }
 
     /**
@@ -498,6 +530,14 @@ public:
      */
     IndexRecord getIndexRecord(std::uint64_t indexId) const;
 
+    /**
+     * Returns records of the table indices of the given type.
+     * @param tableId Table ID.
+     * @param type Index type.
+     * @return Index records ordered by ID.
+     */
+    std::vector<IndexRecord> getTableIndexRecords(std::uint32_t tableId, IndexType type) const;
+
     /**
      * Generates new table ID.
      * @param system Indicates that ID must be in the system object ID range.
@@ -727,10 +767,26 @@ public:
      * @param type Table type.
      * @param columnSpecs Column definitions.
      * @param currentUserId Current user.
+     * @param compressionType Compression type of the variable length data.
      * @return Table object.
      */
     TablePtr createUserTable(const std::string& name, TableType type,
-            const std::vector<ColumnSpecification>& columnSpecs, std::uint32_t currentUserId);
+            const std::vector<ColumnSpecification>& columnSpecs, std::uint32_t currentUserId,
+            CompressionType compressionType = CompressionType::kNone);
+
+    /**
+     * Creates new secondary index on the user table and fills it with the existing rows.
+     * @param table Table object.
+     * @param name Index name.
+     * @param columns Indexed columns.
+     * @param unique Index uniqueness flag.
+     * @param currentUserId Current user.
+     * @return Index object.
+     * @throw DatabaseError if index already exists or can't be created,
+     *                      or if unique index key is duplicated.
+     */
+    SecondaryIndexPtr createIndex(Table& table, const std::string& name,
+            const IndexColumnSpecificationList& columns, bool unique, std::uint32_t currentUserId);
 
     /**
      * Creates new file. File is created with encrypted I/O if available.
@@ -766,10 +822,11 @@ protected:
      * @param name Table name.
      * @param type Table type.
      * @param firstUserTrid First user range TRID.
+     * @param compressionType Compression type of the variable length data.
      * @return New table object.
      */
-    TablePtr createTableUnlocked(
-            const std::string& name, TableType type, std::uint64_t firstUserTrid);
+    TablePtr createTableUnlocked(const std::string& name, TableType type,
+            std::uint64_t firstUserTrid, CompressionType compressionType = CompressionType::kNone);
 
     /**
      * Loads system table object.
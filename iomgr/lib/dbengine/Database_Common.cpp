@@ -14,6 +14,7 @@
 #include "DefaultValueConstraint.h"
 #include "Index.h"
 #include "NotNullConstraint.h"
+#include "SecondaryIndex.h"
 #include "SystemDatabase.h"
 #include "Table.h"
 #include "TableType.h"
@@ -30,6 +31,7 @@
 #include <siodb/common/utils/PlainBinaryEncoding.h>
 
 // STL headers
+#include <algorithm>
 #include <iomanip>
 #include <numeric>
 
@@ -61,6 +63,16 @@ TablePtr Database::getTableChecked(const std::string& tableName)
     throwDatabaseError(IOManagerMessageId::kErrorTableDoesNotExist, m_name, tableName);
 }
 
+std::vector<std::uint32_t> Database::getTableIds() const
+{
+    std::lock_guard lock(m_mutex);
+    std::vector<std::uint32_t> tableIds;
+    tableIds.reserve(m_tableRegistry.size());
+    for (const auto& tableRecord : m_tableRegistry.byId())
+        tableIds.push_back(tableRecord.m_id);
+    return tableIds;
+}
+
 TablePtr Database::getTableChecked(std::uint32_t tableId)
 {
     std::lock_guard lock(m_mutex);
@@ -246,6 +258,21 @@ IndexRecord Database::getIndexRecord(std::uint64_t indexId) const
     return *it;
 }
 
+std::vector<IndexRecord> Database::getTableIndexRecords(std::uint32_t tableId, IndexType type) const
+{
+    std::vector<IndexRecord> result;
+    {
+        std::lock_guard lock(m_mutex);
+        for (const auto& indexRecord : m_indexRegistry.byId()) {
+            if (indexRecord.m_tableId == tableId && indexRecord.m_type == type)
+                result.push_back(indexRecord);
+        }
+    }
+    std::sort(result.begin(), result.end(),
+            [](const auto& left, const auto& right) { return left.m_id < right.m_id; });
+    return result;
+}
+
 void Database::release()
 {
     std::size_t useCount, desiredUseCount;
@@ -456,7 +483,8 @@ TablePtr Database::createUserTable(const std::string& name, TableType type,
 }
 
 TablePtr Database::createUserTable(const std::string& name, TableType type,
-        const std::vector<ColumnSpecification>& columnSpecs, std::uint32_t currentUserId)
+        const std::vector<ColumnSpecification>& columnSpecs, std::uint32_t currentUserId,
+        CompressionType compressionType)
 {
     if (type != TableType::kDisk)
         throwDatabaseError(IOManagerMessageId::kErrorTableTypeNotSupported, static_cast<int>(type));
@@ -536,7 +564,7 @@ TablePtr Database::createUserTable(const std::string& name, TableType type,
         throw CompoundDatabaseError(std::move(errors));
     }
 
-    const auto table = createTable(name, type, 0);
+    const auto table = createTable(name, type, 0, compressionType);
 
     std::vector<ColumnPtr> columns;
     columns.reserve(columnSpecs.size() + 1);
@@ -555,6 +583,40 @@ TablePtr Database::createUserTable(const std::string& name, TableType type,
     return table;
 }
 
+SecondaryIndexPtr Database::createIndex(Table& table, const std::string& name,
+        const IndexColumnSpecificationList& columns, bool unique, std::uint32_t currentUserId)
+{
+    checkTableBelongsToThisDatabase(table, "createIndex");
+
+    LOG_DEBUG << "Database " << m_name << ": Creating index " << name << " on the table "
+              << table.getName();
+
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_indexRegistry.byName().count(name) > 0)
+            throwDatabaseError(IOManagerMessageId::kErrorIndexAlreadyExists, m_name, name);
+    }
+
+    // Index is built without holding database lock, which would block other tables
+    const auto index = table.createSecondaryIndex(name, columns, unique);
+
+    std::lock_guard lock(m_mutex);
+    try {
+        // Same index could be created concurrently
+        if (m_indexRegistry.byName().count(name) > 0)
+            throwDatabaseError(IOManagerMessageId::kErrorIndexAlreadyExists, m_name, name);
+        const TransactionParameters tp(currentUserId, generateNextTransactionId());
+        recordIndexAndColumns(*index, tp);
+    } catch (...) {
+        table.removeSecondaryIndex(*index);
+        throw;
+    }
+    registerIndex(*index);
+
+    LOG_DEBUG << "Database " << m_name << ": Created index #" << index->getId() << ' ' << name;
+    return index;
+}
+
 io::FilePtr Database::createFile(
         const std::string& path, int extraFlags, int createMode, off_t initialSize) const
 {
@@ -585,15 +647,15 @@ void Database::checkTableBelongsToThisDatabase(const Table& table, const char* o
     }
 }
 
-TablePtr Database::createTableUnlocked(
-        const std::string& name, TableType type, std::uint64_t firstUserTrid)
+TablePtr Database::createTableUnlocked(const std::string& name, TableType type,
+        std::uint64_t firstUserTrid, CompressionType compressionType)
 {
     std::lock_guard lock(m_mutex);
     if (m_tableRegistry.byName().count(name) > 0)
         throwDatabaseError(IOManagerMessageId::kErrorTableAlreadyExists, m_name, name);
 
     // Create table
-    auto table = std::make_shared<Table>(*this, type, name, firstUserTrid);
+    auto table = std::make_shared<Table>(*this, type, name, firstUserTrid, compressionType);
 
     // Register table
     registerTable(*table);
@@ -58,6 +58,16 @@ const std::unordered_map<std::string, std::unordered_set<std::string>> Database:
                         kSysUserPermissions_Permissions_Column,
                         kSysUserPermissions_GrantOptions_Column,
                 }},
+        {kSysBlockChecksTable,
+                {
+                        kMasterColumnName,
+                        kSysBlockChecks_DatabaseId_Column,
+                        kSysBlockChecks_TableId_Column,
+                        kSysBlockChecks_ColumnId_Column,
+                        kSysBlockChecks_BlockId_Column,
+                        kSysBlockChecks_CheckTimestamp_Column,
+                        kSysBlockChecks_Error_Column,
+                }},
         {kSysTablesTable,
                 {
                         kMasterColumnName,
@@ -65,6 +75,7 @@ const std::unordered_map<std::string, std::unordered_set<std::string>> Database:
                         kSysTables_Name_Column,
                         kSysTables_FirstUserTrid_Column,
                         kSysTables_CurrentColumnSetId_Column,
+                        kSysTables_Compression_Column,
                 }},
         {kSysDummyTable,
                 {
@@ -140,6 +151,7 @@ const std::unordered_set<std::string> Database::m_systemDatabaseOnlySystemTables
         kSysUsersTable,
         kSysUserAccessKeysTable,
         kSysUserPermissionsTable,
+        kSysBlockChecksTable,
 };
 
 // New database
@@ -349,6 +361,10 @@ void Database::createSystemTables()
                     kSystemTableDataFileDataAreaSize, notNullConstraintSpec));
     allColumns.push_back(column);
 
+    column = m_sysTablesTable->createColumn(ColumnSpecification(kSysTables_Compression_Column,
+            COLUMN_DATA_TYPE_INT8, kSystemTableDataFileDataAreaSize, notNullConstraintSpec));
+    allColumns.push_back(column);
+
     // Create columns of the table SYS_DUMMY
     column = m_sysDummyTable->getMasterColumn();
     allColumns.push_back(column);
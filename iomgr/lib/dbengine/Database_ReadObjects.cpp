@@ -33,6 +33,8 @@ void Database::readAllTables()
             m_sysTablesTable->getColumnChecked(kSysTables_FirstUserTrid_Column);
     const auto currentColumnSetIdColumn =
             m_sysTablesTable->getColumnChecked(kSysTables_CurrentColumnSetId_Column);
+    const auto compressionColumn =
+            m_sysTablesTable->getColumnChecked(kSysTables_Compression_Column);
 
     // Obtain min and max TRID
     const auto index = masterColumn->getMasterColumnMainIndex();
@@ -87,7 +89,8 @@ void Database::readAllTables()
 
         // Read data from columns
         const auto& columnRecords = mcr.getColumnRecords();
-        Variant typeValue, nameValue, firstUserTridValue, currentColumnSetIdValue;
+        Variant typeValue, nameValue, firstUserTridValue, currentColumnSetIdValue,
+                compressionValue;
         std::size_t colIndex = 0;
         typeColumn->readRecord(columnRecords.at(colIndex++).getAddress(), typeValue, false);
         nameColumn->readRecord(columnRecords.at(colIndex++).getAddress(), nameValue, false);
@@ -95,12 +98,15 @@ void Database::readAllTables()
                 columnRecords.at(colIndex++).getAddress(), firstUserTridValue, false);
         currentColumnSetIdColumn->readRecord(
                 columnRecords.at(colIndex++).getAddress(), currentColumnSetIdValue, false);
+        compressionColumn->readRecord(
+                columnRecords.at(colIndex++).getAddress(), compressionValue, false);
 
         const auto tableId = static_cast<std::uint32_t>(mcr.getTableRowId());
         const auto tableType = typeValue.asInt32();
         const auto name = nameValue.asString();
         const auto firstUserTrid = firstUserTridValue.asUInt64();
         const auto currentColumnSetId = currentColumnSetIdValue.asUInt64();
+        const auto compressionType = compressionValue.asInt32();
 
         // Validate table type
         if (tableType < static_cast<int>(TableType::kDisk)
@@ -119,9 +125,19 @@ void Database::readAllTables()
             continue;
         }
 
+        // Validate compression type
+        if (compressionType < static_cast<int>(CompressionType::kNone)
+                || compressionType >= static_cast<int>(CompressionType::kMax)) {
+            hasInvalidTables = true;
+            LOG_ERROR << "Database " << m_name << ": readAllTables: Invalid compression type "
+                      << compressionType << " of the table #" << tableId << '.';
+            continue;
+        }
+
         // Add table record
         TableRecord tableRecord(tableId, static_cast<TableType>(tableType), std::move(*name),
-                firstUserTrid, currentColumnSetId);
+                firstUserTrid, currentColumnSetId,
+                static_cast<CompressionType>(compressionType));
         LOG_DEBUG << "Database " << m_name << ": readAllTables: Table #" << tableRecord.m_id << " '"
                   << tableRecord.m_name << '\'';
         reg.insert(std::move(tableRecord));
@@ -24,6 +24,7 @@ void Database::recordTable(const Table& table, const TransactionParameters& tp)
     values.at(i++) = table.getName();
     values.at(i++) = table.getFirstUserTrid();
     values.at(i++) = table.getCurrentColumnSetId();
+    values.at(i++) = static_cast<std::int8_t>(table.getCompressionType());
     m_sysTablesTable->insertRow(values, tp, table.getId());
     m_sysTablesTable->flushIndices();
     LOG_DEBUG << "Database " << m_name << ": Recorded table #" << table.getId();
@@ -208,8 +209,8 @@ std::pair<MasterColumnRecordPtr, std::vector<std::uint64_t>> Database::recordInd
     values.at(i++) = index.getId();
     values.at(i++) = indexColumn.getColumnDefinitionId();
     values.at(i++) = indexColumn.isDescendingSortOrder();
-    auto result = m_sysIndexColumnsTable->insertRow(values, tp, index.getId());
-    m_sysIndicesTable->flushIndices();
+    auto result = m_sysIndexColumnsTable->insertRow(values, tp, indexColumn.getId());
+    m_sysIndexColumnsTable->flushIndices();
     LOG_DEBUG << "Database " << m_name << ": Recording index column [" << columnIndex << "] #"
               << indexColumn.getId();
     return result;
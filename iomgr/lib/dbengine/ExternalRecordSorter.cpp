@@ -0,0 +1,207 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "ExternalRecordSorter.h"
+
+// Project headers
+#include <siodb-generated/iomgr/lib/messages/IOManagerMessageId.h>
+#include "Database.h"
+#include "ThrowDatabaseError.h"
+
+// Common project headers
+#include <siodb/common/config/SiodbDefs.h>
+#include <siodb/common/utils/FsUtils.h>
+
+// CRT headers
+#include <cstring>
+
+// STL headers
+#include <algorithm>
+#include <numeric>
+
+// System headers
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace siodb::iomgr::dbengine {
+
+ExternalRecordSorter::ExternalRecordSorter(Database& database, const std::string& tmpDir,
+        std::size_t recordSize, std::size_t memoryLimit) noexcept
+    : m_database(database)
+    , m_tmpDir(tmpDir)
+    , m_recordSize(recordSize)
+    , m_memoryLimit(memoryLimit)
+    , m_memoryUsage(0)
+    , m_recordCount(0)
+    , m_fileSize(0)
+    , m_currentRecord(recordSize)
+{
+}
+
+std::size_t ExternalRecordSorter::getRunBufferSize(std::size_t producerCount) const noexcept
+{
+    // Leave half of the memory to the runs kept in memory
+    const auto size = std::min(m_memoryLimit / (2 * std::max<std::size_t>(producerCount, 1)),
+            kMaxRunBufferSize);
+    return std::max(size / m_recordSize, std::size_t(1)) * m_recordSize;
+}
+
+void ExternalRecordSorter::addRun(std::vector<std::uint8_t>& records)
+{
+    if (records.empty()) return;
+    sortRecords(records);
+
+    Run run;
+    run.m_fileOffset = 0;
+    run.m_recordCount = records.size() / m_recordSize;
+    run.m_stored = false;
+    run.m_readCount = 0;
+    run.m_bufferPos = 0;
+    run.m_bufferRecordCount = 0;
+
+    std::lock_guard lock(m_mutex);
+    if (m_memoryUsage + records.size() <= m_memoryLimit) {
+        m_memoryUsage += records.size();
+        run.m_buffer.swap(records);
+    } else {
+        run.m_fileOffset = writeRun(records);
+        run.m_stored = true;
+    }
+    m_recordCount += run.m_recordCount;
+    m_runs.push_back(std::move(run));
+    records.clear();
+}
+
+void ExternalRecordSorter::startMerge()
+{
+    // Stored runs share memory which is not used by the runs kept in memory
+    std::size_t storedRunCount = 0;
+    for (const auto& run : m_runs)
+        storedRunCount += run.m_stored ? 1 : 0;
+    std::size_t readBufferSize = 0;
+    if (storedRunCount > 0) {
+        readBufferSize = std::max(
+                (m_memoryLimit - std::min(m_memoryUsage, m_memoryLimit)) / storedRunCount,
+                kMinReadBufferSize);
+        readBufferSize = std::max(readBufferSize / m_recordSize, std::size_t(1)) * m_recordSize;
+    }
+
+    m_heap.clear();
+    m_heap.reserve(m_runs.size());
+    for (auto& run : m_runs) {
+        if (run.m_stored) {
+            run.m_buffer.resize(readBufferSize);
+            if (!fillRunBuffer(run)) continue;
+        } else
+            run.m_bufferRecordCount = run.m_recordCount;
+        m_heap.push_back(&run);
+    }
+    std::make_heap(m_heap.begin(), m_heap.end(), RunGreater {m_recordSize});
+}
+
+const std::uint8_t* ExternalRecordSorter::next()
+{
+    if (m_heap.empty()) return nullptr;
+
+    const RunGreater runGreater {m_recordSize};
+    std::pop_heap(m_heap.begin(), m_heap.end(), runGreater);
+    auto& run = *m_heap.back();
+    std::memcpy(m_currentRecord.data(), getCurrentRecord(run), m_recordSize);
+
+    // Advance run, put it back to heap if it still has records
+    if (++run.m_bufferPos < run.m_bufferRecordCount || (run.m_stored && fillRunBuffer(run)))
+        std::push_heap(m_heap.begin(), m_heap.end(), runGreater);
+    else {
+        m_heap.pop_back();
+        run.m_buffer = std::vector<std::uint8_t>();
+    }
+    return m_currentRecord.data();
+}
+
+// ----- internals -----
+
+void ExternalRecordSorter::sortRecords(std::vector<std::uint8_t>& records) const
+{
+    const auto recordCount = records.size() / m_recordSize;
+    std::vector<std::size_t> order(recordCount);
+    std::iota(order.begin(), order.end(), 0);
+    const auto data = records.data();
+    std::sort(order.begin(), order.end(), [data, this](std::size_t left, std::size_t right) {
+        return std::memcmp(data + left * m_recordSize, data + right * m_recordSize, m_recordSize)
+               < 0;
+    });
+
+    std::vector<std::uint8_t> sortedRecords(records.size());
+    auto dest = sortedRecords.data();
+    for (const auto i : order) {
+        std::memcpy(dest, data + i * m_recordSize, m_recordSize);
+        dest += m_recordSize;
+    }
+    records.swap(sortedRecords);
+}
+
+off_t ExternalRecordSorter::writeRun(const std::vector<std::uint8_t>& records)
+{
+    if (!m_file) createTmpFile();
+    const auto offset = m_fileSize;
+    if (m_file->write(records.data(), records.size(), offset) != records.size()) {
+        const int errorCode = m_file->getLastError();
+        throwDatabaseError(IOManagerMessageId::kErrorCannotWriteSortFile, m_tmpDir, offset,
+                records.size(), errorCode, std::strerror(errorCode));
+    }
+    m_fileSize += records.size();
+    return offset;
+}
+
+void ExternalRecordSorter::createTmpFile()
+{
+    // File is never linked to the filesystem, or unlinked right after creation,
+    // so it disappears once closed.
+    try {
+        try {
+            m_file = m_database.createFile(m_tmpDir, O_TMPFILE, kDataFileCreationMode, 0);
+        } catch (std::system_error& ex) {
+            if (ex.code().value() != ENOTSUP) throw;
+            // O_TMPFILE not supported, fallback to named temporary file
+            const auto tmpFilePath = utils::constructPath(m_tmpDir, kTmpFileName);
+            m_file = m_database.createFile(
+                    tmpFilePath, O_TRUNC, kDataFileCreationMode, 0);
+            ::unlink(tmpFilePath.c_str());
+        }
+    } catch (std::system_error& ex) {
+        throwDatabaseError(IOManagerMessageId::kErrorCannotCreateSortFile, m_tmpDir,
+                ex.code().value(), std::strerror(ex.code().value()));
+    }
+}
+
+bool ExternalRecordSorter::fillRunBuffer(Run& run)
+{
+    const auto remainingCount = run.m_recordCount - run.m_readCount;
+    if (remainingCount == 0) return false;
+    const auto readCount = std::min<std::uint64_t>(
+            run.m_buffer.size() / m_recordSize, remainingCount);
+    const auto size = readCount * m_recordSize;
+    const auto offset = run.m_fileOffset + run.m_readCount * m_recordSize;
+    if (m_file->read(run.m_buffer.data(), size, offset) != size) {
+        const int errorCode = m_file->getLastError();
+        throwDatabaseError(IOManagerMessageId::kErrorCannotReadSortFile, m_tmpDir, offset, size,
+                errorCode, std::strerror(errorCode));
+    }
+    run.m_readCount += readCount;
+    run.m_bufferPos = 0;
+    run.m_bufferRecordCount = readCount;
+    return true;
+}
+
+///////////////////// class ExternalRecordSorter::RunGreater ///////////////////////////////////////
+
+bool ExternalRecordSorter::RunGreater::operator()(const Run* left, const Run* right) const
+        noexcept
+{
+    return std::memcmp(left->m_buffer.data() + left->m_bufferPos * m_recordSize,
+                   right->m_buffer.data() + right->m_bufferPos * m_recordSize, m_recordSize)
+           > 0;
+}
+
+}  // namespace siodb::iomgr::dbengine
@@ -0,0 +1,207 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "io/File.h"
+
+// Common project headers
+#include <siodb/common/utils/HelperMacros.h>
+
+// STL headers
+#include <mutex>
+#include <vector>
+
+namespace siodb::iomgr::dbengine {
+
+class Database;
+
+/**
+ * Sorts fixed size records in the bytewise order. Records are added in runs,
+ * each run is sorted separately and kept in memory while runs fit into
+ * the memory limit, otherwise run is written to the temporary file.
+ * Then all runs are merged. Temporary file is encrypted if database is encrypted.
+ */
+class ExternalRecordSorter {
+public:
+    /**
+     * Initializes object of class ExternalRecordSorter.
+     * @param database Database which owns sorted data.
+     * @param tmpDir Directory for the temporary file.
+     * @param recordSize Record size.
+     * @param memoryLimit Maximum memory used by runs kept in memory.
+     */
+    ExternalRecordSorter(Database& database, const std::string& tmpDir, std::size_t recordSize,
+            std::size_t memoryLimit) noexcept;
+
+    DECLARE_NONCOPYABLE(ExternalRecordSorter);
+
+    /**
+     * Returns record size.
+     * @return Record size.
+     */
+    std::size_t getRecordSize() const noexcept
+    {
+        return m_recordSize;
+    }
+
+    /**
+     * Returns recommended size of the run buffer for a single producer thread.
+     * @param producerCount Number of producer threads.
+     * @return Run buffer size in bytes, multiple of record size.
+     */
+    std::size_t getRunBufferSize(std::size_t producerCount) const noexcept;
+
+    /**
+     * Returns number of added records.
+     * @return Number of records.
+     */
+    std::uint64_t getRecordCount() const noexcept
+    {
+        return m_recordCount;
+    }
+
+    /**
+     * Sorts records and adds them as a new run. Can be called by multiple threads.
+     * @param records Records. Buffer is cleared after the call.
+     * @throw DatabaseError if temporary file operation failed.
+     */
+    void addRun(std::vector<std::uint8_t>& records);
+
+    /**
+     * Starts merging runs. No runs can be added after that.
+     * @throw DatabaseError if temporary file read failed.
+     */
+    void startMerge();
+
+    /**
+     * Returns next record in the sorted order.
+     * @return Record address which is valid until the next call or nullptr if there are
+     *         no more records.
+     * @throw DatabaseError if temporary file read failed.
+     */
+    const std::uint8_t* next();
+
+private:
+    /** Sorted run */
+    struct Run {
+        /** Records, if run is kept in memory, otherwise read buffer */
+        std::vector<std::uint8_t> m_buffer;
+
+        /** Run offset in the temporary file */
+        off_t m_fileOffset;
+
+        /** Number of records */
+        std::uint64_t m_recordCount;
+
+        /** Indication that run is stored in the temporary file */
+        bool m_stored;
+
+        /** Number of records already read from the temporary file */
+        std::uint64_t m_readCount;
+
+        /** Position of the current record in the buffer */
+        std::size_t m_bufferPos;
+
+        /** Number of records in the buffer */
+        std::size_t m_bufferRecordCount;
+    };
+
+    /** Merge heap comparator */
+    struct RunGreater {
+        /**
+         * Compares current records of the runs.
+         * @param left Left run.
+         * @param right Right run.
+         * @return true if current record of the left run is greater.
+         */
+        bool operator()(const Run* left, const Run* right) const noexcept;
+
+        /** Record size */
+        std::size_t m_recordSize;
+    };
+
+private:
+    /**
+     * Sorts records.
+     * @param records Records.
+     */
+    void sortRecords(std::vector<std::uint8_t>& records) const;
+
+    /**
+     * Writes run to the temporary file. Must be called with mutex locked.
+     * @param records Records.
+     * @return Run file offset.
+     */
+    off_t writeRun(const std::vector<std::uint8_t>& records);
+
+    /** Creates temporary file */
+    void createTmpFile();
+
+    /**
+     * Reads next part of the stored run into its buffer.
+     * @param run Run object.
+     * @return true if some records were read, false if run is exhausted.
+     */
+    bool fillRunBuffer(Run& run);
+
+    /**
+     * Returns current record of the run.
+     * @param run Run object.
+     * @return Current record address.
+     */
+    const std::uint8_t* getCurrentRecord(const Run& run) const noexcept
+    {
+        return run.m_buffer.data() + run.m_bufferPos * m_recordSize;
+    }
+
+private:
+    /** Database object */
+    Database& m_database;
+
+    /** Temporary file directory */
+    const std::string m_tmpDir;
+
+    /** Record size */
+    const std::size_t m_recordSize;
+
+    /** Maximum memory used by runs kept in memory */
+    const std::size_t m_memoryLimit;
+
+    /** Synchronizes run addition */
+    std::mutex m_mutex;
+
+    /** Sorted runs */
+    std::vector<Run> m_runs;
+
+    /** Memory used by runs kept in memory */
+    std::size_t m_memoryUsage;
+
+    /** Total number of records */
+    std::uint64_t m_recordCount;
+
+    /** Temporary file, nullptr until first run is stored */
+    io::FilePtr m_file;
+
+    /** Temporary file size */
+    off_t m_fileSize;
+
+    /** Merge heap */
+    std::vector<Run*> m_heap;
+
+    /** Current merged record */
+    std::vector<std::uint8_t> m_currentRecord;
+
+    /** Minimum size of the read buffer of the stored run */
+    static constexpr std::size_t kMinReadBufferSize = 256 * 1024;
+
+    /** Maximum size of the run buffer of a single producer */
+    static constexpr std::size_t kMaxRunBufferSize = 64 * 1024 * 1024;
+
+    /** Temporary file name */
+    static constexpr const char* kTmpFileName = "sort.tmp";
+};
+
+}  // namespace siodb::iomgr::dbengine
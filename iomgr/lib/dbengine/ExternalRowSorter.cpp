@@ -0,0 +1,402 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "ExternalRowSorter.h"
+
+// Project headers
+#include <siodb-generated/iomgr/lib/messages/IOManagerMessageId.h>
+#include "Database.h"
+#include "ThrowDatabaseError.h"
+
+// Common project headers
+#include <siodb/common/config/SiodbDefs.h>
+#include <siodb/common/utils/FsUtils.h>
+
+// CRT headers
+#include <cstring>
+
+// STL headers
+#include <algorithm>
+
+// System headers
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace siodb::iomgr::dbengine {
+
+namespace {
+
+/**
+ * Compares sort keys bytewise.
+ * @param left Left key.
+ * @param leftSize Left key size.
+ * @param right Right key.
+ * @param rightSize Right key size.
+ * @return Negative value, zero or positive value if left key is less than,
+ *         equal to or greater than right key.
+ */
+int compareKeys(const std::uint8_t* left, std::size_t leftSize, const std::uint8_t* right,
+        std::size_t rightSize) noexcept
+{
+    const auto result = std::memcmp(left, right, std::min(leftSize, rightSize));
+    if (result != 0) return result;
+    return leftSize < rightSize ? -1 : (leftSize > rightSize ? 1 : 0);
+}
+
+}  // anonymous namespace
+
+ExternalRowSorter::ExternalRowSorter(Database& database, const std::string& tmpDir,
+        std::size_t memoryLimit, std::optional<std::uint64_t> maxRowCount) noexcept
+    : m_database(database)
+    , m_tmpDir(tmpDir)
+    , m_memoryLimit(memoryLimit)
+    , m_maxRowCount(maxRowCount)
+    , m_heapMemoryUsage(0)
+    , m_rowCount(0)
+    , m_bufferRowCount(0)
+    , m_fileSize(0)
+    , m_currentRun(nullptr)
+{
+}
+
+void ExternalRowSorter::addRow(
+        const std::vector<std::uint8_t>& key, const std::vector<Variant>& values)
+{
+    ++m_rowCount;
+    if (m_maxRowCount) {
+        addHeapRow(key, values);
+        return;
+    }
+
+    serializeRow(key, values, m_buffer);
+    ++m_bufferRowCount;
+    // Row offsets are needed to sort the buffer
+    if (m_buffer.size() + m_bufferRowCount * sizeof(std::size_t) > m_memoryLimit) writeRun();
+}
+
+void ExternalRowSorter::sort()
+{
+    if (m_maxRowCount) {
+        // Rows are already sorted, with the earlier rows first if keys are equal
+        std::sort_heap(m_heap.begin(), m_heap.end(), HeapRowLess());
+        for (const auto& heapRow : m_heap)
+            m_buffer.insert(m_buffer.end(), heapRow.m_row.begin(), heapRow.m_row.end());
+        m_bufferRowCount = m_heap.size();
+        m_heap = std::vector<HeapRow>();
+        m_heapMemoryUsage = 0;
+    }
+    keepRun();
+
+    // Stored runs share memory which is not used by the run kept in memory
+    std::size_t storedRunCount = 0;
+    std::size_t memoryUsage = 0;
+    for (const auto& run : m_runs) {
+        if (run.m_readSize < run.m_size)
+            ++storedRunCount;
+        else
+            memoryUsage += run.m_size;
+    }
+    std::size_t readBufferSize = 0;
+    if (storedRunCount > 0) {
+        readBufferSize = std::max(
+                (m_memoryLimit - std::min(memoryUsage, m_memoryLimit)) / storedRunCount,
+                kMinReadBufferSize);
+    }
+
+    m_mergeHeap.clear();
+    m_mergeHeap.reserve(m_runs.size());
+    for (auto& run : m_runs) {
+        if (run.m_readSize < run.m_size) run.m_buffer.resize(readBufferSize);
+        if (fillRunBuffer(run)) m_mergeHeap.push_back(&run);
+    }
+    std::make_heap(m_mergeHeap.begin(), m_mergeHeap.end(), RunGreater());
+    m_currentRun = nullptr;
+}
+
+bool ExternalRowSorter::moveToNextRow()
+{
+    const RunGreater runGreater;
+    if (m_currentRun) {
+        // Advance run of the previous row, put it back to heap if it still has rows
+        auto& run = *m_currentRun;
+        m_currentRun = nullptr;
+        const auto header = getRowHeader(getRunRow(run));
+        run.m_bufferPos += sizeof(RowHeader) + header.m_keySize + header.m_valuesSize;
+        if (fillRunBuffer(run)) {
+            m_mergeHeap.push_back(&run);
+            std::push_heap(m_mergeHeap.begin(), m_mergeHeap.end(), runGreater);
+        } else
+            run.m_buffer = std::vector<std::uint8_t>();
+    }
+
+    if (m_mergeHeap.empty()) return false;
+    std::pop_heap(m_mergeHeap.begin(), m_mergeHeap.end(), runGreater);
+    m_currentRun = m_mergeHeap.back();
+    m_mergeHeap.pop_back();
+    return true;
+}
+
+void ExternalRowSorter::getCurrentRow(std::vector<Variant>& values) const
+{
+    // Normally should never happen
+    if (!m_currentRun) throw std::runtime_error("No more rows");
+
+    const auto row = getRunRow(*m_currentRun);
+    const auto header = getRowHeader(row);
+    auto data = row + sizeof(RowHeader) + header.m_keySize;
+    auto remaining = header.m_valuesSize;
+    for (auto& value : values) {
+        value.clear();
+        const auto consumed = value.deserialize(data, remaining);
+        data += consumed;
+        remaining -= consumed;
+    }
+}
+
+// ----- internals -----
+
+void ExternalRowSorter::addHeapRow(
+        const std::vector<std::uint8_t>& key, const std::vector<Variant>& values)
+{
+    if (*m_maxRowCount == 0) return;
+
+    const HeapRowLess heapRowLess;
+    if (m_heap.size() == *m_maxRowCount) {
+        // Row with the same key goes after the kept rows, since it is added later
+        const auto& lastRow = m_heap.front().m_row;
+        const auto lastRowHeader = getRowHeader(lastRow.data());
+        if (compareKeys(key.data(), key.size(), lastRow.data() + sizeof(RowHeader),
+                    lastRowHeader.m_keySize)
+                >= 0)
+            return;
+        std::pop_heap(m_heap.begin(), m_heap.end(), heapRowLess);
+        m_heapMemoryUsage -= m_heap.back().m_row.size() + kHeapRowOverhead;
+        m_heap.back().m_row.clear();
+    } else
+        m_heap.emplace_back();
+
+    auto& heapRow = m_heap.back();
+    serializeRow(key, values, heapRow.m_row);
+    heapRow.m_sequence = m_rowCount;
+    m_heapMemoryUsage += heapRow.m_row.size() + kHeapRowOverhead;
+    std::push_heap(m_heap.begin(), m_heap.end(), heapRowLess);
+
+    if (m_heapMemoryUsage > m_memoryLimit) convertHeapToBuffer();
+}
+
+void ExternalRowSorter::convertHeapToBuffer()
+{
+    // Rows are moved in the order they were added, so that runs keep that order
+    std::sort(m_heap.begin(), m_heap.end(), [](const auto& left, const auto& right) noexcept {
+        return left.m_sequence < right.m_sequence;
+    });
+    for (const auto& heapRow : m_heap)
+        m_buffer.insert(m_buffer.end(), heapRow.m_row.begin(), heapRow.m_row.end());
+    m_bufferRowCount = m_heap.size();
+    m_heap = std::vector<HeapRow>();
+    m_heapMemoryUsage = 0;
+    m_maxRowCount.reset();
+    writeRun();
+}
+
+std::vector<std::size_t> ExternalRowSorter::sortBuffer() const
+{
+    std::vector<std::size_t> offsets;
+    offsets.reserve(m_bufferRowCount);
+    for (std::size_t offset = 0; offset < m_buffer.size();) {
+        offsets.push_back(offset);
+        const auto header = getRowHeader(m_buffer.data() + offset);
+        offset += sizeof(RowHeader) + header.m_keySize + header.m_valuesSize;
+    }
+
+    const auto data = m_buffer.data();
+    std::stable_sort(offsets.begin(), offsets.end(), [data](std::size_t left, std::size_t right) {
+        return compareRowKeys(data + left, data + right) < 0;
+    });
+    return offsets;
+}
+
+void ExternalRowSorter::writeRun()
+{
+    if (m_bufferRowCount == 0) return;
+    const auto offsets = sortBuffer();
+    if (!m_file) createTmpFile();
+
+    Run run;
+    run.m_index = m_runs.size();
+    run.m_fileOffset = m_fileSize;
+    run.m_readSize = 0;
+    run.m_bufferPos = 0;
+    run.m_bufferSize = 0;
+
+    std::vector<std::uint8_t> writeBuffer;
+    writeBuffer.reserve(kWriteBufferSize);
+    const auto flushWriteBuffer = [this, &writeBuffer]() {
+        if (m_file->write(writeBuffer.data(), writeBuffer.size(), m_fileSize)
+                != writeBuffer.size()) {
+            const int errorCode = m_file->getLastError();
+            throwDatabaseError(IOManagerMessageId::kErrorCannotWriteSortFile, m_tmpDir,
+                    m_fileSize, writeBuffer.size(), errorCode, std::strerror(errorCode));
+        }
+        m_fileSize += writeBuffer.size();
+        writeBuffer.clear();
+    };
+
+    for (const auto offset : offsets) {
+        const auto row = m_buffer.data() + offset;
+        const auto header = getRowHeader(row);
+        writeBuffer.insert(writeBuffer.end(), row,
+                row + sizeof(RowHeader) + header.m_keySize + header.m_valuesSize);
+        if (writeBuffer.size() >= kWriteBufferSize) flushWriteBuffer();
+    }
+    if (!writeBuffer.empty()) flushWriteBuffer();
+
+    run.m_size = m_fileSize - run.m_fileOffset;
+    m_runs.push_back(std::move(run));
+    m_buffer.clear();
+    m_bufferRowCount = 0;
+}
+
+void ExternalRowSorter::keepRun()
+{
+    if (m_bufferRowCount == 0) return;
+    const auto offsets = sortBuffer();
+
+    Run run;
+    run.m_index = m_runs.size();
+    run.m_fileOffset = 0;
+    run.m_buffer.reserve(m_buffer.size());
+    for (const auto offset : offsets) {
+        const auto row = m_buffer.data() + offset;
+        const auto header = getRowHeader(row);
+        run.m_buffer.insert(run.m_buffer.end(), row,
+                row + sizeof(RowHeader) + header.m_keySize + header.m_valuesSize);
+    }
+    run.m_size = run.m_buffer.size();
+    run.m_readSize = run.m_size;
+    run.m_bufferPos = 0;
+    run.m_bufferSize = run.m_buffer.size();
+
+    m_runs.push_back(std::move(run));
+    m_buffer = std::vector<std::uint8_t>();
+    m_bufferRowCount = 0;
+}
+
+void ExternalRowSorter::createTmpFile()
+{
+    // File is never linked to the filesystem, or unlinked right after creation,
+    // so it disappears once closed.
+    try {
+        try {
+            m_file = m_database.createFile(m_tmpDir, O_TMPFILE, kDataFileCreationMode, 0);
+        } catch (std::system_error& ex) {
+            if (ex.code().value() != ENOTSUP) throw;
+            // O_TMPFILE not supported, fallback to named temporary file
+            const auto tmpFilePath = utils::constructPath(m_tmpDir, kTmpFileName);
+            m_file = m_database.createFile(tmpFilePath, O_TRUNC, kDataFileCreationMode, 0);
+            ::unlink(tmpFilePath.c_str());
+        }
+    } catch (std::system_error& ex) {
+        throwDatabaseError(IOManagerMessageId::kErrorCannotCreateSortFile, m_tmpDir,
+                ex.code().value(), std::strerror(ex.code().value()));
+    }
+}
+
+bool ExternalRowSorter::fillRunBuffer(Run& run)
+{
+    const auto available = run.m_bufferSize - run.m_bufferPos;
+    bool rowSizeKnown = false;
+    std::size_t rowSize = sizeof(RowHeader);
+    if (available >= sizeof(RowHeader)) {
+        const auto header = getRowHeader(getRunRow(run));
+        rowSizeKnown = true;
+        rowSize += header.m_keySize + header.m_valuesSize;
+        if (available >= rowSize) return true;
+    }
+    if (available == 0 && run.m_readSize == run.m_size) return false;
+
+    // Move partially read row to the beginning of the buffer and read the rest of it
+    if (available > 0) std::memmove(run.m_buffer.data(), getRunRow(run), available);
+    run.m_bufferPos = 0;
+    run.m_bufferSize = available;
+    while (run.m_bufferSize < rowSize) {
+        // Normally should never happen
+        if (run.m_readSize == run.m_size) throw std::runtime_error("Sorted run is truncated");
+
+        if (run.m_buffer.size() < rowSize) run.m_buffer.resize(rowSize);
+        const auto size = static_cast<std::size_t>(std::min<std::uint64_t>(
+                run.m_buffer.size() - run.m_bufferSize, run.m_size - run.m_readSize));
+        const auto offset = run.m_fileOffset + static_cast<off_t>(run.m_readSize);
+        if (m_file->read(run.m_buffer.data() + run.m_bufferSize, size, offset) != size) {
+            const int errorCode = m_file->getLastError();
+            throwDatabaseError(IOManagerMessageId::kErrorCannotReadSortFile, m_tmpDir, offset,
+                    size, errorCode, std::strerror(errorCode));
+        }
+        run.m_readSize += size;
+        run.m_bufferSize += size;
+
+        if (!rowSizeKnown && run.m_bufferSize >= sizeof(RowHeader)) {
+            const auto header = getRowHeader(getRunRow(run));
+            rowSizeKnown = true;
+            rowSize += header.m_keySize + header.m_valuesSize;
+        }
+    }
+    return true;
+}
+
+void ExternalRowSorter::serializeRow(const std::vector<std::uint8_t>& key,
+        const std::vector<Variant>& values, std::vector<std::uint8_t>& dest)
+{
+    RowHeader header;
+    header.m_keySize = key.size();
+    header.m_valuesSize = 0;
+    for (const auto& value : values)
+        header.m_valuesSize += value.getSerializedSize();
+
+    const auto offset = dest.size();
+    dest.resize(offset + sizeof(RowHeader) + header.m_keySize + header.m_valuesSize);
+    auto data = dest.data() + offset;
+    std::memcpy(data, &header, sizeof(RowHeader));
+    data += sizeof(RowHeader);
+    if (!key.empty()) std::memcpy(data, key.data(), key.size());
+    data += key.size();
+    for (const auto& value : values) {
+        data = value.serializeUnchecked(data);
+        if (!data) throw VariantSerializationError("Could not read LOB");
+    }
+}
+
+ExternalRowSorter::RowHeader ExternalRowSorter::getRowHeader(const std::uint8_t* row) noexcept
+{
+    RowHeader header;
+    std::memcpy(&header, row, sizeof(RowHeader));
+    return header;
+}
+
+int ExternalRowSorter::compareRowKeys(const std::uint8_t* left, const std::uint8_t* right) noexcept
+{
+    const auto leftHeader = getRowHeader(left);
+    const auto rightHeader = getRowHeader(right);
+    return compareKeys(left + sizeof(RowHeader), leftHeader.m_keySize, right + sizeof(RowHeader),
+            rightHeader.m_keySize);
+}
+
+///////////////////// class ExternalRowSorter::HeapRowLess /////////////////////////////////////////
+
+bool ExternalRowSorter::HeapRowLess::operator()(const HeapRow& left, const HeapRow& right) const
+        noexcept
+{
+    const auto result = compareRowKeys(left.m_row.data(), right.m_row.data());
+    return result < 0 || (result == 0 && left.m_sequence < right.m_sequence);
+}
+
+///////////////////// class ExternalRowSorter::RunGreater //////////////////////////////////////////
+
+bool ExternalRowSorter::RunGreater::operator()(const Run* left, const Run* right) const noexcept
+{
+    const auto result = compareRowKeys(getRunRow(*left), getRunRow(*right));
+    return result > 0 || (result == 0 && left->m_index > right->m_index);
+}
+
+}  // namespace siodb::iomgr::dbengine
@@ -0,0 +1,266 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "Variant.h"
+#include "io/File.h"
+
+// Common project headers
+#include <siodb/common/utils/HelperMacros.h>
+
+// STL headers
+#include <optional>
+#include <vector>
+
+namespace siodb::iomgr::dbengine {
+
+class Database;
+
+/**
+ * Sorts rows by the normalized binary keys, which are compared bytewise.
+ * Rows with equal keys are returned in the order they were added.
+ * Rows are serialized and kept in memory while they fit into the memory limit,
+ * otherwise they are sorted and written to the temporary file as a run.
+ * Then all runs are merged. Temporary file is encrypted if database is encrypted.
+ *
+ * If only the given number of first rows is needed, rows are kept in a bounded heap,
+ * so that only that many rows are kept. If these rows don't fit into the memory limit,
+ * sorter falls back to the runs.
+ */
+class ExternalRowSorter {
+public:
+    /**
+     * Initializes object of class ExternalRowSorter.
+     * @param database Database which owns sorted data.
+     * @param tmpDir Directory for the temporary file.
+     * @param memoryLimit Maximum memory used by rows kept in memory.
+     * @param maxRowCount Number of first rows, which are needed, or nothing if all rows
+     *                    are needed.
+     */
+    ExternalRowSorter(Database& database, const std::string& tmpDir, std::size_t memoryLimit,
+            std::optional<std::uint64_t> maxRowCount) noexcept;
+
+    DECLARE_NONCOPYABLE(ExternalRowSorter);
+
+    /**
+     * Adds row.
+     * @param key Sort key.
+     * @param values Row values.
+     * @throw DatabaseError if temporary file write failed.
+     * @throw VariantSerializationError if value can't be serialized.
+     */
+    void addRow(const std::vector<std::uint8_t>& key, const std::vector<Variant>& values);
+
+    /**
+     * Sorts rows and starts merging runs. No rows can be added after that.
+     * @throw DatabaseError if temporary file operation failed.
+     */
+    void sort();
+
+    /**
+     * Moves to the next row in the sorted order.
+     * @return true if there is next row, false otherwise.
+     * @throw DatabaseError if temporary file read failed.
+     */
+    bool moveToNextRow();
+
+    /**
+     * Deserializes current row.
+     * @param[out] values Row values.
+     * @throw VariantDeserializationError if value can't be deserialized.
+     */
+    void getCurrentRow(std::vector<Variant>& values) const;
+
+private:
+    /** Header of the serialized row */
+    struct RowHeader {
+        /** Key size */
+        std::size_t m_keySize;
+
+        /** Serialized values size */
+        std::size_t m_valuesSize;
+    };
+
+    /** Sorted run */
+    struct Run {
+        /** Run index, rows of the earlier runs go first if keys are equal */
+        std::size_t m_index;
+
+        /** Run offset in the temporary file, if run is stored in the file */
+        off_t m_fileOffset;
+
+        /** Run size in bytes */
+        std::uint64_t m_size;
+
+        /** Number of bytes already read from the temporary file */
+        std::uint64_t m_readSize;
+
+        /** Rows, if run is kept in memory, otherwise read buffer */
+        std::vector<std::uint8_t> m_buffer;
+
+        /** Position of the current row in the buffer */
+        std::size_t m_bufferPos;
+
+        /** Number of valid bytes in the buffer */
+        std::size_t m_bufferSize;
+    };
+
+    /** Row kept in the heap of the first rows */
+    struct HeapRow {
+        /** Serialized row */
+        std::vector<std::uint8_t> m_row;
+
+        /** Sequence number of the row */
+        std::uint64_t m_sequence;
+    };
+
+    /** Heap of the first rows comparator */
+    struct HeapRowLess {
+        /**
+         * Compares rows by key, and by sequence number if keys are equal.
+         * @param left Left row.
+         * @param right Right row.
+         * @return true if left row goes before right row.
+         */
+        bool operator()(const HeapRow& left, const HeapRow& right) const noexcept;
+    };
+
+    /** Merge heap comparator */
+    struct RunGreater {
+        /**
+         * Compares current rows of the runs.
+         * @param left Left run.
+         * @param right Right run.
+         * @return true if current row of the left run goes after current row of the right run.
+         */
+        bool operator()(const Run* left, const Run* right) const noexcept;
+    };
+
+private:
+    /**
+     * Adds row to the heap of the first rows.
+     * @param key Sort key.
+     * @param values Row values.
+     */
+    void addHeapRow(const std::vector<std::uint8_t>& key, const std::vector<Variant>& values);
+
+    /** Moves rows from the heap of the first rows to the memory buffer */
+    void convertHeapToBuffer();
+
+    /**
+     * Sorts rows in the memory buffer.
+     * @return Offsets of rows in the sorted order.
+     */
+    std::vector<std::size_t> sortBuffer() const;
+
+    /** Sorts rows in the memory buffer and writes them to the temporary file as a run */
+    void writeRun();
+
+    /** Sorts rows in the memory buffer and keeps them in memory as the last run */
+    void keepRun();
+
+    /** Creates temporary file */
+    void createTmpFile();
+
+    /**
+     * Ensures that current row of the run is fully read into its buffer.
+     * @param run Run object.
+     * @return true if run has current row, false if run is exhausted.
+     */
+    bool fillRunBuffer(Run& run);
+
+    /**
+     * Returns current row of the run.
+     * @param run Run object.
+     * @return Current row address.
+     */
+    static const std::uint8_t* getRunRow(const Run& run) noexcept
+    {
+        return run.m_buffer.data() + run.m_bufferPos;
+    }
+
+    /**
+     * Serializes row.
+     * @param key Sort key.
+     * @param values Row values.
+     * @param[out] dest Destination buffer, row is appended to it.
+     */
+    static void serializeRow(const std::vector<std::uint8_t>& key,
+            const std::vector<Variant>& values, std::vector<std::uint8_t>& dest);
+
+    /**
+     * Returns header of the serialized row.
+     * @param row Serialized row.
+     * @return Row header.
+     */
+    static RowHeader getRowHeader(const std::uint8_t* row) noexcept;
+
+    /**
+     * Compares keys of the serialized rows.
+     * @param left Left row.
+     * @param right Right row.
+     * @return Negative value, zero or positive value if key of the left row is less than,
+     *         equal to or greater than key of the right row.
+     */
+    static int compareRowKeys(const std::uint8_t* left, const std::uint8_t* right) noexcept;
+
+private:
+    /** Database object */
+    Database& m_database;
+
+    /** Temporary file directory */
+    const std::string m_tmpDir;
+
+    /** Maximum memory used by rows kept in memory */
+    const std::size_t m_memoryLimit;
+
+    /** Number of first rows kept in the heap, or nothing if rows are kept in the buffer */
+    std::optional<std::uint64_t> m_maxRowCount;
+
+    /** Heap of the first rows, the last of them is on top */
+    std::vector<HeapRow> m_heap;
+
+    /** Memory used by the heap of the first rows */
+    std::size_t m_heapMemoryUsage;
+
+    /** Number of added rows */
+    std::uint64_t m_rowCount;
+
+    /** Serialized rows, which are not written to the temporary file */
+    std::vector<std::uint8_t> m_buffer;
+
+    /** Number of rows in the memory buffer */
+    std::size_t m_bufferRowCount;
+
+    /** Sorted runs, the last of them may be kept in memory */
+    std::vector<Run> m_runs;
+
+    /** Temporary file, nullptr until first run is stored */
+    io::FilePtr m_file;
+
+    /** Temporary file size */
+    off_t m_fileSize;
+
+    /** Merge heap */
+    std::vector<Run*> m_mergeHeap;
+
+    /** Run of the current row, nullptr if there is no current row */
+    Run* m_currentRun;
+
+    /** Size of the serialized rows, which are written to the file together */
+    static constexpr std::size_t kWriteBufferSize = 256 * 1024;
+
+    /** Minimum size of the read buffer of the stored run */
+    static constexpr std::size_t kMinReadBufferSize = 256 * 1024;
+
+    /** Estimated memory used by the row in the heap in addition to serialized row */
+    static constexpr std::size_t kHeapRowOverhead = sizeof(HeapRow) + 2 * sizeof(void*);
+
+    /** Temporary file name, used if unnamed temporary files are not supported */
+    static constexpr const char* kTmpFileName = "order_by.tmp";
+};
+
+}  // namespace siodb::iomgr::dbengine
@@ -0,0 +1,389 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "HashAggregation.h"
+
+// Project headers
+#include <siodb-generated/iomgr/lib/messages/IOManagerMessageId.h>
+#include "Database.h"
+#include "ThrowDatabaseError.h"
+
+// Common project headers
+#include <siodb/common/config/SiodbDefs.h>
+#include <siodb/common/utils/Base128VariantEncoding.h>
+#include <siodb/common/utils/FsUtils.h>
+
+// CRT headers
+#include <cstring>
+
+// System headers
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace siodb::iomgr::dbengine {
+
+namespace {
+
+std::size_t mixHash(std::uint64_t hash) noexcept
+{
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return static_cast<std::size_t>(hash);
+}
+
+std::size_t decodeSize(const std::uint8_t* buffer, std::size_t length, std::size_t& pos)
+{
+    std::uint64_t value = 0;
+    const int consumed = ::decodeVarInt(buffer + pos, length - pos, value);
+    if (consumed <= 0) throw VariantDeserializationError("Corrupted aggregation file");
+    pos += consumed;
+    return static_cast<std::size_t>(value);
+}
+
+}  // anonymous namespace
+
+HashAggregation::HashAggregation(requests::DatabaseContext& context,
+        std::vector<const requests::AggregateFunction*>&& functions, bool hasGroupBy,
+        Database& database, std::size_t memoryLimit)
+    : m_context(context)
+    , m_functions(std::move(functions))
+    , m_hasGroupBy(hasGroupBy)
+    , m_database(database)
+    , m_tmpDir(database.getDataDir())
+    , m_memoryLimit(memoryLimit)
+    , m_memoryUsage(0)
+    , m_level(0)
+    , m_fileSize(0)
+    , m_currentGroup(m_groups.end())
+{
+}
+
+void HashAggregation::addRow(
+        const std::vector<std::uint8_t>& key, const std::vector<Variant>& arguments)
+{
+    m_key.assign(reinterpret_cast<const char*>(key.data()), key.size());
+    auto it = m_groups.find(m_key);
+    if (it == m_groups.end()) {
+        const auto& dataSets = m_context.getDataSets();
+        Group group;
+        group.m_rows.reserve(dataSets.size());
+        for (const auto& dataSet : dataSets)
+            group.m_rows.push_back(dataSet->getCurrentRow());
+        group.m_states.resize(m_functions.size());
+        it = insertGroup(std::string(m_key), std::move(group));
+    }
+    auto& states = it->second.m_states;
+    for (std::size_t i = 0; i < m_functions.size(); ++i)
+        accumulate(*m_functions[i], arguments[i], states[i]);
+    if (m_memoryUsage > m_memoryLimit) spillGroups();
+}
+
+bool HashAggregation::moveToFirstGroup()
+{
+    const auto& dataSets = m_context.getDataSets();
+    m_dataSets.reserve(dataSets.size());
+    for (std::size_t i = 0; i < dataSets.size(); ++i) {
+        auto dataSet = std::make_shared<BufferedDataSet>(dataSets[i]);
+        m_context.replaceDataSet(i, dataSet);
+        m_dataSets.push_back(std::move(dataSet));
+    }
+
+    const bool spilled = finishSpill();
+    if (!m_hasGroupBy && m_groups.empty() && !spilled) {
+        // Without GROUP BY there is always a single group, rows of which are all NULLs
+        Group group;
+        for (const auto& dataSet : m_dataSets)
+            group.m_rows.emplace_back(dataSet->getColumnCount());
+        group.m_states.resize(m_functions.size());
+        insertGroup(std::string(), std::move(group));
+    }
+    m_currentGroup = m_groups.begin();
+    return setCurrentGroup();
+}
+
+bool HashAggregation::moveToNextGroup()
+{
+    if (m_currentGroup != m_groups.end()) ++m_currentGroup;
+    return setCurrentGroup();
+}
+
+/// ------ internals ------
+
+HashAggregation::GroupMap::iterator HashAggregation::insertGroup(
+        std::string&& key, Group&& group)
+{
+    m_memoryUsage += estimateGroupMemory(key, group);
+    return m_groups.emplace(std::move(key), std::move(group)).first;
+}
+
+void HashAggregation::mergeGroup(std::string&& key, Group&& group)
+{
+    const auto it = m_groups.find(key);
+    if (it == m_groups.end())
+        insertGroup(std::move(key), std::move(group));
+    else {
+        auto& states = it->second.m_states;
+        for (std::size_t i = 0; i < m_functions.size(); ++i)
+            merge(*m_functions[i], group.m_states[i], states[i]);
+    }
+    if (m_memoryUsage > m_memoryLimit) spillGroups();
+}
+
+void HashAggregation::spillGroups()
+{
+    // Key hash bits are exhausted, so remaining groups stay in memory
+    if (m_level >= kMaxLevel) return;
+    if (!m_firstSpillPartition) {
+        m_firstSpillPartition = m_partitions.size();
+        m_partitions.resize(m_partitions.size() + kPartitionCount);
+        for (std::size_t i = 0; i < kPartitionCount; ++i)
+            m_partitions[*m_firstSpillPartition + i].m_level = m_level + 1;
+    }
+    const auto shift = m_level * kPartitionBits;
+    for (const auto& [key, group] : m_groups) {
+        const auto hash = mixHash(std::hash<std::string>()(key)) >> shift;
+        storeGroup(m_partitions[*m_firstSpillPartition + (hash % kPartitionCount)], key, group);
+    }
+    m_groups.clear();
+    m_memoryUsage = 0;
+}
+
+bool HashAggregation::finishSpill()
+{
+    if (!m_firstSpillPartition) return false;
+    spillGroups();
+    const auto firstPartition = *m_firstSpillPartition;
+    m_firstSpillPartition.reset();
+    for (auto i = firstPartition; i < firstPartition + kPartitionCount; ++i) {
+        auto& partition = m_partitions[i];
+        flushPartition(partition);
+        partition.m_buffer.shrink_to_fit();
+    }
+    for (auto i = firstPartition + kPartitionCount; i > firstPartition; --i)
+        m_pendingPartitions.push_back(i - 1);
+    return true;
+}
+
+void HashAggregation::storeGroup(
+        Partition& partition, const std::string& key, const Group& group)
+{
+    std::size_t size = ::getVarIntSize(static_cast<std::uint64_t>(key.size())) + key.size();
+    for (const auto& row : group.m_rows) {
+        size += ::getVarIntSize(static_cast<std::uint64_t>(row.size()));
+        for (const auto& value : row)
+            size += value.getSerializedSize();
+    }
+    for (const auto& state : group.m_states)
+        size += state.m_value.getSerializedSize() + ::getVarIntSize(state.m_count);
+
+    auto& buffer = partition.m_buffer;
+    const auto offset = buffer.size();
+    buffer.resize(offset + size);
+    auto p = ::encodeVarInt(static_cast<std::uint64_t>(key.size()), buffer.data() + offset);
+    std::memcpy(p, key.data(), key.size());
+    p += key.size();
+    for (const auto& row : group.m_rows) {
+        p = ::encodeVarInt(static_cast<std::uint64_t>(row.size()), p);
+        for (const auto& value : row)
+            p = value.serializeUnchecked(p);
+    }
+    for (const auto& state : group.m_states) {
+        p = state.m_value.serializeUnchecked(p);
+        p = ::encodeVarInt(state.m_count, p);
+    }
+    if (buffer.size() >= kWriteBufferSize) flushPartition(partition);
+}
+
+void HashAggregation::flushPartition(Partition& partition)
+{
+    if (partition.m_buffer.empty()) return;
+    if (!m_file) m_file = createTmpFile();
+    const auto offset = m_fileSize;
+    const auto size = partition.m_buffer.size();
+    if (m_file->write(partition.m_buffer.data(), size, offset) != size) {
+        const int errorCode = m_file->getLastError();
+        throwDatabaseError(IOManagerMessageId::kErrorCannotWriteAggregationFile, m_tmpDir, offset,
+                size, errorCode, std::strerror(errorCode));
+    }
+    m_fileSize += size;
+    partition.m_chunks.emplace_back(offset, size);
+    partition.m_buffer.clear();
+}
+
+void HashAggregation::loadPartition(std::size_t partitionIndex)
+{
+    // Partitions may be added while groups are loaded, so chunks are taken out
+    const auto chunks = std::move(m_partitions[partitionIndex].m_chunks);
+    m_partitions[partitionIndex].m_chunks.clear();
+    m_groups.clear();
+    m_memoryUsage = 0;
+    m_level = m_partitions[partitionIndex].m_level;
+
+    for (const auto& [offset, size] : chunks) {
+        m_readBuffer.resize(size);
+        if (m_file->read(m_readBuffer.data(), size, offset) != size) {
+            const int errorCode = m_file->getLastError();
+            throwDatabaseError(IOManagerMessageId::kErrorCannotReadAggregationFile, m_tmpDir,
+                    offset, size, errorCode, std::strerror(errorCode));
+        }
+        const auto buffer = m_readBuffer.data();
+        std::size_t pos = 0;
+        while (pos < size) {
+            const auto keySize = decodeSize(buffer, size, pos);
+            if (keySize > size - pos) throw VariantDeserializationError("Corrupted aggregation file");
+            std::string key(reinterpret_cast<const char*>(buffer + pos), keySize);
+            pos += keySize;
+            Group group;
+            group.m_rows.resize(m_dataSets.size());
+            for (auto& row : group.m_rows) {
+                row.resize(decodeSize(buffer, size, pos));
+                for (auto& value : row)
+                    pos += value.deserialize(buffer + pos, size - pos);
+            }
+            group.m_states.resize(m_functions.size());
+            for (auto& state : group.m_states) {
+                pos += state.m_value.deserialize(buffer + pos, size - pos);
+                state.m_count = decodeSize(buffer, size, pos);
+            }
+            mergeGroup(std::move(key), std::move(group));
+        }
+    }
+
+    // Groups which didn't fit into memory are loaded later from the new partitions
+    finishSpill();
+}
+
+bool HashAggregation::setCurrentGroup()
+{
+    while (m_currentGroup == m_groups.end()) {
+        if (m_pendingPartitions.empty()) {
+            for (auto& dataSet : m_dataSets)
+                dataSet->setCurrentRow(nullptr);
+            m_context.setAggregateValues(nullptr);
+            return false;
+        }
+        const auto partitionIndex = m_pendingPartitions.back();
+        m_pendingPartitions.pop_back();
+        loadPartition(partitionIndex);
+        m_currentGroup = m_groups.begin();
+    }
+
+    const auto& group = m_currentGroup->second;
+    for (std::size_t i = 0; i < m_dataSets.size(); ++i)
+        m_dataSets[i]->setCurrentRow(&group.m_rows[i]);
+    m_aggregateValues.clear();
+    for (std::size_t i = 0; i < m_functions.size(); ++i)
+        m_aggregateValues.push_back(getFinalValue(*m_functions[i], group.m_states[i]));
+    m_context.setAggregateValues(&m_aggregateValues);
+    return true;
+}
+
+io::FilePtr HashAggregation::createTmpFile()
+{
+    // File is never linked to the filesystem, or unlinked right after creation,
+    // so it disappears once closed.
+    try {
+        try {
+            return m_database.createFile(m_tmpDir, O_TMPFILE, kDataFileCreationMode, 0);
+        } catch (std::system_error& ex) {
+            if (ex.code().value() != ENOTSUP) throw;
+            // O_TMPFILE not supported, fallback to named temporary file
+            const auto tmpFilePath = utils::constructPath(m_tmpDir, kTmpFileName);
+            auto file = m_database.createFile(tmpFilePath, O_TRUNC, kDataFileCreationMode, 0);
+            ::unlink(tmpFilePath.c_str());
+            return file;
+        }
+    } catch (std::system_error& ex) {
+        throwDatabaseError(IOManagerMessageId::kErrorCannotCreateAggregationFile, m_tmpDir,
+                ex.code().value(), std::strerror(ex.code().value()));
+    }
+}
+
+void HashAggregation::accumulate(
+        const requests::AggregateFunction& function, const Variant& value, AggregateState& state)
+{
+    // COUNT(*) counts rows, other functions ignore NULL values
+    if (!function.getArgument()) {
+        ++state.m_count;
+        return;
+    }
+    if (value.isNull()) return;
+    ++state.m_count;
+    combineValue(function, value, state);
+}
+
+void HashAggregation::merge(const requests::AggregateFunction& function,
+        const AggregateState& source, AggregateState& state)
+{
+    state.m_count += source.m_count;
+    if (!source.m_value.isNull()) combineValue(function, source.m_value, state);
+}
+
+void HashAggregation::combineValue(
+        const requests::AggregateFunction& function, const Variant& value, AggregateState& state)
+{
+    switch (function.getType()) {
+        case requests::ExpressionType::kSumFunction:
+        case requests::ExpressionType::kAvgFunction: {
+            // Values are summed as the widest type of the same kind, so that sum doesn't
+            // overflow the argument type.
+            Variant widenedValue;
+            if (value.isFloatingPoint())
+                widenedValue = value.asDouble();
+            else if (isSignedType(value.getValueType()))
+                widenedValue = value.asInt64();
+            else
+                widenedValue = value.asUInt64();
+            if (state.m_value.isNull())
+                state.m_value = std::move(widenedValue);
+            else
+                state.m_value = state.m_value + widenedValue;
+            break;
+        }
+        case requests::ExpressionType::kMinFunction: {
+            if (state.m_value.isNull() || value.compatibleLess(state.m_value))
+                state.m_value = value;
+            break;
+        }
+        case requests::ExpressionType::kMaxFunction: {
+            if (state.m_value.isNull() || state.m_value.compatibleLess(value))
+                state.m_value = value;
+            break;
+        }
+        default: break;
+    }
+}
+
+Variant HashAggregation::getFinalValue(
+        const requests::AggregateFunction& function, const AggregateState& state)
+{
+    switch (function.getType()) {
+        case requests::ExpressionType::kCountFunction:
+            return static_cast<std::int64_t>(state.m_count);
+        case requests::ExpressionType::kAvgFunction: {
+            if (state.m_count == 0) return Variant();
+            return state.m_value.asDouble() / static_cast<double>(state.m_count);
+        }
+        default: return state.m_value;
+    }
+}
+
+std::size_t HashAggregation::estimateGroupMemory(
+        const std::string& key, const Group& group) noexcept
+{
+    std::size_t size = kGroupOverhead + key.size();
+    for (const auto& row : group.m_rows) {
+        size += sizeof(row);
+        for (const auto& value : row)
+            size += sizeof(Variant) + value.getSerializedSize();
+    }
+    for (const auto& state : group.m_states)
+        size += sizeof(AggregateState) + state.m_value.getSerializedSize();
+    return size;
+}
+
+}  // namespace siodb::iomgr::dbengine
@@ -0,0 +1,291 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "BufferedDataSet.h"
+#include "io/File.h"
+#include "parser/DatabaseContext.h"
+#include "parser/expr/AggregateFunction.h"
+
+// Common project headers
+#include <siodb/common/utils/HelperMacros.h>
+
+// STL headers
+#include <optional>
+#include <unordered_map>
+
+namespace siodb::iomgr::dbengine {
+
+class Database;
+
+/**
+ * Groups combinations of rows of the data sets of the database context and computes
+ * aggregate functions for each group. Groups are kept in a hash table keyed by the normalized
+ * values of the GROUP BY expressions. Each group keeps current rows of the data sets at its
+ * first combination of rows, so that other expressions can be evaluated for the group,
+ * and the partial state of each aggregate function. Partial states of the same group
+ * computed separately are merged into a single one.
+ *
+ * If groups don't fit into the memory limit, they are moved with their partial states
+ * into the partitions chosen by the key hash and stored in the temporary file, and grouping
+ * starts over with the empty hash table. Partitions are then loaded one by one and partial
+ * states of the same group are merged. Partition which still doesn't fit into memory
+ * is partitioned again by the next bits of the key hash.
+ */
+class HashAggregation {
+public:
+    /**
+     * Initializes object of class HashAggregation.
+     * @param context Database context.
+     * @param functions Aggregate functions, in the order of their indices.
+     * @param hasGroupBy Indication that rows are grouped by GROUP BY expressions, otherwise
+     *                   all rows form a single group, which exists even if there are no rows.
+     * @param database Database, temporary files are created in its data directory.
+     * @param memoryLimit Maximum memory used by the groups.
+     */
+    HashAggregation(requests::DatabaseContext& context,
+            std::vector<const requests::AggregateFunction*>&& functions, bool hasGroupBy,
+            Database& database, std::size_t memoryLimit);
+
+    DECLARE_NONCOPYABLE(HashAggregation);
+
+    /**
+     * Adds current combination of rows of the data sets to its group.
+     * @param key Group key.
+     * @param arguments Argument values of the aggregate functions, ignored for COUNT(*).
+     * @throw DatabaseError if temporary file write failed.
+     * @throw VariantTypeCastError if values can't be aggregated.
+     */
+    void addRow(const std::vector<std::uint8_t>& key, const std::vector<Variant>& arguments);
+
+    /**
+     * Replaces data sets in the context with the buffered data sets, which current rows
+     * are set to the rows of the current group, and moves to the first group.
+     * No rows can be added after that.
+     * @return true if there is a group, false otherwise.
+     * @throw DatabaseError if temporary file I/O failed.
+     */
+    bool moveToFirstGroup();
+
+    /**
+     * Moves to the next group.
+     * @return true if there is next group, false otherwise.
+     * @throw DatabaseError if temporary file I/O failed.
+     */
+    bool moveToNextGroup();
+
+private:
+    /** Partial state of the aggregate function */
+    struct AggregateState {
+        /** Sum, minimum or maximum of the values, NULL if there were no values */
+        Variant m_value;
+
+        /** Number of non-NULL values, or number of rows for COUNT(*) */
+        std::uint64_t m_count = 0;
+    };
+
+    /** Group of rows */
+    struct Group {
+        /** Rows of the data sets at the first combination of rows of the group */
+        std::vector<std::vector<Variant>> m_rows;
+
+        /** Partial states of the aggregate functions */
+        std::vector<AggregateState> m_states;
+    };
+
+    /** Groups stored in the temporary file */
+    struct Partition {
+        /** Offsets and sizes of the stored chunks of serialized groups */
+        std::vector<std::pair<off_t, std::size_t>> m_chunks;
+
+        /** Serialized groups not yet stored */
+        std::vector<std::uint8_t> m_buffer;
+
+        /** Number of times groups of the partition were partitioned */
+        unsigned m_level = 0;
+    };
+
+    /** Hash table of the groups */
+    using GroupMap = std::unordered_map<std::string, Group>;
+
+private:
+    /**
+     * Inserts new group into the hash table.
+     * @param key Group key.
+     * @param group Group.
+     * @return Group position in the hash table.
+     */
+    GroupMap::iterator insertGroup(std::string&& key, Group&& group);
+
+    /**
+     * Merges group with the group of the same key in the hash table.
+     * @param key Group key.
+     * @param group Group.
+     */
+    void mergeGroup(std::string&& key, Group&& group);
+
+    /** Moves all groups from the hash table into the partitions */
+    void spillGroups();
+
+    /**
+     * Moves remaining groups into partitions and writes them into the temporary file,
+     * if groups were spilled.
+     * @return true if groups were spilled, false otherwise.
+     */
+    bool finishSpill();
+
+    /**
+     * Serializes group into the partition.
+     * @param partition Partition.
+     * @param key Group key.
+     * @param group Group.
+     */
+    void storeGroup(Partition& partition, const std::string& key, const Group& group);
+
+    /**
+     * Writes serialized groups of the partition into the temporary file.
+     * @param partition Partition.
+     */
+    void flushPartition(Partition& partition);
+
+    /**
+     * Loads groups of the partition into the hash table and merges their partial states.
+     * @param partitionIndex Partition index.
+     */
+    void loadPartition(std::size_t partitionIndex);
+
+    /**
+     * Makes current group position valid, loading pending partitions if needed,
+     * and sets current rows and aggregate values.
+     * @return true if there is current group, false otherwise.
+     */
+    bool setCurrentGroup();
+
+    /** Creates temporary file */
+    io::FilePtr createTmpFile();
+
+    /**
+     * Adds value to the partial state of the aggregate function.
+     * @param function Aggregate function.
+     * @param value Argument value.
+     * @param state Partial state.
+     */
+    static void accumulate(const requests::AggregateFunction& function, const Variant& value,
+            AggregateState& state);
+
+    /**
+     * Merges partial states of the aggregate function.
+     * @param function Aggregate function.
+     * @param source Partial state, which is merged.
+     * @param state Partial state, which receives result.
+     */
+    static void merge(const requests::AggregateFunction& function, const AggregateState& source,
+            AggregateState& state);
+
+    /**
+     * Combines non-NULL value with the value of the partial state.
+     * @param function Aggregate function.
+     * @param value Value.
+     * @param state Partial state.
+     */
+    static void combineValue(const requests::AggregateFunction& function, const Variant& value,
+            AggregateState& state);
+
+    /**
+     * Returns value of the aggregate function.
+     * @param function Aggregate function.
+     * @param state Final state.
+     * @return Value of the aggregate function.
+     */
+    static Variant getFinalValue(
+            const requests::AggregateFunction& function, const AggregateState& state);
+
+    /**
+     * Returns estimated memory used by the group.
+     * @param key Group key.
+     * @param group Group.
+     * @return Memory size in bytes.
+     */
+    static std::size_t estimateGroupMemory(const std::string& key, const Group& group) noexcept;
+
+private:
+    /** Database context */
+    requests::DatabaseContext& m_context;
+
+    /** Aggregate functions */
+    const std::vector<const requests::AggregateFunction*> m_functions;
+
+    /** Indication that rows are grouped by GROUP BY expressions */
+    const bool m_hasGroupBy;
+
+    /** Database object */
+    Database& m_database;
+
+    /** Temporary file directory */
+    const std::string m_tmpDir;
+
+    /** Maximum memory used by the groups */
+    const std::size_t m_memoryLimit;
+
+    /** Groups */
+    GroupMap m_groups;
+
+    /** Estimated memory used by the groups */
+    std::size_t m_memoryUsage;
+
+    /** Key buffer for the hash table lookup */
+    std::string m_key;
+
+    /** Partitions */
+    std::vector<Partition> m_partitions;
+
+    /** First of the partitions receiving spilled groups, if groups were spilled */
+    std::optional<std::size_t> m_firstSpillPartition;
+
+    /** Number of times groups in the hash table were partitioned */
+    unsigned m_level;
+
+    /** Partitions not yet loaded, the last of them is loaded first */
+    std::vector<std::size_t> m_pendingPartitions;
+
+    /** Temporary file, nullptr until first partition is stored */
+    io::FilePtr m_file;
+
+    /** Temporary file size */
+    off_t m_fileSize;
+
+    /** Read buffer */
+    std::vector<std::uint8_t> m_readBuffer;
+
+    /** Data sets which replace data sets in the context */
+    std::vector<std::shared_ptr<BufferedDataSet>> m_dataSets;
+
+    /** Current group */
+    GroupMap::iterator m_currentGroup;
+
+    /** Aggregate function values of the current group */
+    std::vector<Variant> m_aggregateValues;
+
+    /** Number of partitions of the groups, which don't fit into memory */
+    static constexpr std::size_t kPartitionCount = 16;
+
+    /** Number of key hash bits used to choose partition */
+    static constexpr unsigned kPartitionBits = 4;
+
+    /** Maximum number of times groups are partitioned, until key hash bits are exhausted */
+    static constexpr unsigned kMaxLevel = sizeof(std::size_t) * 8 / kPartitionBits;
+
+    /** Size of the serialized groups, which are written to the file together */
+    static constexpr std::size_t kWriteBufferSize = 64 * 1024;
+
+    /** Estimated memory used by the group in addition to key and values */
+    static constexpr std::size_t kGroupOverhead = sizeof(GroupMap::value_type) + 4 * sizeof(void*);
+
+    /** Temporary file name, used if unnamed temporary files are not supported */
+    static constexpr const char* kTmpFileName = "group_by.tmp";
+};
+
+}  // namespace siodb::iomgr::dbengine
@@ -0,0 +1,473 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "HashJoin.h"
+
+// Project headers
+#include <siodb-generated/iomgr/lib/messages/IOManagerMessageId.h>
+#include "Database.h"
+#include "ThrowDatabaseError.h"
+#include "parser/expr/BinaryOperator.h"
+#include "parser/expr/SingleColumnExpression.h"
+
+// Common project headers
+#include <siodb/common/config/SiodbDefs.h>
+#include <siodb/common/utils/FsUtils.h>
+
+// CRT headers
+#include <cstring>
+
+// STL headers
+#include <algorithm>
+#include <string_view>
+
+// System headers
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace siodb::iomgr::dbengine {
+
+namespace {
+
+const requests::SingleColumnExpression* asDataSetColumn(const requests::Expression& expression)
+{
+    if (expression.getType() != requests::ExpressionType::kSingleColumnReference) return nullptr;
+    const auto column = dynamic_cast<const requests::SingleColumnExpression*>(&expression);
+    if (column == nullptr || !column->getDatasetTableIndex() || !column->getDatasetColumnIndex())
+        return nullptr;
+    return column;
+}
+
+/**
+ * Returns indication that equal values of the type are always equal after
+ * conversion to the native type, so that they can be hashed.
+ * @param type Value type.
+ * @return true if values of the type can be hashed, false otherwise.
+ */
+bool isHashableType(VariantType type) noexcept
+{
+    switch (type) {
+        case VariantType::kBool:
+        case VariantType::kInt8:
+        case VariantType::kUInt8:
+        case VariantType::kInt16:
+        case VariantType::kUInt16:
+        case VariantType::kInt32:
+        case VariantType::kUInt32:
+        case VariantType::kInt64:
+        case VariantType::kUInt64:
+        case VariantType::kFloat:
+        case VariantType::kDouble:
+        case VariantType::kString:
+        case VariantType::kBinary: return true;
+        default: return false;
+    }
+}
+
+std::size_t mixHash(std::uint64_t hash) noexcept
+{
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return static_cast<std::size_t>(hash);
+}
+
+std::size_t hashValue(const Variant& value) noexcept
+{
+    switch (value.getValueType()) {
+        case VariantType::kBool: return value.getBool();
+        case VariantType::kInt8: return value.getInt8();
+        case VariantType::kUInt8: return value.getUInt8();
+        case VariantType::kInt16: return value.getInt16();
+        case VariantType::kUInt16: return value.getUInt16();
+        case VariantType::kInt32: return value.getInt32();
+        case VariantType::kUInt32: return value.getUInt32();
+        case VariantType::kInt64: return value.getInt64();
+        case VariantType::kUInt64: return value.getUInt64();
+        case VariantType::kFloat: {
+            // Positive and negative zeros are equal
+            const auto v = value.getFloat();
+            return std::hash<float>()(v == 0 ? 0.0f : v);
+        }
+        case VariantType::kDouble: {
+            const auto v = value.getDouble();
+            return std::hash<double>()(v == 0 ? 0.0 : v);
+        }
+        case VariantType::kString: return std::hash<std::string>()(value.getString());
+        case VariantType::kBinary: {
+            const auto& binary = value.getBinary();
+            return std::hash<std::string_view>()(std::string_view(
+                    reinterpret_cast<const char*>(binary.data()), binary.size()));
+        }
+        default: return 0;
+    }
+}
+
+}  // anonymous namespace
+
+std::unique_ptr<HashJoin> HashJoin::create(requests::DatabaseContext& context,
+        const requests::Expression& where, Database& database, std::size_t memoryLimit)
+{
+    const auto dataSetCount = context.getDataSets().size();
+    if (dataSetCount < 2) return nullptr;
+    std::vector<std::vector<KeyColumn>> keyColumns(dataSetCount - 1);
+    collectKeyColumns(where, context, keyColumns);
+    const bool hasKeyColumns = std::any_of(keyColumns.cbegin(), keyColumns.cend(),
+            [](const auto& levelKeyColumns) noexcept { return !levelKeyColumns.empty(); });
+    if (!hasKeyColumns) return nullptr;
+    return std::unique_ptr<HashJoin>(
+            new HashJoin(context, std::move(keyColumns), database, memoryLimit));
+}
+
+bool HashJoin::moveToFirstRow()
+{
+    for (auto& level : m_levels)
+        buildLevel(level);
+    auto& firstDataSet = *m_context.getDataSets().front();
+    firstDataSet.resetCursor();
+    return findCombination(0, firstDataSet.hasCurrentRow());
+}
+
+bool HashJoin::moveToNextRow()
+{
+    return findCombination(m_levels.size(), moveToNextMatch(m_levels.back()));
+}
+
+/// ------ internals ------
+
+HashJoin::HashJoin(requests::DatabaseContext& context,
+        std::vector<std::vector<KeyColumn>>&& keyColumns, Database& database,
+        std::size_t memoryLimit)
+    : m_context(context)
+    , m_database(database)
+    , m_tmpDir(database.getDataDir())
+    , m_levelMemoryLimit(memoryLimit / keyColumns.size())
+    , m_levels(keyColumns.size())
+{
+    for (std::size_t i = 0; i < m_levels.size(); ++i) {
+        auto& level = m_levels[i];
+        level.m_source = context.getDataSets()[i + 1];
+        level.m_dataSet = std::make_shared<BufferedDataSet>(level.m_source);
+        level.m_keyColumns = std::move(keyColumns[i]);
+        context.replaceDataSet(i + 1, level.m_dataSet);
+    }
+}
+
+void HashJoin::collectKeyColumns(const requests::Expression& expression,
+        const requests::DatabaseContext& context, std::vector<std::vector<KeyColumn>>& keyColumns)
+{
+    const auto type = expression.getType();
+    if (type == requests::ExpressionType::kLogicalAndOperator) {
+        const auto& op = dynamic_cast<const requests::BinaryOperator&>(expression);
+        collectKeyColumns(op.getLeftOperand(), context, keyColumns);
+        collectKeyColumns(op.getRightOperand(), context, keyColumns);
+        return;
+    }
+    if (type != requests::ExpressionType::kEqualPredicate) return;
+
+    const auto& op = dynamic_cast<const requests::BinaryOperator&>(expression);
+    auto left = asDataSetColumn(op.getLeftOperand());
+    auto right = asDataSetColumn(op.getRightOperand());
+    if (!left || !right || *left->getDatasetTableIndex() == *right->getDatasetTableIndex())
+        return;
+    // Rows of the later data set are looked up by the values of the earlier one
+    if (*left->getDatasetTableIndex() > *right->getDatasetTableIndex()) std::swap(left, right);
+
+    const auto leftTableIndex = *left->getDatasetTableIndex();
+    const auto leftColumnIndex = *left->getDatasetColumnIndex();
+    const auto rightTableIndex = *right->getDatasetTableIndex();
+    const auto rightColumnIndex = *right->getDatasetColumnIndex();
+    VariantType valueType;
+    try {
+        valueType = convertColumnDataTypeToVariantType(
+                context.getColumnDataType(leftTableIndex, leftColumnIndex));
+        // Values of different types are compared after conversion
+        if (valueType != convertColumnDataTypeToVariantType(context.getColumnDataType(
+                                 rightTableIndex, rightColumnIndex)))
+            return;
+    } catch (std::invalid_argument&) {
+        return;
+    }
+    if (!isHashableType(valueType)) return;
+    keyColumns.at(rightTableIndex - 1)
+            .push_back({rightColumnIndex, leftTableIndex, leftColumnIndex, valueType});
+}
+
+void HashJoin::buildLevel(Level& level)
+{
+    auto& source = *level.m_source;
+    std::size_t rowNumber = 0;
+    for (source.resetCursor(); source.hasCurrentRow(); source.moveToNextRow()) {
+        const auto& row = source.getCurrentRow();
+        std::size_t hash = rowNumber++;
+        if (!level.m_keyColumns.empty()) {
+            const auto keyHash = hashRowKey(level.m_keyColumns, row);
+            // Row with NULL key never matches
+            if (!keyHash) continue;
+            hash = *keyHash;
+        }
+        if (!level.m_partitions.empty()) {
+            storeRow(level, row, hash);
+            continue;
+        }
+        addLoadedRow(level, std::vector<Variant>(row), hash);
+        if (level.m_memoryUsage > m_levelMemoryLimit) spillLevel(level);
+    }
+
+    if (level.m_partitions.empty()) return;
+    for (auto& partition : level.m_partitions) {
+        flushPartition(level, partition);
+        partition.m_buffer.shrink_to_fit();
+    }
+    planPasses(level);
+    level.m_pass = 0;
+    loadPass(level);
+}
+
+void HashJoin::addLoadedRow(Level& level, std::vector<Variant>&& row, std::size_t hash)
+{
+    level.m_memoryUsage += estimateRowMemory(row);
+    if (!level.m_keyColumns.empty()) level.m_hashTable.emplace(hash, level.m_rows.size());
+    level.m_rows.push_back(std::move(row));
+}
+
+void HashJoin::storeRow(Level& level, const std::vector<Variant>& row, std::size_t hash)
+{
+    auto& partition = level.m_partitions[hash % kPartitionCount];
+    std::size_t size = 0;
+    for (const auto& value : row)
+        size += value.getSerializedSize();
+    auto& buffer = partition.m_buffer;
+    const auto offset = buffer.size();
+    buffer.resize(offset + size);
+    auto p = buffer.data() + offset;
+    for (const auto& value : row)
+        p = value.serializeUnchecked(p);
+    partition.m_memoryUsage += estimateRowMemory(row);
+    if (buffer.size() >= kWriteBufferSize) flushPartition(level, partition);
+}
+
+void HashJoin::spillLevel(Level& level)
+{
+    level.m_partitions.resize(kPartitionCount);
+    if (level.m_keyColumns.empty()) {
+        for (std::size_t i = 0; i < level.m_rows.size(); ++i)
+            storeRow(level, level.m_rows[i], i);
+    } else {
+        for (const auto& [hash, rowIndex] : level.m_hashTable)
+            storeRow(level, level.m_rows[rowIndex], hash);
+    }
+    level.m_rows = std::vector<std::vector<Variant>>();
+    level.m_hashTable.clear();
+    level.m_memoryUsage = 0;
+}
+
+void HashJoin::flushPartition(Level& level, Partition& partition)
+{
+    if (partition.m_buffer.empty()) return;
+    if (!level.m_file) level.m_file = createTmpFile();
+    const auto offset = level.m_fileSize;
+    const auto size = partition.m_buffer.size();
+    if (level.m_file->write(partition.m_buffer.data(), size, offset) != size) {
+        const int errorCode = level.m_file->getLastError();
+        throwDatabaseError(IOManagerMessageId::kErrorCannotWriteJoinFile, m_tmpDir, offset, size,
+                errorCode, std::strerror(errorCode));
+    }
+    level.m_fileSize += size;
+    partition.m_chunks.emplace_back(offset, size);
+    partition.m_buffer.clear();
+}
+
+void HashJoin::planPasses(Level& level)
+{
+    level.m_passes.clear();
+    std::size_t memoryUsage = 0;
+    for (std::size_t i = 0; i < level.m_partitions.size(); ++i) {
+        const auto partitionMemoryUsage = level.m_partitions[i].m_memoryUsage;
+        // Partition which alone doesn't fit into memory is still loaded at once
+        if (level.m_passes.empty() || memoryUsage + partitionMemoryUsage > m_levelMemoryLimit) {
+            level.m_passes.push_back(i);
+            memoryUsage = 0;
+        }
+        memoryUsage += partitionMemoryUsage;
+    }
+    level.m_passes.push_back(level.m_partitions.size());
+}
+
+void HashJoin::loadPass(Level& level)
+{
+    level.m_rows.clear();
+    level.m_hashTable.clear();
+    level.m_memoryUsage = 0;
+    const auto columnCount = level.m_dataSet->getColumnCount();
+    const auto firstPartition = level.m_passes[level.m_pass];
+    const auto lastPartition = level.m_passes[level.m_pass + 1];
+    for (auto i = firstPartition; i < lastPartition; ++i) {
+        for (const auto& [offset, size] : level.m_partitions[i].m_chunks) {
+            m_readBuffer.resize(size);
+            if (level.m_file->read(m_readBuffer.data(), size, offset) != size) {
+                const int errorCode = level.m_file->getLastError();
+                throwDatabaseError(IOManagerMessageId::kErrorCannotReadJoinFile, m_tmpDir,
+                        offset, size, errorCode, std::strerror(errorCode));
+            }
+            std::size_t pos = 0;
+            while (pos < size) {
+                std::vector<Variant> row(columnCount);
+                for (auto& value : row)
+                    pos += value.deserialize(m_readBuffer.data() + pos, size - pos);
+                // Stored rows always have valid keys
+                const auto hash = level.m_keyColumns.empty()
+                                          ? level.m_rows.size()
+                                          : *hashRowKey(level.m_keyColumns, row);
+                addLoadedRow(level, std::move(row), hash);
+            }
+        }
+    }
+}
+
+bool HashJoin::moveToNextPass()
+{
+    // Partition groups of the last data set change first
+    for (auto i = m_levels.size(); i > 0; --i) {
+        auto& level = m_levels[i - 1];
+        if (level.m_pass + 2 >= level.m_passes.size()) continue;
+        ++level.m_pass;
+        loadPass(level);
+        for (auto j = i; j < m_levels.size(); ++j) {
+            auto& nextLevel = m_levels[j];
+            if (nextLevel.m_pass == 0) continue;
+            nextLevel.m_pass = 0;
+            loadPass(nextLevel);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool HashJoin::findCombination(std::size_t dataSetIndex, bool found)
+{
+    const auto dataSetCount = m_levels.size() + 1;
+    while (true) {
+        if (found) {
+            if (++dataSetIndex == dataSetCount) return true;
+            found = moveToFirstMatch(m_levels[dataSetIndex - 1]);
+        } else {
+            if (dataSetIndex == 0) return false;
+            --dataSetIndex;
+            found = (dataSetIndex == 0) ? moveFirstDataSetToNextRow()
+                                        : moveToNextMatch(m_levels[dataSetIndex - 1]);
+        }
+    }
+}
+
+bool HashJoin::moveToFirstMatch(Level& level)
+{
+    level.m_matchPos = 0;
+    if (level.m_keyColumns.empty()) {
+        level.m_matchCount = level.m_rows.size();
+        return setCurrentMatch(level);
+    }
+
+    const auto& keyColumns = level.m_keyColumns;
+    const auto getProbeValue = [this, &keyColumns](std::size_t i) -> const Variant& {
+        return m_context.getColumnValue(
+                keyColumns[i].m_probeTableIndex, keyColumns[i].m_probeColumnIndex);
+    };
+    level.m_matches.clear();
+    if (const auto hash = hashKey(keyColumns, getProbeValue)) {
+        const auto range = level.m_hashTable.equal_range(*hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            const auto& row = level.m_rows[it->second];
+            bool match = true;
+            for (std::size_t i = 0; i < keyColumns.size() && match; ++i)
+                match = row[keyColumns[i].m_columnIndex].compatibleEqual(getProbeValue(i));
+            if (match) level.m_matches.push_back(it->second);
+        }
+    }
+    level.m_matchCount = level.m_matches.size();
+    return setCurrentMatch(level);
+}
+
+bool HashJoin::moveToNextMatch(Level& level)
+{
+    ++level.m_matchPos;
+    return setCurrentMatch(level);
+}
+
+bool HashJoin::setCurrentMatch(Level& level) noexcept
+{
+    if (level.m_matchPos >= level.m_matchCount) {
+        level.m_dataSet->setCurrentRow(nullptr);
+        return false;
+    }
+    const auto rowIndex =
+            level.m_keyColumns.empty() ? level.m_matchPos : level.m_matches[level.m_matchPos];
+    level.m_dataSet->setCurrentRow(&level.m_rows[rowIndex]);
+    return true;
+}
+
+bool HashJoin::moveFirstDataSetToNextRow()
+{
+    auto& firstDataSet = *m_context.getDataSets().front();
+    if (firstDataSet.moveToNextRow()) return true;
+    // All rows of the first data set are joined with the loaded partition groups
+    if (!moveToNextPass()) return false;
+    firstDataSet.resetCursor();
+    return firstDataSet.hasCurrentRow();
+}
+
+io::FilePtr HashJoin::createTmpFile()
+{
+    // File is never linked to the filesystem, or unlinked right after creation,
+    // so it disappears once closed.
+    try {
+        try {
+            return m_database.createFile(m_tmpDir, O_TMPFILE, kDataFileCreationMode, 0);
+        } catch (std::system_error& ex) {
+            if (ex.code().value() != ENOTSUP) throw;
+            // O_TMPFILE not supported, fallback to named temporary file
+            const auto tmpFilePath = utils::constructPath(m_tmpDir, kTmpFileName);
+            auto file = m_database.createFile(tmpFilePath, O_TRUNC, kDataFileCreationMode, 0);
+            ::unlink(tmpFilePath.c_str());
+            return file;
+        }
+    } catch (std::system_error& ex) {
+        throwDatabaseError(IOManagerMessageId::kErrorCannotCreateJoinFile, m_tmpDir,
+                ex.code().value(), std::strerror(ex.code().value()));
+    }
+}
+
+template<typename GetValue>
+std::optional<std::size_t> HashJoin::hashKey(
+        const std::vector<KeyColumn>& keyColumns, GetValue getValue)
+{
+    std::size_t hash = 0;
+    for (std::size_t i = 0; i < keyColumns.size(); ++i) {
+        const Variant& value = getValue(i);
+        // NULL is never equal to anything, values of other types, like LOBs, can't be compared
+        if (value.getValueType() != keyColumns[i].m_valueType) return std::nullopt;
+        hash = mixHash(hash * 31 + hashValue(value));
+    }
+    return hash;
+}
+
+std::optional<std::size_t> HashJoin::hashRowKey(
+        const std::vector<KeyColumn>& keyColumns, const std::vector<Variant>& row)
+{
+    return hashKey(keyColumns, [&row, &keyColumns](std::size_t i) -> const Variant& {
+        return row[keyColumns[i].m_columnIndex];
+    });
+}
+
+std::size_t HashJoin::estimateRowMemory(const std::vector<Variant>& row) noexcept
+{
+    std::size_t size = kRowOverhead;
+    for (const auto& value : row)
+        size += sizeof(Variant) + value.getSerializedSize();
+    return size;
+}
+
+}  // namespace siodb::iomgr::dbengine
@@ -0,0 +1,312 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "BufferedDataSet.h"
+#include "io/File.h"
+#include "parser/DatabaseContext.h"
+
+// Common project headers
+#include <siodb/common/utils/HelperMacros.h>
+
+// STL headers
+#include <unordered_map>
+
+namespace siodb::iomgr::dbengine {
+
+class Database;
+
+/**
+ * Joins data sets of the database context by the equality of their columns.
+ * Rows of all data sets except the first one are read into hash tables keyed by
+ * the columns compared with the columns of the preceding data sets. Rows of the first
+ * data set are read one by one and matching rows of the following data sets are found
+ * by the hash table lookups. Joined data sets are replaced in the context with buffered
+ * data sets, which current rows are set by the join.
+ *
+ * If rows of the data set don't fit into the memory limit, they are partitioned by the key
+ * hash and stored in the temporary file. Partitions are then loaded by the groups, which fit
+ * into the memory, and the first data set is read once for each combination of the loaded
+ * groups of all data sets.
+ */
+class HashJoin {
+public:
+    /**
+     * Creates hash join of the data sets of the context if WHERE condition requires
+     * equality of the columns of different data sets. Only comparisons of the columns
+     * of the same type joined with AND are taken into account, so condition still must
+     * be evaluated for each combination of rows. Must be called after all used columns
+     * are added into the data sets.
+     * @param context Database context.
+     * @param where WHERE condition.
+     * @param database Database, temporary files are created in its data directory.
+     * @param memoryLimit Maximum memory used by the hash tables.
+     * @return Hash join object or nullptr if data sets can't be joined by hash.
+     */
+    static std::unique_ptr<HashJoin> create(requests::DatabaseContext& context,
+            const requests::Expression& where, Database& database, std::size_t memoryLimit);
+
+    DECLARE_NONCOPYABLE(HashJoin);
+
+    /**
+     * Reads rows of the joined data sets and moves to the first combination of matching rows.
+     * @return true if such combination exists, false otherwise.
+     * @throw DatabaseError if temporary file I/O failed.
+     */
+    bool moveToFirstRow();
+
+    /**
+     * Moves to the next combination of matching rows.
+     * @return true if such combination exists, false otherwise.
+     * @throw DatabaseError if temporary file I/O failed.
+     */
+    bool moveToNextRow();
+
+private:
+    /** Equality of the column of the joined data set with the column of a preceding one */
+    struct KeyColumn {
+        /** Column index in the joined data set */
+        std::size_t m_columnIndex;
+
+        /** Index of the preceding data set */
+        std::size_t m_probeTableIndex;
+
+        /** Column index in the preceding data set */
+        std::size_t m_probeColumnIndex;
+
+        /** Value type of both columns */
+        VariantType m_valueType;
+    };
+
+    /** Rows of the joined data set, stored in the temporary file */
+    struct Partition {
+        /** Offsets and sizes of the stored chunks of serialized rows */
+        std::vector<std::pair<off_t, std::size_t>> m_chunks;
+
+        /** Serialized rows not yet stored */
+        std::vector<std::uint8_t> m_buffer;
+
+        /** Estimated memory used by rows, when they are loaded */
+        std::size_t m_memoryUsage = 0;
+    };
+
+    /** Joined data set */
+    struct Level {
+        /** Source data set */
+        DataSetPtr m_source;
+
+        /** Data set which replaces source in the context */
+        std::shared_ptr<BufferedDataSet> m_dataSet;
+
+        /** Key columns, if empty every row matches */
+        std::vector<KeyColumn> m_keyColumns;
+
+        /** Loaded rows */
+        std::vector<std::vector<Variant>> m_rows;
+
+        /** Indices of loaded rows by key hash */
+        std::unordered_multimap<std::size_t, std::size_t> m_hashTable;
+
+        /** Estimated memory used by loaded rows */
+        std::size_t m_memoryUsage = 0;
+
+        /** Partitions, empty if all rows are loaded */
+        std::vector<Partition> m_partitions;
+
+        /** First partition of each group loaded at once, followed by the partition count */
+        std::vector<std::size_t> m_passes;
+
+        /** Currently loaded group of partitions */
+        std::size_t m_pass = 0;
+
+        /** Temporary file */
+        io::FilePtr m_file;
+
+        /** Temporary file size */
+        off_t m_fileSize = 0;
+
+        /** Loaded rows matching current rows of the preceding data sets */
+        std::vector<std::size_t> m_matches;
+
+        /** Number of matching rows */
+        std::size_t m_matchCount = 0;
+
+        /** Current matching row */
+        std::size_t m_matchPos = 0;
+    };
+
+private:
+    /**
+     * Initializes object of class HashJoin.
+     * @param context Database context.
+     * @param keyColumns Key columns of each data set except the first one.
+     * @param database Database object.
+     * @param memoryLimit Maximum memory used by the hash tables.
+     */
+    HashJoin(requests::DatabaseContext& context, std::vector<std::vector<KeyColumn>>&& keyColumns,
+            Database& database, std::size_t memoryLimit);
+
+    /**
+     * Collects equalities of columns of different data sets.
+     * @param expression An expression.
+     * @param context Database context.
+     * @param[out] keyColumns Key columns of each data set except the first one.
+     */
+    static void collectKeyColumns(const requests::Expression& expression,
+            const requests::DatabaseContext& context,
+            std::vector<std::vector<KeyColumn>>& keyColumns);
+
+    /**
+     * Reads rows of the source data set of the level.
+     * @param level Joined data set.
+     */
+    void buildLevel(Level& level);
+
+    /**
+     * Adds row to the loaded rows of the level.
+     * @param level Joined data set.
+     * @param row Row values.
+     * @param hash Key hash.
+     */
+    void addLoadedRow(Level& level, std::vector<Variant>&& row, std::size_t hash);
+
+    /**
+     * Serializes row into the partition, which is chosen by hash.
+     * @param level Joined data set.
+     * @param row Row values.
+     * @param hash Key hash or row number if there are no key columns.
+     */
+    void storeRow(Level& level, const std::vector<Variant>& row, std::size_t hash);
+
+    /**
+     * Moves all loaded rows of the level into partitions.
+     * @param level Joined data set.
+     */
+    void spillLevel(Level& level);
+
+    /**
+     * Writes serialized rows of the partition into the temporary file.
+     * @param level Joined data set.
+     * @param partition Partition.
+     */
+    void flushPartition(Level& level, Partition& partition);
+
+    /**
+     * Splits partitions of the level into groups, which fit into memory.
+     * @param level Joined data set.
+     */
+    void planPasses(Level& level);
+
+    /**
+     * Loads current group of partitions of the level.
+     * @param level Joined data set.
+     */
+    void loadPass(Level& level);
+
+    /**
+     * Moves to the next combination of loaded partition groups.
+     * @return true if there is such combination, false otherwise.
+     */
+    bool moveToNextPass();
+
+    /**
+     * Finds combination of matching rows starting from the data set.
+     * @param dataSetIndex Index of the data set to start from.
+     * @param found Indication that data set is positioned at the row.
+     * @return true if combination found, false otherwise.
+     */
+    bool findCombination(std::size_t dataSetIndex, bool found);
+
+    /**
+     * Finds rows of the level matching current rows of preceding data sets.
+     * @param level Joined data set.
+     * @return true if there are matching rows, false otherwise.
+     */
+    bool moveToFirstMatch(Level& level);
+
+    /**
+     * Moves level to the next matching row.
+     * @param level Joined data set.
+     * @return true if there is next matching row, false otherwise.
+     */
+    bool moveToNextMatch(Level& level);
+
+    /**
+     * Sets current row of the level to the current matching row.
+     * @param level Joined data set.
+     * @return true if there is current matching row, false otherwise.
+     */
+    static bool setCurrentMatch(Level& level) noexcept;
+
+    /**
+     * Moves first data set to the next row. Starts it over with the next combination
+     * of loaded partition groups when all its rows are read.
+     * @return true if there is next row, false otherwise.
+     */
+    bool moveFirstDataSetToNextRow();
+
+    /** Creates temporary file for the level */
+    io::FilePtr createTmpFile();
+
+    /**
+     * Returns key hash.
+     * @param keyColumns Key columns.
+     * @param getValue Function returning value of the key column.
+     * @return Key hash or nothing if some value is NULL or has unexpected type.
+     */
+    template<typename GetValue>
+    static std::optional<std::size_t> hashKey(
+            const std::vector<KeyColumn>& keyColumns, GetValue getValue);
+
+    /**
+     * Returns key hash of the row of the joined data set.
+     * @param keyColumns Key columns.
+     * @param row Row values.
+     * @return Key hash or nothing if some value is NULL or has unexpected type.
+     */
+    static std::optional<std::size_t> hashRowKey(
+            const std::vector<KeyColumn>& keyColumns, const std::vector<Variant>& row);
+
+    /**
+     * Returns estimated memory used by the row.
+     * @param row Row values.
+     * @return Memory size in bytes.
+     */
+    static std::size_t estimateRowMemory(const std::vector<Variant>& row) noexcept;
+
+private:
+    /** Database context */
+    requests::DatabaseContext& m_context;
+
+    /** Database object */
+    Database& m_database;
+
+    /** Temporary file directory */
+    const std::string m_tmpDir;
+
+    /** Maximum memory used by the rows of a single level */
+    const std::size_t m_levelMemoryLimit;
+
+    /** Joined data sets, all data sets except the first one */
+    std::vector<Level> m_levels;
+
+    /** Read buffer */
+    std::vector<std::uint8_t> m_readBuffer;
+
+    /** Number of partitions of the level, which doesn't fit into memory */
+    static constexpr std::size_t kPartitionCount = 16;
+
+    /** Size of the serialized rows, which are written to the file together */
+    static constexpr std::size_t kWriteBufferSize = 64 * 1024;
+
+    /** Estimated memory used by the row in addition to values */
+    static constexpr std::size_t kRowOverhead = sizeof(std::vector<Variant>) + 4 * sizeof(void*);
+
+    /** Temporary file name, used if unnamed temporary files are not supported */
+    static constexpr const char* kTmpFileName = "join.tmp";
+};
+
+}  // namespace siodb::iomgr::dbengine
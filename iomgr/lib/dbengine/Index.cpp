@@ -15,6 +15,9 @@
 #include <siodb/common/stl_wrap/filesystem_wrapper.h>
 #include <siodb/common/utils/FsUtils.h>
 
+// STL headers
+#include <algorithm>
+
 namespace siodb::iomgr::dbengine {
 
 Index::Index(Table& table, IndexType type, const std::string& name, const IndexKeyTraits& keyTraits,
@@ -152,6 +155,9 @@ Index::IndexColumnCollection Index::makeIndexColumns(
         result.push_back(
                 std::make_shared<IndexColumn>(stdext::as_mutable(*this), indexColumnRecord));
     }
+    // Registry is not ordered, but columns are recorded in the order of the key
+    std::sort(result.begin(), result.end(),
+            [](const auto& left, const auto& right) { return left->getId() < right->getId(); });
     return result;
 }
 
@@ -156,6 +156,15 @@ public:
         return m_unique;
     }
 
+    /**
+     * Returns key size.
+     * @return Key size in bytes.
+     */
+    std::size_t getKeySize() const noexcept
+    {
+        return m_keySize;
+    }
+
     /**
      * Returns list of indexed columns with direction.
      * @return List of indexed columns with direction.
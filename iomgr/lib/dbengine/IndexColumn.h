@@ -72,6 +72,15 @@ public:
         return m_columnDefinition->getId();
     }
 
+    /**
+     * Returns column definition.
+     * @return Column definition.
+     */
+    const ColumnDefinitionPtr& getColumnDefinition() const noexcept
+    {
+        return m_columnDefinition;
+    }
+
     /**
      * Returns descending sorting order flag.
      * @return true if descending sorting should be applied for this column, false otherwise.
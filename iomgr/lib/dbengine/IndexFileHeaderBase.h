@@ -99,8 +99,9 @@ protected:
      */
     const std::uint8_t* deserialize(const std::uint8_t* buffer) noexcept;
 
-    /** Serialized size */
-    static constexpr std::size_t kSerializedSize = FullIndexId::kSerializedSize + 1;
+    /** Serialized size, exactly the number of bytes written by serialize() */
+    static constexpr std::size_t kSerializedSize =
+            sizeof(m_version) + 1 + FullIndexId::kSerializedSize;
 
     /** Current version of common part */
     static constexpr std::uint32_t kCurrentVersion = 1;
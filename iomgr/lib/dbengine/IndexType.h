@@ -16,7 +16,7 @@ enum class IndexType {
     kLinearIndexU32,
     kLinearIndexI64,
     kLinearIndexU64,
-    kBPlusTreeIndex,  // not implemented yet
+    kBPlusTreeIndex,
     kHashIndex  // not supported yet
 };
 
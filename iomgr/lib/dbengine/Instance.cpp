@@ -54,10 +54,22 @@ Instance::Instance(const config::InstanceOptions& options)
     , m_superUserInitialAccessKey(options.m_generalOptions.m_superUserInitialAccessKey.empty()
                                           ? loadSuperUserInitialAccessKey()
                                           : options.m_generalOptions.m_superUserInitialAccessKey)
+    , m_enableWriteAheadLog(options.m_ioManagerOptions.m_enableWriteAheadLog)
+    , m_blockPool(options.m_ioManagerOptions.m_blockCacheSize,
+              options.m_ioManagerOptions.m_writerThreadNumber)
+    , m_blockFinalizer(options.m_ioManagerOptions.m_writerThreadNumber > 0
+                               ? std::make_unique<ColumnDataBlockFinalizer>(
+                                       options.m_ioManagerOptions.m_writerThreadNumber)
+                               : nullptr)
     , m_userCache(options.m_ioManagerOptions.m_userCacheCapacity)
     , m_databaseCache(options.m_ioManagerOptions.m_databaseCacheCapacity)
     , m_tableCacheCapacity(options.m_ioManagerOptions.m_tableCacheCapacity)
-    , m_blockCacheCapacity(options.m_ioManagerOptions.m_blockCacheCapacity)
+    , m_segmentFileSize(options.m_ioManagerOptions.m_segmentFileSize)
+    , m_enableDirectIo(options.m_ioManagerOptions.m_enableDirectIo)
+    , m_indexBuildMemory(options.m_ioManagerOptions.m_indexBuildMemory)
+    , m_joinMemory(options.m_ioManagerOptions.m_joinMemory)
+    , m_sortMemory(options.m_ioManagerOptions.m_sortMemory)
+    , m_aggregationMemory(options.m_ioManagerOptions.m_aggregationMemory)
     , m_metadataFile()
     , m_allowCreatingUserTablesInSystemDatabase(
               options.m_generalOptions.m_allowCreatingUserTablesInSystemDatabase)
@@ -66,6 +78,12 @@ Instance::Instance(const config::InstanceOptions& options)
         loadInstanceData();
     else
         createInstanceData();
+
+    if (options.m_ioManagerOptions.m_blockScrubRate > 0) {
+        m_blockScrubber = std::make_unique<ColumnDataBlockScrubber>(*this,
+                options.m_ioManagerOptions.m_blockScrubRate,
+                options.m_ioManagerOptions.m_blockScrubInterval);
+    }
 }
 
 std::string Instance::getDisplayName() const
@@ -118,6 +136,14 @@ DatabasePtr Instance::getDatabase(const std::string& databaseName)
     return database;
 }
 
+void Instance::recordBlockCheckError(
+        const Column& column, std::uint64_t blockId, const std::string& error)
+{
+    const TransactionParameters tp(
+            User::kSuperUserId, m_systemDatabase->generateNextTransactionId());
+    m_systemDatabase->recordBlockCheckError(column, blockId, error, tp);
+}
+
 DatabasePtr Instance::createDatabase(const std::string& name, const std::string& cipherId,
         const BinaryValue& cipherKey, std::uint32_t currentUserId)
 {
@@ -394,6 +420,17 @@ std::pair<std::uint32_t, Uuid> Instance::authenticateUser(
     return std::make_pair(user->getId(), beginSession());
 }
 
+void Instance::commitWriteAheadLog()
+{
+    if (!m_writeAheadLog) return;
+    try {
+        m_writeAheadLog->commit();
+    } catch (std::system_error& ex) {
+        throwDatabaseError(IOManagerMessageId::kErrorCannotCommitWriteAheadLog, ex.code().value(),
+                ex.what());
+    }
+}
+
 void Instance::endSession(const Uuid& sessionUuid)
 {
     std::lock_guard lock(m_sessionMutex);
@@ -408,11 +445,13 @@ void Instance::createInstanceData()
 {
     LOG_INFO << "Instance: Creating new instance data.";
     ensureDataDir();
+    openWriteAheadLog();
     m_metadataFile.reset(openMetadataFile());
     createSuperUser();
     createSystemDatabase();
     recordSuperUser();
     saveMetadata();
+    commitWriteAheadLog();
     createInitializationFlagFile();
     checkDataConsistency();
 }
@@ -421,6 +460,7 @@ void Instance::loadInstanceData()
 {
     LOG_INFO << "Instance: Loading instance data.";
     checkInitializationFlagFile();
+    openWriteAheadLog();
     m_metadataFile.reset(openMetadataFile());
     loadMetadata();
     loadSystemDatabase();
@@ -448,6 +488,18 @@ void Instance::ensureDataDir() const
     }
 }
 
+void Instance::openWriteAheadLog()
+{
+    if (!m_enableWriteAheadLog) return;
+    LOG_DEBUG << "Instance: Opening write-ahead log.";
+    try {
+        m_writeAheadLog = std::make_unique<io::WriteAheadLog>(m_dataDir);
+    } catch (std::system_error& ex) {
+        throwDatabaseError(IOManagerMessageId::kErrorCannotOpenWriteAheadLog, m_dataDir,
+                ex.code().value(), ex.what());
+    }
+}
+
 void Instance::createSystemDatabase()
 {
     LOG_DEBUG << "Instance: Creating system database.";
@@ -5,10 +5,14 @@
 #pragma once
 
 // Project headers
+#include "ColumnDataBlockFinalizer.h"
+#include "ColumnDataBlockPool.h"
+#include "ColumnDataBlockScrubber.h"
 #include "DatabaseCache.h"
 #include "InstancePtr.h"
 #include "UserCache.h"
 #include "reg/DatabaseRegistry.h"
+#include "io/WriteAheadLog.h"
 #include "reg/UserRegistry.h"
 #include "../main/ClientSession.h"
 
@@ -21,6 +25,9 @@
 #include <mutex>
 #include <optional>
 
+// System headers
+#include <fcntl.h>
+
 namespace siodb::config {
 
 struct InstanceOptions;
@@ -29,6 +36,7 @@ struct InstanceOptions;
 
 namespace siodb::iomgr::dbengine {
 
+class Column;
 class SystemDatabase;
 
 /** DBMS instance */
@@ -86,12 +94,91 @@ public:
     }
 
     /**
-     * Returns block cache capacity.
-     * @return Block cache capacity.
+     * Returns size of the segment files which store column data blocks of new columns.
+     * @return Segment file size or zero if blocks of new columns are stored in own files.
+     */
+    auto getSegmentFileSize() const noexcept
+    {
+        return m_segmentFileSize;
+    }
+
+    /**
+     * Returns additional open flags for the column data block and index files.
+     * @return O_DIRECT if direct I/O is enabled, zero otherwise.
+     */
+    int getDirectIoOpenFlags() const noexcept
+    {
+        return m_enableDirectIo ? O_DIRECT : 0;
+    }
+
+    /**
+     * Returns memory used for sorting index keys when index is built.
+     * @return Index build memory in bytes.
+     */
+    auto getIndexBuildMemory() const noexcept
+    {
+        return m_indexBuildMemory;
+    }
+
+    /**
+     * Returns memory used for hash tables of the joined tables.
+     * @return Join memory in bytes.
+     */
+    auto getJoinMemory() const noexcept
+    {
+        return m_joinMemory;
+    }
+
+    /**
+     * Returns memory used for sorting SELECT results by ORDER BY.
+     * @return Sort memory in bytes.
+     */
+    auto getSortMemory() const noexcept
+    {
+        return m_sortMemory;
+    }
+
+    /**
+     * Returns memory used for the groups of the aggregated SELECT results.
+     * @return Aggregation memory in bytes.
+     */
+    auto getAggregationMemory() const noexcept
+    {
+        return m_aggregationMemory;
+    }
+
+    /**
+     * Returns write-ahead log.
+     * @return Write-ahead log or nullptr if data files are written synchronously.
+     */
+    io::WriteAheadLog* getWriteAheadLog() noexcept
+    {
+        return m_writeAheadLog.get();
+    }
+
+    /**
+     * Makes data file writes done so far durable. Does nothing
+     * if write-ahead log is disabled.
+     * @throw DatabaseError if write-ahead log can't be written.
      */
-    auto getBlockCacheCapacity() const noexcept
+    void commitWriteAheadLog();
+
+    /**
+     * Returns instance-wide column data block pool.
+     * @return Block pool.
+     */
+    ColumnDataBlockPool& getBlockPool() noexcept
     {
-        return m_blockCacheCapacity;
+        return m_blockPool;
+    }
+
+    /**
+     * Returns instance-wide column data block finalizer.
+     * @return Block finalizer or nullptr if blocks are finalized by the inserting thread.
+     */
+    ColumnDataBlockFinalizer* getBlockFinalizer() noexcept
+    {
+        return m_blockFinalizer.get();
     }
 
     /**
@@ -140,6 +227,15 @@ public:
      */
     DatabasePtr getDatabase(const std::string& databaseName);
 
+    /**
+     * Records column data block check error into the system database.
+     * @param column Column which block has failed check.
+     * @param blockId Block ID.
+     * @param error Error message.
+     */
+    void recordBlockCheckError(
+            const Column& column, std::uint64_t blockId, const std::string& error);
+
     /**
      * Creates new database object and writes all necessary on-disk data structures.
      * @param name Database name.
@@ -288,6 +384,9 @@ private:
     /** Ensures data directory exists */
     void ensureDataDir() const;
 
+    /** Opens write-ahead log, if enabled, and replays it into the data files */
+    void openWriteAheadLog();
+
     /** Creates system database */
     void createSystemDatabase();
 
@@ -451,6 +550,28 @@ private:
     /** Cache and registries access synchronization object */
     mutable std::mutex m_cacheMutex;
 
+    /** Indication that write-ahead log is enabled */
+    const bool m_enableWriteAheadLog;
+
+    /**
+     * Write-ahead log. Must be declared before any database object holders,
+     * because their files are written until they are destroyed.
+     */
+    std::unique_ptr<io::WriteAheadLog> m_writeAheadLog;
+
+    /**
+     * Column data block pool. Must be declared before any database object holders,
+     * because columns remove their blocks from it when destroyed.
+     */
+    ColumnDataBlockPool m_blockPool;
+
+    /**
+     * Column data block finalizer, nullptr if blocks are finalized by the inserting thread.
+     * Must be declared before any database object holders, because columns wait
+     * for finalization of their blocks when destroyed.
+     */
+    std::unique_ptr<ColumnDataBlockFinalizer> m_blockFinalizer;
+
     /** User registry. Contains information about all known users. */
     UserRegistry m_userRegistry;
 
@@ -472,8 +593,23 @@ private:
     /** Table cache capacity */
     const std::size_t m_tableCacheCapacity;
 
-    /** Block cache capacity */
-    const std::size_t m_blockCacheCapacity;
+    /** Segment file size */
+    const std::size_t m_segmentFileSize;
+
+    /** Indication that column data block and index files are opened with O_DIRECT */
+    const bool m_enableDirectIo;
+
+    /** Index build memory */
+    const std::size_t m_indexBuildMemory;
+
+    /** Join memory */
+    const std::size_t m_joinMemory;
+
+    /** Sort memory */
+    const std::size_t m_sortMemory;
+
+    /** Aggregation memory */
+    const std::size_t m_aggregationMemory;
 
     /* Metadata file descriptor */
     FileDescriptorGuard m_metadataFile;
@@ -499,6 +635,12 @@ private:
     /** Instance initialization completion flag file name */
     static constexpr const char* kInitializationFlagFile = "initialized";
 
+    /**
+     * Column data block scrubber, nullptr if it is disabled. Declared last,
+     * because it accesses all other members until it is destroyed.
+     */
+    std::unique_ptr<ColumnDataBlockScrubber> m_blockScrubber;
+
     /** Metadata file name */
     static constexpr const char* kMetadataFileName = "instance_metadata";
 };
@@ -0,0 +1,615 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "SecondaryIndex.h"
+
+// Project headers
+#include <siodb-generated/iomgr/lib/messages/IOManagerMessageId.h>
+#include "Column.h"
+#include "ColumnDataBlockZoneMap.h"
+#include "ExternalRecordSorter.h"
+#include "IndexColumn.h"
+#include "Instance.h"
+#include "ThrowDatabaseError.h"
+#include "ikt/BinaryIndexKeyTraits.h"
+
+// Common project headers
+#include <siodb/common/log/Log.h>
+#include <siodb/common/utils/PlainBinaryEncoding.h>
+
+// CRT headers
+#include <cstring>
+
+// STL headers
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <thread>
+
+// Boost headers
+#include <boost/endian/conversion.hpp>
+
+namespace siodb::iomgr::dbengine {
+
+namespace {
+
+/**
+ * Writes integer value in the big endian byte order, so that encoded values
+ * are ordered bytewise in the same way as values themselves.
+ * @param value Value.
+ * @param dest Destination buffer.
+ */
+template<typename IntType>
+void encodeBigEndian(IntType value, std::uint8_t* dest) noexcept
+{
+    value = boost::endian::native_to_big(value);
+    std::memcpy(dest, &value, sizeof(value));
+}
+
+/**
+ * Reads integer value written in the big endian byte order.
+ * @param src Source buffer.
+ * @return Value.
+ */
+template<typename IntType>
+IntType decodeBigEndian(const std::uint8_t* src) noexcept
+{
+    IntType value;
+    std::memcpy(&value, src, sizeof(value));
+    return boost::endian::big_to_native(value);
+}
+
+/**
+ * Inverts bytes of the encoded value of the descending column.
+ * @param data Encoded value.
+ * @param size Encoded value size.
+ */
+void invertBytes(std::uint8_t* data, std::size_t size) noexcept
+{
+    for (std::size_t i = 0; i < size; ++i)
+        data[i] = ~data[i];
+}
+
+}  // anonymous namespace
+
+/** Index build state shared by the scanning threads */
+struct SecondaryIndex::BuildState {
+    /**
+     * Initializes object of class BuildState.
+     * @param sorter Entry sorter.
+     * @param threadCount Number of the scanning threads.
+     * @param masterColumn Master column of the table.
+     * @param columns Indexed columns in the index column order.
+     */
+    BuildState(ExternalRecordSorter& sorter, std::size_t threadCount,
+            const ColumnPtr& masterColumn, std::vector<ColumnPtr>&& columns) noexcept
+        : m_sorter(sorter)
+        , m_masterColumn(masterColumn)
+        , m_columns(std::move(columns))
+        , m_runBufferSize(sorter.getRunBufferSize(threadCount))
+        , m_maxQueueSize(threadCount * kMaxQueuedBatchesPerThread)
+        , m_noMoreBatches(false)
+    {
+    }
+
+    /** Entry sorter */
+    ExternalRecordSorter& m_sorter;
+
+    /**
+     * Master column of the table. Columns are resolved before scanning threads start,
+     * because the table is locked by the building thread.
+     */
+    const ColumnPtr m_masterColumn;
+
+    /** Indexed columns */
+    const std::vector<ColumnPtr> m_columns;
+
+    /** Size of the entry buffer of the scanning thread */
+    const std::size_t m_runBufferSize;
+
+    /** Maximum number of queued batches */
+    const std::size_t m_maxQueueSize;
+
+    /** Synchronizes access to the state */
+    std::mutex m_mutex;
+
+    /** Signals change of the queue */
+    std::condition_variable m_queueCond;
+
+    /** Batches of the master column record addresses waiting for the scanning threads */
+    std::deque<std::vector<ColumnDataAddress>> m_queue;
+
+    /** Indication that all batches are queued */
+    bool m_noMoreBatches;
+
+    /** First error happened in the scanning thread */
+    std::exception_ptr m_error;
+};
+
+SecondaryIndex::SecondaryIndex(Table& table, const std::string& name, bool unique,
+        const IndexColumnSpecificationList& columns)
+    : BPlusTreeIndex(table, name,
+            BinaryIndexKeyTraits(computeKeySize(table, name, unique, columns)),
+            unique ? sizeof(std::uint64_t) : 0, nullptr, unique, columns, 0)
+    , m_keyColumns(makeKeyColumns())
+{
+}
+
+SecondaryIndex::SecondaryIndex(Table& table, const IndexRecord& indexRecord)
+    : BPlusTreeIndex(table, indexRecord,
+            BinaryIndexKeyTraits(computeKeySize(table, indexRecord)),
+            indexRecord.m_unique ? sizeof(std::uint64_t) : 0, nullptr)
+    , m_keyColumns(makeKeyColumns())
+{
+}
+
+bool SecondaryIndex::isKeyColumnPosition(std::uint32_t position) const noexcept
+{
+    return std::any_of(m_keyColumns.cbegin(), m_keyColumns.cend(),
+            [position](const auto& keyColumn) { return keyColumn.m_position == position; });
+}
+
+bool SecondaryIndex::makeEntry(const std::vector<const Variant*>& values, std::uint64_t trid,
+        std::uint8_t* entry) const
+{
+    for (std::size_t i = 0; i < m_keyColumns.size(); ++i) {
+        const auto& keyColumn = m_keyColumns[i];
+        const auto& value = *values[i];
+        if (value.isNull()) return false;
+        const auto dest = entry + keyColumn.m_offset;
+        if (!encodeValue(keyColumn, value, dest)) return false;
+        if (keyColumn.m_descending) invertBytes(dest, keyColumn.m_size);
+    }
+    encodeBigEndian(trid, entry + m_kvPairSize - sizeof(std::uint64_t));
+    return true;
+}
+
+bool SecondaryIndex::encodeConstant(
+        std::size_t index, const Variant& value, bool upper, std::uint8_t* key) const
+{
+    const auto& keyColumn = m_keyColumns[index];
+    const auto dest = key + keyColumn.m_offset;
+    switch (keyColumn.m_dataType) {
+        // Strings and binaries are compared with other types differently, so they are not used
+        case COLUMN_DATA_TYPE_TEXT: {
+            if (value.getValueType() != VariantType::kString) return false;
+            const auto& s = value.getString();
+            if (s.length() > kMaxIndexedValueLength) return false;
+            encodeBytes(keyColumn, s.data(), s.length(), dest);
+            break;
+        }
+
+        case COLUMN_DATA_TYPE_BINARY: {
+            if (value.getValueType() != VariantType::kBinary) return false;
+            const auto& b = value.getBinary();
+            if (b.size() > kMaxIndexedValueLength) return false;
+            encodeBytes(keyColumn, b.data(), b.size(), dest);
+            break;
+        }
+
+        case COLUMN_DATA_TYPE_TIMESTAMP: {
+            const auto zoneMapKey = getZoneMapKeyForConstant(keyColumn.m_dataType, value);
+            if (!zoneMapKey) return false;
+            // Nanoseconds are not encoded, so any nanoseconds may match. Keys of the
+            // descending column are inverted, so the largest key has the smallest value.
+            const bool largestValue = upper != keyColumn.m_descending;
+            encodeBigEndian(*zoneMapKey, dest);
+            encodeBigEndian(largestValue ? std::numeric_limits<std::uint32_t>::max() : 0U,
+                    dest + sizeof(std::uint64_t));
+            break;
+        }
+
+        case COLUMN_DATA_TYPE_BOOL: return false;
+
+        default: {
+            const auto zoneMapKey = getZoneMapKeyForConstant(keyColumn.m_dataType, value);
+            if (!zoneMapKey) return false;
+            encodeBigEndian(*zoneMapKey, dest);
+            break;
+        }
+    }
+    if (keyColumn.m_descending) invertBytes(dest, keyColumn.m_size);
+    return true;
+}
+
+bool SecondaryIndex::findTableRowIds(const std::uint8_t* lowerKey, const std::uint8_t* upperKey,
+        std::size_t maxCount, std::vector<std::uint64_t>& trids)
+{
+    std::vector<std::uint8_t> keys(m_keySize * 2);
+    auto key = keys.data();
+    auto nextKey = key + m_keySize;
+    bool found = count(lowerKey) > 0;
+    if (found)
+        std::memcpy(key, lowerKey, m_keySize);
+    else
+        found = getNextKey(lowerKey, key);
+
+    std::uint8_t value[sizeof(std::uint64_t)];
+    for (std::size_t n = 0; found && std::memcmp(key, upperKey, m_keySize) <= 0;) {
+        // TRID is value of the unique index and last part of the key of the non-unique one
+        const std::uint8_t* trid = key + m_keySize - sizeof(std::uint64_t);
+        if (m_unique) trid = (getValue(key, value, 1) == 1) ? value : nullptr;
+        // Entry could be erased after key is read
+        if (trid) {
+            if (n == maxCount) return false;
+            trids.push_back(decodeBigEndian<std::uint64_t>(trid));
+            ++n;
+        }
+        found = getNextKey(key, nextKey);
+        std::swap(key, nextKey);
+    }
+    return true;
+}
+
+void SecondaryIndex::checkEntry(const std::uint8_t* entry)
+{
+    if (m_unique && count(entry) > 0) throwUniqueIndexViolation();
+}
+
+void SecondaryIndex::insertEntry(const std::uint8_t* entry)
+{
+    if (!insert(entry, entry + m_keySize) && m_unique) throwUniqueIndexViolation();
+}
+
+void SecondaryIndex::eraseEntry(const std::uint8_t* entry)
+{
+    erase(entry);
+}
+
+void SecondaryIndex::build()
+{
+    const auto masterColumn = m_table.getMasterColumn();
+    const auto masterColumnIndex = masterColumn->getMasterColumnMainIndex();
+
+    // Obtain min and max TRID
+    std::uint8_t key[8];
+    std::uint64_t minTrid = 0, maxTrid = 0;
+    if (masterColumnIndex->getMinKey(key)) {
+        ::pbeDecodeUInt64(key, &minTrid);
+        if (masterColumnIndex->getMaxKey(key)) ::pbeDecodeUInt64(key, &maxTrid);
+    }
+
+    ExternalRecordSorter sorter(getDatabase(), m_dataDir, m_kvPairSize,
+            getDatabase().getInstance().getIndexBuildMemory());
+
+    if (minTrid <= maxTrid && maxTrid > 0) {
+        const std::size_t batchCount = (maxTrid - minTrid) / kBuildBatchSize + 1;
+        const std::size_t threadCount = std::min({static_cast<std::size_t>(std::max(
+                                                          std::thread::hardware_concurrency(), 1U)),
+                kMaxBuildThreadCount, batchCount});
+        std::vector<ColumnPtr> columns;
+        columns.reserve(m_keyColumns.size());
+        for (const auto& keyColumn : m_keyColumns)
+            columns.push_back(m_table.getColumnChecked(keyColumn.m_columnId));
+        BuildState state(sorter, threadCount, masterColumn, std::move(columns));
+
+        LOG_DEBUG << "Index " << getDisplayName() << ": Scanning TRIDs " << minTrid << ".."
+                  << maxTrid << " with " << threadCount << " threads";
+
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount);
+        try {
+            for (std::size_t i = 0; i < threadCount; ++i)
+                threads.emplace_back(&SecondaryIndex::scanRows, this, std::ref(state));
+
+            // Master column index is not thread-safe, so it is read by this thread only
+            std::vector<ColumnDataAddress> batch;
+            batch.reserve(kBuildBatchSize);
+            std::uint8_t value[12];
+            for (auto trid = minTrid; trid <= maxTrid; ++trid) {
+                ::pbeEncodeUInt64(trid, key);
+                if (masterColumnIndex->getValue(key, value, 1) == 0) continue;
+                ColumnDataAddress mcrAddress;
+                mcrAddress.pbeDeserialize(value, sizeof(value));
+                batch.push_back(mcrAddress);
+                if (batch.size() < kBuildBatchSize && trid < maxTrid) continue;
+
+                std::unique_lock lock(state.m_mutex);
+                state.m_queueCond.wait(lock, [&state] {
+                    return state.m_queue.size() < state.m_maxQueueSize || state.m_error;
+                });
+                if (state.m_error) break;
+                state.m_queue.push_back(std::move(batch));
+                lock.unlock();
+                state.m_queueCond.notify_all();
+                batch = std::vector<ColumnDataAddress>();
+                batch.reserve(kBuildBatchSize);
+            }
+        } catch (...) {
+            std::lock_guard lock(state.m_mutex);
+            if (!state.m_error) state.m_error = std::current_exception();
+        }
+
+        {
+            std::lock_guard lock(state.m_mutex);
+            state.m_noMoreBatches = true;
+        }
+        state.m_queueCond.notify_all();
+        for (auto& thread : threads)
+            thread.join();
+        if (state.m_error) std::rethrow_exception(state.m_error);
+    }
+
+    // Load sorted entries into the tree
+    const auto entryCount = sorter.getRecordCount();
+    LOG_DEBUG << "Index " << getDisplayName() << ": Loading " << entryCount << " entries";
+    sorter.startMerge();
+    std::vector<std::uint8_t> prevEntry(m_kvPairSize);
+    bool hasPrevEntry = false;
+    bulkLoad(entryCount, [&](std::uint8_t* entry) {
+        const auto record = sorter.next();
+        if (!record) throw std::logic_error("Sorted index entries are missing");
+        if (m_unique && hasPrevEntry && std::memcmp(prevEntry.data(), record, m_keySize) == 0)
+            throwUniqueIndexViolation();
+        std::memcpy(entry, record, m_kvPairSize);
+        std::memcpy(prevEntry.data(), record, m_kvPairSize);
+        hasPrevEntry = true;
+    });
+    flush();
+}
+
+// ----- internals -----
+
+std::size_t SecondaryIndex::computeKeySize(const Table& table, const std::string& name,
+        bool unique, const std::vector<std::pair<std::string, ColumnDataType>>& columnDataTypes)
+{
+    std::size_t keySize = unique ? 0 : sizeof(std::uint64_t);
+    for (const auto& e : columnDataTypes) {
+        const auto valueSize = getEncodedValueSize(e.second);
+        if (valueSize == 0) {
+            throwDatabaseError(IOManagerMessageId::kErrorIndexColumnTypeNotSupported,
+                    table.getDatabaseName(), table.getName(), e.first,
+                    getColumnDataTypeName(e.second));
+        }
+        keySize += valueSize;
+    }
+    if (keySize > kMaxKeySize) {
+        throwDatabaseError(IOManagerMessageId::kErrorIndexKeyTooLarge, table.getDatabaseName(),
+                table.getName(), name, keySize, kMaxKeySize);
+    }
+    return keySize;
+}
+
+std::size_t SecondaryIndex::computeKeySize(const Table& table, const std::string& name,
+        bool unique, const IndexColumnSpecificationList& columns)
+{
+    std::vector<std::pair<std::string, ColumnDataType>> columnDataTypes;
+    columnDataTypes.reserve(columns.size());
+    for (const auto& columnSpec : columns) {
+        const auto& column = columnSpec.m_columnDefinition->getColumn();
+        columnDataTypes.emplace_back(column.getName(), column.getDataType());
+    }
+    return computeKeySize(table, name, unique, columnDataTypes);
+}
+
+std::size_t SecondaryIndex::computeKeySize(Table& table, const IndexRecord& indexRecord)
+{
+    std::vector<std::pair<std::string, ColumnDataType>> columnDataTypes;
+    columnDataTypes.reserve(indexRecord.m_columns.size());
+    for (const auto& indexColumnRecord : indexRecord.m_columns.byId()) {
+        const auto& column =
+                table.getColumnDefinitionChecked(indexColumnRecord.m_columnDefinitionId)
+                        ->getColumn();
+        columnDataTypes.emplace_back(column.getName(), column.getDataType());
+    }
+    return computeKeySize(table, indexRecord.m_name, indexRecord.m_unique, columnDataTypes);
+}
+
+std::size_t SecondaryIndex::getEncodedValueSize(ColumnDataType dataType) noexcept
+{
+    switch (dataType) {
+        case COLUMN_DATA_TYPE_BOOL: return 1;
+        case COLUMN_DATA_TYPE_INT8:
+        case COLUMN_DATA_TYPE_UINT8:
+        case COLUMN_DATA_TYPE_INT16:
+        case COLUMN_DATA_TYPE_UINT16:
+        case COLUMN_DATA_TYPE_INT32:
+        case COLUMN_DATA_TYPE_UINT32:
+        case COLUMN_DATA_TYPE_INT64:
+        case COLUMN_DATA_TYPE_UINT64:
+        case COLUMN_DATA_TYPE_FLOAT:
+        case COLUMN_DATA_TYPE_DOUBLE: return sizeof(std::uint64_t);
+        // Zone map key and nanoseconds
+        case COLUMN_DATA_TYPE_TIMESTAMP: return sizeof(std::uint64_t) + sizeof(std::uint32_t);
+        // Zero padded value and its length
+        case COLUMN_DATA_TYPE_TEXT:
+        case COLUMN_DATA_TYPE_BINARY: return kMaxIndexedValueLength + sizeof(std::uint16_t);
+        default: return 0;
+    }
+}
+
+std::vector<SecondaryIndex::KeyColumn> SecondaryIndex::makeKeyColumns() const
+{
+    std::vector<KeyColumn> keyColumns;
+    keyColumns.reserve(m_columns.size());
+    std::size_t offset = 0;
+    for (const auto& indexColumn : m_columns) {
+        const auto& column = indexColumn->getColumnDefinition()->getColumn();
+        KeyColumn keyColumn;
+        keyColumn.m_columnId = column.getId();
+        keyColumn.m_name = column.getName();
+        keyColumn.m_position = m_table.getColumnCurrentPosition(keyColumn.m_columnId);
+        keyColumn.m_dataType = column.getDataType();
+        keyColumn.m_descending = indexColumn->isDescendingSortOrder();
+        keyColumn.m_offset = offset;
+        keyColumn.m_size = getEncodedValueSize(keyColumn.m_dataType);
+        offset += keyColumn.m_size;
+        keyColumns.push_back(keyColumn);
+    }
+    return keyColumns;
+}
+
+bool SecondaryIndex::encodeValue(
+        const KeyColumn& keyColumn, const Variant& value, std::uint8_t* dest) const
+{
+    // Values are cast to the column data type in the same way as Column::putRecord() does.
+    // If cast fails, row is not written at all, so it is not indexed either.
+    try {
+        switch (keyColumn.m_dataType) {
+            case COLUMN_DATA_TYPE_BOOL: {
+                *dest = value.asBool() ? 1 : 0;
+                return true;
+            }
+
+            case COLUMN_DATA_TYPE_TEXT: {
+                switch (value.getValueType()) {
+                    case VariantType::kString: {
+                        const auto& s = value.getString();
+                        encodeBytes(keyColumn, s.data(), s.length(), dest);
+                        return true;
+                    }
+                    case VariantType::kClob:
+                    case VariantType::kBlob: throwValueTooLong(keyColumn);
+                    default: {
+                        const auto s = value.asString();
+                        encodeBytes(keyColumn, s->data(), s->length(), dest);
+                        return true;
+                    }
+                }
+            }
+
+            case COLUMN_DATA_TYPE_BINARY: {
+                switch (value.getValueType()) {
+                    case VariantType::kBinary: {
+                        const auto& b = value.getBinary();
+                        encodeBytes(keyColumn, b.data(), b.size(), dest);
+                        return true;
+                    }
+                    case VariantType::kClob:
+                    case VariantType::kBlob: throwValueTooLong(keyColumn);
+                    default: {
+                        const auto b = value.asBinary();
+                        encodeBytes(keyColumn, b->data(), b->size(), dest);
+                        return true;
+                    }
+                }
+            }
+
+            case COLUMN_DATA_TYPE_TIMESTAMP: {
+                const auto dateTime = value.getValueType() == VariantType::kDateTime
+                                              ? value.getDateTime()
+                                              : value.asDateTime();
+                encodeBigEndian(*getZoneMapKey(keyColumn.m_dataType, Variant(dateTime)), dest);
+                encodeBigEndian(static_cast<std::uint32_t>(dateTime.m_timePart.m_nanos),
+                        dest + sizeof(std::uint64_t));
+                return true;
+            }
+
+            default: break;
+        }
+
+        Variant v;
+        switch (keyColumn.m_dataType) {
+            case COLUMN_DATA_TYPE_INT8: v = value.asInt8(); break;
+            case COLUMN_DATA_TYPE_UINT8: v = value.asUInt8(); break;
+            case COLUMN_DATA_TYPE_INT16: v = value.asInt16(); break;
+            case COLUMN_DATA_TYPE_UINT16: v = value.asUInt16(); break;
+            case COLUMN_DATA_TYPE_INT32: v = value.asInt32(); break;
+            case COLUMN_DATA_TYPE_UINT32: v = value.asUInt32(); break;
+            case COLUMN_DATA_TYPE_INT64: v = value.asInt64(); break;
+            case COLUMN_DATA_TYPE_UINT64: v = value.asUInt64(); break;
+            case COLUMN_DATA_TYPE_FLOAT: v = value.asFloat(); break;
+            case COLUMN_DATA_TYPE_DOUBLE: v = value.asDouble(); break;
+            default: throw std::logic_error("invalid data type");
+        }
+
+        // NaN has no key
+        const auto zoneMapKey = getZoneMapKey(keyColumn.m_dataType, v);
+        if (!zoneMapKey) return false;
+        encodeBigEndian(*zoneMapKey, dest);
+        return true;
+    } catch (std::logic_error&) {
+        return false;
+    }
+}
+
+void SecondaryIndex::encodeBytes(const KeyColumn& keyColumn, const void* data,
+        std::size_t length, std::uint8_t* dest) const
+{
+    if (length > kMaxIndexedValueLength) throwValueTooLong(keyColumn);
+    if (length > 0) std::memcpy(dest, data, length);
+    std::memset(dest + length, 0, kMaxIndexedValueLength - length);
+    encodeBigEndian(static_cast<std::uint16_t>(length), dest + kMaxIndexedValueLength);
+}
+
+void SecondaryIndex::throwValueTooLong(const KeyColumn& keyColumn) const
+{
+    throwDatabaseError(IOManagerMessageId::kErrorIndexValueTooLong, getDatabaseName(),
+            m_table.getName(), keyColumn.m_name, m_name, kMaxIndexedValueLength);
+}
+
+void SecondaryIndex::throwUniqueIndexViolation() const
+{
+    throwDatabaseError(IOManagerMessageId::kErrorUniqueIndexViolation, getDatabaseName(),
+            m_table.getName(), m_name);
+}
+
+void SecondaryIndex::scanRows(BuildState& state) const
+{
+    try {
+        std::vector<std::uint8_t> run;
+        run.reserve(state.m_runBufferSize);
+        std::vector<std::uint64_t> trids;
+        std::vector<std::vector<ColumnDataAddress>> addresses(m_keyColumns.size());
+        std::vector<std::vector<Variant>> values(m_keyColumns.size());
+        std::vector<const Variant*> rowValues(m_keyColumns.size());
+        std::vector<std::uint8_t> entry(m_kvPairSize);
+        MasterColumnRecord mcr;
+
+        while (true) {
+            std::vector<ColumnDataAddress> batch;
+            {
+                std::unique_lock lock(state.m_mutex);
+                state.m_queueCond.wait(lock, [&state] {
+                    return !state.m_queue.empty() || state.m_noMoreBatches || state.m_error;
+                });
+                if (state.m_error || state.m_queue.empty()) break;
+                batch = std::move(state.m_queue.front());
+                state.m_queue.pop_front();
+            }
+            state.m_queueCond.notify_all();
+
+            // Collect value addresses of the indexed columns
+            trids.clear();
+            for (auto& columnAddresses : addresses)
+                columnAddresses.clear();
+            for (const auto& mcrAddress : batch) {
+                state.m_masterColumn->readMasterColumnRecord(mcrAddress, mcr);
+                trids.push_back(mcr.getTableRowId());
+                const auto& columnRecords = mcr.getColumnRecords();
+                for (std::size_t i = 0; i < m_keyColumns.size(); ++i) {
+                    // Normal column positions start from 1, column at position 0 is master column
+                    const auto recordIndex = m_keyColumns[i].m_position - 1;
+                    addresses[i].push_back(recordIndex < columnRecords.size()
+                                                   ? columnRecords[recordIndex].getAddress()
+                                                   : kNullValueAddress);
+                }
+            }
+
+            // Read values column by column and make entries
+            for (std::size_t i = 0; i < m_keyColumns.size(); ++i)
+                state.m_columns[i]->readRecords(addresses[i], values[i], false);
+            for (std::size_t row = 0; row < trids.size(); ++row) {
+                for (std::size_t i = 0; i < m_keyColumns.size(); ++i)
+                    rowValues[i] = &values[i][row];
+                if (!makeEntry(rowValues, trids[row], entry.data())) continue;
+                run.insert(run.end(), entry.cbegin(), entry.cend());
+                if (run.size() >= state.m_runBufferSize) {
+                    state.m_sorter.addRun(run);
+                    run.reserve(state.m_runBufferSize);
+                }
+            }
+        }
+        state.m_sorter.addRun(run);
+    } catch (...) {
+        {
+            std::lock_guard lock(state.m_mutex);
+            if (!state.m_error) state.m_error = std::current_exception();
+        }
+        state.m_queueCond.notify_all();
+    }
+}
+
+}  // namespace siodb::iomgr::dbengine
@@ -0,0 +1,298 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "SecondaryIndexPtr.h"
+#include "bpt/BPlusTreeIndex.h"
+
+namespace siodb::iomgr::dbengine {
+
+class Column;
+
+/**
+ * Secondary index on one or more table columns, created with CREATE INDEX.
+ * Index entry consists of the encoded column values followed by the TRID.
+ * Encoded values are compared bytewise in the order of the column values
+ * (descending columns are inverted). In the unique index, encoded values
+ * are the key and TRID is the value. In the non-unique index, TRID is
+ * part of the key, so that equal column values are allowed.
+ * Rows having NULL (or NaN) in any indexed column are not indexed.
+ */
+class SecondaryIndex final : public BPlusTreeIndex {
+public:
+    /**
+     * Initializes object of class SecondaryIndex for a new index.
+     * @param table A table to which this index belongs.
+     * @param name Index name.
+     * @param unique Index uniqueness flag.
+     * @param columns Indexed columns.
+     * @throw DatabaseError if column can't be indexed or key is too large.
+     */
+    SecondaryIndex(Table& table, const std::string& name, bool unique,
+            const IndexColumnSpecificationList& columns);
+
+    /**
+     * Initializes object of class SecondaryIndex for an existing index.
+     * @param table A table to which this index belongs.
+     * @param indexRecord Index record.
+     */
+    SecondaryIndex(Table& table, const IndexRecord& indexRecord);
+
+    /**
+     * Returns size of the index entry: encoded column values and TRID.
+     * @return Entry size in bytes.
+     */
+    std::size_t getEntrySize() const noexcept
+    {
+        return m_kvPairSize;
+    }
+
+    /**
+     * Returns number of the indexed columns.
+     * @return Number of the indexed columns.
+     */
+    std::size_t getKeyColumnCount() const noexcept
+    {
+        return m_keyColumns.size();
+    }
+
+    /**
+     * Returns table column ID of the indexed column.
+     * @param index Indexed column index.
+     * @return Table column ID.
+     */
+    std::uint64_t getKeyColumnId(std::size_t index) const noexcept
+    {
+        return m_keyColumns[index].m_columnId;
+    }
+
+    /**
+     * Returns current position of the indexed column in the table.
+     * @param index Indexed column index.
+     * @return Column position.
+     */
+    std::uint32_t getKeyColumnPosition(std::size_t index) const noexcept
+    {
+        return m_keyColumns[index].m_position;
+    }
+
+    /**
+     * Returns indication that the indexed column is sorted in the descending order.
+     * @param index Indexed column index.
+     * @return true if column is sorted in the descending order, false otherwise.
+     */
+    bool isKeyColumnDescending(std::size_t index) const noexcept
+    {
+        return m_keyColumns[index].m_descending;
+    }
+
+    /**
+     * Returns indication that given table column is indexed.
+     * @param position Column position in the table.
+     * @return true if column is indexed, false otherwise.
+     */
+    bool isKeyColumnPosition(std::uint32_t position) const noexcept;
+
+    /**
+     * Makes index entry of the table row.
+     * @param values Values of the indexed columns, in the order of the indexed columns.
+     * @param trid Table row ID.
+     * @param entry Entry buffer, must be at least entry size long.
+     * @return true if entry is made, false if row is not indexed.
+     * @throw DatabaseError if value is too long to be indexed.
+     */
+    bool makeEntry(const std::vector<const Variant*>& values, std::uint64_t trid,
+            std::uint8_t* entry) const;
+
+    /**
+     * Encodes constant, which is compared with the indexed column value, into the key.
+     * Keys of the column values equal to the constant are between the keys encoded with
+     * upper set to false and true. Encoding may be less precise than the column values,
+     * e.g. nanoseconds of the timestamp constant are not encoded.
+     * @param index Indexed column index.
+     * @param value Constant value.
+     * @param upper Indicates that the largest key is needed, otherwise the smallest one.
+     * @param key Key buffer. Only bytes of the indexed column are written.
+     * @return true if constant is encoded, false if it can't be used to search the index.
+     */
+    bool encodeConstant(
+            std::size_t index, const Variant& value, bool upper, std::uint8_t* key) const;
+
+    /**
+     * Collects TRIDs of the rows which have keys in the given range.
+     * @param lowerKey Lower key, inclusive.
+     * @param upperKey Upper key, inclusive.
+     * @param maxCount Maximum number of TRIDs to collect.
+     * @param[out] trids TRIDs are appended here in the key order.
+     * @return true if all TRIDs are collected, false if there are more than maxCount TRIDs.
+     */
+    bool findTableRowIds(const std::uint8_t* lowerKey, const std::uint8_t* upperKey,
+            std::size_t maxCount, std::vector<std::uint64_t>& trids);
+
+    /**
+     * Checks that entry can be added to the index without violation of uniqueness.
+     * @param entry Index entry.
+     * @throw DatabaseError if unique index already contains the same key.
+     */
+    void checkEntry(const std::uint8_t* entry);
+
+    /**
+     * Adds entry to the index.
+     * @param entry Index entry.
+     * @throw DatabaseError if unique index already contains the same key.
+     */
+    void insertEntry(const std::uint8_t* entry);
+
+    /**
+     * Removes entry from the index.
+     * @param entry Index entry.
+     */
+    void eraseEntry(const std::uint8_t* entry);
+
+    /**
+     * Fills new index with the entries of the existing table rows. Rows are read
+     * by multiple threads, their entries are sorted externally and then loaded
+     * into the B+ tree bottom-up. Table modifications must be blocked by caller.
+     * @throw DatabaseError if reading rows or writing index failed, or if unique
+     *                      index key is duplicated.
+     */
+    void build();
+
+private:
+    /** Indexed column information */
+    struct KeyColumn {
+        /** Table column ID */
+        std::uint64_t m_columnId;
+
+        /** Column name */
+        std::string m_name;
+
+        /** Column position in the table */
+        std::uint32_t m_position;
+
+        /** Column data type */
+        ColumnDataType m_dataType;
+
+        /** Descending sort order flag */
+        bool m_descending;
+
+        /** Offset of the encoded value in the entry */
+        std::size_t m_offset;
+
+        /** Encoded value size */
+        std::size_t m_size;
+    };
+
+    /** Index build state shared by the scanning threads */
+    struct BuildState;
+
+private:
+    /**
+     * Computes size of the index key.
+     * @param table Table object.
+     * @param name Index name.
+     * @param unique Index uniqueness flag.
+     * @param columnDataTypes Data types of the indexed columns.
+     * @return Key size in bytes.
+     * @throw DatabaseError if column can't be indexed or key is too large.
+     */
+    static std::size_t computeKeySize(const Table& table, const std::string& name, bool unique,
+            const std::vector<std::pair<std::string, ColumnDataType>>& columnDataTypes);
+
+    /**
+     * Computes size of the index key for a new index.
+     * @param table Table object.
+     * @param name Index name.
+     * @param unique Index uniqueness flag.
+     * @param columns Indexed columns.
+     * @return Key size in bytes.
+     */
+    static std::size_t computeKeySize(const Table& table, const std::string& name, bool unique,
+            const IndexColumnSpecificationList& columns);
+
+    /**
+     * Computes size of the index key for an existing index.
+     * @param table Table object.
+     * @param indexRecord Index record.
+     * @return Key size in bytes.
+     */
+    static std::size_t computeKeySize(Table& table, const IndexRecord& indexRecord);
+
+    /**
+     * Returns size of the encoded value of the given data type.
+     * @param dataType Column data type.
+     * @return Encoded value size or zero if data type can't be indexed.
+     */
+    static std::size_t getEncodedValueSize(ColumnDataType dataType) noexcept;
+
+    /**
+     * Collects information about indexed columns.
+     * @return Indexed columns.
+     */
+    std::vector<KeyColumn> makeKeyColumns() const;
+
+    /**
+     * Encodes column value.
+     * @param keyColumn Indexed column.
+     * @param value Column value, not NULL.
+     * @param dest Destination buffer.
+     * @return true if value is encoded, false if value is not indexed.
+     * @throw DatabaseError if value is too long.
+     */
+    bool encodeValue(const KeyColumn& keyColumn, const Variant& value, std::uint8_t* dest) const;
+
+    /**
+     * Encodes string or binary value.
+     * @param keyColumn Indexed column.
+     * @param data Value data.
+     * @param length Value length.
+     * @param dest Destination buffer.
+     * @throw DatabaseError if value is too long.
+     */
+    void encodeBytes(const KeyColumn& keyColumn, const void* data, std::size_t length,
+            std::uint8_t* dest) const;
+
+    /**
+     * Throws error about value which is too long to be indexed.
+     * @param keyColumn Indexed column.
+     * @throw DatabaseError always.
+     */
+    [[noreturn]] void throwValueTooLong(const KeyColumn& keyColumn) const;
+
+    /**
+     * Throws unique index violation error.
+     * @throw DatabaseError always.
+     */
+    [[noreturn]] void throwUniqueIndexViolation() const;
+
+    /**
+     * Reads rows from the master column record addresses and adds their entries to the sorter.
+     * Runs in the scanning thread.
+     * @param state Build state.
+     */
+    void scanRows(BuildState& state) const;
+
+private:
+    /** Indexed columns */
+    const std::vector<KeyColumn> m_keyColumns;
+
+    /** Maximum length of the indexed string or binary value */
+    static constexpr std::size_t kMaxIndexedValueLength = 128;
+
+    /** Maximum size of the index key */
+    static constexpr std::size_t kMaxKeySize = 1024;
+
+    /** Number of rows passed to the scanning thread at once */
+    static constexpr std::size_t kBuildBatchSize = 1024;
+
+    /** Maximum number of batches waiting for the scanning threads, per thread */
+    static constexpr std::size_t kMaxQueuedBatchesPerThread = 4;
+
+    /** Maximum number of the scanning threads */
+    static constexpr std::size_t kMaxBuildThreadCount = 8;
+};
+
+}  // namespace siodb::iomgr::dbengine
@@ -0,0 +1,251 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "SortKey.h"
+
+// Common project headers
+#include <siodb/common/utils/PlainBinaryEncoding.h>
+
+// CRT headers
+#include <cmath>
+#include <cstring>
+
+// STL headers
+#include <limits>
+
+// Boost headers
+#include <boost/endian/conversion.hpp>
+
+namespace siodb::iomgr::dbengine {
+
+namespace {
+
+/** Value categories, in the sort order */
+enum SortKeyCategory : std::uint8_t {
+    kSortKeyNull = 0,
+    kSortKeyBool,
+    kSortKeyNumeric,
+    kSortKeyDateTime,
+    kSortKeyString,
+    kSortKeyBinary,
+};
+
+/** Prefixes of the exact numeric value, in the sort order */
+enum SortKeyNumericPrefix : std::uint8_t {
+    kSortKeyBelowInt64 = 0,
+    kSortKeyNegativeInteger,
+    kSortKeyNonNegativeInteger,
+    kSortKeyAboveUInt64,
+};
+
+/**
+ * Appends integer value in the big endian byte order, so that encoded values
+ * are ordered bytewise in the same way as values themselves.
+ * @param value Value.
+ * @param key Key buffer.
+ */
+template<typename IntType>
+void appendBigEndian(IntType value, std::vector<std::uint8_t>& key)
+{
+    value = boost::endian::native_to_big(value);
+    const auto p = reinterpret_cast<const std::uint8_t*>(&value);
+    key.insert(key.end(), p, p + sizeof(value));
+}
+
+/**
+ * Appends floating point value, so that encoded values are ordered bytewise in the same way
+ * as values themselves. Negative zero is equal to positive zero, NaN is the largest value.
+ * @param value Value.
+ * @param key Key buffer.
+ */
+void appendDouble(double value, std::vector<std::uint8_t>& key)
+{
+    std::uint64_t bits = std::numeric_limits<std::uint64_t>::max();
+    if (!std::isnan(value)) {
+        if (value == 0.0) value = 0.0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        bits = (bits & (std::uint64_t(1) << 63)) ? ~bits : bits | (std::uint64_t(1) << 63);
+    }
+    appendBigEndian(bits, key);
+}
+
+/**
+ * Appends numeric value. Approximate floating point value goes first, it orders values
+ * of all numeric types. It is followed by the exact integer value, which orders integers
+ * that can't be represented in the floating point exactly.
+ * @param value Numeric value.
+ * @param key Key buffer.
+ */
+void appendNumeric(const Variant& value, std::vector<std::uint8_t>& key)
+{
+    if (value.isFloatingPoint()) {
+        const double d = value.getValueType() == VariantType::kFloat ? value.getFloat()
+                                                                     : value.getDouble();
+        appendDouble(d, key);
+        // Integral floating point value is equal to the same integer value
+        constexpr double kMinInt64 = -9223372036854775808.0;
+        constexpr double kMaxUInt64Bound = 18446744073709551616.0;
+        if (std::isnan(d) || std::trunc(d) != d) {
+            key.push_back(kSortKeyNonNegativeInteger);
+            appendBigEndian(std::uint64_t(0), key);
+        } else if (d < kMinInt64) {
+            key.push_back(kSortKeyBelowInt64);
+            appendBigEndian(std::uint64_t(0), key);
+        } else if (d < 0.0) {
+            key.push_back(kSortKeyNegativeInteger);
+            appendBigEndian(static_cast<std::uint64_t>(static_cast<std::int64_t>(d)), key);
+        } else if (d < kMaxUInt64Bound) {
+            key.push_back(kSortKeyNonNegativeInteger);
+            appendBigEndian(static_cast<std::uint64_t>(d), key);
+        } else {
+            key.push_back(kSortKeyAboveUInt64);
+            appendBigEndian(std::uint64_t(0), key);
+        }
+        return;
+    }
+
+    if (value.getValueType() == VariantType::kUInt64) {
+        const auto v = value.getUInt64();
+        appendDouble(static_cast<double>(v), key);
+        key.push_back(kSortKeyNonNegativeInteger);
+        appendBigEndian(v, key);
+        return;
+    }
+
+    const auto v = value.asInt64();
+    appendDouble(static_cast<double>(v), key);
+    // Negative values in two's complement are ordered as unsigned values
+    key.push_back(v < 0 ? kSortKeyNegativeInteger : kSortKeyNonNegativeInteger);
+    appendBigEndian(static_cast<std::uint64_t>(v), key);
+}
+
+/**
+ * Appends bytes so that byte sequences are ordered bytewise and none of them
+ * is a prefix of another one: zero byte is escaped as 0x00 0xFF and sequence
+ * is terminated by 0x00 0x00.
+ * @param data Bytes.
+ * @param size Number of bytes.
+ * @param key Key buffer.
+ */
+void appendBytes(const std::uint8_t* data, std::size_t size, std::vector<std::uint8_t>& key)
+{
+    key.reserve(key.size() + size + 2);
+    for (std::size_t i = 0; i < size; ++i) {
+        key.push_back(data[i]);
+        if (data[i] == 0) key.push_back(0xFF);
+    }
+    key.push_back(0);
+    key.push_back(0);
+}
+
+/**
+ * Appends LOB value.
+ * @param value CLOB or BLOB value.
+ * @param key Key buffer.
+ * @throw std::runtime_error if LOB can't be read.
+ */
+void appendLob(const Variant& value, std::vector<std::uint8_t>& key)
+{
+    // Serialized value consists of the type, the length and the LOB contents
+    std::vector<std::uint8_t> buffer(value.getSerializedSize());
+    if (!value.serializeUnchecked(buffer.data())) throw std::runtime_error("Can't read LOB");
+    std::uint32_t length = 0;
+    const int consumed = ::decodeVarInt(buffer.data() + 1, buffer.size() - 1, length);
+    if (consumed < 0 || buffer.size() - 1 - consumed < length)
+        throw std::runtime_error("Can't read LOB");
+    appendBytes(buffer.data() + 1 + consumed, length, key);
+}
+
+}  // anonymous namespace
+
+void appendSortKey(const Variant& value, bool descending, std::vector<std::uint8_t>& key)
+{
+    const auto start = key.size();
+    switch (value.getValueType()) {
+        case VariantType::kNull: {
+            key.push_back(kSortKeyNull);
+            break;
+        }
+
+        case VariantType::kBool: {
+            key.push_back(kSortKeyBool);
+            key.push_back(value.getBool() ? 1 : 0);
+            break;
+        }
+
+        case VariantType::kInt8:
+        case VariantType::kUInt8:
+        case VariantType::kInt16:
+        case VariantType::kUInt16:
+        case VariantType::kInt32:
+        case VariantType::kUInt32:
+        case VariantType::kInt64:
+        case VariantType::kUInt64:
+        case VariantType::kFloat:
+        case VariantType::kDouble: {
+            key.push_back(kSortKeyNumeric);
+            appendNumeric(value, key);
+            break;
+        }
+
+        case VariantType::kDateTime: {
+            // Date without time part is the same as date with zero time
+            const auto& dt = value.getDateTime();
+            const bool hasTimePart = dt.m_datePart.m_hasTimePart;
+            key.push_back(kSortKeyDateTime);
+            const auto year = static_cast<std::uint32_t>(dt.m_datePart.m_year + (1 << 18));
+            key.push_back(static_cast<std::uint8_t>(year >> 16));
+            key.push_back(static_cast<std::uint8_t>(year >> 8));
+            key.push_back(static_cast<std::uint8_t>(year));
+            key.push_back(static_cast<std::uint8_t>(dt.m_datePart.m_month));
+            key.push_back(static_cast<std::uint8_t>(dt.m_datePart.m_dayOfMonth));
+            key.push_back(static_cast<std::uint8_t>(hasTimePart ? dt.m_timePart.m_hours : 0));
+            key.push_back(static_cast<std::uint8_t>(hasTimePart ? dt.m_timePart.m_minutes : 0));
+            key.push_back(static_cast<std::uint8_t>(hasTimePart ? dt.m_timePart.m_seconds : 0));
+            appendBigEndian(
+                    static_cast<std::uint32_t>(hasTimePart ? dt.m_timePart.m_nanos : 0), key);
+            break;
+        }
+
+        case VariantType::kString: {
+            const auto& s = value.getString();
+            key.push_back(kSortKeyString);
+            appendBytes(reinterpret_cast<const std::uint8_t*>(s.data()), s.length(), key);
+            break;
+        }
+
+        case VariantType::kBinary: {
+            const auto& b = value.getBinary();
+            key.push_back(kSortKeyBinary);
+            appendBytes(b.data(), b.size(), key);
+            break;
+        }
+
+        case VariantType::kClob: {
+            key.push_back(kSortKeyString);
+            appendLob(value, key);
+            break;
+        }
+
+        case VariantType::kBlob: {
+            key.push_back(kSortKeyBinary);
+            appendLob(value, key);
+            break;
+        }
+
+        default: {
+            throw std::runtime_error(
+                    "Values of type " + std::to_string(static_cast<int>(value.getValueType()))
+                    + " can't be sorted");
+        }
+    }
+
+    // Inverted keys are ordered in reverse, since no key is a prefix of another one
+    if (descending) {
+        for (auto i = start; i < key.size(); ++i)
+            key[i] = ~key[i];
+    }
+}
+
+}  // namespace siodb::iomgr::dbengine
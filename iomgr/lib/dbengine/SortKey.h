@@ -0,0 +1,28 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "Variant.h"
+
+// STL headers
+#include <vector>
+
+namespace siodb::iomgr::dbengine {
+
+/**
+ * Appends normalized sort key of the value to the key buffer. Keys of the values are
+ * compared bytewise in the same order as values: NULL goes first, then boolean, numeric,
+ * date/time, string and binary values. Numeric values of different types are compared
+ * by their numeric value. Key of the value is never a prefix of key of another value,
+ * so keys of the several values appended one after another are compared term by term.
+ * @param value Value.
+ * @param descending Indication that values are sorted in the descending order.
+ * @param[out] key Key buffer.
+ * @throw std::runtime_error if value type can't be sorted or LOB can't be read.
+ */
+void appendSortKey(const Variant& value, bool descending, std::vector<std::uint8_t>& key);
+
+}  // namespace siodb::iomgr::dbengine
@@ -64,12 +64,7 @@ SystemDatabase::SystemDatabase(Instance& instance, const std::string& cipherId,
     const std::vector<ColumnConstraintSpecification> noConstraintsSpec;
 
     // Column constraint specification list with single "NOT NULL" constraint
-    // and empty name, which will cause automatic constraint name generation
-    const ColumnConstraintSpecificationList notNullConstraintSpec {
-            ColumnConstraintSpecification(std::string(), ConstraintType::kNotNull,
-                    requests::ExpressionPtr(
-                            m_systemNotNullConstraintDefinition->getExpression().clone())),
-    };
+    const auto notNullConstraintSpec = makeNotNullConstraintSpec();
 
     // Create table SYS_USERS
     m_sysUsersTable = createTableUnlocked(kSysUsersTable, TableType::kDisk, kFirstUserUserId);
@@ -180,6 +175,10 @@ SystemDatabase::SystemDatabase(Instance& instance, const std::string& cipherId,
         block->setState(ColumnDataBlockState::kCurrent);
     }
 
+    // Create table SYS_BLOCK_CHECKS
+    m_sysBlockChecksTable = createSysBlockChecksTable(notNullConstraintSpec);
+    allTables.push_back(m_sysBlockChecksTable);
+
     const auto& tp = m_metadata->getInitTransactionParams();
 
     // Record all tables and related objects
@@ -210,6 +209,18 @@ SystemDatabase::SystemDatabase(
     , m_sysDatabasesTable(loadSystemTable(kSysDatabasesTable))
     , m_sysUserPermissionsTable(loadSystemTable(kSysUserPermissionsTable))
 {
+    if (isTableExists(kSysBlockChecksTable)) {
+        m_sysBlockChecksTable = loadSystemTable(kSysBlockChecksTable);
+        return;
+    }
+
+    // Instance has been created by the earlier version
+    LOG_INFO << "Database " << m_name << ": Creating missing system table "
+             << kSysBlockChecksTable;
+    m_sysBlockChecksTable = createSysBlockChecksTable(makeNotNullConstraintSpec());
+    const TransactionParameters tp(User::kSuperUserId, generateNextTransactionId());
+    recordTableDefinition(*m_sysBlockChecksTable, tp);
+    saveSystemObjectsInfo();
 }
 
 bool SystemDatabase::isSystemDatabase() const noexcept
@@ -471,6 +482,22 @@ void SystemDatabase::recordUserPermission(
     m_sysUserPermissionsTable->insertRow(values, tp, permission.getId());
 }
 
+void SystemDatabase::recordBlockCheckError(const Column& column, std::uint64_t blockId,
+        const std::string& error, const TransactionParameters& tp)
+{
+    LOG_DEBUG << "Database " << m_name << ": Recording check error of the block "
+              << column.getDisplayName() << '.' << blockId;
+    std::vector<Variant> values(m_sysBlockChecksTable->getColumnCount() - 1);
+    std::size_t i = 0;
+    values.at(i++) = column.getDatabase().getId();
+    values.at(i++) = column.getTableId();
+    values.at(i++) = column.getId();
+    values.at(i++) = blockId;
+    values.at(i++) = static_cast<std::uint64_t>(std::time(nullptr));
+    values.at(i++) = error;
+    m_sysBlockChecksTable->insertRow(values, tp);
+}
+
 void SystemDatabase::deleteDatabase(std::uint32_t databaseId, std::uint32_t currentUserId)
 {
     const TransactionParameters tp(currentUserId, generateNextTransactionId());
@@ -680,4 +707,42 @@ std::size_t SystemDatabase::readAllUserAccessKeys(UserAccessKeyRegistries& userA
     return keyCount;
 }
 
+TablePtr SystemDatabase::createSysBlockChecksTable(
+        const ColumnConstraintSpecificationList& notNullConstraintSpec)
+{
+    auto table = createTableUnlocked(kSysBlockChecksTable, TableType::kDisk, 0);
+    std::vector<ColumnPtr> columns;
+    columns.push_back(table->getMasterColumn());
+    columns.push_back(table->createColumn(ColumnSpecification(kSysBlockChecks_DatabaseId_Column,
+            COLUMN_DATA_TYPE_UINT32, kSystemTableDataFileDataAreaSize, notNullConstraintSpec)));
+    columns.push_back(table->createColumn(ColumnSpecification(kSysBlockChecks_TableId_Column,
+            COLUMN_DATA_TYPE_UINT32, kSystemTableDataFileDataAreaSize, notNullConstraintSpec)));
+    columns.push_back(table->createColumn(ColumnSpecification(kSysBlockChecks_ColumnId_Column,
+            COLUMN_DATA_TYPE_UINT64, kSystemTableDataFileDataAreaSize, notNullConstraintSpec)));
+    columns.push_back(table->createColumn(ColumnSpecification(kSysBlockChecks_BlockId_Column,
+            COLUMN_DATA_TYPE_UINT64, kSystemTableDataFileDataAreaSize, notNullConstraintSpec)));
+    columns.push_back(table->createColumn(
+            ColumnSpecification(kSysBlockChecks_CheckTimestamp_Column, COLUMN_DATA_TYPE_UINT64,
+                    kSystemTableDataFileDataAreaSize, notNullConstraintSpec)));
+    columns.push_back(table->createColumn(ColumnSpecification(kSysBlockChecks_Error_Column,
+            COLUMN_DATA_TYPE_TEXT, kSystemTableDataFileDataAreaSize, notNullConstraintSpec)));
+    table->closeCurrentColumnSet();
+
+    // See comment in the constructor
+    for (const auto& column : columns) {
+        auto block = column->createBlock(0);
+        column->updateBlockState(block->getId(), ColumnDataBlockState::kCurrent);
+        block->setState(ColumnDataBlockState::kCurrent);
+    }
+    return table;
+}
+
+ColumnConstraintSpecificationList SystemDatabase::makeNotNullConstraintSpec() const
+{
+    ColumnConstraintSpecificationList notNullConstraintSpec;
+    notNullConstraintSpec.emplace_back(std::string(), ConstraintType::kNotNull,
+            requests::ExpressionPtr(m_systemNotNullConstraintDefinition->getExpression().clone()));
+    return notNullConstraintSpec;
+}
+
 }  // namespace siodb::iomgr::dbengine
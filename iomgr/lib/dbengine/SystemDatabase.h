@@ -104,6 +104,16 @@ public:
      */
     void recordUserPermission(const UserPermission& permission, const TransactionParameters& tp);
 
+    /**
+     * Records column data block check error into the appropriate system table.
+     * @param column Column which block has failed check.
+     * @param blockId Block ID.
+     * @param error Error message.
+     * @param tp Transaction parameters.
+     */
+    void recordBlockCheckError(const Column& column, std::uint64_t blockId,
+            const std::string& error, const TransactionParameters& tp);
+
     /**
      * Deletes database record.
      * @param databaseId Database ID.
@@ -163,6 +173,21 @@ private:
      */
     std::size_t readAllUserAccessKeys(UserAccessKeyRegistries& userAccessKeyRegistries);
 
+    /**
+     * Creates table SYS_BLOCK_CHECKS with columns and their first blocks.
+     * @param notNullConstraintSpec Constraint specification of the non-nullable columns.
+     * @return Table object.
+     */
+    TablePtr createSysBlockChecksTable(
+            const ColumnConstraintSpecificationList& notNullConstraintSpec);
+
+    /**
+     * Returns constraint specification with single "NOT NULL" constraint
+     * and empty name, which causes automatic constraint name generation.
+     * @return Constraint specification.
+     */
+    ColumnConstraintSpecificationList makeNotNullConstraintSpec() const;
+
 private:
     /** Table SYS_USERS */
     TablePtr m_sysUsersTable;
@@ -175,6 +200,9 @@ private:
 
     /** Table SYS_USER_PERMISSIONS */
     TablePtr m_sysUserPermissionsTable;
+
+    /** Table SYS_BLOCK_CHECKS */
+    TablePtr m_sysBlockChecksTable;
 };
 
 }  // namespace siodb::iomgr::dbengine
@@ -10,6 +10,7 @@
 #include "ColumnSetColumn.h"
 #include "DatabaseObjectName.h"
 #include "Index.h"
+#include "SecondaryIndex.h"
 #include "TableColumns.h"
 #include "ThrowDatabaseError.h"
 #include "parser/EmptyContext.h"
@@ -20,10 +21,13 @@
 #include <siodb/common/utils/FsUtils.h>
 #include <siodb/common/utils/PlainBinaryEncoding.h>
 
+// STL headers
+#include <algorithm>
+
 namespace siodb::iomgr::dbengine {
 
-Table::Table(
-        Database& database, TableType type, const std::string& name, std::uint64_t firstUserTrid)
+Table::Table(Database& database, TableType type, const std::string& name,
+        std::uint64_t firstUserTrid, CompressionType compressionType)
     : m_database(database)
     , m_name(validateTableName(name))
     , m_isSystemTable(Database::isSystemTable(m_name))
@@ -35,6 +39,7 @@ Table::Table(
     , m_currentColumnSet(createColumnSetUnlocked())
     , m_constraintCache(*this, kConstraintCacheCapacity)
     , m_firstUserTrid(firstUserTrid)
+    , m_compressionType(compressionType)
 {
     createMasterColumn(firstUserTrid);
     createInitializationFlagFile();
@@ -52,10 +57,12 @@ Table::Table(Database& database, const TableRecord& tableRecord)
     , m_currentColumnSet(getColumnSetChecked(tableRecord.m_currentColumnSetId))
     , m_constraintCache(*this, kConstraintCacheCapacity)
     , m_firstUserTrid(tableRecord.m_firstUserTrid)
+    , m_compressionType(tableRecord.m_compressionType)
 {
     // Populate columns from the current column set
     loadColumnsUnlocked();
     m_masterColumn->loadMasterColumnMainIndex();
+    loadSecondaryIndicesUnlocked();
 }
 
 std::string Table::getDisplayName() const
@@ -296,11 +303,29 @@ void Table::deleteRow(const MasterColumnRecord& mcr, const ColumnDataAddress& mc
         const TransactionParameters& transactionParameters)
 {
     std::lock_guard lock(m_mutex);
+
+    // Collect secondary index entries of the deleted row
+    std::vector<std::vector<std::uint8_t>> indexEntries;
+    if (!m_secondaryIndices.empty()) {
+        const std::vector<char> indexMask(m_secondaryIndices.size(), 1);
+        const auto values = readSecondaryIndexValuesUnlocked(mcr, indexMask);
+        std::vector<const Variant*> rowValues;
+        rowValues.reserve(values.size());
+        for (const auto& value : values)
+            rowValues.push_back(&value);
+        indexEntries =
+                makeSecondaryIndexEntriesUnlocked(rowValues, mcr.getTableRowId(), indexMask);
+    }
+
     MasterColumnRecord newMcr(*this, transactionParameters.m_transactionId,
             mcr.getCreateTimestamp(), transactionParameters.m_timestamp, DmlOperationType::kDelete,
             transactionParameters.m_userId, mcr.getTableRowId(), m_currentColumnSet->getId(),
             mcrAddress);
     m_masterColumn->putMasterColumnRecord(newMcr);
+
+    for (std::size_t i = 0; i < indexEntries.size(); ++i) {
+        if (!indexEntries[i].empty()) m_secondaryIndices[i]->eraseEntry(indexEntries[i].data());
+    }
 }
 
 bool Table::updateRow(std::uint64_t trid, std::vector<Variant>&& columnValues,
@@ -345,6 +370,41 @@ void Table::updateRow(const MasterColumnRecord& mcr, const ColumnDataAddress& mc
             DmlOperationType::kUpdate, tp.m_userId, mcr.getTableRowId(),
             m_currentColumnSet->getId(), mcrAddress);
 
+    // Make old and new entries of the secondary indices covering updated columns,
+    // before values are moved into the columns
+    std::vector<char> indexMask(m_secondaryIndices.size());
+    bool hasAffectedIndices = false;
+    for (std::size_t i = 0; i < m_secondaryIndices.size(); ++i) {
+        for (const auto columnPosition : columnPositions) {
+            if (columnPosition > 0 && m_secondaryIndices[i]->isKeyColumnPosition(columnPosition)) {
+                indexMask[i] = 1;
+                hasAffectedIndices = true;
+                break;
+            }
+        }
+    }
+    std::vector<std::vector<std::uint8_t>> oldIndexEntries, newIndexEntries;
+    if (hasAffectedIndices) {
+        const auto oldValues = readSecondaryIndexValuesUnlocked(mcr, indexMask);
+        std::vector<const Variant*> rowValues;
+        rowValues.reserve(oldValues.size());
+        for (const auto& value : oldValues)
+            rowValues.push_back(&value);
+        oldIndexEntries =
+                makeSecondaryIndexEntriesUnlocked(rowValues, mcr.getTableRowId(), indexMask);
+        std::size_t valueIndex = 0;
+        for (const auto columnPosition : columnPositions) {
+            if (columnPosition == 0) continue;
+            rowValues.at(columnPosition - 1) = &columnValues[valueIndex++];
+        }
+        newIndexEntries =
+                makeSecondaryIndexEntriesUnlocked(rowValues, mcr.getTableRowId(), indexMask);
+        for (std::size_t i = 0; i < newIndexEntries.size(); ++i) {
+            if (!newIndexEntries[i].empty() && newIndexEntries[i] != oldIndexEntries[i])
+                m_secondaryIndices[i]->checkEntry(newIndexEntries[i].data());
+        }
+    }
+
     const auto tableColumns = getColumnsOrderedByPosition();
     std::vector<std::uint64_t> nextBlockIds;
     nextBlockIds.reserve(newMcr.getColumnCount());
@@ -353,7 +413,8 @@ void Table::updateRow(const MasterColumnRecord& mcr, const ColumnDataAddress& mc
         for (const auto columnPosition : columnPositions) {
             const auto& tableColumnRecord = tableColumns[columnPosition];
             if (tableColumnRecord->isMasterColumn()) continue;
-            auto res = tableColumnRecord->putRecord(std::move(columnValues[valueIndex]));
+            auto res = tableColumnRecord->putRecord(
+                    std::move(columnValues[valueIndex]), newMcr.getTableRowId());
             // Normal column positions start from 1, column at position 0 is master column.
             auto& record = columnRecords[columnPosition - 1];
             record.setAddress(res.first);
@@ -382,6 +443,14 @@ void Table::updateRow(const MasterColumnRecord& mcr, const ColumnDataAddress& mc
         }
         throw;
     }
+
+    for (std::size_t i = 0; i < newIndexEntries.size(); ++i) {
+        if (newIndexEntries[i] == oldIndexEntries[i]) continue;
+        if (!oldIndexEntries[i].empty())
+            m_secondaryIndices[i]->eraseEntry(oldIndexEntries[i].data());
+        if (!newIndexEntries[i].empty())
+            m_secondaryIndices[i]->insertEntry(newIndexEntries[i].data());
+    }
 }
 
 void Table::rollbackLastRow(
@@ -421,6 +490,40 @@ void Table::flushIndices()
 {
     std::lock_guard lock(m_mutex);
     m_masterColumn->getMasterColumnMainIndex()->flush();
+    for (const auto& index : m_secondaryIndices)
+        index->flush();
+}
+
+SecondaryIndexPtr Table::createSecondaryIndex(
+        const std::string& name, const IndexColumnSpecificationList& columns, bool unique)
+{
+    std::lock_guard lock(m_mutex);
+    const auto index = std::make_shared<SecondaryIndex>(*this, name, unique, columns);
+    m_secondaryIndices.push_back(index);
+    try {
+        index->build();
+    } catch (...) {
+        removeSecondaryIndex(*index);
+        throw;
+    }
+    return index;
+}
+
+void Table::removeSecondaryIndex(const SecondaryIndex& index)
+{
+    std::lock_guard lock(m_mutex);
+    const auto it = std::find_if(m_secondaryIndices.begin(), m_secondaryIndices.end(),
+            [&index](const auto& secondaryIndex) { return secondaryIndex.get() == &index; });
+    if (it == m_secondaryIndices.end()) return;
+    const auto removedIndex = *it;
+    m_secondaryIndices.erase(it);
+    try {
+        fs::remove_all(removedIndex->getDataDir());
+    } catch (fs::filesystem_error& ex) {
+        LOG_ERROR << "Database " << m_database.getName() << ": Can't remove data directory "
+                  << removedIndex->getDataDir() << " of the index " << removedIndex->getName()
+                  << ": " << ex.what();
+    }
 }
 
 std::uint64_t Table::generateNextUserTrid()
@@ -493,6 +596,56 @@ void Table::loadColumnsUnlocked()
     m_masterColumn = getColumnCheckedUnlocked(Database::kMasterColumnName);
 }
 
+void Table::loadSecondaryIndicesUnlocked()
+{
+    if (m_isSystemTable) return;
+    for (const auto& indexRecord :
+            m_database.getTableIndexRecords(m_id, IndexType::kBPlusTreeIndex))
+        m_secondaryIndices.push_back(std::make_shared<SecondaryIndex>(*this, indexRecord));
+}
+
+std::vector<std::vector<std::uint8_t>> Table::makeSecondaryIndexEntriesUnlocked(
+        const std::vector<const Variant*>& rowValues, std::uint64_t trid,
+        const std::vector<char>& indexMask) const
+{
+    std::vector<std::vector<std::uint8_t>> entries(m_secondaryIndices.size());
+    std::vector<const Variant*> keyValues;
+    for (std::size_t i = 0; i < m_secondaryIndices.size(); ++i) {
+        if (!indexMask[i]) continue;
+        const auto& index = *m_secondaryIndices[i];
+        keyValues.resize(index.getKeyColumnCount());
+        for (std::size_t j = 0; j < keyValues.size(); ++j)
+            keyValues[j] = rowValues.at(index.getKeyColumnPosition(j) - 1);
+        auto& entry = entries[i];
+        entry.resize(index.getEntrySize());
+        if (!index.makeEntry(keyValues, trid, entry.data())) entry.clear();
+    }
+    return entries;
+}
+
+std::vector<Variant> Table::readSecondaryIndexValuesUnlocked(
+        const MasterColumnRecord& mcr, const std::vector<char>& indexMask) const
+{
+    std::vector<Variant> values(m_currentColumns.size() - 1);
+    std::vector<char> valueRead(values.size());
+    const auto& columnRecords = mcr.getColumnRecords();
+    for (std::size_t i = 0; i < m_secondaryIndices.size(); ++i) {
+        if (!indexMask[i]) continue;
+        const auto& index = *m_secondaryIndices[i];
+        for (std::size_t j = 0; j < index.getKeyColumnCount(); ++j) {
+            // Normal column positions start from 1, column at position 0 is master column.
+            const auto valueIndex = index.getKeyColumnPosition(j) - 1;
+            if (valueRead[valueIndex]) continue;
+            valueRead[valueIndex] = 1;
+            // Row may have been written before column was added
+            if (valueIndex >= columnRecords.size()) continue;
+            getColumnCheckedUnlocked(index.getKeyColumnId(j))
+                    ->readRecord(columnRecords[valueIndex].getAddress(), values[valueIndex]);
+        }
+    }
+    return values;
+}
+
 ColumnSetPtr Table::createColumnSetUnlocked()
 {
     auto columnSet = std::make_shared<ColumnSet>(*this);
@@ -653,6 +806,21 @@ std::pair<MasterColumnRecordPtr, std::vector<std::uint64_t>> Table::doInsertRowU
             tp.m_timestamp, DmlOperationType::kInsert, tp.m_userId, customTrid,
             m_currentColumnSet->getId(), kNullValueAddress);
 
+    // Make secondary index entries before values are moved into the columns
+    std::vector<std::vector<std::uint8_t>> indexEntries;
+    if (!m_secondaryIndices.empty()) {
+        std::vector<const Variant*> rowValues;
+        rowValues.reserve(columnValues.size());
+        for (const auto& value : columnValues)
+            rowValues.push_back(&value);
+        indexEntries = makeSecondaryIndexEntriesUnlocked(rowValues, mcr->getTableRowId(),
+                std::vector<char>(m_secondaryIndices.size(), 1));
+        for (std::size_t i = 0; i < indexEntries.size(); ++i) {
+            if (!indexEntries[i].empty())
+                m_secondaryIndices[i]->checkEntry(indexEntries[i].data());
+        }
+    }
+
     std::vector<std::uint64_t> nextBlockIds;
     nextBlockIds.reserve(mcr->getColumnCount());
 
@@ -660,7 +828,8 @@ std::pair<MasterColumnRecordPtr, std::vector<std::uint64_t>> Table::doInsertRowU
         std::size_t i = 0;
         for (const auto& tableColumnRecord : m_currentColumns.byPosition()) {
             if (tableColumnRecord.m_column->isMasterColumn()) continue;
-            auto res = tableColumnRecord.m_column->putRecord(std::move(columnValues[i]));
+            auto res = tableColumnRecord.m_column->putRecord(
+                    std::move(columnValues[i]), mcr->getTableRowId());
             mcr->addColumnRecord(res.first, tp.m_timestamp, tp.m_timestamp);
             nextBlockIds.push_back(res.second.getBlockId());
             ++i;
@@ -671,6 +840,10 @@ std::pair<MasterColumnRecordPtr, std::vector<std::uint64_t>> Table::doInsertRowU
         throw;
     }
 
+    for (std::size_t i = 0; i < indexEntries.size(); ++i) {
+        if (!indexEntries[i].empty()) m_secondaryIndices[i]->insertEntry(indexEntries[i].data());
+    }
+
     return std::make_pair(std::move(mcr), std::move(nextBlockIds));
 }
 
@@ -10,9 +10,12 @@
 #include "ColumnDefinitionPtr.h"
 #include "ColumnPtr.h"
 #include "ColumnSetCache.h"
+#include "CompressionType.h"
 #include "ConstraintCache.h"
 #include "Database.h"
+#include "IndexColumnSpecification.h"
 #include "IndexPtr.h"
+#include "SecondaryIndexPtr.h"
 #include "TableColumns.h"
 #include "TablePtr.h"
 #include "Variant.h"
@@ -32,8 +35,10 @@ public:
      * @param type Table type.
      * @param name Table name.
      * @param firstUserTrid First user range TRID.
+     * @param compressionType Compression type of the variable length data.
      */
-    Table(Database& database, TableType type, const std::string& name, std::uint64_t firstUserTrid);
+    Table(Database& database, TableType type, const std::string& name, std::uint64_t firstUserTrid,
+            CompressionType compressionType = CompressionType::kNone);
 
     /**
      * Initializes object of class Table for the existing table.
@@ -137,6 +142,15 @@ public:
         return m_firstUserTrid;
     }
 
+    /**
+     * Returns compression type of the variable length data.
+     * @return Compression type.
+     */
+    auto getCompressionType() const noexcept
+    {
+        return m_compressionType;
+    }
+
     /**
      * Returns number of column in the table.
      * @return Number of columns in the table.
@@ -384,6 +398,31 @@ public:
             const std::vector<std::string>& columnNames, std::vector<Variant>& columnValues,
             const TransactionParameters& transactionParameters, std::uint64_t customTrid = 0);
 
+    /** Loads secondary indices of the existing table. */
+    void loadSecondaryIndicesUnlocked();
+
+    /**
+     * Makes secondary index entries of the table row.
+     * @param rowValues Values of the columns in the order of positions, except master column.
+     * @param trid Table row ID.
+     * @param indexMask Indicates for which indices entries are made.
+     * @return Entries, one per secondary index. Entry is empty if row is not indexed.
+     * @throw DatabaseError if value can't be indexed.
+     */
+    std::vector<std::vector<std::uint8_t>> makeSecondaryIndexEntriesUnlocked(
+            const std::vector<const Variant*>& rowValues, std::uint64_t trid,
+            const std::vector<char>& indexMask) const;
+
+    /**
+     * Reads values of the columns covered by secondary indices.
+     * @param mcr Master column record.
+     * @param indexMask Indicates for which indices values are read.
+     * @return Values of the columns in the order of positions, except master column.
+     *         Values of the columns which are not read are NULL.
+     */
+    std::vector<Variant> readSecondaryIndexValuesUnlocked(
+            const MasterColumnRecord& mcr, const std::vector<char>& indexMask) const;
+
     /**
      * Inserts new row into the table. Assumes values correspond to columns in other order
      * they are in the table.
@@ -452,6 +491,34 @@ public:
     /** Flushes all pending changes in indices to disk. */
     void flushIndices();
 
+    /**
+     * Creates new secondary index and fills it with the existing rows.
+     * Table modifications are blocked while index is built.
+     * @param name Index name.
+     * @param columns Indexed columns.
+     * @param unique Index uniqueness flag.
+     * @return Index object.
+     * @throw DatabaseError if index can't be created or unique index key is duplicated.
+     */
+    SecondaryIndexPtr createSecondaryIndex(
+            const std::string& name, const IndexColumnSpecificationList& columns, bool unique);
+
+    /**
+     * Removes secondary index from the table and deletes its data.
+     * @param index Index object.
+     */
+    void removeSecondaryIndex(const SecondaryIndex& index);
+
+    /**
+     * Returns secondary indices of the table.
+     * @return List of secondary indices.
+     */
+    std::vector<SecondaryIndexPtr> getSecondaryIndices() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_secondaryIndices;
+    }
+
     /**
      * Generates next TRID from the user TRID range.
      * @return Next user record TRID.
@@ -676,6 +743,12 @@ private:
      */
     const std::uint64_t m_firstUserTrid;
 
+    /** Compression type of the variable length data */
+    const CompressionType m_compressionType;
+
+    /** Secondary indices */
+    std::vector<SecondaryIndexPtr> m_secondaryIndices;
+
     /** Initialization flag file name */
     static constexpr const char* kInitializationFlagFile = "initialized";
 
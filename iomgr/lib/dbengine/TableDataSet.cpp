@@ -9,22 +9,433 @@
 #include "Database.h"
 #include "DatabaseObjectName.h"
 #include "Index.h"
+#include "SecondaryIndex.h"
 #include "ThrowDatabaseError.h"
+#include "parser/expr/BetweenOperator.h"
+#include "parser/expr/BinaryOperator.h"
+#include "parser/expr/ConstantExpression.h"
+#include "parser/expr/InOperator.h"
+#include "parser/expr/SingleColumnExpression.h"
 
 // Common project headers
+#include <siodb/common/log/Log.h>
 #include <siodb/common/utils/PlainBinaryEncoding.h>
 
+// STL headers
+#include <algorithm>
+#include <limits>
+
 namespace siodb::iomgr::dbengine {
 
+namespace {
+
+using KeyRange = std::pair<std::uint64_t, std::uint64_t>;
+
+constexpr auto kMaxKey = std::numeric_limits<std::uint64_t>::max();
+
+/** Comparison of the column with constants, which can be checked against block summaries */
+struct SimplePredicate {
+    /** Dataset column index */
+    std::size_t m_columnIndex;
+
+    /** Predicate type, comparison operator is normalized to have column on the left */
+    requests::ExpressionType m_type;
+
+    /** Constant values */
+    std::vector<const Variant*> m_values;
+};
+
+const requests::SingleColumnExpression* asDataSetColumn(
+        const requests::Expression& expression, std::size_t dataSetIndex)
+{
+    if (expression.getType() != requests::ExpressionType::kSingleColumnReference) return nullptr;
+    const auto column = dynamic_cast<const requests::SingleColumnExpression*>(&expression);
+    if (column == nullptr || column->getDatasetTableIndex() != dataSetIndex
+            || !column->getDatasetColumnIndex())
+        return nullptr;
+    return column;
+}
+
+const Variant* asConstant(const requests::Expression& expression)
+{
+    if (expression.getType() != requests::ExpressionType::kConstant) return nullptr;
+    const auto constant = dynamic_cast<const requests::ConstantExpression*>(&expression);
+    return constant ? &constant->getValue() : nullptr;
+}
+
+requests::ExpressionType swapComparisonOperands(requests::ExpressionType type) noexcept
+{
+    switch (type) {
+        case requests::ExpressionType::kLessPredicate:
+            return requests::ExpressionType::kGreaterPredicate;
+        case requests::ExpressionType::kLessOrEqualPredicate:
+            return requests::ExpressionType::kGreaterOrEqualPredicate;
+        case requests::ExpressionType::kGreaterPredicate:
+            return requests::ExpressionType::kLessPredicate;
+        case requests::ExpressionType::kGreaterOrEqualPredicate:
+            return requests::ExpressionType::kLessOrEqualPredicate;
+        default: return type;
+    }
+}
+
+void collectSimplePredicates(const requests::Expression& expression, std::size_t dataSetIndex,
+        std::vector<SimplePredicate>& predicates)
+{
+    const auto type = expression.getType();
+    switch (type) {
+        case requests::ExpressionType::kLogicalAndOperator: {
+            const auto& op = dynamic_cast<const requests::BinaryOperator&>(expression);
+            collectSimplePredicates(op.getLeftOperand(), dataSetIndex, predicates);
+            collectSimplePredicates(op.getRightOperand(), dataSetIndex, predicates);
+            break;
+        }
+
+        case requests::ExpressionType::kEqualPredicate:
+        case requests::ExpressionType::kLessPredicate:
+        case requests::ExpressionType::kLessOrEqualPredicate:
+        case requests::ExpressionType::kGreaterPredicate:
+        case requests::ExpressionType::kGreaterOrEqualPredicate: {
+            const auto& op = dynamic_cast<const requests::BinaryOperator&>(expression);
+            if (const auto column = asDataSetColumn(op.getLeftOperand(), dataSetIndex)) {
+                if (const auto value = asConstant(op.getRightOperand()))
+                    predicates.push_back({*column->getDatasetColumnIndex(), type, {value}});
+            } else if (const auto column = asDataSetColumn(op.getRightOperand(), dataSetIndex)) {
+                if (const auto value = asConstant(op.getLeftOperand())) {
+                    predicates.push_back({*column->getDatasetColumnIndex(),
+                            swapComparisonOperands(type), {value}});
+                }
+            }
+            break;
+        }
+
+        case requests::ExpressionType::kBetweenPredicate: {
+            const auto& op = dynamic_cast<const requests::BetweenOperator&>(expression);
+            if (op.isNotBetween()) break;
+            const auto column = asDataSetColumn(op.getLeftOperand(), dataSetIndex);
+            const auto lowerBound = asConstant(op.getMiddleOperand());
+            const auto upperBound = asConstant(op.getRightOperand());
+            if (column && lowerBound && upperBound) {
+                predicates.push_back(
+                        {*column->getDatasetColumnIndex(), type, {lowerBound, upperBound}});
+            }
+            break;
+        }
+
+        case requests::ExpressionType::kInPredicate: {
+            const auto& op = dynamic_cast<const requests::InOperator&>(expression);
+            if (op.isNotIn()) break;
+            const auto column = asDataSetColumn(op.getValue(), dataSetIndex);
+            if (!column) break;
+            SimplePredicate predicate {*column->getDatasetColumnIndex(), type, {}};
+            for (const auto& variant : op.getVariants()) {
+                const auto value = asConstant(*variant);
+                if (!value) return;
+                predicate.m_values.push_back(value);
+            }
+            predicates.push_back(std::move(predicate));
+            break;
+        }
+
+        default: break;
+    }
+}
+
+/** Sorts ranges and merges overlapping and adjacent ones */
+void normalizeRanges(std::vector<KeyRange>& ranges)
+{
+    std::sort(ranges.begin(), ranges.end());
+    std::size_t n = 0;
+    for (const auto& range : ranges) {
+        if (n > 0 && (ranges[n - 1].second == kMaxKey || range.first <= ranges[n - 1].second + 1))
+            ranges[n - 1].second = std::max(ranges[n - 1].second, range.second);
+        else
+            ranges[n++] = range;
+    }
+    ranges.resize(n);
+}
+
+/** Intersects two normalized lists of ranges */
+std::vector<KeyRange> intersectRanges(
+        const std::vector<KeyRange>& left, const std::vector<KeyRange>& right)
+{
+    std::vector<KeyRange> result;
+    for (std::size_t i = 0, j = 0; i < left.size() && j < right.size();) {
+        const auto first = std::max(left[i].first, right[j].first);
+        const auto last = std::min(left[i].second, right[j].second);
+        if (first <= last) result.emplace_back(first, last);
+        if (left[i].second < right[j].second)
+            ++i;
+        else
+            ++j;
+    }
+    return result;
+}
+
+/**
+ * Converts predicate into ranges of keys of matching values.
+ * @return Normalized list of ranges or nothing if predicate can't be checked using keys.
+ */
+std::optional<std::vector<KeyRange>> getPredicateKeyRanges(
+        const SimplePredicate& predicate, ColumnDataType dataType)
+{
+    std::vector<std::uint64_t> keys;
+    keys.reserve(predicate.m_values.size());
+    for (const auto value : predicate.m_values) {
+        const auto key = getZoneMapKeyForConstant(dataType, *value);
+        if (!key) return std::nullopt;
+        keys.push_back(*key);
+    }
+
+    // Strict comparisons are checked as non-strict ones, because keys may be less precise
+    std::vector<KeyRange> ranges;
+    switch (predicate.m_type) {
+        case requests::ExpressionType::kEqualPredicate: {
+            ranges.emplace_back(keys[0], keys[0]);
+            break;
+        }
+        case requests::ExpressionType::kLessPredicate:
+        case requests::ExpressionType::kLessOrEqualPredicate: {
+            ranges.emplace_back(0, keys[0]);
+            break;
+        }
+        case requests::ExpressionType::kGreaterPredicate:
+        case requests::ExpressionType::kGreaterOrEqualPredicate: {
+            ranges.emplace_back(keys[0], kMaxKey);
+            break;
+        }
+        case requests::ExpressionType::kBetweenPredicate: {
+            if (keys[0] <= keys[1]) ranges.emplace_back(keys[0], keys[1]);
+            break;
+        }
+        case requests::ExpressionType::kInPredicate: {
+            for (const auto key : keys)
+                ranges.emplace_back(key, key);
+            break;
+        }
+        default: return std::nullopt;
+    }
+    normalizeRanges(ranges);
+    return ranges;
+}
+
+/**
+ * Collects TRID ranges of column data blocks which may contain values with given keys.
+ * @return Normalized list of TRID ranges.
+ */
+std::vector<KeyRange> getBlockTridRanges(Column& column, const std::vector<KeyRange>& keyRanges)
+{
+    std::vector<KeyRange> tridRanges;
+    for (const auto& zoneMap : column.getBlockZoneMaps()) {
+        // Rows of the block with unknown contents may be anywhere
+        if (!zoneMap.m_complete) return {KeyRange(0, kMaxKey)};
+        if (!zoneMap.hasValues()) continue;
+        for (const auto& keyRange : keyRanges) {
+            if (zoneMap.mayContain(keyRange.first, keyRange.second)) {
+                tridRanges.emplace_back(zoneMap.m_minTrid, zoneMap.m_maxTrid);
+                break;
+            }
+        }
+    }
+    normalizeRanges(tridRanges);
+    return tridRanges;
+}
+
+/** Inclusive range of the secondary index keys */
+struct IndexKeyRange {
+    /** Lower key */
+    std::vector<std::uint8_t> m_lowerKey;
+
+    /** Upper key */
+    std::vector<std::uint8_t> m_upperKey;
+};
+
+/** Maximum number of the secondary index key ranges searched for a single condition */
+constexpr std::size_t kMaxIndexKeyRangeCount = 1024;
+
+/** Minimum ratio of the row count to the number of rows found using the secondary index */
+constexpr std::size_t kMinIndexSelectivity = 4;
+
+/** Maximum number of rows found using the secondary index */
+constexpr std::size_t kMaxIndexRowCount = 1024 * 1024;
+
+/**
+ * Converts predicates on the leading indexed columns into ranges of the index keys.
+ * Equality and IN predicates restrict leading columns to single values, the next
+ * column can be restricted by comparisons and BETWEEN predicates.
+ * @param index Secondary index.
+ * @param predicates Predicates.
+ * @param positions Table column positions of the predicate columns.
+ * @param[out] ranges Key ranges.
+ * @return Index usefulness score, zero if index can't be used.
+ */
+std::size_t makeIndexKeyRanges(const SecondaryIndex& index,
+        const std::vector<SimplePredicate>& predicates, const std::vector<std::uint32_t>& positions,
+        std::vector<IndexKeyRange>& ranges)
+{
+    const auto keySize = index.getKeySize();
+    ranges.assign(1, IndexKeyRange {std::vector<std::uint8_t>(keySize, 0),
+                             std::vector<std::uint8_t>(keySize, 0xFF)});
+    std::vector<std::uint8_t> lowerKey(keySize), upperKey(keySize);
+    std::size_t score = 0;
+    for (std::size_t i = 0; i < index.getKeyColumnCount(); ++i) {
+        const auto position = index.getKeyColumnPosition(i);
+
+        // Try to restrict column to the list of values
+        std::vector<IndexKeyRange> pointRanges;
+        bool exact = true;
+        for (std::size_t j = 0; j < predicates.size() && pointRanges.empty(); ++j) {
+            const auto& predicate = predicates[j];
+            if (positions[j] != position
+                    || (predicate.m_type != requests::ExpressionType::kEqualPredicate
+                            && predicate.m_type != requests::ExpressionType::kInPredicate)
+                    || ranges.size() * predicate.m_values.size() > kMaxIndexKeyRangeCount)
+                continue;
+            for (const auto value : predicate.m_values) {
+                std::fill(lowerKey.begin(), lowerKey.end(), 0);
+                std::fill(upperKey.begin(), upperKey.end(), 0);
+                if (!index.encodeConstant(i, *value, false, lowerKey.data())
+                        || !index.encodeConstant(i, *value, true, upperKey.data())) {
+                    pointRanges.clear();
+                    exact = true;
+                    break;
+                }
+                exact &= lowerKey == upperKey;
+                for (const auto& range : ranges) {
+                    auto& pointRange = pointRanges.emplace_back(range);
+                    index.encodeConstant(i, *value, false, pointRange.m_lowerKey.data());
+                    index.encodeConstant(i, *value, true, pointRange.m_upperKey.data());
+                }
+            }
+        }
+
+        if (!pointRanges.empty()) {
+            ranges = std::move(pointRanges);
+            score += 2;
+            // Following columns are ordered only within the same encoded value
+            if (!exact) break;
+            continue;
+        }
+
+        // Try to restrict column by the bounds. Keys of all ranges are the same starting
+        // from this column, so they can be compared as a whole.
+        bool restricted = false;
+        for (std::size_t j = 0; j < predicates.size(); ++j) {
+            const auto& predicate = predicates[j];
+            if (positions[j] != position) continue;
+            const Variant* lowerBound = nullptr;
+            const Variant* upperBound = nullptr;
+            switch (predicate.m_type) {
+                case requests::ExpressionType::kLessPredicate:
+                case requests::ExpressionType::kLessOrEqualPredicate: {
+                    upperBound = predicate.m_values[0];
+                    break;
+                }
+                case requests::ExpressionType::kGreaterPredicate:
+                case requests::ExpressionType::kGreaterOrEqualPredicate: {
+                    lowerBound = predicate.m_values[0];
+                    break;
+                }
+                case requests::ExpressionType::kBetweenPredicate: {
+                    lowerBound = predicate.m_values[0];
+                    upperBound = predicate.m_values[1];
+                    break;
+                }
+                default: continue;
+            }
+
+            // Keys of the descending column are inverted
+            if (index.isKeyColumnDescending(i)) std::swap(lowerBound, upperBound);
+            for (auto& range : ranges) {
+                if (lowerBound) {
+                    lowerKey = range.m_lowerKey;
+                    if (index.encodeConstant(i, *lowerBound, false, lowerKey.data())) {
+                        if (lowerKey > range.m_lowerKey) range.m_lowerKey = lowerKey;
+                        restricted = true;
+                    }
+                }
+                if (upperBound) {
+                    upperKey = range.m_upperKey;
+                    if (index.encodeConstant(i, *upperBound, true, upperKey.data())) {
+                        if (upperKey < range.m_upperKey) range.m_upperKey = upperKey;
+                        restricted = true;
+                    }
+                }
+            }
+        }
+        if (restricted) ++score;
+        break;
+    }
+    return score;
+}
+
+/**
+ * Finds rows which may match predicates using the most suitable secondary index.
+ * @param table Table object.
+ * @param predicates Predicates.
+ * @param positions Table column positions of the predicate columns.
+ * @param maxRowCount Maximum number of rows worth finding using index.
+ * @return Normalized list of TRID ranges of the found rows or nothing if no index
+ *         can be used or too many rows are found.
+ */
+std::optional<std::vector<KeyRange>> findRowsUsingIndex(Table& table,
+        const std::vector<SimplePredicate>& predicates, const std::vector<std::uint32_t>& positions,
+        std::size_t maxRowCount)
+{
+    if (predicates.empty() || maxRowCount == 0) return std::nullopt;
+
+    // Prefer index with more restricted columns, then unique one
+    SecondaryIndexPtr bestIndex;
+    std::vector<IndexKeyRange> bestRanges, ranges;
+    std::size_t bestScore = 0;
+    for (const auto& index : table.getSecondaryIndices()) {
+        const auto score = makeIndexKeyRanges(*index, predicates, positions, ranges);
+        if (score > bestScore || (score > 0 && score == bestScore && index->isUnique())) {
+            bestIndex = index;
+            bestRanges.swap(ranges);
+            bestScore = score;
+        }
+    }
+    if (!bestIndex) return std::nullopt;
+
+    std::vector<std::uint64_t> trids;
+    for (const auto& range : bestRanges) {
+        if (!bestIndex->findTableRowIds(range.m_lowerKey.data(), range.m_upperKey.data(),
+                    maxRowCount - trids.size(), trids)) {
+            LOG_DEBUG << "Index " << bestIndex->getDisplayName() << ": More than " << maxRowCount
+                      << " rows found, index is not used";
+            return std::nullopt;
+        }
+    }
+
+    LOG_DEBUG << "Index " << bestIndex->getDisplayName() << ": Found " << trids.size()
+              << " rows";
+    std::vector<KeyRange> tridRanges;
+    tridRanges.reserve(trids.size());
+    for (const auto trid : trids)
+        tridRanges.emplace_back(trid, trid);
+    normalizeRanges(tridRanges);
+    return tridRanges;
+}
+
+}  // anonymous namespace
+
 TableDataSet::TableDataSet(const TablePtr& table, const std::string& tableAlias)
     : DataSet(tableAlias)
     , m_table(table)
     , m_tableColumns(m_table->getColumnsOrderedByPosition())
     , m_masterColumn(m_table->getMasterColumn())
     , m_masterColumnIndex(m_masterColumn->getMasterColumnMainIndex())
+    , m_rowWindowPos(0)
+    , m_rowWindowCapacity(kInitialRowWindowSize)
+    , m_noMoreKeys(true)
     , m_currentKey(nullptr)
     , m_nextKey(nullptr)
+    , m_skipRows(false)
+    , m_tridRangePos(0)
 {
+    m_readaheads.reserve(m_tableColumns.size());
+    for (const auto& column : m_tableColumns)
+        m_readaheads.emplace_back(*column);
 }
 
 const std::string& TableDataSet::getName() const noexcept
@@ -48,6 +459,23 @@ ColumnDataType TableDataSet::getColumnDataType(std::size_t columnIndex) const
     return m_tableColumns.at(m_columnInfos.at(columnIndex).m_posInTable)->getDataType();
 }
 
+std::size_t TableDataSet::getBatchRowCount() const noexcept
+{
+    return m_hasCurrentRow ? m_rowWindow.size() - m_rowWindowPos : 0;
+}
+
+const Variant* TableDataSet::getBatchColumnValues(std::size_t index)
+{
+    // Normally should never happen
+    if (!m_hasCurrentRow) throw std::runtime_error("No more rows");
+    // Current row value could be already moved out of the row window
+    if (m_valueReadMask.getBit(index)) {
+        throw std::runtime_error("Batch values must be obtained before reading the current row");
+    }
+    if (!m_rowWindowValueReadMask.getBit(index)) readColumnValuesInRowWindow(index);
+    return m_rowWindowValues[index].data() + m_rowWindowPos;
+}
+
 const std::vector<Variant>& TableDataSet::getCurrentRow()
 {
     // Normally should never happen
@@ -72,6 +500,59 @@ std::uint32_t TableDataSet::getDataSourceId() const noexcept
     return m_table->getId();
 }
 
+void TableDataSet::chooseAccessPath(const requests::Expression& where, std::size_t dataSetIndex)
+{
+    std::vector<SimplePredicate> predicates;
+    collectSimplePredicates(where, dataSetIndex, predicates);
+
+    // Rows inserted after summaries are obtained must not be skipped,
+    // so last TRID is obtained before summaries.
+    std::uint64_t firstTrid = 0, lastTrid = 0;
+    if (m_masterColumnIndex->getMinKey(m_key) && m_masterColumnIndex->getMaxKey(&m_key[8])) {
+        ::pbeDecodeUInt64(m_key, &firstTrid);
+        ::pbeDecodeUInt64(&m_key[8], &lastTrid);
+    }
+
+    m_skipRows = false;
+    m_tridRanges.clear();
+    std::vector<std::uint32_t> positions;
+    positions.reserve(predicates.size());
+    for (const auto& predicate : predicates) {
+        const auto position = m_columnInfos.at(predicate.m_columnIndex).m_posInTable;
+        positions.push_back(position);
+        const auto& column = m_tableColumns.at(position);
+        const auto dataType = column->getDataType();
+        if (!column->isMasterColumn() && !isZoneMapSupported(dataType)) continue;
+        const auto keyRanges = getPredicateKeyRanges(predicate, dataType);
+        if (!keyRanges) continue;
+        // Master column values are TRIDs themselves
+        auto tridRanges = column->isMasterColumn() ? *keyRanges
+                                                   : getBlockTridRanges(*column, *keyRanges);
+        m_tridRanges = m_skipRows ? intersectRanges(m_tridRanges, tridRanges)
+                                  : std::move(tridRanges);
+        m_skipRows = true;
+    }
+
+    // Secondary index is used only if it is selective enough,
+    // otherwise scanning blocks is cheaper than reading rows one by one.
+    const std::size_t rowCount = (lastTrid >= firstTrid && lastTrid > 0)
+                                         ? std::min<std::uint64_t>(lastTrid - firstTrid + 1,
+                                                 kMaxIndexRowCount * kMinIndexSelectivity)
+                                         : 0;
+    auto indexTridRanges =
+            findRowsUsingIndex(*m_table, predicates, positions, rowCount / kMinIndexSelectivity);
+    if (indexTridRanges) {
+        m_tridRanges = m_skipRows ? intersectRanges(m_tridRanges, *indexTridRanges)
+                                  : std::move(*indexTridRanges);
+        m_skipRows = true;
+    }
+
+    if (m_skipRows && lastTrid < kMaxKey) {
+        m_tridRanges.emplace_back(lastTrid + 1, kMaxKey);
+        normalizeRanges(m_tridRanges);
+    }
+}
+
 void TableDataSet::resetCursor()
 {
     // Obtain min and max TRID
@@ -93,22 +574,39 @@ void TableDataSet::resetCursor()
 
     m_valueReadMask.resize(m_columnInfos.size());
     m_values.resize(m_columnInfos.size());
+    m_rowWindowValues.resize(m_columnInfos.size());
+    m_rowWindowValueReadMask.resize(m_columnInfos.size());
 
     m_hasCurrentRow = (maxTrid > 0);
+    m_tridRangePos = 0;
+    if (m_hasCurrentRow) m_hasCurrentRow = skipExcludedKeys();
+    m_rowWindow.clear();
+    m_rowWindowPos = 0;
+    m_noMoreKeys = !m_hasCurrentRow;
+    for (auto& readahead : m_readaheads)
+        readahead.reset();
     if (m_hasCurrentRow) {
-        readMasterColumnRecord();
+        fillRowWindow(true);
         m_valueReadMask.fill(false);
     }
 }
 
 bool TableDataSet::moveToNextRow()
 {
-    m_hasCurrentRow = m_masterColumnIndex->getNextKey(m_currentKey, m_nextKey);
-    std::swap(m_currentKey, m_nextKey);
-    if (m_hasCurrentRow) {
-        readMasterColumnRecord();
-        m_valueReadMask.fill(false);
+    if (m_rowWindowPos + 1 < m_rowWindow.size()) {
+        ++m_rowWindowPos;
+        m_hasCurrentRow = true;
+    } else if (m_noMoreKeys)
+        m_hasCurrentRow = false;
+    else {
+        m_hasCurrentRow = moveToNextKey();
+        if (m_hasCurrentRow)
+            fillRowWindow(false);
+        else
+            m_noMoreKeys = true;
     }
+
+    if (m_hasCurrentRow) m_valueReadMask.fill(false);
     return m_hasCurrentRow;
 }
 
@@ -116,7 +614,8 @@ void TableDataSet::deleteCurrentRow(std::uint32_t currentUserId)
 {
     const TransactionParameters tp(
             currentUserId, m_table->getDatabase().generateNextTransactionId());
-    m_table->deleteRow(m_currentMcr, m_currentMcrAddress, tp);
+    const auto& entry = m_rowWindow[m_rowWindowPos];
+    m_table->deleteRow(entry.m_mcr, entry.m_mcrAddress, tp);
 }
 
 void TableDataSet::updateCurrentRow(std::vector<Variant>&& values,
@@ -124,12 +623,70 @@ void TableDataSet::updateCurrentRow(std::vector<Variant>&& values,
 {
     const TransactionParameters tp(
             currentUserId, m_table->getDatabase().generateNextTransactionId());
-    m_table->updateRow(m_currentMcr, m_currentMcrAddress, std::move(values), columnPositions, tp);
+    const auto& entry = m_rowWindow[m_rowWindowPos];
+    m_table->updateRow(entry.m_mcr, entry.m_mcrAddress, std::move(values), columnPositions, tp);
 }
 
 // ---- internals ----
 
-void TableDataSet::readMasterColumnRecord()
+void TableDataSet::fillRowWindow(bool firstWindow)
+{
+    if (firstWindow)
+        m_rowWindowCapacity = kInitialRowWindowSize;
+    else if (m_rowWindowCapacity < kMaxRowWindowSize)
+        m_rowWindowCapacity *= 2;
+
+    m_rowWindow.clear();
+    m_rowWindowPos = 0;
+    m_rowWindowValueReadMask.fill(false);
+
+    // Current key always points to the last row read into the window
+    while (true) {
+        m_rowWindow.emplace_back();
+        readMasterColumnRecord(m_rowWindow.back());
+        if (m_rowWindow.size() == m_rowWindowCapacity) break;
+        if (!moveToNextKey()) {
+            m_noMoreKeys = true;
+            break;
+        }
+    }
+}
+
+bool TableDataSet::skipExcludedKeys()
+{
+    if (!m_skipRows) return true;
+    while (true) {
+        std::uint64_t trid = 0;
+        ::pbeDecodeUInt64(m_currentKey, &trid);
+        // Keys are ordered by TRID, so passed ranges are never needed again
+        while (m_tridRangePos < m_tridRanges.size() && m_tridRanges[m_tridRangePos].second < trid)
+            ++m_tridRangePos;
+        if (m_tridRangePos == m_tridRanges.size()) return false;
+        const auto firstTrid = m_tridRanges[m_tridRangePos].first;
+        if (trid >= firstTrid) return true;
+
+        // Seek to the start of the range instead of visiting each skipped key
+        if (!m_masterColumnIndex->getMaxKey(m_nextKey)) return false;
+        std::uint64_t lastTrid = 0;
+        ::pbeDecodeUInt64(m_nextKey, &lastTrid);
+        if (firstTrid > lastTrid) return false;
+        ::pbeEncodeUInt64(firstTrid, m_nextKey);
+        if (m_masterColumnIndex->count(m_nextKey) > 0) {
+            std::swap(m_currentKey, m_nextKey);
+            return true;
+        }
+        if (!m_masterColumnIndex->getNextKey(m_nextKey, m_currentKey)) return false;
+    }
+}
+
+bool TableDataSet::moveToNextKey()
+{
+    if (!m_masterColumnIndex->getNextKey(m_currentKey, m_nextKey)) return false;
+    std::swap(m_currentKey, m_nextKey);
+    return skipExcludedKeys();
+}
+
+void TableDataSet::readMasterColumnRecord(RowWindowEntry& entry)
 {
     std::uint8_t value[12];
 
@@ -142,19 +699,20 @@ void TableDataSet::readMasterColumnRecord()
 
     ColumnDataAddress mcrAddr;
     mcrAddr.pbeDeserialize(value, sizeof(value));
+    m_readaheads[0].onBlockAccess(mcrAddr.getBlockId());
 
     // Read and validate master column record
-    m_masterColumn->readMasterColumnRecord(mcrAddr, m_currentMcr);
+    m_masterColumn->readMasterColumnRecord(mcrAddr, entry.m_mcr);
 
     // + TRID
-    if (m_currentMcr.getColumnCount() + 1 != m_table->getColumnCount()) {
+    if (entry.m_mcr.getColumnCount() + 1 != m_table->getColumnCount()) {
         throwDatabaseError(IOManagerMessageId::kErrorInvalidMasterColumnRecordColumnCount,
                 m_table->getDatabaseName(), m_table->getName(), m_table->getDatabaseUuid(),
                 m_table->getId(), mcrAddr.getBlockId(), mcrAddr.getOffset(),
-                m_table->getColumnCount(), m_currentMcr.getColumnCount() + 1);
+                m_table->getColumnCount(), entry.m_mcr.getColumnCount() + 1);
     }
 
-    m_currentMcrAddress = mcrAddr;
+    entry.m_mcrAddress = mcrAddr;
 }
 
 void TableDataSet::readColumnValue(std::size_t index)
@@ -162,19 +720,61 @@ void TableDataSet::readColumnValue(std::size_t index)
     auto& value = m_values.at(index);
     const auto pos = m_columnInfos.at(index).m_posInTable;
     auto& column = m_tableColumns.at(pos);
+    const auto& mcr = m_rowWindow[m_rowWindowPos].m_mcr;
 
     if (column->isMasterColumn())
-        value = m_currentMcr.getTableRowId();
+        value = mcr.getTableRowId();
     else {
-        column->readRecord(m_currentMcr.getColumnRecords().at(pos - 1).getAddress(), value, false);
+        const auto dataType = column->getDataType();
+        // LOBs are read into the row window only if batch values are requested
+        if (!m_rowWindowValueReadMask.getBit(index)
+                && (dataType == COLUMN_DATA_TYPE_TEXT || dataType == COLUMN_DATA_TYPE_BINARY)) {
+            // Don't read ahead LOBs, they may be large
+            const auto& addr = mcr.getColumnRecords().at(pos - 1).getAddress();
+            if (!addr.isNullValueAddress()) m_readaheads[pos].onBlockAccess(addr.getBlockId());
+            column->readRecord(addr, value, false);
+        } else {
+            if (!m_rowWindowValueReadMask.getBit(index)) readColumnValuesInRowWindow(index);
+            value = std::move(m_rowWindowValues[index][m_rowWindowPos]);
+        }
         if (value.isNull() && column->isNotNull()) {
             throwDatabaseError(IOManagerMessageId::kErrorUnexpectedNullValue,
                     m_table->getDatabaseName(), m_table->getName(), column->getName(),
-                    m_currentMcr.getTableRowId());
+                    mcr.getTableRowId());
         }
     }
 
     m_valueReadMask.setBit(index, true);
 }
 
+void TableDataSet::readColumnValuesInRowWindow(std::size_t index)
+{
+    const auto pos = m_columnInfos[index].m_posInTable;
+    auto& column = m_tableColumns[pos];
+    auto& windowValues = m_rowWindowValues[index];
+    windowValues.resize(m_rowWindow.size());
+
+    if (column->isMasterColumn()) {
+        for (auto i = m_rowWindowPos; i < m_rowWindow.size(); ++i)
+            windowValues[i] = m_rowWindow[i].m_mcr.getTableRowId();
+        m_rowWindowValueReadMask.setBit(index, true);
+        return;
+    }
+
+    std::vector<ColumnDataAddress> addresses;
+    addresses.reserve(m_rowWindow.size() - m_rowWindowPos);
+    auto& readahead = m_readaheads[pos];
+    for (auto i = m_rowWindowPos; i < m_rowWindow.size(); ++i) {
+        const auto& addr = m_rowWindow[i].m_mcr.getColumnRecords().at(pos - 1).getAddress();
+        if (!addr.isNullValueAddress()) readahead.onBlockAccess(addr.getBlockId());
+        addresses.push_back(addr);
+    }
+
+    std::vector<Variant> values;
+    column->readRecords(addresses, values, false);
+
+    std::move(values.begin(), values.end(), windowValues.begin() + m_rowWindowPos);
+    m_rowWindowValueReadMask.setBit(index, true);
+}
+
 }  // namespace siodb::iomgr::dbengine
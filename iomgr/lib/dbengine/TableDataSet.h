@@ -6,8 +6,10 @@
 
 // Project headers
 #include "Column.h"
+#include "ColumnDataBlockReadahead.h"
 #include "DataSet.h"
 #include "Table.h"
+#include "parser/expr/Expression.h"
 
 // Common project headers
 #include <siodb/common/utils/HelperMacros.h>
@@ -59,7 +61,7 @@ public:
      */
     const auto& getCurrentMcr() const noexcept
     {
-        return m_currentMcr;
+        return m_rowWindow[m_rowWindowPos].m_mcr;
     }
 
     /**
@@ -72,6 +74,22 @@ public:
      */
     const Variant& getColumnValue(std::size_t columnIndex) override;
 
+    /**
+     * Returns number of rows in the current batch, which are remaining rows
+     * of the row window.
+     * @return Number of rows in the batch.
+     */
+    std::size_t getBatchRowCount() const noexcept override;
+
+    /**
+     * Returns column values of the rows of the current batch.
+     * @param index Column index.
+     * @return Address of the value of the current row, followed by the values
+     *         of the remaining rows of the batch.
+     * @throw std::runtime_error if no more rows is available.
+     */
+    const Variant* getBatchColumnValues(std::size_t index) override;
+
     /**
      * Returns column data type
      * @param columnIndex Column index.
@@ -101,6 +119,18 @@ public:
      */
     std::uint32_t getDataSourceId() const noexcept override;
 
+    /**
+     * Chooses how rows which may match the WHERE condition are found. Rows are found
+     * by the TRID ranges in the master column index, using the most selective secondary
+     * index or skipped based on value summaries of column data blocks. Only comparisons
+     * of columns of this dataset with constants, BETWEEN and IN predicates joined with AND
+     * are taken into account, so condition still must be evaluated for each row.
+     * Must be called after all used columns are added into the dataset.
+     * @param where WHERE condition.
+     * @param dataSetIndex Index of this dataset in the database context.
+     */
+    void chooseAccessPath(const requests::Expression& where, std::size_t dataSetIndex);
+
     /** Reset cursor position to the first row. */
     void resetCursor() override;
 
@@ -129,8 +159,42 @@ public:
             const std::vector<std::size_t>& columnPositions, std::uint32_t currentUserId);
 
 private:
-    /** Reads master column record of the current row. */
-    void readMasterColumnRecord();
+    /** Inclusive range of table row IDs */
+    using TridRange = std::pair<std::uint64_t, std::uint64_t>;
+
+    /** Row window entry */
+    struct RowWindowEntry {
+        /** Master column record */
+        MasterColumnRecord m_mcr;
+
+        /** Master column record address */
+        ColumnDataAddress m_mcrAddress;
+    };
+
+private:
+    /**
+     * Reads master column record for the current key.
+     * @param[out] entry Row window entry to fill.
+     */
+    void readMasterColumnRecord(RowWindowEntry& entry);
+
+    /**
+     * Moves current key forward until it refers to the row which is not skipped.
+     * @return true if such key exists, false otherwise.
+     */
+    bool skipExcludedKeys();
+
+    /**
+     * Moves current key to the next row which is not skipped.
+     * @return true if such key exists, false otherwise.
+     */
+    bool moveToNextKey();
+
+    /**
+     * Fills row window, starting from the row with the current key.
+     * @param firstWindow Indicates that this is first window after cursor reset.
+     */
+    void fillRowWindow(bool firstWindow);
 
     /**
      * Reads value of the column.
@@ -138,6 +202,12 @@ private:
      */
     void readColumnValue(std::size_t index);
 
+    /**
+     * Reads values of the column for all remaining rows in the row window.
+     * @param index Column index.
+     */
+    void readColumnValuesInRowWindow(std::size_t index);
+
 private:
     /** Table object */
     const TablePtr m_table;
@@ -154,17 +224,50 @@ private:
     /** Index key buffer */
     std::uint8_t m_key[16];
 
-    /** Current master column record */
-    MasterColumnRecord m_currentMcr;
+    /**
+     * Row window: master column records of the rows read ahead of the cursor.
+     * Values of the column are read for all rows in the window at once.
+     */
+    std::vector<RowWindowEntry> m_rowWindow;
+
+    /** Current row position in the row window */
+    std::size_t m_rowWindowPos;
 
-    /** Current master column record address */
-    ColumnDataAddress m_currentMcrAddress;
+    /** Row window capacity, grows up to kMaxRowWindowSize while scan continues */
+    std::size_t m_rowWindowCapacity;
+
+    /** Column values read for the row window, indexed by dataset column index */
+    std::vector<std::vector<Variant>> m_rowWindowValues;
+
+    /** Indicates which columns have values read for the row window */
+    utils::Bitmask m_rowWindowValueReadMask;
+
+    /** Readahead of column data blocks, indexed by column position in table */
+    std::vector<ColumnDataBlockReadahead> m_readaheads;
+
+    /** Indicates that there are no more keys after the last row in the window */
+    bool m_noMoreKeys;
 
     /** Current row key from index */
     std::uint8_t* m_currentKey;
 
     /** Next row key from index */
     std::uint8_t* m_nextKey;
+
+    /** Indicates that rows with TRIDs out of m_tridRanges are skipped */
+    bool m_skipRows;
+
+    /** Ordered non-overlapping ranges of TRIDs of rows which may match WHERE condition */
+    std::vector<TridRange> m_tridRanges;
+
+    /** Position of the first TRID range which may contain current or next TRIDs */
+    std::size_t m_tridRangePos;
+
+    /** Initial row window size */
+    static constexpr std::size_t kInitialRowWindowSize = 16;
+
+    /** Maximum row window size */
+    static constexpr std::size_t kMaxRowWindowSize = 1024;
 };
 
 }  // namespace siodb::iomgr::dbengine
@@ -160,6 +160,7 @@ std::size_t Variant::deserialize(const std::uint8_t* buffer, std::size_t length)
 {
     if (SIODB_UNLIKELY(length == 0)) throw VariantDeserializationError("Data length is zero");
     const auto b = *buffer++;
+    --length;
     if (SIODB_UNLIKELY(b >= static_cast<std::uint8_t>(VariantType::kMax))) {
         throw VariantDeserializationError(
                 "Invalid data type" + std::to_string(static_cast<unsigned>(b)));
@@ -11,6 +11,7 @@
 // Common project headers
 #include <siodb/common/config/SiodbDefs.h>
 #include <siodb/common/io/FileIO.h>
+#include <siodb/common/log/Log.h>
 #include <siodb/common/stl_wrap/filesystem_wrapper.h>
 #include <siodb/common/utils/FsUtils.h>
 #include <siodb/common/utils/PlainBinaryEncoding.h>
@@ -20,8 +21,7 @@
 
 // STL headers
 #include <algorithm>
-#include <fstream>
-#include <sstream>
+#include <thread>
 
 // System headers
 #include <sys/stat.h>
@@ -39,16 +39,17 @@ BPlusTreeIndex::BPlusTreeIndex(Table& table, const std::string& name,
             columns)
     , m_dataFileSize(dataFileSize)
     , m_internalKvPairSize(m_keySize + sizeof(std::uint64_t))
-    , m_branchingFactor(
-              std::min((Node::kSize - InternalNodeHeader::kSerializedSize) / m_internalKvPairSize,
-                      (Node::kSize - LeafNodeHeader::kSerializedSize) / m_kvPairSize))
-    , m_splitThreshold((m_branchingFactor + 1) / 2)
+    , m_branchingFactor(computeBranchingFactor())
+    , m_minEntryCount(m_branchingFactor / 2)
     , m_indexFilePath(makeIndexFilePath(0))
     , m_file(createIndexFile())
     , m_nodeCount(1)
     , m_rootNodeId(1)
-    , m_nextFreeNodeId(1)
+    , m_firstFreeNodeId(0)
+    , m_indexFileHeaderModified(false)
     , m_nodeCache(*this, kNodeCacheCapacity)
+    , m_entryBuffer(std::max(m_kvPairSize, m_internalKvPairSize))
+    , m_splitBuffer((m_branchingFactor + 1) * m_entryBuffer.size())
 {
     createInitializationFlagFile();
 }
@@ -58,17 +59,19 @@ BPlusTreeIndex::BPlusTreeIndex(Table& table, const IndexRecord& indexRecord,
     : Index(table, indexRecord, keyTraits, valueSize, keyCompare)
     , m_dataFileSize(indexRecord.m_dataFileSize)
     , m_internalKvPairSize(m_keySize + sizeof(std::uint64_t))
-    , m_branchingFactor(
-              std::min((Node::kSize - InternalNodeHeader::kSerializedSize) / m_internalKvPairSize,
-                      (Node::kSize - LeafNodeHeader::kSerializedSize) / m_kvPairSize))
-    , m_splitThreshold((m_branchingFactor + 1) / 2)
+    , m_branchingFactor(computeBranchingFactor())
+    , m_minEntryCount(m_branchingFactor / 2)
     , m_indexFilePath(makeIndexFilePath(0))
     , m_file(openIndexFile())
     , m_nodeCount(calculateNodeCount())
-    , m_rootNodeId(findRootNode())
-    , m_nextFreeNodeId(1)
+    , m_rootNodeId(0)
+    , m_firstFreeNodeId(0)
+    , m_indexFileHeaderModified(false)
     , m_nodeCache(*this, kNodeCacheCapacity)
+    , m_entryBuffer(std::max(m_kvPairSize, m_internalKvPairSize))
+    , m_splitBuffer((m_branchingFactor + 1) * m_entryBuffer.size())
 {
+    readIndexFileHeader();
 }
 
 std::uint32_t BPlusTreeIndex::getDataFileSize() const noexcept
@@ -78,58 +81,30 @@ std::uint32_t BPlusTreeIndex::getDataFileSize() const noexcept
 
 bool BPlusTreeIndex::insert(const void* key, const void* value, bool replaceExisting)
 {
-    // Find a node which should contain the key
-    auto node = findNode(key);
-    assert(node->isLeaf());
-
-    // Check if a key already exists
-    auto insertPos = node->m_header.m_common.m_childCount;
-    const auto it = std::lower_bound(
-            node->begin(), node->end(), key, BinarySearchNodeDataCompareFunction(m_keyCompare));
-    if (it != node->end()) {
-        const auto newEntry = (*it).m_data;
-        if (std::memcmp(newEntry, key, m_keySize) == 0) {
-            // Key exists
-            if (replaceExisting) std::memcpy(newEntry + m_keySize, value, m_valueSize);
-            return false;
-        }
-        insertPos = (newEntry - node->m_data - LeafNodeHeader::kSerializedSize) / m_kvPairSize;
-    }
-
-    if (node->m_header.m_common.m_childCount < m_branchingFactor)
-        insertNewEntryToNonFullLeafNode(*node, insertPos, key, value);
-    else
-        insertNewEntryToFullLeafNode(*node, insertPos, key, value);
-
-    return true;
+    return modify([&] { return doInsert(key, value, replaceExisting); });
 }
 
 std::uint64_t BPlusTreeIndex::erase(const void* key)
 {
-    // TODO: Implement BPlusTreeIndex::erase()
-    TEMPORARY_UNUSED(key);
-    return 0;
+    return modify([&] { return doErase(key); });
 }
 
 std::uint64_t BPlusTreeIndex::update(const void* key, const void* value)
 {
-    // TODO: Implement BPlusTreeIndex::update()
-    TEMPORARY_UNUSED(key);
-    TEMPORARY_UNUSED(value);
-    return 0;
+    return modify([&] { return doUpdate(key, value); });
 }
 
-bool BPlusTreeIndex::markAsDeleted(const void* key, const void* value)
+bool BPlusTreeIndex::markAsDeleted(const void* key, [[maybe_unused]] const void* value)
 {
-    // TODO: Implement BPlusTreeIndex::markAsDeleted()
-    TEMPORARY_UNUSED(key);
-    TEMPORARY_UNUSED(value);
-    return false;
+    return modify([&] { return doErase(key); }) > 0;
 }
 
 void BPlusTreeIndex::flush()
 {
+    std::lock_guard lock(m_writeMutex);
     try {
+        if (m_indexFileHeaderModified) writeIndexFileHeader();
+        std::lock_guard cacheLock(m_cacheMutex);
         m_nodeCache.flush();
     } catch (std::exception& ex) {
         throwDatabaseError(IOManagerMessageId::kErrorBptiFlushNodeCacheFailed,
@@ -144,68 +119,162 @@ std::uint64_t BPlusTreeIndex::getValue(const void* key, void* value, std::size_t
     // otherwise there is no sense to continue
     if (count == 0) return 0;
 
-    // Find a node which may contain the key
-    auto node = findNode(key);
-    assert(node->isLeaf());
-
-    // Attempt to find a key
-    const auto it = std::lower_bound(
-            node->begin(), node->end(), key, BinarySearchNodeDataCompareFunction(m_keyCompare));
-    if (it == node->end()) return 0;
-    auto v = (*it).m_data;
-    if (m_keyCompare(key, v)) return 0;
-
-    std::memcpy(value, v + m_keySize, m_valueSize);
-    return 1;
+    while (true) {
+        std::uint64_t version = 0;
+        const auto leaf = findLeafForReading(key, LeafSearchTarget::kKey, version);
+        if (!leaf) {
+            std::this_thread::yield();
+            continue;
+        }
+        const auto entryCount = getEntryCount(*leaf);
+        const auto pos = findLowerBound(*leaf, entryCount, key);
+        const auto entry = getEntry(*leaf, pos);
+        const bool found = pos < entryCount && compareKeys(entry, key) == 0;
+        if (found) std::memcpy(value, entry + m_keySize, m_valueSize);
+        if (leaf->validate(version)) return found ? 1 : 0;
+    }
 }
 
 std::uint64_t BPlusTreeIndex::count(const void* key)
 {
-    // Find a node which may contain the key
-    auto node = findNode(key);
-    assert(node->isLeaf());
+    while (true) {
+        std::uint64_t version = 0;
+        const auto leaf = findLeafForReading(key, LeafSearchTarget::kKey, version);
+        if (!leaf) {
+            std::this_thread::yield();
+            continue;
+        }
+        const auto entryCount = getEntryCount(*leaf);
+        const auto pos = findLowerBound(*leaf, entryCount, key);
+        const bool found = pos < entryCount && compareKeys(getEntry(*leaf, pos), key) == 0;
+        if (leaf->validate(version)) return found ? 1 : 0;
+    }
+}
 
-    // Check that node actually has a key
-    return std::binary_search(node->begin(), node->end(), key,
-                   BinarySearchNodeDataCompareFunction(m_keyCompare))
-                   ? 1
-                   : 0;
+bool BPlusTreeIndex::getMinKey(void* key)
+{
+    return readEdgeKey(false, key);
 }
 
-bool BPlusTreeIndex::getMinKey([[maybe_unused]] void* key)
+bool BPlusTreeIndex::getMaxKey(void* key)
 {
-    // TODO: Implement BPlusTreeIndex::getMinKey()
-    return false;
+    return readEdgeKey(true, key);
 }
 
-bool BPlusTreeIndex::getMaxKey([[maybe_unused]] void* key)
+bool BPlusTreeIndex::getFirstKey(void* key)
 {
-    // TODO: Implement BPlusTreeIndex::getMinKey()
-    return false;
+    return readEdgeKey(false, key);
 }
 
-bool BPlusTreeIndex::getFirstKey([[maybe_unused]] void* key)
+bool BPlusTreeIndex::getLastKey(void* key)
 {
-    // TODO: Implement BPlusTreeIndex::getFirstKey()
-    return false;
+    return readEdgeKey(true, key);
 }
 
-bool BPlusTreeIndex::getLastKey([[maybe_unused]] void* key)
+bool BPlusTreeIndex::getPrevKey(const void* key, void* prevKey)
 {
-    // TODO: Implement BPlusTreeIndex::getLastKey()
-    return false;
+    return readAdjacentKey(key, false, prevKey);
 }
 
-bool BPlusTreeIndex::getPrevKey([[maybe_unused]] const void* key, [[maybe_unused]] void* prevKey)
+bool BPlusTreeIndex::getNextKey(const void* key, void* nextKey)
 {
-    // TODO: Implement BPlusTreeIndex::getPrevKey()
-    return false;
+    return readAdjacentKey(key, true, nextKey);
 }
 
-bool BPlusTreeIndex::getNextKey([[maybe_unused]] const void* key, [[maybe_unused]] void* nextKey)
+void BPlusTreeIndex::bulkLoad(
+        std::uint64_t entryCount, const std::function<void(std::uint8_t* entry)>& readEntry)
 {
-    // TODO: Implement BPlusTreeIndex::getNextKey()
-    return false;
+    std::lock_guard lock(m_writeMutex);
+    const auto root = getNode(m_rootNodeId.load(std::memory_order_relaxed));
+    if (!root->isLeaf() || root->m_header.m_common.m_childCount > 0 || m_nodeCount != 1)
+        throw std::logic_error("B+ tree bulk load requires empty index");
+    if (entryCount == 0) return;
+
+    std::vector<std::uint8_t> lastKey(m_keySize);
+    std::uint64_t readEntryCount = 0;
+    const auto readLeafEntries = [&](std::uint8_t* entries, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i, entries += m_kvPairSize) {
+            readEntry(entries);
+            if (readEntryCount++ > 0 && compareKeys(lastKey.data(), entries) >= 0)
+                throw std::invalid_argument("B+ tree bulk load entries are not ordered");
+            std::memcpy(lastKey.data(), entries, m_keySize);
+        }
+    };
+
+    // Build levels bottom-up until remaining entries fit into the root node.
+    // Each level produces (lower bound, node ID) entries for the level above it.
+    const std::uint64_t fillCount =
+            std::max(m_minEntryCount, m_branchingFactor * kBulkLoadFillFactor / 100);
+    std::vector<std::uint8_t> levelEntries;
+    std::uint64_t levelEntryCount = entryCount;
+    bool leafLevel = true;
+    const auto node = std::make_unique<Node>(0);
+    while (levelEntryCount > m_branchingFactor) {
+        // Don't leave underfull nodes at the end of the level
+        auto nodeCount = (levelEntryCount + fillCount - 1) / fillCount;
+        while (nodeCount > 1 && levelEntryCount / nodeCount < m_minEntryCount)
+            --nodeCount;
+
+        std::vector<std::uint8_t> upperLevelEntries(nodeCount * m_internalKvPairSize);
+        const auto firstNodeId = m_nodeCount + 1;
+        const auto lastNodeId = m_nodeCount + nodeCount;
+        const auto* levelEntry = levelEntries.data();
+        auto upperLevelEntry = upperLevelEntries.data();
+        for (auto nodeId = firstNodeId; nodeId <= lastNodeId; ++nodeId) {
+            const std::size_t count = levelEntryCount / nodeCount
+                                      + ((nodeId - firstNodeId) < levelEntryCount % nodeCount);
+            std::memset(node->m_data, 0, Node::kSize);
+            auto& leafNodeHeader = node->m_header.m_leafNodeHeader;
+            leafNodeHeader.m_nodeId = nodeId;
+            leafNodeHeader.m_childCount = count;
+            if (leafLevel) {
+                leafNodeHeader.m_nodeType = NodeType::kLeafNode;
+                leafNodeHeader.m_prevNodeId = nodeId > firstNodeId ? nodeId - 1 : 0;
+                leafNodeHeader.m_nextNodeId = nodeId < lastNodeId ? nodeId + 1 : 0;
+                readLeafEntries(getEntry(*node, 0), count);
+            } else {
+                node->m_header.m_common.m_nodeType = NodeType::kInternalNode;
+                std::memcpy(getEntry(*node, 0), levelEntry, count * m_internalKvPairSize);
+                levelEntry += count * m_internalKvPairSize;
+            }
+            node->serializeHeader();
+            writeNode(*node);
+            m_nodeCount = nodeId;
+
+            std::memcpy(upperLevelEntry, getEntry(*node, 0), m_keySize);
+            upperLevelEntry = ::pbeEncodeUInt64(nodeId, upperLevelEntry + m_keySize);
+        }
+
+        levelEntries = std::move(upperLevelEntries);
+        levelEntryCount = nodeCount;
+        leafLevel = false;
+    }
+
+    // Remaining entries go into the root node
+    const auto entrySize = leafLevel ? m_kvPairSize : m_internalKvPairSize;
+    if (leafLevel) {
+        levelEntries.resize(levelEntryCount * entrySize);
+        readLeafEntries(levelEntries.data(), levelEntryCount);
+    }
+    m_modifiedNodes.reserve(1);
+    markModified(root);
+    root->m_header.m_common.m_nodeType =
+            leafLevel ? NodeType::kRootLeafNode : NodeType::kRootInternalNode;
+    root->m_header.m_common.m_childCount = levelEntryCount;
+    std::memcpy(getEntry(*root, 0), levelEntries.data(), levelEntryCount * entrySize);
+    saveModifiedNodes();
+}
+
+// ----- internals -----
+
+std::size_t BPlusTreeIndex::computeBranchingFactor() const
+{
+    const auto branchingFactor =
+            std::min((Node::kSize - InternalNodeHeader::kSerializedSize) / m_internalKvPairSize,
+                    (Node::kSize - LeafNodeHeader::kSerializedSize) / m_kvPairSize);
+    if (branchingFactor < kMinBranchingFactor)
+        throw std::invalid_argument("Key or value is too long for the B+ tree index");
+    return branchingFactor;
 }
 
 io::FilePtr BPlusTreeIndex::createIndexFile() const
@@ -213,18 +282,20 @@ io::FilePtr BPlusTreeIndex::createIndexFile() const
     std::string tmpFilePath;
 
     // Create data file as temporary file
-    constexpr int kBaseExtraOpenFlags = O_DSYNC;
+    const auto wal = getDatabase().getInstance().getWriteAheadLog();
+    const int baseExtraOpenFlags =
+            (wal ? 0 : O_DSYNC) | getDatabase().getInstance().getDirectIoOpenFlags();
     io::FilePtr file;
     try {
         try {
-            file = m_table.getDatabase().createFile(m_dataDir, kBaseExtraOpenFlags | O_TMPFILE,
+            file = m_table.getDatabase().createFile(m_dataDir, baseExtraOpenFlags | O_TMPFILE,
                     kDataFileCreationMode, m_dataFileSize);
         } catch (std::system_error& ex) {
             if (ex.code().value() != ENOTSUP) throw;
             // O_TMPFILE not supported, fallback to named temporary file
             tmpFilePath = m_indexFilePath + kTempFileExtension;
             file = m_table.getDatabase().createFile(
-                    tmpFilePath, kBaseExtraOpenFlags, kDataFileCreationMode, m_dataFileSize);
+                    tmpFilePath, baseExtraOpenFlags, kDataFileCreationMode, m_dataFileSize);
         }
     } catch (std::system_error& ex) {
         throwDatabaseError(IOManagerMessageId::kErrorCannotCreateIndexFile, m_indexFilePath,
@@ -235,43 +306,40 @@ io::FilePtr BPlusTreeIndex::createIndexFile() const
     BinaryValue buffer(Node::kSize, 0);
 
     // Write index header
+    constexpr std::uint64_t kInitialRootNodeId = 1;
     IndexFileHeader indexFileHeader;
+    indexFileHeader.m_rootNodeId = kInitialRootNodeId;
     indexFileHeader.serialize(buffer.data());
     if (file->write(buffer.data(), buffer.size(), 0) != buffer.size()) {
-        const int errorCode = errno;
         throwDatabaseError(IOManagerMessageId::kErrorCannotWriteIndexFile, m_indexFilePath,
                 m_table.getDatabaseName(), m_table.getName(), m_name, m_table.getDatabaseUuid(),
-                m_table.getId(), m_id, 0, buffer.size(), errorCode, std::strerror(errorCode));
+                m_table.getId(), m_id, 0, buffer.size(), file->getLastError(),
+                std::strerror(file->getLastError()));
     }
 
     // Write root node
-    constexpr std::uint64_t kInitialRootNodeId = 1;
     LeafNodeHeader rootNodeHeader;
     rootNodeHeader.m_nodeId = kInitialRootNodeId;
     rootNodeHeader.m_nodeType = NodeType::kRootLeafNode;
     rootNodeHeader.m_childCount = 0;
     rootNodeHeader.m_prevNodeId = 0;
     rootNodeHeader.m_nextNodeId = 0;
-    std::memset(buffer.data(), 0, IndexFileHeader::kSerializedSize);
+    buffer.fill(0);
     rootNodeHeader.serialize(buffer.data());
-    auto nodeOffset = Node::getOffset(1);
+    const auto nodeOffset = Node::getOffset(kInitialRootNodeId);
     if (file->write(buffer.data(), buffer.size(), nodeOffset) != buffer.size()) {
-        const int errorCode = errno;
         throwDatabaseError(IOManagerMessageId::kErrorCannotWriteIndexFile, m_indexFilePath,
                 m_table.getDatabaseName(), m_table.getName(), m_name, m_table.getDatabaseUuid(),
-                m_table.getId(), m_id, nodeOffset, buffer.size(), errorCode,
-                std::strerror(errorCode));
+                m_table.getId(), m_id, nodeOffset, buffer.size(), file->getLastError(),
+                std::strerror(file->getLastError()));
     }
 
-    // Write root node ID
-    ::pbeEncodeUInt64(kInitialRootNodeId, buffer.data());
-    nodeOffset = Node::getOffset(0);
-    if (file->write(buffer.data(), sizeof(std::uint64_t), nodeOffset) != sizeof(std::uint64_t)) {
-        const int errorCode = errno;
+    // Initial contents are flushed directly instead of logging the whole file
+    if (wal && !file->flush()) {
         throwDatabaseError(IOManagerMessageId::kErrorCannotWriteIndexFile, m_indexFilePath,
                 m_table.getDatabaseName(), m_table.getName(), m_name, m_table.getDatabaseUuid(),
-                m_table.getId(), m_id, nodeOffset, sizeof(std::uint64_t), errorCode,
-                std::strerror(errorCode));
+                m_table.getId(), m_id, 0, nodeOffset + buffer.size(), file->getLastError(),
+                std::strerror(file->getLastError()));
     }
 
     if (tmpFilePath.empty()) {
@@ -295,19 +363,24 @@ io::FilePtr BPlusTreeIndex::createIndexFile() const
         }
     }
 
+    if (wal) file->enableWriteAheadLog(wal, m_indexFilePath);
     return file;
 }
 
 io::FilePtr BPlusTreeIndex::openIndexFile() const
 {
+    const auto wal = getDatabase().getInstance().getWriteAheadLog();
+    const int extraOpenFlags =
+            (wal ? 0 : O_DSYNC) | getDatabase().getInstance().getDirectIoOpenFlags();
     io::FilePtr file;
     try {
-        file = m_table.getDatabase().openFile(m_indexFilePath, O_DSYNC);
+        file = m_table.getDatabase().openFile(m_indexFilePath, extraOpenFlags);
     } catch (std::system_error& ex) {
         throwDatabaseError(IOManagerMessageId::kErrorCannotOpenIndexFile, m_indexFilePath,
                 m_table.getDatabaseName(), m_table.getName(), m_name, m_table.getDatabaseUuid(),
                 m_table.getId(), m_id, ex.code().value(), std::strerror(ex.code().value()));
     }
+    if (wal) file->enableWriteAheadLog(wal, m_indexFilePath);
     return file;
 }
 
@@ -316,8 +389,7 @@ std::size_t BPlusTreeIndex::calculateNodeCount() const
     // Validate index file size
     struct stat st;
     if (!m_file->stat(st)) {
-        const auto indexFilePath = makeIndexFilePath(0);
-        throwDatabaseError(IOManagerMessageId::kErrorCannotStatIndexFile, indexFilePath,
+        throwDatabaseError(IOManagerMessageId::kErrorCannotStatIndexFile, m_indexFilePath,
                 m_table.getDatabaseName(), m_table.getName(), m_name, m_table.getDatabaseUuid(),
                 m_table.getId(), m_id, m_file->getLastError(),
                 std::strerror(m_file->getLastError()));
@@ -328,242 +400,710 @@ std::size_t BPlusTreeIndex::calculateNodeCount() const
                 "invalid file size");
     }
 
-    // Determine number of nodes
-    const auto nodeCount = (st.st_size / Node::kSize) - 1;
-    //LOG_DEBUG << "Node count: " << m_nodeCount;
-    if (static_cast<off_t>((nodeCount + 1) * Node::kSize) != st.st_size) {
+    // Determine number of nodes, node 0 is occupied by the index file header
+    return (st.st_size / Node::kSize) - 1;
+}
+
+void BPlusTreeIndex::readIndexFileHeader()
+{
+    // Node 0 is reserved for the header, so node offsets don't depend on the header size
+    static_assert(IndexFileHeader::kSerializedSize <= Node::kSize,
+            "Index file header doesn't fit into the node 0");
+    std::uint8_t buffer[IndexFileHeader::kSerializedSize];
+    if (m_file->read(buffer, sizeof(buffer), 0) != sizeof(buffer)) {
+        throwDatabaseError(IOManagerMessageId::kErrorCannotReadIndexFile, m_indexFilePath,
+                m_table.getDatabaseName(), m_table.getName(), m_name, m_table.getDatabaseUuid(),
+                m_table.getId(), m_id, 0, sizeof(buffer), m_file->getLastError(),
+                std::strerror(m_file->getLastError()));
+    }
+
+    IndexFileHeader indexFileHeader;
+    if (!indexFileHeader.deserialize(buffer)) {
         throwDatabaseError(IOManagerMessageId::kErrorIndexFileCorrupted, m_table.getDatabaseName(),
                 m_table.getName(), m_name, m_table.getDatabaseUuid(), m_table.getId(), m_id,
-                "invalid file size");
+                "invalid header");
+    }
+    if (indexFileHeader.m_firstFreeNodeId > m_nodeCount) {
+        throwDatabaseError(IOManagerMessageId::kErrorIndexFileCorrupted, m_table.getDatabaseName(),
+                m_table.getName(), m_name, m_table.getDatabaseUuid(), m_table.getId(), m_id,
+                "invalid free node list");
+    }
+
+    // Load and validate root node
+    const auto rootNodeId = indexFileHeader.m_rootNodeId;
+    if (rootNodeId == 0 || rootNodeId > m_nodeCount || !getNode(rootNodeId)->isRoot()) {
+        throwDatabaseError(IOManagerMessageId::kErrorCannotFindIndexRoot, m_table.getDatabaseName(),
+                m_table.getName(), m_name, m_table.getDatabaseUuid(), m_table.getId(), m_id);
     }
 
-    return nodeCount;
+    m_rootNodeId = rootNodeId;
+    m_firstFreeNodeId = indexFileHeader.m_firstFreeNodeId;
 }
 
-std::size_t BPlusTreeIndex::findRootNode()
+void BPlusTreeIndex::writeIndexFileHeader()
 {
-    // Read root node ID
-    std::uint8_t buffer[sizeof(uint64_t)];
-    const auto readOffset = Node::getOffset(0);
-    if (m_file->read(buffer, sizeof(std::uint64_t), readOffset) != sizeof(std::uint64_t)) {
-        throwDatabaseError(IOManagerMessageId::kErrorCannotReadIndexFile, m_indexFilePath,
+    IndexFileHeader indexFileHeader;
+    indexFileHeader.m_rootNodeId = m_rootNodeId.load(std::memory_order_relaxed);
+    indexFileHeader.m_firstFreeNodeId = m_firstFreeNodeId;
+    std::uint8_t buffer[IndexFileHeader::kSerializedSize];
+    indexFileHeader.serialize(buffer);
+    if (m_file->write(buffer, sizeof(buffer), 0) != sizeof(buffer)) {
+        throwDatabaseError(IOManagerMessageId::kErrorCannotWriteIndexFile, m_indexFilePath,
                 m_table.getDatabaseName(), m_table.getName(), m_name, m_table.getDatabaseUuid(),
-                m_table.getId(), m_id, readOffset, sizeof(std::uint64_t), m_file->getLastError(),
+                m_table.getId(), m_id, 0, sizeof(buffer), m_file->getLastError(),
                 std::strerror(m_file->getLastError()));
     }
-    std::uint64_t rootNodeId = 0;
-    ::pbeDecodeUInt64(buffer, &rootNodeId);
+    m_indexFileHeaderModified = false;
+}
 
-#if 0
-    // Fallback method - find root node by enumerating and testing all nodes sequentially
-    std::uint64_t rootNodeId = 1;
+BPlusTreeIndex::NodePtr BPlusTreeIndex::findLeafForReading(
+        const void* key, LeafSearchTarget target, std::uint64_t& version)
+{
+    // Optimistic lock coupling: child node version is obtained before parent node
+    // is validated, so that child can't be changed by a split or merge unnoticed.
+    const auto rootNodeId = m_rootNodeId.load(std::memory_order_acquire);
     auto node = getNode(rootNodeId);
-    while (node && node->m_header.m_common.m_nodeType != NodeType::kRootInternalNode
-            && node->m_header.m_common.m_nodeType != NodeType::kRootLeafNode) {
-        ++rootNodeId;
-        node = getNode(rootNodeId);
+    if (!node->tryReadLock(version) || m_rootNodeId.load(std::memory_order_acquire) != rootNodeId)
+        return nullptr;
+
+    while (!node->isLeaf()) {
+        const auto count = getEntryCount(*node);
+        std::size_t pos = 0;
+        switch (target) {
+            case LeafSearchTarget::kKey: pos = findChildPosition(*node, count, key); break;
+            case LeafSearchTarget::kFirst: break;
+            case LeafSearchTarget::kLast: pos = count > 0 ? count - 1 : 0; break;
+        }
+        const auto childNodeId = getChildNodeId(*node, pos);
+        if (!node->validate(version)) return nullptr;
+        auto child = getNode(childNodeId);
+        std::uint64_t childVersion = 0;
+        if (!child->tryReadLock(childVersion) || !node->validate(version)) return nullptr;
+        node = std::move(child);
+        version = childVersion;
     }
-#endif
+    return node;
+}
 
-    // Load and validate root node
-    auto node = getNode(rootNodeId);
-    if (!node || !node->isRoot()) {
-        throwDatabaseError(IOManagerMessageId::kErrorCannotFindIndexRoot, m_table.getDatabaseName(),
-                m_table.getName(), m_name, m_table.getDatabaseUuid(), m_table.getId(), m_id);
+std::optional<bool> BPlusTreeIndex::readNeighbourLeafKey(
+        NodePtr node, std::uint64_t version, bool forward, void* key)
+{
+    while (true) {
+        const auto& leafNodeHeader = node->m_header.m_leafNodeHeader;
+        const auto neighbourNodeId =
+                forward ? leafNodeHeader.m_nextNodeId : leafNodeHeader.m_prevNodeId;
+        if (!node->validate(version)) return std::nullopt;
+        if (neighbourNodeId == 0) return false;
+
+        auto neighbour = getNode(neighbourNodeId);
+        std::uint64_t neighbourVersion = 0;
+        if (!neighbour->tryReadLock(neighbourVersion) || !node->validate(version))
+            return std::nullopt;
+        node = std::move(neighbour);
+        version = neighbourVersion;
+
+        // Normally only root leaf can be empty, but skip empty leaves anyway
+        const auto count = getEntryCount(*node);
+        if (count > 0) {
+            std::memcpy(key, getEntry(*node, forward ? 0 : count - 1), m_keySize);
+            if (!node->validate(version)) return std::nullopt;
+            return true;
+        }
     }
+}
 
-    // Save root node ID
-    return rootNodeId;
-}
-
-BPlusTreeIndex::NodePtr BPlusTreeIndex::findNode(const void* key)
-{
-    // Each node contains:
-    // - header
-    // - series of (key, value) pairs, where value:
-    //     - in the internal node is 64-bit child node ID
-    //     - in the leaf node is 64-bit data offset
-
-    // Search algorithm as described in the https://en.wikipedia.org/wiki/B%2B_tree
-    //
-    // Function: search (k)
-    // return tree_search (k, root);
-    //
-    // Function: tree_search (k, node)
-    // if node is a leaf then
-    //     return node;
-    // switch k do
-    // case k ≤ k_0
-    //     return tree_search(k, p_0);
-    // case k_i < k ≤ k_{i+1}
-    //     return tree_search(k, p_{i+1});
-    // case k_d < k
-    //     return tree_search(k, p_{d});
-    //
-
-    auto currentNodeId = m_rootNodeId;
-    auto currentNode = getNode(currentNodeId);
-
-    while (currentNode && currentNode->m_header.m_common.m_nodeType != NodeType::kLeafNode
-            && currentNode->m_header.m_common.m_nodeType != NodeType::kRootLeafNode) {
-        std::uint64_t nextNodeId = 0;
-        if (m_keyCompare(key, currentNode->m_data + InternalNodeHeader::kSerializedSize) <= 0) {
-            // case k ≤ k_0
-            ::pbeDecodeUInt64(currentNode->m_data + InternalNodeHeader::kSerializedSize + m_keySize,
-                    &nextNodeId);
-        } else {
-            // There must be at least 2 child nodes in this case
-            auto n = currentNode->m_header.m_common.m_childCount;
-            if (n < 2) {
+bool BPlusTreeIndex::readEdgeKey(bool last, void* key)
+{
+    const auto target = last ? LeafSearchTarget::kLast : LeafSearchTarget::kFirst;
+    while (true) {
+        std::uint64_t version = 0;
+        const auto leaf = findLeafForReading(nullptr, target, version);
+        if (leaf) {
+            const auto count = getEntryCount(*leaf);
+            if (count > 0) {
+                std::memcpy(key, getEntry(*leaf, last ? count - 1 : 0), m_keySize);
+                if (leaf->validate(version)) return true;
+            } else {
+                const auto result = readNeighbourLeafKey(leaf, version, !last, key);
+                if (result) return *result;
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+bool BPlusTreeIndex::readAdjacentKey(const void* key, bool forward, void* adjacentKey)
+{
+    while (true) {
+        std::uint64_t version = 0;
+        const auto leaf = findLeafForReading(key, LeafSearchTarget::kKey, version);
+        if (leaf) {
+            const auto count = getEntryCount(*leaf);
+            std::size_t pos = 0;
+            bool found = false;
+            if (forward) {
+                pos = findUpperBound(*leaf, count, key);
+                found = pos < count;
+            } else {
+                pos = findLowerBound(*leaf, count, key);
+                found = pos > 0;
+                if (found) --pos;
+            }
+            if (found) {
+                std::memcpy(adjacentKey, getEntry(*leaf, pos), m_keySize);
+                if (leaf->validate(version)) return true;
+            } else {
+                // Key is beyond this leaf, so adjacent key is the edge key of the neighbour
+                const auto result = readNeighbourLeafKey(leaf, version, forward, adjacentKey);
+                if (result) return *result;
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+BPlusTreeIndex::NodePtr BPlusTreeIndex::findLeafForModification(const void* key, NodePath& path)
+{
+    auto node = getNode(m_rootNodeId.load(std::memory_order_relaxed));
+    while (!node->isLeaf()) {
+        const auto count = getEntryCount(*node);
+        if (count == 0 || node->isFree()) {
+            throwDatabaseError(IOManagerMessageId::kErrorIndexNodeCorrupted,
+                    m_table.getDatabaseName(), m_table.getName(), m_name, node->getId(),
+                    m_table.getDatabaseUuid(), m_table.getId(), m_id);
+        }
+        const auto pos = findChildPosition(*node, count, key);
+        const auto childNodeId = getChildNodeId(*node, pos);
+        path.push_back(PathElement {node, pos});
+        node = getNode(childNodeId);
+    }
+    return node;
+}
+
+template<class Operation>
+auto BPlusTreeIndex::modify(Operation&& operation) -> decltype(operation())
+{
+    std::lock_guard lock(m_writeMutex);
+    const auto nodeCount = m_nodeCount;
+    const auto firstFreeNodeId = m_firstFreeNodeId;
+    decltype(operation()) result {};
+    try {
+        result = operation();
+    } catch (...) {
+        // Operation throws only before it changes any node,
+        // so only node allocation must be rolled back.
+        discardAllocatedNodes(nodeCount);
+        m_firstFreeNodeId = firstFreeNodeId;
+        throw;
+    }
+    saveModifiedNodes();
+    return result;
+}
+
+bool BPlusTreeIndex::doInsert(const void* key, const void* value, bool replaceExisting)
+{
+    NodePath path;
+    const auto leaf = findLeafForModification(key, path);
+    const auto count = getEntryCount(*leaf);
+    const auto pos = findLowerBound(*leaf, count, key);
+    m_modifiedNodes.reserve(path.size() * 2 + 6);
+
+    if (pos < count && compareKeys(getEntry(*leaf, pos), key) == 0) {
+        // Key exists
+        if (replaceExisting) {
+            markModified(leaf);
+            std::memcpy(getEntry(*leaf, pos) + m_keySize, value, m_valueSize);
+        }
+        return false;
+    }
+
+    // Count nodes to split: full leaf and full internal nodes right above it
+    std::size_t splitCount = 0;
+    if (count == m_branchingFactor) {
+        ++splitCount;
+        for (auto it = path.crbegin();
+                it != path.crend() && getEntryCount(*it->m_node) == m_branchingFactor; ++it)
+            ++splitCount;
+    }
+    const bool growTree = splitCount > path.size();
+
+    // Obtain all required nodes before making any changes
+    std::vector<NodePtr> newNodes;
+    newNodes.reserve(splitCount + 1);
+    for (std::size_t i = 0, n = splitCount + (growTree ? 1 : 0); i < n; ++i)
+        newNodes.push_back(getNewNode());
+    NodePtr nextLeaf;
+    const auto nextLeafId = leaf->m_header.m_leafNodeHeader.m_nextNodeId;
+    if (splitCount > 0 && nextLeafId != 0) nextLeaf = getNode(nextLeafId);
+
+    // Nothing below throws
+    std::memcpy(m_entryBuffer.data(), key, m_keySize);
+    std::memcpy(m_entryBuffer.data() + m_keySize, value, m_valueSize);
+    auto node = leaf;
+    auto insertPos = pos;
+    auto newNodeIt = newNodes.cbegin();
+    for (std::size_t level = 0; level < splitCount; ++level) {
+        const auto& newNode = *newNodeIt++;
+        markModified(node);
+        markModified(newNode);
+        const bool isLeaf = node->isLeaf();
+        newNode->m_header.m_common.m_nodeType =
+                isLeaf ? NodeType::kLeafNode : NodeType::kInternalNode;
+        newNode->m_header.m_common.m_childCount = 0;
+        splitNode(*node, *newNode, insertPos, m_entryBuffer.data());
+
+        if (isLeaf) {
+            auto& leafNodeHeader = node->m_header.m_leafNodeHeader;
+            auto& newLeafNodeHeader = newNode->m_header.m_leafNodeHeader;
+            newLeafNodeHeader.m_prevNodeId = node->getId();
+            newLeafNodeHeader.m_nextNodeId = leafNodeHeader.m_nextNodeId;
+            if (nextLeaf) {
+                markModified(nextLeaf);
+                nextLeaf->m_header.m_leafNodeHeader.m_prevNodeId = newNode->getId();
+            }
+            leafNodeHeader.m_nextNodeId = newNode->getId();
+        }
+
+        // Parent entry: lower bound of the new node and its ID
+        std::memcpy(m_entryBuffer.data(), getEntry(*newNode, 0), m_keySize);
+        ::pbeEncodeUInt64(newNode->getId(), m_entryBuffer.data() + m_keySize);
+
+        if (node->isRoot()) {
+            // Grow tree by one level
+            const auto& root = *newNodeIt;
+            markModified(root);
+            root->m_header.m_common.m_nodeType = NodeType::kRootInternalNode;
+            root->m_header.m_common.m_childCount = 2;
+            const auto firstEntry = getEntry(*root, 0);
+            std::memcpy(firstEntry, getEntry(*node, 0), m_keySize);
+            ::pbeEncodeUInt64(node->getId(), firstEntry + m_keySize);
+            std::memcpy(getEntry(*root, 1), m_entryBuffer.data(), m_internalKvPairSize);
+            node->m_header.m_common.m_nodeType =
+                    isLeaf ? NodeType::kLeafNode : NodeType::kInternalNode;
+            m_rootNodeId.store(root->getId(), std::memory_order_release);
+            m_indexFileHeaderModified = true;
+            return true;
+        }
+
+        const auto& parentElement = path[path.size() - 1 - level];
+        node = parentElement.m_node;
+        insertPos = parentElement.m_childPosition + 1;
+    }
+
+    markModified(node);
+    insertEntry(*node, insertPos, m_entryBuffer.data());
+    return true;
+}
+
+std::uint64_t BPlusTreeIndex::doErase(const void* key)
+{
+    NodePath path;
+    const auto leaf = findLeafForModification(key, path);
+    const auto count = getEntryCount(*leaf);
+    const auto pos = findLowerBound(*leaf, count, key);
+    if (pos == count || compareKeys(getEntry(*leaf, pos), key) != 0) return 0;
+
+    // Obtain siblings of the nodes that become underfull before making any changes.
+    // Node borrows entry from the sibling if it has spare entries,
+    // otherwise nodes are merged and parent loses one entry.
+    std::vector<NodePtr> siblings;
+    NodePtr nextLeaf;
+    {
+        auto node = leaf;
+        auto newCount = count - 1;
+        for (std::size_t level = 0; !node->isRoot() && newCount < m_minEntryCount; ++level) {
+            const auto& parentElement = path[path.size() - 1 - level];
+            auto& parent = *parentElement.m_node;
+            if (getEntryCount(parent) < 2) {
                 throwDatabaseError(IOManagerMessageId::kErrorIndexNodeCorrupted,
-                        m_table.getDatabaseName(), m_table.getName(), m_name, currentNodeId,
+                        m_table.getDatabaseName(), m_table.getName(), m_name, parent.getId(),
                         m_table.getDatabaseUuid(), m_table.getId(), m_id);
             }
-
-            --n;
-            std::uint32_t i = 1;
-            for (; i < n - 1; ++i) {
-                const auto currentEntryOffset =
-                        InternalNodeHeader::kSerializedSize + i * m_internalKvPairSize;
-                const auto nextEntryOffset = currentEntryOffset + m_internalKvPairSize;
-                if (m_keyCompare(key, currentNode->m_data + currentEntryOffset) > 0
-                        && m_keyCompare(key, currentNode->m_data + nextEntryOffset) <= 0) {
-                    // case k_i < k ≤ k_{i+1}
-                    ::pbeDecodeUInt64(
-                            currentNode->m_data + nextEntryOffset + m_keySize, &nextNodeId);
-                    break;
-                }
+            const auto childPos = parentElement.m_childPosition;
+            const auto siblingPos = childPos > 0 ? childPos - 1 : childPos + 1;
+            auto sibling = getNode(getChildNodeId(parent, siblingPos));
+            const bool canBorrow = getEntryCount(*sibling) > m_minEntryCount;
+            if (level == 0 && !canBorrow) {
+                const auto& rightLeaf = childPos > 0 ? node : sibling;
+                const auto nextLeafId = rightLeaf->m_header.m_leafNodeHeader.m_nextNodeId;
+                if (nextLeafId != 0) nextLeaf = getNode(nextLeafId);
+            }
+            siblings.push_back(std::move(sibling));
+            if (canBorrow) break;
+            node = parentElement.m_node;
+            newCount = getEntryCount(*node) - 1;
+        }
+    }
+    m_modifiedNodes.reserve(path.size() * 3 + 4);
+
+    // Nothing below throws
+    markModified(leaf);
+    removeEntry(*leaf, pos);
+    auto node = leaf;
+    NodePtr mergedNode;
+    for (std::size_t level = 0; level < siblings.size(); ++level) {
+        const auto& parentElement = path[path.size() - 1 - level];
+        const auto& parent = parentElement.m_node;
+        const auto childPos = parentElement.m_childPosition;
+        const auto& sibling = siblings[level];
+        markModified(parent);
+        markModified(sibling);
+        const bool isLeaf = node->isLeaf();
+        const auto siblingCount = sibling->m_header.m_common.m_childCount;
+
+        if (siblingCount > m_minEntryCount) {
+            if (childPos > 0) {
+                // Borrow last entry of the left sibling
+                insertEntry(*node, 0, getEntry(*sibling, siblingCount - 1));
+                --sibling->m_header.m_common.m_childCount;
+                std::memcpy(getEntry(*parent, childPos), getEntry(*node, 0), m_keySize);
+            } else {
+                // Borrow first entry of the right sibling
+                insertEntry(*node, node->m_header.m_common.m_childCount, getEntry(*sibling, 0));
+                removeEntry(*sibling, 0);
+                std::memcpy(getEntry(*parent, childPos + 1), getEntry(*sibling, 0), m_keySize);
             }
+            return 1;
+        }
 
-            if (i == n - 1) {
-                const auto offset = InternalNodeHeader::kSerializedSize + n * m_internalKvPairSize;
-                if (m_keyCompare(key, currentNode->m_data + offset) > 0) {
-                    // case k_d < k
-                    ::pbeDecodeUInt64(currentNode->m_data + offset + m_keySize, &nextNodeId);
-                } else {
-                    throwDatabaseError(IOManagerMessageId::kErrorIndexNodeCorrupted,
-                            m_table.getDatabaseName(), m_table.getName(), m_name, currentNodeId,
-                            m_table.getDatabaseUuid(), m_table.getId(), m_id);
-                }
+        // Merge right node into the left one
+        const auto left = childPos > 0 ? sibling : node;
+        const auto right = childPos > 0 ? node : sibling;
+        const auto rightPos = childPos > 0 ? childPos : childPos + 1;
+        if (isLeaf) {
+            const auto rightNextNodeId = right->m_header.m_leafNodeHeader.m_nextNodeId;
+            left->m_header.m_leafNodeHeader.m_nextNodeId = rightNextNodeId;
+            if (nextLeaf) {
+                markModified(nextLeaf);
+                nextLeaf->m_header.m_leafNodeHeader.m_prevNodeId = left->getId();
             }
+        } else {
+            // First key of the internal node is not used for search,
+            // so it gets actual lower bound from the parent.
+            std::memcpy(getEntry(*right, 0), getEntry(*parent, rightPos), m_keySize);
         }
+        const auto leftCount = left->m_header.m_common.m_childCount;
+        const auto rightCount = right->m_header.m_common.m_childCount;
+        std::memcpy(getEntry(*left, leftCount), getEntry(*right, 0),
+                rightCount * getEntrySize(*right));
+        left->m_header.m_common.m_childCount = leftCount + rightCount;
+        freeNode(right);
+        removeEntry(*parent, rightPos);
+        mergedNode = left;
+        node = parent;
+    }
 
-        currentNode = getNode(nextNodeId);
-        currentNodeId = nextNodeId;
+    // Shrink tree by one level if root has single child left
+    if (mergedNode && node->isRoot() && node->m_header.m_common.m_childCount == 1) {
+        mergedNode->m_header.m_common.m_nodeType =
+                mergedNode->isLeaf() ? NodeType::kRootLeafNode : NodeType::kRootInternalNode;
+        freeNode(node);
+        m_rootNodeId.store(mergedNode->getId(), std::memory_order_release);
+        m_indexFileHeaderModified = true;
     }
+    return 1;
+}
 
-    if (!currentNode) {
-        throwDatabaseError(IOManagerMessageId::kErrorCannotFindIndexNode, m_table.getDatabaseName(),
-                m_table.getName(), m_name, currentNodeId, m_table.getDatabaseUuid(),
-                m_table.getId(), m_id);
+std::uint64_t BPlusTreeIndex::doUpdate(const void* key, const void* value)
+{
+    NodePath path;
+    const auto leaf = findLeafForModification(key, path);
+    const auto count = getEntryCount(*leaf);
+    const auto pos = findLowerBound(*leaf, count, key);
+    if (pos == count || compareKeys(getEntry(*leaf, pos), key) != 0) return 0;
+    m_modifiedNodes.reserve(1);
+    markModified(leaf);
+    std::memcpy(getEntry(*leaf, pos) + m_keySize, value, m_valueSize);
+    return 1;
+}
+
+void BPlusTreeIndex::markModified(const NodePtr& node) noexcept
+{
+    if (node->isWriteLocked()) return;
+    node->writeLock();
+    node->m_modified = true;
+    // Capacity is reserved by the operation in advance
+    m_modifiedNodes.push_back(node);
+}
+
+void BPlusTreeIndex::saveModifiedNodes()
+{
+    // Publish changes to readers. Nodes remain marked as modified until they are written,
+    // so they stay in the cache and can be saved later by flush() if writing fails here.
+    for (const auto& node : m_modifiedNodes) {
+        node->serializeHeader();
+        node->writeUnlock(node->isFree());
+    }
+
+    const auto nodes = std::move(m_modifiedNodes);
+    m_modifiedNodes.clear();
+
+    // Index file header goes last, so that it refers only to already written nodes
+    for (const auto& node : nodes) {
+        writeNode(*node);
+        node->m_modified = false;
     }
+    if (m_indexFileHeaderModified) writeIndexFileHeader();
+}
 
-    return currentNode;
+void BPlusTreeIndex::discardAllocatedNodes(std::uint64_t nodeCount) noexcept
+{
+    std::lock_guard lock(m_cacheMutex);
+    for (auto nodeId = nodeCount + 1; nodeId <= m_nodeCount; ++nodeId)
+        m_nodeCache.erase(nodeId);
+    m_nodeCount = nodeCount;
 }
 
-BPlusTreeIndex::NodePtr BPlusTreeIndex::getNode(io::File& file, std::uint64_t nodeId)
+void BPlusTreeIndex::writeNode(Node& node) const
 {
+    const auto nodeOffset = Node::getOffset(node.getId());
+    if (m_file->write(node.m_data, Node::kSize, nodeOffset) != Node::kSize) {
+        throwDatabaseError(IOManagerMessageId::kErrorCannotWriteIndexFile, m_indexFilePath,
+                m_table.getDatabaseName(), m_table.getName(), m_name, m_table.getDatabaseUuid(),
+                m_table.getId(), m_id, nodeOffset, Node::kSize, m_file->getLastError(),
+                std::strerror(m_file->getLastError()));
+    }
+}
+
+BPlusTreeIndex::NodePtr BPlusTreeIndex::getNode(std::uint64_t nodeId)
+{
+    std::lock_guard lock(m_cacheMutex);
     auto cachedNode = m_nodeCache.get(nodeId);
-    return cachedNode ? *cachedNode : readNode(file, nodeId);
+    return cachedNode ? *cachedNode : readNode(nodeId);
 }
 
-BPlusTreeIndex::NodePtr BPlusTreeIndex::readNode(io::File& file, std::uint64_t nodeId)
+BPlusTreeIndex::NodePtr BPlusTreeIndex::readNode(std::uint64_t nodeId)
 {
+    // Node 0 is occupied by the index file header
+    if (nodeId == 0) {
+        throwDatabaseError(IOManagerMessageId::kErrorCannotFindIndexNode, m_table.getDatabaseName(),
+                m_table.getName(), m_name, nodeId, m_table.getDatabaseUuid(), m_table.getId(),
+                m_id);
+    }
+
     // Create new node object
-    auto node = std::make_shared<Node>(*this, nodeId);
+    auto node = std::make_shared<Node>(nodeId);
 
     // Read node data
     const auto nodeOffset = Node::getOffset(nodeId);
-    if (file.read(node->m_data, Node::kSize, nodeOffset) != Node::kSize) {
-        const int errorCode = errno;
+    if (m_file->read(node->m_data, Node::kSize, nodeOffset) != Node::kSize) {
         throwDatabaseError(IOManagerMessageId::kErrorCannotReadIndexFile, m_indexFilePath,
                 m_table.getDatabaseName(), m_table.getName(), m_name, m_table.getDatabaseUuid(),
-                m_table.getId(), m_id, nodeOffset, Node::kSize, errorCode,
-                std::strerror(errorCode));
+                m_table.getId(), m_id, nodeOffset, Node::kSize, m_file->getLastError(),
+                std::strerror(m_file->getLastError()));
     }
 
     // Validate node type
-    if (static_cast<int>(node->m_data[0]) >= static_cast<int>(NodeType::kMaxNodeType)) {
+    if (static_cast<int>(node->m_data[Node::kNodeTypeOffset])
+            >= static_cast<int>(NodeType::kMaxNodeType)) {
         throwDatabaseError(IOManagerMessageId::kErrorIndexNodeCorrupted, m_table.getDatabaseName(),
                 m_table.getName(), m_name, nodeId, m_table.getDatabaseUuid(), m_table.getId(),
                 m_id);
     }
 
     // Deserialize node header
-    const auto nodeType = static_cast<NodeType>(node->m_data[0]);
-    if (Node::isLeafNodeType(nodeType))
+    const auto nodeType = static_cast<NodeType>(node->m_data[Node::kNodeTypeOffset]);
+    if (Node::hasLeafNodeHeader(nodeType))
         node->m_header.m_leafNodeHeader.deserialize(node->m_data);
     else
         node->m_header.m_internalNodeHeader.deserialize(node->m_data);
 
+    // Validate node
+    if (node->getId() != nodeId || node->m_header.m_common.m_childCount > m_branchingFactor) {
+        throwDatabaseError(IOManagerMessageId::kErrorIndexNodeCorrupted, m_table.getDatabaseName(),
+                m_table.getName(), m_name, nodeId, m_table.getDatabaseUuid(), m_table.getId(),
+                m_id);
+    }
+
+    // Readers must never use free nodes
+    if (node->isFree()) node->m_version.store(Node::kObsoleteBit, std::memory_order_relaxed);
+
     // Put node to cache
     m_nodeCache.emplace(nodeId, node);
     return node;
 }
 
-BPlusTreeIndex::NodePtr BPlusTreeIndex::makeNode(io::File& file, std::uint64_t nodeId)
+BPlusTreeIndex::NodePtr BPlusTreeIndex::makeNode(std::uint64_t nodeId)
+{
+    auto node = std::make_shared<Node>(nodeId);
+    std::memset(node->m_data, 0, Node::kSize);
+    auto& leafNodeHeader = node->m_header.m_leafNodeHeader;
+    leafNodeHeader.m_nodeType = NodeType::kLeafNode;
+    leafNodeHeader.m_childCount = 0;
+    leafNodeHeader.m_prevNodeId = 0;
+    leafNodeHeader.m_nextNodeId = 0;
+
+    std::lock_guard lock(m_cacheMutex);
+    m_nodeCache.emplace(nodeId, node);
+    return node;
+}
+
+BPlusTreeIndex::NodePtr BPlusTreeIndex::getNewNode()
+{
+    if (m_firstFreeNodeId == 0) return makeNode(++m_nodeCount);
+
+    auto node = getNode(m_firstFreeNodeId);
+    if (!node->isFree()) {
+        throwDatabaseError(IOManagerMessageId::kErrorIndexNodeCorrupted, m_table.getDatabaseName(),
+                m_table.getName(), m_name, node->getId(), m_table.getDatabaseUuid(),
+                m_table.getId(), m_id);
+    }
+    m_firstFreeNodeId = node->m_header.m_leafNodeHeader.m_nextNodeId;
+    m_indexFileHeaderModified = true;
+    return node;
+}
+
+void BPlusTreeIndex::freeNode(const NodePtr& node) noexcept
+{
+    markModified(node);
+    auto& leafNodeHeader = node->m_header.m_leafNodeHeader;
+    leafNodeHeader.m_nodeType = NodeType::kFreeNode;
+    leafNodeHeader.m_childCount = 0;
+    leafNodeHeader.m_prevNodeId = 0;
+    leafNodeHeader.m_nextNodeId = m_firstFreeNodeId;
+    m_firstFreeNodeId = node->getId();
+    m_indexFileHeaderModified = true;
+}
+
+std::uint64_t BPlusTreeIndex::getChildNodeId(Node& node, std::size_t index) const noexcept
+{
+    std::uint64_t childNodeId = 0;
+    ::pbeDecodeUInt64(getEntry(node, index) + m_keySize, &childNodeId);
+    return childNodeId;
+}
+
+std::size_t BPlusTreeIndex::findLowerBound(
+        Node& node, std::size_t count, const void* key) const noexcept
+{
+    std::size_t first = 0, last = count;
+    while (first < last) {
+        const auto middle = first + (last - first) / 2;
+        if (compareKeys(getEntry(node, middle), key) < 0)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    return first;
+}
+
+std::size_t BPlusTreeIndex::findUpperBound(
+        Node& node, std::size_t count, const void* key) const noexcept
 {
-    // TODO: Implement BPlusTreeIndex::makeNode()
-    TEMPORARY_UNUSED(file);
-    TEMPORARY_UNUSED(nodeId);
-    return nullptr;
+    std::size_t first = 0, last = count;
+    while (first < last) {
+        const auto middle = first + (last - first) / 2;
+        if (compareKeys(getEntry(node, middle), key) <= 0)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    return first;
 }
 
-void BPlusTreeIndex::insertNewEntryToNonFullLeafNode(
-        Node& node, std::uint32_t pos, const void* key, const void* value)
+std::size_t BPlusTreeIndex::findChildPosition(
+        Node& node, std::size_t count, const void* key) const noexcept
 {
-    if (pos > node.m_header.m_common.m_childCount)
-        throw std::out_of_range("BPlusTreeIndex: new leaf node element index is out of range");
+    // Find last entry with key not greater than a given key,
+    // key of the first entry is treated as minimum possible key.
+    std::size_t first = 1, last = count;
+    while (first < last) {
+        const auto middle = first + (last - first) / 2;
+        if (compareKeys(getEntry(node, middle), key) <= 0)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    return first - 1;
+}
 
-    const auto newEntry = node.m_data + LeafNodeHeader::kSerializedSize + pos * m_kvPairSize;
+void BPlusTreeIndex::insertEntry(Node& node, std::size_t pos, const std::uint8_t* entry) noexcept
+{
+    const auto entrySize = getEntrySize(node);
+    const auto newEntry = getEntry(node, pos);
     const auto movedEntryCount = node.m_header.m_common.m_childCount - pos;
     if (movedEntryCount > 0)
-        std::memmove(newEntry + m_kvPairSize, newEntry, movedEntryCount * m_kvPairSize);
-
-    std::memcpy(newEntry, key, m_keySize);
-    std::memcpy(newEntry + m_keySize, value, m_valueSize);
+        std::memmove(newEntry + entrySize, newEntry, movedEntryCount * entrySize);
+    std::memcpy(newEntry, entry, entrySize);
     ++node.m_header.m_common.m_childCount;
-    node.m_modified = true;
 }
 
-void BPlusTreeIndex::insertNewEntryToFullLeafNode(
-        Node& node, std::uint32_t pos, const void* key, const void* value)
+void BPlusTreeIndex::removeEntry(Node& node, std::size_t pos) noexcept
 {
-    auto newNode = getNewNode();
+    const auto entrySize = getEntrySize(node);
+    const auto entry = getEntry(node, pos);
+    const auto movedEntryCount = node.m_header.m_common.m_childCount - pos - 1;
+    if (movedEntryCount > 0) std::memmove(entry, entry + entrySize, movedEntryCount * entrySize);
+    --node.m_header.m_common.m_childCount;
+}
 
-    // TODO: Split a node and insert record to a new node
-    TEMPORARY_UNUSED(node);
-    TEMPORARY_UNUSED(pos);
-    TEMPORARY_UNUSED(key);
-    TEMPORARY_UNUSED(value);
+void BPlusTreeIndex::splitNode(
+        Node& node, Node& newNode, std::size_t pos, const std::uint8_t* entry) noexcept
+{
+    const auto entrySize = getEntrySize(node);
+    const auto count = node.m_header.m_common.m_childCount;
+    const auto firstEntry = getEntry(node, 0);
+
+    // Put all entries in order into the split buffer
+    const auto buffer = m_splitBuffer.data();
+    std::memcpy(buffer, firstEntry, pos * entrySize);
+    std::memcpy(buffer + pos * entrySize, entry, entrySize);
+    std::memcpy(buffer + (pos + 1) * entrySize, firstEntry + pos * entrySize,
+            (count - pos) * entrySize);
+
+    // Distribute entries between nodes
+    const auto totalCount = count + 1;
+    const auto leftCount = totalCount / 2;
+    const auto rightCount = totalCount - leftCount;
+    std::memcpy(firstEntry, buffer, leftCount * entrySize);
+    std::memcpy(getEntry(newNode, 0), buffer + leftCount * entrySize, rightCount * entrySize);
+    node.m_header.m_common.m_childCount = leftCount;
+    newNode.m_header.m_common.m_childCount = rightCount;
 }
 
 ///////////////////// class BPlusTreeIndex::IndexFileHeader ///////////////////////////////////////
 
 std::uint8_t* BPlusTreeIndex::IndexFileHeader::serialize(std::uint8_t* buffer) const noexcept
 {
-    return IndexFileHeaderBase::serialize(buffer);
+    buffer = IndexFileHeaderBase::serialize(buffer);
+    buffer = ::pbeEncodeUInt64(m_rootNodeId, buffer);
+    buffer = ::pbeEncodeUInt64(m_firstFreeNodeId, buffer);
+    return buffer;
 }
 
 const std::uint8_t* BPlusTreeIndex::IndexFileHeader::deserialize(
         const std::uint8_t* buffer) noexcept
 {
-    return IndexFileHeaderBase::deserialize(buffer);
+    buffer = IndexFileHeaderBase::deserialize(buffer);
+    if (!buffer) return nullptr;
+    buffer = ::pbeDecodeUInt64(buffer, &m_rootNodeId);
+    buffer = ::pbeDecodeUInt64(buffer, &m_firstFreeNodeId);
+    return buffer;
 }
 
 ///////////////////// class BPlusTreeIndex::NodeCache /////////////////////////////////////////////
 
+BPlusTreeIndex::NodeCache::~NodeCache()
+{
+    try {
+        flush();
+    } catch (...) {
+        // Ignore errors
+    }
+}
+
 void BPlusTreeIndex::NodeCache::flush()
 {
     bool hadErrors = false;
     for (const auto& e : map_internal()) {
+        const auto& node = e.second.first;
+        if (!node->m_modified) continue;
         try {
-            if (e.second.first->m_modified) {
-                // TODO: Write modified block to disk
-                e.second.first->m_modified = false;
-            }
-        } catch (...) {
-            // ignore all exceptions
+            m_owner.writeNode(*node);
+            node->m_modified = false;
+        } catch (std::exception& ex) {
+            hadErrors = true;
+            LOG_ERROR << m_owner.getDisplayName() << ": Failed to save BPTI node #" << e.first
+                      << ": " << ex.what();
         }
     }
     if (hadErrors) {
@@ -574,7 +1114,9 @@ void BPlusTreeIndex::NodeCache::flush()
 bool BPlusTreeIndex::NodeCache::can_evict(
         [[maybe_unused]] const key_type& key, const mapped_type& value) const noexcept
 {
-    return !value->m_modified;
+    // Cache is accessed only with cache mutex locked, so node which is referenced
+    // only by cache can't be obtained by anyone else meanwhile.
+    return value.use_count() == 1 && !value->m_modified;
 }
 
 void BPlusTreeIndex::NodeCache::on_evict([[maybe_unused]] const key_type& key, mapped_type& value,
@@ -586,20 +1128,14 @@ void BPlusTreeIndex::NodeCache::on_evict([[maybe_unused]] const key_type& key, m
 
 bool BPlusTreeIndex::NodeCache::on_last_chance_cleanup()
 {
+    // Save nodes which were left modified after failed write.
+    // Nodes that are in use may be being modified right now, so they are skipped.
     std::size_t savedCount = 0;
     for (const auto& e : map_internal()) {
-        if (!e.second.first->m_modified) continue;
-        // Save node to data file
-        const auto nodeOffset = Node::getOffset(e.first);
-        if (m_owner.m_file->write(e.second.first->m_data, Node::kSize, nodeOffset) != Node::kSize) {
-            const int errorCode = errno;
-            throwDatabaseError(IOManagerMessageId::kErrorCannotWriteIndexFile,
-                    m_owner.getIndexFilePath(), m_owner.getTable().getDatabaseName(),
-                    m_owner.m_table.getName(), m_owner.m_name, m_owner.getTable().getDatabaseUuid(),
-                    m_owner.m_table.getId(), m_owner.m_id, nodeOffset, Node::kSize, errorCode,
-                    std::strerror(errorCode));
-        }
-        e.second.first->m_modified = false;
+        const auto& node = e.second.first;
+        if (node.use_count() > 1 || !node->m_modified) continue;
+        m_owner.writeNode(*node);
+        node->m_modified = false;
         ++savedCount;
     }
     return savedCount > 0;
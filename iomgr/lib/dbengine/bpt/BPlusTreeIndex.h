@@ -9,15 +9,35 @@
 #include "../IndexFileHeaderBase.h"
 
 // Common project headers
-#include <siodb/common/utils/FileDescriptorGuard.h>
 #include <siodb/common/utils/UnorderedLruCache.h>
 
+// CRT headers
+#include <cstring>
+
+// STL headers
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
 // System headers
 #include <sys/types.h>
 
 namespace siodb::iomgr::dbengine {
 
-/** B+ tree index */
+/**
+ * B+ tree index. Keys are unique. Leaf nodes are linked with their siblings
+ * in both directions to support range scans. If no key comparison function
+ * is given, keys are compared bytewise.
+ *
+ * Modifications are serialized by the index write mutex. Each modification
+ * write-locks the nodes it changes and releases them only when the whole
+ * operation is complete. Readers don't take any locks: they traverse the tree
+ * with optimistic lock coupling, validating node versions and restarting
+ * from the root if a node was changed while being read.
+ */
 class BPlusTreeIndex : public Index {
 public:
     /**
@@ -26,7 +46,7 @@ public:
      * @param name Index name.
      * @param keyTraits Key traits.
      * @param valueSize Value size.
-     * @param keyCompare Key comparison function.
+     * @param keyCompare Key comparison function, nullptr for bytewise comparison.
      * @param unique Index uniqueness flag.
      * @param columns Indexed column list.
      * @param dataFileSize Data file size.
@@ -41,7 +61,7 @@ public:
      * @param indexRecord Index record.
      * @param keyTraits Key traits.
      * @param valueSize Value size.
-     * @param keyCompare Key comparison function.
+     * @param keyCompare Key comparison function, nullptr for bytewise comparison.
      */
     BPlusTreeIndex(Table& table, const IndexRecord& indexRecord, const IndexKeyTraits& keyTraits,
             std::size_t valueSize, KeyCompareFunction keyCompare);
@@ -81,13 +101,13 @@ public:
      * Updates data in the index.
      * @param key A key buffer.
      * @param value A value buffer.
-     * @param replaceExisting flag that indicated if existing value to be replaced.
-     * @return true if key found, false if key not found.
+     * @return Number of updated entries.
      */
     std::uint64_t update(const void* key, const void* value) override;
 
     /**
-     * Marks existing key as deleted and updates value.
+     * Marks existing key as deleted. B+ tree doesn't keep deleted entries,
+     * so key is removed from the index and value is ignored.
      * @param key A key buffer.
      * @param value A value buffer.
      * @return true if key existed and changed, false otherwise.
@@ -142,7 +162,7 @@ public:
     bool getLastKey(void* key) override;
 
     /**
-     * Returns previous key in the index.
+     * Returns previous key in the index. Given key doesn't have to exist.
      * @param key Current key.
      * @param prevKey Buffer for storing previous key.
      * @return true if previous key obtained, false otherwise.
@@ -150,19 +170,35 @@ public:
     bool getPrevKey(const void* key, void* prevKey) override;
 
     /**
-     * Returns next key in the index.
+     * Returns next key in the index. Given key doesn't have to exist.
      * @param key Current key.
      * @param nextKey Buffer for storing next key.
      * @return true if next key obtained, false otherwise.
      */
     bool getNextKey(const void* key, void* nextKey) override;
 
+    /**
+     * Builds tree bottom-up from the sorted entries. Index must be empty.
+     * Nodes are filled up to the bulk load fill factor, so that subsequent
+     * inserts don't cause immediate splits.
+     * @param entryCount Number of entries.
+     * @param readEntry Function that writes next (key, value) pair into a given buffer.
+     *                  Entries must be ordered by key in strictly ascending order.
+     * @throw std::logic_error if index is not empty.
+     * @throw std::invalid_argument if entries are not ordered.
+     * @throw DatabaseError if write failed.
+     */
+    void bulkLoad(std::uint64_t entryCount,
+            const std::function<void(std::uint8_t* entry)>& readEntry);
+
 private:
     /** Index file header */
     struct IndexFileHeader : public IndexFileHeaderBase {
         /** Initialized object of class Header */
         IndexFileHeader()
             : IndexFileHeaderBase(IndexType::kBPlusTreeIndex)
+            , m_rootNodeId(0)
+            , m_firstFreeNodeId(0)
         {
         }
 
@@ -175,12 +211,20 @@ private:
         /**
          * De-serializes this object from buffer.
          * @param buffer A buffer.
-         * @return Address after a last read byte.
+         * @return Address after a last read byte or nullptr if header is invalid.
          */
         const std::uint8_t* deserialize(const std::uint8_t* buffer) noexcept;
 
+        /** Root node ID */
+        std::uint64_t m_rootNodeId;
+
+        /** First node in the list of free nodes, zero if list is empty */
+        std::uint64_t m_firstFreeNodeId;
+
         /** Serialized size */
-        static constexpr std::size_t kSerializedSize = IndexFileHeaderBase::kSerializedSize;
+        static constexpr std::size_t kSerializedSize = IndexFileHeaderBase::kSerializedSize
+                                                       + sizeof(m_rootNodeId)
+                                                       + sizeof(m_firstFreeNodeId);
     };
 
     /** Node type */
@@ -189,6 +233,7 @@ private:
         kLeafNode,
         kRootInternalNode,
         kRootLeafNode,
+        kFreeNode,
         kMaxNodeType
     };
 
@@ -200,7 +245,7 @@ private:
         /** Node type */
         NodeType m_nodeType;
 
-        /** Number of child nodes in this root node */
+        /** Number of entries in this node */
         std::uint32_t m_childCount;
 
     protected:
@@ -246,7 +291,7 @@ private:
         static constexpr std::size_t kSerializedSize = CommonNodeHeader::kSerializedSize;
     };
 
-    /** Leaf node header */
+    /** Leaf node header. Also used by free nodes to link list of free nodes. */
     struct LeafNodeHeader : public CommonNodeHeader {
         /**
          * Serializes this object to buffer.
@@ -272,17 +317,19 @@ private:
                 CommonNodeHeader::kSerializedSize + sizeof(m_prevNodeId) + sizeof(m_nextNodeId);
     };
 
-    class NodeKeyValuePairIterator;
-
-    /** Tree node */
+    /**
+     * Tree node. Leaf node contains sorted (key, value) pairs. Internal node contains
+     * sorted (key, child node ID) pairs, where key is the lower bound of keys
+     * in the child subtree. Key of the first entry of internal node is not used
+     * for the search.
+     */
     struct Node {
         /**
          * Initializes object of class Node.
-         * @param owner Node owner.
          * @param nodeId Node ID.
          */
-        Node(const BPlusTreeIndex& owner, std::uint64_t nodeId) noexcept
-            : m_owner(owner)
+        explicit Node(std::uint64_t nodeId) noexcept
+            : m_version(0)
             , m_modified(false)
         {
             m_header.m_common.m_nodeId = nodeId;
@@ -298,6 +345,15 @@ private:
             return nodeId * Node::kSize;
         }
 
+        /**
+         * Returns node ID.
+         * @return Node ID.
+         */
+        std::uint64_t getId() const noexcept
+        {
+            return m_header.m_common.m_nodeId;
+        }
+
         /**
          * Returns indication that this node is leaf node.
          * @return true, if this is leaf node, false otherwise.
@@ -337,23 +393,91 @@ private:
         }
 
         /**
-         * Returns begin iterator.
-         * @return Begin iterator.
+         * Returns indication that this node is free node.
+         * @return true, if this is free node, false otherwise.
+         */
+        bool isFree() const noexcept
+        {
+            return m_header.m_common.m_nodeType == NodeType::kFreeNode;
+        }
+
+        /**
+         * Returns indication that node of a given type has leaf node header.
+         * @param nodeType A node type.
+         * @return true if node has leaf node header, false otherwise.
+         */
+        static constexpr bool hasLeafNodeHeader(NodeType nodeType) noexcept
+        {
+            return isLeafNodeType(nodeType) || nodeType == NodeType::kFreeNode;
+        }
+
+        /** Serializes node header into the node data. */
+        void serializeHeader() noexcept
+        {
+            if (hasLeafNodeHeader(m_header.m_common.m_nodeType))
+                m_header.m_leafNodeHeader.serialize(m_data);
+            else
+                m_header.m_internalNodeHeader.serialize(m_data);
+        }
+
+        /**
+         * Starts optimistic read of the node.
+         * @param[out] version Current node version.
+         * @return true if node can be read, false if it is locked or obsolete.
+         */
+        bool tryReadLock(std::uint64_t& version) const noexcept
+        {
+            version = m_version.load(std::memory_order_acquire);
+            return (version & (kLockedBit | kObsoleteBit)) == 0;
+        }
+
+        /**
+         * Checks that node wasn't changed since optimistic read was started.
+         * @param version Node version obtained when read was started.
+         * @return true if node is unchanged, false otherwise.
+         */
+        bool validate(std::uint64_t version) const noexcept
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return m_version.load(std::memory_order_relaxed) == version;
+        }
+
+        /**
+         * Returns indication that node is write-locked.
+         * @return true if node is write-locked, false otherwise.
+         */
+        bool isWriteLocked() const noexcept
+        {
+            return (m_version.load(std::memory_order_relaxed) & kLockedBit) != 0;
+        }
+
+        /**
+         * Write-locks node. Only one thread may modify index at a time,
+         * so no atomic read-modify-write is needed.
          */
-        NodeKeyValuePairIterator begin() noexcept;
+        void writeLock() noexcept
+        {
+            m_version.store(
+                    m_version.load(std::memory_order_relaxed) | kLockedBit,
+                    std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
 
         /**
-         * Returns end iterator.
-         * @return end iterator.
+         * Unlocks write-locked node and advances its version.
+         * @param obsolete Indication that node was removed from the tree.
          */
-        NodeKeyValuePairIterator end() noexcept;
+        void writeUnlock(bool obsolete) noexcept
+        {
+            const auto version = m_version.load(std::memory_order_relaxed);
+            m_version.store(((version & ~(kLockedBit | kObsoleteBit)) + kVersionIncrement)
+                                    | (obsolete ? kObsoleteBit : 0),
+                    std::memory_order_release);
+        }
 
         /** B+ tree node size */
         static constexpr std::size_t kSize = 8 * 1024;
 
-        /** Owner object */
-        const BPlusTreeIndex& m_owner;
-
         /** Node header */
         union {
             CommonNodeHeader m_common;
@@ -364,11 +488,23 @@ private:
         /** Node data */
         std::uint8_t m_data[kSize];
 
-        /** Modification flag */
-        bool m_modified;
+        /** Node version: bit 0 - obsolete flag, bit 1 - lock flag, bits 2-63 - counter */
+        std::atomic<std::uint64_t> m_version;
+
+        /** Modification flag: node has changes not written to disk yet */
+        std::atomic<bool> m_modified;
 
         /** Node type offset */
         static constexpr std::size_t kNodeTypeOffset = 0;
+
+        /** Obsolete node flag */
+        static constexpr std::uint64_t kObsoleteBit = 1;
+
+        /** Locked node flag */
+        static constexpr std::uint64_t kLockedBit = 2;
+
+        /** Version counter increment */
+        static constexpr std::uint64_t kVersionIncrement = 4;
     };
 
     /** Node shared pointer shortcut type */
@@ -382,8 +518,8 @@ private:
     public:
         /**
          * Initializes object of class NodeCache.
+         * @param owner Owner object.
          * @param capacity Cache capacity (maximum allowed size).
-         * @param fd Index file descriptor.
          */
         explicit NodeCache(const BPlusTreeIndex& owner, std::size_t capacity) noexcept
             : Base(capacity)
@@ -401,7 +537,8 @@ private:
 
     protected:
         /**
-         * Returns indication if item can be evicted. By default all items can be evicted.
+         * Returns indication if item can be evicted. Nodes which are in use
+         * by some thread or have unsaved changes can't be evicted.
          * @param key A key.
          * @param value A value.
          * @return true if item can be evicted, false otherwise.
@@ -429,348 +566,313 @@ private:
         const BPlusTreeIndex& m_owner;
     };
 
-    /**
-     * Lightweight object type returned by iterator dereference operator.
-     * Contains only actual data address.
-     */
-    struct NodeDataValue {
-        /** Address of a key-value pair in the node */
-        std::uint8_t* m_data;
-    };
+    /** Element of the path from root to leaf node */
+    struct PathElement {
+        /** Internal node */
+        NodePtr m_node;
 
-    /** Iterator for key-value pairs in the node */
-    class NodeKeyValuePairIterator {
-    public:
-        typedef NodeKeyValuePairIterator self_type;
-        typedef NodeDataValue value_type;
-        typedef NodeDataValue& reference;
-        typedef NodeDataValue* pointer;
-        typedef std::forward_iterator_tag iterator_category;
-        typedef std::ptrdiff_t difference_type;
-
-    public:
-        /**
-         * Initializes object of class NodeKeyValuePairIterator.
-         * @param node Node object.
-         * @param entryIndex Initial entry index.
-         */
-        explicit NodeKeyValuePairIterator(Node& node, std::size_t entryIndex = 0) noexcept
-            : m_node(&node)
-            , m_entryIndex(entryIndex)
-        {
-        }
-
-        /**
-         * Equality operator.
-         * @param other Other object.
-         * @return true if this object is equal to other, false otherwise.
-         */
-        bool operator==(const NodeKeyValuePairIterator& other) const noexcept
-        {
-            return m_node == other.m_node && m_entryIndex == other.m_entryIndex;
-        }
+        /** Position of the entry pointing to the next node in the path */
+        std::size_t m_childPosition;
+    };
 
-        /**
-         * Non-equality operator.
-         * @param other Other object.
-         * @return true if this object is not equal to other, false otherwise.
-         */
-        bool operator!=(const NodeKeyValuePairIterator& other) const noexcept
-        {
-            return m_node != other.m_node || m_entryIndex != other.m_entryIndex;
-        }
+    /** Path from root to leaf node, excluding leaf node */
+    using NodePath = std::vector<PathElement>;
+
+    /** Target of the leaf search */
+    enum class LeafSearchTarget {
+        /** Leaf which contains or must contain given key */
+        kKey,
+        /** Leftmost leaf */
+        kFirst,
+        /** Rightmost leaf */
+        kLast,
+    };
 
-        /**
-         * Prefix increment operator.
-         * @return This object.
-         * @throw std::out_of_range if move out of iteration range happened.
-         */
-        NodeKeyValuePairIterator& operator++()
-        {
-            if (m_entryIndex >= m_node->m_header.m_common.m_childCount) {
-                throw std::out_of_range("NodeKeyValuePairIterator increment is out of range");
-            }
-            ++m_entryIndex;
-            return *this;
-        }
+private:
+    /**
+     * Compares keys using key comparison function or bytewise, if there is no one.
+     * @param left Left key.
+     * @param right Right key.
+     * @return 0, if keys are equal, negative value if left < right,
+     *         positive value if left > right.
+     */
+    int compareKeys(const void* left, const void* right) const noexcept
+    {
+        return m_keyCompare ? m_keyCompare(left, right) : std::memcmp(left, right, m_keySize);
+    }
 
-        /**
-         * Postfix increment operator.
-         * @return Iterator object, pointing to a current element.
-         * @throw std::out_of_range if move out of iteration range happened.
-         */
-        NodeKeyValuePairIterator operator++(int)
-        {
-            if (m_entryIndex >= m_node->m_header.m_common.m_childCount) {
-                throw std::out_of_range("NodeKeyValuePairIterator increment is out of range");
-            }
-            return NodeKeyValuePairIterator(*m_node, m_entryIndex++);
-        }
+    /**
+     * Computes maximum number of entries in a node.
+     * @return Maximum number of entries in a node.
+     * @throw std::invalid_argument if key is too long.
+     */
+    std::size_t computeBranchingFactor() const;
 
-        /**
-         * Prefix decrement operator.
-         * @return This object.
-         * @throw std::out_of_range if move out of iteration range happened.
-         */
-        NodeKeyValuePairIterator& operator--()
-        {
-            if (m_entryIndex == 0) {
-                throw std::out_of_range("NodeKeyValuePairIterator decrement is out of range");
-            }
-            --m_entryIndex;
-            return *this;
-        }
+    /**
+     * Creates and initializes new index data file.
+     * @return Index file descriptor.
+     */
+    io::FilePtr createIndexFile() const;
 
-        /**
-         * Postfix decrement operator.
-         * @return Iterator object, pointing to a current element.
-         * @throw std::out_of_range if move out of iteration range happened.
-         */
-        NodeKeyValuePairIterator operator--(int)
-        {
-            if (m_entryIndex == 0) {
-                throw std::out_of_range("NodeKeyValuePairIterator decrement is out of range");
-            }
-            return NodeKeyValuePairIterator(*m_node, m_entryIndex--);
-        }
+    /**
+     * Opens existing index data file.
+     * @return Index file descriptor.
+     */
+    io::FilePtr openIndexFile() const;
 
-        /**
-         * Addition to this object operator.
-         * @param n Number of steps forward.
-         * @return This object.
-         * @throw std::out_of_range if move out of iteration range happened.
-         */
-        NodeKeyValuePairIterator& operator+=(difference_type n)
-        {
-            if (n < 0) return *this -= (-n);
-            if (m_node->m_header.m_common.m_childCount - m_entryIndex
-                    < static_cast<std::size_t>(n)) {
-                throw std::out_of_range("NodeKeyValuePairIterator step forward is out of range");
-            }
-            m_entryIndex += n;
-            return *this;
-        }
+    /**
+     * Calculates number of nodes in the index file.
+     * @return Number of nodes in the index file.
+     */
+    std::size_t calculateNodeCount() const;
 
-        /**
-         * Subtraction from this object operator.
-         * @param n Number of steps back.
-         * @return This object.
-         * @throw std::out_of_range if move out of iteration range happened.
-         */
-        NodeKeyValuePairIterator& operator-=(difference_type n)
-        {
-            if (n < 0) return *this += (-n);
-            if (m_entryIndex < static_cast<std::size_t>(n)) {
-                throw std::out_of_range("NodeKeyValuePairIterator step back is out of range");
-            }
-            m_entryIndex -= n;
-            return *this;
-        }
+    /** Reads index file header and validates root node. */
+    void readIndexFileHeader();
 
-        /**
-         * Addition operator.
-         * @param n Number of steps forward.
-         * @return Iterator object pointing N steps forward.
-         * @throw std::out_of_range if move out of iteration range happened.
-         */
-        NodeKeyValuePairIterator operator+(difference_type n) const
-        {
-            if (n < 0) return *this - (-n);
-            if (m_node->m_header.m_common.m_childCount - m_entryIndex
-                    < static_cast<std::size_t>(n)) {
-                throw std::out_of_range("NodeKeyValuePairIterator step forward is out of range");
-            }
-            return NodeKeyValuePairIterator(*m_node, m_entryIndex + n);
-        }
+    /**
+     * Writes index file header.
+     * @throw DatabaseError if write failed.
+     */
+    void writeIndexFileHeader();
 
-        /**
-         * Addition operator.
-         * @param n Number of steps forward.
-         * @return Iterator object pointing N steps forward.
-         * @throw std::out_of_range if move out of iteration range happened.
-         */
-        NodeKeyValuePairIterator operator-(difference_type n) const
-        {
-            if (n < 0) return *this + (-n);
-            if (m_entryIndex < static_cast<std::size_t>(n)) {
-                throw std::out_of_range("NodeKeyValuePairIterator step back is out of range");
-            }
-            return NodeKeyValuePairIterator(*m_node, m_entryIndex - n);
-        }
+    /**
+     * Finds leaf node for reading. Uses optimistic lock coupling.
+     * @param key A key, used only when target is LeafSearchTarget::kKey.
+     * @param target Search target.
+     * @param[out] version Version of the returned leaf node.
+     * @return Leaf node or nullptr if search must be restarted.
+     */
+    NodePtr findLeafForReading(const void* key, LeafSearchTarget target, std::uint64_t& version);
 
-        /**
-         * Dereference operator.
-         * @return Lightweight object, which contains pointer to actual data inside.
-         */
-        NodeDataValue operator*() const noexcept
-        {
-            return NodeDataValue {
-                    m_node->m_data + m_entryIndex * m_node->m_owner.m_internalKvPairSize};
-        }
+    /**
+     * Reads edge key of the neighbour leaf node. Skips empty leaf nodes.
+     * @param node Leaf node, which is being read.
+     * @param version Version of the leaf node.
+     * @param forward Indication that next leaf must be used, otherwise previous one.
+     * @param key Output key buffer. Receives first key of the next leaf node
+     *            or last key of the previous leaf node.
+     * @return true if key found, false if there is no neighbour, std::nullopt if search
+     *         must be restarted.
+     */
+    std::optional<bool> readNeighbourLeafKey(
+            NodePtr node, std::uint64_t version, bool forward, void* key);
 
-    private:
-        /** Underlying node object */
-        Node* m_node;
+    /**
+     * Reads first or last key of the index.
+     * @param last Indication that last key must be read.
+     * @param key Output key buffer.
+     * @return true if key found, false if index is empty.
+     */
+    bool readEdgeKey(bool last, void* key);
 
-        /** Current entry index */
-        std::size_t m_entryIndex;
-    };
+    /**
+     * Reads key adjacent to a given key.
+     * @param key A key.
+     * @param forward Indication that next key must be read, otherwise previous one.
+     * @param adjacentKey Output key buffer.
+     * @return true if key found, false otherwise.
+     */
+    bool readAdjacentKey(const void* key, bool forward, void* adjacentKey);
 
-    /** Comparison function for the binary search */
-    struct BinarySearchNodeDataCompareFunction {
-        /** Initializes object of class BinarySearchNodeDataCompareFunction */
-        explicit BinarySearchNodeDataCompareFunction(KeyCompareFunction cmp) noexcept
-            : m_cmp(cmp)
-        {
-        }
+    /**
+     * Finds leaf node for modification. Must be called with write mutex locked.
+     * @param key A key.
+     * @param[out] path Path from root to leaf.
+     * @return Leaf node.
+     */
+    NodePtr findLeafForModification(const void* key, NodePath& path);
 
-        /**
-         * Compares data from node and given key.
-         * @return true, if value is "less" than key, false otherwise.
-         */
-        bool operator()(const NodeDataValue& value, const void* key) const
-        {
-            return m_cmp(value.m_data, key);
-        }
+    /**
+     * Inserts new key or replaces value of existing key. Must be called
+     * with write mutex locked.
+     * @param key A key.
+     * @param value A value.
+     * @param replaceExisting flag that indicated if existing value to be replaced.
+     * @return true if key was a new one, false if key already existed.
+     */
+    bool doInsert(const void* key, const void* value, bool replaceExisting);
 
-        /**
-         * Compares data from node and given key.
-         * @return true, if key is "less" than value, false otherwise.
-         */
-        bool operator()(const void* key, const NodeDataValue& value) const
-        {
-            return m_cmp(key, value.m_data);
-        }
+    /**
+     * Removes key. Merges or rebalances nodes which become underfull.
+     * Must be called with write mutex locked.
+     * @param key A key.
+     * @return Number of removed entries.
+     */
+    std::uint64_t doErase(const void* key);
 
-        /** Key comparison function */
-        const KeyCompareFunction m_cmp;
-    };
+    /**
+     * Updates value of the existing key. Must be called with write mutex locked.
+     * @param key A key.
+     * @param value A value.
+     * @return Number of updated entries.
+     */
+    std::uint64_t doUpdate(const void* key, const void* value);
 
-private:
     /**
-     * Creates and initializes new index data file.
-     * @return Index file descriptor.
+     * Runs index modification with write mutex locked and saves changed nodes.
+     * Operation must not modify anything after it has thrown an exception.
+     * @param operation Operation.
+     * @return Operation result.
      */
-    io::FilePtr createIndexFile() const;
+    template<class Operation>
+    auto modify(Operation&& operation) -> decltype(operation());
 
     /**
-     * Opens existing index data file.
-     * @return Index file descriptor.
+     * Marks node as modified by the current operation and write-locks it.
+     * @param node Node object.
      */
-    io::FilePtr openIndexFile() const;
+    void markModified(const NodePtr& node) noexcept;
 
     /**
-     * Calculates number of nodes in the index file.
-     * @return Number of nodes in the index file.
+     * Unlocks nodes modified by the current operation and writes them to disk.
+     * @throw DatabaseError if write failed.
      */
-    std::size_t calculateNodeCount() const;
+    void saveModifiedNodes();
 
     /**
-     * Finds root node.
-     * @return Root node ID.
+     * Forgets nodes added to the index file by the failed operation.
+     * @param nodeCount Number of nodes before operation.
      */
-    std::size_t findRootNode();
+    void discardAllocatedNodes(std::uint64_t nodeCount) noexcept;
 
     /**
-     * Finds node that contains or must contain given key.
-     * @param key A key.
-     * @return Node object.
+     * Writes node data to disk.
+     * @param node Node object.
+     * @throw DatabaseError if write failed.
      */
-    NodePtr findNode(const void* key);
+    void writeNode(Node& node) const;
 
     /**
-     * Gets existing node object from the standard data file.
+     * Gets existing node object from cache or from disk.
      * @param nodeId Node ID.
      * @return Node object.
      */
-    NodePtr getNode(std::uint64_t nodeId)
-    {
-        return getNode(*m_file, nodeId);
-    }
+    NodePtr getNode(std::uint64_t nodeId);
 
     /**
-     * Gets existing node object from a given file.
-     * @param file File object.
+     * Reads existing node object from the index file.
+     * Must be called with cache mutex locked.
      * @param nodeId Node ID.
      * @return Node object.
      */
-    NodePtr getNode(io::File& file, std::uint64_t nodeId);
+    NodePtr readNode(std::uint64_t nodeId);
 
     /**
-     * Reads existing node object from the standard data file.
+     * Makes new node object after the last node in the index file.
+     * Node is written to disk with the rest of operation changes.
      * @param nodeId Node ID.
      * @return Node object.
      */
-    NodePtr readNode(std::uint64_t nodeId)
-    {
-        return readNode(*m_file, nodeId);
-    }
+    NodePtr makeNode(std::uint64_t nodeId);
 
     /**
-     * Reads existing node object from a given file.
-     * @param file File object.
-     * @param nodeId Node ID.
-     * @return Node object.
+     * Makes new node after the last node in the index file or obtains first available
+     * free node. Must be called with write mutex locked.
+     * @return New node object.
      */
-    NodePtr readNode(io::File& file, std::uint64_t nodeId);
+    NodePtr getNewNode();
 
     /**
-     * Makes new physical node in the standard data file and corresponding node object.
-     * @param nodeId Node ID.
-     * @return Node object.
+     * Moves node to the list of free nodes.
+     * @param node Node object.
      */
-    NodePtr makeNode(std::uint64_t nodeId)
-    {
-        return makeNode(*m_file, nodeId);
-    }
+    void freeNode(const NodePtr& node) noexcept;
 
     /**
-     * Makes new physical node in a given data file and corresponding node object.
-     * @param file File object.
-     * @param nodeId Node ID.
-     * @return Node object.
+     * Returns number of entries in the node, limited by the branching factor,
+     * so that reader never goes outside node data.
+     * @param node Node object.
+     * @return Number of entries.
      */
-    NodePtr makeNode(io::File& file, std::uint64_t nodeId);
+    std::size_t getEntryCount(const Node& node) const noexcept
+    {
+        return std::min<std::size_t>(node.m_header.m_common.m_childCount, m_branchingFactor);
+    }
 
     /**
-     * Makes new physical node in the standard data file or obtains first available free node.
-     * @return New node object.
+     * Returns entry size for a given node.
+     * @param node Node object.
+     * @return Entry size.
      */
-    NodePtr getNewNode()
+    std::size_t getEntrySize(const Node& node) const noexcept
     {
-        return getNewNode(*m_file);
+        return node.isLeaf() ? m_kvPairSize : m_internalKvPairSize;
     }
 
     /**
-     * Makes new physical node in a given data file or obtains first available free node.
-     * @param file File object.
-     * @return New node object.
+     * Returns address of the entry in the node.
+     * @param node Node object.
+     * @param index Entry index.
+     * @return Entry address.
      */
-    NodePtr getNewNode(io::File& file)
+    std::uint8_t* getEntry(Node& node, std::size_t index) const noexcept
     {
-        return (m_nextFreeNodeId > m_nodeCount) ? makeNode(file, m_nextFreeNodeId++)
-                                                : getNode(file, m_nextFreeNodeId);
+        return node.isLeaf()
+                       ? node.m_data + LeafNodeHeader::kSerializedSize + index * m_kvPairSize
+                       : node.m_data + InternalNodeHeader::kSerializedSize
+                                 + index * m_internalKvPairSize;
     }
 
     /**
-     * Inserts new key-value pair into the non-full leaf node.
+     * Returns child node ID from the internal node entry.
+     * @param node Internal node object.
+     * @param index Entry index.
+     * @return Child node ID.
+     */
+    std::uint64_t getChildNodeId(Node& node, std::size_t index) const noexcept;
+
+    /**
+     * Finds first entry with key not less than a given key.
      * @param node Node object.
-     * @param pos Position of the new record.
+     * @param count Number of entries.
      * @param key A key.
-     * @param value A value.
+     * @return Entry index.
      */
-    void insertNewEntryToNonFullLeafNode(
-            Node& node, std::uint32_t pos, const void* key, const void* value);
+    std::size_t findLowerBound(Node& node, std::size_t count, const void* key) const noexcept;
 
     /**
-     * Inserts new key-value pair into the full leaf node.
+     * Finds first entry with key greater than a given key.
      * @param node Node object.
-     * @param pos Position of the new record.
+     * @param count Number of entries.
      * @param key A key.
-     * @param value A value.
+     * @return Entry index.
+     */
+    std::size_t findUpperBound(Node& node, std::size_t count, const void* key) const noexcept;
+
+    /**
+     * Finds entry of internal node pointing to the subtree which contains
+     * or must contain a given key.
+     * @param node Internal node object.
+     * @param count Number of entries.
+     * @param key A key.
+     * @return Entry index.
+     */
+    std::size_t findChildPosition(Node& node, std::size_t count, const void* key) const noexcept;
+
+    /**
+     * Inserts entry into the non-full node.
+     * @param node Node object.
+     * @param pos Position of the new entry.
+     * @param entry Entry data.
      */
-    void insertNewEntryToFullLeafNode(
-            Node& node, std::uint32_t pos, const void* key, const void* value);
+    void insertEntry(Node& node, std::size_t pos, const std::uint8_t* entry) noexcept;
+
+    /**
+     * Removes entry from the node.
+     * @param node Node object.
+     * @param pos Entry position.
+     */
+    void removeEntry(Node& node, std::size_t pos) noexcept;
+
+    /**
+     * Inserts entry into the full node and moves upper half of entries
+     * into the new node.
+     * @param node Full node object.
+     * @param newNode New node object.
+     * @param pos Position of the new entry.
+     * @param entry Entry data.
+     */
+    void splitNode(Node& node, Node& newNode, std::size_t pos, const std::uint8_t* entry) noexcept;
 
 private:
     /** Data file size */
@@ -782,8 +884,8 @@ private:
     /** Maximum number of entries in the node */
     const std::size_t m_branchingFactor;
 
-    /** Node split threshold */
-    const std::size_t m_splitThreshold;
+    /** Minimum number of entries in the non-root node */
+    const std::size_t m_minEntryCount;
 
     /** Index file name */
     const std::string m_indexFilePath;
@@ -795,29 +897,40 @@ private:
     std::uint64_t m_nodeCount;
 
     /** Root node ID */
-    std::uint64_t m_rootNodeId;
+    std::atomic<std::uint64_t> m_rootNodeId;
 
-    /** Next free node ID */
-    std::uint64_t m_nextFreeNodeId;
+    /** First node in the list of free nodes */
+    std::uint64_t m_firstFreeNodeId;
+
+    /** Indication that index file header must be written */
+    bool m_indexFileHeaderModified;
+
+    /** Serializes modifications of the tree */
+    std::mutex m_writeMutex;
+
+    /** Synchronizes access to the node cache */
+    std::mutex m_cacheMutex;
 
     /** Node cache */
     NodeCache m_nodeCache;
 
-    /** Modified nodes (used during modification operations) */
-    std::unordered_set<Node*> m_modifiedNodes;
+    /** Nodes changed by the current modification operation */
+    std::vector<NodePtr> m_modifiedNodes;
+
+    /** Buffer for entry being inserted */
+    std::vector<std::uint8_t> m_entryBuffer;
+
+    /** Buffer for node split */
+    std::vector<std::uint8_t> m_splitBuffer;
 
     /** Node cache capacity */
-    static constexpr std::size_t kNodeCacheCapacity = 16;
-};
+    static constexpr std::size_t kNodeCacheCapacity = 256;
 
-inline BPlusTreeIndex::NodeKeyValuePairIterator BPlusTreeIndex::Node::begin() noexcept
-{
-    return NodeKeyValuePairIterator(*this);
-}
+    /** Minimum allowed branching factor */
+    static constexpr std::size_t kMinBranchingFactor = 4;
 
-inline BPlusTreeIndex::NodeKeyValuePairIterator BPlusTreeIndex::Node::end() noexcept
-{
-    return NodeKeyValuePairIterator(*this, m_header.m_common.m_childCount);
-}
+    /** Percentage of node capacity filled by bulk load */
+    static constexpr std::size_t kBulkLoadFillFactor = 90;
+};
 
 }  // namespace siodb::iomgr::dbengine
@@ -4,27 +4,18 @@
 
 #include "AesCipherContext.h"
 
-// Common project headers
-#include <siodb/common/utils/Debug.h>
-
 namespace siodb::iomgr::dbengine::crypto {
 
-////////// class AesEncryptionContext ////////////////////////////////////
-
-void AesEncryptionContext::transform(
-        const std::uint8_t* in, unsigned blockCount, std::uint8_t* out) const noexcept
-{
-    for (; blockCount > 0; --blockCount, in += m_blockSizeInBytes, out += m_blockSizeInBytes)
-        AES_encrypt(in, out, &m_preparedKey);
-}
-
-////////// class AesDecryptionContext ////////////////////////////////////
+////////// class AesCipherContext ////////////////////////////////////////
 
-void AesDecryptionContext::transform(
-        const std::uint8_t* in, unsigned blockCount, std::uint8_t* out) const noexcept
+const EVP_CIPHER* AesCipherContext::getEvpCipher(std::size_t keySize) noexcept
 {
-    for (; blockCount > 0; --blockCount, in += m_blockSizeInBytes, out += m_blockSizeInBytes)
-        AES_decrypt(in, out, &m_preparedKey);
+    switch (keySize) {
+        case 16: return ::EVP_aes_128_ecb();
+        case 24: return ::EVP_aes_192_ecb();
+        case 32: return ::EVP_aes_256_ecb();
+        default: return nullptr;
+    }
 }
 
 }  // namespace siodb::iomgr::dbengine::crypto
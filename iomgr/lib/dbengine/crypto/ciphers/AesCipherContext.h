@@ -5,76 +5,60 @@
 #pragma once
 
 // Project headers
-#include "CipherContext.h"
-
-// OpenSSL headers
-#include <openssl/aes.h>
+#include "EvpCipherContext.h"
 
 namespace siodb::iomgr::dbengine::crypto {
 
-/** Base class for all AES cipher contexts */
-class AesCipherContext : public CipherContext {
+/** Base class for all Aes cipher contexts */
+class AesCipherContext : public EvpCipherContext {
 protected:
     /**
      * Initializes object of class AesCipherContext.
      * @param cipher Cipher instance.
+     * @param key A key.
+     * @param encrypt Indication that context encrypts data.
+     * @throw std::runtime_error if key size is not supported.
      */
-    explicit AesCipherContext(ConstCipherPtr&& cipher) noexcept
-        : CipherContext(std::move(cipher))
+    AesCipherContext(ConstCipherPtr&& cipher, const BinaryValue& key, bool encrypt)
+        : EvpCipherContext(std::move(cipher), getEvpCipher(key.size()), key, encrypt)
     {
     }
 
-protected:
-    /** Prepared encryption or decryption key */
-    AES_KEY m_preparedKey;
+private:
+    /**
+     * Returns EVP cipher in ECB mode for the given key size.
+     * @param keySize Key size in bytes.
+     * @return EVP cipher or nullptr if key size is not supported.
+     */
+    static const EVP_CIPHER* getEvpCipher(std::size_t keySize) noexcept;
 };
 
-/** Encryption context for all AES ciphers */
-class AesEncryptionContext : public AesCipherContext {
+/** Encryption context for all Aes ciphers */
+class AesEncryptionContext final : public AesCipherContext {
 public:
     /**
      * Initializes instance of class AesEncryptionContext.
      * @param cipher Cipher instance.
      * @param key A key.
      */
-    explicit AesEncryptionContext(ConstCipherPtr&& cipher, const BinaryValue& key) noexcept
-        : AesCipherContext(std::move(cipher))
+    AesEncryptionContext(ConstCipherPtr&& cipher, const BinaryValue& key)
+        : AesCipherContext(std::move(cipher), key, true)
     {
-        AES_set_encrypt_key(key.data(), key.size() * 8, &m_preparedKey);
     }
-
-    /**
-     * Transforms (i.e. encrypts or decrypts) given number of blocks.
-     * @param in Input data.
-     * @param blockCount Number of data blocks to process.
-     * @param out Output buffer.
-     */
-    void transform(const std::uint8_t* in, unsigned blockCount, std::uint8_t* out) const
-            noexcept override final;
 };
 
-/** Decryption context for all AES ciphers */
-class AesDecryptionContext : public AesCipherContext {
+/** Decryption context for all Aes ciphers */
+class AesDecryptionContext final : public AesCipherContext {
 public:
     /**
      * Initializes instance of class AesDecryptionContext.
      * @param cipher Cipher instance.
      * @param key A key.
      */
-    explicit AesDecryptionContext(ConstCipherPtr&& cipher, const BinaryValue& key) noexcept
-        : AesCipherContext(std::move(cipher))
+    AesDecryptionContext(ConstCipherPtr&& cipher, const BinaryValue& key)
+        : AesCipherContext(std::move(cipher), key, false)
     {
-        AES_set_decrypt_key(key.data(), key.size() * 8, &m_preparedKey);
     }
-
-    /**
-     * Transforms (i.e. encrypts or decrypts) given number of blocks.
-     * @param in Input data.
-     * @param blockCount Number of data blocks to process.
-     * @param out Output buffer.
-     */
-    void transform(const std::uint8_t* in, unsigned blockCount, std::uint8_t* out) const
-            noexcept override final;
 };
 
 }  // namespace siodb::iomgr::dbengine::crypto
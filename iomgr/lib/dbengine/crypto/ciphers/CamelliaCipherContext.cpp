@@ -6,22 +6,16 @@
 
 namespace siodb::iomgr::dbengine::crypto {
 
-////////// class CamelliaEncryptionContext ////////////////////////////////////
+////////// class CamelliaCipherContext ////////////////////////////////////////
 
-void CamelliaEncryptionContext::transform(
-        const std::uint8_t* in, unsigned blockCount, std::uint8_t* out) const noexcept
+const EVP_CIPHER* CamelliaCipherContext::getEvpCipher(std::size_t keySize) noexcept
 {
-    for (; blockCount > 0; --blockCount, in += m_blockSizeInBytes, out += m_blockSizeInBytes)
-        Camellia_encrypt(in, out, &m_preparedKey);
-}
-
-////////// class CamelliaDecryptionContext ////////////////////////////////////
-
-void CamelliaDecryptionContext::transform(
-        const std::uint8_t* in, unsigned blockCount, std::uint8_t* out) const noexcept
-{
-    for (; blockCount > 0; --blockCount, in += m_blockSizeInBytes, out += m_blockSizeInBytes)
-        Camellia_decrypt(in, out, &m_preparedKey);
+    switch (keySize) {
+        case 16: return ::EVP_camellia_128_ecb();
+        case 24: return ::EVP_camellia_192_ecb();
+        case 32: return ::EVP_camellia_256_ecb();
+        default: return nullptr;
+    }
 }
 
 }  // namespace siodb::iomgr::dbengine::crypto
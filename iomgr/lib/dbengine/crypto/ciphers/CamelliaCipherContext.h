@@ -5,76 +5,60 @@
 #pragma once
 
 // Project headers
-#include "CipherContext.h"
-
-// OpenSSL headers
-#include <openssl/camellia.h>
+#include "EvpCipherContext.h"
 
 namespace siodb::iomgr::dbengine::crypto {
 
 /** Base class for all Camellia cipher contexts */
-class CamelliaCipherContext : public CipherContext {
+class CamelliaCipherContext : public EvpCipherContext {
 protected:
     /**
-     * Initializes instance of class CamelliaCipherContext.
+     * Initializes object of class CamelliaCipherContext.
      * @param cipher Cipher instance.
      * @param key A key.
+     * @param encrypt Indication that context encrypts data.
+     * @throw std::runtime_error if key size is not supported.
      */
-    explicit CamelliaCipherContext(ConstCipherPtr&& cipher, const BinaryValue& key) noexcept
-        : CipherContext(std::move(cipher))
+    CamelliaCipherContext(ConstCipherPtr&& cipher, const BinaryValue& key, bool encrypt)
+        : EvpCipherContext(std::move(cipher), getEvpCipher(key.size()), key, encrypt)
     {
-        Camellia_set_key(key.data(), key.size() * 8, &m_preparedKey);
     }
 
-protected:
-    /** Prepared encryption or decryption key */
-    CAMELLIA_KEY m_preparedKey;
+private:
+    /**
+     * Returns EVP cipher in ECB mode for the given key size.
+     * @param keySize Key size in bytes.
+     * @return EVP cipher or nullptr if key size is not supported.
+     */
+    static const EVP_CIPHER* getEvpCipher(std::size_t keySize) noexcept;
 };
 
 /** Encryption context for all Camellia ciphers */
-class CamelliaEncryptionContext : public CamelliaCipherContext {
+class CamelliaEncryptionContext final : public CamelliaCipherContext {
 public:
     /**
-     * Initializes instance of class AesEncryptionContext.
+     * Initializes instance of class CamelliaEncryptionContext.
      * @param cipher Cipher instance.
      * @param key A key.
      */
-    explicit CamelliaEncryptionContext(ConstCipherPtr&& cipher, const BinaryValue& key) noexcept
-        : CamelliaCipherContext(std::move(cipher), key)
+    CamelliaEncryptionContext(ConstCipherPtr&& cipher, const BinaryValue& key)
+        : CamelliaCipherContext(std::move(cipher), key, true)
     {
     }
-
-    /**
-     * Transforms (i.e. encrypts or decrypts) given number of blocks.
-     * @param in Input data.
-     * @param blockCount Number of data blocks to process.
-     * @param out Output buffer.
-     */
-    void transform(const std::uint8_t* in, unsigned blockCount, std::uint8_t* out) const
-            noexcept override final;
 };
 
 /** Decryption context for all Camellia ciphers */
-class CamelliaDecryptionContext : public CamelliaCipherContext {
+class CamelliaDecryptionContext final : public CamelliaCipherContext {
 public:
     /**
-     * Initializes instance of class AesDecryptionContext.
+     * Initializes instance of class CamelliaDecryptionContext.
      * @param cipher Cipher instance.
      * @param key A key.
      */
-    explicit CamelliaDecryptionContext(ConstCipherPtr&& cipher, const BinaryValue& key) noexcept
-        : CamelliaCipherContext(std::move(cipher), key)
+    CamelliaDecryptionContext(ConstCipherPtr&& cipher, const BinaryValue& key)
+        : CamelliaCipherContext(std::move(cipher), key, false)
     {
     }
-
-    /**
-     * Transforms (i.e. encrypts or decrypts) given number of blocks.
-     * @param in Input data.
-     * @param blockCount Number of data blocks to process.
-     * @param out Output buffer.
-     */
-    void transform(const std::uint8_t* in, unsigned blockCount, std::uint8_t* out) const
-            noexcept override final;
 };
 
 }  // namespace siodb::iomgr::dbengine::crypto
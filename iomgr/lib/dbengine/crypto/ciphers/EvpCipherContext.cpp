@@ -0,0 +1,83 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "EvpCipherContext.h"
+
+// STL headers
+#include <stdexcept>
+
+namespace siodb::iomgr::dbengine::crypto {
+
+EvpCipherContext::EvpCipherContext(ConstCipherPtr&& cipher, const EVP_CIPHER* evpCipher,
+        const BinaryValue& key, bool encrypt)
+    : CipherContext(std::move(cipher))
+    , m_prototype(::EVP_CIPHER_CTX_new())
+{
+    if (!m_prototype) throw std::bad_alloc();
+    if (!evpCipher
+            || ::EVP_CipherInit_ex(m_prototype, evpCipher, nullptr, key.data(), nullptr,
+                       encrypt ? 1 : 0)
+                       != 1
+            || ::EVP_CIPHER_CTX_set_padding(m_prototype, 0) != 1) {
+        ::EVP_CIPHER_CTX_free(m_prototype);
+        throw std::runtime_error("Can't initialize cipher context");
+    }
+}
+
+EvpCipherContext::~EvpCipherContext()
+{
+    for (auto ctx : m_contextPool)
+        ::EVP_CIPHER_CTX_free(ctx);
+    ::EVP_CIPHER_CTX_free(m_prototype);
+}
+
+void EvpCipherContext::transform(
+        const std::uint8_t* in, unsigned blockCount, std::uint8_t* out) const noexcept
+{
+    // Whole blocks without padding are transformed in a single update call,
+    // which never fails for the ECB mode once context is initialized.
+    const int size = static_cast<int>(blockCount * m_blockSizeInBytes);
+    int outSize = 0;
+    if (const auto ctx = acquireContext()) {
+        ::EVP_CipherUpdate(ctx, out, &outSize, in, size);
+        releaseContext(ctx);
+    } else {
+        // No memory for a context copy, use prototype exclusively
+        std::lock_guard lock(m_mutex);
+        ::EVP_CipherUpdate(m_prototype, out, &outSize, in, size);
+    }
+}
+
+// ----- internals -----
+
+EVP_CIPHER_CTX* EvpCipherContext::acquireContext() const noexcept
+{
+    {
+        std::lock_guard lock(m_mutex);
+        if (!m_contextPool.empty()) {
+            const auto ctx = m_contextPool.back();
+            m_contextPool.pop_back();
+            return ctx;
+        }
+    }
+
+    const auto ctx = ::EVP_CIPHER_CTX_new();
+    if (!ctx) return nullptr;
+    std::lock_guard lock(m_mutex);
+    if (::EVP_CIPHER_CTX_copy(ctx, m_prototype) == 1) return ctx;
+    ::EVP_CIPHER_CTX_free(ctx);
+    return nullptr;
+}
+
+void EvpCipherContext::releaseContext(EVP_CIPHER_CTX* ctx) const noexcept
+{
+    std::lock_guard lock(m_mutex);
+    try {
+        m_contextPool.push_back(ctx);
+    } catch (std::bad_alloc&) {
+        ::EVP_CIPHER_CTX_free(ctx);
+    }
+}
+
+}  // namespace siodb::iomgr::dbengine::crypto
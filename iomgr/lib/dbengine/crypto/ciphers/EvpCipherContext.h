@@ -0,0 +1,82 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "CipherContext.h"
+
+// Common project headers
+#include <siodb/common/utils/HelperMacros.h>
+
+// STL headers
+#include <mutex>
+#include <vector>
+
+// OpenSSL headers
+#include <openssl/evp.h>
+
+namespace siodb::iomgr::dbengine::crypto {
+
+/**
+ * Base class for cipher contexts implemented via OpenSSL EVP interface.
+ * Cipher is used in ECB mode without padding, so that ciphertext is the same as
+ * produced by the per-block low level functions, while EVP processes many blocks
+ * per call using hardware acceleration and pipelining where available.
+ * EVP context can't be used by multiple threads at once, so each transform
+ * borrows a copy of the initialized context from a pool.
+ */
+class EvpCipherContext : public CipherContext {
+protected:
+    /**
+     * Initializes object of class EvpCipherContext.
+     * @param cipher Cipher instance.
+     * @param evpCipher EVP cipher in ECB mode.
+     * @param key A key.
+     * @param encrypt Indication that context encrypts data.
+     * @throw std::runtime_error if EVP context can't be initialized.
+     */
+    EvpCipherContext(ConstCipherPtr&& cipher, const EVP_CIPHER* evpCipher,
+            const BinaryValue& key, bool encrypt);
+
+public:
+    /** De-initializes object of class EvpCipherContext */
+    ~EvpCipherContext() override;
+
+    DECLARE_NONCOPYABLE(EvpCipherContext);
+
+    /**
+     * Transforms (i.e. encrypts or decrypts) given number of blocks.
+     * @param in Input data.
+     * @param blockCount Number of data blocks to process.
+     * @param out Output buffer.
+     */
+    void transform(const std::uint8_t* in, unsigned blockCount, std::uint8_t* out) const
+            noexcept override final;
+
+private:
+    /**
+     * Takes EVP context from the pool or creates new one.
+     * @return EVP context or nullptr if there is no memory.
+     */
+    EVP_CIPHER_CTX* acquireContext() const noexcept;
+
+    /**
+     * Returns EVP context to the pool.
+     * @param ctx EVP context.
+     */
+    void releaseContext(EVP_CIPHER_CTX* ctx) const noexcept;
+
+private:
+    /** Initialized EVP context, which is copied for each concurrent user */
+    EVP_CIPHER_CTX* const m_prototype;
+
+    /** Synchronizes access to the pool and to the prototype */
+    mutable std::mutex m_mutex;
+
+    /** Pool of the idle EVP contexts */
+    mutable std::vector<EVP_CIPHER_CTX*> m_contextPool;
+};
+
+}  // namespace siodb::iomgr::dbengine::crypto
@@ -10,6 +10,7 @@
 #include "../DatabaseError.h"
 #include "../Index.h"
 #include "../ThrowDatabaseError.h"
+#include "../parser/expr/AggregateFunction.h"
 #include "../parser/expr/BinaryOperator.h"
 #include "../parser/expr/ConstantExpression.h"
 #include "../parser/expr/InOperator.h"
@@ -605,6 +606,16 @@ void RequestHandler::updateColumnsFromExpression(const std::vector<DataSetPtr>&
             expressions.push_back(&inOperator->getValue());
             for (const auto& variant : inOperator->getVariants())
                 expressions.push_back(variant.get());
+        } else if (requests::AggregateFunction::isAggregateFunctionType(expression->getType())) {
+            const auto aggregateFunction =
+                    dynamic_cast<const requests::AggregateFunction*>(expression);
+            if (aggregateFunction == nullptr) {
+                // Normally should never happen
+                throw std::runtime_error("AggregateFunction type cast failed");
+            }
+            // COUNT(*) has no argument
+            if (aggregateFunction->getArgument())
+                expressions.push_back(aggregateFunction->getArgument());
         }
     }
 }
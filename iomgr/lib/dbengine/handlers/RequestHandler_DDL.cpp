@@ -20,6 +20,9 @@
 #include <siodb/common/protobuf/ProtobufMessageIO.h>
 #include <siodb/common/protobuf/SiodbProtocolTag.h>
 
+// STL headers
+#include <unordered_set>
+
 namespace siodb::iomgr::dbengine {
 
 void RequestHandler::executeCreateDatabaseRequest(iomgr_protocol::DatabaseEngineResponse& response,
@@ -61,6 +64,7 @@ void RequestHandler::executeCreateDatabaseRequest(iomgr_protocol::DatabaseEngine
             cipher ? crypto::generateCipherKey(keyLength, cipherKeySeed) : BinaryValue();
     m_instance.createDatabase(request.m_database, cipherId, cipherKey, m_userId);
 
+    m_instance.commitWriteAheadLog();
     protobuf::writeMessage(
             protobuf::ProtocolMessageType::kDatabaseEngineResponse, response, m_connectionIo);
 }
@@ -90,10 +94,26 @@ void RequestHandler::executeCreateTableRequest(iomgr_protocol::DatabaseEngineRes
     for (const auto& column : request.m_columns)
         tableColumns.push_back(convertTableColumnDefinition(column));
 
+    auto compressionType = CompressionType::kNone;
+    if (request.m_compression) {
+        requests::EmptyContext emptyContext;
+        const auto compressionValue = request.m_compression->evaluate(emptyContext);
+        if (!compressionValue.isString())
+            throwDatabaseError(IOManagerMessageId::kErrorCompressionTypeIsNotString);
+        const auto compressionTypeOpt = getCompressionType(compressionValue.getString());
+        if (!compressionTypeOpt) {
+            throwDatabaseError(
+                    IOManagerMessageId::kErrorUnknownCompressionType, compressionValue.getString());
+        }
+        compressionType = *compressionTypeOpt;
+    }
+
     // NOTE: Duplicate columns and columns with invalid names
     // are checked inside the createUserTable().
-    db->createUserTable(request.m_table, TableType::kDisk, tableColumns, m_userId);
+    db->createUserTable(
+            request.m_table, TableType::kDisk, tableColumns, m_userId, compressionType);
 
+    m_instance.commitWriteAheadLog();
     protobuf::writeMessage(
             protobuf::ProtocolMessageType::kDatabaseEngineResponse, response, m_connectionIo);
 }
@@ -122,7 +142,7 @@ void RequestHandler::executeAddColumnRequest(iomgr_protocol::DatabaseEngineRespo
 }
 
 void RequestHandler::executeCreateIndexRequest(iomgr_protocol::DatabaseEngineResponse& response,
-        [[maybe_unused]] const requests::CreateIndexRequest& request)
+        const requests::CreateIndexRequest& request)
 {
     response.set_has_affected_row_count(false);
 
@@ -137,11 +157,51 @@ void RequestHandler::executeCreateIndexRequest(iomgr_protocol::DatabaseEngineRes
         throwDatabaseError(IOManagerMessageId::kErrorInvalidIndexName, request.m_index);
 
     if (request.m_columns.empty()) {
-        throwDatabaseError(IOManagerMessageId::kErrorInvalidIndexColumns, request.m_database,
-                request.m_table, request.m_index);
+        throwDatabaseError(IOManagerMessageId::kErrorInvalidIndexColumns, dbName, request.m_table,
+                request.m_index);
     }
 
-    sendNotImplementedYet(response);
+    const auto db = m_instance.getDatabaseChecked(dbName);
+    const auto table = db->getTableChecked(request.m_table);
+    if (table->isSystemTable()) {
+        throwDatabaseError(
+                IOManagerMessageId::kErrorCannotCreateIndexOnSystemTable, dbName, request.m_table);
+    }
+
+    if (db->isIndexExists(request.m_index)) {
+        if (!request.m_ifDoesntExist) {
+            throwDatabaseError(
+                    IOManagerMessageId::kErrorIndexAlreadyExists, dbName, request.m_index);
+        }
+        protobuf::writeMessage(
+                protobuf::ProtocolMessageType::kDatabaseEngineResponse, response, m_connectionIo);
+        return;
+    }
+
+    std::unordered_set<std::string> knownColumns;
+    IndexColumnSpecificationList indexColumns;
+    indexColumns.reserve(request.m_columns.size());
+    for (const auto& column : request.m_columns) {
+        if (!isValidDatabaseObjectName(column.m_name))
+            throwDatabaseError(IOManagerMessageId::kErrorInvalidColumnName, column.m_name);
+        if (!knownColumns.insert(column.m_name).second) {
+            throwDatabaseError(
+                    IOManagerMessageId::kErrorCreateIndexDuplicateColumnName, column.m_name);
+        }
+        const auto tableColumn = table->getColumnChecked(column.m_name);
+        if (tableColumn->isMasterColumn()) {
+            throwDatabaseError(IOManagerMessageId::kErrorCannotCreateIndexOnMasterColumn, dbName,
+                    request.m_table, column.m_name);
+        }
+        indexColumns.emplace_back(
+                tableColumn->getCurrentColumnDefinition(), column.m_sortDescending);
+    }
+
+    db->createIndex(*table, request.m_index, indexColumns, request.m_unique, m_userId);
+
+    m_instance.commitWriteAheadLog();
+    protobuf::writeMessage(
+            protobuf::ProtocolMessageType::kDatabaseEngineResponse, response, m_connectionIo);
 }
 
 void RequestHandler::executeDropDatabaseRequest(iomgr_protocol::DatabaseEngineResponse& response,
@@ -156,6 +216,7 @@ void RequestHandler::executeDropDatabaseRequest(iomgr_protocol::DatabaseEngineRe
 
     m_instance.dropDatabase(request.m_database, !request.m_ifExists, m_userId);
 
+    m_instance.commitWriteAheadLog();
     protobuf::writeMessage(
             protobuf::ProtocolMessageType::kDatabaseEngineResponse, response, m_connectionIo);
 }
@@ -16,6 +16,7 @@
 #include "../Variant.h"
 #include "../parser/DatabaseContext.h"
 #include "../parser/EmptyContext.h"
+#include "../parser/expr/CompiledExpression.h"
 
 // Common project headers
 #include <siodb/common/io/FileIO.h>
@@ -115,6 +116,11 @@ void RequestHandler::executeUpdateRequest(
     if (!errors.empty()) throw CompoundDatabaseError(std::move(errors));
 
     checkWhereExpression(request.m_where, dbContext);
+    if (request.m_where) tableDataSet->chooseAccessPath(*request.m_where, 0);
+    const auto compiledWhere = request.m_where
+                                       ? requests::CompiledExpression::compile(
+                                               *request.m_where, dbContext)
+                                       : nullptr;
 
     try {
         for (const auto& expr : request.m_values)
@@ -129,7 +135,8 @@ void RequestHandler::executeUpdateRequest(
         // Read all columns required for where
         if (request.m_where) {
             try {
-                const auto rowFits = request.m_where->evaluate(dbContext);
+                const auto rowFits = compiledWhere ? compiledWhere->evaluate(dbContext)
+                                                   : request.m_where->evaluate(dbContext);
                 if (!rowFits.getBool()) continue;
             } catch (const std::runtime_error& e) {
                 // Catch exception from WHERE expression evaluation
@@ -148,6 +155,7 @@ void RequestHandler::executeUpdateRequest(
         response.set_affected_row_count(++updatedRowCount);
     }
 
+    m_instance.commitWriteAheadLog();
     protobuf::writeMessage(
             protobuf::ProtocolMessageType::kDatabaseEngineResponse, response, m_connectionIo);
 }
@@ -182,13 +190,19 @@ void RequestHandler::executeDeleteRequest(
     if (!errors.empty()) throw CompoundDatabaseError(std::move(errors));
 
     checkWhereExpression(request.m_where, dbContext);
+    if (request.m_where) tableDataSet->chooseAccessPath(*request.m_where, 0);
+    const auto compiledWhere = request.m_where
+                                       ? requests::CompiledExpression::compile(
+                                               *request.m_where, dbContext)
+                                       : nullptr;
 
     std::uint64_t deletedRowCount = 0;
     for (tableDataSet->resetCursor(); tableDataSet->hasCurrentRow();
             tableDataSet->moveToNextRow()) {
         if (request.m_where) {
             try {
-                const auto rowFits = request.m_where->evaluate(dbContext);
+                const auto rowFits = compiledWhere ? compiledWhere->evaluate(dbContext)
+                                                   : request.m_where->evaluate(dbContext);
                 if (!rowFits.getBool()) continue;
             } catch (const std::runtime_error& ex) {
                 // Catch exception from WHERE expression evaluation
@@ -201,6 +215,7 @@ void RequestHandler::executeDeleteRequest(
         response.set_affected_row_count(++deletedRowCount);
     }
 
+    m_instance.commitWriteAheadLog();
     protobuf::writeMessage(
             protobuf::ProtocolMessageType::kDatabaseEngineResponse, response, m_connectionIo);
 }
@@ -314,6 +329,8 @@ void RequestHandler::executeInsertRequest(
         response.set_affected_row_count(++insertedRowCount);
     }
 
+    // Inserted rows must be durable before client is notified
+    m_instance.commitWriteAheadLog();
     protobuf::writeMessage(
             protobuf::ProtocolMessageType::kDatabaseEngineResponse, response, m_connectionIo);
 }
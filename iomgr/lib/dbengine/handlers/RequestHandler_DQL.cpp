@@ -10,14 +10,25 @@
 #include "../ColumnSet.h"
 #include "../Database.h"
 #include "../DatabaseObjectName.h"
+#include "../ExternalRowSorter.h"
+#include "../HashAggregation.h"
+#include "../HashJoin.h"
 #include "../Index.h"
+#include "../SortKey.h"
 #include "../Table.h"
 #include "../TableDataSet.h"
 #include "../ThrowDatabaseError.h"
 #include "../parser/DatabaseContext.h"
 #include "../parser/EmptyContext.h"
+#include "../parser/expr/AggregateFunction.h"
 #include "../parser/expr/AllColumnsExpression.h"
+#include "../parser/expr/BinaryOperator.h"
+#include "../parser/expr/CompiledExpression.h"
+#include "../parser/expr/ConstantExpression.h"
+#include "../parser/expr/InOperator.h"
 #include "../parser/expr/SingleColumnExpression.h"
+#include "../parser/expr/TernaryOperator.h"
+#include "../parser/expr/UnaryOperator.h"
 
 // Common project headers
 #include <siodb/common/log/Log.h>
@@ -26,6 +37,11 @@
 #include <siodb/common/utils/EmptyString.h>
 #include <siodb/common/utils/PlainBinaryEncoding.h>
 
+// STL headers
+#include <limits>
+#include <numeric>
+#include <optional>
+
 namespace siodb::iomgr::dbengine {
 
 namespace {
@@ -41,6 +57,197 @@ bool moveToNextRow(const std::vector<DataSetPtr>& tableDataSets)
     return tableDataSets.front()->hasCurrentRow();
 }
 
+/**
+ * Filters rows of the single data set by the WHERE condition in batches.
+ * Rows which surely don't match the condition are skipped without evaluating
+ * condition for each of them.
+ */
+class BatchRowFilter {
+public:
+    /**
+     * Initializes object of class BatchRowFilter.
+     * @param dataSet Data set, which cursor is already reset.
+     * @param where WHERE condition.
+     * @param context Evaluation context, containing only this data set.
+     */
+    BatchRowFilter(DataSet& dataSet, const requests::Expression& where,
+            requests::DatabaseContext& context) noexcept
+        : m_dataSet(dataSet)
+        , m_where(where)
+        , m_context(context)
+        , m_batchRowCount(0)
+        , m_batchPos(0)
+        , m_selectionPos(0)
+        , m_exact(false)
+    {
+    }
+
+    /**
+     * Moves data set to the first row, starting from the current one, which may match
+     * the condition.
+     * @return true if such row exists, false otherwise.
+     */
+    bool moveToSelectedRow()
+    {
+        while (m_dataSet.hasCurrentRow()) {
+            if (m_batchPos == m_batchRowCount) startBatch();
+            while (m_selectionPos < m_selection.size() && m_selection[m_selectionPos] < m_batchPos)
+                ++m_selectionPos;
+            const std::size_t selectedPos = (m_selectionPos < m_selection.size())
+                                                    ? m_selection[m_selectionPos]
+                                                    : m_batchRowCount;
+            // Moving within the batch doesn't read rows, moving past it starts the next batch
+            while (m_batchPos < selectedPos) {
+                ++m_batchPos;
+                if (!m_dataSet.moveToNextRow()) return false;
+            }
+            if (m_batchPos < m_batchRowCount) return true;
+        }
+        return false;
+    }
+
+    /**
+     * Returns indication that the current row surely matches the condition.
+     * @return true if current row matches the condition, false if the condition must be
+     *         evaluated for it.
+     */
+    bool isCurrentRowMatching() const noexcept
+    {
+        return m_exact;
+    }
+
+    /**
+     * Moves data set to the next row.
+     * @return true if row data available for reading, false otherwise.
+     */
+    bool moveToNextRow()
+    {
+        ++m_batchPos;
+        return m_dataSet.moveToNextRow();
+    }
+
+private:
+    /** Evaluates the condition for the batch starting at the current row */
+    void startBatch()
+    {
+        m_batchRowCount = m_dataSet.getBatchRowCount();
+        m_batchPos = 0;
+        m_selection.resize(m_batchRowCount);
+        std::iota(m_selection.begin(), m_selection.end(), 0);
+        m_selectionPos = 0;
+        m_exact = m_where.evaluateBatch(m_context, m_selection);
+    }
+
+private:
+    /** Data set */
+    DataSet& m_dataSet;
+
+    /** WHERE condition */
+    const requests::Expression& m_where;
+
+    /** Evaluation context */
+    requests::DatabaseContext& m_context;
+
+    /** Number of rows in the current batch */
+    std::size_t m_batchRowCount;
+
+    /** Position of the current row in the batch */
+    std::size_t m_batchPos;
+
+    /** Selected rows of the current batch */
+    requests::Expression::SelectionVector m_selection;
+
+    /** Position of the first selection entry which is not passed yet */
+    std::size_t m_selectionPos;
+
+    /** Indication that selected rows surely match the condition */
+    bool m_exact;
+};
+
+/** ORDER BY term resolved against the SELECT result */
+struct OrderByTerm {
+    /** Term expression */
+    const requests::Expression* m_expression = nullptr;
+
+    /** Index of the result value, if term refers to the result column */
+    std::optional<std::size_t> m_valueIndex;
+
+    /** Compiled term expression, if term is evaluated for each row */
+    std::unique_ptr<requests::CompiledExpression> m_compiledExpression;
+
+    /** Indication of the descending sort order */
+    bool m_sortDescending = false;
+};
+
+/** GROUP BY term resolved against the SELECT result */
+struct GroupByTerm {
+    /** Term expression, or result expression which term refers to */
+    const requests::Expression* m_expression = nullptr;
+
+    /** Compiled term expression */
+    std::unique_ptr<requests::CompiledExpression> m_compiledExpression;
+};
+
+/**
+ * Collects aggregate functions used in the expression.
+ * @param expression Expression.
+ * @param[out] functions Aggregate functions.
+ * @throw std::runtime_error if aggregate function is used in the argument of another one.
+ */
+void collectAggregateFunctions(const requests::Expression& expression,
+        std::vector<const requests::AggregateFunction*>& functions)
+{
+    std::vector<std::pair<const requests::Expression*, bool>> expressions;
+    expressions.emplace_back(&expression, false);
+    while (!expressions.empty()) {
+        const auto [expression, insideAggregate] = expressions.back();
+        expressions.pop_back();
+        if (requests::AggregateFunction::isAggregateFunctionType(expression->getType())) {
+            if (insideAggregate)
+                throw std::runtime_error("Aggregate functions can't be nested");
+            const auto& aggregateFunction =
+                    dynamic_cast<const requests::AggregateFunction&>(*expression);
+            functions.push_back(&aggregateFunction);
+            if (aggregateFunction.getArgument())
+                expressions.emplace_back(aggregateFunction.getArgument(), true);
+        } else if (expression->isUnaryOperator()) {
+            const auto& op = dynamic_cast<const requests::UnaryOperator&>(*expression);
+            expressions.emplace_back(&op.getOperand(), insideAggregate);
+        } else if (expression->isBinaryOperator()) {
+            const auto& op = dynamic_cast<const requests::BinaryOperator&>(*expression);
+            expressions.emplace_back(&op.getLeftOperand(), insideAggregate);
+            expressions.emplace_back(&op.getRightOperand(), insideAggregate);
+        } else if (expression->isTernaryOperator()) {
+            const auto& op = dynamic_cast<const requests::TernaryOperator&>(*expression);
+            expressions.emplace_back(&op.getLeftOperand(), insideAggregate);
+            expressions.emplace_back(&op.getMiddleOperand(), insideAggregate);
+            expressions.emplace_back(&op.getRightOperand(), insideAggregate);
+        } else if (expression->getType() == requests::ExpressionType::kInPredicate) {
+            const auto& op = dynamic_cast<const requests::InOperator&>(*expression);
+            expressions.emplace_back(&op.getValue(), insideAggregate);
+            for (const auto& variant : op.getVariants())
+                expressions.emplace_back(variant.get(), insideAggregate);
+        }
+    }
+}
+
+/**
+ * Returns indication that expression uses aggregate functions.
+ * @param expression Expression.
+ * @return true if expression uses aggregate functions, false otherwise.
+ */
+bool hasAggregateFunctions(const requests::Expression& expression)
+{
+    std::vector<const requests::AggregateFunction*> functions;
+    try {
+        collectAggregateFunctions(expression, functions);
+    } catch (std::runtime_error&) {
+        // Only nested aggregate functions are rejected
+        return true;
+    }
+    return !functions.empty();
+}
+
 }  // namespace
 
 void RequestHandler::executeSelectRequest(
@@ -232,6 +439,110 @@ void RequestHandler::executeSelectRequest(
         }
     }
 
+    // ORDER BY and GROUP BY terms refer to the result column by position or alias,
+    // otherwise they are evaluated for each row
+    std::unordered_map<std::string, std::size_t> resultAliasValueIndices;
+    // Result expression of each result value, nullptr for values of all columns of the table
+    std::vector<const requests::Expression*> resultValueExpressions;
+    if (!request.m_orderBy.empty() || !request.m_groupBy.empty()) {
+        resultValueExpressions.reserve(columnCountToSend);
+        for (const auto& resultExpr : request.m_resultExpressions) {
+            if (resultExpr.m_expression->getType()
+                    == requests::ExpressionType::kAllColumnsReference) {
+                const auto& allColumnsExpression =
+                        dynamic_cast<const requests::AllColumnsExpression&>(
+                                *resultExpr.m_expression);
+                const auto tableIndex = *allColumnsExpression.getDatasetTableIndex();
+                resultValueExpressions.resize(
+                        resultValueExpressions.size() + tableColumnRecordLists[tableIndex].size(),
+                        nullptr);
+            } else {
+                if (!resultExpr.m_alias.empty()) {
+                    resultAliasValueIndices.emplace(
+                            resultExpr.m_alias, resultValueExpressions.size());
+                }
+                resultValueExpressions.push_back(resultExpr.m_expression.get());
+            }
+        }
+    }
+
+    const auto findResultAlias =
+            [&resultAliasValueIndices](
+                    const requests::Expression& expression) -> std::optional<std::size_t> {
+        if (expression.getType() != requests::ExpressionType::kSingleColumnReference)
+            return std::nullopt;
+        const auto& columnExpression =
+                dynamic_cast<const requests::SingleColumnExpression&>(expression);
+        if (!columnExpression.getTableName().empty()) return std::nullopt;
+        const auto it = resultAliasValueIndices.find(columnExpression.getColumnName());
+        if (it == resultAliasValueIndices.end()) return std::nullopt;
+        return it->second;
+    };
+
+    std::vector<OrderByTerm> orderByTerms;
+    orderByTerms.reserve(request.m_orderBy.size());
+    for (const auto& orderByExpr : request.m_orderBy) {
+        auto& term = orderByTerms.emplace_back();
+        term.m_expression = orderByExpr.m_subject.get();
+        term.m_sortDescending = orderByExpr.m_sortDescending;
+        if (orderByExpr.m_subject->getType() == requests::ExpressionType::kConstant) {
+            const auto& position =
+                    dynamic_cast<const requests::ConstantExpression&>(*orderByExpr.m_subject)
+                            .getValue();
+            if (position.isInteger()) {
+                if (position.isNegative() || position.asUInt64() == 0
+                        || position.asUInt64() > columnCountToSend) {
+                    errors.push_back(
+                            makeDatabaseError(IOManagerMessageId::kErrorOrderByPositionOutOfRange,
+                                    *position.asString(), columnCountToSend));
+                } else
+                    term.m_valueIndex = position.asUInt64() - 1;
+                continue;
+            }
+        } else {
+            term.m_valueIndex = findResultAlias(*orderByExpr.m_subject);
+            if (term.m_valueIndex) continue;
+        }
+        updateColumnsFromExpression(dataSets, orderByExpr.m_subject, errors);
+    }
+
+    // GROUP BY term which refers to the result column is replaced with its expression
+    std::vector<GroupByTerm> groupByTerms;
+    groupByTerms.reserve(request.m_groupBy.size());
+    for (const auto& groupByExpr : request.m_groupBy) {
+        auto& term = groupByTerms.emplace_back();
+        term.m_expression = groupByExpr.get();
+        std::optional<std::size_t> valueIndex;
+        if (groupByExpr->getType() == requests::ExpressionType::kConstant) {
+            const auto& position =
+                    dynamic_cast<const requests::ConstantExpression&>(*groupByExpr).getValue();
+            if (position.isInteger()) {
+                if (position.isNegative() || position.asUInt64() == 0
+                        || position.asUInt64() > resultValueExpressions.size()) {
+                    errors.push_back(
+                            makeDatabaseError(IOManagerMessageId::kErrorInvalidGroupByExpression,
+                                    "Position " + *position.asString() + " is out of range"));
+                    continue;
+                }
+                valueIndex = position.asUInt64() - 1;
+            }
+        } else
+            valueIndex = findResultAlias(*groupByExpr);
+        if (valueIndex) {
+            term.m_expression = resultValueExpressions[*valueIndex];
+            if (!term.m_expression) {
+                errors.push_back(
+                        makeDatabaseError(IOManagerMessageId::kErrorInvalidGroupByExpression,
+                                "Position " + std::to_string(*valueIndex + 1)
+                                        + " refers to all columns of the table"));
+            }
+            continue;
+        }
+        updateColumnsFromExpression(dataSets, groupByExpr, errors);
+    }
+
+    if (request.m_having) updateColumnsFromExpression(dataSets, request.m_having, errors);
+
     // Add remaining columns used in the WHERE clause
     if (request.m_where != nullptr) updateColumnsFromExpression(dataSets, request.m_where, errors);
     if (!errors.empty()) throw CompoundDatabaseError(std::move(errors));
@@ -239,11 +550,115 @@ void RequestHandler::executeSelectRequest(
     utils::Bitmask nullMask;
     if (!notNull) nullMask.resize(columnCountToSend, false);
 
+    if (request.m_where) {
+        for (std::size_t i = 0; i < dataSets.size(); ++i) {
+            const auto tableDataSet = dynamic_cast<TableDataSet*>(dataSets[i].get());
+            if (tableDataSet) tableDataSet->chooseAccessPath(*request.m_where, i);
+        }
+    }
+
     for (auto& tableDataSet : dataSets)
         tableDataSet->resetCursor();
 
+    // WHERE condition is evaluated for each row before grouping
+    if (request.m_where && hasAggregateFunctions(*request.m_where)) {
+        throwDatabaseError(IOManagerMessageId::kErrorInvalidWhereCondition,
+                "Aggregate functions are not allowed in WHERE");
+    }
     checkWhereExpression(request.m_where, *dbContext);
 
+    // Aggregate functions are computed for each group of rows, all rows form a single group
+    // if GROUP BY is not present
+    std::vector<const requests::AggregateFunction*> aggregateFunctions;
+    try {
+        std::vector<const requests::AggregateFunction*> functions;
+        for (const auto& resultExpr : request.m_resultExpressions)
+            collectAggregateFunctions(*resultExpr.m_expression, functions);
+        if (request.m_having) collectAggregateFunctions(*request.m_having, functions);
+        for (const auto& term : orderByTerms) {
+            if (!term.m_valueIndex) collectAggregateFunctions(*term.m_expression, functions);
+        }
+        // Same aggregate function used several times is computed once
+        for (const auto function : functions) {
+            const auto it = std::find_if(aggregateFunctions.cbegin(), aggregateFunctions.cend(),
+                    [function](const auto other) noexcept { return *other == *function; });
+            const auto aggregateIndex = it - aggregateFunctions.cbegin();
+            stdext::as_mutable_ptr(function)->setAggregateIndex(aggregateIndex);
+            if (it == aggregateFunctions.cend()) aggregateFunctions.push_back(function);
+        }
+    } catch (std::runtime_error& e) {
+        throwDatabaseError(IOManagerMessageId::kErrorInvalidAggregateFunction, e.what());
+    }
+    const bool hasAggregation =
+            !groupByTerms.empty() || request.m_having || !aggregateFunctions.empty();
+
+    std::vector<std::unique_ptr<requests::CompiledExpression>> compiledAggregateArguments;
+    compiledAggregateArguments.reserve(aggregateFunctions.size());
+    for (const auto function : aggregateFunctions) {
+        try {
+            function->validate(*dbContext);
+        } catch (std::exception& e) {
+            throwDatabaseError(IOManagerMessageId::kErrorInvalidAggregateFunction, e.what());
+        }
+        const auto argument = function->getArgument();
+        compiledAggregateArguments.push_back(
+                argument ? requests::CompiledExpression::compile(*argument, *dbContext)
+                         : nullptr);
+    }
+
+    for (auto& term : groupByTerms) {
+        try {
+            if (hasAggregateFunctions(*term.m_expression))
+                throw std::runtime_error("Aggregate functions are not allowed in GROUP BY");
+            term.m_expression->validate(*dbContext);
+        } catch (std::exception& e) {
+            throwDatabaseError(IOManagerMessageId::kErrorInvalidGroupByExpression, e.what());
+        }
+        term.m_compiledExpression =
+                requests::CompiledExpression::compile(*term.m_expression, *dbContext);
+    }
+
+    std::unique_ptr<requests::CompiledExpression> compiledHaving;
+    if (request.m_having) {
+        try {
+            request.m_having->validate(*dbContext);
+        } catch (std::exception& e) {
+            throwDatabaseError(IOManagerMessageId::kErrorInvalidHavingCondition, e.what());
+        }
+        if (!isBoolType(request.m_having->getResultValueType(*dbContext))) {
+            throwDatabaseError(IOManagerMessageId::kErrorInvalidHavingCondition,
+                    "Result is not boolean value");
+        }
+        compiledHaving = requests::CompiledExpression::compile(*request.m_having, *dbContext);
+    }
+
+    // Expressions evaluated for each row are compiled once
+    std::unique_ptr<requests::CompiledExpression> compiledWhere;
+    if (request.m_where)
+        compiledWhere = requests::CompiledExpression::compile(*request.m_where, *dbContext);
+    std::vector<std::unique_ptr<requests::CompiledExpression>> compiledResultExpressions;
+    compiledResultExpressions.reserve(request.m_resultExpressions.size());
+    for (const auto& resultExpr : request.m_resultExpressions) {
+        const auto exprType = resultExpr.m_expression->getType();
+        if (exprType == requests::ExpressionType::kAllColumnsReference
+                || exprType == requests::ExpressionType::kSingleColumnReference)
+            compiledResultExpressions.emplace_back();
+        else {
+            compiledResultExpressions.push_back(requests::CompiledExpression::compile(
+                    *resultExpr.m_expression, *dbContext));
+        }
+    }
+    for (auto& term : orderByTerms) {
+        if (term.m_valueIndex) continue;
+        try {
+            term.m_expression->validate(*dbContext);
+        } catch (std::exception& e) {
+            throwDatabaseError(IOManagerMessageId::kErrorInvalidOrderByExpression, e.what());
+        }
+        term.m_compiledExpression =
+                requests::CompiledExpression::compile(*term.m_expression, *dbContext);
+    }
+
     std::optional<std::uint64_t> limit;
     std::optional<std::uint64_t> offset;
 
@@ -280,26 +695,143 @@ void RequestHandler::executeSelectRequest(
 
     google::protobuf::io::CodedOutputStream codedOutput(&rawOutput);
     try {
+        // Rows of multiple data sets are joined by hash if they must have equal columns
+        std::unique_ptr<HashJoin> hashJoin;
+        if (request.m_where) {
+            hashJoin = HashJoin::create(
+                    *dbContext, *request.m_where, *db, m_instance.getJoinMemory());
+        }
+
+        // Rows are grouped by hash, aggregate functions are computed for each group
+        std::unique_ptr<HashAggregation> aggregation;
+        std::vector<std::uint8_t> groupKey;
+        std::vector<Variant> aggregateArguments(aggregateFunctions.size());
+        if (hasAggregation) {
+            aggregation = std::make_unique<HashAggregation>(*dbContext,
+                    std::vector<const requests::AggregateFunction*>(aggregateFunctions),
+                    !groupByTerms.empty(), *db, m_instance.getAggregationMemory());
+        }
+
         bool rowDataAvailable = true;
-        for (auto& tableDataSet : dataSets) {
-            rowDataAvailable &= tableDataSet->hasCurrentRow();
-            if (!rowDataAvailable) break;
+        if (hashJoin)
+            rowDataAvailable = hashJoin->moveToFirstRow();
+        else {
+            for (auto& tableDataSet : dataSets) {
+                rowDataAvailable &= tableDataSet->hasCurrentRow();
+                if (!rowDataAvailable) break;
+            }
         }
         std::vector<Variant> values(columnCountToSend);
 
+        // Rows of the single data set are filtered in batches
+        std::optional<BatchRowFilter> batchFilter;
+        if (request.m_where && dataSets.size() == 1)
+            batchFilter.emplace(*dataSets.front(), *request.m_where, *dbContext);
+        const auto moveToNextRowChecked = [&batchFilter, &hashJoin, &dataSets]() {
+            if (batchFilter) return batchFilter->moveToNextRow();
+            return hashJoin ? hashJoin->moveToNextRow() : moveToNextRow(dataSets);
+        };
+
+        const auto writeRow = [&]() {
+            std::size_t rowSize = nullMask.getByteSize();
+            for (std::size_t i = 0; i < columnCountToSend; ++i) {
+                const auto valueSize = getVariantSize(values[i]);
+                rowSize += valueSize;
+                if (!notNull) nullMask.setBit(i, valueSize == 0);
+            }
+
+            codedOutput.WriteVarint64(rowSize);
+            protobuf::checkOutputStreamError(rawOutput);
+
+            if (!notNull) {
+                codedOutput.WriteRaw(nullMask.getData(), nullMask.getByteSize());
+                protobuf::checkOutputStreamError(rawOutput);
+            }
+
+            for (std::size_t i = 0; i < columnCountToSend; ++i) {
+                writeVariant(codedOutput, values[i]);
+                protobuf::checkOutputStreamError(rawOutput);
+            }
+        };
+
+        // Rows are sorted before sending if ORDER BY is present. Only first rows
+        // are kept if LIMIT is present.
+        std::unique_ptr<ExternalRowSorter> sorter;
+        std::vector<std::uint8_t> sortKey;
+        if (!orderByTerms.empty()) {
+            std::optional<std::uint64_t> maxRowCount;
+            if (limit) {
+                maxRowCount = *limit
+                              + std::min(offset.value_or(0),
+                                      std::numeric_limits<std::uint64_t>::max() - *limit);
+            }
+            sorter = std::make_unique<ExternalRowSorter>(
+                    *db, db->getDataDir(), m_instance.getSortMemory(), maxRowCount);
+        }
+
+        const auto evaluateValues = [&]() {
+            std::size_t valueIdx = 0;
+            for (std::size_t i = 0; i < request.m_resultExpressions.size(); ++i) {
+                const auto& expr = request.m_resultExpressions[i];
+                const auto exprType = expr.m_expression->getType();
+                if (exprType == requests::ExpressionType::kAllColumnsReference) {
+                    const auto allColumnsExpression =
+                            dynamic_cast<const requests::AllColumnsExpression*>(
+                                    expr.m_expression.get());
+                    const auto tableIdx = *allColumnsExpression->getDatasetTableIndex();
+                    for (const auto& rowValue : dataSets[tableIdx]->getCurrentRow())
+                        values[valueIdx++] = rowValue;
+                } else {
+                    const auto& compiledExpr = compiledResultExpressions[i];
+                    values[valueIdx++] = compiledExpr ? compiledExpr->evaluate(*dbContext)
+                                                      : expr.m_expression->evaluate(*dbContext);
+                }
+            }
+        };
+
+        const auto addSortedRow = [&]() {
+            sortKey.clear();
+            try {
+                for (const auto& term : orderByTerms) {
+                    if (term.m_valueIndex)
+                        appendSortKey(values[*term.m_valueIndex], term.m_sortDescending, sortKey);
+                    else {
+                        const auto value = term.m_compiledExpression
+                                                   ? term.m_compiledExpression->evaluate(*dbContext)
+                                                   : term.m_expression->evaluate(*dbContext);
+                        appendSortKey(value, term.m_sortDescending, sortKey);
+                    }
+                }
+            } catch (const std::runtime_error& e) {
+                throwDatabaseError(IOManagerMessageId::kErrorInvalidOrderByExpression, e.what());
+            } catch (const VariantLogicError& error) {
+                throwDatabaseError(
+                        IOManagerMessageId::kErrorInvalidOrderByExpression, error.what());
+            }
+            sorter->addRow(sortKey, values);
+        };
+
         while (rowDataAvailable && (!limit.has_value() || *limit > 0)) {
-            std::size_t rowSize = 0;
             if (request.m_where) {
                 try {
                     if (isNullType(request.m_where->getResultValueType(*dbContext))) {
-                        rowDataAvailable = moveToNextRow(dataSets);
+                        rowDataAvailable = moveToNextRowChecked();
                         continue;
                     }
 
-                    const auto rowFits = request.m_where->evaluate(*dbContext);
-                    if (!rowFits.getBool()) {
-                        rowDataAvailable = moveToNextRow(dataSets);
-                        continue;
+                    if (batchFilter && !batchFilter->moveToSelectedRow()) {
+                        rowDataAvailable = false;
+                        break;
+                    }
+
+                    if (!batchFilter || !batchFilter->isCurrentRowMatching()) {
+                        const auto rowFits = compiledWhere
+                                                     ? compiledWhere->evaluate(*dbContext)
+                                                     : request.m_where->evaluate(*dbContext);
+                        if (!rowFits.getBool()) {
+                            rowDataAvailable = moveToNextRowChecked();
+                            continue;
+                        }
                     }
                 } catch (const std::runtime_error& e) {
                     // Catch exception from WHERE expression evaluation
@@ -310,53 +842,113 @@ void RequestHandler::executeSelectRequest(
                 }
             }
 
-            if (offset && *offset > 0) {
+            if (aggregation) {
+                groupKey.clear();
+                try {
+                    for (const auto& term : groupByTerms) {
+                        const auto value = term.m_compiledExpression
+                                                   ? term.m_compiledExpression->evaluate(*dbContext)
+                                                   : term.m_expression->evaluate(*dbContext);
+                        appendSortKey(value, false, groupKey);
+                    }
+                } catch (const std::runtime_error& e) {
+                    throwDatabaseError(
+                            IOManagerMessageId::kErrorInvalidGroupByExpression, e.what());
+                } catch (const VariantLogicError& error) {
+                    throwDatabaseError(
+                            IOManagerMessageId::kErrorInvalidGroupByExpression, error.what());
+                }
+                try {
+                    for (std::size_t i = 0; i < aggregateFunctions.size(); ++i) {
+                        const auto argument = aggregateFunctions[i]->getArgument();
+                        // COUNT(*) has no argument
+                        if (!argument) continue;
+                        const auto& compiledArgument = compiledAggregateArguments[i];
+                        aggregateArguments[i] = compiledArgument
+                                                        ? compiledArgument->evaluate(*dbContext)
+                                                        : argument->evaluate(*dbContext);
+                    }
+                } catch (const std::runtime_error& e) {
+                    throwDatabaseError(
+                            IOManagerMessageId::kErrorInvalidAggregateFunction, e.what());
+                } catch (const VariantLogicError& error) {
+                    throwDatabaseError(
+                            IOManagerMessageId::kErrorInvalidAggregateFunction, error.what());
+                }
+                try {
+                    aggregation->addRow(groupKey, aggregateArguments);
+                } catch (const VariantLogicError& error) {
+                    throwDatabaseError(
+                            IOManagerMessageId::kErrorInvalidAggregateFunction, error.what());
+                }
+                rowDataAvailable = moveToNextRowChecked();
+                continue;
+            }
+
+            if (!sorter && offset && *offset > 0) {
                 --(*offset);
-                rowDataAvailable = moveToNextRow(dataSets);
+                rowDataAvailable = moveToNextRowChecked();
                 continue;
             }
 
-            std::size_t valueIdx = 0;
-            for (const auto& expr : request.m_resultExpressions) {
-                const auto exprType = expr.m_expression->getType();
-                if (exprType == requests::ExpressionType::kAllColumnsReference) {
-                    const auto allColumnsExpression =
-                            dynamic_cast<const requests::AllColumnsExpression*>(
-                                    expr.m_expression.get());
-                    const auto tableIdx = *allColumnsExpression->getDatasetTableIndex();
-                    for (const auto& rowValue : dataSets[tableIdx]->getCurrentRow()) {
-                        values[valueIdx] = rowValue;
-                        const auto valueSize = getVariantSize(values[valueIdx]);
-                        rowSize += valueSize;
-                        if (!notNull) nullMask.setBit(valueIdx, valueSize == 0);
-                        ++valueIdx;
+            evaluateValues();
+            if (sorter) {
+                addSortedRow();
+                rowDataAvailable = moveToNextRowChecked();
+                continue;
+            }
+
+            writeRow();
+            if (limit) --(*limit);
+            rowDataAvailable = moveToNextRowChecked();
+        }
+
+        if (aggregation) {
+            for (bool groupAvailable = aggregation->moveToFirstGroup();
+                    groupAvailable && (!limit.has_value() || *limit > 0);
+                    groupAvailable = aggregation->moveToNextGroup()) {
+                if (request.m_having) {
+                    try {
+                        const auto groupFits = compiledHaving
+                                                       ? compiledHaving->evaluate(*dbContext)
+                                                       : request.m_having->evaluate(*dbContext);
+                        if (groupFits.isNull() || !groupFits.getBool()) continue;
+                    } catch (const std::runtime_error& e) {
+                        throwDatabaseError(
+                                IOManagerMessageId::kErrorInvalidHavingCondition, e.what());
+                    } catch (const VariantLogicError& error) {
+                        throwDatabaseError(
+                                IOManagerMessageId::kErrorInvalidHavingCondition, error.what());
                     }
-                } else {
-                    values[valueIdx] = expr.m_expression->evaluate(*dbContext);
-                    const auto valueSize = getVariantSize(values[valueIdx]);
-                    rowSize += valueSize;
-                    if (!notNull) nullMask.setBit(valueIdx, valueSize == 0);
-                    ++valueIdx;
                 }
-            }
 
-            rowSize += nullMask.getByteSize();
+                if (!sorter && offset && *offset > 0) {
+                    --(*offset);
+                    continue;
+                }
 
-            codedOutput.WriteVarint64(rowSize);
-            protobuf::checkOutputStreamError(rawOutput);
+                evaluateValues();
+                if (sorter) {
+                    addSortedRow();
+                    continue;
+                }
 
-            if (!notNull) {
-                codedOutput.WriteRaw(nullMask.getData(), nullMask.getByteSize());
-                protobuf::checkOutputStreamError(rawOutput);
+                writeRow();
+                if (limit) --(*limit);
             }
+        }
 
-            for (std::size_t i = 0; i < columnCountToSend; ++i) {
-                writeVariant(codedOutput, values[i]);
-                protobuf::checkOutputStreamError(rawOutput);
+        if (sorter) {
+            sorter->sort();
+            while ((!limit.has_value() || *limit > 0) && sorter->moveToNextRow()) {
+                if (offset && *offset > 0) {
+                    --(*offset);
+                    continue;
+                }
+                sorter->getCurrentRow(values);
+                writeRow();
+                if (limit) --(*limit);
             }
-
-            if (limit) --(*limit);
-            rowDataAvailable = moveToNextRow(dataSets);
         }
     } catch (DatabaseError& dberror) {
         LOG_ERROR << kLogContext << dberror.what();
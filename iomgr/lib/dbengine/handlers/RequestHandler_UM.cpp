@@ -19,6 +19,7 @@ void RequestHandler::executeCreateUserRequest(iomgr_protocol::DatabaseEngineResp
 {
     response.set_has_affected_row_count(false);
     m_instance.createUser(request.m_name, request.m_realName, request.m_active, m_userId);
+    m_instance.commitWriteAheadLog();
     protobuf::writeMessage(
             protobuf::ProtocolMessageType::kDatabaseEngineResponse, response, m_connectionIo);
 }
@@ -28,6 +29,7 @@ void RequestHandler::executeDropUserRequest(
 {
     response.set_has_affected_row_count(false);
     m_instance.dropUser(request.m_name, !request.m_ifExists, m_userId);
+    m_instance.commitWriteAheadLog();
     protobuf::writeMessage(
             protobuf::ProtocolMessageType::kDatabaseEngineResponse, response, m_connectionIo);
 }
@@ -37,6 +39,7 @@ void RequestHandler::executeAlterUserRequest(
 {
     response.set_has_affected_row_count(false);
     m_instance.updateUser(request.m_name, request.m_active, request.m_realName, m_userId);
+    m_instance.commitWriteAheadLog();
     protobuf::writeMessage(
             protobuf::ProtocolMessageType::kDatabaseEngineResponse, response, m_connectionIo);
 }
@@ -48,6 +51,7 @@ void RequestHandler::executeAddUserAccessKeyRequest(
     response.set_has_affected_row_count(false);
     m_instance.createUserAccessKey(
             request.m_userName, request.m_keyName, request.m_keyText, request.m_active, m_userId);
+    m_instance.commitWriteAheadLog();
     protobuf::writeMessage(
             protobuf::ProtocolMessageType::kDatabaseEngineResponse, response, m_connectionIo);
 }
@@ -59,6 +63,7 @@ void RequestHandler::executeDropUserAccessKeyRequest(
     response.set_has_affected_row_count(false);
     m_instance.dropUserAccessKey(
             request.m_userName, request.m_keyName, !request.m_ifExists, m_userId);
+    m_instance.commitWriteAheadLog();
     protobuf::writeMessage(
             protobuf::ProtocolMessageType::kDatabaseEngineResponse, response, m_connectionIo);
 }
@@ -70,6 +75,7 @@ void RequestHandler::executeAlterUserAccessKeyRequest(
     response.set_has_affected_row_count(false);
     m_instance.updateUserAccessKey(
             request.m_userName, request.m_keyName, request.m_active, m_userId);
+    m_instance.commitWriteAheadLog();
     protobuf::writeMessage(
             protobuf::ProtocolMessageType::kDatabaseEngineResponse, response, m_connectionIo);
 }
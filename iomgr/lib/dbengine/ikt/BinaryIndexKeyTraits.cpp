@@ -0,0 +1,32 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "BinaryIndexKeyTraits.h"
+
+// CRT headers
+#include <cstring>
+
+namespace siodb::iomgr::dbengine {
+
+std::size_t BinaryIndexKeyTraits::getKeySize() const noexcept
+{
+    return m_keySize;
+}
+
+void* BinaryIndexKeyTraits::getMinKey(void* key) const noexcept
+{
+    return std::memset(key, 0, m_keySize);
+}
+
+void* BinaryIndexKeyTraits::getMaxKey(void* key) const noexcept
+{
+    return std::memset(key, 0xFF, m_keySize);
+}
+
+NumericKeyType BinaryIndexKeyTraits::getNumericKeyType() const noexcept
+{
+    return NumericKeyType::kNonNumeric;
+}
+
+}  // namespace siodb::iomgr::dbengine
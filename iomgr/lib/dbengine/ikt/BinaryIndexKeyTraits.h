@@ -0,0 +1,58 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "IndexKeyTraits.h"
+
+namespace siodb::iomgr::dbengine {
+
+/**
+ * Index key traits information provider for the index with fixed size binary keys
+ * compared bytewise.
+ */
+class BinaryIndexKeyTraits final : public IndexKeyTraits {
+public:
+    /**
+     * Initializes object of class BinaryIndexKeyTraits.
+     * @param keySize Key size in bytes.
+     */
+    explicit BinaryIndexKeyTraits(std::size_t keySize) noexcept
+        : m_keySize(keySize)
+    {
+    }
+
+    /**
+     * Returns key size.
+     * @return Key size in bytes.
+     */
+    std::size_t getKeySize() const noexcept override;
+
+    /**
+     * Writes minimum key value to the given buffer.
+     * @param key Key buffer.
+     * @return Key buffer.
+     */
+    void* getMinKey(void* key) const noexcept override;
+
+    /**
+     * Writes maximum key value to the given buffer.
+     * @param key Key buffer.
+     * @return Key buffer.
+     */
+    void* getMaxKey(void* key) const noexcept override;
+
+    /**
+     * Returns numeric key type.
+     * @return Numeric key type.
+     */
+    NumericKeyType getNumericKeyType() const noexcept override;
+
+private:
+    /** Key size */
+    const std::size_t m_keySize;
+};
+
+}  // namespace siodb::iomgr::dbengine
@@ -43,6 +43,8 @@ EncryptedFile::EncryptedFile(const std::string& path, int extraFlags, int create
     , m_dataBuffer(kDataBufferSize)
     , m_dataBufferBlockCount(m_dataBuffer.size() / m_blockSize)
     , m_dataBufferUsefulSize(m_dataBufferBlockCount * m_blockSize)
+    , m_readCachePageSize(utils::alignUp(kMinReadCachePageSize, m_blockSize))
+    , m_readCacheTick(0)
 {
     if (!writeHeader()) throw std::system_error(m_lastError, std::generic_category());
 }
@@ -60,6 +62,8 @@ EncryptedFile::EncryptedFile(const std::string& path, int extraFlags,
     , m_dataBuffer(kDataBufferSize)
     , m_dataBufferBlockCount(m_dataBuffer.size() / m_blockSize)
     , m_dataBufferUsefulSize(m_dataBufferBlockCount * m_blockSize)
+    , m_readCachePageSize(utils::alignUp(kMinReadCachePageSize, m_blockSize))
+    , m_readCacheTick(0)
 {
     struct stat st;
     if (::fstat(m_fd.getFd(), &st) < 0) {
@@ -90,6 +94,9 @@ std::size_t EncryptedFile::read(std::uint8_t* buffer, std::size_t size, off_t of
         return 0;
     }
 
+    std::lock_guard lock(m_mutex);
+    // Large reads bypass cache, so that they don't evict pages of small reads
+    if (size < m_readCachePageSize) return readCached(buffer, size, offset + m_headerBuffer.size());
     return readInternal(buffer, size, offset + m_headerBuffer.size());
 }
 
@@ -104,11 +111,13 @@ std::size_t EncryptedFile::write(
         return 0;
     }
 
+    std::lock_guard lock(m_mutex);
     return writeInternal(buffer, size, offset + m_headerBuffer.size());
 }
 
 off_t EncryptedFile::getFileSize() noexcept
 {
+    std::lock_guard lock(m_mutex);
     return m_plaintextSize;
 }
 
@@ -118,6 +127,7 @@ bool EncryptedFile::stat(struct stat& st) noexcept
         m_lastError = errno;
         return false;
     }
+    std::lock_guard lock(m_mutex);
     st.st_size = m_plaintextSize;
     return true;
 }
@@ -131,6 +141,8 @@ bool EncryptedFile::extend(off_t length) noexcept
         return false;
     }
 
+    std::lock_guard lock(m_mutex);
+    invalidateReadCache(getEofOffset(), 0);
     const auto remainingPlaintextSize =
             m_plaintextSize - utils::alignDown(m_plaintextSize, m_blockSize);
     if (length <= remainingPlaintextSize) {
@@ -164,12 +176,8 @@ std::size_t EncryptedFile::readInternal(
     if (offsetDiff > 0) {
         // Read partial amount of data from the first block
 
-        if (::preadExact(m_fd.getFd(), m_dataBuffer.data(), m_blockSize, alignedDownOffset,
-                    kIgnoreSignals)
-                != m_blockSize) {
-            m_lastError = errno;
+        if (readRaw(m_dataBuffer.data(), m_blockSize, alignedDownOffset) != m_blockSize)
             return 0;
-        }
 
         m_decryptionContext->transform(m_dataBuffer.data(), 1, m_dataBuffer.data());
 
@@ -188,11 +196,9 @@ std::size_t EncryptedFile::readInternal(
     if (alignedDownSize > 0) {
         // Read data blocks in the middle
 
-        const auto bytesRead =
-                ::preadExact(m_fd.getFd(), buffer, alignedDownSize, offset, kIgnoreSignals);
+        const auto bytesRead = readRaw(buffer, alignedDownSize, offset);
 
         if (bytesRead != alignedDownSize) {
-            m_lastError = errno;
             const auto decryptedBytes = utils::alignDown(bytesRead, m_blockSize);
             if (decryptedBytes > 0)
                 m_decryptionContext->transform(buffer, decryptedBytes / m_blockSize, buffer);
@@ -210,11 +216,8 @@ std::size_t EncryptedFile::readInternal(
     if (size > 0) {
         // Read part of the last block if applicable
 
-        if (::preadExact(m_fd.getFd(), m_dataBuffer.data(), m_blockSize, offset, kIgnoreSignals)
-                != m_blockSize) {
-            m_lastError = errno;
+        if (readRaw(m_dataBuffer.data(), m_blockSize, offset) != m_blockSize)
             return totalBytesRead;
-        }
 
         m_decryptionContext->transform(m_dataBuffer.data(), 1, m_dataBuffer.data());
         std::memcpy(buffer, m_dataBuffer.data(), size);
@@ -230,6 +233,9 @@ std::size_t EncryptedFile::writeInternal(
     DEBUG_TRACE("EncryptedFile::writeInternal: buffer=" << VOID_PTR(buffer) << " size=" << size
                                                         << " offset=" << offset);
 
+    // Partial blocks are written as whole blocks
+    invalidateReadCache(offset, size + m_blockSize);
+
     std::size_t totalBytesWritten = 0;
 
     DEBUG_TRACE("EncryptedFile::writeInternal: size(0)=" << size << " offset=" << offset);
@@ -270,12 +276,10 @@ std::size_t EncryptedFile::writeInternal(
         DEBUG_TRACE("EncryptedFile::writeInternal: write2=" << bytesToWrite);
         m_encryptionContext->transform(buffer, bytesToWrite / m_blockSize, m_dataBuffer.data());
 
-        const auto bytesWritten = utils::alignDown(::pwriteExact(m_fd.getFd(), m_dataBuffer.data(),
-                                                           bytesToWrite, offset, kIgnoreSignals),
-                m_blockSize);
+        const auto bytesWritten = utils::alignDown(
+                writeRaw(m_dataBuffer.data(), bytesToWrite, offset), m_blockSize);
 
         const bool errorOccurred = bytesWritten != bytesToWrite;
-        if (errorOccurred) m_lastError = errno;
 
         totalBytesWritten += bytesWritten;
 
@@ -337,9 +341,7 @@ bool EncryptedFile::updateBlock(const std::uint8_t* buffer, std::size_t size, of
     assert(offset >= 0 && offset <= static_cast<off_t>(getEofOffset() - size));
 
     const auto blockOffset = utils::alignDown(offset, m_blockSize);
-    if (::preadExact(m_fd.getFd(), m_dataBuffer.data(), m_blockSize, blockOffset, kIgnoreSignals)
-            != m_blockSize) {
-        m_lastError = errno;
+    if (readRaw(m_dataBuffer.data(), m_blockSize, blockOffset) != m_blockSize) {
         DEBUG_TRACE("updateBlock: READ block failed: at " << blockOffset << ": " << m_lastError
                                                           << " " << std::strerror(m_lastError));
         return false;
@@ -350,9 +352,7 @@ bool EncryptedFile::updateBlock(const std::uint8_t* buffer, std::size_t size, of
     std::memcpy(m_dataBuffer.data() + (offset - blockOffset), buffer, size);
     m_encryptionContext->transform(m_dataBuffer.data(), 1, m_dataBuffer.data());
 
-    if (::pwriteExact(m_fd.getFd(), m_dataBuffer.data(), m_blockSize, blockOffset, kIgnoreSignals)
-            != m_blockSize) {
-        m_lastError = errno;
+    if (writeRaw(m_dataBuffer.data(), m_blockSize, blockOffset) != m_blockSize) {
         DEBUG_TRACE("updateBlock: WRITE block failed: at " << blockOffset << ": " << m_lastError
                                                            << " " << std::strerror(m_lastError));
         return false;
@@ -376,9 +376,7 @@ bool EncryptedFile::writeBlock(const std::uint8_t* buffer, std::size_t size, off
     m_encryptionContext->transform(m_dataBuffer.data(), 1, m_dataBuffer.data());
 
     const auto blockOffset = utils::alignUp(offset, m_blockSize);
-    if (::pwriteExact(m_fd.getFd(), m_dataBuffer.data(), m_blockSize, blockOffset, kIgnoreSignals)
-            != m_blockSize) {
-        m_lastError = errno;
+    if (writeRaw(m_dataBuffer.data(), m_blockSize, blockOffset) != m_blockSize) {
         return false;
     }
 
@@ -405,11 +403,80 @@ bool EncryptedFile::writeHeader() noexcept
     ::pbeEncodeInt64(m_plaintextSize, m_headerBuffer.data());
     m_encryptionContext->transform(
             m_headerBuffer.data(), m_headerBuffer.size() / m_blockSize, m_headerBuffer.data());
-    if (::pwriteExact(m_fd.getFd(), m_headerBuffer.data(), m_headerBuffer.size(), 0, kIgnoreSignals)
-            == m_headerBuffer.size())
-        return true;
-    m_lastError = errno;
-    return false;
+    return writeRaw(m_headerBuffer.data(), m_headerBuffer.size(), 0) == m_headerBuffer.size();
+}
+
+std::size_t EncryptedFile::readCached(
+        std::uint8_t* buffer, std::size_t size, off_t offset) noexcept
+{
+    std::size_t totalBytesRead = 0;
+    while (size > 0) {
+        const auto page = getReadCachePage(utils::alignDown(offset, m_readCachePageSize));
+        if (!page) break;
+
+        const std::size_t offsetInPage = offset - page->m_offset;
+        if (offsetInPage >= page->m_size) {
+            // End of file
+            m_lastError = 0;
+            break;
+        }
+
+        const auto bytesToCopy = std::min(size, page->m_size - offsetInPage);
+        std::memcpy(buffer, page->m_data.data() + offsetInPage, bytesToCopy);
+        offset += bytesToCopy;
+        buffer += bytesToCopy;
+        size -= bytesToCopy;
+        totalBytesRead += bytesToCopy;
+    }
+    return totalBytesRead;
+}
+
+EncryptedFile::ReadCachePage* EncryptedFile::getReadCachePage(off_t offset) noexcept
+{
+    auto victim = &m_readCache[0];
+    for (auto& page : m_readCache) {
+        if (page.m_offset == offset) {
+            page.m_lastUse = ++m_readCacheTick;
+            return &page;
+        }
+        if (page.m_lastUse < victim->m_lastUse) victim = &page;
+    }
+
+    if (victim->m_data.empty()) {
+        try {
+            victim->m_data.resize(m_readCachePageSize);
+        } catch (std::bad_alloc&) {
+            m_lastError = ENOMEM;
+            return nullptr;
+        }
+    }
+
+    victim->m_offset = -1;
+    victim->m_lastUse = 0;
+    const auto bytesRead = readRaw(victim->m_data.data(), m_readCachePageSize, offset);
+    if (bytesRead != m_readCachePageSize && m_lastError != 0) return nullptr;
+
+    // Partial cipher block at the end of file can't be decrypted
+    const auto blockCount = bytesRead / m_blockSize;
+    m_decryptionContext->transform(victim->m_data.data(), blockCount, victim->m_data.data());
+    victim->m_offset = offset;
+    victim->m_size = blockCount * m_blockSize;
+    victim->m_lastUse = ++m_readCacheTick;
+    return victim;
+}
+
+void EncryptedFile::invalidateReadCache(off_t offset, std::size_t size) noexcept
+{
+    const off_t endOffset = offset + size;
+    for (auto& page : m_readCache) {
+        if (page.m_offset < 0) continue;
+        const off_t pageEndOffset = page.m_offset + m_readCachePageSize;
+        if ((page.m_offset < endOffset && offset < pageEndOffset)
+                || page.m_size < m_readCachePageSize) {
+            page.m_offset = -1;
+            page.m_lastUse = 0;
+        }
+    }
 }
 
 }  // namespace siodb::iomgr::dbengine::io
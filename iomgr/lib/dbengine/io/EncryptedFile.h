@@ -11,9 +11,17 @@
 // Common project headers
 #include <siodb/common/utils/Align.h>
 
+// STL headers
+#include <array>
+#include <mutex>
+
 namespace siodb::iomgr::dbengine::io {
 
-/** Provides encrypted binary file I/O. */
+/**
+ * Provides encrypted binary file I/O. Small reads are served from a few cached
+ * pages of decrypted data, so that reads of neighbouring values don't read
+ * and decrypt same cipher blocks again. Writes invalidate affected pages.
+ */
 class EncryptedFile : public File {
 public:
     DECLARE_NONCOPYABLE(EncryptedFile);
@@ -99,7 +107,32 @@ public:
      */
     bool extend(off_t length) noexcept override;
 
+    /**
+     * Returns indication that file stores data as is, so that file contents
+     * can be accessed directly via memory mapping of the file.
+     * @return Always false, because file stores encrypted data.
+     */
+    bool isMappable() const noexcept override
+    {
+        return false;
+    }
+
 private:
+    /** Cached page of decrypted data */
+    struct ReadCachePage {
+        /** Offset of the page, -1 if page is empty */
+        off_t m_offset = -1;
+
+        /** Size of the decrypted data, less than page size if page ends at the end of file */
+        std::size_t m_size = 0;
+
+        /** Last use tick, used to evict least recently used page */
+        std::uint64_t m_lastUse = 0;
+
+        /** Decrypted data, allocated on first use */
+        BinaryValue m_data;
+    };
+
     /**
      * Reads specified amount of data from file starting at a given offset.
      * If pread() system call succeeds but reads less then specified, next attempts are taken
@@ -159,6 +192,33 @@ private:
      */
     bool writeHeader() noexcept;
 
+    /**
+     * Reads data via decrypted page cache.
+     * @param buffer A buffer for data.
+     * @param size Desired data size.
+     * @param offset Starting offset.
+     * @return Number of bytes actually read. Values less than requested indicate error.
+     *         In such case, m_lastError an error code. Error code 0 indicates that end of file
+     *         is reached.
+     */
+    std::size_t readCached(std::uint8_t* buffer, std::size_t size, off_t offset) noexcept;
+
+    /**
+     * Returns cached decrypted page, reads and decrypts it if it is not cached.
+     * @param offset Page offset.
+     * @return Page or nullptr if page can't be read. In the case of failure,
+     *         m_lastError will contain an error code.
+     */
+    ReadCachePage* getReadCachePage(off_t offset) noexcept;
+
+    /**
+     * Drops cached pages which overlap with the given range, and pages which
+     * end at the end of file, since file is going to be changed.
+     * @param offset Starting offset.
+     * @param size Range size.
+     */
+    void invalidateReadCache(off_t offset, std::size_t size) noexcept;
+
 private:
     /**
      * Returns EOF offset.
@@ -197,9 +257,31 @@ private:
     /** Useful size of I/O buffer, which can store number of full blocks */
     const std::size_t m_dataBufferUsefulSize;
 
+    /**
+     * Serializes I/O operations, which share I/O buffer and plaintext size.
+     * Same file is used concurrently when it is a segment file, which stores
+     * multiple column data blocks.
+     */
+    mutable std::mutex m_mutex;
+
+    /** Number of cached decrypted pages */
+    static constexpr std::size_t kReadCachePageCount = 4;
+
+    /** Cached decrypted pages */
+    std::array<ReadCachePage, kReadCachePageCount> m_readCache;
+
+    /** Page size, multiple of the cipher block size */
+    const std::size_t m_readCachePageSize;
+
+    /** Page use counter */
+    std::uint64_t m_readCacheTick;
+
     /** Header plaintext size */
     static constexpr std::size_t kHeaderPlaintextSize = sizeof(std::uint64_t);
 
+    /** Minimum page size of the decrypted page cache */
+    static constexpr std::size_t kMinReadCachePageSize = 4096;
+
     /** I/O buffer size */
     static constexpr std::size_t kDataBufferSize = 8192;
 };
@@ -5,28 +5,80 @@
 #include "File.h"
 
 // Project headers
+#include "WriteAheadLog.h"
+
+// Common project headers
 #include <siodb/common/io/FileIO.h>
+#include <siodb/common/utils/Align.h>
 
 // CRT headers
 #include <cerrno>
+#include <cstdlib>
 #include <cstring>
 
 // STL headers
+#include <algorithm>
 #include <sstream>
 #include <system_error>
 
 // System headers
+#include <fcntl.h>
 #include <unistd.h>
 
 namespace siodb::iomgr::dbengine::io {
 
+namespace {
+
+/** Size of the bounce buffer used for unaligned direct I/O */
+constexpr std::size_t kDirectIoBufferSize = 256 * 1024;
+
+/**
+ * Returns aligned bounce buffer of the current thread, allocates it on first use.
+ * @return Buffer of kDirectIoBufferSize bytes or nullptr if there is no memory.
+ */
+std::uint8_t* getDirectIoBuffer() noexcept
+{
+    thread_local std::unique_ptr<std::uint8_t, decltype(&std::free)> buffer(nullptr, &std::free);
+    if (!buffer) {
+        buffer.reset(static_cast<std::uint8_t*>(
+                std::aligned_alloc(File::kDirectIoAlignment, kDirectIoBufferSize)));
+    }
+    return buffer.get();
+}
+
+/**
+ * Reads aligned data from the O_DIRECT file. Unlike preadExact(), doesn't retry
+ * after short read, because direct read returns less than requested only
+ * at end of file, and next read would be unaligned.
+ * @param fd File descriptor.
+ * @param[out] buffer A buffer for data.
+ * @param size Desired data size.
+ * @param offset Starting offset.
+ * @return Number of bytes actually read. If it is less than requested,
+ *         errno contains error code or 0 if end of file is reached.
+ */
+std::size_t preadDirect(int fd, void* buffer, std::size_t size, off_t offset) noexcept
+{
+    ssize_t n;
+    do {
+        n = ::pread(fd, buffer, size, offset);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) return 0;
+    if (static_cast<std::size_t>(n) < size) errno = 0;
+    return n;
+}
+
+}  // anonymous namespace
+
 File::File(const std::string& path, int extraFlags, int createMode, off_t initialSize)
     : m_fd(validateFd(
-            ::open(path.c_str(),
+            openFile(path,
                     ((extraFlags & O_TMPFILE) ? 0 : O_CREAT) | O_RDWR | O_CLOEXEC | extraFlags,
                     createMode),
             path))
     , m_lastError(0)
+    , m_wal(nullptr)
+    , m_directIo((::fcntl(m_fd.getFd(), F_GETFL) & O_DIRECT) != 0)
 {
     if (initialSize > 0 && ::posixFileAllocateExact(m_fd.getFd(), 0, initialSize)) {
         const int errorCode = errno;
@@ -38,8 +90,10 @@ File::File(const std::string& path, int extraFlags, int createMode, off_t initia
 }
 
 File::File(const std::string& path, int extraFlags)
-    : m_fd(validateFd(::open(path.c_str(), O_RDWR | O_CLOEXEC | extraFlags), path))
+    : m_fd(validateFd(openFile(path, O_RDWR | O_CLOEXEC | extraFlags), path))
     , m_lastError(0)
+    , m_wal(nullptr)
+    , m_directIo((::fcntl(m_fd.getFd(), F_GETFL) & O_DIRECT) != 0)
 {
 }
 
@@ -61,6 +115,12 @@ off_t File::getRawFileSize() noexcept
     return stat(st) ? st.st_size : -1;
 }
 
+void File::enableWriteAheadLog(WriteAheadLog* wal, const std::string& path)
+{
+    m_walPath = path;
+    m_wal = wal;
+}
+
 bool File::flush() noexcept
 {
     if (::fdatasync(m_fd.getFd()) == 0) return true;
@@ -79,4 +139,154 @@ int File::validateFd(int fd, const std::string& path)
     throw std::system_error(errorCode, std::generic_category(), err.str());
 }
 
+int File::openFile(const std::string& path, int flags, int createMode) noexcept
+{
+    const int fd = ::open(path.c_str(), flags, createMode);
+    // Some file systems, like tmpfs, don't support O_DIRECT, use page cache for them
+    if (fd < 0 && errno == EINVAL && (flags & O_DIRECT))
+        return ::open(path.c_str(), flags & ~O_DIRECT, createMode);
+    return fd;
+}
+
+std::size_t File::readRaw(void* buffer, std::size_t size, off_t offset) noexcept
+{
+    if (m_directIo) {
+        if (!isDirectIoAligned(buffer, size, offset))
+            return readDirectUnaligned(static_cast<std::uint8_t*>(buffer), size, offset);
+        const auto res = preadDirect(m_fd.getFd(), buffer, size, offset);
+        if (res != size) m_lastError = errno;
+        return res;
+    }
+    const auto res = ::preadExact(m_fd.getFd(), buffer, size, offset, kIgnoreSignals);
+    if (res != size) m_lastError = errno;
+    return res;
+}
+
+std::size_t File::writeRaw(const void* buffer, std::size_t size, off_t offset) noexcept
+{
+    std::size_t res;
+    if (m_directIo && !isDirectIoAligned(buffer, size, offset)) {
+        res = writeDirectUnaligned(static_cast<const std::uint8_t*>(buffer), size, offset);
+    } else {
+        res = ::pwriteExact(m_fd.getFd(), buffer, size, offset, kIgnoreSignals);
+        if (res != size) m_lastError = errno;
+    }
+    // Partially written data is recorded as well, it may be already on disk
+    if (res > 0 && !logWrite(buffer, res, offset)) return 0;
+    return res;
+}
+
+bool File::logWrite(const void* buffer, std::size_t size, off_t offset) noexcept
+{
+    if (!m_wal) return true;
+    try {
+        m_wal->logWrite(m_walPath, buffer, size, offset);
+        return true;
+    } catch (std::bad_alloc&) {
+        m_lastError = ENOMEM;
+    } catch (std::exception&) {
+        m_lastError = EINVAL;
+    }
+    return false;
+}
+
+std::size_t File::readDirectUnaligned(
+        std::uint8_t* buffer, std::size_t size, off_t offset) noexcept
+{
+    const auto directIoBuffer = getDirectIoBuffer();
+    if (!directIoBuffer) {
+        m_lastError = ENOMEM;
+        return 0;
+    }
+
+    std::size_t totalBytesRead = 0;
+    while (size > 0) {
+        const auto chunkOffset = utils::alignDown(offset, kDirectIoAlignment);
+        const std::size_t leadingGapSize = offset - chunkOffset;
+        const auto bytesToRead = std::min(size, kDirectIoBufferSize - leadingGapSize);
+        const auto chunkSize = utils::alignUp(leadingGapSize + bytesToRead, kDirectIoAlignment);
+
+        const auto res = preadDirect(m_fd.getFd(), directIoBuffer, chunkSize, chunkOffset);
+        const auto bytesRead =
+                std::min(res > leadingGapSize ? res - leadingGapSize : 0, bytesToRead);
+        std::memcpy(buffer, directIoBuffer + leadingGapSize, bytesRead);
+        totalBytesRead += bytesRead;
+        if (bytesRead != bytesToRead) {
+            m_lastError = errno;
+            break;
+        }
+
+        buffer += bytesRead;
+        offset += bytesRead;
+        size -= bytesRead;
+    }
+    return totalBytesRead;
+}
+
+std::size_t File::writeDirectUnaligned(
+        const std::uint8_t* buffer, std::size_t size, off_t offset) noexcept
+{
+    const auto directIoBuffer = getDirectIoBuffer();
+    if (!directIoBuffer) {
+        m_lastError = ENOMEM;
+        return 0;
+    }
+
+    std::lock_guard lock(m_directWriteMutex);
+    std::size_t totalBytesWritten = 0;
+    while (size > 0) {
+        const auto chunkOffset = utils::alignDown(offset, kDirectIoAlignment);
+        const std::size_t leadingGapSize = offset - chunkOffset;
+        const auto bytesToWrite = std::min(size, kDirectIoBufferSize - leadingGapSize);
+        const auto chunkSize = utils::alignUp(leadingGapSize + bytesToWrite, kDirectIoAlignment);
+        const auto lastBlockOffset = chunkSize - kDirectIoAlignment;
+
+        // Preserve existing data around the written range
+        off_t fileSize = -1;
+        if (leadingGapSize > 0 && !readDirectEdgeBlock(directIoBuffer, chunkOffset, fileSize))
+            break;
+        if ((leadingGapSize + bytesToWrite) % kDirectIoAlignment != 0
+                && (lastBlockOffset > 0 || leadingGapSize == 0)
+                && !readDirectEdgeBlock(directIoBuffer + lastBlockOffset,
+                        chunkOffset + lastBlockOffset, fileSize))
+            break;
+
+        std::memcpy(directIoBuffer + leadingGapSize, buffer, bytesToWrite);
+        const auto res =
+                ::pwriteExact(m_fd.getFd(), directIoBuffer, chunkSize, chunkOffset, kIgnoreSignals);
+        if (res != chunkSize) {
+            m_lastError = errno;
+            if (res > leadingGapSize)
+                totalBytesWritten += std::min(res - leadingGapSize, bytesToWrite);
+            break;
+        }
+
+        // Whole blocks were written, restore file size if they crossed end of file
+        const off_t endOffset = offset + bytesToWrite;
+        if (fileSize >= 0 && ::ftruncate(m_fd.getFd(), std::max(fileSize, endOffset)) != 0) {
+            m_lastError = errno;
+            break;
+        }
+
+        totalBytesWritten += bytesToWrite;
+        buffer += bytesToWrite;
+        offset += bytesToWrite;
+        size -= bytesToWrite;
+    }
+    return totalBytesWritten;
+}
+
+bool File::readDirectEdgeBlock(std::uint8_t* block, off_t offset, off_t& fileSize) noexcept
+{
+    const auto res = preadDirect(m_fd.getFd(), block, kDirectIoAlignment, offset);
+    if (res == kDirectIoAlignment) return true;
+    if (errno != 0) {
+        m_lastError = errno;
+        return false;
+    }
+    std::memset(block + res, 0, kDirectIoAlignment - res);
+    fileSize = std::max(fileSize, static_cast<off_t>(offset + res));
+    return true;
+}
+
 }  // namespace siodb::iomgr::dbengine::io
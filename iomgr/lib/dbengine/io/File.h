@@ -14,6 +14,7 @@
 
 // STL headers
 #include <memory>
+#include <mutex>
 #include <string>
 
 // System headers
@@ -22,8 +23,18 @@
 
 namespace siodb::iomgr::dbengine::io {
 
-/** Provides file I/O. */
+class WriteAheadLog;
+
+/**
+ * Provides file I/O. When file is opened with O_DIRECT, requests which are not aligned
+ * to the direct I/O alignment are performed via per-thread aligned bounce buffer:
+ * partially covered edge blocks are read, patched and written back as whole blocks.
+ */
 class File {
+public:
+    /** Alignment of the file offsets, sizes and buffers for direct I/O */
+    static constexpr std::size_t kDirectIoAlignment = 4096;
+
 protected:
     /**
      * Initializes object of class File. Creates new file.
@@ -152,6 +163,40 @@ public:
      */
     bool flush() noexcept;
 
+    /**
+     * Returns indication that file stores data as is, so that file contents
+     * can be accessed directly via memory mapping of the file.
+     * @return true if file contents can be memory mapped, false otherwise.
+     */
+    virtual bool isMappable() const noexcept = 0;
+
+    /**
+     * Enables recording of the file writes into the write-ahead log.
+     * Writes become durable when log is committed.
+     * @param wal Write-ahead log.
+     * @param path File path, which is used to replay log records.
+     */
+    void enableWriteAheadLog(WriteAheadLog* wal, const std::string& path);
+
+    /**
+     * Returns indication that file writes are recorded in the write-ahead log.
+     * @return true if writes are recorded, false otherwise.
+     */
+    bool isWriteAheadLogged() const noexcept
+    {
+        return m_wal != nullptr;
+    }
+
+    /**
+     * Returns indication that file is opened for direct I/O, bypassing the page cache.
+     * O_DIRECT is silently dropped on file systems which don't support it.
+     * @return true if file is opened with O_DIRECT, false otherwise.
+     */
+    bool isDirectIo() const noexcept
+    {
+        return m_directIo;
+    }
+
 protected:
     /**
      * Validates given file descriptor.
@@ -162,15 +207,122 @@ protected:
      */
     static int validateFd(int fd, const std::string& path);
 
+    /**
+     * Opens file. Retries without O_DIRECT if file system doesn't support it.
+     * @param path File path.
+     * @param flags Open flags.
+     * @param createMode File creation mode.
+     * @return File descriptor or -1 on error, in such case errno contains error code.
+     */
+    static int openFile(const std::string& path, int flags, int createMode = 0) noexcept;
+
+    /**
+     * Reads raw data from the on-disk file.
+     * @param[out] buffer A buffer for data.
+     * @param size Desired data size.
+     * @param offset Starting offset.
+     * @return Number of bytes actually read. Values less than requested indicate error.
+     *         In such case, getLastError() will return an error code. If error code is 0,
+     *         then end of file is reached.
+     */
+    std::size_t readRaw(void* buffer, std::size_t size, off_t offset) noexcept;
+
+    /**
+     * Writes raw data to the on-disk file and records it in the write-ahead log,
+     * if log is enabled for this file.
+     * @param buffer A buffer with data.
+     * @param size Data size.
+     * @param offset Starting offset.
+     * @return Number of bytes known to be written successfully. Value less than requested
+     *         indicates error. In such case, getLastError() will return an error code.
+     */
+    std::size_t writeRaw(const void* buffer, std::size_t size, off_t offset) noexcept;
+
+    /**
+     * Records raw data written to the on-disk file in the write-ahead log,
+     * if log is enabled for this file.
+     * @param buffer A buffer with written data.
+     * @param size Data size.
+     * @param offset Starting offset.
+     * @return true if data is recorded or log isn't enabled, false otherwise.
+     *         In the case of failure, getLastError() will return an error code.
+     */
+    bool logWrite(const void* buffer, std::size_t size, off_t offset) noexcept;
+
+private:
+    /**
+     * Returns indication that request can be passed to the O_DIRECT file as is.
+     * @param buffer Data buffer.
+     * @param size Data size.
+     * @param offset Starting offset.
+     * @return true if buffer, size and offset are aligned, false otherwise.
+     */
+    static bool isDirectIoAligned(const void* buffer, std::size_t size, off_t offset) noexcept
+    {
+        return (reinterpret_cast<std::uintptr_t>(buffer) | size | static_cast<std::size_t>(offset))
+                       % kDirectIoAlignment
+               == 0;
+    }
+
+    /**
+     * Reads unaligned data from the O_DIRECT file via bounce buffer.
+     * @param[out] buffer A buffer for data.
+     * @param size Desired data size.
+     * @param offset Starting offset.
+     * @return Number of bytes actually read.
+     */
+    std::size_t readDirectUnaligned(std::uint8_t* buffer, std::size_t size, off_t offset) noexcept;
+
+    /**
+     * Writes unaligned data to the O_DIRECT file via bounce buffer.
+     * @param buffer A buffer with data.
+     * @param size Data size.
+     * @param offset Starting offset.
+     * @return Number of bytes known to be written successfully.
+     */
+    std::size_t writeDirectUnaligned(
+            const std::uint8_t* buffer, std::size_t size, off_t offset) noexcept;
+
+    /**
+     * Reads edge block of the unaligned direct write into the bounce buffer.
+     * Part of the block beyond end of file is zeroed.
+     * @param[out] block Block buffer.
+     * @param offset Block offset.
+     * @param[in,out] fileSize Raised to the end of the data read, if block crosses
+     *                         end of file. Stays negative if end of file isn't found.
+     * @return true if operation succeeded, false otherwise.
+     */
+    bool readDirectEdgeBlock(std::uint8_t* block, off_t offset, off_t& fileSize) noexcept;
+
 protected:
     /** File descriptor */
     FileDescriptorGuard m_fd;
 
     /** Last I/O error code */
     int m_lastError;
+
+    /** Write-ahead log, nullptr if writes are not recorded */
+    WriteAheadLog* m_wal;
+
+    /** File path for the write-ahead log records */
+    std::string m_walPath;
+
+    /** Indication that file is opened with O_DIRECT */
+    const bool m_directIo;
+
+    /**
+     * Serializes unaligned direct writes, which read and write back whole blocks,
+     * so that concurrent writes into the same block don't overwrite each other.
+     */
+    std::mutex m_directWriteMutex;
+
+    friend class FileIoBatch;
 };
 
 /** Unique pointer shortcut type */
 using FilePtr = std::unique_ptr<File>;
 
+/** Shared pointer shortcut type */
+using FileSharedPtr = std::shared_ptr<File>;
+
 }  // namespace siodb::iomgr::dbengine::io
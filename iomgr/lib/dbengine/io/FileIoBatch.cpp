@@ -0,0 +1,103 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "FileIoBatch.h"
+
+// Common project headers
+#include <siodb/common/log/Log.h>
+
+// STL headers
+#include <atomic>
+
+namespace siodb::iomgr::dbengine::io {
+
+namespace {
+
+/** Indicates that io_uring setup has failed once, so there is no need to try again */
+std::atomic<bool> g_ioUringUnavailable(false);
+
+}  // namespace
+
+void FileIoBatch::addRead(File& file, std::uint8_t* buffer, std::size_t size, off_t offset)
+{
+    m_files.push_back(&file);
+    m_operations.push_back(IoUring::Operation {file.getFd(), false, buffer, size, offset, 0, 0});
+}
+
+void FileIoBatch::addWrite(File& file, const std::uint8_t* buffer, std::size_t size, off_t offset)
+{
+    m_files.push_back(&file);
+    // io_uring never writes into the buffer of the write operation
+    m_operations.push_back(IoUring::Operation {
+            file.getFd(), true, const_cast<std::uint8_t*>(buffer), size, offset, 0, 0});
+}
+
+bool FileIoBatch::execute() noexcept
+{
+    // Single operation doesn't benefit from io_uring
+    const auto ring = m_operations.size() > 1 ? getThreadRing() : nullptr;
+
+    std::vector<IoUring::Operation> ringOperations;
+    std::vector<std::size_t> ringOperationIndices;
+    bool succeeded = true;
+    for (std::size_t i = 0; i < m_operations.size(); ++i) {
+        auto& operation = m_operations[i];
+        auto& file = *m_files[i];
+        if (ring && file.isMappable()) {
+            ringOperations.push_back(operation);
+            ringOperationIndices.push_back(i);
+            continue;
+        }
+        operation.m_result = operation.m_write
+                                     ? file.write(operation.m_buffer, operation.m_size,
+                                               operation.m_offset)
+                                     : file.read(operation.m_buffer, operation.m_size,
+                                               operation.m_offset);
+        succeeded &= (operation.m_result == operation.m_size);
+    }
+
+    if (ringOperations.empty()) return succeeded;
+
+    ring->execute(ringOperations.data(), ringOperations.size());
+    for (std::size_t i = 0; i < ringOperations.size(); ++i) {
+        const auto& ringOperation = ringOperations[i];
+        auto& operation = m_operations[ringOperationIndices[i]];
+        operation.m_result = ringOperation.m_result;
+        operation.m_errorCode = ringOperation.m_errorCode;
+        auto& file = *m_files[ringOperationIndices[i]];
+        if (operation.m_result != operation.m_size) {
+            file.m_lastError = operation.m_errorCode;
+            succeeded = false;
+        }
+        if (operation.m_write && operation.m_result > 0
+                && !file.logWrite(operation.m_buffer, operation.m_result, operation.m_offset)) {
+            operation.m_result = 0;
+            succeeded = false;
+        }
+    }
+    return succeeded;
+}
+
+bool FileIoBatch::isIoUringAvailable() noexcept
+{
+    return getThreadRing() != nullptr;
+}
+
+// ----- internals -----
+
+IoUring* FileIoBatch::getThreadRing() noexcept
+{
+    thread_local std::unique_ptr<IoUring> ring;
+    if (ring || g_ioUringUnavailable.load(std::memory_order_relaxed)) return ring.get();
+    try {
+        ring = std::make_unique<IoUring>(kRingEntries);
+    } catch (std::exception& ex) {
+        // Fall back to regular I/O
+        if (!g_ioUringUnavailable.exchange(true))
+            LOG_INFO << "io_uring is not available, using regular file I/O: " << ex.what();
+    }
+    return ring.get();
+}
+
+}  // namespace siodb::iomgr::dbengine::io
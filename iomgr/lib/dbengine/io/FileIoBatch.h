@@ -0,0 +1,114 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "File.h"
+#include "IoUring.h"
+
+// STL headers
+#include <vector>
+
+namespace siodb::iomgr::dbengine::io {
+
+/**
+ * Batch of independent file reads and writes executed together.
+ * Operations on files which store data as is are submitted to io_uring
+ * in a single system call and proceed in parallel. Other operations,
+ * and all operations when io_uring is not available, are executed
+ * one by one using regular file I/O.
+ */
+class FileIoBatch {
+public:
+    /** Initializes object of class FileIoBatch. */
+    FileIoBatch() = default;
+
+    DECLARE_NONCOPYABLE(FileIoBatch);
+
+    /**
+     * Returns number of operations in the batch.
+     * @return Number of operations.
+     */
+    std::size_t size() const noexcept
+    {
+        return m_operations.size();
+    }
+
+    /**
+     * Returns indication that batch has no operations.
+     * @return true if batch is empty, false otherwise.
+     */
+    bool empty() const noexcept
+    {
+        return m_operations.empty();
+    }
+
+    /**
+     * Adds read operation.
+     * @param file A file.
+     * @param[out] buffer A buffer for data, must stay valid until batch is executed.
+     * @param size Data size.
+     * @param offset File offset.
+     */
+    void addRead(File& file, std::uint8_t* buffer, std::size_t size, off_t offset);
+
+    /**
+     * Adds write operation.
+     * @param file A file.
+     * @param buffer A buffer with data, must stay valid until batch is executed.
+     * @param size Data size.
+     * @param offset File offset.
+     */
+    void addWrite(File& file, const std::uint8_t* buffer, std::size_t size, off_t offset);
+
+    /**
+     * Executes all operations of the batch. Files of failed operations
+     * receive last error code, same as after regular read or write.
+     * @return true if all operations succeeded, false otherwise.
+     */
+    bool execute() noexcept;
+
+    /**
+     * Returns number of bytes transferred by the executed operation.
+     * @param index Operation index.
+     * @return Number of bytes transferred.
+     */
+    std::size_t getResult(std::size_t index) const
+    {
+        return m_operations.at(index).m_result;
+    }
+
+    /** Removes all operations. */
+    void clear() noexcept
+    {
+        m_files.clear();
+        m_operations.clear();
+    }
+
+    /**
+     * Returns indication that io_uring can be used on this system.
+     * @return true if io_uring is available, false otherwise.
+     */
+    static bool isIoUringAvailable() noexcept;
+
+private:
+    /**
+     * Returns io_uring instance of the current thread, creates it if needed.
+     * @return io_uring instance or nullptr if io_uring is not available.
+     */
+    static IoUring* getThreadRing() noexcept;
+
+private:
+    /** Files of the operations */
+    std::vector<File*> m_files;
+
+    /** Operations */
+    std::vector<IoUring::Operation> m_operations;
+
+    /** Submission queue size of the per-thread io_uring instances */
+    static constexpr unsigned kRingEntries = 64;
+};
+
+}  // namespace siodb::iomgr::dbengine::io
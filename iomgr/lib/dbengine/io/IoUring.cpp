@@ -0,0 +1,192 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "IoUring.h"
+
+// Common project headers
+#include <siodb/common/io/FileIO.h>
+
+// CRT headers
+#include <cerrno>
+#include <cstring>
+
+// STL headers
+#include <algorithm>
+#include <system_error>
+
+// System headers
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace siodb::iomgr::dbengine::io {
+
+namespace {
+
+template<class T>
+T* ringPtr(void* ring, std::uint32_t offset) noexcept
+{
+    return reinterpret_cast<T*>(static_cast<std::uint8_t*>(ring) + offset);
+}
+
+}  // namespace
+
+IoUring::IoUring(unsigned entries)
+    : m_sqEntries(0)
+    , m_sqRing(MAP_FAILED)
+    , m_sqRingSize(0)
+    , m_cqRing(MAP_FAILED)
+    , m_cqRingSize(0)
+    , m_sqes(nullptr)
+    , m_sqesSize(0)
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    m_fd.reset(static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params)));
+    if (!m_fd.isValidFd())
+        throw std::system_error(errno, std::generic_category(), "io_uring_setup() failed");
+
+    try {
+        m_sqEntries = params.sq_entries;
+        m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+            m_sqRing = mapRing(m_sqRingSize, IORING_OFF_SQ_RING);
+            m_cqRing = m_sqRing;
+        } else {
+            m_sqRing = mapRing(m_sqRingSize, IORING_OFF_SQ_RING);
+            m_cqRing = mapRing(m_cqRingSize, IORING_OFF_CQ_RING);
+        }
+        m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = static_cast<io_uring_sqe*>(mapRing(m_sqesSize, IORING_OFF_SQES));
+    } catch (...) {
+        unmapRings();
+        throw;
+    }
+
+    m_sqTail = ringPtr<unsigned>(m_sqRing, params.sq_off.tail);
+    m_sqMask = *ringPtr<unsigned>(m_sqRing, params.sq_off.ring_mask);
+    m_sqArray = ringPtr<unsigned>(m_sqRing, params.sq_off.array);
+    m_cqHead = ringPtr<unsigned>(m_cqRing, params.cq_off.head);
+    m_cqTail = ringPtr<unsigned>(m_cqRing, params.cq_off.tail);
+    m_cqMask = *ringPtr<unsigned>(m_cqRing, params.cq_off.ring_mask);
+    m_cqes = ringPtr<io_uring_cqe>(m_cqRing, params.cq_off.cqes);
+    m_iovecs.resize(m_sqEntries);
+}
+
+IoUring::~IoUring()
+{
+    unmapRings();
+}
+
+void IoUring::execute(Operation* operations, std::size_t count) noexcept
+{
+    while (count > 0) {
+        const auto chunkSize = std::min<std::size_t>(count, m_sqEntries);
+        executeChunk(operations, chunkSize);
+        operations += chunkSize;
+        count -= chunkSize;
+    }
+}
+
+// ----- internals -----
+
+void IoUring::executeChunk(Operation* operations, std::size_t count) noexcept
+{
+    // Fill submission queue
+    auto tail = *m_sqTail;
+    for (std::size_t i = 0; i < count; ++i, ++tail) {
+        auto& operation = operations[i];
+        operation.m_result = 0;
+        operation.m_errorCode = 0;
+        const auto index = tail & m_sqMask;
+        auto& iov = m_iovecs[index];
+        iov.iov_base = operation.m_buffer;
+        iov.iov_len = operation.m_size;
+        auto& sqe = m_sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = operation.m_write ? IORING_OP_WRITEV : IORING_OP_READV;
+        sqe.fd = operation.m_fd;
+        sqe.addr = reinterpret_cast<std::uintptr_t>(&iov);
+        sqe.len = 1;
+        sqe.off = operation.m_offset;
+        sqe.user_data = i;
+        m_sqArray[index] = index;
+    }
+    __atomic_store_n(m_sqTail, tail, __ATOMIC_RELEASE);
+
+    // Submit and collect completions
+    std::size_t submitted = 0, completed = 0;
+    while (completed < count) {
+        const auto toSubmit = static_cast<unsigned>(count - submitted);
+        const int n = enter(toSubmit, static_cast<unsigned>(count - completed));
+        if (n < 0 && submitted == completed) {
+            // Nothing is in flight and kernel doesn't accept more, so fail the remaining ones
+            const int errorCode = errno;
+            for (std::size_t i = completed; i < count; ++i)
+                operations[i].m_errorCode = errorCode;
+            // Withdraw unsubmitted entries
+            __atomic_store_n(m_sqTail, *m_sqTail - toSubmit, __ATOMIC_RELEASE);
+            return;
+        }
+        if (n > 0) submitted += n;
+
+        auto head = *m_cqHead;
+        const auto cqTail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        for (; head != cqTail; ++head) {
+            const auto& cqe = m_cqes[head & m_cqMask];
+            auto& operation = operations[cqe.user_data];
+            if (cqe.res < 0)
+                operation.m_errorCode = -cqe.res;
+            else {
+                operation.m_result = cqe.res;
+                if (operation.m_result < operation.m_size) finishSynchronously(operation);
+            }
+            ++completed;
+        }
+        __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+    }
+}
+
+int IoUring::enter(unsigned toSubmit, unsigned minComplete) noexcept
+{
+    while (true) {
+        const auto res = ::syscall(__NR_io_uring_enter, m_fd.getFd(), toSubmit, minComplete,
+                IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (res >= 0 || errno != EINTR) return static_cast<int>(res);
+    }
+}
+
+void IoUring::finishSynchronously(Operation& operation) noexcept
+{
+    const auto remaining = operation.m_size - operation.m_result;
+    const auto buffer = operation.m_buffer + operation.m_result;
+    const auto offset = operation.m_offset + operation.m_result;
+    const auto res =
+            operation.m_write
+                    ? ::pwriteExact(operation.m_fd, buffer, remaining, offset, kIgnoreSignals)
+                    : ::preadExact(operation.m_fd, buffer, remaining, offset, kIgnoreSignals);
+    operation.m_result += res;
+    if (res != remaining) operation.m_errorCode = errno;
+}
+
+void* IoUring::mapRing(std::size_t size, off_t offset)
+{
+    const auto addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            m_fd.getFd(), offset);
+    if (addr == MAP_FAILED)
+        throw std::system_error(errno, std::generic_category(), "io_uring ring mapping failed");
+    return addr;
+}
+
+void IoUring::unmapRings() noexcept
+{
+    if (m_sqes) ::munmap(m_sqes, m_sqesSize);
+    if (m_cqRing != MAP_FAILED && m_cqRing != m_sqRing) ::munmap(m_cqRing, m_cqRingSize);
+    if (m_sqRing != MAP_FAILED) ::munmap(m_sqRing, m_sqRingSize);
+}
+
+}  // namespace siodb::iomgr::dbengine::io
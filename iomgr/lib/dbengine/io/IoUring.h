@@ -0,0 +1,172 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Common project headers
+#include <siodb/common/utils/FileDescriptorGuard.h>
+#include <siodb/common/utils/HelperMacros.h>
+
+// CRT headers
+#include <cstdint>
+
+// STL headers
+#include <vector>
+
+// System headers
+#include <sys/types.h>
+#include <sys/uio.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace siodb::iomgr::dbengine::io {
+
+/**
+ * Minimal io_uring instance used for batched positional reads and writes.
+ * Talks to the kernel directly via system calls, so doesn't require liburing.
+ * Not thread-safe, each thread must use its own instance.
+ */
+class IoUring {
+public:
+    /** Single positional read or write operation */
+    struct Operation {
+        /** File descriptor */
+        int m_fd;
+
+        /** Indication of write operation */
+        bool m_write;
+
+        /** Data buffer */
+        std::uint8_t* m_buffer;
+
+        /** Data size */
+        std::size_t m_size;
+
+        /** File offset */
+        off_t m_offset;
+
+        /** Number of bytes transferred */
+        std::size_t m_result;
+
+        /** Error code, 0 if operation succeeded */
+        int m_errorCode;
+    };
+
+public:
+    /**
+     * Initializes object of class IoUring.
+     * @param entries Desired submission queue size.
+     * @throw std::system_error if io_uring is not supported or can't be set up.
+     */
+    explicit IoUring(unsigned entries);
+
+    /** De-initializes object of class IoUring. */
+    ~IoUring();
+
+    DECLARE_NONCOPYABLE(IoUring);
+
+    /**
+     * Returns maximum number of operations in flight.
+     * @return Submission queue size.
+     */
+    unsigned getCapacity() const noexcept
+    {
+        return m_sqEntries;
+    }
+
+    /**
+     * Executes operations: submits them in as few system calls as possible
+     * and waits until all of them complete. Partially completed operations are
+     * finished synchronously. Each operation receives its own result.
+     * @param operations Operations.
+     * @param count Number of operations.
+     */
+    void execute(Operation* operations, std::size_t count) noexcept;
+
+private:
+    /**
+     * Submits up to capacity operations and waits for their completion.
+     * @param operations Operations.
+     * @param count Number of operations, must not exceed capacity.
+     */
+    void executeChunk(Operation* operations, std::size_t count) noexcept;
+
+    /**
+     * Calls io_uring_enter() system call, retrying on EINTR.
+     * @param toSubmit Number of entries to submit.
+     * @param minComplete Number of completions to wait for.
+     * @return Number of submitted entries or -1 on error.
+     */
+    int enter(unsigned toSubmit, unsigned minComplete) noexcept;
+
+    /**
+     * Finishes partially completed operation synchronously.
+     * @param operation Operation.
+     */
+    static void finishSynchronously(Operation& operation) noexcept;
+
+    /**
+     * Maps part of the ring into memory.
+     * @param size Mapping size.
+     * @param offset Ring offset.
+     * @return Mapping address.
+     * @throw std::system_error if mapping fails.
+     */
+    void* mapRing(std::size_t size, off_t offset);
+
+    /** Unmaps all ring mappings. */
+    void unmapRings() noexcept;
+
+private:
+    /** Ring file descriptor */
+    FileDescriptorGuard m_fd;
+
+    /** Submission queue size */
+    unsigned m_sqEntries;
+
+    /** Submission queue ring mapping */
+    void* m_sqRing;
+
+    /** Submission queue ring mapping size */
+    std::size_t m_sqRingSize;
+
+    /** Completion queue ring mapping, may be the same as m_sqRing */
+    void* m_cqRing;
+
+    /** Completion queue ring mapping size */
+    std::size_t m_cqRingSize;
+
+    /** Submission queue entries */
+    io_uring_sqe* m_sqes;
+
+    /** Submission queue entries mapping size */
+    std::size_t m_sqesSize;
+
+    /** Submission queue tail */
+    unsigned* m_sqTail;
+
+    /** Submission queue ring mask */
+    unsigned m_sqMask;
+
+    /** Submission queue index array */
+    unsigned* m_sqArray;
+
+    /** Completion queue head */
+    unsigned* m_cqHead;
+
+    /** Completion queue tail */
+    const unsigned* m_cqTail;
+
+    /** Completion queue ring mask */
+    unsigned m_cqMask;
+
+    /** Completion queue entries */
+    const io_uring_cqe* m_cqes;
+
+    /** I/O vectors of the operations in flight */
+    std::vector<iovec> m_iovecs;
+};
+
+}  // namespace siodb::iomgr::dbengine::io
@@ -28,16 +28,12 @@ NormalFile::NormalFile(const std::string& path, int extraFlags)
 
 std::size_t NormalFile::read(std::uint8_t* buffer, std::size_t size, off_t offset) noexcept
 {
-    const auto res = ::preadExact(m_fd.getFd(), buffer, size, offset, kIgnoreSignals);
-    if (res != size) m_lastError = errno;
-    return res;
+    return readRaw(buffer, size, offset);
 }
 
 std::size_t NormalFile::write(const std::uint8_t* buffer, std::size_t size, off_t offset) noexcept
 {
-    const auto res = ::pwriteExact(m_fd.getFd(), buffer, size, offset, kIgnoreSignals);
-    if (res != size) m_lastError = errno;
-    return res;
+    return writeRaw(buffer, size, offset);
 }
 
 off_t NormalFile::getFileSize() noexcept
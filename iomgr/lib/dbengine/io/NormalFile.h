@@ -78,6 +78,18 @@ public:
      *         getLastError() will return an error code.
      */
     bool extend(off_t length) noexcept override;
+
+    /**
+     * Returns indication that file stores data as is, so that file contents
+     * can be accessed directly via memory mapping of the file.
+     * Files opened for direct I/O are not mapped, so that their contents
+     * don't go through the page cache.
+     * @return true unless file is opened with O_DIRECT.
+     */
+    bool isMappable() const noexcept override
+    {
+        return !m_directIo;
+    }
 };
 
 }  // namespace siodb::iomgr::dbengine::io
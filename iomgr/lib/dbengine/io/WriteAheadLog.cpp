@@ -0,0 +1,304 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "WriteAheadLog.h"
+
+// Common project headers
+#include <siodb/common/config/SiodbDefs.h>
+#include <siodb/common/io/FileIO.h>
+#include <siodb/common/log/Log.h>
+#include <siodb/common/utils/FsUtils.h>
+#include <siodb/common/utils/PlainBinaryEncoding.h>
+
+// CRT headers
+#include <cerrno>
+#include <cstring>
+
+// STL headers
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+
+// System headers
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// zlib
+#include <zlib.h>
+
+namespace siodb::iomgr::dbengine::io {
+
+namespace {
+
+/**
+ * Opens file and validates file descriptor.
+ * @param path File path.
+ * @param flags Open flags.
+ * @return File descriptor.
+ * @throw std::system_error if file can't be opened.
+ */
+int openChecked(const std::string& path, int flags)
+{
+    const int fd = ::open(path.c_str(), flags | O_CLOEXEC, kDataFileCreationMode);
+    if (fd >= 0) return fd;
+    const int errorCode = errno;
+    throw std::system_error(errorCode, std::generic_category(), "Can't open " + path);
+}
+
+}  // anonymous namespace
+
+WriteAheadLog::WriteAheadLog(const std::string& dataDir, std::uint64_t checkpointSize)
+    : m_dataDir(dataDir)
+    , m_logFilePath(utils::constructPath(dataDir, kLogFileName))
+    , m_checkpointSize(checkpointSize)
+    , m_fd(openChecked(m_logFilePath, O_CREAT | O_RDWR))
+    , m_dirFd(openChecked(dataDir, O_RDONLY | O_DIRECTORY))
+    , m_fileSize(0)
+    , m_appendedLsn(0)
+    , m_durableLsn(0)
+    , m_flushing(false)
+    , m_replayedRecordCount(0)
+{
+    const auto result = replay();
+    m_replayedRecordCount = result.m_recordCount;
+    if (result.m_recordCount > 0) {
+        LOG_INFO << "Write-ahead log: Replayed " << result.m_recordCount << " records into "
+                 << result.m_fileCount << " files";
+    }
+    if (::ftruncate(m_fd.getFd(), 0) != 0 || ::fdatasync(m_fd.getFd()) != 0) {
+        const int errorCode = errno;
+        throw std::system_error(
+                errorCode, std::generic_category(), "Can't truncate " + m_logFilePath);
+    }
+}
+
+WriteAheadLog::~WriteAheadLog()
+{
+    try {
+        checkpoint();
+    } catch (std::exception& ex) {
+        LOG_ERROR << "Write-ahead log: Final checkpoint failed: " << ex.what();
+    }
+}
+
+void WriteAheadLog::logWrite(
+        const std::string& path, const void* data, std::size_t size, off_t offset)
+{
+    // Large writes are split, so that data size always fits into the record header
+    constexpr std::size_t kMaxRecordDataSize = std::numeric_limits<std::uint32_t>::max() / 2;
+    auto p = static_cast<const std::uint8_t*>(data);
+    while (size > kMaxRecordDataSize) {
+        appendRecord(RecordType::kWrite, path, p, kMaxRecordDataSize, offset);
+        p += kMaxRecordDataSize;
+        offset += kMaxRecordDataSize;
+        size -= kMaxRecordDataSize;
+    }
+    appendRecord(RecordType::kWrite, path, p, size, offset);
+}
+
+void WriteAheadLog::logDiscard(const std::string& path)
+{
+    appendRecord(RecordType::kDiscard, path, nullptr, 0, 0);
+}
+
+void WriteAheadLog::commit()
+{
+    std::unique_lock lock(m_mutex);
+    const auto lsn = m_appendedLsn;
+    while (m_durableLsn < lsn) {
+        // Some other thread writes log now, its write may cover our records as well
+        if (m_flushing) {
+            m_flushCompleted.wait(lock);
+            continue;
+        }
+        flushBufferUnlocked(lock);
+        if (m_fileSize >= m_checkpointSize) checkpointUnlocked(lock);
+    }
+}
+
+void WriteAheadLog::checkpoint()
+{
+    std::unique_lock lock(m_mutex);
+    while (m_flushing)
+        m_flushCompleted.wait(lock);
+    checkpointUnlocked(lock);
+}
+
+// ----- internals -----
+
+void WriteAheadLog::appendRecord(RecordType type, const std::string& path, const void* data,
+        std::size_t size, off_t offset)
+{
+    if (path.size() > std::numeric_limits<std::uint16_t>::max())
+        throw std::invalid_argument("Write-ahead log: File path is too long: " + path);
+
+    std::uint8_t header[kRecordHeaderSize];
+    auto p = ::pbeEncodeUInt32(static_cast<std::uint32_t>(size), header + 4);
+    *p++ = static_cast<std::uint8_t>(type);
+    p = ::pbeEncodeUInt16(static_cast<std::uint16_t>(path.size()), p);
+    ::pbeEncodeUInt64(static_cast<std::uint64_t>(offset), p);
+
+    const auto pathData = reinterpret_cast<const std::uint8_t*>(path.data());
+    const auto recordData = static_cast<const std::uint8_t*>(data);
+    auto crc = ::crc32(0, header + 4, kRecordHeaderSize - 4);
+    crc = ::crc32(crc, pathData, static_cast<uInt>(path.size()));
+    if (size > 0) crc = ::crc32(crc, recordData, static_cast<uInt>(size));
+    ::pbeEncodeUInt32(static_cast<std::uint32_t>(crc), header);
+
+    std::lock_guard lock(m_mutex);
+    m_buffer.reserve(m_buffer.size() + kRecordHeaderSize + path.size() + size);
+    m_buffer.insert(m_buffer.end(), header, header + kRecordHeaderSize);
+    m_buffer.insert(m_buffer.end(), pathData, pathData + path.size());
+    if (size > 0) m_buffer.insert(m_buffer.end(), recordData, recordData + size);
+    ++m_appendedLsn;
+}
+
+void WriteAheadLog::flushBufferUnlocked(std::unique_lock<std::mutex>& lock)
+{
+    std::vector<std::uint8_t> buffer;
+    buffer.swap(m_buffer);
+    const auto lsn = m_appendedLsn;
+    const auto offset = m_fileSize;
+    m_flushing = true;
+    lock.unlock();
+
+    int errorCode = 0;
+    if (::pwriteExact(m_fd.getFd(), buffer.data(), buffer.size(), offset, kIgnoreSignals)
+                    != buffer.size()
+            || ::fdatasync(m_fd.getFd()) != 0)
+        errorCode = errno;
+
+    lock.lock();
+    m_flushing = false;
+    m_flushCompleted.notify_all();
+    if (errorCode != 0) {
+        // Keep records, so that next commit writes them again
+        buffer.insert(buffer.end(), m_buffer.begin(), m_buffer.end());
+        m_buffer.swap(buffer);
+        throw std::system_error(
+                errorCode, std::generic_category(), "Can't write " + m_logFilePath);
+    }
+    m_fileSize += buffer.size();
+    m_durableLsn = lsn;
+}
+
+void WriteAheadLog::checkpointUnlocked(std::unique_lock<std::mutex>& lock)
+{
+    m_flushing = true;
+    lock.unlock();
+
+    // Data of all records in the log file is already written into the data files,
+    // so once file system is flushed, records are not needed anymore.
+    int errorCode = 0;
+    if (::syncfs(m_dirFd.getFd()) != 0 || ::ftruncate(m_fd.getFd(), 0) != 0
+            || ::fdatasync(m_fd.getFd()) != 0)
+        errorCode = errno;
+
+    lock.lock();
+    m_flushing = false;
+    m_flushCompleted.notify_all();
+    if (errorCode != 0) {
+        throw std::system_error(
+                errorCode, std::generic_category(), "Can't checkpoint " + m_logFilePath);
+    }
+    m_fileSize = 0;
+}
+
+WriteAheadLog::ReplayResult WriteAheadLog::replay()
+{
+    struct stat st;
+    if (::fstat(m_fd.getFd(), &st) != 0) {
+        const int errorCode = errno;
+        throw std::system_error(errorCode, std::generic_category(), "Can't stat " + m_logFilePath);
+    }
+
+    std::vector<std::uint8_t> log(st.st_size);
+    if (::preadExact(m_fd.getFd(), log.data(), log.size(), 0, kIgnoreSignals) != log.size()) {
+        const int errorCode = errno;
+        throw std::system_error(errorCode, std::generic_category(), "Can't read " + m_logFilePath);
+    }
+
+    struct Record {
+        RecordType m_type;
+        std::string m_path;
+        off_t m_offset;
+        const std::uint8_t* m_data;
+        std::size_t m_size;
+    };
+
+    // Parse records until the end of log or the first torn record
+    std::vector<Record> records;
+    std::unordered_map<std::string, std::size_t> lastDiscards;
+    std::size_t pos = 0;
+    while (log.size() - pos >= kRecordHeaderSize) {
+        const auto header = log.data() + pos;
+        std::uint32_t crc = 0, size = 0;
+        std::uint16_t pathLength = 0;
+        std::uint64_t offset = 0;
+        auto p = ::pbeDecodeUInt32(header, &crc);
+        p = ::pbeDecodeUInt32(p, &size);
+        const auto type = static_cast<RecordType>(*p++);
+        p = ::pbeDecodeUInt16(p, &pathLength);
+        ::pbeDecodeUInt64(p, &offset);
+
+        const std::size_t recordSize = kRecordHeaderSize + pathLength + size;
+        if (log.size() - pos < recordSize) break;
+        if (::crc32(0, header + 4, static_cast<uInt>(recordSize - 4)) != crc) break;
+        if (type != RecordType::kWrite && type != RecordType::kDiscard) break;
+
+        const auto pathData = reinterpret_cast<const char*>(header + kRecordHeaderSize);
+        Record record {type, std::string(pathData, pathLength), static_cast<off_t>(offset),
+                header + kRecordHeaderSize + pathLength, size};
+        if (type == RecordType::kDiscard) lastDiscards[record.m_path] = records.size();
+        records.push_back(std::move(record));
+        pos += recordSize;
+    }
+
+    ReplayResult result;
+    std::unordered_map<std::string, FileDescriptorGuard> files;
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        const auto& record = records[i];
+        if (record.m_type != RecordType::kWrite) continue;
+        const auto it = lastDiscards.find(record.m_path);
+        if (it != lastDiscards.end() && it->second > i) continue;
+
+        auto fileIt = files.find(record.m_path);
+        if (fileIt == files.end()) {
+            // Files which were removed later are not recreated
+            FileDescriptorGuard fd(::open(record.m_path.c_str(), O_WRONLY | O_CLOEXEC));
+            if (!fd.isValidFd() && errno != ENOENT) {
+                const int errorCode = errno;
+                throw std::system_error(
+                        errorCode, std::generic_category(), "Can't open " + record.m_path);
+            }
+            fileIt = files.emplace(record.m_path, std::move(fd)).first;
+        }
+        if (!fileIt->second.isValidFd()) continue;
+
+        if (::pwriteExact(fileIt->second.getFd(), record.m_data, record.m_size, record.m_offset,
+                    kIgnoreSignals)
+                != record.m_size) {
+            const int errorCode = errno;
+            throw std::system_error(
+                    errorCode, std::generic_category(), "Can't write " + record.m_path);
+        }
+        ++result.m_recordCount;
+    }
+
+    for (auto& file : files) {
+        if (!file.second.isValidFd()) continue;
+        if (::fdatasync(file.second.getFd()) != 0) {
+            const int errorCode = errno;
+            throw std::system_error(
+                    errorCode, std::generic_category(), "Can't flush " + file.first);
+        }
+        ++result.m_fileCount;
+    }
+
+    return result;
+}
+
+}  // namespace siodb::iomgr::dbengine::io
@@ -0,0 +1,201 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Common project headers
+#include <siodb/common/utils/FileDescriptorGuard.h>
+#include <siodb/common/utils/HelperMacros.h>
+
+// CRT headers
+#include <cstdint>
+
+// STL headers
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// System headers
+#include <sys/types.h>
+
+namespace siodb::iomgr::dbengine::io {
+
+/**
+ * Physical redo log of the data file writes. Files which are covered by the log
+ * are written without synchronous I/O: each write goes to the page cache and
+ * then is recorded in the log together with the written bytes. Log is made
+ * durable by the commit, which flushes all records appended so far with
+ * a single write and a single fdatasync(). Concurrent commits are grouped:
+ * while one thread flushes the log, other threads wait and then either find
+ * their records already flushed or flush all records accumulated meanwhile
+ * at once.
+ *
+ * When log file grows over the checkpoint size, all data files are flushed
+ * and the log is truncated. On startup, log records are replayed into the data
+ * files up to the first incomplete or corrupted record, which indicates the end
+ * of the log written before crash.
+ *
+ * Records contain raw file bytes, so encrypted files are recorded and replayed
+ * in the encrypted form.
+ */
+class WriteAheadLog {
+public:
+    /** Log file name */
+    static constexpr const char* kLogFileName = "wal.siodf";
+
+    /** Default checkpoint size */
+    static constexpr std::uint64_t kDefaultCheckpointSize = 64 * 1024 * 1024;
+
+public:
+    /**
+     * Initializes object of class WriteAheadLog. Opens or creates log file,
+     * replays existing log records into the data files and truncates the log.
+     * @param dataDir Directory where log file is located. All logged data files
+     *                must be located on the same file system.
+     * @param checkpointSize Log file size which triggers checkpoint.
+     * @throw std::system_error if log can't be opened or replayed.
+     */
+    explicit WriteAheadLog(
+            const std::string& dataDir, std::uint64_t checkpointSize = kDefaultCheckpointSize);
+
+    /** De-initializes object of class WriteAheadLog. Performs final checkpoint. */
+    ~WriteAheadLog();
+
+    DECLARE_NONCOPYABLE(WriteAheadLog);
+
+    /**
+     * Returns number of records replayed on startup.
+     * @return Number of replayed records.
+     */
+    std::size_t getReplayedRecordCount() const noexcept
+    {
+        return m_replayedRecordCount;
+    }
+
+    /**
+     * Appends write record. Must be called after data is written into the file,
+     * so that checkpoint never truncates records whose data isn't written yet.
+     * @param path Data file path.
+     * @param data Written data.
+     * @param size Data size.
+     * @param offset File offset.
+     * @throw std::bad_alloc if there is no memory for the record.
+     */
+    void logWrite(const std::string& path, const void* data, std::size_t size, off_t offset);
+
+    /**
+     * Appends discard record. Previous records of the file are not replayed
+     * after discard record is committed. Used before the file is replaced
+     * or removed. Current file contents must be flushed before commit.
+     * @param path Data file path.
+     * @throw std::bad_alloc if there is no memory for the record.
+     */
+    void logDiscard(const std::string& path);
+
+    /**
+     * Makes all records appended so far durable.
+     * @throw std::system_error if log can't be written.
+     */
+    void commit();
+
+    /**
+     * Flushes all data files and truncates the log.
+     * @throw std::system_error if data files or log can't be flushed.
+     */
+    void checkpoint();
+
+private:
+    /** Record types */
+    enum class RecordType : std::uint8_t {
+        kWrite = 1,
+        kDiscard = 2,
+    };
+
+    /** Replay statistics */
+    struct ReplayResult {
+        /** Number of replayed records */
+        std::size_t m_recordCount = 0;
+
+        /** Number of files which were written */
+        std::size_t m_fileCount = 0;
+    };
+
+private:
+    /**
+     * Appends record to the log buffer.
+     * @param type Record type.
+     * @param path Data file path.
+     * @param data Record data.
+     * @param size Data size.
+     * @param offset File offset.
+     */
+    void appendRecord(RecordType type, const std::string& path, const void* data,
+            std::size_t size, off_t offset);
+
+    /**
+     * Writes log buffer to the log file. Must be called by a single thread at a time.
+     * Releases lock while writing.
+     * @param lock Lock of m_mutex.
+     */
+    void flushBufferUnlocked(std::unique_lock<std::mutex>& lock);
+
+    /**
+     * Flushes data files and truncates log file. Must be called by a single
+     * thread at a time. Releases lock while flushing data files.
+     * @param lock Lock of m_mutex.
+     */
+    void checkpointUnlocked(std::unique_lock<std::mutex>& lock);
+
+    /**
+     * Replays log file into the data files.
+     * @return Replay statistics.
+     */
+    ReplayResult replay();
+
+private:
+    /** Log directory */
+    const std::string m_dataDir;
+
+    /** Log file path */
+    const std::string m_logFilePath;
+
+    /** Log file size which triggers checkpoint */
+    const std::uint64_t m_checkpointSize;
+
+    /** Log file */
+    FileDescriptorGuard m_fd;
+
+    /** Data directory, used to flush file system */
+    FileDescriptorGuard m_dirFd;
+
+    /** Records appended but not yet written to the log file */
+    std::vector<std::uint8_t> m_buffer;
+
+    /** Current log file size */
+    std::uint64_t m_fileSize;
+
+    /** Sequence number of the last appended record */
+    std::uint64_t m_appendedLsn;
+
+    /** Sequence number of the last durable record */
+    std::uint64_t m_durableLsn;
+
+    /** Indication that some thread writes log file */
+    bool m_flushing;
+
+    /** Number of records replayed on startup */
+    std::size_t m_replayedRecordCount;
+
+    /** Synchronizes access to the log state */
+    std::mutex m_mutex;
+
+    /** Signalled when log file write completes */
+    std::condition_variable m_flushCompleted;
+
+    /** Record header size: CRC, data size, type, path length, offset */
+    static constexpr std::size_t kRecordHeaderSize = 4 + 4 + 1 + 2 + 8;
+};
+
+}  // namespace siodb::iomgr::dbengine::io
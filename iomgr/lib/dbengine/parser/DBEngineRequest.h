@@ -127,10 +127,10 @@ struct OrderByExpression {
     }
 
     /** ORDER BY subject */
-    const ConstExpressionPtr m_subject;
+    ConstExpressionPtr m_subject;
 
     /** Indicator of the descending sort order */
-    const bool m_sortDescending;
+    bool m_sortDescending;
 };
 
 /** SELECT request */
@@ -150,7 +150,7 @@ struct SelectRequest : public DBEngineRequest {
             std::vector<ResultExpression>&& columns, ConstExpressionPtr&& where = nullptr,
             std::vector<ConstExpressionPtr>&& groupBy = std::vector<ConstExpressionPtr>(),
             ConstExpressionPtr&& having = nullptr,
-            std::vector<ConstExpressionPtr>&& orderBy = std::vector<ConstExpressionPtr>(),
+            std::vector<OrderByExpression>&& orderBy = std::vector<OrderByExpression>(),
             ConstExpressionPtr&& offset = nullptr, ConstExpressionPtr&& limit = nullptr) noexcept
         : DBEngineRequest(DBEngineRequestType::kSelect)
         , m_database(std::move(database))
@@ -184,7 +184,7 @@ struct SelectRequest : public DBEngineRequest {
     const ConstExpressionPtr m_having;
 
     /** ORDER BY expressions, empty if absent */
-    const std::vector<ConstExpressionPtr> m_orderBy;
+    const std::vector<OrderByExpression> m_orderBy;
 
     /** OFFSET expression, empty if absent */
     const ConstExpressionPtr m_offset;
@@ -755,13 +755,15 @@ struct CreateTableRequest : public DBEngineRequest {
      * @param database Database name.
      * @param table Table name.
      * @param columns Table columns.
+     * @param compression Compression type expression.
      */
     CreateTableRequest(std::string&& database, std::string&& table,
-            std::vector<ColumnDefinition>&& columns) noexcept
+            std::vector<ColumnDefinition>&& columns, ConstExpressionPtr&& compression) noexcept
         : DBEngineRequest(DBEngineRequestType::kCreateTable)
         , m_database(std::move(database))
         , m_table(std::move(table))
         , m_columns(std::move(columns))
+        , m_compression(std::move(compression))
     {
     }
 
@@ -773,6 +775,9 @@ struct CreateTableRequest : public DBEngineRequest {
 
     /** Column definitions */
     const std::vector<ColumnDefinition> m_columns;
+
+    /** Compression type expression */
+    const ConstExpressionPtr m_compression;
 };
 
 /** DROP TABLE request */
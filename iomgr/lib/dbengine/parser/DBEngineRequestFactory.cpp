@@ -147,14 +147,18 @@ requests::DBEngineRequestPtr DBEngineRequestFactory::createSelectRequestForSimpl
     std::string database;
     std::vector<requests::SourceTable> tables;
     std::vector<requests::ResultExpression> columns;
-    requests::ConstExpressionPtr where, offset, limit;
+    requests::ConstExpressionPtr where, having, offset, limit;
+    std::vector<requests::ConstExpressionPtr> groupBy;
+    std::vector<requests::OrderByExpression> orderBy;
 
     for (std::size_t i = 0; i < node->children.size(); ++i) {
         const auto child = node->children[i];
         const auto childTerminalType = helpers::getNonTerminalType(child);
 
         if (childTerminalType == SiodbParser::RuleSelect_core)
-            parseSelectCore(child, database, tables, columns, where);
+            parseSelectCore(child, database, tables, columns, where, groupBy, having);
+        else if (childTerminalType == SiodbParser::RuleOrdering_term)
+            orderBy.push_back(parseOrderingTerm(child));
         else if (childTerminalType == kInvalidNodeType) {
             const auto terminalType = helpers::getTerminalType(child);
             switch (terminalType) {
@@ -189,15 +193,6 @@ requests::DBEngineRequestPtr DBEngineRequestFactory::createSelectRequestForSimpl
         }
     }
 
-    // TODO: Capture GROUP BY values
-    std::vector<requests::ConstExpressionPtr> groupBy;
-
-    // TODO: Capture HAVING values
-    requests::ConstExpressionPtr having;
-
-    // TODO: Capture ORDER BY values
-    std::vector<requests::ConstExpressionPtr> orderBy;
-
     return std::make_unique<requests::SelectRequest>(std::move(database), std::move(tables),
             std::move(columns), std::move(where), std::move(groupBy), std::move(having),
             std::move(orderBy), std::move(offset), std::move(limit));
@@ -216,11 +211,6 @@ requests::DBEngineRequestPtr DBEngineRequestFactory::createSelectRequestForFacto
 
     // Now fallback to simple one
     return createSelectRequestForSimpleSelectStatement(node);
-
-    // TODO: Capture WHERE values
-    // TODO: Capture GROUP BY values
-    // TODO: Capture HAVING values
-    // TODO: Capture ORDER BY values
 }
 
 requests::DBEngineRequestPtr DBEngineRequestFactory::createInsertRequest(
@@ -856,8 +846,27 @@ requests::DBEngineRequestPtr DBEngineRequestFactory::createCreateTableRequest(
                 std::move(constraints));
     }
 
-    return std::make_unique<requests::CreateTableRequest>(
-            std::move(database), std::move(table), std::move(columns));
+    // Capture table options
+    requests::ConstExpressionPtr compression;
+    const auto optionListNode =
+            helpers::findNonTerminal(node, SiodbParser::RuleCreate_table_option_list);
+    if (optionListNode) {
+        // skip comma (option ',' option ... )
+        for (std::size_t i = 0; i < optionListNode->children.size(); i += 2) {
+            auto optionNode = optionListNode->children[i];
+            ExpressionFactory exprFactory(false);
+            switch (helpers::getTerminalType(optionNode->children.at(0))) {
+                case SiodbParser::K_COMPRESSION: {
+                    compression = exprFactory.createExpression(optionNode->children.at(2));
+                    break;
+                }
+                default: throw std::invalid_argument("CREATE TABLE invalid option");
+            }
+        }
+    }
+
+    return std::make_unique<requests::CreateTableRequest>(std::move(database), std::move(table),
+            std::move(columns), std::move(compression));
 }
 
 requests::DBEngineRequestPtr DBEngineRequestFactory::createDropTableRequest(
@@ -1276,7 +1285,8 @@ requests::ResultExpression DBEngineRequestFactory::createResultExpression(
 
 void DBEngineRequestFactory::parseSelectCore(antlr4::tree::ParseTree* node, std::string& database,
         std::vector<requests::SourceTable>& tables,
-        std::vector<requests::ResultExpression>& columns, requests::ConstExpressionPtr& where)
+        std::vector<requests::ResultExpression>& columns, requests::ConstExpressionPtr& where,
+        std::vector<requests::ConstExpressionPtr>& groupBy, requests::ConstExpressionPtr& having)
 {
     std::size_t i = 0;
     for (; i < node->children.size(); ++i) {
@@ -1317,6 +1327,26 @@ void DBEngineRequestFactory::parseSelectCore(antlr4::tree::ParseTree* node, std:
 
                     ExpressionFactory exprFactory(true);
                     where = exprFactory.createExpression(node->children[i]);
+                } else if (terminalType == SiodbParser::K_GROUP) {
+                    // GROUP BY expressions are separated by commas
+                    ExpressionFactory exprFactory(true);
+                    for (i += 2; i < node->children.size(); ++i) {
+                        const auto groupByNode = node->children[i];
+                        if (helpers::getNonTerminalType(groupByNode) == SiodbParser::RuleExpr)
+                            groupBy.push_back(exprFactory.createExpression(groupByNode));
+                        else if (helpers::getTerminalType(groupByNode) != SiodbParser::COMMA)
+                            break;
+                    }
+                    if (groupBy.empty())
+                        throw std::runtime_error("SELECT: GROUP BY does not contain expression");
+                    --i;
+                } else if (terminalType == SiodbParser::K_HAVING) {
+                    ++i;
+                    if (i >= node->children.size())
+                        throw std::runtime_error("SELECT: HAVING does not contain expression");
+
+                    ExpressionFactory exprFactory(true);
+                    having = exprFactory.createExpression(node->children[i]);
                 }
                 break;
             };
@@ -1328,4 +1358,19 @@ void DBEngineRequestFactory::parseSelectCore(antlr4::tree::ParseTree* node, std:
     }
 }
 
+requests::OrderByExpression DBEngineRequestFactory::parseOrderingTerm(
+        antlr4::tree::ParseTree* node)
+{
+    bool sortDescending = false;
+    for (std::size_t i = 1; i < node->children.size(); ++i) {
+        const auto terminalType = helpers::getTerminalType(node->children[i]);
+        if (terminalType == SiodbParser::K_COLLATE)
+            throw std::runtime_error("SELECT: COLLATE is not supported in ORDER BY");
+        sortDescending = terminalType == SiodbParser::K_DESC;
+    }
+    ExpressionFactory exprFactory(true);
+    return requests::OrderByExpression(
+            exprFactory.createExpression(node->children.at(0)), sortDescending);
+}
+
 }  // namespace siodb::iomgr::dbengine::parser
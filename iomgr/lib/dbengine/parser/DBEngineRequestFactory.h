@@ -257,10 +257,22 @@ private:
      * @param[out] tables List of tables.
      * @param[out] columns List of columns.
      * @param[out] where WHERE condition.
+     * @param[out] groupBy GROUP BY expressions.
+     * @param[out] having HAVING condition.
      */
     static void parseSelectCore(antlr4::tree::ParseTree* node, std::string& database,
             std::vector<requests::SourceTable>& tables,
-            std::vector<requests::ResultExpression>& columns, requests::ConstExpressionPtr& where);
+            std::vector<requests::ResultExpression>& columns, requests::ConstExpressionPtr& where,
+            std::vector<requests::ConstExpressionPtr>& groupBy,
+            requests::ConstExpressionPtr& having);
+
+    /**
+     * Parses ORDER BY term.
+     * @param node Parse tree node with ordering_term node.
+     * @return ORDER BY expression.
+     * @throw std::runtime_error if term uses unsupported syntax.
+     */
+    static requests::OrderByExpression parseOrderingTerm(antlr4::tree::ParseTree* node);
 
     /**
      * Converts given type name into Siodb column data type.
@@ -18,6 +18,20 @@ ColumnDataType DatabaseContext::getColumnDataType(
     return m_dataSets.at(tableIndex)->getColumnDataType(columnIndex);
 }
 
+const Variant* DatabaseContext::getBatchColumnValues(
+        std::size_t tableIndex, std::size_t columnIndex)
+{
+    // Rows of multiple data sets are combined one by one, so they have no common batch
+    if (m_dataSets.size() != 1) return nullptr;
+    return m_dataSets.at(tableIndex)->getBatchColumnValues(columnIndex);
+}
+
+const Variant& DatabaseContext::getAggregateValue(std::size_t aggregateIndex)
+{
+    if (!m_aggregateValues) throw std::runtime_error("There is no current group of rows");
+    return m_aggregateValues->at(aggregateIndex);
+}
+
 /// ------ internals ------
 
 DatabaseContext::NameToIndexMapping DatabaseContext::makeNameToIndexMapping() const
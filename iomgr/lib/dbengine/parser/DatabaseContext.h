@@ -13,7 +13,7 @@ namespace siodb::iomgr::dbengine::requests {
 /**
  * Context used for expression evaluation
  */
-class DatabaseContext final : public Expression::Context {
+class DatabaseContext final : public Expression::BatchContext {
 public:
     /**
      * Initializes object of class DatabaseContext
@@ -22,6 +22,7 @@ public:
     explicit DatabaseContext(std::vector<DataSetPtr>&& dataSets)
         : m_dataSets(std::move(dataSets))
         , m_nameToIndexMapping(makeNameToIndexMapping())
+        , m_aggregateValues(nullptr)
     {
     }
 
@@ -34,6 +35,18 @@ public:
         return m_dataSets;
     }
 
+    /**
+     * Replaces data set. New data set must have the same columns and keep the replaced
+     * data set alive, because names of the replaced data set are used for name lookup.
+     * @param index Data set index.
+     * @param dataSet New data set.
+     * @throw std::out_of_range if index is out of range.
+     */
+    void replaceDataSet(std::size_t index, DataSetPtr dataSet)
+    {
+        m_dataSets.at(index) = std::move(dataSet);
+    }
+
     /**
      * Retuns data set index.
      * @param name Data set name.
@@ -66,6 +79,36 @@ public:
     ColumnDataType getColumnDataType(
             std::size_t tableIndex, std::size_t columnIndex) const override;
 
+    /**
+     * Returns values of the column for the rows of the current batch.
+     * Batches are available only if there is a single data set.
+     * @param tableIndex Table index.
+     * @param columnIndex Column index.
+     * @return Address of the column values or nullptr if batch values are not available.
+     * @throw std::out_of_range if table or column index is greater than or equal
+     * to actual number of tables or columns
+     */
+    const Variant* getBatchColumnValues(std::size_t tableIndex, std::size_t columnIndex) override;
+
+    /**
+     * Sets values of the aggregate functions for the current group of rows.
+     * @param aggregateValues Aggregate function values, nullptr if there is no current group.
+     */
+    void setAggregateValues(const std::vector<Variant>* aggregateValues) noexcept
+    {
+        m_aggregateValues = aggregateValues;
+    }
+
+    /**
+     * Returns value of the aggregate function for the current group of rows.
+     * @param aggregateIndex Aggregate function index.
+     * @return Aggregate function value.
+     * @throw std::out_of_range if aggregate index is greater than or equal
+     * to actual number of aggregate functions
+     * @throw std::runtime_error if there is no current group.
+     */
+    const Variant& getAggregateValue(std::size_t aggregateIndex) override;
+
 private:
     /** Name to index mapping type */
     using NameToIndexMapping = std::unordered_map<std::reference_wrapper<const std::string>,
@@ -80,10 +123,13 @@ private:
 
 private:
     /** Data sets */
-    const std::vector<DataSetPtr> m_dataSets;
+    std::vector<DataSetPtr> m_dataSets;
 
     /** Name to index mapping */
     const NameToIndexMapping m_nameToIndexMapping;
+
+    /** Aggregate function values of the current group, nullptr if there is no current group */
+    const std::vector<Variant>* m_aggregateValues;
 };
 
 }  // namespace siodb::iomgr::dbengine::requests
@@ -138,13 +138,18 @@ create_index_stmt:
 		',' indexed_column
 	)* ')' (K_WHERE expr)?;
 
+create_table_option: K_COMPRESSION '=' simple_expr;
+
+create_table_option_list:
+	create_table_option (',' create_table_option)*;
+
 create_table_stmt:
 	K_CREATE (K_TEMP | K_TEMPORARY)? K_TABLE (
 		K_IF K_NOT K_EXISTS
 	)? (database_name '.')? table_name (
 		'(' column_def (',' column_def)* (',' table_constraint)* ')' (
 			K_WITHOUT IDENTIFIER
-		)?
+		)? (K_WITH create_table_option_list)?
 		| K_AS select_stmt
 	);
 
@@ -377,6 +382,7 @@ simple_expr:
 	literal_value
 	| BIND_PARAMETER
 	| ( ( database_name '.')? table_name '.')? column_name
+	| function_call
 	| unary_operator simple_expr
 	| simple_expr '||' simple_expr
 	| simple_expr ( '*' | '/' | '%') simple_expr
@@ -419,8 +425,7 @@ expr:
 	| expr K_AND expr
 	| expr K_OR expr
 	| '(' expr ')'
-	| simple_expr
-	| function_call;
+	| simple_expr;
 
 foreign_key_clause:
 	K_REFERENCES foreign_table (
@@ -578,6 +583,7 @@ keyword:
 	| K_COLLATE
 	| K_COLUMN
 	| K_COMMIT
+	| K_COMPRESSION
 	| K_CONFLICT
 	| K_CONSTRAINT
 	| K_CREATE
@@ -786,6 +792,7 @@ K_CHECK: C H E C K;
 K_COLLATE: C O L L A T E;
 K_COLUMN: C O L U M N;
 K_COMMIT: C O M M I T;
+K_COMPRESSION: C O M P R E S S I O N;
 K_CONFLICT: C O N F L I C T;
 K_CONSTRAINT: C O N S T R A I N T;
 K_CREATE: C R E A T E;
@@ -0,0 +1,148 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "AggregateFunction.h"
+
+namespace siodb::iomgr::dbengine::requests {
+
+AggregateFunction::AggregateFunction(ExpressionType type, ExpressionPtr&& argument)
+    : Expression(type)
+    , m_argument(std::move(argument))
+{
+    if (!isAggregateFunctionType(type)) throw std::invalid_argument("Invalid aggregate function");
+    if (!m_argument && type != ExpressionType::kCountFunction)
+        throw std::invalid_argument("Aggregate function argument is nullptr");
+}
+
+VariantType AggregateFunction::getResultValueType(const Context& context) const
+{
+    switch (m_type) {
+        case ExpressionType::kCountFunction: return VariantType::kInt64;
+        case ExpressionType::kAvgFunction: return VariantType::kDouble;
+        case ExpressionType::kSumFunction: {
+            // Values are summed as the widest type of the same kind
+            const auto argumentType = m_argument->getResultValueType(context);
+            if (isFloatingPointType(argumentType)) return VariantType::kDouble;
+            if (isIntegerType(argumentType))
+                return isSignedType(argumentType) ? VariantType::kInt64 : VariantType::kUInt64;
+            return VariantType::kNull;
+        }
+        default: return m_argument->getResultValueType(context);
+    }
+}
+
+ColumnDataType AggregateFunction::getColumnDataType(const Context& context) const
+{
+    switch (m_type) {
+        case ExpressionType::kCountFunction: return COLUMN_DATA_TYPE_INT64;
+        case ExpressionType::kAvgFunction: return COLUMN_DATA_TYPE_DOUBLE;
+        case ExpressionType::kSumFunction: {
+            const auto argumentType = m_argument->getColumnDataType(context);
+            if (isFloatingPointType(argumentType)) return COLUMN_DATA_TYPE_DOUBLE;
+            if (isIntegerType(argumentType))
+                return isSignedType(argumentType) ? COLUMN_DATA_TYPE_INT64 : COLUMN_DATA_TYPE_UINT64;
+            return COLUMN_DATA_TYPE_UNKNOWN;
+        }
+        default: return m_argument->getColumnDataType(context);
+    }
+}
+
+MutableOrConstantString AggregateFunction::getExpressionText() const
+{
+    switch (m_type) {
+        case ExpressionType::kMaxFunction: return "MAX";
+        case ExpressionType::kMinFunction: return "MIN";
+        case ExpressionType::kSumFunction: return "SUM";
+        case ExpressionType::kAvgFunction: return "AVG";
+        default: return "COUNT";
+    }
+}
+
+std::size_t AggregateFunction::getSerializedSize() const noexcept
+{
+    return getExpressionTypeSerializedSize(m_type) + 1
+           + (m_argument ? m_argument->getSerializedSize() : 0);
+}
+
+void AggregateFunction::validate(const Context& context) const
+{
+    checkHasAggregateIndex();
+    if (!m_argument) return;
+    m_argument->validate(context);
+    const auto argumentType = m_argument->getResultValueType(context);
+    switch (m_type) {
+        case ExpressionType::kSumFunction:
+        case ExpressionType::kAvgFunction: {
+            if (!isNumericType(argumentType) && !isNullType(argumentType)) {
+                throw std::runtime_error(getExpressionText().asMutableString()
+                                         + " function: argument type isn't numeric");
+            }
+            break;
+        }
+        case ExpressionType::kMinFunction:
+        case ExpressionType::kMaxFunction: {
+            if (argumentType == VariantType::kClob || argumentType == VariantType::kBlob) {
+                throw std::runtime_error(getExpressionText().asMutableString()
+                                         + " function: argument type can't be compared");
+            }
+            break;
+        }
+        default: break;
+    }
+}
+
+Variant AggregateFunction::evaluate(Context& context) const
+{
+    checkHasAggregateIndex();
+    return context.getAggregateValue(*m_aggregateIndex);
+}
+
+std::uint8_t* AggregateFunction::serializeUnchecked(std::uint8_t* buffer) const
+{
+    buffer = serializeExpressionTypeUnchecked(m_type, buffer);
+    *buffer++ = m_argument ? 1 : 0;
+    return m_argument ? m_argument->serializeUnchecked(buffer) : buffer;
+}
+
+Expression* AggregateFunction::clone() const
+{
+    ExpressionPtr argument(m_argument ? m_argument->clone() : nullptr);
+    return new AggregateFunction(m_type, std::move(argument));
+}
+
+bool AggregateFunction::isAggregateFunctionType(ExpressionType type) noexcept
+{
+    switch (type) {
+        case ExpressionType::kMaxFunction:
+        case ExpressionType::kMinFunction:
+        case ExpressionType::kSumFunction:
+        case ExpressionType::kAvgFunction:
+        case ExpressionType::kCountFunction: return true;
+        default: return false;
+    }
+}
+
+// ----- internals -----
+
+bool AggregateFunction::isEqualTo(const Expression& other) const noexcept
+{
+    const auto& otherArgument = static_cast<const AggregateFunction&>(other).m_argument;
+    if (!m_argument || !otherArgument) return !m_argument && !otherArgument;
+    return *m_argument == *otherArgument;
+}
+
+void AggregateFunction::dumpImpl(std::ostream& os) const
+{
+    if (m_argument)
+        os << " arg: " << *m_argument;
+    else
+        os << " arg: *";
+}
+
+void AggregateFunction::checkHasAggregateIndex() const
+{
+    if (!m_aggregateIndex) throw std::runtime_error("Aggregate function index is not set");
+}
+
+}  // namespace siodb::iomgr::dbengine::requests
@@ -0,0 +1,148 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "Expression.h"
+
+// STL headers
+#include <optional>
+
+namespace siodb::iomgr::dbengine::requests {
+
+/**
+ * Aggregate function COUNT, SUM, MIN, MAX or AVG. Function is computed over the group
+ * of rows, so its value is provided by the evaluation context for the current group.
+ */
+class AggregateFunction final : public Expression {
+public:
+    /**
+     * Initializes object of class AggregateFunction.
+     * @param type Aggregate function type.
+     * @param argument Function argument, nullptr for COUNT(*).
+     * @throw std::invalid_argument if type is not aggregate function type
+     *                              or argument is nullptr for function other than COUNT.
+     */
+    AggregateFunction(ExpressionType type, ExpressionPtr&& argument);
+
+    /**
+     * Returns function argument.
+     * @return Function argument or nullptr for COUNT(*).
+     */
+    const Expression* getArgument() const noexcept
+    {
+        return m_argument.get();
+    }
+
+    /**
+     * Returns index of the aggregate function in the evaluation context.
+     * @return Aggregate function index.
+     */
+    const auto& getAggregateIndex() const noexcept
+    {
+        return m_aggregateIndex;
+    }
+
+    /**
+     * Sets index of the aggregate function in the evaluation context.
+     * @param aggregateIndex Aggregate function index.
+     */
+    void setAggregateIndex(std::size_t aggregateIndex) noexcept
+    {
+        m_aggregateIndex = aggregateIndex;
+    }
+
+    /**
+     * Returns value type of expression.
+     * @param context Evaluation context.
+     * @return Evaluated expression value type.
+     */
+    VariantType getResultValueType(const Context& context) const override;
+
+    /**
+     * Returns type of generated column from this expression.
+     * @param context Evaluation context.
+     * @return Column data type.
+     */
+    ColumnDataType getColumnDataType(const Context& context) const override;
+
+    /**
+     * Returns expression text.
+     * @return Expression text.
+     */
+    MutableOrConstantString getExpressionText() const override;
+
+    /**
+     * Returns memory size in bytes required to serialize this expression.
+     * @return Memory size in bytes.
+     */
+    std::size_t getSerializedSize() const noexcept override;
+
+    /**
+     * Checks if argument is valid and has suitable type.
+     * @param context Evaluation context.
+     * @throw std::runtime_error if argument is not valid or aggregate index is not set.
+     */
+    void validate(const Context& context) const override;
+
+    /**
+     * Evaluates expression.
+     * @param context Evaluation context.
+     * @return Value of the aggregate function for the current group of rows.
+     * @throw std::runtime_error if aggregate index is not set or there is no current group.
+     */
+    Variant evaluate(Context& context) const override;
+
+    /**
+     * Serializes this expression, doesn't check memory buffer size.
+     * @param buffer Memory buffer address.
+     * @return Address after a last written byte.
+     * @throw std::runtime_error if serialization failed.
+     */
+    std::uint8_t* serializeUnchecked(std::uint8_t* buffer) const override;
+
+    /**
+     * Creates deep copy of this expression.
+     * @return New expression object.
+     */
+    Expression* clone() const override;
+
+    /**
+     * Returns indication that expression type is aggregate function type.
+     * @param type Expression type.
+     * @return true if expression type is aggregate function type, false otherwise.
+     */
+    static bool isAggregateFunctionType(ExpressionType type) noexcept;
+
+protected:
+    /**
+     * Compares structure of this expression with another one for equality.
+     * @param other Other expression. Guaranteed to be of the same type as this one.
+     * @return true if expressions structurally equal, false otherwise.
+     */
+    bool isEqualTo(const Expression& other) const noexcept override;
+
+    /**
+     * Dumps expression-specific part to a stream.
+     * @param os Output stream.
+     */
+    void dumpImpl(std::ostream& os) const override;
+
+private:
+    /**
+     * Checks that @ref m_aggregateIndex value is set.
+     * @throw std::runtime_error if aggregate index is not set.
+     */
+    void checkHasAggregateIndex() const;
+
+private:
+    /** Function argument, nullptr for COUNT(*) */
+    const ExpressionPtr m_argument;
+
+    /** Index of the aggregate function in the evaluation context */
+    std::optional<std::size_t> m_aggregateIndex;
+};
+
+}  // namespace siodb::iomgr::dbengine::requests
@@ -6,6 +6,7 @@
 
 // Project headers
 #include "AddOperator.h"
+#include "AggregateFunction.h"
 #include "AllColumnsExpression.h"
 #include "BetweenOperator.h"
 #include "BitwiseAndOperator.h"
@@ -0,0 +1,316 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "BatchFilter.h"
+
+// Project headers
+#include "ConstantExpression.h"
+#include "NativeValueType.h"
+#include "SingleColumnExpression.h"
+
+// STL headers
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+namespace siodb::iomgr::dbengine::requests {
+
+namespace {
+
+/**
+ * Converts constant to the native type of the column values, if comparison of the native
+ * values gives the same result as comparison of the variants for any column value.
+ * @param constant Constant value.
+ * @return Converted constant or nothing if there is no such conversion.
+ */
+template<typename T>
+std::optional<T> convertConstant(const Variant& constant)
+{
+    const auto constantType = constant.getValueType();
+    if constexpr (std::is_floating_point_v<T>) {
+        // Integers are compared with floating point values after conversion, which may round
+        if (!constant.isFloatingPoint()) return std::nullopt;
+        const double value = (constantType == VariantType::kFloat) ? constant.getFloat()
+                                                                   : constant.getDouble();
+        const auto result = static_cast<T>(value);
+        // Inexact and NaN values are not converted
+        if (static_cast<double>(result) != value) return std::nullopt;
+        return result;
+    } else {
+        if (!constant.isInteger()) return std::nullopt;
+        const bool signedConstant = constantType == VariantType::kInt8
+                                    || constantType == VariantType::kInt16
+                                    || constantType == VariantType::kInt32
+                                    || constantType == VariantType::kInt64;
+        if (signedConstant) {
+            // Large unsigned values are cast to signed type when compared with signed values
+            if (std::is_unsigned_v<T> && sizeof(T) >= sizeof(std::uint32_t)) return std::nullopt;
+            const auto value = constant.asInt64();
+            if (value < static_cast<std::int64_t>(std::numeric_limits<T>::min())
+                    || (value > 0
+                            && static_cast<std::uint64_t>(value)
+                                       > static_cast<std::uint64_t>(
+                                               std::numeric_limits<T>::max())))
+                return std::nullopt;
+            return static_cast<T>(value);
+        }
+        const auto value = constant.asUInt64();
+        if (value > static_cast<std::uint64_t>(std::numeric_limits<T>::max()))
+            return std::nullopt;
+        return static_cast<T>(value);
+    }
+}
+
+/**
+ * Returns comparison operator type with swapped operands.
+ * @param type Comparison operator type.
+ * @return Comparison operator type.
+ */
+ExpressionType swapComparisonOperands(ExpressionType type) noexcept
+{
+    switch (type) {
+        case ExpressionType::kLessPredicate: return ExpressionType::kGreaterPredicate;
+        case ExpressionType::kLessOrEqualPredicate: return ExpressionType::kGreaterOrEqualPredicate;
+        case ExpressionType::kGreaterPredicate: return ExpressionType::kLessPredicate;
+        case ExpressionType::kGreaterOrEqualPredicate: return ExpressionType::kLessOrEqualPredicate;
+        default: return type;
+    }
+}
+
+/**
+ * Compares variants in the same way as comparison operators do.
+ * @param type Comparison operator type.
+ * @param left Left operand.
+ * @param right Right operand.
+ * @return Comparison result.
+ */
+bool compareVariants(ExpressionType type, const Variant& left, const Variant& right)
+{
+    // TODO: SIODB-172
+    if (type == ExpressionType::kEqualPredicate) return left.compatibleEqual(right);
+    if (left.isNull() || right.isNull()) return false;
+    switch (type) {
+        case ExpressionType::kNotEqualPredicate: return !left.compatibleEqual(right);
+        case ExpressionType::kLessPredicate: return left.compatibleLess(right);
+        case ExpressionType::kLessOrEqualPredicate: return left.compatibleLessOrEqual(right);
+        case ExpressionType::kGreaterPredicate: return left.compatibleGreater(right);
+        case ExpressionType::kGreaterOrEqualPredicate: return left.compatibleGreaterOrEqual(right);
+        default: throw std::invalid_argument("Invalid comparison operator type");
+    }
+}
+
+/**
+ * Keeps selected rows for which values match.
+ * @param values Batch values.
+ * @param typedMatch Function checking the native value of the column type.
+ * @param genericMatch Function checking values of other types, including NULLs.
+ * @param[in,out] selection Selected rows.
+ */
+template<typename T, typename TypedMatch, typename GenericMatch>
+void filterSelection(const Variant* values, TypedMatch typedMatch, GenericMatch genericMatch,
+        Expression::SelectionVector& selection)
+{
+    constexpr auto valueType = getNativeValueType<T>();
+    std::size_t n = 0;
+    for (const auto pos : selection) {
+        const auto& value = values[pos];
+        const bool match = (value.getValueType() == valueType)
+                                   ? typedMatch(getNativeValue<T>(value))
+                                   : genericMatch(value);
+        if (match) selection[n++] = pos;
+    }
+    selection.resize(n);
+}
+
+/**
+ * Keeps selected rows for which values match.
+ * @param values Batch values.
+ * @param match Function checking value.
+ * @param[in,out] selection Selected rows.
+ */
+template<typename Match>
+void filterSelection(const Variant* values, Match match, Expression::SelectionVector& selection)
+{
+    std::size_t n = 0;
+    for (const auto pos : selection) {
+        if (match(values[pos])) selection[n++] = pos;
+    }
+    selection.resize(n);
+}
+
+/**
+ * Keeps selected rows for which comparison of the native values is true.
+ * @param values Batch values.
+ * @param type Comparison operator type, column value is the left operand.
+ * @param constant Constant of the native type.
+ * @param genericMatch Function checking values of other types, including NULLs.
+ * @param[in,out] selection Selected rows.
+ */
+template<typename T, typename GenericMatch>
+void filterSelectionByComparison(const Variant* values, ExpressionType type, T constant,
+        GenericMatch genericMatch, Expression::SelectionVector& selection)
+{
+    switch (type) {
+        case ExpressionType::kEqualPredicate: {
+            filterSelection<T>(
+                    values, [constant](T v) { return v == constant; }, genericMatch, selection);
+            break;
+        }
+        case ExpressionType::kNotEqualPredicate: {
+            filterSelection<T>(
+                    values, [constant](T v) { return v != constant; }, genericMatch, selection);
+            break;
+        }
+        case ExpressionType::kLessPredicate: {
+            filterSelection<T>(
+                    values, [constant](T v) { return v < constant; }, genericMatch, selection);
+            break;
+        }
+        case ExpressionType::kLessOrEqualPredicate: {
+            filterSelection<T>(
+                    values, [constant](T v) { return v <= constant; }, genericMatch, selection);
+            break;
+        }
+        case ExpressionType::kGreaterPredicate: {
+            filterSelection<T>(
+                    values, [constant](T v) { return v > constant; }, genericMatch, selection);
+            break;
+        }
+        case ExpressionType::kGreaterOrEqualPredicate: {
+            filterSelection<T>(
+                    values, [constant](T v) { return v >= constant; }, genericMatch, selection);
+            break;
+        }
+        default: throw std::invalid_argument("Invalid comparison operator type");
+    }
+}
+
+}  // anonymous namespace
+
+std::optional<BatchColumnValues> getBatchColumnValues(
+        const Expression& expression, Expression::BatchContext& context)
+{
+    if (expression.getType() != ExpressionType::kSingleColumnReference) return std::nullopt;
+    const auto& column = dynamic_cast<const SingleColumnExpression&>(expression);
+    const auto& tableIndex = column.getDatasetTableIndex();
+    const auto& columnIndex = column.getDatasetColumnIndex();
+    if (!tableIndex || !columnIndex) return std::nullopt;
+    const auto values = context.getBatchColumnValues(*tableIndex, *columnIndex);
+    if (!values) return std::nullopt;
+    return BatchColumnValues {values, convertColumnDataTypeToVariantType(context.getColumnDataType(
+                                              *tableIndex, *columnIndex))};
+}
+
+const Variant* getConstantValue(const Expression& expression) noexcept
+{
+    if (expression.getType() != ExpressionType::kConstant) return nullptr;
+    return &static_cast<const ConstantExpression&>(expression).getValue();
+}
+
+void filterBatchByComparison(const BatchColumnValues& column, ExpressionType type,
+        const Variant& constant, bool constantOnLeft, Expression::SelectionVector& selection)
+{
+    const auto genericMatch = [type, &constant, constantOnLeft](const Variant& value) {
+        return constantOnLeft ? compareVariants(type, constant, value)
+                              : compareVariants(type, value, constant);
+    };
+
+    const bool filtered = withNativeType(column.m_valueType, [&](auto tag) {
+        using T = typename decltype(tag)::Type;
+        const auto nativeConstant = convertConstant<T>(constant);
+        if (!nativeConstant) return false;
+        filterSelectionByComparison<T>(column.m_values,
+                constantOnLeft ? swapComparisonOperands(type) : type, *nativeConstant,
+                genericMatch, selection);
+        return true;
+    });
+    if (!filtered) filterSelection(column.m_values, genericMatch, selection);
+}
+
+void filterBatchByRange(const BatchColumnValues& column, const Variant& lowerBound,
+        const Variant& upperBound, bool notBetween, Expression::SelectionVector& selection)
+{
+    // Same as BetweenOperator::evaluate() does
+    const auto genericMatch = [&lowerBound, &upperBound, notBetween](const Variant& value) {
+        // TODO: SIODB-172
+        if (value.isNull() || lowerBound.isNull() || upperBound.isNull()) return false;
+        if (!value.isNumeric() && !(value.isString() || value.isDateTime())) {
+            throw std::runtime_error(
+                    "Expression value type isn't compatible with BETWEEN operator");
+        }
+        const bool valueIsBetween = lowerBound.compatibleLessOrEqual(value)
+                                    && upperBound.compatibleGreaterOrEqual(value);
+        return valueIsBetween != notBetween;
+    };
+
+    const bool filtered = withNativeType(column.m_valueType, [&](auto tag) {
+        using T = typename decltype(tag)::Type;
+        const auto lower = convertConstant<T>(lowerBound);
+        const auto upper = convertConstant<T>(upperBound);
+        if (!lower || !upper) return false;
+        filterSelection<T>(
+                column.m_values,
+                [lower = *lower, upper = *upper, notBetween](T v) {
+                    return (lower <= v && v <= upper) != notBetween;
+                },
+                genericMatch, selection);
+        return true;
+    });
+    if (!filtered) filterSelection(column.m_values, genericMatch, selection);
+}
+
+void filterBatchByList(const BatchColumnValues& column,
+        const std::vector<const Variant*>& constants, bool notIn,
+        Expression::SelectionVector& selection)
+{
+    // Same as InOperator::evaluate() does
+    const auto genericMatch = [&constants, notIn](const Variant& value) {
+        // TODO: SIODB-172
+        if (value.isNull()) return false;
+        const bool found = std::any_of(constants.cbegin(), constants.cend(),
+                [&value](const Variant* constant) {
+                    return !constant->isNull() && constant->compatibleEqual(value);
+                });
+        return found != notIn;
+    };
+
+    const bool filtered = withNativeType(column.m_valueType, [&](auto tag) {
+        using T = typename decltype(tag)::Type;
+        std::vector<T> nativeConstants;
+        nativeConstants.reserve(constants.size());
+        for (const auto constant : constants) {
+            // NULL never matches
+            if (constant->isNull()) continue;
+            const auto nativeConstant = convertConstant<T>(*constant);
+            if (!nativeConstant) return false;
+            nativeConstants.push_back(*nativeConstant);
+        }
+        std::sort(nativeConstants.begin(), nativeConstants.end());
+        filterSelection<T>(
+                column.m_values,
+                [&nativeConstants, notIn](T v) {
+                    return std::binary_search(nativeConstants.cbegin(), nativeConstants.cend(), v)
+                           != notIn;
+                },
+                genericMatch, selection);
+        return true;
+    });
+    if (!filtered) filterSelection(column.m_values, genericMatch, selection);
+}
+
+void filterBatchByIdentity(const BatchColumnValues& column, const Variant& constant, bool isNot,
+        Expression::SelectionVector& selection)
+{
+    // Same as IsOperator::evaluate() does
+    filterSelection(
+            column.m_values,
+            [&constant, isNot](const Variant& value) {
+                if (value.isNull() || constant.isNull())
+                    return isNot != (value.isNull() == constant.isNull());
+                return value.compatibleEqual(constant) != isNot;
+            },
+            selection);
+}
+
+}  // namespace siodb::iomgr::dbengine::requests
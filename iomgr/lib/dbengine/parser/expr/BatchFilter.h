@@ -0,0 +1,84 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "Expression.h"
+
+namespace siodb::iomgr::dbengine::requests {
+
+/** Column values of the batch referenced by expression */
+struct BatchColumnValues {
+    /** Values of the batch rows */
+    const Variant* m_values;
+
+    /** Value type of the column */
+    VariantType m_valueType;
+};
+
+/**
+ * Returns batch values of the column if expression is column reference.
+ * @param expression An expression.
+ * @param context Batch evaluation context.
+ * @return Column values or nothing if expression is not a column reference
+ *         or column values are not available.
+ */
+std::optional<BatchColumnValues> getBatchColumnValues(
+        const Expression& expression, Expression::BatchContext& context);
+
+/**
+ * Returns value of the expression if it is constant.
+ * @param expression An expression.
+ * @return Constant value or nullptr if expression is not constant.
+ */
+const Variant* getConstantValue(const Expression& expression) noexcept;
+
+/**
+ * Removes rows which don't satisfy comparison of the column value with the constant
+ * from the selection. Values are compared in the same way as comparison operators do.
+ * Values of the numeric column are compared in the type-specialized loop if constant
+ * can be converted to the column type exactly.
+ * @param column Column values.
+ * @param type Comparison operator type.
+ * @param constant Constant value.
+ * @param constantOnLeft Indicates that constant is the left operand.
+ * @param[in,out] selection Selected rows.
+ */
+void filterBatchByComparison(const BatchColumnValues& column, ExpressionType type,
+        const Variant& constant, bool constantOnLeft, Expression::SelectionVector& selection);
+
+/**
+ * Removes rows which don't satisfy BETWEEN predicate from the selection.
+ * @param column Column values.
+ * @param lowerBound Lower bound.
+ * @param upperBound Upper bound.
+ * @param notBetween Indicates NOT BETWEEN predicate.
+ * @param[in,out] selection Selected rows.
+ */
+void filterBatchByRange(const BatchColumnValues& column, const Variant& lowerBound,
+        const Variant& upperBound, bool notBetween, Expression::SelectionVector& selection);
+
+/**
+ * Removes rows which don't satisfy IN predicate from the selection.
+ * @param column Column values.
+ * @param constants List of constants.
+ * @param notIn Indicates NOT IN predicate.
+ * @param[in,out] selection Selected rows.
+ */
+void filterBatchByList(const BatchColumnValues& column,
+        const std::vector<const Variant*>& constants, bool notIn,
+        Expression::SelectionVector& selection);
+
+/**
+ * Removes rows which don't satisfy IS predicate from the selection.
+ * @param column Column values.
+ * @param constant Constant value.
+ * @param isNot Indicates IS NOT predicate.
+ * @param[in,out] selection Selected rows.
+ */
+void filterBatchByIdentity(const BatchColumnValues& column, const Variant& constant, bool isNot,
+        Expression::SelectionVector& selection);
+
+}  // namespace siodb::iomgr::dbengine::requests
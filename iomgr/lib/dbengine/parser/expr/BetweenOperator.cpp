@@ -4,6 +4,9 @@
 
 #include "BetweenOperator.h"
 
+// Project headers
+#include "BatchFilter.h"
+
 namespace siodb::iomgr::dbengine::requests {
 
 VariantType BetweenOperator::getResultValueType([[maybe_unused]] const Context& context) const
@@ -72,6 +75,17 @@ Variant BetweenOperator::evaluate(Context& context) const
     return valueIsBetween != m_notBetween;
 }
 
+bool BetweenOperator::evaluateBatch(BatchContext& context, SelectionVector& selection) const
+{
+    const auto lowerBound = getConstantValue(*m_middle);
+    const auto upperBound = getConstantValue(*m_right);
+    if (!lowerBound || !upperBound) return false;
+    const auto column = getBatchColumnValues(*m_left, context);
+    if (!column) return false;
+    filterBatchByRange(*column, *lowerBound, *upperBound, m_notBetween, selection);
+    return true;
+}
+
 std::uint8_t* BetweenOperator::serializeUnchecked(std::uint8_t* buffer) const
 {
     buffer = TernaryOperator::serializeUnchecked(buffer);
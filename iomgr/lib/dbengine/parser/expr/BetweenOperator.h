@@ -80,6 +80,14 @@ public:
      */
     Variant evaluate(Context& context) const override;
 
+    /**
+     * Evaluates expression as a condition for the batch of rows.
+     * @param context Batch evaluation context.
+     * @param[in,out] selection Selected rows.
+     * @return true if remaining rows surely match condition, false otherwise.
+     */
+    bool evaluateBatch(BatchContext& context, SelectionVector& selection) const override;
+
     /**
      * Serializes this expression, doesn't check memory buffer size.
      * @param buffer Memory buffer address.
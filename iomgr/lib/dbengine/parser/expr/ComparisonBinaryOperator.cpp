@@ -4,6 +4,9 @@
 
 #include "ComparisonBinaryOperator.h"
 
+// Project headers
+#include "BatchFilter.h"
+
 namespace siodb::iomgr::dbengine::requests {
 
 VariantType ComparisonBinaryOperator::getResultValueType(
@@ -18,4 +21,32 @@ ColumnDataType ComparisonBinaryOperator::getColumnDataType(
     return COLUMN_DATA_TYPE_BOOL;
 }
 
+bool ComparisonBinaryOperator::evaluateBatch(
+        BatchContext& context, SelectionVector& selection) const
+{
+    switch (m_type) {
+        case ExpressionType::kEqualPredicate:
+        case ExpressionType::kNotEqualPredicate:
+        case ExpressionType::kLessPredicate:
+        case ExpressionType::kLessOrEqualPredicate:
+        case ExpressionType::kGreaterPredicate:
+        case ExpressionType::kGreaterOrEqualPredicate: break;
+        default: return false;
+    }
+
+    // Only comparisons of the column with constant are supported
+    if (const auto constant = getConstantValue(*m_right)) {
+        if (const auto column = getBatchColumnValues(*m_left, context)) {
+            filterBatchByComparison(*column, m_type, *constant, false, selection);
+            return true;
+        }
+    } else if (const auto constant = getConstantValue(*m_left)) {
+        if (const auto column = getBatchColumnValues(*m_right, context)) {
+            filterBatchByComparison(*column, m_type, *constant, true, selection);
+            return true;
+        }
+    }
+    return false;
+}
+
 }  // namespace siodb::iomgr::dbengine::requests
\ No newline at end of file
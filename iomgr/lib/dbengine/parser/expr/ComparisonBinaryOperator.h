@@ -37,6 +37,14 @@ public:
      * @return Column data type.
      */
     ColumnDataType getColumnDataType(const Context& context) const override final;
+
+    /**
+     * Evaluates expression as a condition for the batch of rows.
+     * @param context Batch evaluation context.
+     * @param[in,out] selection Selected rows.
+     * @return true if remaining rows surely match condition, false otherwise.
+     */
+    bool evaluateBatch(BatchContext& context, SelectionVector& selection) const override;
 };
 
 }  // namespace siodb::iomgr::dbengine::requests
@@ -0,0 +1,651 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "CompiledExpression.h"
+
+// Project headers
+#include "BinaryOperator.h"
+#include "ConstantExpression.h"
+#include "NativeValueType.h"
+#include "SingleColumnExpression.h"
+#include "UnaryOperator.h"
+
+// STL headers
+#include <functional>
+
+namespace siodb::iomgr::dbengine::requests {
+
+/** Instruction handlers and their selection by the operand value types */
+struct CompiledExpression::InstructionHandlers {
+    /** Unary minus */
+    struct Negation {
+        template<typename T>
+        static auto apply(T value) noexcept
+        {
+            return -value;
+        }
+    };
+
+    /** Unary plus */
+    struct Identity {
+        template<typename T>
+        static auto apply(T value) noexcept
+        {
+            return +value;
+        }
+    };
+
+    /** Addition */
+    struct Addition {
+        template<typename L, typename R>
+        static constexpr bool isSupported() noexcept
+        {
+            return true;
+        }
+
+        template<typename L, typename R>
+        static auto apply(L left, R right) noexcept
+        {
+            return left + right;
+        }
+    };
+
+    /** Subtraction */
+    struct Subtraction {
+        template<typename L, typename R>
+        static constexpr bool isSupported() noexcept
+        {
+            return true;
+        }
+
+        template<typename L, typename R>
+        static auto apply(L left, R right) noexcept
+        {
+            return left - right;
+        }
+    };
+
+    /** Multiplication */
+    struct Multiplication {
+        template<typename L, typename R>
+        static constexpr bool isSupported() noexcept
+        {
+            return true;
+        }
+
+        template<typename L, typename R>
+        static auto apply(L left, R right) noexcept
+        {
+            return left * right;
+        }
+    };
+
+    /** Division */
+    struct Division {
+        template<typename L, typename R>
+        static constexpr bool isSupported() noexcept
+        {
+            return true;
+        }
+
+        template<typename L, typename R>
+        static auto apply(L left, R right) noexcept
+        {
+            return left / right;
+        }
+    };
+
+    /** Modulo, defined only for integers */
+    struct Modulo {
+        template<typename L, typename R>
+        static constexpr bool isSupported() noexcept
+        {
+            return std::is_integral_v<L> && std::is_integral_v<R>;
+        }
+
+        template<typename L, typename R>
+        static auto apply(L left, R right) noexcept
+        {
+            return left % right;
+        }
+    };
+
+    /**
+     * Returns register value.
+     * @param reg Register.
+     * @return Register value reference.
+     */
+    template<typename T>
+    static T& getValue(Register& reg) noexcept
+    {
+        if constexpr (std::is_same_v<T, bool>)
+            return reg.m_value.m_bool;
+        else if constexpr (std::is_same_v<T, std::int8_t>)
+            return reg.m_value.m_int8;
+        else if constexpr (std::is_same_v<T, std::uint8_t>)
+            return reg.m_value.m_uint8;
+        else if constexpr (std::is_same_v<T, std::int16_t>)
+            return reg.m_value.m_int16;
+        else if constexpr (std::is_same_v<T, std::uint16_t>)
+            return reg.m_value.m_uint16;
+        else if constexpr (std::is_same_v<T, std::int32_t>)
+            return reg.m_value.m_int32;
+        else if constexpr (std::is_same_v<T, std::uint32_t>)
+            return reg.m_value.m_uint32;
+        else if constexpr (std::is_same_v<T, std::int64_t>)
+            return reg.m_value.m_int64;
+        else if constexpr (std::is_same_v<T, std::uint64_t>)
+            return reg.m_value.m_uint64;
+        else if constexpr (std::is_same_v<T, float>)
+            return reg.m_value.m_float;
+        else
+            return reg.m_value.m_double;
+    }
+
+    /**
+     * Returns register value.
+     * @param reg Register.
+     * @return Register value.
+     */
+    template<typename T>
+    static T getValue(const Register& reg) noexcept
+    {
+        return getValue<T>(const_cast<Register&>(reg));
+    }
+
+    /**
+     * Compares native values in the same way as Variant::compatibleXXX() functions do.
+     * Large unsigned integers are cast to signed type when compared with signed integers,
+     * float values are converted to double.
+     * @param left Left value.
+     * @param right Right value.
+     * @return Comparison result.
+     */
+    template<typename Compare, typename L, typename R>
+    static bool compareValues(L left, R right) noexcept
+    {
+        constexpr bool isLeftSigned = std::is_integral_v<L> && std::is_signed_v<L>;
+        constexpr bool isRightSigned = std::is_integral_v<R> && std::is_signed_v<R>;
+        if constexpr (std::is_same_v<L, float> || std::is_same_v<R, float>)
+            return Compare()(static_cast<double>(left), static_cast<double>(right));
+        else if constexpr (std::is_same_v<L, std::uint32_t> && isRightSigned)
+            return Compare()(static_cast<std::int32_t>(left), right);
+        else if constexpr (std::is_same_v<L, std::uint64_t> && isRightSigned)
+            return Compare()(static_cast<std::int64_t>(left), right);
+        else if constexpr (isLeftSigned && sizeof(L) <= 4 && std::is_same_v<R, std::uint32_t>)
+            return Compare()(left, static_cast<std::int32_t>(right));
+        else if constexpr (isLeftSigned && std::is_same_v<R, std::uint64_t>)
+            return Compare()(left, static_cast<std::int64_t>(right));
+        else
+            return Compare()(left, right);
+    }
+
+    /** Loads column value into the register. */
+    template<typename T>
+    static bool loadColumn(const Instruction& instruction, Register* registers,
+            Expression::Context& context)
+    {
+        const auto& value =
+                context.getColumnValue(instruction.m_tableIndex, instruction.m_columnIndex);
+        auto& result = registers[instruction.m_result];
+        result.m_null = value.isNull();
+        if (result.m_null) return true;
+        if constexpr (std::is_same_v<T, bool>) {
+            if (!value.isBool()) throw WrongVariantTypeError(value.getValueType());
+            result.m_value.m_bool = value.getBool();
+        } else {
+            if (value.getValueType() != getNativeValueType<T>())
+                throw WrongVariantTypeError(value.getValueType());
+            getValue<T>(result) = getNativeValue<T>(value);
+        }
+        return true;
+    }
+
+    /** Evaluates unary operator. */
+    template<typename Operation, typename T>
+    static bool evaluateUnary(const Instruction& instruction, Register* registers,
+            [[maybe_unused]] Expression::Context& context) noexcept
+    {
+        const auto& operand = registers[instruction.m_left];
+        auto& result = registers[instruction.m_result];
+        result.m_null = operand.m_null;
+        if (!result.m_null) {
+            using ResultType = decltype(Operation::apply(T()));
+            getValue<ResultType>(result) = Operation::apply(getValue<T>(operand));
+        }
+        return true;
+    }
+
+    /** Evaluates binary arithmetic operator. */
+    template<typename Operation, typename L, typename R>
+    static bool evaluateBinary(const Instruction& instruction, Register* registers,
+            [[maybe_unused]] Expression::Context& context) noexcept
+    {
+        const auto& left = registers[instruction.m_left];
+        const auto& right = registers[instruction.m_right];
+        auto& result = registers[instruction.m_result];
+        result.m_null = left.m_null || right.m_null;
+        if (!result.m_null) {
+            using ResultType = decltype(Operation::apply(L(), R()));
+            getValue<ResultType>(result) =
+                    Operation::apply(getValue<L>(left), getValue<R>(right));
+        }
+        return true;
+    }
+
+    /** Evaluates comparison operator. */
+    template<typename Compare, typename L, typename R>
+    static bool evaluateComparison(const Instruction& instruction, Register* registers,
+            [[maybe_unused]] Expression::Context& context)
+    {
+        const auto& left = registers[instruction.m_left];
+        const auto& right = registers[instruction.m_right];
+        auto& result = registers[instruction.m_result];
+        result.m_null = false;
+        if (left.m_null || right.m_null) {
+            if constexpr (std::is_same_v<Compare, std::equal_to<>>) {
+                // Equality operator has no special NULL handling,
+                // Variant::compatibleEqual() fails if only right value is NULL.
+                if (!left.m_null) {
+                    result.m_value.m_bool = Variant(getValue<L>(left)).compatibleEqual(Variant());
+                    return true;
+                }
+            }
+            result.m_value.m_bool = false;
+            return true;
+        }
+        result.m_value.m_bool = compareValues<Compare>(getValue<L>(left), getValue<R>(right));
+        return true;
+    }
+
+    /** Evaluates left operand of AND operator, skips right one if result is known. */
+    static bool evaluateAndLeft(const Instruction& instruction, Register* registers,
+            [[maybe_unused]] Expression::Context& context) noexcept
+    {
+        const auto& left = registers[instruction.m_left];
+        if (!left.m_null && left.m_value.m_bool) return true;
+        registers[instruction.m_result] = left;
+        return false;
+    }
+
+    /** Evaluates left operand of OR operator, skips right one if result is known. */
+    static bool evaluateOrLeft(const Instruction& instruction, Register* registers,
+            [[maybe_unused]] Expression::Context& context) noexcept
+    {
+        const auto& left = registers[instruction.m_left];
+        if (!left.m_null && !left.m_value.m_bool) return true;
+        registers[instruction.m_result] = left;
+        return false;
+    }
+
+    /** Evaluates NOT operator. */
+    static bool evaluateNot(const Instruction& instruction, Register* registers,
+            [[maybe_unused]] Expression::Context& context) noexcept
+    {
+        const auto& operand = registers[instruction.m_left];
+        auto& result = registers[instruction.m_result];
+        result.m_null = operand.m_null;
+        result.m_value.m_bool = !operand.m_value.m_bool;
+        return true;
+    }
+
+    /** Copies register. */
+    static bool copyRegister(const Instruction& instruction, Register* registers,
+            [[maybe_unused]] Expression::Context& context) noexcept
+    {
+        registers[instruction.m_result] = registers[instruction.m_left];
+        return true;
+    }
+
+    /** Evaluates condition by the expression object. */
+    static bool evaluateCondition(
+            const Instruction& instruction, Register* registers, Expression::Context& context)
+    {
+        const auto value = instruction.m_expression->evaluate(context);
+        auto& result = registers[instruction.m_result];
+        result.m_null = value.isNull();
+        if (!result.m_null) {
+            if (!value.isBool()) throw std::runtime_error(instruction.m_errorMessage);
+            result.m_value.m_bool = value.getBool();
+        }
+        return true;
+    }
+
+    /**
+     * Selects column load handler.
+     * @param valueType Column value type.
+     * @return Handler or nullptr if value type is not supported.
+     */
+    static InstructionHandler selectLoadColumn(VariantType valueType) noexcept
+    {
+        if (valueType == VariantType::kBool) return &loadColumn<bool>;
+        InstructionHandler handler = nullptr;
+        withNativeType(valueType, [&handler](auto tag) noexcept {
+            handler = &loadColumn<typename decltype(tag)::Type>;
+            return true;
+        });
+        return handler;
+    }
+
+    /**
+     * Adds unary operator instruction.
+     * @param program Compiled expression.
+     * @param operand Operand.
+     * @return Result operand or nothing if operand type is not supported.
+     */
+    template<typename Operation>
+    static std::optional<Operand> addUnary(CompiledExpression& program, const Operand& operand)
+    {
+        std::optional<Operand> result;
+        withNativeType(operand.m_valueType, [&](auto tag) {
+            using T = typename decltype(tag)::Type;
+            using ResultType = decltype(Operation::apply(T()));
+            result = program.addRegister(getNativeValueType<ResultType>());
+            program.addInstruction(
+                    &evaluateUnary<Operation, T>, result->m_register, operand.m_register);
+            return true;
+        });
+        return result;
+    }
+
+    /**
+     * Adds binary arithmetic operator instruction.
+     * @param program Compiled expression.
+     * @param left Left operand.
+     * @param right Right operand.
+     * @return Result operand or nothing if operand types are not supported.
+     */
+    template<typename Operation>
+    static std::optional<Operand> addBinary(
+            CompiledExpression& program, const Operand& left, const Operand& right)
+    {
+        std::optional<Operand> result;
+        withNativeType(left.m_valueType, [&](auto leftTag) {
+            return withNativeType(right.m_valueType, [&](auto rightTag) {
+                using L = typename decltype(leftTag)::Type;
+                using R = typename decltype(rightTag)::Type;
+                if constexpr (Operation::template isSupported<L, R>()) {
+                    using ResultType = decltype(Operation::apply(L(), R()));
+                    result = program.addRegister(getNativeValueType<ResultType>());
+                    program.addInstruction(&evaluateBinary<Operation, L, R>,
+                            result->m_register, left.m_register, right.m_register);
+                    return true;
+                } else
+                    return false;
+            });
+        });
+        return result;
+    }
+
+    /**
+     * Adds comparison operator instruction.
+     * @param program Compiled expression.
+     * @param left Left operand.
+     * @param right Right operand.
+     * @return Result operand or nothing if operand types are not supported.
+     */
+    template<typename Compare>
+    static std::optional<Operand> addComparison(
+            CompiledExpression& program, const Operand& left, const Operand& right)
+    {
+        InstructionHandler handler = nullptr;
+        if (left.m_valueType == VariantType::kBool && right.m_valueType == VariantType::kBool) {
+            // Boolean values are only checked for equality
+            if constexpr (std::is_same_v<Compare, std::equal_to<>>
+                          || std::is_same_v<Compare, std::not_equal_to<>>)
+                handler = &evaluateComparison<Compare, bool, bool>;
+        } else {
+            withNativeType(left.m_valueType, [&](auto leftTag) {
+                return withNativeType(right.m_valueType, [&](auto rightTag) {
+                    using L = typename decltype(leftTag)::Type;
+                    using R = typename decltype(rightTag)::Type;
+                    handler = &evaluateComparison<Compare, L, R>;
+                    return true;
+                });
+            });
+        }
+        if (!handler) return std::nullopt;
+        const auto result = program.addRegister(VariantType::kBool);
+        program.addInstruction(handler, result.m_register, left.m_register, right.m_register);
+        return result;
+    }
+};
+
+std::unique_ptr<CompiledExpression> CompiledExpression::compile(
+        const Expression& expression, const Expression::Context& context)
+{
+    std::unique_ptr<CompiledExpression> program(new CompiledExpression());
+    const auto result = program->compileExpression(expression, context);
+    if (!result) return nullptr;
+    program->m_resultRegister = result->m_register;
+    program->m_resultType = result->m_valueType;
+    return program;
+}
+
+Variant CompiledExpression::evaluate(Expression::Context& context)
+{
+    const auto registers = m_registers.data();
+    const auto instructionCount = m_instructions.size();
+    for (std::size_t pos = 0; pos < instructionCount;) {
+        const auto& instruction = m_instructions[pos];
+        pos = instruction.m_handler(instruction, registers, context) ? pos + 1
+                                                                    : instruction.m_jumpTarget;
+    }
+
+    const auto& result = m_registers[m_resultRegister];
+    if (result.m_null) return Variant();
+    if (m_resultType == VariantType::kBool) return result.m_value.m_bool;
+    Variant value;
+    withNativeType(m_resultType, [&value, &result](auto tag) noexcept {
+        value = InstructionHandlers::getValue<typename decltype(tag)::Type>(result);
+        return true;
+    });
+    return value;
+}
+
+// ----- internals -----
+
+std::optional<CompiledExpression::Operand> CompiledExpression::compileExpression(
+        const Expression& expression, const Expression::Context& context)
+{
+    const auto type = expression.getType();
+    switch (type) {
+        case ExpressionType::kConstant: {
+            const auto& value = static_cast<const ConstantExpression&>(expression).getValue();
+            const auto valueType = value.getValueType();
+            if (valueType == VariantType::kBool) {
+                const auto result = addRegister(valueType);
+                m_registers[result.m_register].m_value.m_bool = value.getBool();
+                return result;
+            }
+            std::optional<Operand> result;
+            withNativeType(valueType, [&](auto tag) {
+                using T = typename decltype(tag)::Type;
+                result = addRegister(valueType);
+                InstructionHandlers::getValue<T>(m_registers[result->m_register]) =
+                        getNativeValue<T>(value);
+                return true;
+            });
+            return result;
+        }
+
+        case ExpressionType::kSingleColumnReference: {
+            const auto& column = static_cast<const SingleColumnExpression&>(expression);
+            const auto& tableIndex = column.getDatasetTableIndex();
+            const auto& columnIndex = column.getDatasetColumnIndex();
+            if (!tableIndex || !columnIndex) return std::nullopt;
+            VariantType valueType;
+            try {
+                valueType = convertColumnDataTypeToVariantType(
+                        context.getColumnDataType(*tableIndex, *columnIndex));
+            } catch (std::invalid_argument&) {
+                return std::nullopt;
+            }
+            const auto handler = InstructionHandlers::selectLoadColumn(valueType);
+            if (!handler) return std::nullopt;
+            const auto result = addRegister(valueType);
+            auto& instruction = addInstruction(handler, result.m_register);
+            instruction.m_tableIndex = *tableIndex;
+            instruction.m_columnIndex = *columnIndex;
+            return result;
+        }
+
+        case ExpressionType::kUnaryMinusOperator:
+        case ExpressionType::kUnaryPlusOperator: {
+            const auto& op = static_cast<const UnaryOperator&>(expression);
+            const auto operand = compileExpression(op.getOperand(), context);
+            if (!operand) return std::nullopt;
+            return type == ExpressionType::kUnaryMinusOperator
+                           ? InstructionHandlers::addUnary<InstructionHandlers::Negation>(
+                                   *this, *operand)
+                           : InstructionHandlers::addUnary<InstructionHandlers::Identity>(
+                                   *this, *operand);
+        }
+
+        case ExpressionType::kAddOperator:
+        case ExpressionType::kSubtractOperator:
+        case ExpressionType::kMultiplyOperator:
+        case ExpressionType::kDivideOperator:
+        case ExpressionType::kModuloOperator: {
+            const auto& op = static_cast<const BinaryOperator&>(expression);
+            const auto left = compileExpression(op.getLeftOperand(), context);
+            if (!left) return std::nullopt;
+            const auto right = compileExpression(op.getRightOperand(), context);
+            if (!right) return std::nullopt;
+            return compileArithmeticOperator(type, *left, *right);
+        }
+
+        case ExpressionType::kEqualPredicate:
+        case ExpressionType::kNotEqualPredicate:
+        case ExpressionType::kLessPredicate:
+        case ExpressionType::kLessOrEqualPredicate:
+        case ExpressionType::kGreaterPredicate:
+        case ExpressionType::kGreaterOrEqualPredicate: {
+            const auto& op = static_cast<const BinaryOperator&>(expression);
+            const auto left = compileExpression(op.getLeftOperand(), context);
+            if (!left) return std::nullopt;
+            const auto right = compileExpression(op.getRightOperand(), context);
+            if (!right) return std::nullopt;
+            return compileComparisonOperator(type, *left, *right);
+        }
+
+        case ExpressionType::kLogicalAndOperator:
+        case ExpressionType::kLogicalOrOperator: {
+            const auto& op = static_cast<const BinaryOperator&>(expression);
+            const auto left =
+                    compileCondition(op.getLeftOperand(), context, "Left value isn't bool");
+            const auto result = addRegister(VariantType::kBool);
+            const auto jumpPos = m_instructions.size();
+            addInstruction(type == ExpressionType::kLogicalAndOperator
+                                   ? &InstructionHandlers::evaluateAndLeft
+                                   : &InstructionHandlers::evaluateOrLeft,
+                    result.m_register, left.m_register);
+            const auto right =
+                    compileCondition(op.getRightOperand(), context, "Right value isn't bool");
+            addInstruction(&InstructionHandlers::copyRegister, result.m_register, right.m_register);
+            m_instructions[jumpPos].m_jumpTarget = m_instructions.size();
+            return result;
+        }
+
+        case ExpressionType::kLogicalNotOperator: {
+            const auto& op = static_cast<const UnaryOperator&>(expression);
+            const auto operand =
+                    compileCondition(op.getOperand(), context, "NOT operator: Value isn't bool");
+            const auto result = addRegister(VariantType::kBool);
+            addInstruction(
+                    &InstructionHandlers::evaluateNot, result.m_register, operand.m_register);
+            return result;
+        }
+
+        default: return std::nullopt;
+    }
+}
+
+CompiledExpression::Operand CompiledExpression::compileCondition(const Expression& expression,
+        const Expression::Context& context, const char* errorMessage)
+{
+    const auto instructionCount = m_instructions.size();
+    const auto registerCount = m_registers.size();
+    const auto operand = compileExpression(expression, context);
+    if (operand && operand->m_valueType == VariantType::kBool) return *operand;
+
+    // Discard partially compiled operand, let expression object evaluate it
+    m_instructions.resize(instructionCount);
+    m_registers.resize(registerCount);
+    const auto result = addRegister(VariantType::kBool);
+    auto& instruction = addInstruction(&InstructionHandlers::evaluateCondition, result.m_register);
+    instruction.m_expression = &expression;
+    instruction.m_errorMessage = errorMessage;
+    return result;
+}
+
+std::optional<CompiledExpression::Operand> CompiledExpression::compileArithmeticOperator(
+        ExpressionType type, const Operand& left, const Operand& right)
+{
+    switch (type) {
+        case ExpressionType::kAddOperator:
+            return InstructionHandlers::addBinary<InstructionHandlers::Addition>(
+                    *this, left, right);
+        case ExpressionType::kSubtractOperator:
+            return InstructionHandlers::addBinary<InstructionHandlers::Subtraction>(
+                    *this, left, right);
+        case ExpressionType::kMultiplyOperator:
+            return InstructionHandlers::addBinary<InstructionHandlers::Multiplication>(
+                    *this, left, right);
+        case ExpressionType::kDivideOperator:
+            return InstructionHandlers::addBinary<InstructionHandlers::Division>(
+                    *this, left, right);
+        case ExpressionType::kModuloOperator:
+            return InstructionHandlers::addBinary<InstructionHandlers::Modulo>(
+                    *this, left, right);
+        default: return std::nullopt;
+    }
+}
+
+std::optional<CompiledExpression::Operand> CompiledExpression::compileComparisonOperator(
+        ExpressionType type, const Operand& left, const Operand& right)
+{
+    switch (type) {
+        case ExpressionType::kEqualPredicate:
+            return InstructionHandlers::addComparison<std::equal_to<>>(*this, left, right);
+        case ExpressionType::kNotEqualPredicate:
+            return InstructionHandlers::addComparison<std::not_equal_to<>>(*this, left, right);
+        case ExpressionType::kLessPredicate:
+            return InstructionHandlers::addComparison<std::less<>>(*this, left, right);
+        case ExpressionType::kLessOrEqualPredicate:
+            return InstructionHandlers::addComparison<std::less_equal<>>(*this, left, right);
+        case ExpressionType::kGreaterPredicate:
+            return InstructionHandlers::addComparison<std::greater<>>(*this, left, right);
+        case ExpressionType::kGreaterOrEqualPredicate:
+            return InstructionHandlers::addComparison<std::greater_equal<>>(*this, left, right);
+        default: return std::nullopt;
+    }
+}
+
+CompiledExpression::Operand CompiledExpression::addRegister(VariantType valueType)
+{
+    Register reg;
+    reg.m_value.m_uint64 = 0;
+    reg.m_null = false;
+    m_registers.push_back(reg);
+    return Operand {static_cast<std::uint32_t>(m_registers.size() - 1), valueType};
+}
+
+CompiledExpression::Instruction& CompiledExpression::addInstruction(
+        InstructionHandler handler, std::uint32_t result, std::uint32_t left, std::uint32_t right)
+{
+    Instruction instruction;
+    instruction.m_handler = handler;
+    instruction.m_result = result;
+    instruction.m_left = left;
+    instruction.m_right = right;
+    instruction.m_jumpTarget = 0;
+    instruction.m_tableIndex = 0;
+    instruction.m_columnIndex = 0;
+    instruction.m_expression = nullptr;
+    instruction.m_errorMessage = nullptr;
+    return m_instructions.emplace_back(instruction);
+}
+
+}  // namespace siodb::iomgr::dbengine::requests
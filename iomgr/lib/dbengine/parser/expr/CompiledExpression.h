@@ -0,0 +1,201 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "Expression.h"
+
+// STL headers
+#include <optional>
+
+namespace siodb::iomgr::dbengine::requests {
+
+/**
+ * Expression compiled into a flat program of type-specialized instructions.
+ * Value types of the operands are resolved once at compile time, so evaluation
+ * of the row doesn't dispatch on the variant types and doesn't call expression
+ * objects recursively. Results are the same as results of Expression::evaluate(),
+ * including result value types. Subexpressions which can't be compiled, but are
+ * operands of the logical operators, are evaluated by the expression objects.
+ */
+class CompiledExpression {
+public:
+    /**
+     * Compiles expression. Expression must be already validated.
+     * @param expression An expression.
+     * @param context Evaluation context, used to resolve column data types.
+     * @return Compiled expression or nullptr if expression can't be compiled.
+     */
+    static std::unique_ptr<CompiledExpression> compile(
+            const Expression& expression, const Expression::Context& context);
+
+    /**
+     * Evaluates expression for the current row of the context.
+     * @param context Evaluation context.
+     * @return Resulting value.
+     */
+    Variant evaluate(Expression::Context& context);
+
+private:
+    /** Register value */
+    union RegisterValue {
+        bool m_bool;
+        std::int8_t m_int8;
+        std::uint8_t m_uint8;
+        std::int16_t m_int16;
+        std::uint16_t m_uint16;
+        std::int32_t m_int32;
+        std::uint32_t m_uint32;
+        std::int64_t m_int64;
+        std::uint64_t m_uint64;
+        float m_float;
+        double m_double;
+    };
+
+    /** Register which holds intermediate value of the known value type */
+    struct Register {
+        /** Value, valid if not NULL */
+        RegisterValue m_value;
+
+        /** NULL flag */
+        bool m_null;
+    };
+
+    /** Program instruction */
+    struct Instruction;
+
+    /**
+     * Instruction handler.
+     * @param instruction Instruction.
+     * @param registers Registers.
+     * @param context Evaluation context.
+     * @return true to continue with the next instruction, false to jump to the jump target.
+     */
+    using InstructionHandler = bool (*)(
+            const Instruction& instruction, Register* registers, Expression::Context& context);
+
+    /** Program instruction */
+    struct Instruction {
+        /** Handler */
+        InstructionHandler m_handler;
+
+        /** Result register */
+        std::uint32_t m_result;
+
+        /** Left or single operand register */
+        std::uint32_t m_left;
+
+        /** Right operand register */
+        std::uint32_t m_right;
+
+        /** Position of the next instruction, if handler requests jump */
+        std::size_t m_jumpTarget;
+
+        /** Table index of the column */
+        std::size_t m_tableIndex;
+
+        /** Column index */
+        std::size_t m_columnIndex;
+
+        /** Expression evaluated by the expression object */
+        const Expression* m_expression;
+
+        /** Error message if result of the evaluated expression is not boolean */
+        const char* m_errorMessage;
+    };
+
+    /** Compiled subexpression */
+    struct Operand {
+        /** Register holding result */
+        std::uint32_t m_register;
+
+        /** Result value type */
+        VariantType m_valueType;
+    };
+
+    /** Instruction handlers */
+    struct InstructionHandlers;
+
+private:
+    /** Initializes object of class CompiledExpression. */
+    CompiledExpression() noexcept
+        : m_resultRegister(0)
+        , m_resultType(VariantType::kNull)
+    {
+    }
+
+    /**
+     * Compiles subexpression.
+     * @param expression An expression.
+     * @param context Evaluation context.
+     * @return Compiled subexpression or nothing if it can't be compiled.
+     */
+    std::optional<Operand> compileExpression(
+            const Expression& expression, const Expression::Context& context);
+
+    /**
+     * Compiles operand of the logical operator. If operand can't be compiled
+     * into boolean value, its value is obtained by the expression object.
+     * @param expression An expression.
+     * @param context Evaluation context.
+     * @param errorMessage Error message if operand value is not boolean.
+     * @return Compiled operand.
+     */
+    Operand compileCondition(const Expression& expression,
+            const Expression::Context& context, const char* errorMessage);
+
+    /**
+     * Compiles arithmetic operator.
+     * @param type Operator type.
+     * @param left Left operand.
+     * @param right Right operand.
+     * @return Compiled operator or nothing if operand types aren't supported.
+     */
+    std::optional<Operand> compileArithmeticOperator(
+            ExpressionType type, const Operand& left, const Operand& right);
+
+    /**
+     * Compiles comparison operator.
+     * @param type Operator type.
+     * @param left Left operand.
+     * @param right Right operand.
+     * @return Compiled operator or nothing if operand types aren't supported.
+     */
+    std::optional<Operand> compileComparisonOperator(
+            ExpressionType type, const Operand& left, const Operand& right);
+
+    /**
+     * Allocates new register.
+     * @param valueType Value type.
+     * @return Register operand.
+     */
+    Operand addRegister(VariantType valueType);
+
+    /**
+     * Adds instruction.
+     * @param handler Instruction handler.
+     * @param result Result register.
+     * @param left Left or single operand register.
+     * @param right Right operand register.
+     * @return Added instruction.
+     */
+    Instruction& addInstruction(InstructionHandler handler, std::uint32_t result,
+            std::uint32_t left = 0, std::uint32_t right = 0);
+
+private:
+    /** Instructions */
+    std::vector<Instruction> m_instructions;
+
+    /** Registers, constants are preloaded */
+    std::vector<Register> m_registers;
+
+    /** Result register */
+    std::uint32_t m_resultRegister;
+
+    /** Result value type */
+    VariantType m_resultType;
+};
+
+}  // namespace siodb::iomgr::dbengine::requests
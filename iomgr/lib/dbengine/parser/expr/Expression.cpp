@@ -9,6 +9,12 @@
 
 namespace siodb::iomgr::dbengine::requests {
 
+const Variant& Expression::Context::getAggregateValue(
+        [[maybe_unused]] std::size_t aggregateIndex)
+{
+    throw std::runtime_error("Aggregate functions are not allowed in this context");
+}
+
 bool Expression::isConstant() const noexcept
 {
     return false;
@@ -34,6 +40,12 @@ bool Expression::canCastAsDateTime(const Context& context) const noexcept
     return isDateTimeType(getResultValueType(context));
 }
 
+bool Expression::evaluateBatch(
+        [[maybe_unused]] BatchContext& context, [[maybe_unused]] SelectionVector& selection) const
+{
+    return false;
+}
+
 namespace {
 
 template<class ExprT>
@@ -352,6 +364,25 @@ std::size_t Expression::deserialize(
                    + deserializeBinaryExpression<CastOperator>(
                            buffer + consumed, length - consumed, result);
         }
+        case ExpressionType::kMaxFunction:
+        case ExpressionType::kMinFunction:
+        case ExpressionType::kSumFunction:
+        case ExpressionType::kAvgFunction:
+        case ExpressionType::kCountFunction: {
+            if (SIODB_UNLIKELY(consumed == length))
+                throw VariantDeserializationError("Not enough data for the argument attribute");
+            if (SIODB_UNLIKELY(buffer[consumed] > 1))
+                throw VariantDeserializationError("Invalid argument attribute");
+            const bool hasArgument = buffer[consumed++] == 1;
+
+            ExpressionPtr argument;
+            if (hasArgument)
+                consumed += Expression::deserialize(buffer + consumed, length - consumed, argument);
+
+            result = std::make_unique<AggregateFunction>(
+                    static_cast<ExpressionType>(expressionType), std::move(argument));
+            return consumed;
+        }
         default: {
             throw std::runtime_error("Deserailization of the expression type #"
                                      + std::to_string(expressionType) + " is not supported");
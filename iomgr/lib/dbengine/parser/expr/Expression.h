@@ -52,8 +52,32 @@ public:
          */
         virtual ColumnDataType getColumnDataType(
                 std::size_t tableIndex, std::size_t columnIndex) const = 0;
+
+        /**
+         * Returns value of the aggregate function for the current group of rows.
+         * @param aggregateIndex Aggregate function index.
+         * @return Aggregate function value.
+         * @throw std::runtime_error if aggregate values are not available in this context.
+         */
+        virtual const Variant& getAggregateValue(std::size_t aggregateIndex);
+    };
+
+    /** Expression evaluation context, which provides values of the batch of rows */
+    class BatchContext : public Context {
+    public:
+        /**
+         * Returns values of the column for the rows of the current batch.
+         * @param tableIndex Table index.
+         * @param columnIndex Column index.
+         * @return Address of the column values or nullptr if batch values are not available.
+         */
+        virtual const Variant* getBatchColumnValues(
+                std::size_t tableIndex, std::size_t columnIndex) = 0;
     };
 
+    /** Positions of the selected rows in the batch, in ascending order */
+    using SelectionVector = std::vector<std::uint32_t>;
+
     /** De-initializes object of class Expression. */
     virtual ~Expression() = default;
 
@@ -156,6 +180,17 @@ public:
      */
     virtual Variant evaluate(Context& context) const = 0;
 
+    /**
+     * Evaluates expression as a condition for the batch of rows. Removes rows for which
+     * condition is not true from the selection. Rows are removed only if they surely
+     * don't match, so if batch evaluation is not fully supported, remaining rows
+     * must be checked by evaluating expression for each row.
+     * @param context Batch evaluation context.
+     * @param[in,out] selection Selected rows.
+     * @return true if remaining rows surely match condition, false otherwise.
+     */
+    virtual bool evaluateBatch(BatchContext& context, SelectionVector& selection) const;
+
     /**
      * Serializes this expression, doesn't check memory buffer size.
      * @param buffer Memory buffer address.
@@ -64,10 +64,7 @@ requests::ExpressionPtr ExpressionFactory::createExpression(antlr4::tree::ParseT
             }
             throw std::runtime_error("Expression is invalid");
         }
-        case SiodbParser::RuleFunction_call: {
-            // TODO: Support functions
-            throw std::runtime_error("Functions aren't not supported now");
-        }
+        case SiodbParser::RuleFunction_call: return createFunctionCall(node);
         case SiodbParser::RuleSimple_expr: return createSimpleExpression(node);
         default: break;
     }
@@ -454,6 +451,58 @@ requests::ExpressionPtr ExpressionFactory::createLogicalBinaryOperator(
     }
 }
 
+requests::ExpressionPtr ExpressionFactory::createFunctionCall(antlr4::tree::ParseTree* node) const
+{
+    const auto functionNameNode = node->children.at(0);
+    if (!m_allowColumnExpressions) {
+        throw std::invalid_argument(utils::StringBuilder()
+                                    << "Function " << functionNameNode->getText()
+                                    << " is not allowed in this context");
+    }
+
+    const auto functionName =
+            boost::to_upper_copy(helpers::getAnyNameText(functionNameNode->children.at(0)));
+    requests::ExpressionType type;
+    if (functionName == "COUNT")
+        type = requests::ExpressionType::kCountFunction;
+    else if (functionName == "SUM")
+        type = requests::ExpressionType::kSumFunction;
+    else if (functionName == "MIN")
+        type = requests::ExpressionType::kMinFunction;
+    else if (functionName == "MAX")
+        type = requests::ExpressionType::kMaxFunction;
+    else if (functionName == "AVG")
+        type = requests::ExpressionType::kAvgFunction;
+    else
+        throw std::runtime_error("Function " + functionName + " is not supported");
+
+    // Arguments are between parentheses
+    std::vector<antlr4::tree::ParseTree*> argumentNodes;
+    bool allRows = false;
+    for (std::size_t i = 2; i + 1 < node->children.size(); ++i) {
+        const auto childNode = node->children[i];
+        if (helpers::getNonTerminalType(childNode) == SiodbParser::RuleExpr) {
+            argumentNodes.push_back(childNode);
+            continue;
+        }
+        const auto terminalType = helpers::getTerminalType(childNode);
+        if (terminalType == SiodbParser::K_DISTINCT)
+            throw std::runtime_error("Function " + functionName + ": DISTINCT is not supported");
+        allRows |= terminalType == SiodbParser::STAR;
+    }
+
+    if (allRows) {
+        if (type != requests::ExpressionType::kCountFunction)
+            throw std::runtime_error("Function " + functionName + " doesn't accept *");
+        return std::make_unique<requests::AggregateFunction>(type, nullptr);
+    }
+
+    if (argumentNodes.size() != 1)
+        throw std::runtime_error("Function " + functionName + " requires single argument");
+    return std::make_unique<requests::AggregateFunction>(
+            type, createExpression(argumentNodes.front()));
+}
+
 requests::ExpressionPtr ExpressionFactory::createSimpleExpression(
         antlr4::tree::ParseTree* node) const
 {
@@ -467,6 +516,8 @@ requests::ExpressionPtr ExpressionFactory::createSimpleExpression(
             return createConstant(childNode);
         else if (rule == SiodbParser::RuleColumn_name)
             return createColumnValueExpression(nullptr, childNode);
+        else if (rule == SiodbParser::RuleFunction_call)
+            return createFunctionCall(childNode);
 
     } else if (childCount == 2) {
         // the only case with 2 childs is: unary_operator, [expression, column_name]
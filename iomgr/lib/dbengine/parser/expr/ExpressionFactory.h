@@ -154,6 +154,15 @@ private:
     requests::ExpressionPtr createLogicalBinaryOperator(antlr4::tree::ParseTree* leftNode,
             antlr4::tree::ParseTree* operatorNode, antlr4::tree::ParseTree* rightNode) const;
 
+    /**
+     * Creates aggregate function expression from function call node.
+     * @param node A node with function call.
+     * @return New aggregate function expression object.
+     * @throw invalid_argument if functions are not allowed in this context.
+     * @throw runtime_error if function or its arguments are not supported.
+     */
+    requests::ExpressionPtr createFunctionCall(antlr4::tree::ParseTree* node) const;
+
     /**
      * Creates an expression from simple expression node.
      * @param node A pointer to a parse tree with expression.
@@ -4,6 +4,9 @@
 
 #include "InOperator.h"
 
+// Project headers
+#include "BatchFilter.h"
+
 // Common project headers
 #include <siodb/common/utils/Base128VariantEncoding.h>
 
@@ -121,6 +124,21 @@ Variant InOperator::evaluate(Context& context) const
     return m_notIn != (variantIter != m_variants.end());
 }
 
+bool InOperator::evaluateBatch(BatchContext& context, SelectionVector& selection) const
+{
+    std::vector<const Variant*> constants;
+    constants.reserve(m_variants.size());
+    for (const auto& variant : m_variants) {
+        const auto constant = getConstantValue(*variant);
+        if (!constant) return false;
+        constants.push_back(constant);
+    }
+    const auto column = getBatchColumnValues(*m_value, context);
+    if (!column) return false;
+    filterBatchByList(*column, constants, m_notIn, selection);
+    return true;
+}
+
 std::size_t InOperator::getSerializedSize() const noexcept
 {
     std::size_t n = getExpressionTypeSerializedSize(m_type) + m_value->getSerializedSize()
@@ -4,6 +4,9 @@
 
 #include "IsOperator.h"
 
+// Project headers
+#include "BatchFilter.h"
+
 namespace siodb::iomgr::dbengine::requests {
 
 MutableOrConstantString IsOperator::getExpressionText() const
@@ -27,6 +30,16 @@ Variant IsOperator::evaluate(Context& context) const
     return leftValue.compatibleEqual(m_right->evaluate(context)) != m_isNot;
 }
 
+bool IsOperator::evaluateBatch(BatchContext& context, SelectionVector& selection) const
+{
+    const auto constant = getConstantValue(*m_right);
+    if (!constant) return false;
+    const auto column = getBatchColumnValues(*m_left, context);
+    if (!column) return false;
+    filterBatchByIdentity(*column, *constant, m_isNot, selection);
+    return true;
+}
+
 std::uint8_t* IsOperator::serializeUnchecked(std::uint8_t* buffer) const
 {
     buffer = ComparisonBinaryOperator::serializeUnchecked(buffer);
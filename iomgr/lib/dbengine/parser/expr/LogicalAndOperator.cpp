@@ -26,6 +26,12 @@ Variant LogicalAndOperator::evaluate(Context& context) const
     return rightVal.getBool();
 }
 
+bool LogicalAndOperator::evaluateBatch(BatchContext& context, SelectionVector& selection) const
+{
+    // Right operand is checked only for rows which surely match left one
+    return m_left->evaluateBatch(context, selection) && m_right->evaluateBatch(context, selection);
+}
+
 Expression* LogicalAndOperator::clone() const
 {
     return cloneImpl<LogicalAndOperator>();
@@ -0,0 +1,105 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "../../Variant.h"
+
+// STL headers
+#include <type_traits>
+
+namespace siodb::iomgr::dbengine::requests {
+
+/** Native type tag */
+template<typename T>
+struct TypeTag {
+    /** Native type */
+    using Type = T;
+};
+
+/**
+ * Returns variant value type corresponding to the native type.
+ * @return Variant value type.
+ */
+template<typename T>
+constexpr VariantType getNativeValueType() noexcept
+{
+    if constexpr (std::is_same_v<T, std::int8_t>)
+        return VariantType::kInt8;
+    else if constexpr (std::is_same_v<T, std::uint8_t>)
+        return VariantType::kUInt8;
+    else if constexpr (std::is_same_v<T, std::int16_t>)
+        return VariantType::kInt16;
+    else if constexpr (std::is_same_v<T, std::uint16_t>)
+        return VariantType::kUInt16;
+    else if constexpr (std::is_same_v<T, std::int32_t>)
+        return VariantType::kInt32;
+    else if constexpr (std::is_same_v<T, std::uint32_t>)
+        return VariantType::kUInt32;
+    else if constexpr (std::is_same_v<T, std::int64_t>)
+        return VariantType::kInt64;
+    else if constexpr (std::is_same_v<T, std::uint64_t>)
+        return VariantType::kUInt64;
+    else if constexpr (std::is_same_v<T, float>)
+        return VariantType::kFloat;
+    else
+        return VariantType::kDouble;
+}
+
+/**
+ * Returns native value of the variant. Variant must have corresponding value type.
+ * @param value Variant value.
+ * @return Native value.
+ */
+template<typename T>
+T getNativeValue(const Variant& value) noexcept
+{
+    if constexpr (std::is_same_v<T, std::int8_t>)
+        return value.getInt8();
+    else if constexpr (std::is_same_v<T, std::uint8_t>)
+        return value.getUInt8();
+    else if constexpr (std::is_same_v<T, std::int16_t>)
+        return value.getInt16();
+    else if constexpr (std::is_same_v<T, std::uint16_t>)
+        return value.getUInt16();
+    else if constexpr (std::is_same_v<T, std::int32_t>)
+        return value.getInt32();
+    else if constexpr (std::is_same_v<T, std::uint32_t>)
+        return value.getUInt32();
+    else if constexpr (std::is_same_v<T, std::int64_t>)
+        return value.getInt64();
+    else if constexpr (std::is_same_v<T, std::uint64_t>)
+        return value.getUInt64();
+    else if constexpr (std::is_same_v<T, float>)
+        return value.getFloat();
+    else
+        return value.getDouble();
+}
+
+/**
+ * Calls function with the tag of the native type corresponding to the numeric value type.
+ * @param valueType Variant value type.
+ * @param function Function object.
+ * @return Function result or false if value type is not numeric.
+ */
+template<typename Function>
+bool withNativeType(VariantType valueType, Function&& function)
+{
+    switch (valueType) {
+        case VariantType::kInt8: return function(TypeTag<std::int8_t>());
+        case VariantType::kUInt8: return function(TypeTag<std::uint8_t>());
+        case VariantType::kInt16: return function(TypeTag<std::int16_t>());
+        case VariantType::kUInt16: return function(TypeTag<std::uint16_t>());
+        case VariantType::kInt32: return function(TypeTag<std::int32_t>());
+        case VariantType::kUInt32: return function(TypeTag<std::uint32_t>());
+        case VariantType::kInt64: return function(TypeTag<std::int64_t>());
+        case VariantType::kUInt64: return function(TypeTag<std::uint64_t>());
+        case VariantType::kFloat: return function(TypeTag<float>());
+        case VariantType::kDouble: return function(TypeTag<double>());
+        default: return false;
+    }
+}
+
+}  // namespace siodb::iomgr::dbengine::requests
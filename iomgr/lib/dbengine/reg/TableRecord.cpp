@@ -16,6 +16,7 @@ TableRecord::TableRecord(const Table& table)
     , m_name(table.getName())
     , m_firstUserTrid(table.getFirstUserTrid())
     , m_currentColumnSetId(table.getCurrentColumnSetId())
+    , m_compressionType(table.getCompressionType())
 {
 }
 
@@ -23,7 +24,8 @@ std::size_t TableRecord::getSerializedSize() const noexcept
 {
     return ::getVarIntSize(m_id) + getVarIntSize(static_cast<std::uint32_t>(m_type))
            + ::getSerializedSize(m_name) + ::getVarIntSize(m_firstUserTrid)
-           + ::getVarIntSize(m_currentColumnSetId);
+           + ::getVarIntSize(m_currentColumnSetId)
+           + ::getVarIntSize(static_cast<std::uint32_t>(m_compressionType));
 }
 
 std::uint8_t* TableRecord::serializeUnchecked(std::uint8_t* buffer) const noexcept
@@ -33,6 +35,7 @@ std::uint8_t* TableRecord::serializeUnchecked(std::uint8_t* buffer) const noexce
     buffer = ::serializeUnchecked(m_name, buffer);
     buffer = ::encodeVarInt(m_firstUserTrid, buffer);
     buffer = ::encodeVarInt(m_currentColumnSetId, buffer);
+    buffer = ::encodeVarInt(static_cast<std::uint32_t>(m_compressionType), buffer);
     return buffer;
 }
 
@@ -64,6 +67,12 @@ std::size_t TableRecord::deserialize(const std::uint8_t* buffer, std::size_t len
         helpers::reportDeserializationFailure(kClassName, "currentColumnSetId", consumed);
     totalConsumed += consumed;
 
+    consumed = ::decodeVarInt(buffer + totalConsumed, length - totalConsumed, uv32);
+    if (consumed < 1)
+        helpers::reportDeserializationFailure(kClassName, "compressionType", consumed);
+    totalConsumed += consumed;
+    m_compressionType = static_cast<CompressionType>(uv32);
+
     return totalConsumed;
 }
 
@@ -5,6 +5,7 @@
 #pragma once
 
 // Project headers
+#include "../CompressionType.h"
 #include "../TableType.h"
 
 // STL headers
@@ -22,6 +23,7 @@ struct TableRecord {
         , m_type(TableType::kDisk)
         , m_firstUserTrid(0)
         , m_currentColumnSetId(0)
+        , m_compressionType(CompressionType::kNone)
     {
     }
 
@@ -32,14 +34,16 @@ struct TableRecord {
      * @param name Table name.
      * @param firstUserTrid First user range TRID.
      * @param currentColumnSetId Current column set ID.
+     * @param compressionType Compression type of the variable length data.
      */
     TableRecord(std::uint32_t id, TableType type, std::string&& name, std::uint64_t firstUserTrid,
-            std::uint64_t currentColumnSetId) noexcept
+            std::uint64_t currentColumnSetId, CompressionType compressionType) noexcept
         : m_id(id)
         , m_type(type)
         , m_name(std::move(name))
         , m_firstUserTrid(firstUserTrid)
         , m_currentColumnSetId(currentColumnSetId)
+        , m_compressionType(compressionType)
     {
     }
 
@@ -85,6 +89,9 @@ struct TableRecord {
     /** Current column set ID */
     std::uint64_t m_currentColumnSetId;
 
+    /** Compression type of the variable length data */
+    CompressionType m_compressionType;
+
     /** Structure name */
     static constexpr const char* kClassName = "TableRecord";
 };
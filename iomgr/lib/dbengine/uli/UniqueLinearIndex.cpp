@@ -279,18 +279,20 @@ io::FilePtr UniqueLinearIndex::createIndexFile(std::uint64_t fileId) const
     const auto indexFilePath = makeIndexFilePath(fileId);
 
     // Create data file as temporary file
-    constexpr int kBaseExtraOpenFlags = O_DSYNC;
+    const auto wal = getDatabase().getInstance().getWriteAheadLog();
+    const int baseExtraOpenFlags =
+            (wal ? 0 : O_DSYNC) | getDatabase().getInstance().getDirectIoOpenFlags();
     io::FilePtr file;
     try {
         try {
-            file = m_table.getDatabase().createFile(m_dataDir, kBaseExtraOpenFlags | O_TMPFILE,
+            file = m_table.getDatabase().createFile(m_dataDir, baseExtraOpenFlags | O_TMPFILE,
                     kDataFileCreationMode, m_dataFileSize);
         } catch (std::system_error& ex) {
             if (ex.code().value() != ENOTSUP) throw;
             // O_TMPFILE not supported, fallback to named temporary file
             tmpFilePath = indexFilePath + kTempFileExtension;
             file = m_table.getDatabase().createFile(
-                    tmpFilePath, kBaseExtraOpenFlags, kDataFileCreationMode, m_dataFileSize);
+                    tmpFilePath, baseExtraOpenFlags, kDataFileCreationMode, m_dataFileSize);
         }
     } catch (std::system_error& ex) {
         throwDatabaseError(IOManagerMessageId::kErrorCannotCreateIndexFile, indexFilePath,
@@ -298,6 +300,9 @@ io::FilePtr UniqueLinearIndex::createIndexFile(std::uint64_t fileId) const
                 m_id, ex.code().value(), std::strerror(ex.code().value()));
     }
 
+    // Header is padded to the node size, so node offsets don't depend on the header size
+    static_assert(IndexFileHeader::kSerializedSize <= uli::Node::kSize,
+            "Index file header doesn't fit into the first node");
     BinaryValue buffer(uli::Node::kSize, 0);
 
     // Write header
@@ -320,6 +325,14 @@ io::FilePtr UniqueLinearIndex::createIndexFile(std::uint64_t fileId) const
                 std::strerror(file->getLastError()));
     }
 
+    // Initial contents are flushed directly instead of logging the whole file
+    if (wal && !file->flush()) {
+        throwDatabaseError(IOManagerMessageId::kErrorCannotWriteIndexFile, indexFilePath,
+                getDatabaseName(), m_table.getName(), m_name, getDatabaseUuid(), m_table.getId(),
+                m_id, 0, firstNodeOffset + buffer.size(), file->getLastError(),
+                std::strerror(file->getLastError()));
+    }
+
     if (tmpFilePath.empty()) {
         // Link to the filesystem
         const auto fdPath = "/proc/self/fd/" + std::to_string(file->getFd());
@@ -340,20 +353,25 @@ io::FilePtr UniqueLinearIndex::createIndexFile(std::uint64_t fileId) const
         }
     }
 
+    if (wal) file->enableWriteAheadLog(wal, indexFilePath);
     return file;
 }
 
 io::FilePtr UniqueLinearIndex::openIndexFile(std::uint64_t fileId) const
 {
     const auto indexFilePath = makeIndexFilePath(fileId);
+    const auto wal = getDatabase().getInstance().getWriteAheadLog();
+    const int extraOpenFlags =
+            (wal ? 0 : O_DSYNC) | getDatabase().getInstance().getDirectIoOpenFlags();
     io::FilePtr file;
     try {
-        file = getDatabase().openFile(indexFilePath, O_DSYNC);
+        file = getDatabase().openFile(indexFilePath, extraOpenFlags);
     } catch (std::system_error& ex) {
         throwDatabaseError(IOManagerMessageId::kErrorCannotOpenIndexFile, indexFilePath,
                 getDatabaseName(), m_table.getName(), m_name, getDatabaseUuid(), m_table.getId(),
                 m_id, ex.code().value(), std::strerror(ex.code().value()));
     }
+    if (wal) file->enableWriteAheadLog(wal, indexFilePath);
     return file;
 }
 
@@ -0,0 +1,616 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+// Project headers
+#include "dbengine/ColumnSpecification.h"
+#include "dbengine/DatabaseError.h"
+#include "dbengine/Instance.h"
+#include "dbengine/Table.h"
+#include "dbengine/User.h"
+#include "dbengine/bpt/BPlusTreeIndex.h"
+#include "dbengine/crypto/ciphers/Cipher.h"
+#include "dbengine/ikt/BinaryIndexKeyTraits.h"
+#include "dbengine/reg/IndexRecord.h"
+
+// Common project headers
+#include <siodb/common/log/Log.h>
+#include <siodb/common/options/InstanceOptions.h>
+#include <siodb/common/stl_wrap/filesystem_wrapper.h>
+#include <siodb/common/utils/FsUtils.h>
+#include <siodb/common/utils/MessageCatalog.h>
+#include <siodb/common/utils/StartupActions.h>
+#include <siodb/common/utils/StringBuilder.h>
+
+// CRT headers
+#include <ctime>
+
+// STL headers
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <thread>
+
+// System headers
+#include <unistd.h>
+
+// Google Test
+#include <gtest/gtest.h>
+
+namespace dbengine = siodb::iomgr::dbengine;
+
+namespace {
+
+const char* argv0;
+std::string baseDir;
+dbengine::InstancePtr instance;
+dbengine::TablePtr table;
+
+constexpr const char* kDatabaseName = "BPLUS_TREE_INDEX_TEST";
+constexpr const char* kTableName = "TEST_TABLE";
+constexpr const char* kColumnName = "C";
+constexpr std::uint32_t kDataAreaSize = 1024 * 1024;
+
+constexpr std::size_t kKeySize = 8;
+
+/** Large values make branching factor small (8), so that trees with few keys are deep */
+constexpr std::size_t kLargeValueSize = 1000;
+
+/** Expected index contents: key -> value tag */
+using ReferenceIndex = std::map<std::uint64_t, std::uint64_t>;
+
+siodb::config::InstanceOptions makeInstanceOptions()
+{
+    siodb::config::InstanceOptions instanceOptions;
+
+    // Fill executable path
+    std::vector<char> executableFullPath(PATH_MAX);
+    if (::realpath(argv0, executableFullPath.data()) == nullptr)
+        throw std::runtime_error("Failed to obtain full path of the current executable.");
+    instanceOptions.m_generalOptions.m_executablePath = executableFullPath.data();
+
+    // Fill general options
+    instanceOptions.m_generalOptions.m_dataDirectory = baseDir + "/data";
+    instanceOptions.m_generalOptions.m_superUserInitialAccessKey =
+            "ssh-ed25519 AAAAC3NzaC1lZDI1NTE5AAAAIMiRClOWfWD4kC6cy5IvxscUm17g5ECaXDUe5KVuIFEz "
+            "root@siodb";
+
+    // Fill encryption options
+    instanceOptions.m_encryptionOptions.m_defaultCipherId = dbengine::crypto::kNoCipherId;
+    instanceOptions.m_encryptionOptions.m_systemDbCipherId = dbengine::crypto::kNoCipherId;
+
+    // Fill log options
+    instanceOptions.m_logOptions.m_logFileBaseName = "iomgr";
+    {
+        siodb::config::LogChannelOptions channel;
+        channel.m_name = "file";
+        channel.m_type = siodb::config::LogChannelType::kFile;
+        channel.m_destination = baseDir + "/log";
+        channel.m_severity = boost::log::trivial::debug;
+        instanceOptions.m_logOptions.m_logChannels.push_back(channel);
+    }
+
+    return instanceOptions;
+}
+
+dbengine::TablePtr createTestTable(dbengine::Instance& instance)
+{
+    const auto database = instance.createDatabase(kDatabaseName, dbengine::crypto::kNoCipherId,
+            siodb::BinaryValue(), dbengine::User::kSuperUserId);
+    std::vector<dbengine::ColumnSpecification> columnSpecs;
+    columnSpecs.emplace_back(kColumnName, siodb::COLUMN_DATA_TYPE_INT64, kDataAreaSize);
+    return database->createUserTable(
+            kTableName, dbengine::TableType::kDisk, columnSpecs, dbengine::User::kSuperUserId);
+}
+
+/** Encodes key, so that bytewise order is same as numeric order */
+void encodeKey(std::uint64_t key, std::uint8_t* buffer) noexcept
+{
+    for (int i = kKeySize - 1; i >= 0; --i, key >>= 8)
+        buffer[i] = static_cast<std::uint8_t>(key);
+}
+
+std::uint64_t decodeKey(const std::uint8_t* buffer) noexcept
+{
+    std::uint64_t key = 0;
+    for (std::size_t i = 0; i < kKeySize; ++i)
+        key = (key << 8) | buffer[i];
+    return key;
+}
+
+/** Fills whole value, so that misplaced bytes are detected */
+void encodeValue(std::uint64_t tag, std::uint8_t* buffer, std::size_t valueSize) noexcept
+{
+    std::memset(buffer, static_cast<int>(tag % 251), valueSize);
+    if (valueSize >= sizeof(tag)) std::memcpy(buffer, &tag, sizeof(tag));
+}
+
+std::unique_ptr<dbengine::BPlusTreeIndex> createIndex(
+        const std::string& name, std::size_t valueSize = kLargeValueSize)
+{
+    return std::make_unique<dbengine::BPlusTreeIndex>(*table, name,
+            dbengine::BinaryIndexKeyTraits(kKeySize), valueSize, nullptr, true,
+            dbengine::IndexColumnSpecificationList(), 0);
+}
+
+std::unique_ptr<dbengine::BPlusTreeIndex> reopenIndex(
+        std::unique_ptr<dbengine::BPlusTreeIndex>& index, std::size_t valueSize = kLargeValueSize)
+{
+    index->flush();
+    const dbengine::IndexRecord indexRecord(*index);
+    index.reset();
+    return std::make_unique<dbengine::BPlusTreeIndex>(*table, indexRecord,
+            dbengine::BinaryIndexKeyTraits(kKeySize), valueSize, nullptr);
+}
+
+bool insertEntry(dbengine::BPlusTreeIndex& index, std::uint64_t key, std::uint64_t tag,
+        bool replaceExisting = false, std::size_t valueSize = kLargeValueSize)
+{
+    std::uint8_t keyBuffer[kKeySize];
+    encodeKey(key, keyBuffer);
+    std::vector<std::uint8_t> value(valueSize);
+    encodeValue(tag, value.data(), valueSize);
+    return index.insert(keyBuffer, value.data(), replaceExisting);
+}
+
+std::uint64_t eraseEntry(dbengine::BPlusTreeIndex& index, std::uint64_t key)
+{
+    std::uint8_t keyBuffer[kKeySize];
+    encodeKey(key, keyBuffer);
+    return index.erase(keyBuffer);
+}
+
+/**
+ * Checks index contents: minimum and maximum keys, full scans in both
+ * directions and point lookups of all keys.
+ * @param index Index object.
+ * @param expected Expected contents.
+ * @param valueSize Value size.
+ */
+void checkContents(dbengine::BPlusTreeIndex& index, const ReferenceIndex& expected,
+        std::size_t valueSize = kLargeValueSize)
+{
+    std::uint8_t key[kKeySize], adjacentKey[kKeySize];
+    ASSERT_EQ(index.getMinKey(key), !expected.empty());
+    ASSERT_EQ(index.getMaxKey(adjacentKey), !expected.empty());
+    ASSERT_EQ(index.getFirstKey(key), !expected.empty());
+    ASSERT_EQ(index.getLastKey(adjacentKey), !expected.empty());
+    if (expected.empty()) return;
+
+    // Forward scan
+    ASSERT_TRUE(index.getMinKey(key));
+    for (auto it = expected.begin(); it != expected.end(); ++it) {
+        ASSERT_EQ(decodeKey(key), it->first);
+        const bool hasNextKey = index.getNextKey(key, adjacentKey);
+        ASSERT_EQ(hasNextKey, std::next(it) != expected.end()) << it->first;
+        std::memcpy(key, adjacentKey, kKeySize);
+    }
+
+    // Backward scan
+    ASSERT_TRUE(index.getMaxKey(key));
+    for (auto it = expected.rbegin(); it != expected.rend(); ++it) {
+        ASSERT_EQ(decodeKey(key), it->first);
+        const bool hasPrevKey = index.getPrevKey(key, adjacentKey);
+        ASSERT_EQ(hasPrevKey, std::next(it) != expected.rend()) << it->first;
+        std::memcpy(key, adjacentKey, kKeySize);
+    }
+
+    // Point lookups
+    std::vector<std::uint8_t> value(valueSize), expectedValue(valueSize);
+    for (const auto& e : expected) {
+        encodeKey(e.first, key);
+        ASSERT_EQ(index.getValue(key, value.data(), 1), 1U) << e.first;
+        encodeValue(e.second, expectedValue.data(), valueSize);
+        ASSERT_EQ(value, expectedValue) << e.first;
+        ASSERT_EQ(index.count(key), 1U) << e.first;
+    }
+}
+
+}  // anonymous namespace
+
+TEST(BPlusTreeIndex, InsertWithCascadingSplits)
+{
+    constexpr std::uint64_t kKeyCount = 3000;
+    std::vector<std::uint64_t> ascendingKeys(kKeyCount);
+    for (std::uint64_t i = 0; i < kKeyCount; ++i)
+        ascendingKeys[i] = i * 10;
+    auto descendingKeys = ascendingKeys;
+    std::reverse(descendingKeys.begin(), descendingKeys.end());
+    auto randomKeys = ascendingKeys;
+    std::shuffle(randomKeys.begin(), randomKeys.end(), std::mt19937_64(1));
+
+    int n = 0;
+    for (const auto& keys : {ascendingKeys, descendingKeys, randomKeys}) {
+        // Each leaf holds at most 8 entries, so tree grows to 5 levels
+        auto index = createIndex("split_" + std::to_string(++n));
+        ReferenceIndex expected;
+        checkContents(*index, expected);
+        for (const auto key : keys) {
+            ASSERT_TRUE(insertEntry(*index, key, key + 1));
+            expected.emplace(key, key + 1);
+            if (expected.size() % 500 == 0) checkContents(*index, expected);
+        }
+        checkContents(*index, expected);
+
+        // Existing keys are kept unless replacement is requested
+        for (std::uint64_t i = 0; i < kKeyCount; i += 7) {
+            const auto key = ascendingKeys[i];
+            ASSERT_FALSE(insertEntry(*index, key, key + 2));
+            ASSERT_FALSE(insertEntry(*index, key, key + 3, true));
+            expected[key] = key + 3;
+        }
+        checkContents(*index, expected);
+    }
+}
+
+TEST(BPlusTreeIndex, EraseWithBorrowAndMerge)
+{
+    constexpr std::uint64_t kKeyCount = 3000;
+    auto index = createIndex("erase");
+    ReferenceIndex expected;
+    for (std::uint64_t key = 0; key < kKeyCount; ++key) {
+        ASSERT_TRUE(insertEntry(*index, key, key));
+        expected.emplace(key, key);
+    }
+    checkContents(*index, expected);
+
+    // Leftmost nodes underflow and borrow from or merge with their right siblings
+    for (std::uint64_t key = 0; key < 1000; ++key) {
+        ASSERT_EQ(eraseEntry(*index, key), 1U) << key;
+        expected.erase(key);
+        if (key % 100 == 0) checkContents(*index, expected);
+    }
+    checkContents(*index, expected);
+
+    // Rightmost nodes underflow and borrow from or merge with their left siblings
+    for (std::uint64_t key = kKeyCount - 1; key >= 2000; --key) {
+        ASSERT_EQ(eraseEntry(*index, key), 1U) << key;
+        expected.erase(key);
+        if (key % 100 == 0) checkContents(*index, expected);
+    }
+    checkContents(*index, expected);
+
+    // Nodes in the middle underflow everywhere
+    for (std::uint64_t key = 1001; key < 2000; key += 2) {
+        ASSERT_EQ(eraseEntry(*index, key), 1U) << key;
+        expected.erase(key);
+    }
+    checkContents(*index, expected);
+
+    // Missing keys are not erased
+    ASSERT_EQ(eraseEntry(*index, 1001), 0U);
+    ASSERT_EQ(eraseEntry(*index, kKeyCount + 1), 0U);
+
+    // Root collapses level by level down to the empty leaf
+    std::vector<std::uint64_t> keys;
+    for (const auto& e : expected)
+        keys.push_back(e.first);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(2));
+    for (const auto key : keys) {
+        ASSERT_EQ(eraseEntry(*index, key), 1U) << key;
+        expected.erase(key);
+        if (expected.size() % 50 == 0) checkContents(*index, expected);
+    }
+    ASSERT_TRUE(expected.empty());
+    checkContents(*index, expected);
+    std::uint8_t key[kKeySize], adjacentKey[kKeySize];
+    encodeKey(0, key);
+    EXPECT_FALSE(index->getNextKey(key, adjacentKey));
+    EXPECT_FALSE(index->getPrevKey(key, adjacentKey));
+
+    // Empty tree grows again
+    for (std::uint64_t key = 0; key < 100; ++key) {
+        ASSERT_TRUE(insertEntry(*index, key * 3, key));
+        expected.emplace(key * 3, key);
+    }
+    checkContents(*index, expected);
+}
+
+TEST(BPlusTreeIndex, FreeNodeReuse)
+{
+    constexpr std::uint64_t kKeyCount = 2000;
+    auto index = createIndex("free_nodes");
+    for (std::uint64_t key = 0; key < kKeyCount; ++key)
+        ASSERT_TRUE(insertEntry(*index, key, key));
+    index->flush();
+    const auto fileSize = fs::file_size(index->getIndexFilePath());
+
+    // Nodes released by erasure are reused instead of growing the file
+    for (int round = 0; round < 3; ++round) {
+        for (std::uint64_t key = 0; key < kKeyCount; ++key)
+            ASSERT_EQ(eraseEntry(*index, key), 1U) << key;
+        index->flush();
+        for (std::uint64_t key = 0; key < kKeyCount; ++key)
+            ASSERT_TRUE(insertEntry(*index, key, key + round));
+        index->flush();
+        EXPECT_EQ(fs::file_size(index->getIndexFilePath()), fileSize) << round;
+    }
+
+    // Free node list survives reopening
+    ReferenceIndex expected;
+    for (std::uint64_t key = 0; key < kKeyCount; ++key) {
+        if (key % 2 == 0)
+            ASSERT_EQ(eraseEntry(*index, key), 1U) << key;
+        else
+            expected.emplace(key, key + 2);
+    }
+    index = reopenIndex(index);
+    checkContents(*index, expected);
+    for (std::uint64_t key = 0; key < kKeyCount; key += 2) {
+        ASSERT_TRUE(insertEntry(*index, key, key));
+        expected.emplace(key, key);
+    }
+    index->flush();
+    EXPECT_EQ(fs::file_size(index->getIndexFilePath()), fileSize);
+    checkContents(*index, expected);
+}
+
+TEST(BPlusTreeIndex, KeyNavigationAcrossLeaves)
+{
+    constexpr std::uint64_t kKeyCount = 1000;
+    auto index = createIndex("navigation");
+    for (std::uint64_t i = 1; i <= kKeyCount; ++i)
+        ASSERT_TRUE(insertEntry(*index, i * 10, i));
+
+    std::uint8_t key[kKeySize], adjacentKey[kKeySize];
+    ASSERT_TRUE(index->getMinKey(key));
+    EXPECT_EQ(decodeKey(key), 10U);
+    ASSERT_TRUE(index->getMaxKey(key));
+    EXPECT_EQ(decodeKey(key), kKeyCount * 10);
+
+    // Keys in the index and between them, at leaf boundaries and inside leaves
+    for (std::uint64_t i = 1; i <= kKeyCount; ++i) {
+        const auto existingKey = i * 10;
+        for (const auto k : {existingKey, existingKey + 5}) {
+            encodeKey(k, key);
+            const bool hasNextKey = index->getNextKey(key, adjacentKey);
+            ASSERT_EQ(hasNextKey, i < kKeyCount) << k;
+            if (hasNextKey) {
+                ASSERT_EQ(decodeKey(adjacentKey), existingKey + 10) << k;
+            }
+        }
+        for (const auto k : {existingKey, existingKey - 5}) {
+            encodeKey(k, key);
+            const bool hasPrevKey = index->getPrevKey(key, adjacentKey);
+            ASSERT_EQ(hasPrevKey, i > 1) << k;
+            if (hasPrevKey) {
+                ASSERT_EQ(decodeKey(adjacentKey), existingKey - 10) << k;
+            }
+        }
+    }
+
+    // Keys outside of the index key range
+    encodeKey(0, key);
+    ASSERT_TRUE(index->getNextKey(key, adjacentKey));
+    EXPECT_EQ(decodeKey(adjacentKey), 10U);
+    EXPECT_FALSE(index->getPrevKey(key, adjacentKey));
+    encodeKey(std::numeric_limits<std::uint64_t>::max(), key);
+    ASSERT_TRUE(index->getPrevKey(key, adjacentKey));
+    EXPECT_EQ(decodeKey(adjacentKey), kKeyCount * 10);
+    EXPECT_FALSE(index->getNextKey(key, adjacentKey));
+}
+
+TEST(BPlusTreeIndex, BulkLoad)
+{
+    // Entry counts around node capacity and large enough for several levels
+    for (const std::uint64_t entryCount : {0, 1, 7, 8, 9, 100, 5000}) {
+        auto index = createIndex("bulk_" + std::to_string(entryCount));
+        ReferenceIndex expected;
+        std::uint64_t i = 0;
+        index->bulkLoad(entryCount, [&](std::uint8_t* entry) {
+            const auto key = i * 3;
+            encodeKey(key, entry);
+            encodeValue(key + 1, entry + kKeySize, kLargeValueSize);
+            expected.emplace(key, key + 1);
+            ++i;
+        });
+        ASSERT_EQ(i, entryCount);
+        checkContents(*index, expected);
+
+        // Missing keys and ranges starting between keys
+        std::uint8_t key[kKeySize], adjacentKey[kKeySize];
+        std::vector<std::uint8_t> value(kLargeValueSize);
+        for (std::uint64_t k = 1; k < entryCount * 3; k += 3) {
+            encodeKey(k, key);
+            ASSERT_EQ(index->getValue(key, value.data(), 1), 0U) << k;
+            ASSERT_EQ(index->count(key), 0U) << k;
+            const bool hasNextKey = index->getNextKey(key, adjacentKey);
+            ASSERT_EQ(hasNextKey, k + 2 < entryCount * 3) << k;
+            if (hasNextKey) {
+                ASSERT_EQ(decodeKey(adjacentKey), k + 2);
+            }
+            ASSERT_TRUE(index->getPrevKey(key, adjacentKey)) << k;
+            ASSERT_EQ(decodeKey(adjacentKey), k - 1);
+        }
+
+        // Bulk loaded tree is modified as usual
+        std::mt19937_64 rng(entryCount);
+        for (int round = 0; round < 2000; ++round) {
+            const auto k = rng() % (entryCount * 3 + 10);
+            if (rng() % 2 == 0) {
+                ASSERT_EQ(insertEntry(*index, k, k), expected.emplace(k, k).second) << k;
+            } else {
+                ASSERT_EQ(eraseEntry(*index, k), expected.erase(k)) << k;
+            }
+        }
+        checkContents(*index, expected);
+        index = reopenIndex(index);
+        checkContents(*index, expected);
+    }
+
+    // Bulk load requires empty index
+    {
+        auto index = createIndex("bulk_non_empty");
+        ASSERT_TRUE(insertEntry(*index, 1, 1));
+        EXPECT_THROW(index->bulkLoad(1,
+                             [](std::uint8_t* entry) {
+                                 encodeKey(2, entry);
+                                 encodeValue(2, entry + kKeySize, kLargeValueSize);
+                             }),
+                std::logic_error);
+    }
+
+    // Bulk load requires ordered entries
+    {
+        auto index = createIndex("bulk_unordered");
+        std::uint64_t i = 0;
+        EXPECT_THROW(index->bulkLoad(100,
+                             [&](std::uint8_t* entry) {
+                                 encodeKey(i == 50 ? 1 : i, entry);
+                                 encodeValue(i, entry + kKeySize, kLargeValueSize);
+                                 ++i;
+                             }),
+                std::invalid_argument);
+    }
+}
+
+TEST(BPlusTreeIndex, Reopen)
+{
+    // Small values, so that tree has large nodes
+    constexpr std::size_t kValueSize = sizeof(std::uint64_t);
+    auto index = createIndex("reopen", kValueSize);
+    ReferenceIndex expected;
+    std::mt19937_64 rng(3);
+    for (int round = 0; round < 20000; ++round) {
+        const auto key = rng() % 10000;
+        if (rng() % 3 < 2) {
+            ASSERT_EQ(insertEntry(*index, key, round, false, kValueSize),
+                    expected.emplace(key, round).second);
+        } else {
+            ASSERT_EQ(eraseEntry(*index, key), expected.erase(key));
+        }
+    }
+    checkContents(*index, expected, kValueSize);
+
+    index = reopenIndex(index, kValueSize);
+    checkContents(*index, expected, kValueSize);
+
+    // Reopened index is modified as usual
+    for (std::uint64_t key = 10000; key < 12000; ++key) {
+        ASSERT_TRUE(insertEntry(*index, key, key, false, kValueSize));
+        expected.emplace(key, key);
+    }
+    for (std::uint64_t key = 0; key < 5000; ++key)
+        ASSERT_EQ(eraseEntry(*index, key), expected.erase(key));
+
+    index = reopenIndex(index, kValueSize);
+    checkContents(*index, expected, kValueSize);
+}
+
+TEST(BPlusTreeIndex, ConcurrentReadersDuringWrites)
+{
+    // Readers check even keys, which always exist, while writer inserts and erases odd keys
+    constexpr std::uint64_t kKeyCount = 5000;
+    auto index = createIndex("concurrent");
+    ReferenceIndex expected;
+    for (std::uint64_t key = 0; key < kKeyCount; key += 2) {
+        ASSERT_TRUE(insertEntry(*index, key, key));
+        expected.emplace(key, key);
+    }
+
+    std::atomic<bool> stop(false);
+    std::atomic<std::size_t> errorCount(0);
+    std::vector<std::thread> readers;
+    for (unsigned i = 0; i < 4; ++i) {
+        readers.emplace_back([&, i] {
+            std::mt19937_64 rng(i);
+            std::uint8_t key[kKeySize], adjacentKey[kKeySize];
+            std::vector<std::uint8_t> value(kLargeValueSize), expectedValue(kLargeValueSize);
+            while (!stop) {
+                const auto k = (rng() % (kKeyCount / 2)) * 2;
+                encodeKey(k, key);
+                encodeValue(k, expectedValue.data(), kLargeValueSize);
+                if (index->getValue(key, value.data(), 1) != 1 || value != expectedValue)
+                    ++errorCount;
+                if (k + 2 < kKeyCount) {
+                    if (!index->getNextKey(key, adjacentKey)) {
+                        ++errorCount;
+                    } else {
+                        const auto nextKey = decodeKey(adjacentKey);
+                        if (nextKey != k + 1 && nextKey != k + 2) ++errorCount;
+                    }
+                }
+                if (k > 0) {
+                    if (!index->getPrevKey(key, adjacentKey)) {
+                        ++errorCount;
+                    } else {
+                        const auto prevKey = decodeKey(adjacentKey);
+                        if (prevKey != k - 1 && prevKey != k - 2) ++errorCount;
+                    }
+                }
+            }
+        });
+    }
+
+    std::mt19937_64 rng(4);
+    for (int round = 0; round < 20000; ++round) {
+        const auto key = (rng() % (kKeyCount / 2)) * 2 + 1;
+        if (rng() % 2 == 0) {
+            EXPECT_EQ(insertEntry(*index, key, key), expected.emplace(key, key).second);
+        } else {
+            EXPECT_EQ(eraseEntry(*index, key), expected.erase(key));
+        }
+    }
+    stop = true;
+    for (auto& reader : readers)
+        reader.join();
+
+    EXPECT_EQ(errorCount, 0U);
+    checkContents(*index, expected);
+}
+
+int main(int argc, char** argv)
+{
+    // Must be called very first!
+    siodb::utils::performCommonStartupActions();
+
+    // Save executable
+    argv0 = argv[0];
+
+    const auto home = ::getenv("HOME");
+    const std::string baseDirPath = siodb::utils::StringBuilder()
+                                    << home << "/tmp/siodb_" << std::time(nullptr) << '_'
+                                    << ::getpid();
+    baseDir = baseDirPath;
+
+    // Initialize logging
+    const auto instanceOptions = makeInstanceOptions();
+    siodb::log::LogSubsystemGuard logGuard(instanceOptions.m_logOptions);
+    LOG_INFO << "Base directory: " << baseDir;
+
+    // Initialize DB message catalog.
+    LOG_INFO << "Initializing database message catalog...";
+    siodb::utils::MessageCatalog::initDefaultCatalog(
+            siodb::utils::constructPath(instanceOptions.getExecutableDir(), "iomgr_messages.txt"));
+
+    // Initialize ciphers
+    LOG_INFO << "Initializing built-in ciphers...";
+    dbengine::crypto::initializeBuiltInCiphers();
+    LOG_INFO << "Initializing external ciphers...";
+    dbengine::crypto::initializeExternalCiphers(
+            instanceOptions.m_encryptionOptions.m_externalCipherOptions);
+
+    // Indices are created directly on the test table and are not registered in it
+    try {
+        instance = std::make_shared<dbengine::Instance>(instanceOptions);
+        table = createTestTable(*instance);
+    } catch (dbengine::DatabaseError& ex) {
+        LOG_ERROR << '[' << ex.getErrorCode() << "] " << ex.what() << '\n'
+                  << ex.getStackTraceAsString();
+        return 1;
+    }
+
+    // Run tests
+    testing::InitGoogleTest(&argc, argv);
+    const int result = RUN_ALL_TESTS();
+
+    table.reset();
+    instance.reset();
+
+    // Keep data only if some test failed
+    if (result == 0) fs::remove_all(baseDir);
+    return result;
+}
@@ -6,9 +6,11 @@
 #include <cstring>
 
 // STL headers
+#include <chrono>
 #include <iomanip>
 #include <iostream>
 #include <random>
+#include <thread>
 
 // Project headers
 #include "dbengine/crypto/ciphers/AesCipher.h"
@@ -67,6 +69,66 @@ bool testCipher(const siodb::iomgr::dbengine::crypto::Cipher& cipher, unsigned m
     return true;
 }
 
+siodb::BinaryValue fromHex(const char* hex)
+{
+    siodb::BinaryValue result(std::strlen(hex) / 2);
+    for (std::size_t i = 0; i < result.size(); ++i)
+        result[i] = static_cast<std::uint8_t>(std::stoul(std::string(hex + i * 2, 2), nullptr, 16));
+    return result;
+}
+
+/**
+ * Checks single block known answer. Contexts must produce the same ciphertext
+ * as the plain block cipher, so that existing encrypted files remain readable.
+ */
+bool testKnownAnswer(const siodb::iomgr::dbengine::crypto::Cipher& cipher, const char* key,
+        const char* plaintext, const char* ciphertext)
+{
+    const auto data = fromHex(plaintext);
+    const auto expected = fromHex(ciphertext);
+    const auto encryptionContext = cipher.createEncryptionContext(fromHex(key));
+    const auto decryptionContext = cipher.createDecryptionContext(fromHex(key));
+
+    // Same block repeated, to check multi-block transform
+    constexpr unsigned kBlockCount = 37;
+    siodb::BinaryValue in(data.size() * kBlockCount), out(in.size()), back(in.size());
+    for (unsigned i = 0; i < kBlockCount; ++i)
+        std::memcpy(in.data() + i * data.size(), data.data(), data.size());
+    encryptionContext->transform(in.data(), kBlockCount, out.data());
+    for (unsigned i = 0; i < kBlockCount; ++i) {
+        if (std::memcmp(out.data() + i * data.size(), expected.data(), data.size()) != 0) {
+            printData(std::cerr, "Encrypted Data", out);
+            return false;
+        }
+    }
+    decryptionContext->transform(out.data(), kBlockCount, back.data());
+    return back == in;
+}
+
+/** Measures and prints transform throughput of the cipher contexts. */
+void measureThroughput(const siodb::iomgr::dbengine::crypto::Cipher& cipher)
+{
+    constexpr std::size_t kChunkSize = 64 * 1024;
+    constexpr std::size_t kTotalSize = 64 * 1024 * 1024;
+    const auto blockSize = cipher.getBlockSize() / 8;
+    const siodb::BinaryValue key(cipher.getKeySize() / 8, 0x5A);
+    siodb::BinaryValue data(kChunkSize, 0x33), buffer(kChunkSize);
+
+    for (const bool encrypt : {true, false}) {
+        const auto context =
+                encrypt ? cipher.createEncryptionContext(key) : cipher.createDecryptionContext(key);
+        const auto startTime = std::chrono::steady_clock::now();
+        for (std::size_t n = 0; n < kTotalSize; n += kChunkSize)
+            context->transform(data.data(), kChunkSize / blockSize, buffer.data());
+        const std::chrono::duration<double> duration =
+                std::chrono::steady_clock::now() - startTime;
+        std::cout << cipher.getCipherId() << (encrypt ? " encrypt: " : " decrypt: ")
+                  << std::fixed << std::setprecision(1)
+                  << (kTotalSize / (1024.0 * 1024.0) / duration.count()) << " MiB/s"
+                  << std::endl;
+    }
+}
+
 }  // anonymous namespace
 
 TEST(BuiltInCiphers, Aes128)
@@ -111,6 +173,69 @@ TEST(BuiltInCiphers, Camellia256)
     ASSERT_TRUE(testCipher(*cipher, 16));
 }
 
+TEST(BuiltInCiphers, KnownAnswers)
+{
+    using namespace siodb::iomgr::dbengine::crypto;
+    // FIPS-197 Appendix C
+    EXPECT_TRUE(testKnownAnswer(*std::make_shared<Aes128>(),
+            "000102030405060708090a0b0c0d0e0f",
+            "00112233445566778899aabbccddeeff", "69c4e0d86a7b0430d8cdb78070b4c55a"));
+    EXPECT_TRUE(testKnownAnswer(*std::make_shared<Aes192>(),
+            "000102030405060708090a0b0c0d0e0f1011121314151617",
+            "00112233445566778899aabbccddeeff", "dda97ca4864cdfe06eaf70a0ec0d7191"));
+    EXPECT_TRUE(testKnownAnswer(*std::make_shared<Aes256>(),
+            "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f",
+            "00112233445566778899aabbccddeeff", "8ea2b7ca516745bfeafc49904b496089"));
+    // RFC 3713 Appendix A
+    EXPECT_TRUE(testKnownAnswer(*std::make_shared<Camellia128>(),
+            "0123456789abcdeffedcba9876543210",
+            "0123456789abcdeffedcba9876543210", "67673138549669730857065648eabe43"));
+    EXPECT_TRUE(testKnownAnswer(*std::make_shared<Camellia192>(),
+            "0123456789abcdeffedcba98765432100011223344556677",
+            "0123456789abcdeffedcba9876543210", "b4993401b3e996f84ee5cee7d79b09b9"));
+    EXPECT_TRUE(testKnownAnswer(*std::make_shared<Camellia256>(),
+            "0123456789abcdeffedcba987654321000112233445566778899aabbccddeeff",
+            "0123456789abcdeffedcba9876543210", "9acc237dff16d76c20ef7c919e3a7509"));
+}
+
+TEST(BuiltInCiphers, ConcurrentTransform)
+{
+    // Same context is shared by all files of a database
+    const auto cipher = std::make_shared<siodb::iomgr::dbengine::crypto::Aes256>();
+    const siodb::BinaryValue key(cipher->getKeySize() / 8, 7);
+    const auto encryptionContext = cipher->createEncryptionContext(key);
+    const auto decryptionContext = cipher->createDecryptionContext(key);
+
+    std::vector<std::thread> threads;
+    std::atomic<unsigned> failureCount = 0;
+    for (unsigned t = 0; t < 8; ++t) {
+        threads.emplace_back([&, t] {
+            siodb::BinaryValue data(4096, static_cast<std::uint8_t>(t)), encrypted(4096),
+                    decrypted(4096);
+            for (int i = 0; i < 2000; ++i) {
+                data[i % data.size()] = static_cast<std::uint8_t>(i);
+                const auto blockCount = 1 + i % 256;
+                encryptionContext->transform(data.data(), blockCount, encrypted.data());
+                decryptionContext->transform(encrypted.data(), blockCount, decrypted.data());
+                if (std::memcmp(data.data(), decrypted.data(), blockCount * 16) != 0)
+                    ++failureCount;
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    EXPECT_EQ(failureCount, 0U);
+}
+
+TEST(BuiltInCiphers, Throughput)
+{
+    using namespace siodb::iomgr::dbengine::crypto;
+    measureThroughput(*std::make_shared<Aes128>());
+    measureThroughput(*std::make_shared<Aes256>());
+    measureThroughput(*std::make_shared<Camellia128>());
+    measureThroughput(*std::make_shared<Camellia256>());
+}
+
 int main(int argc, char** argv)
 {
     // Run tests
@@ -0,0 +1,435 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+// Project headers
+#include "dbengine/Column.h"
+#include "dbengine/ColumnDataBlock.h"
+#include "dbengine/DatabaseError.h"
+#include "dbengine/Index.h"
+#include "dbengine/Instance.h"
+#include "dbengine/Table.h"
+#include "dbengine/TransactionParameters.h"
+#include "dbengine/User.h"
+#include "dbengine/crypto/ciphers/Cipher.h"
+
+// Common project headers
+#include <siodb/common/log/Log.h>
+#include <siodb/common/options/InstanceOptions.h>
+#include <siodb/common/stl_wrap/filesystem_wrapper.h>
+#include <siodb/common/utils/FsUtils.h>
+#include <siodb/common/utils/MessageCatalog.h>
+#include <siodb/common/utils/PlainBinaryEncoding.h>
+#include <siodb/common/utils/StartupActions.h>
+#include <siodb/common/utils/StringBuilder.h>
+
+// CRT headers
+#include <ctime>
+
+// STL headers
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <thread>
+
+// System headers
+#include <unistd.h>
+
+// Google Test
+#include <gtest/gtest.h>
+
+namespace dbengine = siodb::iomgr::dbengine;
+
+namespace {
+
+const char* argv0;
+std::string baseDir;
+
+constexpr const char* kDatabaseName = "COLUMN_DATA_BLOCK_TEST";
+constexpr const char* kTableName = "TEST_TABLE";
+constexpr const char* kIntColumnName = "I";
+constexpr const char* kTextColumnName = "T";
+
+/** Small data area, so that table data is spread over many blocks */
+constexpr std::uint32_t kDataAreaSize = 1024;
+
+constexpr std::size_t kRowCount = 2000;
+
+siodb::config::InstanceOptions makeInstanceOptions(const std::string& instanceName)
+{
+    siodb::config::InstanceOptions instanceOptions;
+
+    // Fill executable path
+    std::vector<char> executableFullPath(PATH_MAX);
+    if (::realpath(argv0, executableFullPath.data()) == nullptr)
+        throw std::runtime_error("Failed to obtain full path of the current executable.");
+    instanceOptions.m_generalOptions.m_executablePath = executableFullPath.data();
+
+    // Fill general options
+    instanceOptions.m_generalOptions.m_dataDirectory = baseDir + "/data_" + instanceName;
+    instanceOptions.m_generalOptions.m_superUserInitialAccessKey =
+            "ssh-ed25519 AAAAC3NzaC1lZDI1NTE5AAAAIMiRClOWfWD4kC6cy5IvxscUm17g5ECaXDUe5KVuIFEz "
+            "root@siodb";
+
+    // Fill encryption options
+    instanceOptions.m_encryptionOptions.m_defaultCipherId = dbengine::crypto::kNoCipherId;
+    instanceOptions.m_encryptionOptions.m_systemDbCipherId = dbengine::crypto::kNoCipherId;
+
+    // Scrubber would load blocks concurrently with the test
+    instanceOptions.m_ioManagerOptions.m_blockScrubRate = 0;
+
+    // Fill log options
+    instanceOptions.m_logOptions.m_logFileBaseName = "iomgr";
+    {
+        siodb::config::LogChannelOptions channel;
+
+        channel.m_name = "console";
+        channel.m_type = siodb::config::LogChannelType::kConsole;
+        channel.m_destination = "stdout";
+        channel.m_severity = boost::log::trivial::debug;
+        instanceOptions.m_logOptions.m_logChannels.push_back(channel);
+
+        channel.m_name = "file";
+        channel.m_type = siodb::config::LogChannelType::kFile;
+        channel.m_destination = baseDir + "/log";
+        instanceOptions.m_logOptions.m_logChannels.push_back(channel);
+    }
+
+    return instanceOptions;
+}
+
+std::int64_t makeIntValue(std::size_t row)
+{
+    return static_cast<std::int64_t>(row) * 7919 - 1000000;
+}
+
+std::string makeTextValue(std::size_t row)
+{
+    // Lengths vary, so that some values are split between blocks
+    return "Row #" + std::to_string(row) + ' ' + std::string(row % 200, 'a' + row % 26);
+}
+
+dbengine::TablePtr createTestTable(dbengine::Instance& instance)
+{
+    const auto database = instance.createDatabase(kDatabaseName, dbengine::crypto::kNoCipherId,
+            siodb::BinaryValue(), dbengine::User::kSuperUserId);
+    std::vector<dbengine::ColumnSpecification> columnSpecs;
+    columnSpecs.emplace_back(kIntColumnName, siodb::COLUMN_DATA_TYPE_INT64, kDataAreaSize);
+    columnSpecs.emplace_back(kTextColumnName, siodb::COLUMN_DATA_TYPE_TEXT, kDataAreaSize);
+    return database->createUserTable(
+            kTableName, dbengine::TableType::kDisk, columnSpecs, dbengine::User::kSuperUserId);
+}
+
+dbengine::TablePtr getTestTable(dbengine::Instance& instance)
+{
+    return instance.getDatabaseChecked(kDatabaseName)->getTableChecked(kTableName);
+}
+
+/**
+ * Inserts rows into the test table.
+ * @param table Test table.
+ * @param firstRow First row number.
+ * @param rowCount Number of rows.
+ * @param[out] trids TRIDs of the rows, indexed by row number.
+ */
+void insertRows(dbengine::Table& table, std::size_t firstRow, std::size_t rowCount,
+        std::vector<std::uint64_t>& trids)
+{
+    const dbengine::TransactionParameters transactionParameters(
+            dbengine::User::kSuperUserId, table.getDatabase().generateNextTransactionId());
+    trids.resize(firstRow + rowCount);
+    for (auto row = firstRow; row < firstRow + rowCount; ++row) {
+        std::vector<dbengine::Variant> values;
+        values.emplace_back(makeIntValue(row));
+        values.emplace_back(makeTextValue(row));
+        trids[row] = table.insertRow(values, transactionParameters).first->getTableRowId();
+    }
+}
+
+/**
+ * Reads all rows of the test table by their TRIDs and compares them with inserted values.
+ * @param table Test table.
+ * @param trids TRIDs of the rows, indexed by row number.
+ */
+void checkRows(dbengine::Table& table, const std::vector<std::uint64_t>& trids)
+{
+    const auto masterColumn = table.getMasterColumn();
+    const auto masterColumnMainIndex = masterColumn->getMasterColumnMainIndex();
+    const auto intColumn = table.getColumnChecked(kIntColumnName);
+    const auto textColumn = table.getColumnChecked(kTextColumnName);
+    for (std::size_t row = 0; row < trids.size(); ++row) {
+        std::uint8_t key[8], value[12];
+        ::pbeEncodeUInt64(trids[row], key);
+        ASSERT_EQ(masterColumnMainIndex->getValue(key, value, 1), 1U) << "row " << row;
+        dbengine::ColumnDataAddress mcrAddress;
+        mcrAddress.pbeDeserialize(value, sizeof(value));
+        dbengine::MasterColumnRecord mcr;
+        masterColumn->readMasterColumnRecord(mcrAddress, mcr);
+
+        // Column records are ordered by column position
+        const auto& columnRecords = mcr.getColumnRecords();
+        ASSERT_EQ(columnRecords.size(), 2U) << "row " << row;
+        dbengine::Variant intValue, textValue;
+        intColumn->readRecord(columnRecords[0].getAddress(), intValue);
+        textColumn->readRecord(columnRecords[1].getAddress(), textValue);
+        ASSERT_EQ(intValue.getValueType(), dbengine::VariantType::kInt64) << "row " << row;
+        EXPECT_EQ(intValue.getInt64(), makeIntValue(row)) << "row " << row;
+        ASSERT_EQ(textValue.getValueType(), dbengine::VariantType::kString) << "row " << row;
+        EXPECT_EQ(textValue.getString(), makeTextValue(row)) << "row " << row;
+    }
+}
+
+/**
+ * Checks that all blocks of the column have extents in the segment files,
+ * and that extents don't overlap.
+ * @param column Column object.
+ */
+void checkSegmentExtents(const dbengine::Column& column)
+{
+    const auto segmentStore = column.getSegmentStore();
+    ASSERT_NE(segmentStore, nullptr) << column.getName();
+    ASSERT_NE(segmentStore->getFirstBlockId(), 0U) << column.getName();
+
+    // (segment ID, offset) -> size
+    std::map<std::pair<std::uint32_t, std::uint64_t>, std::uint64_t> extents;
+    for (auto blockId = segmentStore->getFirstBlockId(); blockId <= column.getLastBlockId();
+            ++blockId) {
+        const auto extent = segmentStore->getExtent(blockId);
+        ASSERT_TRUE(extent.isValid()) << column.getName() << " block #" << blockId;
+        EXPECT_EQ(extent.m_offset % 4096, 0U) << column.getName() << " block #" << blockId;
+        EXPECT_LE(extent.m_offset + extent.m_size, segmentStore->getSegmentFileSize())
+                << column.getName() << " block #" << blockId;
+        extents.emplace(std::make_pair(extent.m_segmentId, extent.m_offset), extent.m_size);
+    }
+
+    for (auto it = extents.begin(); it != extents.end(); ++it) {
+        const auto next = std::next(it);
+        if (next == extents.end() || next->first.first != it->first.first) continue;
+        EXPECT_LE(it->first.second + it->second, next->first.second)
+                << column.getName() << " segment " << it->first.first;
+    }
+}
+
+/**
+ * Counts closed blocks of the column, which stored data is verified successfully.
+ * Table is only inserted into, so all blocks except the last one are closed.
+ * @param column Column object.
+ * @return Number of verified blocks.
+ */
+std::size_t countVerifiedBlocks(dbengine::Column& column)
+{
+    std::size_t count = 0;
+    for (std::uint64_t blockId = 1; blockId < column.getLastBlockId(); ++blockId) {
+        if (column.verifyBlock(blockId) > 0) ++count;
+    }
+    return count;
+}
+
+/**
+ * Waits until all closed blocks of the data columns are finalized.
+ * @param table Test table.
+ * @return true if all blocks are finalized, false on timeout.
+ */
+bool waitForFinalizedBlocks(dbengine::Table& table)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+    for (const auto& columnName : {kIntColumnName, kTextColumnName}) {
+        const auto column = table.getColumnChecked(columnName);
+        while (countVerifiedBlocks(*column) + 1 < column->getLastBlockId()) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    return true;
+}
+
+}  // anonymous namespace
+
+TEST(ColumnDataBlock, SegmentFilesRoundTrip)
+{
+    auto instanceOptions = makeInstanceOptions("segment_files");
+    instanceOptions.m_ioManagerOptions.m_segmentFileSize =
+            siodb::config::kMinIOManagerSegmentFileSize;
+
+    std::vector<std::uint64_t> trids;
+    {
+        const auto instance = std::make_unique<dbengine::Instance>(instanceOptions);
+        const auto table = createTestTable(*instance);
+        insertRows(*table, 0, kRowCount, trids);
+        checkRows(*table, trids);
+        for (const auto& column : table->getColumnsOrderedByPosition())
+            checkSegmentExtents(*column);
+    }
+
+    // Existing columns keep segment files, free space is rebuilt from the offset table
+    instanceOptions.m_ioManagerOptions.m_segmentFileSize = 0;
+    {
+        const auto instance = std::make_unique<dbengine::Instance>(instanceOptions);
+        const auto table = getTestTable(*instance);
+        checkRows(*table, trids);
+        insertRows(*table, kRowCount, kRowCount, trids);
+        checkRows(*table, trids);
+        for (const auto& column : table->getColumnsOrderedByPosition())
+            checkSegmentExtents(*column);
+    }
+
+    {
+        const auto instance = std::make_unique<dbengine::Instance>(instanceOptions);
+        const auto table = getTestTable(*instance);
+        checkRows(*table, trids);
+    }
+}
+
+TEST(ColumnDataBlock, WritebackRoundTrip)
+{
+    auto instanceOptions = makeInstanceOptions("writeback");
+    // Table doesn't fit into the block cache, so modified blocks are evicted
+    // and written back by the writer threads while rows are inserted
+    instanceOptions.m_ioManagerOptions.m_blockCacheSize = 256 * 1024;
+    instanceOptions.m_ioManagerOptions.m_writerThreadNumber = 2;
+
+    std::vector<std::uint64_t> trids;
+    {
+        const auto instance = std::make_unique<dbengine::Instance>(instanceOptions);
+        const auto table = createTestTable(*instance);
+        insertRows(*table, 0, kRowCount, trids);
+
+        std::size_t blockCount = 0;
+        for (const auto& column : table->getColumnsOrderedByPosition())
+            blockCount += column->getLastBlockId();
+        EXPECT_LT(instance->getBlockPool().size(), blockCount);
+
+        // Evicted blocks are loaded again from their files
+        checkRows(*table, trids);
+    }
+
+    {
+        const auto instance = std::make_unique<dbengine::Instance>(instanceOptions);
+        const auto table = getTestTable(*instance);
+        checkRows(*table, trids);
+    }
+}
+
+TEST(ColumnDataBlock, FinalizationRoundTrip)
+{
+    // Without writer threads blocks are finalized by the inserting thread
+    for (const std::size_t writerThreadNumber : {0, 2}) {
+        auto instanceOptions =
+                makeInstanceOptions("finalization_" + std::to_string(writerThreadNumber));
+        instanceOptions.m_ioManagerOptions.m_writerThreadNumber = writerThreadNumber;
+
+        std::vector<std::uint64_t> trids;
+        {
+            const auto instance = std::make_unique<dbengine::Instance>(instanceOptions);
+            const auto table = createTestTable(*instance);
+            insertRows(*table, 0, kRowCount, trids);
+            ASSERT_TRUE(waitForFinalizedBlocks(*table)) << writerThreadNumber;
+            checkRows(*table, trids);
+        }
+
+        // Digest chain of the closed blocks is checked when columns are opened
+        {
+            const auto instance = std::make_unique<dbengine::Instance>(instanceOptions);
+            const auto table = getTestTable(*instance);
+            for (const auto& columnName : {kIntColumnName, kTextColumnName}) {
+                const auto column = table->getColumnChecked(columnName);
+                ASSERT_GT(column->getLastBlockId(), 1U) << columnName;
+                EXPECT_EQ(countVerifiedBlocks(*column) + 1, column->getLastBlockId())
+                        << columnName << ", " << writerThreadNumber;
+            }
+            checkRows(*table, trids);
+        }
+    }
+}
+
+TEST(ColumnDataBlock, ChecksumRoundTrip)
+{
+    const auto instanceOptions = makeInstanceOptions("checksum");
+
+    std::vector<std::uint64_t> trids;
+    std::string dataFilePath;
+    {
+        const auto instance = std::make_unique<dbengine::Instance>(instanceOptions);
+        const auto table = createTestTable(*instance);
+        insertRows(*table, 0, kRowCount, trids);
+        ASSERT_TRUE(waitForFinalizedBlocks(*table));
+        const auto column = table->getColumnChecked(kIntColumnName);
+        ASSERT_GT(column->getLastBlockId(), 2U);
+        ASSERT_EQ(column->getSegmentStore(), nullptr);
+        dataFilePath = dbengine::ColumnDataBlock::makeDataFilePath(*column, 2);
+    }
+
+    // Stored checksums and digests are valid after reopening
+    {
+        const auto instance = std::make_unique<dbengine::Instance>(instanceOptions);
+        const auto table = getTestTable(*instance);
+        for (const auto& columnName : {kIntColumnName, kTextColumnName}) {
+            const auto column = table->getColumnChecked(columnName);
+            EXPECT_EQ(countVerifiedBlocks(*column) + 1, column->getLastBlockId()) << columnName;
+        }
+        checkRows(*table, trids);
+    }
+
+    // Corrupt first byte of the stored data of the closed block
+    {
+        std::fstream file(dataFilePath, std::ios::in | std::ios::out | std::ios::binary);
+        ASSERT_TRUE(file.is_open()) << dataFilePath;
+        const auto offset = dbengine::ColumnDataBlockHeader::kDefaultDataAreaOffset;
+        char c = 0;
+        file.seekg(offset);
+        ASSERT_TRUE(file.read(&c, 1));
+        c = static_cast<char>(~c);
+        file.seekp(offset);
+        ASSERT_TRUE(file.write(&c, 1));
+    }
+
+    // Corruption is detected either when column is opened or when block is verified
+    const auto instance = std::make_unique<dbengine::Instance>(instanceOptions);
+    EXPECT_THROW(
+            {
+                const auto table = getTestTable(*instance);
+                table->getColumnChecked(kIntColumnName)->verifyBlock(2);
+            },
+            dbengine::DatabaseError);
+}
+
+int main(int argc, char** argv)
+{
+    // Must be called very first!
+    siodb::utils::performCommonStartupActions();
+
+    // Save executable
+    argv0 = argv[0];
+
+    const auto home = ::getenv("HOME");
+    const std::string baseDirPath = siodb::utils::StringBuilder()
+                                    << home << "/tmp/siodb_" << std::time(nullptr) << '_'
+                                    << ::getpid();
+    baseDir = baseDirPath;
+
+    // Initialize logging
+    const auto instanceOptions = makeInstanceOptions(std::string());
+    siodb::log::LogSubsystemGuard logGuard(instanceOptions.m_logOptions);
+    LOG_INFO << "Base directory: " << baseDir;
+
+    // Initialize DB message catalog.
+    LOG_INFO << "Initializing database message catalog...";
+    siodb::utils::MessageCatalog::initDefaultCatalog(
+            siodb::utils::constructPath(instanceOptions.getExecutableDir(), "iomgr_messages.txt"));
+
+    // Initialize ciphers
+    LOG_INFO << "Initializing built-in ciphers...";
+    dbengine::crypto::initializeBuiltInCiphers();
+    LOG_INFO << "Initializing external ciphers...";
+    dbengine::crypto::initializeExternalCiphers(
+            instanceOptions.m_encryptionOptions.m_externalCipherOptions);
+
+    // Run tests
+    testing::InitGoogleTest(&argc, argv);
+    const int result = RUN_ALL_TESTS();
+
+    // Keep data only if some test failed
+    if (result == 0) fs::remove_all(baseDir);
+    return result;
+}
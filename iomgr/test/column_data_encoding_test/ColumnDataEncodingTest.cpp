@@ -0,0 +1,177 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+// Project headers
+#include "dbengine/ColumnDataEncoding.h"
+
+// Common project headers
+#include <siodb/common/utils/PlainBinaryEncoding.h>
+
+// STL headers
+#include <random>
+#include <string>
+#include <vector>
+
+// Google Test
+#include <gtest/gtest.h>
+#include <siodb/common/unit_test/GTestOutput.h>
+
+namespace dbengine = siodb::iomgr::dbengine;
+
+namespace {
+
+constexpr std::size_t kValueCount = 10000;
+
+std::vector<std::uint8_t> makeInt64Data(const std::vector<std::int64_t>& values)
+{
+    std::vector<std::uint8_t> data(values.size() * sizeof(std::int64_t));
+    auto p = data.data();
+    for (const auto value : values)
+        p = ::pbeEncodeInt64(value, p);
+    return data;
+}
+
+void checkRoundTrip(const std::vector<std::uint8_t>& data, unsigned valueSize, bool isSigned,
+        dbengine::ColumnDataEncoding expectedEncoding)
+{
+    const auto count = data.size() / valueSize;
+    std::vector<std::uint8_t> encodedData;
+    const auto encoding =
+            dbengine::encodeIntegerColumnData(data.data(), count, valueSize, isSigned, encodedData);
+    ASSERT_EQ(encoding, expectedEncoding);
+    if (encoding == dbengine::ColumnDataEncoding::kPlain) {
+        ASSERT_TRUE(encodedData.empty());
+        return;
+    }
+    ASSERT_LT(encodedData.size(), data.size());
+
+    std::vector<std::uint8_t> decodedData(data.size());
+    ASSERT_TRUE(dbengine::decodeIntegerColumnData(encoding, encodedData.data(),
+            encodedData.size(), count, valueSize, isSigned, decodedData.data()));
+    ASSERT_EQ(decodedData, data);
+}
+
+}  // anonymous namespace
+
+TEST(ColumnDataEncoding, FrameOfReference)
+{
+    std::mt19937_64 rng(1);
+    std::uniform_int_distribution<std::int64_t> dist(-1000000000000LL, -1000000000000LL + 1000);
+    std::vector<std::int64_t> values(kValueCount);
+    for (auto& value : values)
+        value = dist(rng);
+    checkRoundTrip(makeInt64Data(values), 8, true, dbengine::ColumnDataEncoding::kFrameOfReference);
+}
+
+TEST(ColumnDataEncoding, Delta)
+{
+    std::vector<std::int64_t> values(kValueCount);
+    for (std::size_t i = 0; i < values.size(); ++i)
+        values[i] = 5000000000LL - static_cast<std::int64_t>(i) * 3;
+    checkRoundTrip(makeInt64Data(values), 8, true, dbengine::ColumnDataEncoding::kDelta);
+}
+
+TEST(ColumnDataEncoding, RunLength)
+{
+    std::mt19937_64 rng(2);
+    std::vector<std::int64_t> values(kValueCount);
+    for (std::size_t i = 0; i < values.size(); i += 100)
+        std::fill_n(values.begin() + i, 100, static_cast<std::int64_t>(rng() >> 24));
+    checkRoundTrip(makeInt64Data(values), 8, true, dbengine::ColumnDataEncoding::kRunLength);
+}
+
+TEST(ColumnDataEncoding, Dictionary)
+{
+    std::mt19937_64 rng(3);
+    std::vector<std::int64_t> distinctValues(10);
+    for (auto& value : distinctValues)
+        value = static_cast<std::int64_t>(rng() >> 24);
+    std::vector<std::int64_t> values(kValueCount);
+    for (auto& value : values)
+        value = distinctValues[rng() % distinctValues.size()];
+    checkRoundTrip(makeInt64Data(values), 8, true, dbengine::ColumnDataEncoding::kDictionary);
+}
+
+TEST(ColumnDataEncoding, SmallValueSizes)
+{
+    std::mt19937 rng(4);
+    for (const unsigned valueSize : {1U, 2U, 4U}) {
+        for (const bool isSigned : {false, true}) {
+            // Values in a small range around zero or around the middle of range
+            std::vector<std::uint8_t> data(kValueCount * valueSize);
+            for (std::size_t i = 0; i < kValueCount; ++i) {
+                const auto value = static_cast<std::uint32_t>(rng() % 7) - 3;
+                for (unsigned j = 0; j < valueSize; ++j)
+                    data[i * valueSize + j] = static_cast<std::uint8_t>(value >> (j * 8));
+            }
+            std::vector<std::uint8_t> encodedData;
+            const auto count = data.size() / valueSize;
+            const auto encoding = dbengine::encodeIntegerColumnData(
+                    data.data(), count, valueSize, isSigned, encodedData);
+            if (isSigned) {
+                ASSERT_NE(encoding, dbengine::ColumnDataEncoding::kPlain);
+            }
+            if (encoding == dbengine::ColumnDataEncoding::kPlain) continue;
+            std::vector<std::uint8_t> decodedData(data.size());
+            ASSERT_TRUE(dbengine::decodeIntegerColumnData(encoding, encodedData.data(),
+                    encodedData.size(), count, valueSize, isSigned, decodedData.data()));
+            ASSERT_EQ(decodedData, data);
+        }
+    }
+}
+
+TEST(ColumnDataEncoding, RandomValuesStayPlain)
+{
+    std::mt19937_64 rng(5);
+    std::vector<std::int64_t> values(kValueCount);
+    for (auto& value : values)
+        value = static_cast<std::int64_t>(rng());
+    checkRoundTrip(makeInt64Data(values), 8, true, dbengine::ColumnDataEncoding::kPlain);
+}
+
+TEST(ColumnDataEncoding, CorruptedData)
+{
+    std::vector<std::int64_t> values(kValueCount);
+    for (std::size_t i = 0; i < values.size(); ++i)
+        values[i] = static_cast<std::int64_t>(i / 100);
+    const auto data = makeInt64Data(values);
+    std::vector<std::uint8_t> encodedData;
+    const auto encoding =
+            dbengine::encodeIntegerColumnData(data.data(), kValueCount, 8, true, encodedData);
+    ASSERT_NE(encoding, dbengine::ColumnDataEncoding::kPlain);
+
+    // Truncated data must be detected
+    std::vector<std::uint8_t> decodedData(data.size());
+    ASSERT_FALSE(dbengine::decodeIntegerColumnData(encoding, encodedData.data(),
+            encodedData.size() - 1, kValueCount, 8, true, decodedData.data()));
+}
+
+TEST(ColumnDataEncoding, Zlib)
+{
+    std::string text;
+    for (std::size_t i = 0; i < kValueCount; ++i)
+        text += "Row #" + std::to_string(i % 100) + " of the compressible text column. ";
+    const std::vector<std::uint8_t> data(text.cbegin(), text.cend());
+
+    std::vector<std::uint8_t> compressedData;
+    ASSERT_EQ(dbengine::compressColumnData(dbengine::CompressionType::kNone, data.data(),
+                      data.size(), compressedData),
+            dbengine::ColumnDataEncoding::kPlain);
+    ASSERT_TRUE(compressedData.empty());
+
+    const auto encoding = dbengine::compressColumnData(
+            dbengine::CompressionType::kZlib, data.data(), data.size(), compressedData);
+    ASSERT_EQ(encoding, dbengine::ColumnDataEncoding::kZlib);
+    ASSERT_LT(compressedData.size(), data.size());
+
+    std::vector<std::uint8_t> decompressedData(data.size());
+    ASSERT_TRUE(dbengine::decompressColumnData(encoding, compressedData.data(),
+            compressedData.size(), decompressedData.data(), decompressedData.size()));
+    ASSERT_EQ(decompressedData, data);
+
+    // Size mismatch must be detected
+    decompressedData.resize(data.size() + 1);
+    ASSERT_FALSE(dbengine::decompressColumnData(encoding, compressedData.data(),
+            compressedData.size(), decompressedData.data(), decompressedData.size()));
+}
@@ -0,0 +1,253 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+// Project headers
+#include "dbengine/crypto/ciphers/AesCipher.h"
+#include "dbengine/io/EncryptedFile.h"
+#include "dbengine/io/NormalFile.h"
+
+// Common project headers
+#include <siodb/common/stl_wrap/filesystem_wrapper.h>
+#include <siodb/common/utils/Debug.h>
+
+// STL headers
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// CRT headers
+#include <cstdlib>
+#include <cstring>
+
+// System headers
+#include <fcntl.h>
+#include <unistd.h>
+
+// Google Test
+#include <gtest/gtest.h>
+#include <siodb/common/unit_test/GTestOutput.h>
+
+namespace dbengine = siodb::iomgr::dbengine;
+
+constexpr int kFileCreationMode = 0644;
+
+class TestEnvironment : public ::testing::Environment {
+public:
+    auto getEncryptionContext() const noexcept
+    {
+        return m_encryptionContext;
+    }
+
+    auto getDecryptionContext() const noexcept
+    {
+        return m_decryptionContext;
+    }
+
+    auto makeNewFilePath()
+    {
+        return m_testDir + "/f_" + std::to_string(++m_fileId);
+    }
+
+    void SetUp() override
+    {
+        std::ostringstream str;
+        str << ::getenv("HOME") << "/tmp/direct_io_test_" << std::time(nullptr) << '_'
+            << ::getpid();
+        m_testDir = str.str();
+        fs::create_directories(m_testDir);
+        m_fileId = 0;
+
+        const auto cipher = std::make_shared<dbengine::crypto::Aes128>();
+        const auto keySizeBytes = cipher->getKeySize() / 8;
+        siodb::BinaryValue cipherKey(keySizeBytes);
+        for (std::size_t i = 0; i < keySizeBytes; ++i)
+            cipherKey[i] = i;
+        m_encryptionContext = cipher->createEncryptionContext(cipherKey);
+        m_decryptionContext = cipher->createDecryptionContext(cipherKey);
+    }
+
+    void TearDown() override
+    {
+        // In case of failed test keep resources for debug.
+        if (testing::UnitTest::GetInstance()->Passed() && fs::exists(m_testDir)) {
+            fs::remove_all(m_testDir);
+        }
+    }
+
+private:
+    std::string m_testDir;
+    unsigned m_fileId;
+    dbengine::crypto::CipherContextPtr m_encryptionContext;
+    dbengine::crypto::CipherContextPtr m_decryptionContext;
+};
+
+// See https://stackoverflow.com/a/15341467/1540501
+TestEnvironment* g_testEnv;
+
+namespace {
+
+std::vector<std::uint8_t> makeData(std::size_t size, std::uint8_t seed)
+{
+    std::vector<std::uint8_t> data(size);
+    for (std::size_t i = 0; i < size; ++i)
+        data[i] = static_cast<std::uint8_t>(seed + i * 7);
+    return data;
+}
+
+/**
+ * Applies random unaligned writes to the file and to the reference buffer,
+ * then checks that file contents match the reference.
+ */
+void checkRandomWrites(dbengine::io::File& file, std::vector<std::uint8_t>& reference)
+{
+    std::mt19937 rng(12345);
+    for (int i = 0; i < 200; ++i) {
+        const std::size_t offset = rng() % (reference.size() - 1);
+        const std::size_t size =
+                1 + rng() % std::min<std::size_t>(reference.size() - offset, 10000);
+        const auto data = makeData(size, static_cast<std::uint8_t>(i));
+        ASSERT_EQ(file.write(data.data(), size, offset), size);
+        std::memcpy(reference.data() + offset, data.data(), size);
+    }
+
+    std::vector<std::uint8_t> contents(reference.size());
+    ASSERT_EQ(file.read(contents.data(), contents.size(), 0), contents.size());
+    ASSERT_EQ(contents, reference);
+
+    // Unaligned reads of the same data
+    for (int i = 0; i < 100; ++i) {
+        const std::size_t offset = rng() % (reference.size() - 1);
+        const std::size_t size = 1 + rng() % (reference.size() - offset);
+        std::vector<std::uint8_t> part(size);
+        ASSERT_EQ(file.read(part.data(), size, offset), size);
+        ASSERT_EQ(std::memcmp(part.data(), reference.data() + offset, size), 0);
+    }
+}
+
+}  // anonymous namespace
+
+TEST(DirectIo, NormalFileUnalignedWrites)
+{
+    constexpr std::size_t kFileSize = 100000;
+    const auto filePath = g_testEnv->makeNewFilePath();
+    std::vector<std::uint8_t> reference(kFileSize, 0);
+    {
+        dbengine::io::NormalFile file(filePath, O_DIRECT, kFileCreationMode, kFileSize);
+        if (file.isDirectIo()) EXPECT_FALSE(file.isMappable());
+        checkRandomWrites(file, reference);
+        // File size isn't rounded up to the direct I/O alignment
+        EXPECT_EQ(file.getFileSize(), static_cast<off_t>(kFileSize));
+    }
+
+    // Data is visible via page cache as well
+    dbengine::io::NormalFile file(filePath, 0);
+    std::vector<std::uint8_t> contents(kFileSize);
+    ASSERT_EQ(file.read(contents.data(), contents.size(), 0), contents.size());
+    ASSERT_EQ(contents, reference);
+}
+
+TEST(DirectIo, NormalFileAppend)
+{
+    dbengine::io::NormalFile file(g_testEnv->makeNewFilePath(), O_DIRECT, kFileCreationMode);
+    std::vector<std::uint8_t> reference;
+    for (std::size_t size = 1; size < 20000; size = size * 3 + 1) {
+        const auto data = makeData(size, static_cast<std::uint8_t>(size));
+        ASSERT_EQ(file.write(data.data(), size, reference.size()), size);
+        reference.insert(reference.end(), data.begin(), data.end());
+        ASSERT_EQ(file.getFileSize(), static_cast<off_t>(reference.size()));
+    }
+
+    std::vector<std::uint8_t> contents(reference.size());
+    ASSERT_EQ(file.read(contents.data(), contents.size(), 0), contents.size());
+    ASSERT_EQ(contents, reference);
+
+    // Read beyond end of file stops at end of file
+    std::vector<std::uint8_t> tail(100);
+    EXPECT_EQ(file.read(tail.data(), tail.size(), reference.size() - 10), 10U);
+    EXPECT_EQ(file.getLastError(), 0);
+}
+
+TEST(DirectIo, NormalFileAlignedBuffer)
+{
+    constexpr std::size_t kSize = dbengine::io::File::kDirectIoAlignment * 4;
+    dbengine::io::NormalFile file(g_testEnv->makeNewFilePath(), O_DIRECT, kFileCreationMode);
+    const auto buffer = static_cast<std::uint8_t*>(
+            std::aligned_alloc(dbengine::io::File::kDirectIoAlignment, kSize));
+    ASSERT_NE(buffer, nullptr);
+    const auto data = makeData(kSize, 3);
+    std::memcpy(buffer, data.data(), kSize);
+    EXPECT_EQ(file.write(buffer, kSize, 0), kSize);
+    std::memset(buffer, 0, kSize);
+    EXPECT_EQ(file.read(buffer, kSize, 0), kSize);
+    EXPECT_EQ(std::memcmp(buffer, data.data(), kSize), 0);
+    std::free(buffer);
+}
+
+TEST(DirectIo, NormalFileConcurrentWrites)
+{
+    // Threads write interleaved small ranges, which share direct I/O blocks
+    constexpr std::size_t kThreadCount = 4;
+    constexpr std::size_t kChunkSize = 100;
+    constexpr std::size_t kChunkCount = 200;
+    constexpr std::size_t kFileSize = kThreadCount * kChunkSize * kChunkCount;
+    dbengine::io::NormalFile file(
+            g_testEnv->makeNewFilePath(), O_DIRECT, kFileCreationMode, kFileSize);
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < kThreadCount; ++t) {
+        threads.emplace_back([&file, t] {
+            const auto data = makeData(kChunkSize, static_cast<std::uint8_t>(t + 1));
+            for (std::size_t i = 0; i < kChunkCount; ++i)
+                file.write(data.data(), kChunkSize, (i * kThreadCount + t) * kChunkSize);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    std::vector<std::uint8_t> contents(kFileSize);
+    ASSERT_EQ(file.read(contents.data(), contents.size(), 0), contents.size());
+    for (std::size_t i = 0; i < kChunkCount * kThreadCount; ++i) {
+        const auto expected = makeData(kChunkSize, static_cast<std::uint8_t>(i % kThreadCount + 1));
+        ASSERT_EQ(std::memcmp(contents.data() + i * kChunkSize, expected.data(), kChunkSize), 0);
+    }
+}
+
+TEST(DirectIo, EncryptedFile)
+{
+    constexpr std::size_t kFileSize = 50000;
+    const auto filePath = g_testEnv->makeNewFilePath();
+    auto reference = makeData(kFileSize, 1);
+    {
+        dbengine::io::EncryptedFile file(filePath, O_DIRECT, kFileCreationMode,
+                g_testEnv->getEncryptionContext(), g_testEnv->getDecryptionContext(), kFileSize);
+        // Preallocated space isn't encrypted, so fill it first
+        ASSERT_EQ(file.write(reference.data(), reference.size(), 0), reference.size());
+        checkRandomWrites(file, reference);
+        EXPECT_EQ(file.getFileSize(), static_cast<off_t>(kFileSize));
+
+        // Append beyond the preallocated size
+        const auto data = makeData(333, 77);
+        ASSERT_EQ(file.write(data.data(), data.size(), reference.size()), data.size());
+        reference.insert(reference.end(), data.begin(), data.end());
+    }
+
+    // Raw file size must stay consistent with the plaintext size
+    dbengine::io::EncryptedFile file(filePath, O_DIRECT, g_testEnv->getEncryptionContext(),
+            g_testEnv->getDecryptionContext());
+    EXPECT_EQ(file.getFileSize(), static_cast<off_t>(reference.size()));
+    std::vector<std::uint8_t> contents(reference.size());
+    ASSERT_EQ(file.read(contents.data(), contents.size(), 0), contents.size());
+    ASSERT_EQ(contents, reference);
+}
+
+int main(int argc, char** argv)
+{
+    DEBUG_SYSCALLS_LIBRARY_GUARD;
+    testing::InitGoogleTest(&argc, argv);
+    auto testEnv = new TestEnvironment();
+    testing::AddGlobalTestEnvironment(testEnv);
+    g_testEnv = testEnv;
+    return RUN_ALL_TESTS();
+}
@@ -553,6 +553,55 @@ TEST(EncryptedFile, RandomReadWrite)
     }
 }
 
+// Test does:
+// 1) Creates a file and fills it with data
+// 2) Reads small values, so that they are cached
+// 3) Overwrites and appends small values near cached ones
+// 4) Checks that small reads see new data
+TEST(EncryptedFile, SmallReadsAfterWrites)
+{
+    using namespace siodb;
+    using namespace siodb::iomgr::dbengine;
+
+    constexpr std::size_t kFileSize = 20000;
+    siodb::BinaryValue data(kFileSize);
+    for (std::size_t i = 0; i < kFileSize; ++i)
+        data[i] = static_cast<std::uint8_t>(i * 13);
+
+    io::EncryptedFile file(g_testEnv->makeNewFilePath(), 0, kFileCreationMode,
+            g_testEnv->getEncryptionContext(), g_testEnv->getDecryptionContext(), 0);
+    ASSERT_EQ(file.write(data.data(), data.size(), 0), data.size());
+
+    std::mt19937 gen(777);
+    for (int i = 0; i < 1000; ++i) {
+        const std::size_t pos = gen() % (data.size() - 8);
+        const std::size_t len = 1 + gen() % 8;
+        std::uint8_t value[8];
+        ASSERT_EQ(file.read(value, len, pos), len);
+        ASSERT_EQ(std::memcmp(value, data.data() + pos, len), 0);
+
+        if (i % 3 == 0) {
+            // Overwrite nearby value
+            const auto writePos = std::min(pos + gen() % 64, data.size() - len);
+            for (std::size_t j = 0; j < len; ++j)
+                data[writePos + j] = static_cast<std::uint8_t>(gen());
+            ASSERT_EQ(file.write(data.data() + writePos, len, writePos), len);
+        } else if (i % 10 == 1) {
+            // Append value
+            const auto writePos = data.size();
+            data.resize(writePos + len);
+            for (std::size_t j = 0; j < len; ++j)
+                data[writePos + j] = static_cast<std::uint8_t>(gen());
+            ASSERT_EQ(file.write(data.data() + writePos, len, writePos), len);
+        }
+    }
+
+    // Whole file is consistent with small reads
+    siodb::BinaryValue contents(data.size());
+    ASSERT_EQ(file.read(contents.data(), contents.size(), 0), contents.size());
+    EXPECT_EQ(contents, data);
+}
+
 int main(int argc, char** argv)
 {
     DEBUG_SYSCALLS_LIBRARY_GUARD;
@@ -81,3 +81,19 @@ TEST(Serialization_Other, ListExpression)
     const auto expr = std::make_unique<requests::ListExpression>(std::move(items));
     testExpressionSerialization(*expr, kExpectedSerializedSize);
 }
+
+TEST(Serialization_Other, AggregateFunction)
+{
+    constexpr std::size_t kExpectedSerializedSize = 5;
+    const auto expr = std::make_unique<requests::AggregateFunction>(
+            requests::ExpressionType::kSumFunction, makeConstant(1));
+    testExpressionSerialization(*expr, kExpectedSerializedSize);
+}
+
+TEST(Serialization_Other, CountAllFunction)
+{
+    constexpr std::size_t kExpectedSerializedSize = 2;
+    const auto expr = std::make_unique<requests::AggregateFunction>(
+            requests::ExpressionType::kCountFunction, nullptr);
+    testExpressionSerialization(*expr, kExpectedSerializedSize);
+}
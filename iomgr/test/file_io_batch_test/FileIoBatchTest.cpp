@@ -0,0 +1,173 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+// Project headers
+#include "dbengine/crypto/ciphers/AesCipher.h"
+#include "dbengine/io/EncryptedFile.h"
+#include "dbengine/io/FileIoBatch.h"
+#include "dbengine/io/NormalFile.h"
+
+// Common project headers
+#include <siodb/common/stl_wrap/filesystem_wrapper.h>
+#include <siodb/common/utils/Debug.h>
+
+// STL headers
+#include <memory>
+#include <sstream>
+#include <vector>
+
+// CRT headers
+#include <cstring>
+
+// Google Test
+#include <gtest/gtest.h>
+#include <siodb/common/unit_test/GTestOutput.h>
+
+namespace dbengine = siodb::iomgr::dbengine;
+
+constexpr int kFileCreationMode = 0644;
+
+class TestEnvironment : public ::testing::Environment {
+public:
+    auto makeNewFilePath()
+    {
+        return m_testDir + "/f_" + std::to_string(++m_fileId);
+    }
+
+    void SetUp() override
+    {
+        std::ostringstream str;
+        str << ::getenv("HOME") << "/tmp/file_io_batch_test_" << std::time(nullptr) << '_'
+            << ::getpid();
+        m_testDir = str.str();
+        fs::create_directories(m_testDir);
+        m_fileId = 0;
+    }
+
+    void TearDown() override
+    {
+        // In case of failed test keep resources for debug.
+        if (testing::UnitTest::GetInstance()->Passed() && fs::exists(m_testDir)) {
+            fs::remove_all(m_testDir);
+        }
+    }
+
+private:
+    std::string m_testDir;
+    unsigned m_fileId;
+};
+
+// See https://stackoverflow.com/a/15341467/1540501
+TestEnvironment* g_testEnv;
+
+namespace {
+
+std::vector<std::uint8_t> makeData(std::size_t size, std::uint8_t seed)
+{
+    std::vector<std::uint8_t> data(size);
+    for (std::size_t i = 0; i < size; ++i)
+        data[i] = static_cast<std::uint8_t>(seed + i * 7);
+    return data;
+}
+
+}  // namespace
+
+// Writes and reads back many chunks of several files with single batch each time.
+// Number of operations exceeds io_uring queue size, so that chunked submission is tested too.
+TEST(FileIoBatch, NormalFiles)
+{
+    constexpr std::size_t kFileCount = 4;
+    constexpr std::size_t kChunkCount = 50;
+    constexpr std::size_t kChunkSize = 4096 + 17;
+
+    TEST_COUT << "io_uring available: " << dbengine::io::FileIoBatch::isIoUringAvailable()
+              << std::endl;
+
+    std::vector<dbengine::io::FilePtr> files;
+    for (std::size_t i = 0; i < kFileCount; ++i) {
+        files.push_back(std::make_unique<dbengine::io::NormalFile>(
+                g_testEnv->makeNewFilePath(), 0, kFileCreationMode));
+    }
+
+    std::vector<std::vector<std::uint8_t>> chunks;
+    dbengine::io::FileIoBatch writeBatch;
+    for (std::size_t i = 0; i < kFileCount * kChunkCount; ++i) {
+        chunks.push_back(makeData(kChunkSize, static_cast<std::uint8_t>(i)));
+        writeBatch.addWrite(*files[i % kFileCount], chunks.back().data(), kChunkSize,
+                (i / kFileCount) * kChunkSize);
+    }
+    ASSERT_TRUE(writeBatch.execute());
+    for (std::size_t i = 0; i < writeBatch.size(); ++i)
+        ASSERT_EQ(writeBatch.getResult(i), kChunkSize);
+
+    std::vector<std::vector<std::uint8_t>> readChunks(
+            kFileCount * kChunkCount, std::vector<std::uint8_t>(kChunkSize));
+    dbengine::io::FileIoBatch readBatch;
+    for (std::size_t i = 0; i < readChunks.size(); ++i) {
+        readBatch.addRead(*files[i % kFileCount], readChunks[i].data(), kChunkSize,
+                (i / kFileCount) * kChunkSize);
+    }
+    ASSERT_TRUE(readBatch.execute());
+    for (std::size_t i = 0; i < readChunks.size(); ++i)
+        ASSERT_EQ(readChunks[i], chunks[i]);
+}
+
+// Reading beyond end of file must fail just like regular read does.
+TEST(FileIoBatch, ReadPastEndOfFile)
+{
+    dbengine::io::NormalFile file(g_testEnv->makeNewFilePath(), 0, kFileCreationMode);
+    const auto data = makeData(100, 1);
+    ASSERT_EQ(file.write(data.data(), data.size(), 0), data.size());
+
+    std::vector<std::uint8_t> buffer1(50), buffer2(100);
+    dbengine::io::FileIoBatch batch;
+    batch.addRead(file, buffer1.data(), buffer1.size(), 0);
+    batch.addRead(file, buffer2.data(), buffer2.size(), 50);
+    ASSERT_FALSE(batch.execute());
+    ASSERT_EQ(batch.getResult(0), buffer1.size());
+    ASSERT_EQ(batch.getResult(1), 50U);
+    ASSERT_EQ(std::memcmp(buffer1.data(), data.data(), buffer1.size()), 0);
+}
+
+// Encrypted files are not submitted to io_uring, but must work in the same batch.
+TEST(FileIoBatch, MixedFiles)
+{
+    const auto cipher = std::make_shared<dbengine::crypto::Aes128>();
+    siodb::BinaryValue cipherKey(cipher->getKeySize() / 8);
+    for (std::size_t i = 0; i < cipherKey.size(); ++i)
+        cipherKey[i] = i;
+
+    dbengine::io::NormalFile normalFile(g_testEnv->makeNewFilePath(), 0, kFileCreationMode);
+    dbengine::io::EncryptedFile encryptedFile(g_testEnv->makeNewFilePath(), 0, kFileCreationMode,
+            cipher->createEncryptionContext(cipherKey), cipher->createDecryptionContext(cipherKey));
+
+    const auto data1 = makeData(1000, 3);
+    const auto data2 = makeData(3000, 5);
+    dbengine::io::FileIoBatch writeBatch;
+    writeBatch.addWrite(normalFile, data1.data(), data1.size(), 0);
+    writeBatch.addWrite(encryptedFile, data2.data(), data2.size(), 0);
+    writeBatch.addWrite(normalFile, data2.data(), data2.size(), data1.size());
+    ASSERT_TRUE(writeBatch.execute());
+
+    std::vector<std::uint8_t> buffer1(data1.size()), buffer2(data2.size()),
+            buffer3(data2.size());
+    dbengine::io::FileIoBatch readBatch;
+    readBatch.addRead(encryptedFile, buffer2.data(), buffer2.size(), 0);
+    readBatch.addRead(normalFile, buffer1.data(), buffer1.size(), 0);
+    readBatch.addRead(normalFile, buffer3.data(), buffer3.size(), data1.size());
+    ASSERT_TRUE(readBatch.execute());
+    ASSERT_EQ(buffer1, data1);
+    ASSERT_EQ(buffer2, data2);
+    ASSERT_EQ(buffer3, data2);
+}
+
+int main(int argc, char** argv)
+{
+    DEBUG_SYSCALLS_LIBRARY_GUARD;
+    testing::InitGoogleTest(&argc, argv);
+    auto testEnv = new TestEnvironment();
+    testing::AddGlobalTestEnvironment(testEnv);
+    g_testEnv = testEnv;
+    return RUN_ALL_TESTS();
+}
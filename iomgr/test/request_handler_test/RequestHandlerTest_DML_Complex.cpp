@@ -3,7 +3,8 @@
 // in the LICENSE file.
 
 // Project headers
-#include "RequestHandlerTest_TestEnv.h"
+#include "RequestHandlerTest_Helpers.h"
+#include "dbengine/ColumnSpecification.h"
 #include "dbengine/parser/DBEngineRequestFactory.h"
 #include "dbengine/parser/SqlParser.h"
 
@@ -11,6 +12,9 @@
 #include <siodb/common/protobuf/ProtobufMessageIO.h>
 #include <siodb/common/protobuf/RawDateTimeIO.h>
 
+// STL headers
+#include <sstream>
+
 // Boost headers
 #include <boost/endian/conversion.hpp>
 
@@ -524,3 +528,86 @@ TEST(DML_Complex, ComplexInsertUpdateDeleteTest)
         EXPECT_EQ(rowLength, 0U);
     }
 }
+
+/** Test checks that range predicates skip blocks without losing rows of other blocks */
+TEST(DML_Complex, RangePredicatesWithBlockSkipping)
+{
+    const auto instance = TestEnvironment::getInstance();
+    ASSERT_NE(instance, nullptr);
+    const auto requestHandler = TestEnvironment::makeRequestHandler();
+
+    // Small data blocks, so that values are spread over many blocks
+    constexpr std::uint32_t kDataBlockDataAreaSize = 256;
+    const std::vector<dbengine::ColumnSpecification> tableColumns {
+            {"V", siodb::COLUMN_DATA_TYPE_INT32, kDataBlockDataAreaSize},
+            {"N", siodb::COLUMN_DATA_TYPE_INT32, kDataBlockDataAreaSize},
+    };
+    instance->getDatabase("SYS")->createUserTable("COMPLEX_TEST_ZONE_MAP",
+            dbengine::TableType::kDisk, tableColumns, dbengine::User::kSuperUserId);
+
+    // Every third N is NULL
+    constexpr int kRowCount = 300;
+    std::ostringstream insert;
+    insert << "INSERT INTO SYS.COMPLEX_TEST_ZONE_MAP VALUES ";
+    for (int i = 0; i < kRowCount; ++i) {
+        if (i > 0) insert << ", ";
+        insert << '(' << i << ", ";
+        if (i % 3 == 0)
+            insert << "NULL";
+        else
+            insert << i;
+        insert << ')';
+    }
+    ASSERT_EQ(executeStatementChecked(*requestHandler, insert.str()), 300U);
+
+    const auto makeRows = [](int first, int last) {
+        QueryResultRows rows;
+        for (int i = first; i <= last; ++i)
+            rows.push_back({std::to_string(i)});
+        return rows;
+    };
+
+    EXPECT_EQ(executeQueryChecked(*requestHandler,
+                      "SELECT V FROM SYS.COMPLEX_TEST_ZONE_MAP WHERE V = 123"),
+            makeRows(123, 123));
+    EXPECT_EQ(executeQueryChecked(*requestHandler,
+                      "SELECT V FROM SYS.COMPLEX_TEST_ZONE_MAP WHERE V < 5"),
+            makeRows(0, 4));
+    EXPECT_EQ(executeQueryChecked(*requestHandler,
+                      "SELECT V FROM SYS.COMPLEX_TEST_ZONE_MAP WHERE V >= 295"),
+            makeRows(295, 299));
+    EXPECT_EQ(executeQueryChecked(*requestHandler,
+                      "SELECT V FROM SYS.COMPLEX_TEST_ZONE_MAP WHERE V BETWEEN 150 AND 170"),
+            makeRows(150, 170));
+    EXPECT_EQ(executeQueryChecked(*requestHandler,
+                      "SELECT V FROM SYS.COMPLEX_TEST_ZONE_MAP WHERE V IN (7, 150, 299, 1000)"),
+            QueryResultRows({{"7"}, {"150"}, {"299"}}));
+    EXPECT_EQ(executeQueryChecked(*requestHandler,
+                      "SELECT V FROM SYS.COMPLEX_TEST_ZONE_MAP WHERE N BETWEEN 10 AND 15"),
+            QueryResultRows({{"10"}, {"11"}, {"13"}, {"14"}}));
+    EXPECT_EQ(executeQueryChecked(*requestHandler,
+                      "SELECT V FROM SYS.COMPLEX_TEST_ZONE_MAP WHERE V > 40 AND V < 45 AND N > 0"),
+            QueryResultRows({{"41"}, {"43"}, {"44"}}));
+
+    // Updated rows get new values, which must be found by their new range
+    EXPECT_EQ(executeStatementChecked(*requestHandler,
+                      "UPDATE SYS.COMPLEX_TEST_ZONE_MAP SET V = V + 1000 "
+                      "WHERE V BETWEEN 200 AND 209"),
+            10U);
+    EXPECT_EQ(executeQueryChecked(*requestHandler,
+                      "SELECT V FROM SYS.COMPLEX_TEST_ZONE_MAP WHERE V >= 1000"),
+            makeRows(1200, 1209));
+    EXPECT_TRUE(executeQueryChecked(*requestHandler,
+            "SELECT V FROM SYS.COMPLEX_TEST_ZONE_MAP WHERE V BETWEEN 200 AND 209")
+                        .empty());
+
+    EXPECT_EQ(executeStatementChecked(
+                      *requestHandler, "DELETE FROM SYS.COMPLEX_TEST_ZONE_MAP WHERE V < 100"),
+            100U);
+    EXPECT_EQ(executeQueryChecked(*requestHandler,
+                      "SELECT V FROM SYS.COMPLEX_TEST_ZONE_MAP WHERE V BETWEEN 95 AND 104"),
+            makeRows(100, 104));
+    EXPECT_EQ(executeQueryChecked(*requestHandler, "SELECT V FROM SYS.COMPLEX_TEST_ZONE_MAP")
+                      .size(),
+            200U);
+}
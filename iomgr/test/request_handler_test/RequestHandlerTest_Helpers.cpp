@@ -0,0 +1,201 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#include "RequestHandlerTest_Helpers.h"
+
+// Project headers
+#include "dbengine/parser/DBEngineRequestFactory.h"
+#include "dbengine/parser/SqlParser.h"
+
+// Common project headers
+#include <siodb/common/protobuf/ProtobufMessageIO.h>
+
+// STL headers
+#include <algorithm>
+#include <sstream>
+
+// Boost headers
+#include <boost/endian/conversion.hpp>
+
+// Google Test
+#include <gtest/gtest.h>
+
+namespace parser_ns = dbengine::parser;
+
+namespace {
+
+siodb::iomgr_protocol::DatabaseEngineResponse executeRequest(
+        dbengine::RequestHandler& requestHandler, const std::string& statement,
+        siodb::protobuf::CustomProtobufInputStream& inputStream)
+{
+    parser_ns::SqlParser parser(statement);
+    parser.parse();
+
+    const auto request = parser_ns::DBEngineRequestFactory::createRequest(parser.findStatement(0));
+    requestHandler.executeRequest(*request, TestEnvironment::kTestRequestId, 0, 1);
+
+    siodb::iomgr_protocol::DatabaseEngineResponse response;
+    siodb::protobuf::readMessage(siodb::protobuf::ProtocolMessageType::kDatabaseEngineResponse,
+            response, inputStream);
+    EXPECT_EQ(response.request_id(), TestEnvironment::kTestRequestId);
+    return response;
+}
+
+template<class T>
+bool readRawValue(google::protobuf::io::CodedInputStream& codedInput, std::string& text)
+{
+    T value = 0;
+    if (!codedInput.ReadRaw(&value, sizeof(value))) return false;
+    boost::endian::little_to_native_inplace(value);
+    text = std::to_string(value);
+    return true;
+}
+
+bool readValue(google::protobuf::io::CodedInputStream& codedInput, siodb::ColumnDataType type,
+        std::string& text)
+{
+    switch (type) {
+        case siodb::COLUMN_DATA_TYPE_BOOL: {
+            std::uint8_t value = 0;
+            if (!codedInput.ReadRaw(&value, sizeof(value))) return false;
+            text = value ? "true" : "false";
+            return true;
+        }
+        case siodb::COLUMN_DATA_TYPE_INT8: return readRawValue<std::int8_t>(codedInput, text);
+        case siodb::COLUMN_DATA_TYPE_UINT8: return readRawValue<std::uint8_t>(codedInput, text);
+        case siodb::COLUMN_DATA_TYPE_INT16: return readRawValue<std::int16_t>(codedInput, text);
+        case siodb::COLUMN_DATA_TYPE_UINT16: return readRawValue<std::uint16_t>(codedInput, text);
+        case siodb::COLUMN_DATA_TYPE_INT32: {
+            std::uint32_t value = 0;
+            if (!codedInput.ReadVarint32(&value)) return false;
+            text = std::to_string(static_cast<std::int32_t>(value));
+            return true;
+        }
+        case siodb::COLUMN_DATA_TYPE_UINT32: {
+            std::uint32_t value = 0;
+            if (!codedInput.ReadVarint32(&value)) return false;
+            text = std::to_string(value);
+            return true;
+        }
+        case siodb::COLUMN_DATA_TYPE_INT64: {
+            std::uint64_t value = 0;
+            if (!codedInput.ReadVarint64(&value)) return false;
+            text = std::to_string(static_cast<std::int64_t>(value));
+            return true;
+        }
+        case siodb::COLUMN_DATA_TYPE_UINT64: {
+            std::uint64_t value = 0;
+            if (!codedInput.ReadVarint64(&value)) return false;
+            text = std::to_string(value);
+            return true;
+        }
+        case siodb::COLUMN_DATA_TYPE_FLOAT: {
+            union {
+                float m_floatValue;
+                std::uint32_t m_uint32Value;
+            } v;
+            if (!codedInput.ReadLittleEndian32(&v.m_uint32Value)) return false;
+            std::ostringstream oss;
+            oss << v.m_floatValue;
+            text = oss.str();
+            return true;
+        }
+        case siodb::COLUMN_DATA_TYPE_DOUBLE: {
+            union {
+                double m_doubleValue;
+                std::uint64_t m_uint64Value;
+            } v;
+            if (!codedInput.ReadLittleEndian64(&v.m_uint64Value)) return false;
+            std::ostringstream oss;
+            oss << v.m_doubleValue;
+            text = oss.str();
+            return true;
+        }
+        case siodb::COLUMN_DATA_TYPE_TEXT:
+        case siodb::COLUMN_DATA_TYPE_BINARY: {
+            std::uint32_t size = 0;
+            if (!codedInput.ReadVarint32(&size)) return false;
+            return codedInput.ReadString(&text, size);
+        }
+        default: {
+            ADD_FAILURE() << "Unsupported column data type " << static_cast<int>(type);
+            return false;
+        }
+    }
+}
+
+}  // namespace
+
+siodb::iomgr_protocol::DatabaseEngineResponse executeStatement(
+        dbengine::RequestHandler& requestHandler, const std::string& statement)
+{
+    siodb::protobuf::CustomProtobufInputStream inputStream(
+            TestEnvironment::getInputStream(), siodb::utils::DefaultErrorCodeChecker());
+    return executeRequest(requestHandler, statement, inputStream);
+}
+
+std::uint64_t executeStatementChecked(
+        dbengine::RequestHandler& requestHandler, const std::string& statement)
+{
+    const auto response = executeStatement(requestHandler, statement);
+    EXPECT_EQ(response.message_size(), 0) << statement << ": " << response.message(0).text();
+    return response.affected_row_count();
+}
+
+siodb::iomgr_protocol::DatabaseEngineResponse executeQuery(dbengine::RequestHandler& requestHandler,
+        const std::string& statement, QueryResultRows& rows)
+{
+    rows.clear();
+    siodb::protobuf::CustomProtobufInputStream inputStream(
+            TestEnvironment::getInputStream(), siodb::utils::DefaultErrorCodeChecker());
+    auto response = executeRequest(requestHandler, statement, inputStream);
+    if (response.message_size() > 0) return response;
+
+    const auto columnCount = static_cast<std::size_t>(response.column_description_size());
+    bool hasNullMask = false;
+    for (std::size_t i = 0; i < columnCount; ++i)
+        hasNullMask |= response.column_description(i).is_null();
+
+    google::protobuf::io::CodedInputStream codedInput(&inputStream);
+    std::vector<std::uint8_t> nullMask((columnCount + 7) / 8);
+    while (true) {
+        std::uint64_t rowLength = 0;
+        if (!codedInput.ReadVarint64(&rowLength)) {
+            ADD_FAILURE() << "Can't read row length";
+            break;
+        }
+        if (rowLength == 0) break;
+
+        if (hasNullMask && !codedInput.ReadRaw(nullMask.data(), nullMask.size())) {
+            ADD_FAILURE() << "Can't read null bitmask";
+            break;
+        }
+
+        auto& row = rows.emplace_back(columnCount);
+        for (std::size_t i = 0; i < columnCount; ++i) {
+            if (hasNullMask && (nullMask[i / 8] & (1 << (i % 8))) != 0)
+                row[i] = "NULL";
+            else if (!readValue(codedInput, response.column_description(i).type(), row[i])) {
+                ADD_FAILURE() << "Can't read value of the column " << i;
+                return response;
+            }
+        }
+    }
+    return response;
+}
+
+QueryResultRows executeQueryChecked(
+        dbengine::RequestHandler& requestHandler, const std::string& statement)
+{
+    QueryResultRows rows;
+    const auto response = executeQuery(requestHandler, statement, rows);
+    EXPECT_EQ(response.message_size(), 0) << statement << ": " << response.message(0).text();
+    return rows;
+}
+
+QueryResultRows sortRows(QueryResultRows rows)
+{
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
@@ -0,0 +1,60 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+#pragma once
+
+// Project headers
+#include "RequestHandlerTest_TestEnv.h"
+
+// STL headers
+#include <string>
+#include <vector>
+
+/** Rows of the query result. Values are converted to text, NULL values are "NULL". */
+using QueryResultRows = std::vector<std::vector<std::string>>;
+
+/**
+ * Executes SQL statement, which doesn't return rows.
+ * @param requestHandler Request handler.
+ * @param statement SQL statement.
+ * @return Response.
+ */
+siodb::iomgr_protocol::DatabaseEngineResponse executeStatement(
+        dbengine::RequestHandler& requestHandler, const std::string& statement);
+
+/**
+ * Executes SQL statement, which doesn't return rows, and checks that it succeeded.
+ * @param requestHandler Request handler.
+ * @param statement SQL statement.
+ * @return Affected row count.
+ */
+std::uint64_t executeStatementChecked(
+        dbengine::RequestHandler& requestHandler, const std::string& statement);
+
+/**
+ * Executes SQL query and reads all result rows.
+ * @param requestHandler Request handler.
+ * @param statement SQL query.
+ * @param[out] rows Result rows, left empty if query failed.
+ * @return Response.
+ */
+siodb::iomgr_protocol::DatabaseEngineResponse executeQuery(dbengine::RequestHandler& requestHandler,
+        const std::string& statement, QueryResultRows& rows);
+
+/**
+ * Executes SQL query, checks that it succeeded and returns result rows.
+ * @param requestHandler Request handler.
+ * @param statement SQL query.
+ * @return Result rows.
+ */
+QueryResultRows executeQueryChecked(
+        dbengine::RequestHandler& requestHandler, const std::string& statement);
+
+/**
+ * Returns rows sorted in lexicographical order of their values,
+ * for comparison of results which order is not defined.
+ * @param rows Rows.
+ * @return Sorted rows.
+ */
+QueryResultRows sortRows(QueryResultRows rows);
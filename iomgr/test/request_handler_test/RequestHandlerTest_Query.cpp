@@ -1903,4 +1903,305 @@ TEST(Query, SelectWithWhere_LimitAndOffset)
         ASSERT_TRUE(codedInput.ReadVarint64(&rowLength));
         EXPECT_EQ(rowLength, 0U);
     }
-}
\ No newline at end of file
+}
+TEST(Query, SelectWithOrderBy)
+{
+    const auto instance = TestEnvironment::getInstance();
+    ASSERT_NE(instance, nullptr);
+    const auto requestHandler = TestEnvironment::makeRequestHandler();
+
+    siodb::protobuf::CustomProtobufInputStream inputStream(
+            TestEnvironment::getInputStream(), siodb::utils::DefaultErrorCodeChecker());
+
+    // create table
+    const std::vector<dbengine::SimpleColumnSpecification> tableColumns {
+            {"A", siodb::COLUMN_DATA_TYPE_INT32, true},
+            {"B", siodb::COLUMN_DATA_TYPE_INT32, true},
+    };
+
+    instance->getDatabase("SYS")->createUserTable("SELECT_WITH_ORDER_BY_1",
+            dbengine::TableType::kDisk, tableColumns, dbengine::User::kSuperUserId);
+
+    /// ----------- INSERT -----------
+    {
+        const std::string statement(
+                "INSERT INTO SYS.SELECT_WITH_ORDER_BY_1 VALUES (3, 1), (1, 2), (2, 3), (3, 0), "
+                "(1, 5)");
+
+        parser_ns::SqlParser parser(statement);
+        parser.parse();
+
+        const auto insertRequest =
+                parser_ns::DBEngineRequestFactory::createRequest(parser.findStatement(0));
+
+        requestHandler->executeRequest(*insertRequest, TestEnvironment::kTestRequestId, 0, 1);
+
+        siodb::iomgr_protocol::DatabaseEngineResponse response;
+        siodb::protobuf::readMessage(siodb::protobuf::ProtocolMessageType::kDatabaseEngineResponse,
+                response, inputStream);
+
+        EXPECT_EQ(response.request_id(), TestEnvironment::kTestRequestId);
+        ASSERT_EQ(response.message_size(), 0);
+        EXPECT_TRUE(response.has_affected_row_count());
+        ASSERT_EQ(response.affected_row_count(), 5U);
+    }
+
+    /// ----------- SELECT -----------
+    {
+        const std::string statement(
+                "SELECT A, B FROM SYS.SELECT_WITH_ORDER_BY_1 ORDER BY A DESC, 2");
+        parser_ns::SqlParser parser(statement);
+        parser.parse();
+
+        const auto selectRequest =
+                parser_ns::DBEngineRequestFactory::createRequest(parser.findStatement(0));
+
+        siodb::iomgr_protocol::DatabaseEngineResponse response;
+        requestHandler->executeRequest(*selectRequest, TestEnvironment::kTestRequestId, 0, 1);
+        siodb::protobuf::readMessage(siodb::protobuf::ProtocolMessageType::kDatabaseEngineResponse,
+                response, inputStream);
+
+        EXPECT_EQ(response.request_id(), TestEnvironment::kTestRequestId);
+        ASSERT_EQ(response.message_size(), 0);
+        EXPECT_FALSE(response.has_affected_row_count());
+        ASSERT_EQ(response.column_description_size(), 2);
+
+        const std::vector<std::pair<std::int32_t, std::int32_t>> expectedRows {
+                {3, 0}, {3, 1}, {2, 3}, {1, 2}, {1, 5}};
+
+        google::protobuf::io::CodedInputStream codedInput(&inputStream);
+        std::uint64_t rowLength = 0;
+        for (const auto& expectedRow : expectedRows) {
+            ASSERT_TRUE(codedInput.ReadVarint64(&rowLength));
+            ASSERT_TRUE(rowLength > 0);
+
+            std::int32_t a = 0, b = 0;
+            ASSERT_TRUE(codedInput.ReadVarint32(reinterpret_cast<std::uint32_t*>(&a)));
+            ASSERT_TRUE(codedInput.ReadVarint32(reinterpret_cast<std::uint32_t*>(&b)));
+            EXPECT_EQ(a, expectedRow.first);
+            EXPECT_EQ(b, expectedRow.second);
+        }
+
+        ASSERT_TRUE(codedInput.ReadVarint64(&rowLength));
+        EXPECT_EQ(rowLength, 0U);
+    }
+}
+
+TEST(Query, SelectWithOrderByAndLimit)
+{
+    const auto instance = TestEnvironment::getInstance();
+    ASSERT_NE(instance, nullptr);
+    const auto requestHandler = TestEnvironment::makeRequestHandler();
+
+    siodb::protobuf::CustomProtobufInputStream inputStream(
+            TestEnvironment::getInputStream(), siodb::utils::DefaultErrorCodeChecker());
+
+    // create table
+    const std::vector<dbengine::SimpleColumnSpecification> tableColumns {
+            {"A", siodb::COLUMN_DATA_TYPE_INT32, true},
+    };
+
+    instance->getDatabase("SYS")->createUserTable("SELECT_WITH_ORDER_BY_AND_LIMIT_1",
+            dbengine::TableType::kDisk, tableColumns, dbengine::User::kSuperUserId);
+
+    /// ----------- INSERT -----------
+    {
+        const std::string statement(
+                "INSERT INTO SYS.SELECT_WITH_ORDER_BY_AND_LIMIT_1 VALUES (4), (9), (0), (7), (2), "
+                "(5), (8), (1), (6), (3)");
+
+        parser_ns::SqlParser parser(statement);
+        parser.parse();
+
+        const auto insertRequest =
+                parser_ns::DBEngineRequestFactory::createRequest(parser.findStatement(0));
+
+        requestHandler->executeRequest(*insertRequest, TestEnvironment::kTestRequestId, 0, 1);
+
+        siodb::iomgr_protocol::DatabaseEngineResponse response;
+        siodb::protobuf::readMessage(siodb::protobuf::ProtocolMessageType::kDatabaseEngineResponse,
+                response, inputStream);
+
+        EXPECT_EQ(response.request_id(), TestEnvironment::kTestRequestId);
+        ASSERT_EQ(response.message_size(), 0);
+        EXPECT_TRUE(response.has_affected_row_count());
+        ASSERT_EQ(response.affected_row_count(), 10U);
+    }
+
+    /// ----------- SELECT -----------
+    {
+        const std::string statement(
+                "SELECT A AS X FROM SYS.SELECT_WITH_ORDER_BY_AND_LIMIT_1 ORDER BY X DESC "
+                "LIMIT 3 OFFSET 2");
+        parser_ns::SqlParser parser(statement);
+        parser.parse();
+
+        const auto selectRequest =
+                parser_ns::DBEngineRequestFactory::createRequest(parser.findStatement(0));
+
+        siodb::iomgr_protocol::DatabaseEngineResponse response;
+        requestHandler->executeRequest(*selectRequest, TestEnvironment::kTestRequestId, 0, 1);
+        siodb::protobuf::readMessage(siodb::protobuf::ProtocolMessageType::kDatabaseEngineResponse,
+                response, inputStream);
+
+        EXPECT_EQ(response.request_id(), TestEnvironment::kTestRequestId);
+        ASSERT_EQ(response.message_size(), 0);
+        EXPECT_FALSE(response.has_affected_row_count());
+        ASSERT_EQ(response.column_description_size(), 1);
+        EXPECT_EQ(response.column_description(0).name(), "X");
+
+        google::protobuf::io::CodedInputStream codedInput(&inputStream);
+        std::uint64_t rowLength = 0;
+        for (auto i = 7; i > 4; --i) {
+            ASSERT_TRUE(codedInput.ReadVarint64(&rowLength));
+            ASSERT_TRUE(rowLength > 0);
+
+            std::int32_t a = 0;
+            ASSERT_TRUE(codedInput.ReadVarint32(reinterpret_cast<std::uint32_t*>(&a)));
+            EXPECT_EQ(a, i);
+        }
+
+        ASSERT_TRUE(codedInput.ReadVarint64(&rowLength));
+        EXPECT_EQ(rowLength, 0U);
+    }
+}
+
+TEST(Query, SelectWithGroupBy)
+{
+    const auto instance = TestEnvironment::getInstance();
+    ASSERT_NE(instance, nullptr);
+    const auto requestHandler = TestEnvironment::makeRequestHandler();
+
+    siodb::protobuf::CustomProtobufInputStream inputStream(
+            TestEnvironment::getInputStream(), siodb::utils::DefaultErrorCodeChecker());
+
+    // create table
+    const std::vector<dbengine::SimpleColumnSpecification> tableColumns {
+            {"A", siodb::COLUMN_DATA_TYPE_INT32, true},
+            {"B", siodb::COLUMN_DATA_TYPE_INT32, true},
+    };
+
+    instance->getDatabase("SYS")->createUserTable("SELECT_WITH_GROUP_BY_1",
+            dbengine::TableType::kDisk, tableColumns, dbengine::User::kSuperUserId);
+
+    /// ----------- INSERT -----------
+    {
+        const std::string statement(
+                "INSERT INTO SYS.SELECT_WITH_GROUP_BY_1 VALUES (1, 10), (2, 5), (1, 20), (3, 7), "
+                "(2, 1), (1, 30)");
+
+        parser_ns::SqlParser parser(statement);
+        parser.parse();
+
+        const auto insertRequest =
+                parser_ns::DBEngineRequestFactory::createRequest(parser.findStatement(0));
+
+        requestHandler->executeRequest(*insertRequest, TestEnvironment::kTestRequestId, 0, 1);
+
+        siodb::iomgr_protocol::DatabaseEngineResponse response;
+        siodb::protobuf::readMessage(siodb::protobuf::ProtocolMessageType::kDatabaseEngineResponse,
+                response, inputStream);
+
+        EXPECT_EQ(response.request_id(), TestEnvironment::kTestRequestId);
+        ASSERT_EQ(response.message_size(), 0);
+        EXPECT_TRUE(response.has_affected_row_count());
+        ASSERT_EQ(response.affected_row_count(), 6U);
+    }
+
+    /// ----------- SELECT -----------
+    {
+        const std::string statement(
+                "SELECT A, COUNT(*), SUM(B), MIN(B), MAX(B) FROM SYS.SELECT_WITH_GROUP_BY_1 "
+                "GROUP BY A HAVING COUNT(*) > 1 ORDER BY A");
+        parser_ns::SqlParser parser(statement);
+        parser.parse();
+
+        const auto selectRequest =
+                parser_ns::DBEngineRequestFactory::createRequest(parser.findStatement(0));
+
+        siodb::iomgr_protocol::DatabaseEngineResponse response;
+        requestHandler->executeRequest(*selectRequest, TestEnvironment::kTestRequestId, 0, 1);
+        siodb::protobuf::readMessage(siodb::protobuf::ProtocolMessageType::kDatabaseEngineResponse,
+                response, inputStream);
+
+        EXPECT_EQ(response.request_id(), TestEnvironment::kTestRequestId);
+        ASSERT_EQ(response.message_size(), 0);
+        EXPECT_FALSE(response.has_affected_row_count());
+        ASSERT_EQ(response.column_description_size(), 5);
+        EXPECT_EQ(response.column_description(1).type(), siodb::COLUMN_DATA_TYPE_INT64);
+        EXPECT_EQ(response.column_description(2).type(), siodb::COLUMN_DATA_TYPE_INT64);
+        EXPECT_EQ(response.column_description(3).type(), siodb::COLUMN_DATA_TYPE_INT32);
+
+        // Group A=3 has single row and doesn't match HAVING
+        const std::vector<std::array<std::int64_t, 5>> expectedRows {
+                {1, 3, 60, 10, 30}, {2, 2, 6, 1, 5}};
+
+        google::protobuf::io::CodedInputStream codedInput(&inputStream);
+        std::uint64_t rowLength = 0;
+        for (const auto& expectedRow : expectedRows) {
+            ASSERT_TRUE(codedInput.ReadVarint64(&rowLength));
+            ASSERT_TRUE(rowLength > 0);
+
+            // Result expressions may be NULL, so null bitmask is sent
+            std::uint8_t nullMask = 0xFF;
+            ASSERT_TRUE(codedInput.ReadRaw(&nullMask, 1));
+            EXPECT_EQ(nullMask, 0);
+
+            std::int32_t a = 0, minB = 0, maxB = 0;
+            std::int64_t count = 0, sumB = 0;
+            ASSERT_TRUE(codedInput.ReadVarint32(reinterpret_cast<std::uint32_t*>(&a)));
+            ASSERT_TRUE(codedInput.ReadVarint64(reinterpret_cast<std::uint64_t*>(&count)));
+            ASSERT_TRUE(codedInput.ReadVarint64(reinterpret_cast<std::uint64_t*>(&sumB)));
+            ASSERT_TRUE(codedInput.ReadVarint32(reinterpret_cast<std::uint32_t*>(&minB)));
+            ASSERT_TRUE(codedInput.ReadVarint32(reinterpret_cast<std::uint32_t*>(&maxB)));
+            EXPECT_EQ(a, expectedRow[0]);
+            EXPECT_EQ(count, expectedRow[1]);
+            EXPECT_EQ(sumB, expectedRow[2]);
+            EXPECT_EQ(minB, expectedRow[3]);
+            EXPECT_EQ(maxB, expectedRow[4]);
+        }
+
+        ASSERT_TRUE(codedInput.ReadVarint64(&rowLength));
+        EXPECT_EQ(rowLength, 0U);
+    }
+
+    /// ----------- SELECT without GROUP BY -----------
+    {
+        // All rows form a single group, which exists even if no rows match WHERE
+        const std::string statement(
+                "SELECT COUNT(*), AVG(B) FROM SYS.SELECT_WITH_GROUP_BY_1 WHERE A > 5");
+        parser_ns::SqlParser parser(statement);
+        parser.parse();
+
+        const auto selectRequest =
+                parser_ns::DBEngineRequestFactory::createRequest(parser.findStatement(0));
+
+        siodb::iomgr_protocol::DatabaseEngineResponse response;
+        requestHandler->executeRequest(*selectRequest, TestEnvironment::kTestRequestId, 0, 1);
+        siodb::protobuf::readMessage(siodb::protobuf::ProtocolMessageType::kDatabaseEngineResponse,
+                response, inputStream);
+
+        EXPECT_EQ(response.request_id(), TestEnvironment::kTestRequestId);
+        ASSERT_EQ(response.message_size(), 0);
+        EXPECT_FALSE(response.has_affected_row_count());
+        ASSERT_EQ(response.column_description_size(), 2);
+        EXPECT_EQ(response.column_description(1).type(), siodb::COLUMN_DATA_TYPE_DOUBLE);
+
+        google::protobuf::io::CodedInputStream codedInput(&inputStream);
+        std::uint64_t rowLength = 0;
+        ASSERT_TRUE(codedInput.ReadVarint64(&rowLength));
+        ASSERT_TRUE(rowLength > 0);
+
+        // AVG of no values is NULL
+        std::uint8_t nullMask = 0;
+        ASSERT_TRUE(codedInput.ReadRaw(&nullMask, 1));
+        EXPECT_EQ(nullMask, 2);
+
+        std::uint64_t count = 1;
+        ASSERT_TRUE(codedInput.ReadVarint64(&count));
+        EXPECT_EQ(count, 0U);
+
+        ASSERT_TRUE(codedInput.ReadVarint64(&rowLength));
+        EXPECT_EQ(rowLength, 0U);
+    }
+}
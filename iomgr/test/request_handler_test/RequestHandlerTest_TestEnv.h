@@ -2,6 +2,8 @@
 // Use of this source code is governed by a license that can be found
 // in the LICENSE file.
 
+#pragma once
+
 // Project headers
 #include "dbengine/Instance.h"
 #include "dbengine/handlers/RequestHandler.h"
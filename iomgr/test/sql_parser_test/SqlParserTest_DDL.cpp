@@ -188,6 +188,31 @@ TEST(DDL, CreateTable)
     EXPECT_EQ(request.m_columns[2].m_dataType, siodb::COLUMN_DATA_TYPE_TEXT);
     EXPECT_EQ(request.m_columns[3].m_dataType, siodb::COLUMN_DATA_TYPE_TIMESTAMP);
     EXPECT_EQ(request.m_columns[4].m_dataType, siodb::COLUMN_DATA_TYPE_DOUBLE);
+    EXPECT_FALSE(request.m_compression);
+}
+
+TEST(DDL, CreateTableWithCompression)
+{
+    // Parse statement and prepare request
+    const std::string statement(
+            "CREATE TABLE my_table (name TEXT, photo BLOB) WITH COMPRESSION = 'zlib'");
+    parser_ns::SqlParser parser(statement);
+    parser.parse();
+    const auto dbeRequest =
+            parser_ns::DBEngineRequestFactory::createRequest(parser.findStatement(0));
+
+    // Check request type
+    ASSERT_EQ(dbeRequest->m_requestType, requests::DBEngineRequestType::kCreateTable);
+
+    // Check request
+    const auto& request = dynamic_cast<const requests::CreateTableRequest&>(*dbeRequest);
+    EXPECT_TRUE(request.m_database.empty());
+    EXPECT_EQ(request.m_table, "MY_TABLE");
+    ASSERT_EQ(request.m_columns.size(), 2U);
+
+    requests::EmptyContext emptyContext;
+    ASSERT_TRUE(request.m_compression);
+    EXPECT_EQ(request.m_compression->evaluate(emptyContext), "zlib");
 }
 
 TEST(DDL, DropTable)
@@ -1360,4 +1360,84 @@ TEST(SqlParser_Query, SelectWithLimitAndOffset_2)
     const auto& limitExpr =
             dynamic_cast<const requests::ConstantExpression&>(*selectRequest.m_limit);
     ASSERT_TRUE(limitExpr.getValue().compatibleEqual(10));
-}
\ No newline at end of file
+}
+/** Test checks select statement with ORDER BY clause */
+TEST(SqlParser_Query, SelectWithOrderBy)
+{
+    // Parse statement
+    const std::string statement = "SELECT c1, c2 FROM t1 ORDER BY c1 DESC, c2 + 1, 2 ASC LIMIT 5";
+
+    parser_ns::SqlParser parser(statement);
+    parser.parse();
+
+    const auto dbeRequest =
+            parser_ns::DBEngineRequestFactory::createRequest(parser.findStatement(0));
+
+    ASSERT_EQ(dbeRequest->m_requestType, requests::DBEngineRequestType::kSelect);
+    const auto& selectRequest = dynamic_cast<const requests::SelectRequest&>(*dbeRequest);
+    ASSERT_EQ(selectRequest.m_orderBy.size(), 3U);
+
+    ASSERT_EQ(selectRequest.m_orderBy[0].m_subject->getType(),
+            requests::ExpressionType::kSingleColumnReference);
+    const auto& column = dynamic_cast<const requests::SingleColumnExpression&>(
+            *selectRequest.m_orderBy[0].m_subject);
+    EXPECT_EQ(column.getColumnName(), "C1");
+    EXPECT_TRUE(selectRequest.m_orderBy[0].m_sortDescending);
+
+    EXPECT_EQ(selectRequest.m_orderBy[1].m_subject->getType(),
+            requests::ExpressionType::kAddOperator);
+    EXPECT_FALSE(selectRequest.m_orderBy[1].m_sortDescending);
+
+    ASSERT_EQ(selectRequest.m_orderBy[2].m_subject->getType(),
+            requests::ExpressionType::kConstant);
+    const auto& position = dynamic_cast<const requests::ConstantExpression&>(
+            *selectRequest.m_orderBy[2].m_subject);
+    EXPECT_TRUE(position.getValue().compatibleEqual(2));
+    EXPECT_FALSE(selectRequest.m_orderBy[2].m_sortDescending);
+
+    ASSERT_TRUE(selectRequest.m_limit != nullptr);
+}
+
+/** Test checks select statement with GROUP BY and HAVING clauses */
+TEST(SqlParser_Query, SelectWithGroupBy)
+{
+    // Parse statement
+    const std::string statement =
+            "SELECT c1, c3, COUNT(*), SUM(c2) + 1 FROM t1 GROUP BY c1, 2 HAVING MAX(c2) > 10";
+
+    parser_ns::SqlParser parser(statement);
+    parser.parse();
+
+    const auto dbeRequest =
+            parser_ns::DBEngineRequestFactory::createRequest(parser.findStatement(0));
+
+    ASSERT_EQ(dbeRequest->m_requestType, requests::DBEngineRequestType::kSelect);
+    const auto& selectRequest = dynamic_cast<const requests::SelectRequest&>(*dbeRequest);
+    ASSERT_EQ(selectRequest.m_resultExpressions.size(), 4U);
+
+    const auto& count = dynamic_cast<const requests::AggregateFunction&>(
+            *selectRequest.m_resultExpressions[2].m_expression);
+    EXPECT_EQ(count.getType(), requests::ExpressionType::kCountFunction);
+    EXPECT_EQ(count.getArgument(), nullptr);
+
+    const auto& add = dynamic_cast<const requests::BinaryOperator&>(
+            *selectRequest.m_resultExpressions[3].m_expression);
+    EXPECT_EQ(add.getType(), requests::ExpressionType::kAddOperator);
+    const auto& sum = dynamic_cast<const requests::AggregateFunction&>(add.getLeftOperand());
+    EXPECT_EQ(sum.getType(), requests::ExpressionType::kSumFunction);
+    ASSERT_NE(sum.getArgument(), nullptr);
+    EXPECT_EQ(sum.getArgument()->getType(), requests::ExpressionType::kSingleColumnReference);
+
+    ASSERT_EQ(selectRequest.m_groupBy.size(), 2U);
+    const auto& column =
+            dynamic_cast<const requests::SingleColumnExpression&>(*selectRequest.m_groupBy[0]);
+    EXPECT_EQ(column.getColumnName(), "C1");
+    const auto& position =
+            dynamic_cast<const requests::ConstantExpression&>(*selectRequest.m_groupBy[1]);
+    EXPECT_TRUE(position.getValue().compatibleEqual(2));
+
+    ASSERT_TRUE(selectRequest.m_having != nullptr);
+    const auto& having = dynamic_cast<const requests::BinaryOperator&>(*selectRequest.m_having);
+    EXPECT_EQ(having.getType(), requests::ExpressionType::kGreaterPredicate);
+    EXPECT_EQ(having.getLeftOperand().getType(), requests::ExpressionType::kMaxFunction);
+}
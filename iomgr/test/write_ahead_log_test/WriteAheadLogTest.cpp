@@ -0,0 +1,359 @@
+// Copyright (C) 2019-2020 Siodb GmbH. All rights reserved.
+// Use of this source code is governed by a license that can be found
+// in the LICENSE file.
+
+// Project headers
+#include "dbengine/crypto/ciphers/AesCipher.h"
+#include "dbengine/io/EncryptedFile.h"
+#include "dbengine/io/NormalFile.h"
+#include "dbengine/io/WriteAheadLog.h"
+
+// Common project headers
+#include <siodb/common/stl_wrap/filesystem_wrapper.h>
+#include <siodb/common/utils/Debug.h>
+
+// STL headers
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// CRT headers
+#include <cstring>
+
+// System headers
+#include <fcntl.h>
+#include <unistd.h>
+
+// Google Test
+#include <gtest/gtest.h>
+#include <siodb/common/unit_test/GTestOutput.h>
+
+namespace dbengine = siodb::iomgr::dbengine;
+
+constexpr int kFileCreationMode = 0644;
+
+class TestEnvironment : public ::testing::Environment {
+public:
+    auto makeNewDirPath()
+    {
+        auto path = m_testDir + "/d_" + std::to_string(++m_dirId);
+        fs::create_directories(path);
+        return path;
+    }
+
+    void SetUp() override
+    {
+        std::ostringstream str;
+        str << ::getenv("HOME") << "/tmp/write_ahead_log_test_" << std::time(nullptr) << '_'
+            << ::getpid();
+        m_testDir = str.str();
+        fs::create_directories(m_testDir);
+        m_dirId = 0;
+    }
+
+    void TearDown() override
+    {
+        // In case of failed test keep resources for debug.
+        if (testing::UnitTest::GetInstance()->Passed() && fs::exists(m_testDir)) {
+            fs::remove_all(m_testDir);
+        }
+    }
+
+private:
+    std::string m_testDir;
+    unsigned m_dirId;
+};
+
+// See https://stackoverflow.com/a/15341467/1540501
+TestEnvironment* g_testEnv;
+
+namespace {
+
+std::vector<std::uint8_t> makeData(std::size_t size, std::uint8_t seed)
+{
+    std::vector<std::uint8_t> data(size);
+    for (std::size_t i = 0; i < size; ++i)
+        data[i] = static_cast<std::uint8_t>(seed + i * 7);
+    return data;
+}
+
+std::vector<std::uint8_t> readRawFile(const std::string& path)
+{
+    std::vector<std::uint8_t> data(fs::file_size(path));
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    EXPECT_GE(fd, 0);
+    EXPECT_EQ(::pread(fd, data.data(), data.size(), 0), static_cast<ssize_t>(data.size()));
+    ::close(fd);
+    return data;
+}
+
+void writeRawFile(const std::string& path, const std::vector<std::uint8_t>& data)
+{
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, kFileCreationMode);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(::write(fd, data.data(), data.size()), static_cast<ssize_t>(data.size()));
+    ::close(fd);
+}
+
+/**
+ * Simulates crash: saves committed log before the final checkpoint truncates it,
+ * then restores log and replaces data files with the given "on-disk" state.
+ */
+class CrashSimulator {
+public:
+    explicit CrashSimulator(const std::string& dir)
+        : m_logFilePath(dir + '/' + dbengine::io::WriteAheadLog::kLogFileName)
+    {
+    }
+
+    void saveLog()
+    {
+        m_log = readRawFile(m_logFilePath);
+    }
+
+    void restoreLog()
+    {
+        writeRawFile(m_logFilePath, m_log);
+    }
+
+    std::vector<std::uint8_t>& getLog() noexcept
+    {
+        return m_log;
+    }
+
+private:
+    const std::string m_logFilePath;
+    std::vector<std::uint8_t> m_log;
+};
+
+}  // namespace
+
+// Committed writes are replayed into the file which lost them.
+TEST(WriteAheadLog, ReplayCommittedWrites)
+{
+    const auto dir = g_testEnv->makeNewDirPath();
+    const auto path = dir + "/data";
+    const auto data1 = makeData(1000, 3);
+    const auto data2 = makeData(500, 5);
+    CrashSimulator crash(dir);
+    {
+        dbengine::io::WriteAheadLog wal(dir);
+        ASSERT_EQ(wal.getReplayedRecordCount(), 0U);
+        dbengine::io::NormalFile file(path, 0, kFileCreationMode);
+        file.enableWriteAheadLog(&wal, path);
+        ASSERT_TRUE(file.isWriteAheadLogged());
+        ASSERT_EQ(file.write(data1.data(), data1.size(), 0), data1.size());
+        ASSERT_EQ(file.write(data2.data(), data2.size(), 200), data2.size());
+        wal.commit();
+        crash.saveLog();
+    }
+
+    // Writes didn't reach disk
+    writeRawFile(path, std::vector<std::uint8_t>(100, 0));
+    crash.restoreLog();
+
+    dbengine::io::WriteAheadLog wal(dir);
+    ASSERT_EQ(wal.getReplayedRecordCount(), 2U);
+    auto expected = data1;
+    std::memcpy(expected.data() + 200, data2.data(), data2.size());
+    ASSERT_EQ(readRawFile(path), expected);
+    ASSERT_EQ(fs::file_size(dir + '/' + dbengine::io::WriteAheadLog::kLogFileName), 0U);
+}
+
+// Encrypted file is replayed in the encrypted form and can be read back.
+TEST(WriteAheadLog, ReplayEncryptedFile)
+{
+    const auto cipher = std::make_shared<dbengine::crypto::Aes128>();
+    siodb::BinaryValue cipherKey(cipher->getKeySize() / 8);
+    for (std::size_t i = 0; i < cipherKey.size(); ++i)
+        cipherKey[i] = i;
+
+    const auto dir = g_testEnv->makeNewDirPath();
+    const auto path = dir + "/data";
+    const auto data = makeData(3000, 7);
+    CrashSimulator crash(dir);
+    std::vector<std::uint8_t> expectedRawData;
+    {
+        dbengine::io::WriteAheadLog wal(dir);
+        dbengine::io::EncryptedFile file(path, 0, kFileCreationMode,
+                cipher->createEncryptionContext(cipherKey),
+                cipher->createDecryptionContext(cipherKey));
+        file.enableWriteAheadLog(&wal, path);
+        ASSERT_EQ(file.write(data.data(), data.size(), 0), data.size());
+        wal.commit();
+        crash.saveLog();
+        expectedRawData = readRawFile(path);
+    }
+
+    writeRawFile(path, std::vector<std::uint8_t>(expectedRawData.size(), 0));
+    crash.restoreLog();
+
+    dbengine::io::WriteAheadLog wal(dir);
+    ASSERT_GT(wal.getReplayedRecordCount(), 0U);
+    ASSERT_EQ(readRawFile(path), expectedRawData);
+
+    dbengine::io::EncryptedFile file(path, 0, cipher->createEncryptionContext(cipherKey),
+            cipher->createDecryptionContext(cipherKey));
+    std::vector<std::uint8_t> buffer(data.size());
+    ASSERT_EQ(file.read(buffer.data(), buffer.size(), 0), buffer.size());
+    ASSERT_EQ(buffer, data);
+}
+
+// Incomplete record at the end of the log is ignored.
+TEST(WriteAheadLog, TornTail)
+{
+    const auto dir = g_testEnv->makeNewDirPath();
+    const auto path = dir + "/data";
+    const auto data1 = makeData(100, 1);
+    const auto data2 = makeData(100, 2);
+    CrashSimulator crash(dir);
+    {
+        dbengine::io::WriteAheadLog wal(dir);
+        dbengine::io::NormalFile file(path, 0, kFileCreationMode);
+        file.enableWriteAheadLog(&wal, path);
+        ASSERT_EQ(file.write(data1.data(), data1.size(), 0), data1.size());
+        ASSERT_EQ(file.write(data2.data(), data2.size(), 0), data2.size());
+        wal.commit();
+        crash.saveLog();
+    }
+
+    // Second record is partially written
+    crash.getLog().resize(crash.getLog().size() - 10);
+    writeRawFile(path, std::vector<std::uint8_t>(data1.size(), 0));
+    crash.restoreLog();
+
+    dbengine::io::WriteAheadLog wal(dir);
+    ASSERT_EQ(wal.getReplayedRecordCount(), 1U);
+    ASSERT_EQ(readRawFile(path), data1);
+}
+
+// Records which precede discard record are not replayed.
+TEST(WriteAheadLog, Discard)
+{
+    const auto dir = g_testEnv->makeNewDirPath();
+    const auto path = dir + "/data";
+    const auto data1 = makeData(100, 1);
+    const auto data2 = makeData(50, 2);
+    CrashSimulator crash(dir);
+    {
+        dbengine::io::WriteAheadLog wal(dir);
+        dbengine::io::NormalFile file(path, 0, kFileCreationMode);
+        file.enableWriteAheadLog(&wal, path);
+        ASSERT_EQ(file.write(data1.data(), data1.size(), 0), data1.size());
+        wal.logDiscard(path);
+        ASSERT_EQ(file.write(data2.data(), data2.size(), 0), data2.size());
+        wal.commit();
+        crash.saveLog();
+    }
+
+    writeRawFile(path, std::vector<std::uint8_t>(data1.size(), 0));
+    crash.restoreLog();
+
+    dbengine::io::WriteAheadLog wal(dir);
+    ASSERT_EQ(wal.getReplayedRecordCount(), 1U);
+    auto expected = std::vector<std::uint8_t>(data1.size(), 0);
+    std::memcpy(expected.data(), data2.data(), data2.size());
+    ASSERT_EQ(readRawFile(path), expected);
+}
+
+// Records of the removed files are skipped.
+TEST(WriteAheadLog, RemovedFile)
+{
+    const auto dir = g_testEnv->makeNewDirPath();
+    const auto path = dir + "/data";
+    const auto data = makeData(100, 1);
+    CrashSimulator crash(dir);
+    {
+        dbengine::io::WriteAheadLog wal(dir);
+        dbengine::io::NormalFile file(path, 0, kFileCreationMode);
+        file.enableWriteAheadLog(&wal, path);
+        ASSERT_EQ(file.write(data.data(), data.size(), 0), data.size());
+        wal.commit();
+        crash.saveLog();
+    }
+
+    fs::remove(path);
+    crash.restoreLog();
+
+    dbengine::io::WriteAheadLog wal(dir);
+    ASSERT_EQ(wal.getReplayedRecordCount(), 0U);
+    ASSERT_FALSE(fs::exists(path));
+}
+
+// Concurrent commits make all records durable.
+TEST(WriteAheadLog, GroupCommit)
+{
+    constexpr std::size_t kThreadCount = 8;
+    constexpr std::size_t kWriteCount = 100;
+    const auto dir = g_testEnv->makeNewDirPath();
+    CrashSimulator crash(dir);
+    {
+        dbengine::io::WriteAheadLog wal(dir);
+        std::vector<std::unique_ptr<dbengine::io::NormalFile>> files;
+        for (std::size_t i = 0; i < kThreadCount; ++i) {
+            const auto path = dir + "/data" + std::to_string(i);
+            files.push_back(std::make_unique<dbengine::io::NormalFile>(path, 0, kFileCreationMode));
+            files.back()->enableWriteAheadLog(&wal, path);
+        }
+
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < kThreadCount; ++i) {
+            threads.emplace_back([&wal, &file = *files[i], i] {
+                const auto data = makeData(64, static_cast<std::uint8_t>(i));
+                for (std::size_t j = 0; j < kWriteCount; ++j) {
+                    ASSERT_EQ(file.write(data.data(), data.size(), j * data.size()), data.size());
+                    wal.commit();
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        crash.saveLog();
+    }
+
+    for (std::size_t i = 0; i < kThreadCount; ++i)
+        writeRawFile(dir + "/data" + std::to_string(i), {});
+    crash.restoreLog();
+
+    dbengine::io::WriteAheadLog wal(dir);
+    ASSERT_EQ(wal.getReplayedRecordCount(), kThreadCount * kWriteCount);
+    for (std::size_t i = 0; i < kThreadCount; ++i) {
+        const auto data = makeData(64, static_cast<std::uint8_t>(i));
+        const auto fileData = readRawFile(dir + "/data" + std::to_string(i));
+        ASSERT_EQ(fileData.size(), data.size() * kWriteCount);
+        for (std::size_t j = 0; j < kWriteCount; ++j)
+            ASSERT_EQ(std::memcmp(fileData.data() + j * data.size(), data.data(), data.size()), 0);
+    }
+}
+
+// Log is truncated when it grows over the checkpoint size.
+TEST(WriteAheadLog, Checkpoint)
+{
+    const auto dir = g_testEnv->makeNewDirPath();
+    const auto path = dir + "/data";
+    const auto logFilePath = dir + '/' + dbengine::io::WriteAheadLog::kLogFileName;
+    const auto data = makeData(1000, 1);
+    dbengine::io::WriteAheadLog wal(dir, 4096);
+    dbengine::io::NormalFile file(path, 0, kFileCreationMode);
+    file.enableWriteAheadLog(&wal, path);
+
+    ASSERT_EQ(file.write(data.data(), data.size(), 0), data.size());
+    wal.commit();
+    ASSERT_GT(fs::file_size(logFilePath), data.size());
+
+    for (std::size_t i = 0; i < 4; ++i)
+        ASSERT_EQ(file.write(data.data(), data.size(), 0), data.size());
+    wal.commit();
+    ASSERT_EQ(fs::file_size(logFilePath), 0U);
+}
+
+int main(int argc, char** argv)
+{
+    DEBUG_SYSCALLS_LIBRARY_GUARD;
+    testing::InitGoogleTest(&argc, argv);
+    auto testEnv = new TestEnvironment();
+    testing::AddGlobalTestEnvironment(testEnv);
+    g_testEnv = testEnv;
+    return RUN_ALL_TESTS();
+}